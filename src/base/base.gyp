@@ -132,6 +132,7 @@
         'text_converter.cc',
         'text_normalizer.cc',
         'thread.cc',
+        'trace.cc',
         'util.cc',
         'version.cc',
         'win_util.cc',
@@ -383,6 +384,17 @@
         },
       ],
     },
+    {
+      # Replaces the global operator new.  Link only to benchmark binaries.
+      'target_name': 'benchmark',
+      'type': 'static_library',
+      'sources': [
+        'benchmark.cc',
+      ],
+      'dependencies': [
+        'base',
+      ],
+    },
     {
       'target_name': 'multifile',
       'type': 'static_library',
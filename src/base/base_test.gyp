@@ -85,6 +85,7 @@
         'process_mutex_test.cc',
         'stopwatch_test.cc',
         'timer_test.cc',
+        'trace_test.cc',
         'unnamed_event_test.cc',
         'update_util_test.cc',
         'url_test.cc',
@@ -131,6 +132,7 @@
         'logging_test.cc',
         'mmap_test.cc',
         'mutex_test.cc',
+        'parallel_sort_test.cc',
         'singleton_test.cc',
         'stl_util_test.cc',
         'string_piece_test.cc',
@@ -341,6 +343,21 @@
         'base.gyp:multifile',
       ],
     },
+    {
+      'target_name': 'benchmark_test',
+      'type': 'executable',
+      'sources': [
+        'benchmark_test.cc',
+      ],
+      'dependencies': [
+        '../testing/testing.gyp:gtest_main',
+        'base.gyp:base',
+        'base.gyp:benchmark',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     # Test cases meta target: this target is referred from gyp/tests.gyp
     {
       'target_name': 'base_all_test',
@@ -349,6 +366,7 @@
         'base_core_test',
         'base_init_test',
         'base_test',
+        'benchmark_test',
         'config_file_stream_test',
         'encryptor_test',
         'file_util_test',
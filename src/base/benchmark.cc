@@ -0,0 +1,219 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/stopwatch.h"
+#include "base/util.h"
+
+namespace {
+
+std::atomic<uint64> g_allocation_count(0);
+
+void *CountedAllocate(size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == NULL) {
+    // Exceptions are disabled.  Do not use LOG here since it allocates.
+    abort();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+void *operator new(size_t size) {
+  return CountedAllocate(size);
+}
+
+void *operator new[](size_t size) {
+  return CountedAllocate(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) throw() {
+  return CountedAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) throw() {
+  return CountedAllocate(size);
+}
+
+void operator delete(void *ptr) throw() {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) throw() {
+  free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) throw() {
+  free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) throw() {
+  free(ptr);
+}
+
+namespace mozc {
+namespace {
+
+// Returns the value at the |percent| percentile of |sorted| by the
+// nearest-rank method.
+double Percentile(const vector<double> &sorted, int percent) {
+  DCHECK(!sorted.empty());
+  size_t rank = (sorted.size() * percent + 99) / 100;
+  if (rank == 0) {
+    rank = 1;
+  }
+  return sorted[rank - 1];
+}
+
+}  // namespace
+
+BenchmarkRunner::BenchmarkRunner()
+    : warmup_ops_(10),
+      min_ops_(100),
+      max_ops_(1000000),
+      min_time_ms_(1000) {}
+
+BenchmarkRunner::~BenchmarkRunner() {}
+
+void BenchmarkRunner::Run(BenchmarkInterface *benchmark,
+                          BenchmarkResult *result) const {
+  DCHECK(benchmark);
+  DCHECK(result);
+  benchmark->SetUp();
+
+  for (int64 i = 0; i < warmup_ops_; ++i) {
+    benchmark->PrepareOp();
+    benchmark->RunOp();
+  }
+
+  vector<double> times_ns;
+  times_ns.reserve(static_cast<size_t>(min(max_ops_, min_ops_ * 16)));
+  uint64 num_allocations = 0;
+  Stopwatch total_stopwatch = Stopwatch::StartNew();
+  while (static_cast<int64>(times_ns.size()) < max_ops_ &&
+         (static_cast<int64>(times_ns.size()) < min_ops_ ||
+          total_stopwatch.GetElapsedMilliseconds() < min_time_ms_)) {
+    benchmark->PrepareOp();
+    // Read the counter after PrepareOp() and after the growth of |times_ns|
+    // so that only the allocations made by RunOp() are counted.
+    times_ns.push_back(0.0);
+    const uint64 allocations_before = GetAllocationCount();
+    Stopwatch stopwatch = Stopwatch::StartNew();
+    benchmark->RunOp();
+    stopwatch.Stop();
+    num_allocations += GetAllocationCount() - allocations_before;
+    times_ns.back() = stopwatch.GetElapsedNanoseconds();
+  }
+
+  benchmark->TearDown();
+
+  ComputeStats(&times_ns, num_allocations, result);
+  result->name = benchmark->name();
+}
+
+void BenchmarkRunner::ComputeStats(vector<double> *times_ns,
+                                   uint64 num_allocations,
+                                   BenchmarkResult *result) {
+  DCHECK(times_ns);
+  DCHECK(result);
+  result->num_ops = times_ns->size();
+  if (times_ns->empty()) {
+    result->mean_ns = result->p50_ns = result->p90_ns = result->p99_ns =
+        result->max_ns = result->allocations_per_op = 0.0;
+    return;
+  }
+
+  sort(times_ns->begin(), times_ns->end());
+  double total_ns = 0.0;
+  for (size_t i = 0; i < times_ns->size(); ++i) {
+    total_ns += (*times_ns)[i];
+  }
+  result->mean_ns = total_ns / times_ns->size();
+  result->p50_ns = Percentile(*times_ns, 50);
+  result->p90_ns = Percentile(*times_ns, 90);
+  result->p99_ns = Percentile(*times_ns, 99);
+  result->max_ns = times_ns->back();
+  result->allocations_per_op =
+      static_cast<double>(num_allocations) / times_ns->size();
+}
+
+string BenchmarkRunner::FormatAsText(const vector<BenchmarkResult> &results) {
+  string output = Util::StringPrintf(
+      "%-40s %10s %12s %12s %12s %12s %10s\n",
+      "name", "ops", "ns/op", "p50(ns)", "p90(ns)", "p99(ns)", "allocs/op");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult &result = results[i];
+    output += Util::StringPrintf(
+        "%-40s %10lld %12.0f %12.0f %12.0f %12.0f %10.2f\n",
+        result.name.c_str(), static_cast<long long>(result.num_ops),
+        result.mean_ns, result.p50_ns, result.p90_ns, result.p99_ns,
+        result.allocations_per_op);
+  }
+  return output;
+}
+
+string BenchmarkRunner::FormatAsJson(const vector<BenchmarkResult> &results) {
+  ostringstream os;
+  os << "{\"benchmarks\":[";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult &result = results[i];
+    if (i > 0) {
+      os << ",";
+    }
+    // Benchmark names are ASCII identifiers, so no escaping is needed.
+    DCHECK_EQ(string::npos, result.name.find_first_of("\"\\"));
+    os << Util::StringPrintf(
+        "{\"name\":\"%s\",\"num_ops\":%lld,\"mean_ns\":%.1f,"
+        "\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f,"
+        "\"allocations_per_op\":%.2f}",
+        result.name.c_str(), static_cast<long long>(result.num_ops),
+        result.mean_ns, result.p50_ns, result.p90_ns, result.p99_ns,
+        result.max_ns, result.allocations_per_op);
+  }
+  os << "]}\n";
+  return os.str();
+}
+
+uint64 BenchmarkRunner::GetAllocationCount() {
+  return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+}  // namespace mozc
@@ -0,0 +1,128 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A small harness to run micro benchmarks with repeatable fixtures.
+//
+// Each benchmark implements BenchmarkInterface.  BenchmarkRunner calls
+// SetUp() once, then RunOp() repeatedly until both the minimum number of
+// operations and the minimum time are reached, and reports the time and the
+// number of heap allocations per operation.  Each operation is timed
+// separately so that the percentiles reflect the per-keystroke latency that
+// users actually see.
+//
+// Linking this library replaces the global operator new to count heap
+// allocations.  The counter is a relaxed atomic, so the overhead is small but
+// non-zero; do not link it to production binaries.
+
+#ifndef MOZC_BASE_BENCHMARK_H_
+#define MOZC_BASE_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+
+namespace mozc {
+
+class BenchmarkInterface {
+ public:
+  virtual ~BenchmarkInterface() {}
+
+  // Returns the name used to identify the benchmark in the reports.
+  virtual string name() const = 0;
+
+  // Called once before the measurement.
+  virtual void SetUp() {}
+
+  // Called before each operation.  Not included in the measurement.
+  virtual void PrepareOp() {}
+
+  // Performs one operation.
+  virtual void RunOp() = 0;
+
+  // Called once after the measurement.
+  virtual void TearDown() {}
+};
+
+struct BenchmarkResult {
+  BenchmarkResult()
+      : num_ops(0), mean_ns(0.0), p50_ns(0.0), p90_ns(0.0), p99_ns(0.0),
+        max_ns(0.0), allocations_per_op(0.0) {}
+
+  string name;
+  int64 num_ops;
+  double mean_ns;
+  double p50_ns;
+  double p90_ns;
+  double p99_ns;
+  double max_ns;
+  double allocations_per_op;
+};
+
+class BenchmarkRunner {
+ public:
+  BenchmarkRunner();
+  ~BenchmarkRunner();
+
+  // Operations run before the measurement to warm up caches.
+  void set_warmup_ops(int64 ops) { warmup_ops_ = ops; }
+  void set_min_ops(int64 ops) { min_ops_ = ops; }
+  void set_max_ops(int64 ops) { max_ops_ = ops; }
+  void set_min_time_ms(int64 time_ms) { min_time_ms_ = time_ms; }
+
+  // Runs |benchmark| and stores the statistics to |result|.
+  void Run(BenchmarkInterface *benchmark, BenchmarkResult *result) const;
+
+  // Computes the statistics from the elapsed time of each operation.
+  // |times_ns| is sorted in place.
+  static void ComputeStats(vector<double> *times_ns, uint64 num_allocations,
+                           BenchmarkResult *result);
+
+  // Formats the results as a table for humans.
+  static string FormatAsText(const vector<BenchmarkResult> &results);
+
+  // Formats the results as JSON for regression tracking, e.g.,
+  // {"benchmarks":[{"name":"...","num_ops":100,"mean_ns":...}]}
+  static string FormatAsJson(const vector<BenchmarkResult> &results);
+
+  // Returns the number of heap allocations made by this process so far.
+  static uint64 GetAllocationCount();
+
+ private:
+  int64 warmup_ops_;
+  int64 min_ops_;
+  int64 max_ops_;
+  int64 min_time_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkRunner);
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_BENCHMARK_H_
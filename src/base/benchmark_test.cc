@@ -0,0 +1,187 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/benchmark.h"
+
+#include <string>
+#include <vector>
+
+#include "base/clock_mock.h"
+#include "base/scoped_ptr.h"
+#include "base/util.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace {
+
+// Advances the clock by 1, 2, 3, ... microseconds and makes one heap
+// allocation in each operation.
+class FakeBenchmark : public BenchmarkInterface {
+ public:
+  explicit FakeBenchmark(ClockMock *clock)
+      : clock_(clock), num_set_up_(0), num_prepare_(0), num_run_(0),
+        num_tear_down_(0) {}
+
+  virtual string name() const { return "Fake"; }
+  virtual void SetUp() { ++num_set_up_; }
+  virtual void PrepareOp() {
+    ++num_prepare_;
+    // Allocations and time here must not be measured.
+    clock_->PutClockForwardByTicks(1000000);
+    scoped_ptr<int> unused(new int(0));
+  }
+  virtual void RunOp() {
+    ++num_run_;
+    clock_->PutClockForwardByTicks(1000 * num_run_);
+    buffer_.reset(new char[16]);
+  }
+  virtual void TearDown() { ++num_tear_down_; }
+
+  int num_set_up() const { return num_set_up_; }
+  int num_prepare() const { return num_prepare_; }
+  int num_run() const { return num_run_; }
+  int num_tear_down() const { return num_tear_down_; }
+
+ private:
+  ClockMock *clock_;
+  scoped_ptr<char[]> buffer_;
+  int num_set_up_;
+  int num_prepare_;
+  int num_run_;
+  int num_tear_down_;
+};
+
+class BenchmarkTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    clock_mock_.reset(new ClockMock(0, 0));
+    // 1GHz (Accuracy = 1ns)
+    clock_mock_->SetFrequency(1000000000uLL);
+    Util::SetClockHandler(clock_mock_.get());
+  }
+
+  virtual void TearDown() {
+    Util::SetClockHandler(NULL);
+  }
+
+  scoped_ptr<ClockMock> clock_mock_;
+};
+
+TEST_F(BenchmarkTest, Run) {
+  FakeBenchmark benchmark(clock_mock_.get());
+  BenchmarkRunner runner;
+  runner.set_warmup_ops(0);
+  runner.set_min_ops(100);
+  runner.set_max_ops(100);
+  runner.set_min_time_ms(0);
+
+  BenchmarkResult result;
+  runner.Run(&benchmark, &result);
+
+  EXPECT_EQ(1, benchmark.num_set_up());
+  EXPECT_EQ(100, benchmark.num_prepare());
+  EXPECT_EQ(100, benchmark.num_run());
+  EXPECT_EQ(1, benchmark.num_tear_down());
+
+  EXPECT_EQ("Fake", result.name);
+  EXPECT_EQ(100, result.num_ops);
+  EXPECT_DOUBLE_EQ(50500.0, result.mean_ns);
+  EXPECT_DOUBLE_EQ(50000.0, result.p50_ns);
+  EXPECT_DOUBLE_EQ(90000.0, result.p90_ns);
+  EXPECT_DOUBLE_EQ(99000.0, result.p99_ns);
+  EXPECT_DOUBLE_EQ(100000.0, result.max_ns);
+  EXPECT_DOUBLE_EQ(1.0, result.allocations_per_op);
+}
+
+TEST_F(BenchmarkTest, RunUntilMinTime) {
+  FakeBenchmark benchmark(clock_mock_.get());
+  BenchmarkRunner runner;
+  runner.set_warmup_ops(3);
+  runner.set_min_ops(1);
+  runner.set_max_ops(1000);
+  // Each operation takes more than 1ms including PrepareOp().
+  runner.set_min_time_ms(10);
+
+  BenchmarkResult result;
+  runner.Run(&benchmark, &result);
+  EXPECT_EQ(13, benchmark.num_run());
+  EXPECT_EQ(10, result.num_ops);
+}
+
+TEST(BenchmarkRunnerTest, ComputeStatsForEmptyInput) {
+  vector<double> times;
+  BenchmarkResult result;
+  BenchmarkRunner::ComputeStats(&times, 0, &result);
+  EXPECT_EQ(0, result.num_ops);
+  EXPECT_DOUBLE_EQ(0.0, result.mean_ns);
+  EXPECT_DOUBLE_EQ(0.0, result.p99_ns);
+}
+
+TEST(BenchmarkRunnerTest, FormatAsJson) {
+  vector<BenchmarkResult> results(2);
+  results[0].name = "A";
+  results[0].num_ops = 10;
+  results[0].mean_ns = 1.5;
+  results[0].p50_ns = 1.0;
+  results[0].p90_ns = 2.0;
+  results[0].p99_ns = 3.0;
+  results[0].max_ns = 4.0;
+  results[0].allocations_per_op = 0.5;
+  results[1].name = "B";
+
+  EXPECT_EQ(
+      "{\"benchmarks\":["
+      "{\"name\":\"A\",\"num_ops\":10,\"mean_ns\":1.5,\"p50_ns\":1.0,"
+      "\"p90_ns\":2.0,\"p99_ns\":3.0,\"max_ns\":4.0,"
+      "\"allocations_per_op\":0.50},"
+      "{\"name\":\"B\",\"num_ops\":0,\"mean_ns\":0.0,\"p50_ns\":0.0,"
+      "\"p90_ns\":0.0,\"p99_ns\":0.0,\"max_ns\":0.0,"
+      "\"allocations_per_op\":0.00}]}\n",
+      BenchmarkRunner::FormatAsJson(results));
+
+  const string text = BenchmarkRunner::FormatAsText(results);
+  EXPECT_NE(string::npos, text.find("allocs/op"));
+  EXPECT_NE(string::npos, text.find("\nA "));
+}
+
+TEST(BenchmarkRunnerTest, CountAllocations) {
+  // Keep the pointers in a vector allocated beforehand so that the compiler
+  // does not elide the allocations.
+  vector<int *> values;
+  values.reserve(2);
+  const uint64 before = BenchmarkRunner::GetAllocationCount();
+  values.push_back(new int(1));
+  values.push_back(new int[10]);
+  EXPECT_EQ(before + 2, BenchmarkRunner::GetAllocationCount());
+  delete values[0];
+  delete [] values[1];
+}
+
+}  // namespace
+}  // namespace mozc
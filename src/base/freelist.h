@@ -61,11 +61,18 @@ template <class T> class FreeList {
   }
 
   void Free() {
-    for (size_t i = 1; i < pool_.size(); ++i) {
+    Trim(1);
+  }
+
+  // Same as Reset(), but deletes the chunks except the first |max_chunks|.
+  // The objects in the kept chunks are not destructed, so Alloc() returns
+  // them as they were left; the caller is responsible for reinitializing.
+  void Trim(size_t max_chunks) {
+    for (size_t i = max_chunks; i < pool_.size(); ++i) {
       delete [] pool_[i];
     }
-    if (pool_.size() > 1) {
-      pool_.resize(1);
+    if (pool_.size() > max_chunks) {
+      pool_.resize(max_chunks);
     }
     current_index_ = 0;
     chunk_index_ = 0;
@@ -0,0 +1,160 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Sorting helpers which split the work across threads. The result is always
+// identical to the one of the corresponding single-threaded algorithm, so
+// they can be used to build data files which must be reproducible.
+
+#ifndef MOZC_BASE_PARALLEL_SORT_H_
+#define MOZC_BASE_PARALLEL_SORT_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "base/port.h"
+#include "base/stl_util.h"
+#include "base/thread.h"
+
+namespace mozc {
+namespace parallel_sort_internal {
+
+// Ranges smaller than this are sorted on the calling thread.
+const size_t kMinElementsPerThread = 1024;
+
+template <typename Iterator, typename Compare>
+class StableSortThread : public Thread {
+ public:
+  StableSortThread(Iterator begin, Iterator end, Compare comp)
+      : begin_(begin), end_(end), comp_(comp) {}
+
+  virtual void Run() {
+    stable_sort(begin_, end_, comp_);
+  }
+
+ private:
+  Iterator begin_;
+  Iterator end_;
+  Compare comp_;
+
+  DISALLOW_COPY_AND_ASSIGN(StableSortThread);
+};
+
+template <typename Iterator, typename Compare>
+class MergeThread : public Thread {
+ public:
+  MergeThread(Iterator begin, Iterator middle, Iterator end, Compare comp)
+      : begin_(begin), middle_(middle), end_(end), comp_(comp) {}
+
+  virtual void Run() {
+    inplace_merge(begin_, middle_, end_, comp_);
+  }
+
+ private:
+  Iterator begin_;
+  Iterator middle_;
+  Iterator end_;
+  Compare comp_;
+
+  DISALLOW_COPY_AND_ASSIGN(MergeThread);
+};
+
+// Starts all the |threads|, waits for them and deletes them.
+inline void RunAndJoin(vector<Thread *> *threads) {
+  for (size_t i = 0; i < threads->size(); ++i) {
+    (*threads)[i]->SetJoinable(true);
+    (*threads)[i]->Start();
+  }
+  for (size_t i = 0; i < threads->size(); ++i) {
+    (*threads)[i]->Join();
+  }
+  STLDeleteElements(threads);
+}
+
+}  // namespace parallel_sort_internal
+
+// Same as stable_sort(begin, end, comp) but uses up to |num_threads| threads.
+// The range is split into runs which are sorted concurrently, and then the
+// adjacent runs are merged pairwise. As both stable_sort and inplace_merge
+// are stable, the result is identical to the one of stable_sort.
+template <typename Iterator, typename Compare>
+void ParallelStableSort(Iterator begin, Iterator end, Compare comp,
+                        int num_threads) {
+  using parallel_sort_internal::kMinElementsPerThread;
+  using parallel_sort_internal::MergeThread;
+  using parallel_sort_internal::RunAndJoin;
+  using parallel_sort_internal::StableSortThread;
+
+  const size_t size = distance(begin, end);
+  size_t num_runs = (num_threads > 1) ? static_cast<size_t>(num_threads) : 1;
+  num_runs = min(num_runs, size / kMinElementsPerThread);
+  if (num_runs <= 1) {
+    stable_sort(begin, end, comp);
+    return;
+  }
+
+  // bounds[i] and bounds[i + 1] delimit the i-th run.
+  vector<Iterator> bounds;
+  for (size_t i = 0; i < num_runs; ++i) {
+    bounds.push_back(begin + size * i / num_runs);
+  }
+  bounds.push_back(end);
+
+  vector<Thread *> threads;
+  for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+    threads.push_back(new StableSortThread<Iterator, Compare>(
+        bounds[i], bounds[i + 1], comp));
+  }
+  RunAndJoin(&threads);
+
+  while (bounds.size() > 2) {
+    vector<Iterator> merged_bounds;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+      merged_bounds.push_back(bounds[i]);
+      if (i + 2 < bounds.size()) {
+        threads.push_back(new MergeThread<Iterator, Compare>(
+            bounds[i], bounds[i + 1], bounds[i + 2], comp));
+      }
+    }
+    merged_bounds.push_back(end);
+    RunAndJoin(&threads);
+    bounds.swap(merged_bounds);
+  }
+}
+
+template <typename Iterator>
+void ParallelStableSort(Iterator begin, Iterator end, int num_threads) {
+  typedef typename iterator_traits<Iterator>::value_type ValueType;
+  ParallelStableSort(begin, end, less<ValueType>(), num_threads);
+}
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_PARALLEL_SORT_H_
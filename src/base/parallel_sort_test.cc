@@ -0,0 +1,87 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/parallel_sort.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/util.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace {
+
+// Compares only the first element so that the stability can be checked
+// through the second one.
+struct FirstLessThan {
+  bool operator()(const pair<int, int> &lhs,
+                  const pair<int, int> &rhs) const {
+    return lhs.first < rhs.first;
+  }
+};
+
+TEST(ParallelSortTest, SameAsStableSort) {
+  vector<pair<int, int> > original;
+  for (int i = 0; i < 100000; ++i) {
+    // Many duplicated keys.
+    original.push_back(make_pair(Util::Random(100), i));
+  }
+
+  vector<pair<int, int> > expected = original;
+  stable_sort(expected.begin(), expected.end(), FirstLessThan());
+
+  const int kNumThreads[] = { 0, 1, 2, 3, 4, 7, 16 };
+  for (size_t i = 0; i < arraysize(kNumThreads); ++i) {
+    vector<pair<int, int> > actual = original;
+    ParallelStableSort(actual.begin(), actual.end(), FirstLessThan(),
+                       kNumThreads[i]);
+    EXPECT_TRUE(expected == actual) << kNumThreads[i];
+  }
+}
+
+TEST(ParallelSortTest, SmallInput) {
+  vector<string> words;
+  ParallelStableSort(words.begin(), words.end(), 4);
+  EXPECT_TRUE(words.empty());
+
+  words.push_back("c");
+  words.push_back("a");
+  words.push_back("b");
+  ParallelStableSort(words.begin(), words.end(), 4);
+  ASSERT_EQ(3, words.size());
+  EXPECT_EQ("a", words[0]);
+  EXPECT_EQ("b", words[1]);
+  EXPECT_EQ("c", words[2]);
+}
+
+}  // namespace
+}  // namespace mozc
@@ -0,0 +1,210 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/trace.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/mutex.h"
+#include "base/singleton.h"
+#include "base/thread.h"
+#include "base/util.h"
+
+namespace mozc {
+namespace {
+
+const char *const kStageNames[] = {
+  "SessionHandler::EvalCommand",
+  "Composer::InsertCharacter",
+  "ImmutableConverter::MakeLattice",
+  "ImmutableConverter::Viterbi",
+  "NBestGenerator",
+  "DictionaryPredictor::AggregateRealtimeConversion",
+  "DictionaryPredictor::AggregateUnigramPrediction",
+  "DictionaryPredictor::AggregateBigramPrediction",
+  "DictionaryPredictor::AggregateSuffixPrediction",
+  "DictionaryPredictor::AggregateEnglishPrediction",
+  "DictionaryPredictor::AggregateTypeCorrectingPrediction",
+  "MergerRewriter::Rewrite",
+  "SessionOutput",
+};
+
+struct TraceEvent {
+  uint64 ticks;
+  int32 arg;
+  uint8 stage;
+  bool is_begin;
+};
+
+// Events recorded by one thread. |mutex| is only contended while the events
+// are exported.
+struct TraceBuffer {
+  explicit TraceBuffer(int id) : thread_id(id), size(0) {}
+
+  Mutex mutex;
+  const int thread_id;
+  // Number of the events recorded since the last clear. The latest event
+  // is at (size - 1) % Trace::kRingBufferSize.
+  uint64 size;
+  TraceEvent events[Trace::kRingBufferSize];
+};
+
+class TraceBufferRegistry {
+ public:
+  TraceBufferRegistry() {}
+
+  ~TraceBufferRegistry() {
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      delete buffers_[i];
+    }
+  }
+
+  TraceBuffer *NewBuffer() {
+    scoped_lock l(&mutex_);
+    TraceBuffer *buffer = new TraceBuffer(static_cast<int>(buffers_.size()));
+    buffers_.push_back(buffer);
+    return buffer;
+  }
+
+  // Returns the buffer shared by all the threads when TLS is not available.
+  TraceBuffer *GetSharedBuffer() {
+    scoped_lock l(&mutex_);
+    if (buffers_.empty()) {
+      buffers_.push_back(new TraceBuffer(0));
+    }
+    return buffers_[0];
+  }
+
+  void Export(string *output) {
+    const double ticks_per_usec =
+        static_cast<double>(Util::GetFrequency()) / 1000000.0;
+    output->assign("{\"traceEvents\":[");
+    bool first = true;
+    scoped_lock l(&mutex_);
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      TraceBuffer *buffer = buffers_[i];
+      scoped_lock buffer_lock(&buffer->mutex);
+      const uint64 num_events =
+          min(buffer->size, static_cast<uint64>(Trace::kRingBufferSize));
+      for (uint64 j = buffer->size - num_events; j < buffer->size; ++j) {
+        const TraceEvent &event = buffer->events[j % Trace::kRingBufferSize];
+        if (!first) {
+          output->append(",");
+        }
+        first = false;
+        output->append(Util::StringPrintf(
+            "{\"name\":\"%s\",\"cat\":\"mozc\",\"ph\":\"%c\","
+            "\"ts\":%.3f,\"args\":{\"arg\":%d},\"pid\":0,\"tid\":%d}",
+            Trace::GetStageName(static_cast<Trace::Stage>(event.stage)),
+            event.is_begin ? 'B' : 'E',
+            event.ticks / ticks_per_usec,
+            event.arg,
+            buffer->thread_id));
+      }
+      buffer->size = 0;
+    }
+    output->append("]}");
+  }
+
+  void Clear() {
+    scoped_lock l(&mutex_);
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      scoped_lock buffer_lock(&buffers_[i]->mutex);
+      buffers_[i]->size = 0;
+    }
+  }
+
+ private:
+  Mutex mutex_;
+  vector<TraceBuffer *> buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBufferRegistry);
+};
+
+#ifdef HAVE_TLS
+TLS_KEYWORD TraceBuffer *g_trace_buffer = NULL;
+#endif  // HAVE_TLS
+
+TraceBuffer *GetTraceBuffer() {
+#ifdef HAVE_TLS
+  if (g_trace_buffer == NULL) {
+    g_trace_buffer = Singleton<TraceBufferRegistry>::get()->NewBuffer();
+  }
+  return g_trace_buffer;
+#else
+  return Singleton<TraceBufferRegistry>::get()->GetSharedBuffer();
+#endif  // HAVE_TLS
+}
+
+void AddEvent(Trace::Stage stage, int32 arg, bool is_begin) {
+  DCHECK_LT(stage, Trace::NUM_STAGES);
+  TraceBuffer *buffer = GetTraceBuffer();
+  const uint64 ticks = Util::GetTicks();
+  scoped_lock l(&buffer->mutex);
+  TraceEvent *event =
+      &buffer->events[buffer->size % Trace::kRingBufferSize];
+  event->ticks = ticks;
+  event->arg = arg;
+  event->stage = static_cast<uint8>(stage);
+  event->is_begin = is_begin;
+  ++buffer->size;
+}
+
+}  // namespace
+
+void Trace::Begin(Stage stage, int32 arg) {
+  AddEvent(stage, arg, true);
+}
+
+void Trace::End(Stage stage, int32 arg) {
+  AddEvent(stage, arg, false);
+}
+
+void Trace::ExportAsChromeTraceJson(string *output) {
+  DCHECK(output);
+  Singleton<TraceBufferRegistry>::get()->Export(output);
+}
+
+void Trace::Clear() {
+  Singleton<TraceBufferRegistry>::get()->Clear();
+}
+
+const char *Trace::GetStageName(Stage stage) {
+  static_assert(arraysize(kStageNames) == NUM_STAGES,
+                "kStageNames must have a name for each stage.");
+  if (stage < 0 || stage >= NUM_STAGES) {
+    return "Unknown";
+  }
+  return kStageNames[stage];
+}
+
+}  // namespace mozc
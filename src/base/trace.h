@@ -0,0 +1,141 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Lightweight tracing of the stages a key event goes through, from
+// SessionHandler down to the converter, predictors and rewriters.
+//
+// Each thread records begin/end events into its own ring buffer, so that
+// tracing does not serialize the threads. The events of all the threads can
+// be exported in the Chrome trace event format, which is viewable in
+// chrome://tracing, to see where the time of a slow key event was spent.
+//
+// The trace points are compiled in only when MOZC_ENABLE_TRACING is defined
+// (enable_tracing=1 in gyp). Otherwise MOZC_TRACE_SCOPE expands to nothing
+// and the exported trace is always empty.
+//
+// Usage:
+//   void ImmutableConverterImpl::Viterbi(...) {
+//     MOZC_TRACE_SCOPE(Trace::IMMUTABLE_CONVERTER_VITERBI);
+//     ...
+//   }
+
+#ifndef MOZC_BASE_TRACE_H_
+#define MOZC_BASE_TRACE_H_
+
+#include <string>
+
+#include "base/port.h"
+
+namespace mozc {
+
+class Trace {
+ public:
+  // Ids of the traced stages. Append new stages just before NUM_STAGES and
+  // give them a name in trace.cc.
+  enum Stage {
+    SESSION_HANDLER_EVAL_COMMAND = 0,
+    COMPOSER_INSERT_CHARACTER,
+    IMMUTABLE_CONVERTER_MAKE_LATTICE,
+    IMMUTABLE_CONVERTER_VITERBI,
+    NBEST_GENERATOR,
+    DICTIONARY_PREDICTOR_AGGREGATE_REALTIME_CONVERSION,
+    DICTIONARY_PREDICTOR_AGGREGATE_UNIGRAM,
+    DICTIONARY_PREDICTOR_AGGREGATE_BIGRAM,
+    DICTIONARY_PREDICTOR_AGGREGATE_SUFFIX,
+    DICTIONARY_PREDICTOR_AGGREGATE_ENGLISH,
+    DICTIONARY_PREDICTOR_AGGREGATE_TYPE_CORRECTING,
+    // The argument is the index of the rewriter in MergerRewriter.
+    MERGER_REWRITER_REWRITE,
+    SESSION_OUTPUT,
+    NUM_STAGES,
+  };
+
+  // Number of events kept per thread. Older events are overwritten.
+  static const size_t kRingBufferSize = 8192;
+
+  // Records the beginning and the end of |stage| in the buffer of the
+  // calling thread. |arg| is an optional stage specific number exported
+  // with the event.
+  static void Begin(Stage stage, int32 arg);
+  static void End(Stage stage, int32 arg);
+
+  // Exports the events recorded by all the threads as Chrome trace JSON,
+  // and clears them.
+  static void ExportAsChromeTraceJson(string *output);
+
+  // Clears the events recorded by all the threads.
+  static void Clear();
+
+  // Returns the name of |stage| used in the exported trace.
+  static const char *GetStageName(Stage stage);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(Trace);
+};
+
+// Records a span of |stage| covering the lifetime of this object.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(Trace::Stage stage)
+      : stage_(stage), arg_(0) {
+    Trace::Begin(stage_, arg_);
+  }
+  ScopedTrace(Trace::Stage stage, int32 arg)
+      : stage_(stage), arg_(arg) {
+    Trace::Begin(stage_, arg_);
+  }
+  ~ScopedTrace() {
+    Trace::End(stage_, arg_);
+  }
+
+ private:
+  const Trace::Stage stage_;
+  const int32 arg_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTrace);
+};
+
+}  // namespace mozc
+
+#define MOZC_TRACE_CONCAT_INTERNAL(a, b) a##b
+#define MOZC_TRACE_CONCAT(a, b) MOZC_TRACE_CONCAT_INTERNAL(a, b)
+
+#ifdef MOZC_ENABLE_TRACING
+#define MOZC_TRACE_SCOPE(stage) \
+  ::mozc::ScopedTrace MOZC_TRACE_CONCAT(mozc_trace_, __LINE__)( \
+      ::mozc::stage)
+#define MOZC_TRACE_SCOPE_WITH_ARG(stage, arg) \
+  ::mozc::ScopedTrace MOZC_TRACE_CONCAT(mozc_trace_, __LINE__)( \
+      ::mozc::stage, (arg))
+#else
+#define MOZC_TRACE_SCOPE(stage)
+#define MOZC_TRACE_SCOPE_WITH_ARG(stage, arg)
+#endif  // MOZC_ENABLE_TRACING
+
+#endif  // MOZC_BASE_TRACE_H_
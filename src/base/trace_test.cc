@@ -0,0 +1,164 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/trace.h"
+
+#include <string>
+
+#include "base/clock_mock.h"
+#include "base/scoped_ptr.h"
+#include "base/thread.h"
+#include "base/util.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace {
+
+// Returns the number of the occurrences of |pattern| in |str|.
+size_t CountOccurrences(const string &str, const string &pattern) {
+  size_t count = 0;
+  for (size_t pos = str.find(pattern); pos != string::npos;
+       pos = str.find(pattern, pos + pattern.size())) {
+    ++count;
+  }
+  return count;
+}
+
+class TraceThread : public Thread {
+ public:
+  virtual void Run() {
+    for (int i = 0; i < 10; ++i) {
+      ScopedTrace trace(Trace::MERGER_REWRITER_REWRITE, i);
+    }
+  }
+};
+
+class TraceTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    Trace::Clear();
+  }
+
+  virtual void TearDown() {
+    Util::SetClockHandler(NULL);
+    Trace::Clear();
+  }
+};
+
+}  // namespace
+
+TEST_F(TraceTest, ExportAsChromeTraceJson) {
+  ClockMock clock(0, 0);
+  // 1MHz (Accuracy = 1us)
+  clock.SetFrequency(1000000uLL);
+  clock.SetTicks(1000);
+  Util::SetClockHandler(&clock);
+
+  {
+    ScopedTrace outer(Trace::SESSION_HANDLER_EVAL_COMMAND);
+    clock.PutClockForwardByTicks(10);
+    {
+      ScopedTrace inner(Trace::MERGER_REWRITER_REWRITE, 3);
+      clock.PutClockForwardByTicks(5);
+    }
+  }
+
+  string json;
+  Trace::ExportAsChromeTraceJson(&json);
+  EXPECT_TRUE(Util::StartsWith(json, "{\"traceEvents\":[{"));
+  EXPECT_TRUE(Util::EndsWith(json, "}]}"));
+  EXPECT_EQ(4, CountOccurrences(json, "\"cat\":\"mozc\""));
+
+  // The thread id depends on the order the threads started tracing, so only
+  // the fields before it are checked.
+  const char *kExpectedEvents[] = {
+    "{\"name\":\"SessionHandler::EvalCommand\",\"cat\":\"mozc\","
+    "\"ph\":\"B\",\"ts\":1000.000,\"args\":{\"arg\":0},\"pid\":0,",
+    "{\"name\":\"MergerRewriter::Rewrite\",\"cat\":\"mozc\","
+    "\"ph\":\"B\",\"ts\":1010.000,\"args\":{\"arg\":3},\"pid\":0,",
+    "{\"name\":\"MergerRewriter::Rewrite\",\"cat\":\"mozc\","
+    "\"ph\":\"E\",\"ts\":1015.000,\"args\":{\"arg\":3},\"pid\":0,",
+    "{\"name\":\"SessionHandler::EvalCommand\",\"cat\":\"mozc\","
+    "\"ph\":\"E\",\"ts\":1015.000,\"args\":{\"arg\":0},\"pid\":0,",
+  };
+  size_t pos = 0;
+  for (size_t i = 0; i < arraysize(kExpectedEvents); ++i) {
+    pos = json.find(kExpectedEvents[i], pos);
+    ASSERT_NE(string::npos, pos) << kExpectedEvents[i];
+  }
+
+  // The events are cleared by the export.
+  Trace::ExportAsChromeTraceJson(&json);
+  EXPECT_EQ("{\"traceEvents\":[]}", json);
+}
+
+TEST_F(TraceTest, RingBuffer) {
+  const size_t kNumSpans = Trace::kRingBufferSize;
+  for (size_t i = 0; i < kNumSpans; ++i) {
+    ScopedTrace trace(Trace::NBEST_GENERATOR, static_cast<int32>(i));
+  }
+
+  // Only the latest kRingBufferSize events, i.e. the latter half of the
+  // spans, are kept.
+  string json;
+  Trace::ExportAsChromeTraceJson(&json);
+  EXPECT_EQ(kNumSpans, CountOccurrences(json, "\"name\":"));
+  EXPECT_EQ(string::npos, json.find("\"arg\":0},"));
+  EXPECT_NE(string::npos,
+            json.find(Util::StringPrintf("\"arg\":%d},",
+                                         static_cast<int>(kNumSpans / 2))));
+  EXPECT_EQ(string::npos,
+            json.find(Util::StringPrintf("\"arg\":%d},",
+                                         static_cast<int>(kNumSpans / 2 - 1))));
+}
+
+TEST_F(TraceTest, MultipleThreads) {
+  const int kNumThreads = 4;
+  TraceThread threads[kNumThreads];
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i].Start();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i].Join();
+  }
+
+  string json;
+  Trace::ExportAsChromeTraceJson(&json);
+  EXPECT_EQ(kNumThreads * 10, CountOccurrences(json, "\"ph\":\"B\""));
+  EXPECT_EQ(kNumThreads * 10, CountOccurrences(json, "\"ph\":\"E\""));
+}
+
+TEST_F(TraceTest, GetStageName) {
+  EXPECT_STREQ("ImmutableConverter::Viterbi",
+               Trace::GetStageName(Trace::IMMUTABLE_CONVERTER_VITERBI));
+  EXPECT_STREQ("SessionOutput", Trace::GetStageName(Trace::SESSION_OUTPUT));
+  EXPECT_STREQ("Unknown", Trace::GetStageName(Trace::NUM_STAGES));
+}
+
+}  // namespace mozc
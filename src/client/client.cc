@@ -100,6 +100,7 @@ Client::~Client() {
 
 void Client::SetIPCClientFactory(IPCClientFactoryInterface *client_factory) {
   client_factory_ = client_factory;
+  ipc_client_.reset();
 }
 
 void Client::SetServerLauncher(
@@ -604,6 +605,17 @@ bool Client::CallAndCheckVersion(const commands::Input &input,
   return true;
 }
 
+IPCClientInterface *Client::GetIPCClient(bool *reused) {
+  DCHECK(reused);
+  *reused = (ipc_client_.get() != NULL && ipc_client_->IsReusable());
+  if (!*reused) {
+    ipc_client_.reset(
+        client_factory_->NewClient(kServerAddress,
+                                   server_launcher_->server_program()));
+  }
+  return ipc_client_.get();
+}
+
 bool Client::Call(const commands::Input &input,
                   commands::Output *output) {
   VLOG(2) << "commands::Input: " << endl << input.DebugString();
@@ -624,9 +636,8 @@ bool Client::Call(const commands::Input &input,
   input.SerializeToString(&request);
 
   // Call IPC
-  scoped_ptr<IPCClientInterface> client(
-      client_factory_->NewClient(kServerAddress,
-                                 server_launcher_->server_program()));
+  bool reused = false;
+  IPCClientInterface *client = GetIPCClient(&reused);
 
   // set client protocol version.
   // When an error occurs inside Connected() function,
@@ -639,7 +650,7 @@ bool Client::Call(const commands::Input &input,
   server_product_version_ = Version::GetMozcVersion();
   server_process_id_ = 0;
 
-  if (client.get() == NULL) {
+  if (client == NULL) {
     LOG(ERROR) << "Cannot make client object";
     server_status_ = SERVER_FATAL;
     return false;
@@ -668,8 +679,29 @@ bool Client::Call(const commands::Input &input,
   // http://b/2126375
   // TODO(taku): Investigate the error in detail.
   size_t size = kResultBufferSize;
-  if (!client->Call(request.data(), request.size(),
-                    result_.get(), &size, timeout_)) {
+  bool called = client->Call(request.data(), request.size(),
+                             result_.get(), &size, timeout_);
+  if (!called && reused && client->GetLastIPCError() == IPC_WRITE_ERROR) {
+    // The server may have been restarted since the last Call().
+    // Retry once with a new connection. Only a failure in sending is
+    // retried, as the server has not received the whole request then.
+    // After the request is sent, the server may have processed it, and
+    // commands like SEND_KEY must not be applied twice.
+    LOG(WARNING) << "Reused connection is broken. Reconnecting.";
+    // Note that the broken client is deleted here.
+    client = GetIPCClient(&reused);
+    if (client == NULL) {
+      LOG(ERROR) << "Cannot make client object";
+      server_status_ = SERVER_FATAL;
+      return false;
+    }
+    if (client->Connected()) {
+      size = kResultBufferSize;
+      called = client->Call(request.data(), request.size(),
+                            result_.get(), &size, timeout_);
+    }
+  }
+  if (!called) {
     LOG(ERROR) << "Call failure";
     //               << input.DebugString();
     if (client->GetLastIPCError() == IPC_TIMEOUT_ERROR) {
@@ -800,6 +832,7 @@ bool Client::CheckVersionOrRestartServerInternal(
 }
 
 void Client::Reset() {
+  ipc_client_.reset();
   server_status_ = SERVER_UNKNOWN;
   server_protocol_version_ = 0;
   server_process_id_ = 0;
@@ -43,6 +43,7 @@
 
 namespace mozc {
 class IPCClientFactoryInterface;
+class IPCClientInterface;
 
 namespace config {
 class Config;
@@ -216,6 +217,11 @@ class Client : public ClientInterface {
   bool CallAndCheckVersion(const commands::Input &input,
                            commands::Output *output);
 
+  // Returns an IPC client connected to the server. The connection used by
+  // the previous Call() is reused if the server keeps it open.
+  // |reused| is set to true in that case.
+  IPCClientInterface *GetIPCClient(bool *reused);
+
   // Making a journal inputs to restore
   // the current state even when mozc_server crashes
   void PlaybackHistory();
@@ -242,6 +248,8 @@ class Client : public ClientInterface {
 
   uint64 id_;
   IPCClientFactoryInterface *client_factory_;
+  // IPC client kept for the next Call() if it is reusable.
+  scoped_ptr<IPCClientInterface> ipc_client_;
   scoped_ptr<ServerLauncherInterface> server_launcher_;
   scoped_ptr<char[]> result_;
   scoped_ptr<config::Config> preferences_;
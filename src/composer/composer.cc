@@ -33,6 +33,7 @@
 
 #include "base/logging.h"
 #include "base/singleton.h"
+#include "base/trace.h"
 #include "base/util.h"
 #include "composer/internal/composition.h"
 #include "composer/internal/composition_input.h"
@@ -202,6 +203,7 @@ Composer::Composer(const Table *table, const commands::Request *request)
       comeback_input_mode_(transliteration::HIRAGANA),
       input_field_type_(commands::Context::NORMAL),
       shifted_sequence_count_(0),
+      table_(table),
       composition_(new Composition(table)),
       typing_corrector_(table,
                         FLAGS_max_typing_correction_query_candidates,
@@ -235,6 +237,7 @@ bool Composer::Empty() const {
 }
 
 void Composer::SetTable(const Table *table) {
+  table_ = table;
   composition_->SetTable(table);
 
   typing_corrector_.SetTable(table);
@@ -466,6 +469,7 @@ void Composer::InsertCharacterKeyAndPreeditForProbableKeyEvents(
 }
 
 bool Composer::InsertCharacterKeyEvent(const commands::KeyEvent &key) {
+  MOZC_TRACE_SCOPE(Trace::COMPOSER_INSERT_CHARACTER);
   if (!EnableInsert()) {
     return false;
   }
@@ -1203,12 +1207,24 @@ void Composer::CopyFrom(const Composer &src) {
   source_text_.assign(src.source_text_);
   max_length_ = src.max_length_;
 
+  table_ = src.table_;
   composition_.reset(src.composition_->Clone());
   request_ = src.request_;
 
   typing_corrector_.CopyFrom(src.typing_corrector_);
 }
 
+void Composer::CopySettingsFrom(const Composer &src) {
+  SetTable(src.table_);
+  comeback_input_mode_ = src.comeback_input_mode_;
+  input_field_type_ = src.input_field_type_;
+  max_length_ = src.max_length_;
+  request_ = src.request_;
+  typing_corrector_.CopyFrom(src.typing_corrector_);
+
+  Reset();
+}
+
 bool Composer::is_new_input() const {
   return is_new_input_;
 }
@@ -216,6 +216,9 @@ class Composer {
   void SetNewInput();
 
   void CopyFrom(const Composer &src);
+  // Copies |src| except its composition. The result is the same as
+  // CopyFrom() followed by Reset(), but the composition is not copied.
+  void CopySettingsFrom(const Composer &src);
 
   bool is_new_input() const;
   size_t shifted_sequence_count() const;
@@ -260,6 +263,7 @@ class Composer {
   commands::Context::InputFieldType input_field_type_;
 
   size_t shifted_sequence_count_;
+  const Table *table_;
   scoped_ptr<CompositionInterface> composition_;
 
   TypingCorrector typing_corrector_;
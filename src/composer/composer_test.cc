@@ -1392,6 +1392,39 @@ TEST_F(ComposerTest, CopyFrom) {
   }
 }
 
+TEST_F(ComposerTest, CopySettingsFrom) {
+  // "あ"
+  table_->AddRule("a", "\xE3\x81\x82", "");
+
+  composer_->SetInputFieldType(commands::Context::PASSWORD);
+  composer_->SetInputMode(transliteration::FULL_KATAKANA);
+  composer_->set_max_length(10);
+  composer_->InsertCharacter("a");
+  composer_->InsertCharacter("a");
+
+  Composer dest(NULL, default_request_.get());
+  dest.CopySettingsFrom(*composer_);
+
+  Composer expected(NULL, default_request_.get());
+  expected.CopyFrom(*composer_);
+  expected.Reset();
+  ExpectSameComposer(expected, dest);
+  EXPECT_TRUE(dest.Empty());
+
+  // The table is copied too.
+  dest.InsertCharacter("a");
+  string preedit;
+  dest.GetStringForPreedit(&preedit);
+  // "ア"
+  EXPECT_EQ("\xE3\x82\xA2", preedit);
+
+  // The source composer is not modified.
+  preedit.clear();
+  composer_->GetStringForPreedit(&preedit);
+  // "アア"
+  EXPECT_EQ("\xE3\x82\xA2\xE3\x82\xA2", preedit);
+}
+
 TEST_F(ComposerTest, ShiftKeyOperation) {
   commands::KeyEvent key;
   // "あ"
@@ -35,6 +35,7 @@
 
 #include "base/config_file_stream.h"
 #include "base/logging.h"
+#include "base/mutex.h"
 #include "base/number_util.h"
 #include "base/port.h"
 #include "base/scoped_ptr.h"
@@ -86,6 +87,7 @@ class ConfigHandlerImpl {
   virtual ~ConfigHandlerImpl() {}
   const Config &GetConfig() const;
   bool GetConfig(Config *config) const;
+  ConfigSnapshot GetConfigSnapshot();
   const Config &GetStoredConfig() const;
   bool GetStoredConfig(Config *config) const;
   bool SetConfig(const Config &config);
@@ -105,6 +107,9 @@ class ConfigHandlerImpl {
   Config imposed_config_;
   // equals to config_.MergeFrom(imposed_config_)
   Config merged_config_;
+  // Copy of |merged_config_|, replaced whenever it is updated.
+  ConfigSnapshot merged_config_snapshot_;
+  Mutex snapshot_mutex_;
 };
 
 ConfigHandlerImpl *GetConfigHandlerImpl() {
@@ -121,6 +126,11 @@ bool ConfigHandlerImpl::GetConfig(Config *config) const {
   return true;
 }
 
+ConfigSnapshot ConfigHandlerImpl::GetConfigSnapshot() {
+  scoped_lock l(&snapshot_mutex_);
+  return merged_config_snapshot_;
+}
+
 const Config &ConfigHandlerImpl::GetStoredConfig() const {
   return stored_config_;
 }
@@ -168,6 +178,12 @@ bool ConfigHandlerImpl::SetConfigInternal(const Config &config) {
 void ConfigHandlerImpl::UpdateMergedConfig() {
   merged_config_.CopyFrom(stored_config_);
   merged_config_.MergeFrom(imposed_config_);
+
+  // Copies the config outside the lock. The old snapshot is kept alive by
+  // its holders.
+  const ConfigSnapshot snapshot(merged_config_);
+  scoped_lock l(&snapshot_mutex_);
+  merged_config_snapshot_ = snapshot;
 }
 
 bool ConfigHandlerImpl::SetConfig(const Config &config) {
@@ -245,10 +261,81 @@ string ConfigHandlerImpl::GetConfigFileName() {
 }
 }  // namespace
 
+class ConfigSnapshot::Rep {
+ public:
+  explicit Rep(const Config &config) : ref_count_(1) {
+    config_.CopyFrom(config);
+  }
+
+  const Config &config() const {
+    return config_;
+  }
+
+  void AddRef() {
+    scoped_lock l(&mutex_);
+    ++ref_count_;
+  }
+
+  // Returns true if this was the last reference.
+  bool Release() {
+    scoped_lock l(&mutex_);
+    return --ref_count_ == 0;
+  }
+
+ private:
+  Config config_;
+  Mutex mutex_;
+  int ref_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(Rep);
+};
+
+ConfigSnapshot::ConfigSnapshot() : rep_(NULL) {}
+
+ConfigSnapshot::ConfigSnapshot(const Config &config)
+    : rep_(new Rep(config)) {}
+
+ConfigSnapshot::ConfigSnapshot(const ConfigSnapshot &other)
+    : rep_(other.rep_) {
+  if (rep_ != NULL) {
+    rep_->AddRef();
+  }
+}
+
+ConfigSnapshot::~ConfigSnapshot() {
+  Release();
+}
+
+ConfigSnapshot &ConfigSnapshot::operator=(const ConfigSnapshot &other) {
+  if (rep_ != other.rep_) {
+    if (other.rep_ != NULL) {
+      other.rep_->AddRef();
+    }
+    Release();
+    rep_ = other.rep_;
+  }
+  return *this;
+}
+
+const Config &ConfigSnapshot::get() const {
+  return (rep_ == NULL) ? Config::default_instance() : rep_->config();
+}
+
+void ConfigSnapshot::Release() {
+  if (rep_ != NULL && rep_->Release()) {
+    delete rep_;
+  }
+  rep_ = NULL;
+}
+
 const Config &ConfigHandler::GetConfig() {
   return GetConfigHandlerImpl()->GetConfig();
 }
 
+ConfigSnapshot ConfigHandler::GetConfigSnapshot() {
+  return GetConfigHandlerImpl()->GetConfigSnapshot();
+}
+
 // Returns current Config
 bool ConfigHandler::GetConfig(Config *config) {
   return GetConfigHandlerImpl()->GetConfig(config);
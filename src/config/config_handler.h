@@ -44,6 +44,36 @@ enum {
   CONFIG_VERSION = 1,
 };
 
+// Immutable copy of a config shared by reference counting.
+// Copying a snapshot only increments the reference count, and the config it
+// refers to is never modified. Hence a snapshot can be read from any thread
+// while ConfigHandler::SetConfig() or Reload() replaces the current config.
+class ConfigSnapshot {
+ public:
+  // Refers to Config::default_instance().
+  ConfigSnapshot();
+  // Copies |config|.
+  explicit ConfigSnapshot(const Config &config);
+  ConfigSnapshot(const ConfigSnapshot &other);
+  ~ConfigSnapshot();
+
+  ConfigSnapshot &operator=(const ConfigSnapshot &other);
+
+  const Config &get() const;
+
+  // Returns true if both refer to the same copy of the config.
+  bool IsSameAs(const ConfigSnapshot &other) const {
+    return rep_ == other.rep_;
+  }
+
+ private:
+  class Rep;
+
+  void Release();
+
+  Rep *rep_;
+};
+
 // This is pure static class.
 class ConfigHandler {
  public:
@@ -53,6 +83,10 @@ class ConfigHandler {
   // Returns current config.
   static bool GetConfig(Config *config);
 
+  // Returns a snapshot of the current config. Unlike GetConfig(), the
+  // snapshot is not affected by the following SetConfig() or Reload().
+  static ConfigSnapshot GetConfigSnapshot();
+
   // Returns current config.
   // If imposed config is not set, the result is the same as GetConfig().
   static const Config &GetStoredConfig();
@@ -222,6 +222,38 @@ TEST_F(ConfigHandlerTest, SetImposedConfig) {
   }
 }
 
+TEST_F(ConfigHandlerTest, GetConfigSnapshot) {
+  config::Config input;
+  config::ConfigHandler::GetDefaultConfig(&input);
+  input.set_incognito_mode(false);
+  EXPECT_TRUE(config::ConfigHandler::SetConfig(input));
+
+  const config::ConfigSnapshot snapshot =
+      config::ConfigHandler::GetConfigSnapshot();
+  EXPECT_FALSE(snapshot.get().incognito_mode());
+  EXPECT_TRUE(snapshot.IsSameAs(config::ConfigHandler::GetConfigSnapshot()));
+
+  // Updating the config doesn't change the snapshots taken before.
+  input.set_incognito_mode(true);
+  EXPECT_TRUE(config::ConfigHandler::SetConfig(input));
+  EXPECT_FALSE(snapshot.get().incognito_mode());
+  const config::ConfigSnapshot updated_snapshot =
+      config::ConfigHandler::GetConfigSnapshot();
+  EXPECT_TRUE(updated_snapshot.get().incognito_mode());
+  EXPECT_FALSE(snapshot.IsSameAs(updated_snapshot));
+
+  // Copies share the same config.
+  config::ConfigSnapshot copied_snapshot;
+  EXPECT_FALSE(copied_snapshot.IsSameAs(snapshot));
+  copied_snapshot = snapshot;
+  EXPECT_TRUE(copied_snapshot.IsSameAs(snapshot));
+  EXPECT_FALSE(copied_snapshot.get().incognito_mode());
+
+  // The default snapshot refers to the default instance of Config.
+  const config::ConfigSnapshot default_snapshot;
+  EXPECT_EQ(&config::Config::default_instance(), &default_snapshot.get());
+}
+
 TEST_F(ConfigHandlerTest, ConfigFileNameConfig) {
   const string config_file = string("config")
       + NumberUtil::SimpleItoa(config::CONFIG_VERSION);
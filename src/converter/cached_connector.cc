@@ -37,7 +37,8 @@
 namespace mozc {
 namespace converter {
 namespace {
-const int kInvalidCacheKey = -1;
+// No valid key has both rid and lid of 0xffff.
+const uint64 kInvalidCacheEntry = static_cast<uint64>(0xffffffff) << 32;
 
 inline int GetHashValue(uint16 rid, uint16 lid, int hash_mask) {
   return ((3 * rid + lid) & hash_mask);
@@ -53,44 +54,36 @@ inline uint32 EncodeKey(uint16 rid, uint16 lid) {
   return (static_cast<uint32>(rid) << 16) | lid;
 }
 
+inline uint64 EncodeEntry(uint32 key, int cost) {
+  return (static_cast<uint64>(key) << 32) | static_cast<uint32>(cost);
+}
+
 }  // namespace
 
 CachedConnector::CachedConnector(ConnectorInterface *connector, int cache_size)
     : connector_(connector),
-      cache_initialized_(false),
-      cache_key_(new int[cache_size]),
-      cache_value_(new int[cache_size]),
+      cache_(new std::atomic<uint64>[cache_size]),
       cache_size_(cache_size),
       hash_mask_(cache_size - 1) {
   // Check if the cache_size is 2^k form.
   DCHECK_EQ(0, cache_size & (cache_size - 1));
+  ClearCache();
 }
 
 CachedConnector::~CachedConnector() {}
 
 int CachedConnector::GetTransitionCost(uint16 rid, uint16 lid) const {
-  InitializeCache();
-
-  const uint32 index = EncodeKey(rid, lid);
-  const int bucket = GetHashValue(rid, lid, hash_mask_);
-  if (cache_key_[bucket] != index) {
-    // Simply overwrite previous key/value.
-    cache_key_[bucket] = index;
-    cache_value_[bucket] = connector_->GetTransitionCost(rid, lid);
+  const uint32 key = EncodeKey(rid, lid);
+  std::atomic<uint64> &bucket = cache_[GetHashValue(rid, lid, hash_mask_)];
+  const uint64 entry = bucket.load(std::memory_order_relaxed);
+  if (static_cast<uint32>(entry >> 32) == key) {
+    return static_cast<int32>(static_cast<uint32>(entry));
   }
 
-  return cache_value_[bucket];
-}
-
-void CachedConnector::InitializeCache() const {
-  if (cache_initialized_) {
-    return;
-  }
-  VLOG(2) << "Initializing Cache for CachedConnector.";
-  for (int i = 0; i < cache_size_; ++i) {
-    cache_key_[i] = kInvalidCacheKey;
-  }
-  cache_initialized_ = true;
+  // Simply overwrite previous key/value.
+  const int cost = connector_->GetTransitionCost(rid, lid);
+  bucket.store(EncodeEntry(key, cost), std::memory_order_relaxed);
+  return cost;
 }
 
 // Test code can use this method to get acceptable error.
@@ -99,7 +92,10 @@ int CachedConnector::GetResolution() const {
 }
 
 void CachedConnector::ClearCache() {
-  cache_initialized_ = false;
+  VLOG(2) << "Initializing Cache for CachedConnector.";
+  for (int i = 0; i < cache_size_; ++i) {
+    cache_[i].store(kInvalidCacheEntry, std::memory_order_relaxed);
+  }
 }
 
 }  // namespace converter
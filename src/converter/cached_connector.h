@@ -30,6 +30,8 @@
 #ifndef MOZC_CONVERTER_CACHED_CONNECTOR_H_
 #define MOZC_CONVERTER_CACHED_CONNECTOR_H_
 
+#include <atomic>
+
 #include "base/port.h"
 #include "base/scoped_ptr.h"
 #include "converter/connector_interface.h"
@@ -38,6 +40,9 @@ namespace mozc {
 namespace converter {
 
 // Provides cache mechanism for Connector.
+// A direct-mapped cache of transition costs in front of another connector.
+// GetTransitionCost() is thread-safe, so one instance is shared by all the
+// threads converting with the same engine.
 class CachedConnector : public ConnectorInterface {
  public:
   // |cache_size| should be 2^k form of value.
@@ -51,15 +56,14 @@ class CachedConnector : public ConnectorInterface {
   void ClearCache();
 
  private:
-  void InitializeCache() const;
-
   ConnectorInterface *connector_;
 
-  // Cache data need to be mutable as they are modified in const methods. For
-  // the performance, we are assuming the cache is an array, not vector.
-  mutable bool cache_initialized_;
-  mutable scoped_ptr<int[]> cache_key_;
-  mutable scoped_ptr<int[]> cache_value_;
+  // Each entry packs the key (rid << 16 | lid) into the upper 32 bits and
+  // the cost into the lower 32 bits, so that a lookup reads both with one
+  // relaxed atomic load.  Threads racing on a bucket may overwrite each
+  // other's entry, but a reader never sees a key paired with the cost of
+  // another key.  The entries are modified in const methods.
+  scoped_ptr<std::atomic<uint64>[]> cache_;
   const int cache_size_;
   const int hash_mask_;
 
@@ -95,6 +95,42 @@ class CachedConnectorThread : public Thread {
   scoped_ptr<TestConnector> test_;
   scoped_ptr<CachedConnector> cached_;
 };
+
+// Looks up the transition costs through a CachedConnector shared with other
+// threads.
+class SharedCachedConnectorThread : public Thread {
+ public:
+  SharedCachedConnectorThread(const TestConnector *test,
+                              const CachedConnector *cached,
+                              int seed)
+      : test_(test), cached_(cached), seed_(seed), num_errors_(0) {}
+
+  void Run() {
+    // Each thread walks the ids in a different order so that the threads
+    // overwrite the same buckets with different keys.
+    const int kIdSize = 100;
+    for (int trial = 0; trial < 100; ++trial) {
+      for (int i = 0; i < kIdSize; ++i) {
+        for (int j = 0; j < kIdSize; ++j) {
+          const uint16 rid = (i * 7 + seed_) % kIdSize;
+          const uint16 lid = (j * 13 + trial + seed_) % kIdSize;
+          if (test_->GetTransitionCost(rid, lid) !=
+              cached_->GetTransitionCost(rid, lid)) {
+            ++num_errors_;
+          }
+        }
+      }
+    }
+  }
+
+  int num_errors() const { return num_errors_; }
+
+ private:
+  const TestConnector *test_;
+  const CachedConnector *cached_;
+  const int seed_;
+  int num_errors_;
+};
 }  // namespace
 
 class CachedConnectorTest : public testing::Test {
@@ -149,5 +185,27 @@ TEST_F(CachedConnectorTest, CacheTestWithThread) {
   }
 }
 
+TEST_F(CachedConnectorTest, SharedCacheTestWithThread) {
+  // One CachedConnector is shared by all the converting threads of an
+  // engine, so concurrent lookups must always return the right cost.
+  TestConnector test(0);
+  CachedConnector cached(&test, kCacheSize);
+  const int kSize = 8;
+  vector<SharedCachedConnectorThread *> threads;
+  for (int i = 0; i < kSize; ++i) {
+    threads.push_back(new SharedCachedConnectorThread(&test, &cached, i));
+  }
+
+  for (int i = 0; i < kSize; ++i) {
+    threads[i]->Start();
+  }
+
+  for (int i = 0; i < kSize; ++i) {
+    threads[i]->Join();
+    EXPECT_EQ(0, threads[i]->num_errors()) << i;
+    delete threads[i];
+  }
+}
+
 }  // namespace converter
 }  // namespace mozc
@@ -99,6 +99,21 @@ void CandidateFilter::Reset() {
   top_candidate_ = NULL;
 }
 
+bool CandidateFilter::IsSeen(const string &value) const {
+  return binary_search(seen_.begin(), seen_.end(), Util::Fingerprint(value));
+}
+
+bool CandidateFilter::MarkSeen(const string &value) {
+  const uint64 fingerprint = Util::Fingerprint(value);
+  vector<uint64>::iterator it =
+      lower_bound(seen_.begin(), seen_.end(), fingerprint);
+  if (it != seen_.end() && *it == fingerprint) {
+    return false;
+  }
+  seen_.insert(it, fingerprint);
+  return true;
+}
+
 CandidateFilter::ResultType CandidateFilter::FilterCandidateInternal(
     const string &original_key,
     const Segment::Candidate *candidate,
@@ -170,7 +185,7 @@ CandidateFilter::ResultType CandidateFilter::FilterCandidateInternal(
   }
 
   // The candidate is already seen.
-  if (seen_.find(candidate->value) != seen_.end()) {
+  if (IsSeen(candidate->value)) {
     return CandidateFilter::BAD_CANDIDATE;
   }
 
@@ -362,7 +377,7 @@ CandidateFilter::ResultType CandidateFilter::FilterCandidate(
     // In reverse conversion, only remove duplicates because the filtering
     // criteria of FilterCandidateInternal() are completely designed for
     // (forward) conversion.
-    const bool inserted = seen_.insert(candidate->value).second;
+    const bool inserted = MarkSeen(candidate->value);
     return inserted ? GOOD_CANDIDATE : BAD_CANDIDATE;
   } else {
     const ResultType result = FilterCandidateInternal(original_key, candidate,
@@ -370,7 +385,7 @@ CandidateFilter::ResultType CandidateFilter::FilterCandidate(
     if (result != GOOD_CANDIDATE) {
       return result;
     }
-    seen_.insert(candidate->value);
+    MarkSeen(candidate->value);
     return result;
   }
 }
@@ -30,7 +30,6 @@
 #ifndef MOZC_CONVERTER_CANDIDATE_FILTER_H_
 #define MOZC_CONVERTER_CANDIDATE_FILTER_H_
 
-#include <set>
 #include <string>
 #include <vector>
 #include "base/port.h"
@@ -77,7 +76,15 @@ class CandidateFilter {
   const POSMatcher *pos_matcher_;
   const SuggestionFilter *suggestion_filter_;
 
-  set<string> seen_;
+  // Returns true if a candidate of |value| has been accepted.
+  bool IsSeen(const string &value) const;
+  // Records |value| as accepted. Returns false if it has already been.
+  bool MarkSeen(const string &value);
+
+  // Sorted fingerprints of the values of the accepted candidates. The number
+  // of the candidates is bounded, so a flat array is cheaper than a tree of
+  // strings to allocate and to search.
+  vector<uint64> seen_;
   const Segment::Candidate *top_candidate_;
 
   DISALLOW_COPY_AND_ASSIGN(CandidateFilter);
@@ -29,14 +29,22 @@
 
 #include "converter/connector_base.h"
 
+#include "base/flags.h"
 #include "base/port.h"
 #include "converter/cached_connector.h"
+#include "converter/dense_connector.h"
 #include "converter/sparse_connector.h"
 #include "data_manager/data_manager_interface.h"
 
+DEFINE_bool(use_dense_connector, false,
+            "Expand the connection matrix into a dense array at load time. "
+            "This makes Viterbi faster at the cost of num_ids^2 * 2 bytes "
+            "of memory.");
+
 namespace mozc {
 
 using converter::CachedConnector;
+using converter::DenseConnector;
 
 ConnectorBase *ConnectorBase::CreateFromDataManager(
     const DataManagerInterface &data_manager) {
@@ -48,25 +56,44 @@ ConnectorBase *ConnectorBase::CreateFromDataManager(
   const char *connection_data = NULL;
   size_t connection_data_size = 0;
   data_manager.GetConnectorData(&connection_data, &connection_data_size);
-  return new ConnectorBase(connection_data, connection_data_size, kCacheSize);
+  return new ConnectorBase(connection_data, connection_data_size, kCacheSize,
+                           FLAGS_use_dense_connector);
 }
 
 ConnectorBase::ConnectorBase(const char *connection_data,
                              size_t connection_size,
-                             int cache_size)
-    : sparse_connector_(new SparseConnector(connection_data, connection_size)),
-      cached_connector_(new CachedConnector(sparse_connector_.get(),
-                                            cache_size)) {}
+                             int cache_size,
+                             bool use_dense_matrix)
+    : sparse_connector_(new SparseConnector(connection_data, connection_size)) {
+  if (use_dense_matrix) {
+    dense_connector_.reset(
+        new DenseConnector(*sparse_connector_, sparse_connector_->num_ids()));
+  } else {
+    cached_connector_.reset(
+        new CachedConnector(sparse_connector_.get(), cache_size));
+  }
+}
 
 ConnectorBase::~ConnectorBase() {}
 
-
 int ConnectorBase::GetTransitionCost(uint16 rid, uint16 lid) const {
+  if (dense_connector_.get() != NULL) {
+    return dense_connector_->GetTransitionCost(rid, lid);
+  }
   return cached_connector_->GetTransitionCost(rid, lid);
 }
 
+void ConnectorBase::GetTransitionCosts(const uint16 *rids, size_t size,
+                                       uint16 lid, int *costs) const {
+  if (dense_connector_.get() != NULL) {
+    dense_connector_->GetTransitionCosts(rids, size, lid, costs);
+    return;
+  }
+  cached_connector_->GetTransitionCosts(rids, size, lid, costs);
+}
+
 int ConnectorBase::GetResolution() const {
-  return cached_connector_->GetResolution();
+  return sparse_connector_->GetResolution();
 }
 
 }  // namespace mozc
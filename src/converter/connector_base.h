@@ -42,6 +42,7 @@ class SparseConnector;
 
 namespace converter {
 class CachedConnector;
+class DenseConnector;
 }  // namespace converter
 
 class ConnectorBase : public ConnectorInterface {
@@ -49,17 +50,24 @@ class ConnectorBase : public ConnectorInterface {
   static ConnectorBase *CreateFromDataManager(
       const DataManagerInterface &data_manager);
 
+  // If |use_dense_matrix| is true, the whole connection matrix is expanded
+  // at construction and |cache_size| is ignored.  Otherwise, costs are
+  // decoded from the sparse data on demand through a cache of |cache_size|.
   ConnectorBase(const char *connection_data, size_t connection_size,
-                int cache_size);
+                int cache_size, bool use_dense_matrix);
   virtual ~ConnectorBase();
 
   virtual int GetTransitionCost(uint16 rid, uint16 lid) const;
+  virtual void GetTransitionCosts(const uint16 *rids, size_t size, uint16 lid,
+                                  int *costs) const;
   virtual int GetResolution() const;
 
  private:
   scoped_ptr<SparseConnector> sparse_connector_;
   scoped_ptr<converter::CachedConnector> cached_connector_;
+  scoped_ptr<converter::DenseConnector> dense_connector_;
 
+  DISALLOW_COPY_AND_ASSIGN(ConnectorBase);
 };
 
 }  // namespace mozc
@@ -40,6 +40,17 @@ class ConnectorInterface {
 
   virtual int GetTransitionCost(uint16 rid, uint16 lid) const = 0;
 
+  // Stores GetTransitionCost(rids[i], lid) into costs[i] for each i in
+  // [0, size).  Viterbi calls this for every begin node with the rids of all
+  // the end nodes at the same position, so implementations holding a dense
+  // matrix can override this to look the costs up from a single row.
+  virtual void GetTransitionCosts(const uint16 *rids, size_t size, uint16 lid,
+                                  int *costs) const {
+    for (size_t i = 0; i < size; ++i) {
+      costs[i] = GetTransitionCost(rids[i], lid);
+    }
+  }
+
   // Test code can use this method to get acceptable error.
   virtual int GetResolution() const = 0;
 
@@ -30,6 +30,7 @@
 #include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "base/logging.h"
+#include "config/config.pb.h"
 #include "session/commands.pb.h"
 
 namespace mozc {
@@ -37,19 +38,41 @@ namespace mozc {
 ConversionRequest::ConversionRequest()
     : composer_(NULL),
       request_(&commands::Request::default_instance()),
+      config_(config::ConfigHandler::GetConfigSnapshot()),
       use_actual_converter_for_realtime_conversion_(false),
       composer_key_selection_(CONVERSION_KEY),
       skip_slow_rewriters_(false),
-      create_partial_candidates_(false) {}
+      create_partial_candidates_(false),
+      kana_modifier_insensitive_conversion_(true),
+      nbest_beam_width_(0),
+      nbest_cost_threshold_(0) {}
 
 ConversionRequest::ConversionRequest(const composer::Composer *c,
                                      const commands::Request *request)
     : composer_(c),
       request_(request),
+      config_(config::ConfigHandler::GetConfigSnapshot()),
       use_actual_converter_for_realtime_conversion_(false),
       composer_key_selection_(CONVERSION_KEY),
       skip_slow_rewriters_(false),
-      create_partial_candidates_(false) {}
+      create_partial_candidates_(false),
+      kana_modifier_insensitive_conversion_(true),
+      nbest_beam_width_(0),
+      nbest_cost_threshold_(0) {}
+
+ConversionRequest::ConversionRequest(const composer::Composer *c,
+                                     const commands::Request *request,
+                                     const config::ConfigSnapshot &config)
+    : composer_(c),
+      request_(request),
+      config_(config),
+      use_actual_converter_for_realtime_conversion_(false),
+      composer_key_selection_(CONVERSION_KEY),
+      skip_slow_rewriters_(false),
+      create_partial_candidates_(false),
+      kana_modifier_insensitive_conversion_(true),
+      nbest_beam_width_(0),
+      nbest_cost_threshold_(0) {}
 
 ConversionRequest::~ConversionRequest() {}
 
@@ -71,6 +94,18 @@ const commands::Request &ConversionRequest::request() const {
   return *request_;
 }
 
+void ConversionRequest::set_request(const commands::Request *request) {
+  request_ = request;
+}
+
+const config::Config &ConversionRequest::config() const {
+  return config_.get();
+}
+
+void ConversionRequest::set_config(const config::ConfigSnapshot &config) {
+  config_ = config;
+}
+
 bool ConversionRequest::use_actual_converter_for_realtime_conversion() const {
   return use_actual_converter_for_realtime_conversion_;
 }
@@ -107,18 +142,44 @@ void ConversionRequest::set_create_partial_candidates(bool value) {
 }
 
 bool ConversionRequest::IsKanaModifierInsensitiveConversion() const {
-  return request_->kana_modifier_insensitive_conversion() &&
-         GET_CONFIG(use_kana_modifier_insensitive_conversion);
+  return kana_modifier_insensitive_conversion_ &&
+         request_->kana_modifier_insensitive_conversion() &&
+         config_.get().use_kana_modifier_insensitive_conversion();
+}
+
+void ConversionRequest::set_kana_modifier_insensitive_conversion(bool value) {
+  kana_modifier_insensitive_conversion_ = value;
+}
+
+size_t ConversionRequest::nbest_beam_width() const {
+  return nbest_beam_width_;
+}
+
+void ConversionRequest::set_nbest_beam_width(size_t width) {
+  nbest_beam_width_ = width;
+}
+
+int32 ConversionRequest::nbest_cost_threshold() const {
+  return nbest_cost_threshold_;
+}
+
+void ConversionRequest::set_nbest_cost_threshold(int32 threshold) {
+  nbest_cost_threshold_ = threshold;
 }
 
 void ConversionRequest::CopyFrom(const ConversionRequest &request) {
   composer_ = request.composer_;
   request_ = request.request_;
+  config_ = request.config_;
   use_actual_converter_for_realtime_conversion_ =
       request.use_actual_converter_for_realtime_conversion_;
   composer_key_selection_ = request.composer_key_selection_;
   skip_slow_rewriters_ = request.skip_slow_rewriters_;
   create_partial_candidates_ = request.create_partial_candidates_;
+  kana_modifier_insensitive_conversion_ =
+      request.kana_modifier_insensitive_conversion_;
+  nbest_beam_width_ = request.nbest_beam_width_;
+  nbest_cost_threshold_ = request.nbest_cost_threshold_;
 }
 
 }  // namespace mozc
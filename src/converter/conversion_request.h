@@ -33,6 +33,7 @@
 #include <string>
 
 #include "base/port.h"
+#include "config/config_handler.h"
 
 namespace mozc {
 namespace composer {
@@ -44,7 +45,9 @@ class Request;
 
 // Contains utilizable information for conversion, suggestion and prediction,
 // including composition, preceding text, etc.
-// This class doesn't take ownerships of any Composer* argument.
+// This class doesn't take ownerships of any Composer* or Request* argument.
+// The config is held as a snapshot, so it stays valid and unchanged while
+// the config is updated.
 // TODO(team, yukawa): Refactor this class so it can represents that more
 // detailed context information such as commands::Context.
 class ConversionRequest {
@@ -66,8 +69,12 @@ class ConversionRequest {
   };
 
   ConversionRequest();
+  // Uses the snapshot of the current config of ConfigHandler.
   ConversionRequest(const composer::Composer *c,
                     const commands::Request *request);
+  ConversionRequest(const composer::Composer *c,
+                    const commands::Request *request,
+                    const config::ConfigSnapshot &config);
   ~ConversionRequest();
 
   bool has_composer() const;
@@ -84,6 +91,13 @@ class ConversionRequest {
   void set_composer_key_selection(ComposerKeySelection selection);
 
   const commands::Request &request() const;
+  void set_request(const commands::Request *request);
+
+  // The config used for this conversion. Modules on the conversion path
+  // should read settings from here instead of the global ConfigHandler, so
+  // that sessions with different configs can be processed concurrently.
+  const config::Config &config() const;
+  void set_config(const config::ConfigSnapshot &config);
 
   void CopyFrom(const ConversionRequest &request);
 
@@ -92,7 +106,18 @@ class ConversionRequest {
   bool skip_slow_rewriters() const;
   void set_skip_slow_rewriters(bool value);
 
+  // Returns true if kana modifier insensitive lookup is enabled by the
+  // request, the config and set_kana_modifier_insensitive_conversion().
   bool IsKanaModifierInsensitiveConversion() const;
+  void set_kana_modifier_insensitive_conversion(bool value);
+
+  // Limits of the N-best search of the immutable converter, which trade
+  // recall for latency. See NBestGenerator::set_beam_width() and
+  // NBestGenerator::set_cost_threshold(). Zero means no limit (default).
+  size_t nbest_beam_width() const;
+  void set_nbest_beam_width(size_t width);
+  int32 nbest_cost_threshold() const;
+  void set_nbest_cost_threshold(int32 threshold);
 
  private:
   // Required fields
@@ -102,6 +127,10 @@ class ConversionRequest {
   // Input request.
   const commands::Request *request_;
 
+  // Config for this conversion. The snapshot of the current config of
+  // ConfigHandler at the construction by default.
+  config::ConfigSnapshot config_;
+
   // If true, insert a top candidate from the actual (non-immutable) converter
   // to realtime conversion results. Note that setting this true causes a big
   // performance loss (3 times slower).
@@ -121,6 +150,14 @@ class ConversionRequest {
   // For example, "私の" is created from composition "わたしのなまえ".
   bool create_partial_candidates_;
 
+  // If false, kana modifier insensitive lookup is disabled regardless of the
+  // request and the config.
+  bool kana_modifier_insensitive_conversion_;
+
+  // Limits of the N-best search. Zero means no limit.
+  size_t nbest_beam_width_;
+  int32 nbest_cost_threshold_;
+
   // TODO(noriyukit): Moves all the members of Segments that are irrelevant to
   // this structure, e.g., Segments::user_history_enabled_ and
   // Segments::request_type_. Also, a key for conversion is eligible to live in
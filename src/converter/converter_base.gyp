@@ -85,6 +85,21 @@
         'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
       },
     },
+    {
+      'target_name': 'dense_connector',
+      'type': 'static_library',
+      'sources': [
+        'dense_connector.cc',
+      ],
+      'dependencies': [
+        '../base/base.gyp:base',
+      ],
+      'xcode_settings' : {
+        'SDKROOT': 'iphoneos',
+        'IPHONEOS_DEPLOYMENT_TARGET': '7.0',
+        'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
+      },
+    },
     {
       'target_name': 'connector_base',
       'type': 'static_library',
@@ -94,6 +109,7 @@
       'dependencies': [
         '../base/base.gyp:base',
         'cached_connector',
+        'dense_connector',
         'sparse_connector',
       ],
       'xcode_settings' : {
@@ -108,6 +124,7 @@
       'sources': [
         'lattice.cc',
         'node_allocator.h',
+        'viterbi_table.cc',
       ],
       'dependencies': [
         '../base/base.gyp:base',
@@ -238,6 +255,8 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
+        '../config/config.gyp:config_handler',
+        '../config/config.gyp:config_protocol',
         '../session/session_base.gyp:session_protocol',
       ],
       'xcode_settings' : {
@@ -41,6 +41,15 @@ namespace composer {
 class Composer;
 }  // namespace composer
 
+// Thread safety: one converter (and the engine owning it) can be shared by
+// several threads. The Start*() methods and ReconstructHistory() may be
+// called in parallel as long as each thread passes its own Segments. All the
+// scratch data of a conversion, such as the lattice and its nodes, lives in
+// the Segments or on the stack, and the shared modules (dictionaries,
+// connector cache and user history) are safe for concurrent lookups.
+// The methods learning from the user input, i.e. FinishConversion() and
+// RevertConversion(), must not run in parallel with any other method, because
+// the rewriters update their storages without locking.
 class ConverterInterface {
  public:
   // Allow deletion through the interface.
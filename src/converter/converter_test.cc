@@ -36,6 +36,7 @@
 #include "base/port.h"
 #include "base/scoped_ptr.h"
 #include "base/system_util.h"
+#include "base/thread.h"
 #include "base/util.h"
 #include "composer/composer.h"
 #include "composer/table.h"
@@ -143,6 +144,59 @@ class InsertDummyWordsRewriter : public RewriterInterface {
   }
 };
 
+// Returns the top candidates of all the conversion segments joined by '|'.
+string GetTopCandidates(const Segments &segments) {
+  string result;
+  for (size_t i = 0; i < segments.conversion_segments_size(); ++i) {
+    const Segment &segment = segments.conversion_segment(i);
+    if (segment.candidates_size() > 0) {
+      result.append(segment.candidate(0).value);
+    }
+    result.append("|");
+  }
+  return result;
+}
+
+// Converts and suggests the given keys with a converter shared with other
+// threads, and records the top candidates.
+class ConversionThread : public Thread {
+ public:
+  ConversionThread(const ConverterInterface *converter,
+                   const vector<string> &keys, int num_trials)
+      : converter_(converter), keys_(keys), num_trials_(num_trials) {}
+
+  virtual void Run() {
+    composer::Table table;
+    commands::Request client_request;
+    for (int trial = 0; trial < num_trials_; ++trial) {
+      results_.clear();
+      for (size_t i = 0; i < keys_.size(); ++i) {
+        composer::Composer composer(&table, &client_request);
+        composer.InsertCharacterPreedit(keys_[i]);
+        const ConversionRequest request(&composer, &client_request);
+        {
+          Segments segments;
+          converter_->StartConversionForRequest(request, &segments);
+          results_.push_back(GetTopCandidates(segments));
+        }
+        {
+          Segments segments;
+          converter_->StartSuggestionForRequest(request, &segments);
+          results_.push_back(GetTopCandidates(segments));
+        }
+      }
+    }
+  }
+
+  const vector<string> &results() const { return results_; }
+
+ private:
+  const ConverterInterface *converter_;
+  const vector<string> keys_;
+  const int num_trials_;
+  vector<string> results_;
+};
+
 }  // namespace
 
 class ConverterTest : public ::testing::Test {
@@ -1679,4 +1733,41 @@ TEST_F(ConverterTest, ReconstructHistory) {
   EXPECT_NE(0, candidate.rid);
 }
 
+TEST_F(ConverterTest, ConcurrentConversionsOnSharedEngine) {
+  scoped_ptr<EngineInterface> engine(MockDataEngineFactory::Create());
+  const ConverterInterface *converter = engine->GetConverter();
+
+  vector<string> keys;
+  // "わたしのなまえはなかのです"
+  keys.push_back("\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97\xE3\x81\xAE\xE3\x81\xAA"
+                 "\xE3\x81\xBE\xE3\x81\x88\xE3\x81\xAF\xE3\x81\xAA\xE3\x81\x8B"
+                 "\xE3\x81\xAE\xE3\x81\xA7\xE3\x81\x99");
+  // "きょうはいいてんきです"
+  keys.push_back("\xE3\x81\x8D\xE3\x82\x87\xE3\x81\x86\xE3\x81\xAF\xE3\x81\x84"
+                 "\xE3\x81\x84\xE3\x81\xA6\xE3\x82\x93\xE3\x81\x8D\xE3\x81\xA7"
+                 "\xE3\x81\x99");
+  // "かいぎ"
+  keys.push_back("\xE3\x81\x8B\xE3\x81\x84\xE3\x81\x8E");
+  // "にほんご"
+  keys.push_back("\xE3\x81\xAB\xE3\x81\xBB\xE3\x82\x93\xE3\x81\x94");
+
+  // The results converted by one thread are the expected ones.
+  ConversionThread baseline(converter, keys, 1);
+  baseline.Run();
+
+  const int kNumThreads = 8;
+  vector<ConversionThread *> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new ConversionThread(converter, keys, 20));
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Start();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    EXPECT_EQ(baseline.results(), threads[i]->results()) << i;
+    delete threads[i];
+  }
+}
+
 }  // namespace mozc
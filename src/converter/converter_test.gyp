@@ -44,7 +44,9 @@
         'key_corrector_test.cc',
         'lattice_test.cc',
         'nbest_generator_test.cc',
+        'node_allocator_test.cc',
         'segments_test.cc',
+        'viterbi_table_test.cc',
       ],
       'dependencies': [
         '../composer/composer.gyp:composer',
@@ -137,6 +139,21 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'dense_connector_test',
+      'type': 'executable',
+      'sources': [
+        'dense_connector_test.cc',
+      ],
+      'dependencies': [
+        '../testing/testing.gyp:gtest_main',
+        'converter_base.gyp:dense_connector',
+        'converter_base.gyp:sparse_connector',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     # Test cases meta target: this target is referred from gyp/tests.gyp
     {
       'target_name': 'converter_all_test',
@@ -145,6 +162,7 @@
         'cached_connector_test',
         'converter_test',
         'converter_regression_test',
+        'dense_connector_test',
         'sparse_connector_test',
       ],
     },
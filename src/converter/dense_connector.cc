@@ -0,0 +1,83 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "converter/dense_connector.h"
+
+#include "base/logging.h"
+#include "base/port.h"
+
+namespace mozc {
+namespace converter {
+
+DenseConnector::DenseConnector(const ConnectorInterface &connector,
+                               int num_ids)
+    : num_ids_(num_ids),
+      resolution_(connector.GetResolution()),
+      overflow_cost_(kOverflowCostValue),
+      costs_(new uint16[static_cast<size_t>(num_ids) * num_ids]) {
+  CHECK_GT(num_ids, 0);
+  CHECK_LE(num_ids, kuint16max + 1);
+  bool has_overflow = false;
+  for (int lid = 0; lid < num_ids; ++lid) {
+    uint16 *row = costs_.get() + static_cast<size_t>(lid) * num_ids;
+    for (int rid = 0; rid < num_ids; ++rid) {
+      const int cost = connector.GetTransitionCost(rid, lid);
+      CHECK_GE(cost, 0) << "Negative cost: " << rid << " " << lid;
+      if (cost < kOverflowCostValue) {
+        row[rid] = static_cast<uint16>(cost);
+        continue;
+      }
+      // Connection data has 16-bit costs, or 1-byte costs multiplied by the
+      // resolution, where only kInvalidCost * resolution exceeds 16 bits.
+      // So there is at most one such cost for valid data.
+      CHECK(!has_overflow || cost == overflow_cost_)
+          << "Too many costs out of 16 bits: " << overflow_cost_ << " "
+          << cost;
+      has_overflow = true;
+      overflow_cost_ = cost;
+      row[rid] = kOverflowCostValue;
+    }
+  }
+}
+
+DenseConnector::~DenseConnector() {}
+
+void DenseConnector::GetTransitionCosts(const uint16 *rids, size_t size,
+                                        uint16 lid, int *costs) const {
+  DCHECK_LT(lid, num_ids_);
+  const uint16 *row = costs_.get() + static_cast<size_t>(lid) * num_ids_;
+  for (size_t i = 0; i < size; ++i) {
+    DCHECK_LT(rids[i], num_ids_);
+    const uint16 cost = row[rids[i]];
+    costs[i] = (cost == kOverflowCostValue) ? overflow_cost_ : cost;
+  }
+}
+
+}  // namespace converter
+}  // namespace mozc
@@ -0,0 +1,94 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_CONVERTER_DENSE_CONNECTOR_H_
+#define MOZC_CONVERTER_DENSE_CONNECTOR_H_
+
+#include "base/logging.h"
+#include "base/port.h"
+#include "base/scoped_ptr.h"
+#include "converter/connector_interface.h"
+
+namespace mozc {
+namespace converter {
+
+// Holds the whole connection matrix uncompressed so that a transition cost
+// is a single array load.  The matrix is stored lid-major, i.e., the costs
+// for one lid and all the rids are contiguous, which is the access pattern of
+// Viterbi: for each begin node (lid) it scans all the end nodes (rid) at the
+// same position.  GetTransitionCosts() exploits this layout; the loop over a
+// row has no branches and can be vectorized by the compiler.
+//
+// The matrix takes num_ids^2 * 2 bytes (about 13MB for the OSS dictionary),
+// so this is meant for environments where memory is cheaper than latency.
+// Costs are kept in 16 bits except for one value which doesn't fit, i.e.,
+// kInvalidCost * resolution in the connection data with 1-byte costs. It is
+// stored as kOverflowCostValue and restored on lookup.
+class DenseConnector : public ConnectorInterface {
+ public:
+  // Expands all the transition costs of |connector| for ids in
+  // [0, num_ids).  |connector| is not referred after construction.
+  DenseConnector(const ConnectorInterface &connector, int num_ids);
+  virtual ~DenseConnector();
+
+  virtual int GetTransitionCost(uint16 rid, uint16 lid) const {
+    DCHECK_LT(rid, num_ids_);
+    DCHECK_LT(lid, num_ids_);
+    const uint16 cost = costs_[static_cast<size_t>(lid) * num_ids_ + rid];
+    return (cost == kOverflowCostValue) ? overflow_cost_ : cost;
+  }
+
+  virtual void GetTransitionCosts(const uint16 *rids, size_t size, uint16 lid,
+                                  int *costs) const;
+
+  virtual int GetResolution() const {
+    return resolution_;
+  }
+
+  int num_ids() const {
+    return num_ids_;
+  }
+
+ private:
+  static const uint16 kOverflowCostValue = 0xFFFF;
+
+  const int num_ids_;
+  const int resolution_;
+  // The cost represented by kOverflowCostValue in |costs_|.
+  int overflow_cost_;
+  // costs_[lid * num_ids_ + rid] is the transition cost from rid to lid.
+  scoped_ptr<uint16[]> costs_;
+
+  DISALLOW_COPY_AND_ASSIGN(DenseConnector);
+};
+
+}  // namespace converter
+}  // namespace mozc
+
+#endif  // MOZC_CONVERTER_DENSE_CONNECTOR_H_
@@ -0,0 +1,231 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "converter/dense_connector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+#include "converter/connector_interface.h"
+#include "converter/sparse_connector.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace converter {
+namespace {
+
+const int kNumIds = 100;
+
+class TestConnector : public ConnectorInterface {
+ public:
+  TestConnector() {}
+  ~TestConnector() {}
+
+  int GetTransitionCost(uint16 rid, uint16 lid) const {
+    if ((rid + lid) % 7 == 0) {
+      return kInvalidCost;
+    }
+    return rid * 3 + lid * 5;
+  }
+
+  int GetResolution() const {
+    return 2;
+  }
+};
+
+void AppendUint16(uint16 value, string *output) {
+  output->push_back(static_cast<char>(value & 0xff));
+  output->push_back(static_cast<char>(value >> 8));
+}
+
+// Appends |bits| as the bit vector of SimpleSuccinctBitVectorIndex, padded to
+// 32 bits.
+void AppendBits(vector<bool> bits, string *output) {
+  while (bits.size() % 32 != 0) {
+    bits.push_back(false);
+  }
+  for (size_t i = 0; i < bits.size(); i += 8) {
+    uint8 byte = 0;
+    for (size_t j = 0; j < 8; ++j) {
+      if (bits[i + j]) {
+        byte |= 1 << j;
+      }
+    }
+    output->push_back(static_cast<char>(byte));
+  }
+}
+
+// Builds the SparseConnector image with 1-byte costs in the same way as
+// gen_connection_data.py.  The costs equal to |default_costs[rid]| are
+// omitted from the rows.
+void BuildOneByteCostImage(const vector<vector<int> > &matrix,
+                           const vector<uint16> &default_costs,
+                           int resolution, string *image) {
+  const uint16 num_ids = matrix.size();
+  image->clear();
+  AppendUint16(SparseConnector::kSparseConnectorMagic, image);
+  AppendUint16(resolution, image);
+  AppendUint16(num_ids, image);
+  AppendUint16(num_ids, image);
+  for (size_t i = 0; i < default_costs.size(); ++i) {
+    AppendUint16(default_costs[i], image);
+  }
+  if (default_costs.size() % 2 != 0) {
+    AppendUint16(0, image);
+  }
+
+  for (uint16 rid = 0; rid < num_ids; ++rid) {
+    vector<bool> chunk_bits, compact_bits;
+    string values;
+    for (uint16 chunk = 0; chunk < num_ids; chunk += 8) {
+      vector<bool> bits;
+      for (uint16 lid = chunk; lid < chunk + 8; ++lid) {
+        const bool has_value =
+            (lid < num_ids && matrix[rid][lid] != default_costs[rid]);
+        bits.push_back(has_value);
+        if (!has_value) {
+          continue;
+        }
+        if (matrix[rid][lid] == ConnectorInterface::kInvalidCost) {
+          values.push_back(static_cast<char>(
+              SparseConnector::kInvalid1ByteCostValue));
+        } else {
+          values.push_back(static_cast<char>(matrix[rid][lid] / resolution));
+        }
+      }
+      const bool has_chunk = (find(bits.begin(), bits.end(), true) !=
+                              bits.end());
+      chunk_bits.push_back(has_chunk);
+      if (has_chunk) {
+        compact_bits.insert(compact_bits.end(), bits.begin(), bits.end());
+      }
+    }
+    while (values.size() % 4 != 0) {
+      values.push_back('\0');
+    }
+    AppendUint16((compact_bits.size() + 31) / 32 * 4, image);
+    AppendUint16(values.size(), image);
+    AppendBits(chunk_bits, image);
+    AppendBits(compact_bits, image);
+    image->append(values);
+  }
+}
+
+TEST(DenseConnectorTest, GetTransitionCost) {
+  TestConnector test;
+  DenseConnector dense(test, kNumIds);
+  EXPECT_EQ(kNumIds, dense.num_ids());
+  EXPECT_EQ(test.GetResolution(), dense.GetResolution());
+  for (int rid = 0; rid < kNumIds; ++rid) {
+    for (int lid = 0; lid < kNumIds; ++lid) {
+      EXPECT_EQ(test.GetTransitionCost(rid, lid),
+                dense.GetTransitionCost(rid, lid)) << rid << " " << lid;
+    }
+  }
+}
+
+TEST(DenseConnectorTest, GetTransitionCosts) {
+  TestConnector test;
+  DenseConnector dense(test, kNumIds);
+
+  // Rids in arbitrary order with duplicates, as end nodes in a lattice.
+  vector<uint16> rids;
+  for (int i = 0; i < 3 * kNumIds; ++i) {
+    rids.push_back((i * 37) % kNumIds);
+  }
+
+  vector<int> expected(rids.size());
+  vector<int> actual(rids.size());
+  for (int lid = 0; lid < kNumIds; ++lid) {
+    // The default implementation in ConnectorInterface.
+    test.GetTransitionCosts(&rids[0], rids.size(), lid, &expected[0]);
+    dense.GetTransitionCosts(&rids[0], rids.size(), lid, &actual[0]);
+    for (size_t i = 0; i < rids.size(); ++i) {
+      EXPECT_EQ(test.GetTransitionCost(rids[i], lid), expected[i]);
+      EXPECT_EQ(expected[i], actual[i]) << rids[i] << " " << lid;
+    }
+  }
+
+  // Empty input is allowed.
+  dense.GetTransitionCosts(NULL, 0, 0, NULL);
+}
+
+TEST(DenseConnectorTest, SparseConnectorWithOneByteCosts) {
+  const int kResolution = 64;
+  vector<vector<int> > matrix(kNumIds, vector<int>(kNumIds));
+  vector<uint16> default_costs(kNumIds);
+  for (int rid = 0; rid < kNumIds; ++rid) {
+    default_costs[rid] = rid * 101 + 7;
+    for (int lid = 0; lid < kNumIds; ++lid) {
+      if ((rid + lid) % 7 == 0) {
+        matrix[rid][lid] = ConnectorInterface::kInvalidCost;
+      } else if ((rid * lid) % 3 == 0) {
+        matrix[rid][lid] = default_costs[rid];
+      } else {
+        matrix[rid][lid] = ((rid * 13 + lid * 17) % 255) * kResolution;
+      }
+    }
+  }
+  string image;
+  BuildOneByteCostImage(matrix, default_costs, kResolution, &image);
+  // SparseConnector reads the image as an array of uint16 and uint32.
+  vector<uint32> buffer(image.size() / sizeof(uint32) + 1);
+  memcpy(&buffer[0], image.data(), image.size());
+  const SparseConnector sparse(reinterpret_cast<const char *>(&buffer[0]),
+                               image.size());
+  ASSERT_EQ(kResolution, sparse.GetResolution());
+  ASSERT_EQ(kNumIds, sparse.num_ids());
+  // The invalid cost is scaled by the resolution, which exceeds 16 bits.
+  EXPECT_EQ(ConnectorInterface::kInvalidCost * kResolution,
+            sparse.GetTransitionCost(0, 0));
+
+  const DenseConnector dense(sparse, kNumIds);
+  EXPECT_EQ(kResolution, dense.GetResolution());
+  vector<uint16> rids(kNumIds);
+  for (int rid = 0; rid < kNumIds; ++rid) {
+    rids[rid] = rid;
+  }
+  vector<int> costs(kNumIds);
+  for (int lid = 0; lid < kNumIds; ++lid) {
+    dense.GetTransitionCosts(&rids[0], rids.size(), lid, &costs[0]);
+    for (int rid = 0; rid < kNumIds; ++rid) {
+      EXPECT_EQ(sparse.GetTransitionCost(rid, lid),
+                dense.GetTransitionCost(rid, lid)) << rid << " " << lid;
+      EXPECT_EQ(sparse.GetTransitionCost(rid, lid), costs[rid])
+          << rid << " " << lid;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace converter
+}  // namespace mozc
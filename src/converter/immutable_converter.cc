@@ -41,9 +41,9 @@
 #include "base/scoped_ptr.h"
 #include "base/stl_util.h"
 #include "base/string_piece.h"
+#include "base/trace.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/connector_interface.h"
 #include "converter/conversion_request.h"
 #include "converter/key_corrector.h"
@@ -53,6 +53,7 @@
 #include "converter/node_list_builder.h"
 #include "converter/segmenter_interface.h"
 #include "converter/segments.h"
+#include "converter/viterbi_table.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/pos_group.h"
 #include "dictionary/pos_matcher.h"
@@ -135,7 +136,7 @@ void InsertCorrectedNodes(size_t pos, const string &key,
                                       lattice->node_allocator());
   dictionary->LookupPrefix(
       StringPiece(str, length),
-      request.IsKanaModifierInsensitiveConversion(),
+      request,
       &builder);
   if (builder.tail() != NULL) {
     builder.tail()->bnext = NULL;
@@ -310,6 +311,7 @@ ImmutableConverterImpl::ImmutableConverterImpl(
 void ImmutableConverterImpl::ExpandCandidates(
     const string &original_key, NBestGenerator *nbest, Segment *segment,
     Segments::RequestType request_type, size_t expand_size) const {
+  MOZC_TRACE_SCOPE(Trace::NBEST_GENERATOR);
   DCHECK(nbest);
   DCHECK(segment);
   CHECK_GT(expand_size, 0);
@@ -778,7 +780,7 @@ Node *ImmutableConverterImpl::Lookup(const int begin_pos,
         lattice->node_allocator(),
         lattice->node_allocator()->max_nodes_size());
     dictionary_->LookupReverse(
-        StringPiece(begin, len), lattice->node_allocator(), &builder);
+        StringPiece(begin, len), lattice->node_allocator(), request, &builder);
     result_node = builder.result();
   } else {
     if (is_prediction && !FLAGS_disable_lattice_cache) {
@@ -787,7 +789,7 @@ Node *ImmutableConverterImpl::Lookup(const int begin_pos,
           lattice->cache_info(begin_pos) + 1);
       dictionary_->LookupPrefix(
           StringPiece(begin, len),
-          request.IsKanaModifierInsensitiveConversion(),
+          request,
           &builder);
       result_node = builder.result();
       lattice->SetCacheInfo(begin_pos, len);
@@ -798,7 +800,7 @@ Node *ImmutableConverterImpl::Lookup(const int begin_pos,
           lattice->node_allocator()->max_nodes_size());
       dictionary_->LookupPrefix(
           StringPiece(begin, len),
-          request.IsKanaModifierInsensitiveConversion(),
+          request,
           &builder);
       result_node = builder.result();
     }
@@ -890,9 +892,11 @@ const int kVeryBigCost = (INT_MAX >> 2);
 // are the next boundary looked from pos. (If pos is on the boundary,
 // left_boundary should be the previous one, and right_boundary should be
 // the next).
+// The end nodes at |pos| are read from |table|, and each valid begin node at
+// |pos| is added to |table| after its cost is settled.
 inline void ViterbiInternal(
     const ConnectorInterface &connector, size_t pos, size_t right_boundary,
-    Lattice *lattice) {
+    Lattice *lattice, ViterbiTable *table) {
   for (Node *rnode = lattice->begin_nodes(pos);
        rnode != NULL; rnode = rnode->bnext) {
     if (rnode->end_pos > right_boundary) {
@@ -911,44 +915,44 @@ inline void ViterbiInternal(
             rnode->prev->cost +
             rnode->wcost +
             connector.GetTransitionCost(rnode->prev->rid, rnode->lid);
+        table->Add(rnode);
       }
       continue;
     }
 
     // Find a valid node which connects to the rnode with minimum cost.
     int best_cost = kVeryBigCost;
-    Node *best_node = NULL;
-    for (Node *lnode = lattice->end_nodes(pos);
-         lnode != NULL; lnode = lnode->enext) {
-      if (lnode->prev == NULL) {
-        // Invalid lnode.
-        continue;
-      }
-
-      int cost =
-          lnode->cost + connector.GetTransitionCost(lnode->rid, rnode->lid);
-      if (cost < best_cost) {
-        best_cost = cost;
-        best_node = lnode;
-      }
-    }
+    Node *best_node =
+        table->FindBestPrev(connector, pos, rnode->lid, &best_cost);
 
     rnode->prev = best_node;
     rnode->cost = best_cost + rnode->wcost;
+    if (best_node != NULL) {
+      table->Add(rnode);
+    }
   }
 }
 }  // namespace
 
 bool ImmutableConverterImpl::Viterbi(
     const Segments &segments, Lattice *lattice) const {
+  MOZC_TRACE_SCOPE(Trace::IMMUTABLE_CONVERTER_VITERBI);
   const string &key = lattice->key();
 
+  // The costs computed below depend on the segment boundaries, so they are
+  // not reusable by PredictionViterbi().
+  lattice->set_viterbi_cache_pos(0);
+
+  ViterbiTable *table = lattice->viterbi_table();
+  table->Init(*lattice);
+
   // Process BOS.
   {
     Node *bos_node = lattice->bos_nodes();
     // Ensure only one bos node is available.
     DCHECK(bos_node != NULL);
     DCHECK(bos_node->enext == NULL);
+    table->Add(bos_node);
 
     const size_t right_boundary = segments.segment(0).key().size();
     for (Node *rnode = lattice->begin_nodes(0);
@@ -966,6 +970,7 @@ bool ImmutableConverterImpl::Viterbi(
           bos_node->cost +
           connector_->GetTransitionCost(bos_node->rid, rnode->lid) +
           rnode->wcost;
+      table->Add(rnode);
     }
   }
 
@@ -979,7 +984,7 @@ bool ImmutableConverterImpl::Viterbi(
     const size_t right_boundary =
         left_boundary + segments.segment(0).key().size();
     for (size_t pos = left_boundary + 1; pos < right_boundary; ++pos) {
-      ViterbiInternal(*connector_, pos, right_boundary, lattice);
+      ViterbiInternal(*connector_, pos, right_boundary, lattice, table);
     }
     left_boundary = right_boundary;
   }
@@ -990,7 +995,7 @@ bool ImmutableConverterImpl::Viterbi(
     const size_t right_boundary =
         left_boundary + segments.segment(i).key().size();
     for (size_t pos = left_boundary; pos < right_boundary; ++pos) {
-      ViterbiInternal(*connector_, pos, right_boundary, lattice);
+      ViterbiInternal(*connector_, pos, right_boundary, lattice, table);
     }
     left_boundary = right_boundary;
   }
@@ -1010,22 +1015,8 @@ bool ImmutableConverterImpl::Viterbi(
         key.size() - segments.segment(segments_size - 1).key().size();
     // Find a valid node which connects to the rnode with minimum cost.
     int best_cost = kVeryBigCost;
-    Node *best_node = NULL;
-    for (Node *lnode = lattice->end_nodes(key.size());
-         lnode != NULL; lnode = lnode->enext) {
-      if (lnode->prev == NULL) {
-        // Invalid lnode.
-        continue;
-      }
-
-      int cost =
-          lnode->cost +
-          connector_->GetTransitionCost(lnode->rid, eos_node->lid);
-      if (cost < best_cost) {
-        best_cost = cost;
-        best_node = lnode;
-      }
-    }
+    Node *best_node = table->FindBestPrev(
+        *connector_, key.size(), eos_node->lid, &best_cost);
 
     eos_node->prev = best_node;
     eos_node->cost = best_cost + eos_node->wcost;
@@ -1078,8 +1069,14 @@ bool ImmutableConverterImpl::PredictionViterbi(
   for (size_t i = 0; i < history_segments_size; ++i) {
     history_length += segments.segment(i).key().size();
   }
-  PredictionViterbiInternal(0, history_length, lattice);
-  PredictionViterbiInternal(history_length, key_length, lattice);
+  // When the key is extended by typing, the lattice keeps the nodes for the
+  // common prefix and their costs from the last run.  Only the nodes touched
+  // by the new suffix are relaxed.  The history part is small and its nodes
+  // are recreated for every call, so it is always recomputed.
+  const size_t cache_pos = lattice->viterbi_cache_pos();
+  lattice->set_viterbi_cache_pos(0);
+  PredictionViterbiInternal(0, history_length, 0, lattice);
+  PredictionViterbiInternal(history_length, key_length, cache_pos, lattice);
 
   Node *node = lattice->eos_nodes();
   CHECK(node->bnext == NULL);
@@ -1095,11 +1092,15 @@ bool ImmutableConverterImpl::PredictionViterbi(
     return false;
   }
 
+  // The nodes ending at the end of the key have the suffix penalty, which
+  // is removed when the key is extended, so they are not reusable.
+  lattice->set_viterbi_cache_pos(key_length);
   return true;
 }
 
 void ImmutableConverterImpl::PredictionViterbiInternal(
-    int calc_begin_pos, int calc_end_pos, Lattice *lattice) const {
+    int calc_begin_pos, int calc_end_pos, size_t cache_pos,
+    Lattice *lattice) const {
   CHECK_LE(calc_begin_pos, calc_end_pos);
 
   // Mapping from lnode's rid to (cost, Node) of best way/cost, and vice versa.
@@ -1115,6 +1116,30 @@ void ImmutableConverterImpl::PredictionViterbiInternal(
   const pair<int, Node*> kInvalidValue(INT_MAX, static_cast<Node*>(NULL));
 
   for (size_t pos = calc_begin_pos; pos <= calc_end_pos; ++pos) {
+    // The nodes starting at |calc_begin_pos| are always recomputed.  If the
+    // cost of such a node has changed, e.g., because the history has changed,
+    // the cached costs after it are no longer valid.
+    const bool is_begin_pos = (pos == calc_begin_pos);
+
+    rbest.clear();
+    Node *rnode_begin = lattice->begin_nodes(pos);
+    for (Node *rnode = rnode_begin; rnode != NULL; rnode = rnode->bnext) {
+      if (rnode->end_pos > calc_end_pos ||
+          (!is_begin_pos && rnode->end_pos < cache_pos)) {
+        continue;
+      }
+      BestMap::value_type key(rnode->lid, kInvalidValue);
+      BestMap::iterator iter =
+          lower_bound(rbest.begin(), rbest.end(), key, OrderByFirst());
+      if (iter == rbest.end() || iter->first != rnode->lid) {
+        rbest.insert(iter, key);
+      }
+    }
+
+    if (rbest.empty()) {
+      continue;
+    }
+
     lbest.clear();
     for (Node *lnode = lattice->end_nodes(pos);
          lnode != NULL; lnode = lnode->enext) {
@@ -1135,24 +1160,6 @@ void ImmutableConverterImpl::PredictionViterbiInternal(
       continue;
     }
 
-    rbest.clear();
-    Node *rnode_begin = lattice->begin_nodes(pos);
-    for (Node *rnode = rnode_begin; rnode != NULL; rnode = rnode->bnext) {
-      if (rnode->end_pos > calc_end_pos) {
-        continue;
-      }
-      BestMap::value_type key(rnode->lid, kInvalidValue);
-      BestMap::iterator iter =
-          lower_bound(rbest.begin(), rbest.end(), key, OrderByFirst());
-      if (iter == rbest.end() || iter->first != rnode->lid) {
-        rbest.insert(iter, key);
-      }
-    }
-
-    if (rbest.empty()) {
-      continue;
-    }
-
     for (BestMap::iterator liter = lbest.begin();
          liter != lbest.end(); ++liter) {
       for (BestMap::iterator riter = rbest.begin();
@@ -1167,7 +1174,8 @@ void ImmutableConverterImpl::PredictionViterbiInternal(
     }
 
     for (Node *rnode = rnode_begin; rnode != NULL; rnode = rnode->bnext) {
-      if (rnode->end_pos > calc_end_pos) {
+      if (rnode->end_pos > calc_end_pos ||
+          (!is_begin_pos && rnode->end_pos < cache_pos)) {
         continue;
       }
       BestMap::value_type key(rnode->lid, kInvalidValue);
@@ -1178,7 +1186,11 @@ void ImmutableConverterImpl::PredictionViterbiInternal(
         continue;
       }
 
-      rnode->cost = iter->second.first + rnode->wcost;
+      const int cost = iter->second.first + rnode->wcost;
+      if (is_begin_pos && rnode->end_pos < cache_pos && rnode->cost != cost) {
+        cache_pos = 0;
+      }
+      rnode->cost = cost;
       rnode->prev = iter->second.second;
     }
   }
@@ -1270,7 +1282,7 @@ void ImmutableConverterImpl::MakeLatticeNodesForPredictiveNodes(
           pos_matcher_);
       suffix_dictionary_->LookupPredictive(
           StringPiece(key.data() + pos, key.size() - pos),
-          request.IsKanaModifierInsensitiveConversion(), &builder);
+          request, &builder);
       if (builder.result() != NULL) {
         lattice->Insert(pos, builder.result());
       }
@@ -1301,7 +1313,7 @@ void ImmutableConverterImpl::MakeLatticeNodesForPredictiveNodes(
           pos_matcher_);
       dictionary_->LookupPredictive(
           StringPiece(key.data() + pos, key.size() - pos),
-          request.IsKanaModifierInsensitiveConversion(), &builder);
+          request, &builder);
       if (builder.result() != NULL) {
         lattice->Insert(pos, builder.result());
       }
@@ -1312,6 +1324,7 @@ void ImmutableConverterImpl::MakeLatticeNodesForPredictiveNodes(
 bool ImmutableConverterImpl::MakeLattice(
     const ConversionRequest &request,
     Segments *segments, Lattice *lattice) const {
+  MOZC_TRACE_SCOPE(Trace::IMMUTABLE_CONVERTER_MAKE_LATTICE);
   if (segments == NULL) {
     LOG(ERROR) << "Segments is NULL";
     return false;
@@ -1588,7 +1601,7 @@ void ImmutableConverterImpl::MakeLatticeNodesForConversionSegments(
   scoped_ptr<KeyCorrector> key_corrector;
   if (is_conversion && !segments.resized()) {
     KeyCorrector::InputMode mode = KeyCorrector::ROMAN;
-    if (GET_CONFIG(preedit_method) != config::Config::ROMAN) {
+    if (request.config().preedit_method() != config::Config::ROMAN) {
       mode = KeyCorrector::KANA;
     }
     key_corrector.reset(new KeyCorrector(key, mode, history_key.size()));
@@ -1678,13 +1691,14 @@ void ImmutableConverterImpl::Resegment(
 
 // Single segment conversion results should be set to |segments|.
 void ImmutableConverterImpl::InsertFirstSegmentToCandidates(
+    const ConversionRequest &request,
     Segments *segments,
     const Lattice &lattice,
     const vector<uint16> &group,
     size_t max_candidates_size) const {
   const size_t only_first_segment_candidate_pos =
       segments->conversion_segment(0).candidates_size();
-  InsertCandidates(segments, lattice, group,
+  InsertCandidates(request, segments, lattice, group,
                    max_candidates_size,
                    ONLY_FIRST_SEGMENT);
   // Note that inserted candidates might consume the entire key.
@@ -1807,6 +1821,7 @@ Segment *ImmutableConverterImpl::GetInsertTargetSegment(
 }
 
 void ImmutableConverterImpl::InsertCandidates(
+    const ConversionRequest &request,
     Segments *segments,
     const Lattice &lattice,
     const vector<uint16> &group,
@@ -1828,6 +1843,8 @@ void ImmutableConverterImpl::InsertCandidates(
   NBestGenerator nbest_generator(
       suppression_dictionary_, segmenter_, connector_, pos_matcher_,
       &lattice, suggestion_filter_);
+  nbest_generator.set_beam_width(request.nbest_beam_width());
+  nbest_generator.set_cost_threshold(request.nbest_cost_threshold());
 
   string original_key;
   for (size_t i = 0; i < segments->conversion_segments_size(); ++i) {
@@ -1903,7 +1920,7 @@ bool ImmutableConverterImpl::MakeSegments(const ConversionRequest &request,
       const size_t single_segment_candidates_size =
           ((max_candidates_size > kOnlyFirstSegmentCandidateSize) ?
            max_candidates_size - kOnlyFirstSegmentCandidateSize : 1);
-      InsertCandidates(segments, lattice, group,
+      InsertCandidates(request, segments, lattice, group,
                        single_segment_candidates_size, SINGLE_SEGMENT);
 
       // Even if single_segment_candidates_size + kOnlyFirstSegmentCandidateSize
@@ -1920,10 +1937,11 @@ bool ImmutableConverterImpl::MakeSegments(const ConversionRequest &request,
           min(max_candidates_size,
               single_segment_candidates_size + kOnlyFirstSegmentCandidateSize);
       InsertFirstSegmentToCandidates(
-          segments, lattice, group, only_first_segment_candidates_size);
+          request, segments, lattice, group,
+          only_first_segment_candidates_size);
     } else {
-      InsertCandidates(
-          segments, lattice, group, max_candidates_size, SINGLE_SEGMENT);
+      InsertCandidates(request, segments, lattice, group, max_candidates_size,
+                       SINGLE_SEGMENT);
     }
   } else {
     DCHECK(!request.create_partial_candidates());
@@ -1941,8 +1959,8 @@ bool ImmutableConverterImpl::MakeSegments(const ConversionRequest &request,
     // TODO(toshiyuki): We want more beautiful structure.
     const size_t old_conversion_segments_size =
         segments->conversion_segments_size();
-    InsertCandidates(
-        segments, lattice, group, max_candidates_size, MULTI_SEGMENTS);
+    InsertCandidates(request, segments, lattice, group, max_candidates_size,
+                     MULTI_SEGMENTS);
     if (old_conversion_segments_size > 0) {
       segments->erase_segments(segments->history_segments_size(),
                                old_conversion_segments_size);
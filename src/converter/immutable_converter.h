@@ -78,6 +78,7 @@ class ImmutableConverterImpl : public ImmutableConverterInterface {
   friend class NBestGeneratorTest;
   FRIEND_TEST(NBestGeneratorTest, MultiSegmentConnectionTest);
   FRIEND_TEST(NBestGeneratorTest, SingleSegmentConnectionTest);
+  FRIEND_TEST(NBestGeneratorTest, PruningTest);
 
   enum InsertCandidatesType {
     MULTI_SEGMENTS,  // Normal conversion ("私の|名前は|中野です")
@@ -129,19 +130,25 @@ class ImmutableConverterImpl : public ImmutableConverterInterface {
   bool Viterbi(const Segments &segments, Lattice *lattice) const;
 
   bool PredictionViterbi(const Segments &segments, Lattice *lattice) const;
+  // Runs Viterbi for the nodes from |calc_begin_pos| to |calc_end_pos|.
+  // Nodes ending before |cache_pos| are skipped as they keep the costs from
+  // the last run, except for those starting at |calc_begin_pos|.
   void PredictionViterbiInternal(
-      int calc_begin_pos, int calc_end_pos, Lattice *lattice) const;
+      int calc_begin_pos, int calc_end_pos, size_t cache_pos,
+      Lattice *lattice) const;
 
   // TODO(toshiyuki): Change parameter order for mutable |segments|.
 
   // Inserts first segment from conversion result to candidates.
   // Costs will be modified using the existing candidates.
-  void InsertFirstSegmentToCandidates(Segments *segments,
+  void InsertFirstSegmentToCandidates(const ConversionRequest &request,
+                                      Segments *segments,
                                       const Lattice &lattice,
                                       const vector<uint16> &group,
                                       size_t max_candidates_size) const;
 
-  void InsertCandidates(Segments *segments,
+  void InsertCandidates(const ConversionRequest &request,
+                        Segments *segments,
                         const Lattice &lattice,
                         const vector<uint16> &group,
                         size_t max_candidates_size,
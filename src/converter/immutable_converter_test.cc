@@ -63,6 +63,7 @@
 #include "testing/base/public/gunit.h"
 
 DECLARE_string(test_tmpdir);
+DECLARE_bool(disable_lattice_cache);
 
 namespace mozc {
 
@@ -181,14 +182,17 @@ class ImmutableConverterTest : public ::testing::Test {
     SystemUtil::SetUserProfileDirectory(FLAGS_test_tmpdir);
     config::ConfigHandler::GetDefaultConfig(&default_config_);
     config::ConfigHandler::SetConfig(default_config_);
+    original_disable_lattice_cache_ = FLAGS_disable_lattice_cache;
   }
 
   virtual void TearDown() {
     config::ConfigHandler::SetConfig(default_config_);
+    FLAGS_disable_lattice_cache = original_disable_lattice_cache_;
   }
 
  private:
   config::Config default_config_;
+  bool original_disable_lattice_cache_;
 };
 
 TEST_F(ImmutableConverterTest, KeepKeyForPrediction) {
@@ -250,7 +254,7 @@ class KeyCheckDictionary : public DictionaryInterface {
   virtual bool HasValue(StringPiece value) const { return false; }
 
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_looukp,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const {
     if (key == target_query_) {
       received_target_query_ = true;
@@ -259,16 +263,19 @@ class KeyCheckDictionary : public DictionaryInterface {
 
   virtual void LookupPrefix(
       StringPiece key,
-      bool use_kana_modifier_insensitive_looukp,
+      const ConversionRequest &conversion_request,
       Callback *callback) const {
     // No check
   }
 
-  virtual void LookupExact(StringPiece key, Callback *callback) const {
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const {
     // No check
   }
 
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const {
     // No check
   }
@@ -599,4 +606,93 @@ TEST_F(ImmutableConverterTest, AutoPartialSuggestionForSingleSegment) {
   }
 }
 
+namespace {
+// Replaces the segments with the history segment of |history_key| (if not
+// empty) and a conversion segment of |key|. The cached lattice is kept.
+void ResetSegmentsForPrediction(Segments::RequestType request_type,
+                                const string &history_key,
+                                const string &key,
+                                Segments *segments) {
+  segments->clear_segments();
+  segments->set_request_type(request_type);
+  segments->set_max_prediction_candidates_size(10);
+  if (!history_key.empty()) {
+    SetCandidate(history_key, history_key, segments->add_segment());
+    segments->mutable_segment(0)->set_segment_type(Segment::HISTORY);
+  }
+  segments->add_segment()->set_key(key);
+}
+}  // namespace
+
+TEST_F(ImmutableConverterTest, IncrementalPredictionWithLatticeCache) {
+  scoped_ptr<MockDataAndImmutableConverter> data_and_converter(
+      new MockDataAndImmutableConverter);
+  ImmutableConverterImpl *converter = data_and_converter->GetConverter();
+
+  // The results with the lattice cache must be the same as those converted
+  // from scratch, while the cached lattice is updated by UpdateKey() and
+  // ResetNodeCost() for each key.
+  // "わたしのなまえはなかのです" typed one character at a time. Then the
+  // last three characters are deleted, which only shrinks the key of the
+  // lattice, and "わたしは" replaces the suffix after "わたし".
+  const string kKey =
+      "\xe3\x82\x8f\xe3\x81\x9f\xe3\x81\x97\xe3\x81\xae\xe3\x81\xaa\xe3"
+      "\x81\xbe\xe3\x81\x88\xe3\x81\xaf\xe3\x81\xaa\xe3\x81\x8b\xe3\x81"
+      "\xae\xe3\x81\xa7\xe3\x81\x99";
+  const size_t key_len = Util::CharsLen(kKey);
+  vector<string> keys;
+  for (size_t i = 1; i <= key_len; ++i) {
+    keys.push_back(Util::SubString(kKey, 0, i));
+  }
+  keys.push_back(Util::SubString(kKey, 0, key_len - 3));
+  // "わたしは"
+  keys.push_back("\xe3\x82\x8f\xe3\x81\x9f\xe3\x81\x97\xe3\x81\xaf");
+
+  // "おはよう", whose nodes are NOT_CONNECTED to the nodes of the key.
+  const string kHistoryKey =
+      "\xe3\x81\x8a\xe3\x81\xaf\xe3\x82\x88\xe3\x81\x86";
+  const string kHistoryKeys[] = { "", kHistoryKey };
+  const Segments::RequestType kRequestTypes[] = {
+    Segments::PREDICTION,
+    Segments::SUGGESTION,
+  };
+
+  for (size_t i = 0; i < arraysize(kRequestTypes); ++i) {
+    for (size_t j = 0; j < arraysize(kHistoryKeys); ++j) {
+      // Keeps the lattice across the keys.
+      Segments cached_segments;
+      for (size_t k = 0; k < keys.size(); ++k) {
+        SCOPED_TRACE(Util::StringPrintf("request_type: %d, history: %s, "
+                                        "key: %s", kRequestTypes[i],
+                                        kHistoryKeys[j].c_str(),
+                                        keys[k].c_str()));
+        FLAGS_disable_lattice_cache = false;
+        ResetSegmentsForPrediction(kRequestTypes[i], kHistoryKeys[j], keys[k],
+                                   &cached_segments);
+        ASSERT_TRUE(converter->Convert(&cached_segments));
+
+        FLAGS_disable_lattice_cache = true;
+        Segments segments;
+        ResetSegmentsForPrediction(kRequestTypes[i], kHistoryKeys[j], keys[k],
+                                   &segments);
+        ASSERT_TRUE(converter->Convert(&segments));
+
+        ASSERT_EQ(1, cached_segments.conversion_segments_size());
+        ASSERT_EQ(1, segments.conversion_segments_size());
+        const Segment &actual = cached_segments.conversion_segment(0);
+        const Segment &expected = segments.conversion_segment(0);
+        ASSERT_LT(0, expected.candidates_size());
+        ASSERT_EQ(expected.candidates_size(), actual.candidates_size());
+        EXPECT_EQ(expected.candidate(0).value, actual.candidate(0).value);
+        for (size_t l = 0; l < expected.candidates_size(); ++l) {
+          EXPECT_EQ(expected.candidate(l).cost, actual.candidate(l).cost)
+              << expected.candidate(l).value;
+          EXPECT_EQ(expected.candidate(l).wcost, actual.candidate(l).wcost)
+              << expected.candidate(l).value;
+        }
+      }
+    }
+  }
+}
+
 }  // namespace mozc
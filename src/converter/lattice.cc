@@ -39,6 +39,7 @@
 #include "base/util.h"
 #include "converter/node.h"
 #include "converter/node_allocator.h"
+#include "converter/viterbi_table.h"
 
 DEFINE_bool(disable_lattice_cache,
             false,
@@ -145,7 +146,11 @@ struct LatticeDisplayNodeInfo {
   string display_node_str_;
 };
 
-Lattice::Lattice() : history_end_pos_(0), node_allocator_(new NodeAllocator) {}
+Lattice::Lattice()
+    : history_end_pos_(0),
+      node_allocator_(new NodeAllocator),
+      viterbi_table_(new ViterbiTable),
+      viterbi_cache_pos_(0) {}
 
 Lattice::~Lattice() {}
 
@@ -203,6 +208,10 @@ void Lattice::Insert(size_t pos, Node *node) {
     rnode->cost = 0;
     rnode->enext = end_nodes_[end_pos];
     end_nodes_[end_pos] = rnode;
+    // The new node changes the best path to the nodes starting at end_pos.
+    if (rnode->node_type != Node::HIS_NODE) {
+      viterbi_cache_pos_ = min(viterbi_cache_pos_, end_pos);
+    }
   }
 
   if (begin_nodes_[pos] == NULL) {
@@ -233,6 +242,7 @@ void Lattice::Clear() {
   node_allocator_->Free();
   cache_info_.clear();
   history_end_pos_ = 0;
+  viterbi_cache_pos_ = 0;
 }
 
 void Lattice::SetDebugDisplayNode(size_t begin_pos, size_t end_pos,
@@ -357,6 +367,8 @@ void Lattice::ShrinkKey(const size_t new_len) {
   }
   fill(cache_info_.begin() + new_len, cache_info_.end(), 0);
 
+  viterbi_cache_pos_ = min(viterbi_cache_pos_, new_len);
+
   // update key
   key_.erase(new_len);
 }
@@ -371,6 +383,18 @@ void Lattice::SetCacheInfo(const size_t pos, const size_t len) {
   cache_info_[pos] = len;
 }
 
+size_t Lattice::viterbi_cache_pos() const {
+  return viterbi_cache_pos_;
+}
+
+void Lattice::set_viterbi_cache_pos(size_t pos) {
+  viterbi_cache_pos_ = min(pos, key_.size());
+}
+
+ViterbiTable *Lattice::viterbi_table() {
+  return viterbi_table_.get();
+}
+
 void Lattice::ResetNodeCost() {
   for (size_t i = 0; i <= key_.size(); ++i) {
     if (begin_nodes_[i] != NULL) {
@@ -413,6 +437,9 @@ void Lattice::ResetNodeCost() {
         if (node->attributes & Node::ENABLE_CACHE) {
           node->wcost = node->raw_wcost;
         } else {
+          if (node->node_type != Node::HIS_NODE) {
+            viterbi_cache_pos_ = min(viterbi_cache_pos_, i);
+          }
           if (node == end_nodes_[i]) {
             if (node->enext == NULL) {
               end_nodes_[i] = NULL;
@@ -42,6 +42,7 @@ namespace mozc {
 struct Node;
 class NodeAllocator;
 class NodeAllocatorInterface;
+class ViterbiTable;
 
 class Lattice {
  public:
@@ -110,6 +111,19 @@ class Lattice {
   // process for some heuristic methods.
   void ResetNodeCost();
 
+  // Support for incremental Viterbi.  Nodes ending before this position
+  // still have the costs and the prev links computed by the last Viterbi,
+  // which set this position with set_viterbi_cache_pos().  Nodes ending at
+  // or after this position have to be recomputed.  The position is lowered
+  // automatically when the nodes it depends on are inserted or erased, except
+  // for history nodes, which the caller has to recompute anyway.
+  size_t viterbi_cache_pos() const;
+  void set_viterbi_cache_pos(size_t pos);
+
+  // Returns the table for the Viterbi forward pass. It is kept with the
+  // lattice so that its buffers are reused by the following conversions.
+  ViterbiTable *viterbi_table();
+
   // Dump the best path and the path that contains the designated string.
   string DebugString() const;
 
@@ -127,11 +141,14 @@ class Lattice {
   vector<Node *> begin_nodes_;
   vector<Node *> end_nodes_;
   scoped_ptr<NodeAllocator> node_allocator_;
+  scoped_ptr<ViterbiTable> viterbi_table_;
 
   // cache_info_ holds cache information about lookup.
   // If cache_info_[pos] equals to len, it means key.substr(pos, k)
   // (1 <= k <= len) is already looked up.
   vector<size_t> cache_info_;
+
+  size_t viterbi_cache_pos_;
 };
 
 }  // namespace mozc
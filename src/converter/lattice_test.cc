@@ -225,4 +225,52 @@ TEST(LatticeTest, ShrinkKeyTest) {
     }
   }
 }
+
+TEST(LatticeTest, ViterbiCachePosTest) {
+  Lattice lattice;
+  lattice.SetKey("test");
+  EXPECT_EQ(0, lattice.viterbi_cache_pos());
+
+  lattice.set_viterbi_cache_pos(10);
+  EXPECT_EQ(4, lattice.viterbi_cache_pos());
+
+  // Extending the key keeps the costs of the nodes for the prefix.
+  lattice.AddSuffix("s");
+  EXPECT_EQ(4, lattice.viterbi_cache_pos());
+
+  // A node ending in the middle of the key invalidates the costs after it.
+  {
+    Node *node = lattice.NewNode();
+    node->key = "es";
+    lattice.Insert(1, node);
+    EXPECT_EQ(3, lattice.viterbi_cache_pos());
+  }
+
+  // History nodes are always recomputed.
+  {
+    Node *node = lattice.NewNode();
+    node->key = "t";
+    node->node_type = Node::HIS_NODE;
+    lattice.Insert(0, node);
+    EXPECT_EQ(3, lattice.viterbi_cache_pos());
+  }
+
+  lattice.ShrinkKey(2);
+  EXPECT_EQ(2, lattice.viterbi_cache_pos());
+
+  lattice.set_viterbi_cache_pos(2);
+  {
+    // Nodes without ENABLE_CACHE are removed by ResetNodeCost().
+    Node *node = lattice.NewNode();
+    node->key = "t";
+    lattice.Insert(0, node);
+    EXPECT_EQ(1, lattice.viterbi_cache_pos());
+  }
+  lattice.set_viterbi_cache_pos(2);
+  lattice.ResetNodeCost();
+  EXPECT_EQ(1, lattice.viterbi_cache_pos());
+
+  lattice.Clear();
+  EXPECT_EQ(0, lattice.viterbi_cache_pos());
+}
 }  // namespace mozc
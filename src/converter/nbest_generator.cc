@@ -73,6 +73,7 @@ const NBestGenerator::QueueElement *NBestGenerator::CreateNewElement(
     int32 w_gx) {
   QueueElement *elm = freelist_.Alloc();
   DCHECK(elm);
+  ++num_created_elements_;
   elm->node = node;
   elm->next = next;
   elm->fx = fx;
@@ -103,6 +104,21 @@ inline void NBestGenerator::Agenda::Pop() {
   priority_queue_.pop_back();
 }
 
+void NBestGenerator::Agenda::Prune(size_t size) {
+  if (priority_queue_.size() <= size) {
+    return;
+  }
+  // The comparator orders the elements in descending order of f(x), so the
+  // best |size| elements are moved to the tail.
+  const vector<const QueueElement *>::iterator kept_begin =
+      priority_queue_.end() - size;
+  nth_element(priority_queue_.begin(), kept_begin, priority_queue_.end(),
+              QueueElementComparator());
+  priority_queue_.erase(priority_queue_.begin(), kept_begin);
+  make_heap(priority_queue_.begin(), priority_queue_.end(),
+            QueueElementComparator());
+}
+
 NBestGenerator::NBestGenerator(const SuppressionDictionary *suppression_dic,
                                const SegmenterInterface *segmenter,
                                const ConnectorInterface *connector,
@@ -118,7 +134,11 @@ NBestGenerator::NBestGenerator(const SuppressionDictionary *suppression_dic,
           suppression_dic, pos_matcher, suggestion_filter)),
       viterbi_result_checked_(false),
       check_mode_(STRICT),
-      boundary_checker_(NULL) {
+      boundary_checker_(NULL),
+      beam_width_(0),
+      cost_threshold_(0),
+      best_fx_(kint32max),
+      num_created_elements_(0) {
   DCHECK(suppression_dictionary_);
   DCHECK(segmenter);
   DCHECK(connector);
@@ -133,13 +153,25 @@ NBestGenerator::NBestGenerator(const SuppressionDictionary *suppression_dic,
 NBestGenerator::~NBestGenerator() {
 }
 
+void NBestGenerator::set_beam_width(size_t beam_width) {
+  beam_width_ = beam_width;
+}
+
+void NBestGenerator::set_cost_threshold(int32 cost_threshold) {
+  cost_threshold_ = cost_threshold;
+}
+
 void NBestGenerator::Reset(const Node *begin_node, const Node *end_node,
                            const BoundaryCheckMode mode) {
   agenda_.Clear();
-  freelist_.Free();
+  // Keeps the allocated elements for the next segment, as the generator is
+  // reset for each segment of a conversion.
+  freelist_.Reset();
   filter_->Reset();
   viterbi_result_checked_ = false;
   check_mode_ = mode;
+  best_fx_ = kint32max;
+  num_created_elements_ = 0;
 
   begin_node_ = begin_node;
   end_node_ = end_node;
@@ -308,6 +340,13 @@ bool NBestGenerator::Next(const string &original_key,
   while (!agenda_.IsEmpty()) {
     const QueueElement *top = agenda_.Top();
     DCHECK(top);
+    if (IsOverCostThreshold(top->fx)) {
+      // The agenda is ordered by f(x), so no remaining path is within the
+      // threshold.
+      VLOG(2) << "over the cost threshold: " << top->fx - best_fx_;
+      agenda_.Clear();
+      return false;
+    }
     agenda_.Pop();
     const Node *rnode = top->node;
     CHECK(rnode);
@@ -439,6 +478,10 @@ bool NBestGenerator::Next(const string &original_key,
         const int32 fx = lnode->cost + gx;
         const int32 structure_gx = structure_cost_diff + top->structure_gx;
         const int32 w_gx = wcost_diff + top->w_gx;
+        best_fx_ = min(best_fx_, fx);
+        if (IsOverCostThreshold(fx)) {
+          continue;
+        }
         if (is_left_edge) {
           // We only need to only 1 left node here.
           // Even if expand all left nodes, all the |value| part should
@@ -457,6 +500,10 @@ bool NBestGenerator::Next(const string &original_key,
       if (best_left_elm != NULL) {
         agenda_.Push(best_left_elm);
       }
+
+      if (beam_width_ > 0 && agenda_.Size() >= 2 * beam_width_) {
+        agenda_.Prune(beam_width_);
+      }
     }
   }
 
@@ -568,6 +615,11 @@ int NBestGenerator::InsertTopResult(const string &original_key,
   return result;
 }
 
+bool NBestGenerator::IsOverCostThreshold(int32 fx) const {
+  return cost_threshold_ > 0 && best_fx_ != kint32max &&
+      fx - best_fx_ > cost_threshold_;
+}
+
 int NBestGenerator::GetTransitionCost(const Node *lnode,
                                       const Node *rnode) const {
   const int kInvalidPenaltyCost = 100000;
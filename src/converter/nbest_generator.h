@@ -38,6 +38,8 @@
 #include "base/scoped_ptr.h"
 #include "converter/candidate_filter.h"
 #include "converter/segments.h"
+// for FRIEND_TEST()
+#include "testing/base/public/gunit_prod.h"
 
 namespace mozc {
 
@@ -93,6 +95,17 @@ class NBestGenerator {
   void Reset(const Node *begin_node, const Node *end_node,
              const BoundaryCheckMode mode);
 
+  // Sets the maximum number of partial paths kept in the agenda.
+  // When the agenda grows to twice of |beam_width|, the paths except for the
+  // best |beam_width| ones are discarded. Zero disables the beam (default).
+  void set_beam_width(size_t beam_width);
+
+  // Sets the maximum cost difference of the paths to be enumerated from the
+  // best one. The paths over the threshold are not expanded, and Next()
+  // returns false once no path within the threshold remains. Zero disables
+  // the threshold (default).
+  void set_cost_threshold(int32 cost_threshold);
+
   // Iterator:
   // Can obtain N-best results by calling Next() in sequence.
   bool Next(const string &original_key,
@@ -100,6 +113,8 @@ class NBestGenerator {
             Segments::RequestType request_type);
 
  private:
+  FRIEND_TEST(NBestGeneratorTest, PruningTest);
+
   enum BoundaryCheckResult {
     VALID = 0,
     VALID_WEAK_CONNECTED,  // Valid but should get penalty.
@@ -127,6 +142,9 @@ class NBestGenerator {
     bool IsEmpty() const {
       return priority_queue_.empty();
     }
+    size_t Size() const {
+      return priority_queue_.size();
+    }
     void Clear() {
       priority_queue_.clear();
     }
@@ -137,6 +155,9 @@ class NBestGenerator {
     void Push(const QueueElement *element);
     void Pop();
 
+    // Keeps only the best |size| elements.
+    void Prune(size_t size);
+
    private:
     vector<const QueueElement*> priority_queue_;
 
@@ -161,6 +182,9 @@ class NBestGenerator {
 
   int GetTransitionCost(const Node *lnode, const Node *rnode) const;
 
+  // Returns true if a path whose f(x) is |fx| is over the cost threshold.
+  bool IsOverCostThreshold(int32 fx) const;
+
   // Create queue element from freelist
   const QueueElement *CreateNewElement(const Node *node,
                                        const QueueElement *next,
@@ -188,6 +212,15 @@ class NBestGenerator {
 
   BoundaryChecker boundary_checker_;
 
+  // Limits of the search. Zero means no limit.
+  size_t beam_width_;
+  int32 cost_threshold_;
+  // The smallest f(x) of the expanded paths, used as the base of
+  // |cost_threshold_|.
+  int32 best_fx_;
+  // The number of the queue elements created since the last Reset().
+  size_t num_created_elements_;
+
   DISALLOW_COPY_AND_ASSIGN(NBestGenerator);
 };
 
@@ -331,4 +331,98 @@ TEST_F(NBestGeneratorTest, SingleSegmentConnectionTest) {
               result_segment.candidate(0).value);
   }
 }
+
+TEST_F(NBestGeneratorTest, PruningTest) {
+  scoped_ptr<MockDataAndImmutableConverter> data_and_converter(
+      new MockDataAndImmutableConverter);
+  ImmutableConverterImpl *converter = data_and_converter->GetConverter();
+
+  Segments segments;
+  segments.set_request_type(Segments::CONVERSION);
+  // "わたしのなまえはなかのです"
+  string kText = ("\xe3\x82\x8f\xe3\x81\x9f\xe3\x81\x97\xe3\x81\xae"
+                  "\xe3\x81\xaa\xe3\x81\xbe\xe3\x81\x88\xe3\x81\xaf"
+                  "\xe3\x81\xaa\xe3\x81\x8b\xe3\x81\xae\xe3\x81\xa7"
+                  "\xe3\x81\x99");
+  {
+    Segment *segment = segments.add_segment();
+    segment->set_segment_type(Segment::FREE);
+    segment->set_key(kText);
+  }
+
+  Lattice lattice;
+  lattice.SetKey(kText);
+  const ConversionRequest request;
+  converter->MakeLattice(request, &segments, &lattice);
+
+  vector<uint16> group;
+  converter->MakeGroup(segments, &group);
+  converter->Viterbi(segments, &lattice);
+
+  scoped_ptr<NBestGenerator> nbest_generator(
+      data_and_converter->CreateNBestGenerator(&lattice));
+
+  const bool kSingleSegment = true;  // For realtime conversion
+  const Node *begin_node = lattice.bos_nodes();
+  const Node *end_node = GetEndNode(
+      *converter, segments, *begin_node, group, kSingleSegment);
+
+  Segment expected_segment;
+  nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+  GatherCandidates(
+      10, Segments::CONVERSION, nbest_generator.get(), &expected_segment);
+  ASSERT_LT(1, expected_segment.candidates_size());
+  const size_t expected_num_elements =
+      nbest_generator->num_created_elements_;
+
+  {
+    // The cost threshold only stops the enumeration, so the results are the
+    // prefix of the ones without the threshold.
+    nbest_generator->set_cost_threshold(1);
+    nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+    Segment result_segment;
+    GatherCandidates(
+        10, Segments::CONVERSION, nbest_generator.get(), &result_segment);
+    ASSERT_LE(1, result_segment.candidates_size());
+    // The candidates after the best one cost more than the threshold.
+    ASSERT_GT(expected_segment.candidates_size(),
+              result_segment.candidates_size());
+    EXPECT_GT(expected_num_elements, nbest_generator->num_created_elements_);
+    for (size_t i = 0; i < result_segment.candidates_size(); ++i) {
+      EXPECT_EQ(expected_segment.candidate(i).value,
+                result_segment.candidate(i).value);
+      EXPECT_EQ(expected_segment.candidate(i).cost,
+                result_segment.candidate(i).cost);
+    }
+    nbest_generator->set_cost_threshold(0);
+  }
+  {
+    // The Viterbi best result is always the top even with the narrowest beam.
+    nbest_generator->set_beam_width(1);
+    nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+    Segment result_segment;
+    GatherCandidates(
+        10, Segments::CONVERSION, nbest_generator.get(), &result_segment);
+    ASSERT_LE(1, result_segment.candidates_size());
+    EXPECT_EQ(expected_segment.candidate(0).value,
+              result_segment.candidate(0).value);
+    // The pruned paths are never expanded.
+    EXPECT_GT(expected_num_elements, nbest_generator->num_created_elements_);
+    nbest_generator->set_beam_width(0);
+  }
+  {
+    // Without the limits, the results are the same as the first ones.
+    nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+    Segment result_segment;
+    GatherCandidates(
+        10, Segments::CONVERSION, nbest_generator.get(), &result_segment);
+    ASSERT_EQ(expected_segment.candidates_size(),
+              result_segment.candidates_size());
+    EXPECT_EQ(expected_num_elements, nbest_generator->num_created_elements_);
+    for (size_t i = 0; i < result_segment.candidates_size(); ++i) {
+      EXPECT_EQ(expected_segment.candidate(i).value,
+                result_segment.candidate(i).value);
+    }
+  }
+}
 }  // namespace mozc
@@ -287,6 +287,15 @@ class NodeAllocatorInterface {
 
   virtual Node *NewNode() = 0;
 
+  // Returns a new node initialized by Node::InitFromToken().  Subclasses can
+  // override this to skip Node::Init(), as InitFromToken() sets all the
+  // fields anyway.
+  virtual Node *NewNodeFromToken(const Token &token) {
+    Node *node = NewNode();
+    node->InitFromToken(token);
+    return node;
+  }
+
   virtual size_t max_nodes_size() const {
     return max_nodes_size_;
   }
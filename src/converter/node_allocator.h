@@ -37,9 +37,15 @@
 
 namespace mozc {
 
+// Allocates nodes from chunks of kChunkSize nodes.  Free() keeps the chunks
+// needed for max_nodes_size() nodes instead of returning them to the heap,
+// so a conversion following another one usually allocates no node.  The
+// strings in a reused node also keep their capacity, so assigning a key or a
+// value to it does not allocate either unless the string is longer than
+// before.
 class NodeAllocator : public NodeAllocatorInterface {
  public:
-  NodeAllocator() : node_freelist_(1024), node_count_(0) {}
+  NodeAllocator() : node_freelist_(kChunkSize), node_count_(0) {}
   virtual ~NodeAllocator() {}
 
   virtual Node *NewNode() {
@@ -50,9 +56,19 @@ class NodeAllocator : public NodeAllocatorInterface {
     return node;
   }
 
-  // Free all nodes allocateed by NewNode()
+  virtual Node *NewNodeFromToken(const Token &token) {
+    Node *node = node_freelist_.Alloc();
+    DCHECK(node);
+    node->InitFromToken(token);
+    ++node_count_;
+    return node;
+  }
+
+  // Frees all nodes allocated by NewNode() and NewNodeFromToken().
   void Free() {
-    node_freelist_.Free();
+    const size_t num_chunks =
+        (max_nodes_size() + kChunkSize - 1) / kChunkSize;
+    node_freelist_.Trim(max(num_chunks, static_cast<size_t>(1)));
     node_count_ = 0;
   }
 
@@ -61,6 +77,8 @@ class NodeAllocator : public NodeAllocatorInterface {
   }
 
  private:
+  static const size_t kChunkSize = 1024;
+
   FreeList<Node> node_freelist_;
   size_t node_count_;
 
@@ -0,0 +1,89 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "converter/node_allocator.h"
+
+#include <vector>
+
+#include "base/port.h"
+#include "converter/node.h"
+#include "dictionary/dictionary_token.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace {
+
+TEST(NodeAllocatorTest, NewNodeFromToken) {
+  NodeAllocator allocator;
+  Token token;
+  token.key = "key";
+  token.value = "value";
+  token.cost = 100;
+  token.lid = 10;
+  token.rid = 20;
+  token.attributes = Token::USER_DICTIONARY;
+  Node *node = allocator.NewNodeFromToken(token);
+  ASSERT_TRUE(node != NULL);
+  EXPECT_EQ(1, allocator.node_count());
+  EXPECT_EQ("key", node->key);
+  EXPECT_EQ("", node->actual_key);
+  EXPECT_EQ("value", node->value);
+  EXPECT_EQ(100, node->wcost);
+  EXPECT_EQ(10, node->lid);
+  EXPECT_EQ(20, node->rid);
+  EXPECT_TRUE(node->attributes & Node::USER_DICTIONARY);
+  EXPECT_TRUE(node->prev == NULL);
+  EXPECT_TRUE(node->bnext == NULL);
+}
+
+TEST(NodeAllocatorTest, ReuseNodesAfterFree) {
+  NodeAllocator allocator;
+  allocator.set_max_nodes_size(4096);
+
+  vector<Node *> nodes;
+  for (int i = 0; i < 3000; ++i) {
+    Node *node = allocator.NewNode();
+    node->value = "a long value that does not fit in a short string";
+    nodes.push_back(node);
+  }
+  EXPECT_EQ(3000, allocator.node_count());
+
+  allocator.Free();
+  EXPECT_EQ(0, allocator.node_count());
+
+  // The same nodes are returned in the same order, and they are cleared.
+  for (int i = 0; i < 3000; ++i) {
+    Node *node = allocator.NewNode();
+    EXPECT_EQ(nodes[i], node);
+    EXPECT_TRUE(node->value.empty());
+  }
+}
+
+}  // namespace
+}  // namespace mozc
@@ -74,8 +74,7 @@ class BaseNodeListBuilder : public DictionaryInterface::Callback {
   NodeAllocatorInterface *allocator() { return allocator_; }
 
   Node *NewNodeFromToken(const Token &token) {
-    Node *new_node = allocator_->NewNode();
-    new_node->InitFromToken(token);
+    Node *new_node = allocator_->NewNodeFromToken(token);
     new_node->wcost += penalty_;
     return new_node;
   }
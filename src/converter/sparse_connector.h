@@ -52,6 +52,12 @@ class SparseConnector : public ConnectorInterface {
   virtual int GetTransitionCost(uint16 rid, uint16 lid) const;
   virtual int GetResolution() const;
 
+  // Returns the number of ids.  The matrix is square, so this is both the
+  // number of rids and that of lids.
+  int num_ids() const {
+    return rows_.size();
+  }
+
  private:
   class Row;
 
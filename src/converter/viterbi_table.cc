@@ -0,0 +1,144 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "converter/viterbi_table.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/port.h"
+#include "converter/connector_interface.h"
+#include "converter/lattice.h"
+#include "converter/node.h"
+
+namespace mozc {
+
+ViterbiTable::ViterbiTable() : lattice_(NULL) {}
+
+ViterbiTable::~ViterbiTable() {}
+
+void ViterbiTable::Init(const Lattice &lattice) {
+  const size_t num_positions = lattice.key().size() + 1;
+  offsets_.resize(num_positions);
+  sizes_.assign(num_positions, 0);
+
+  // Every node in the table is reachable from end_nodes(), so the number of
+  // nodes in the enext list is an upper bound of the column size.
+  size_t total = 0;
+  size_t max_column_size = 0;
+  for (size_t pos = 0; pos < num_positions; ++pos) {
+    offsets_[pos] = total;
+    size_t column_size = 0;
+    for (const Node *node = lattice.end_nodes(pos);
+         node != NULL; node = node->enext) {
+      ++column_size;
+    }
+    total += column_size;
+    max_column_size = max(max_column_size, column_size);
+  }
+
+  // resize() doesn't shrink the capacity, so the buffers grow to the size
+  // of the largest lattice and are not reallocated after that.
+  rids_.resize(total);
+  costs_.resize(total);
+  nodes_.resize(total);
+  transition_costs_.resize(max_column_size);
+  lattice_ = &lattice;
+}
+
+void ViterbiTable::Add(Node *node) {
+  const size_t pos = node->end_pos;
+  DCHECK_LT(pos, sizes_.size());
+  const size_t index = offsets_[pos] + sizes_[pos];
+  DCHECK(pos + 1 == offsets_.size() || index < offsets_[pos + 1])
+      << "Node is not in end_nodes(" << pos << ")";
+  rids_[index] = node->rid;
+  costs_[index] = node->cost;
+  nodes_[index] = node;
+  ++sizes_[pos];
+}
+
+Node *ViterbiTable::FindBestPrev(const ConnectorInterface &connector,
+                                 size_t pos, uint16 lid, int *best_cost) {
+  const size_t size = sizes_[pos];
+  if (size == 0) {
+    return NULL;
+  }
+  const size_t offset = offsets_[pos];
+  int *costs = &transition_costs_[0];
+  connector.GetTransitionCosts(&rids_[offset], size, lid, costs);
+
+  // The two passes below have no data-dependent branches except the final
+  // search, so that the compiler can vectorize them.
+  const int *prev_costs = &costs_[offset];
+  int min_cost = INT_MAX;
+  for (size_t i = 0; i < size; ++i) {
+    costs[i] += prev_costs[i];
+    min_cost = min(min_cost, costs[i]);
+  }
+  if (min_cost >= *best_cost) {
+    return NULL;
+  }
+  size_t best = size;
+  size_t num_best = 0;
+  for (size_t i = 0; i < size; ++i) {
+    if (costs[i] == min_cost) {
+      best = i;
+      ++num_best;
+    }
+  }
+  DCHECK_LT(best, size);
+  *best_cost = min_cost;
+  if (num_best == 1) {
+    return nodes_[offset + best];
+  }
+
+  // The old loop over the enext list took the first minimum in the list.
+  // Ties are rare, so the list is walked only for them.
+  tied_nodes_.clear();
+  for (size_t i = 0; i < size; ++i) {
+    if (costs[i] == min_cost) {
+      tied_nodes_.push_back(nodes_[offset + i]);
+    }
+  }
+  DCHECK(lattice_ != NULL);
+  for (Node *node = lattice_->end_nodes(pos);
+       node != NULL; node = node->enext) {
+    if (find(tied_nodes_.begin(), tied_nodes_.end(), node) !=
+        tied_nodes_.end()) {
+      return node;
+    }
+  }
+  LOG(DFATAL) << "Node is not in end_nodes(" << pos << ")";
+  return nodes_[offset + best];
+}
+
+}  // namespace mozc
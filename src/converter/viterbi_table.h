@@ -0,0 +1,113 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_CONVERTER_VITERBI_TABLE_H_
+#define MOZC_CONVERTER_VITERBI_TABLE_H_
+
+#include <vector>
+
+#include "base/port.h"
+
+namespace mozc {
+
+class ConnectorInterface;
+class Lattice;
+struct Node;
+
+// Structure-of-arrays view of the lattice for the Viterbi forward pass.
+//
+// Viterbi relaxes every begin node at a position against all the end nodes at
+// the same position.  Walking the enext list of Node touches one cache line
+// per node just to read rid and cost, and the validity check (prev != NULL)
+// is a branch in the innermost loop.  This table instead keeps, for each
+// position, the rid, cost and Node of the valid end nodes in parallel arrays.
+// A node is added once its cost is settled, i.e., when Viterbi has processed
+// its begin position, so the column at |pos| is complete by the time Viterbi
+// reaches |pos|.  The Nodes stay the primary representation; the table only
+// carries what the inner loop reads.
+//
+// Usage:
+//   ViterbiTable *table = lattice->viterbi_table();
+//   table->Init(*lattice);
+//   table->Add(bos_node);
+//   for each position pos and each begin node rnode at pos:
+//     int cost = kVeryBigCost;
+//     rnode->prev = table->FindBestPrev(connector, pos, rnode->lid, &cost);
+//     ...
+//     table->Add(rnode);
+class ViterbiTable {
+ public:
+  ViterbiTable();
+  ~ViterbiTable();
+
+  // Lays out the columns for the end nodes in |lattice|.  Previously added
+  // nodes are discarded but the allocated buffers are reused.  |lattice|
+  // must outlive the following calls of FindBestPrev().
+  void Init(const Lattice &lattice);
+
+  // Appends |node| to the column at node->end_pos.  node->rid and node->cost
+  // must be final.
+  void Add(Node *node);
+
+  // Returns the number of nodes added to the column at |pos|.
+  size_t column_size(size_t pos) const {
+    return sizes_[pos];
+  }
+
+  // Finds the node in the column at |pos| that minimizes
+  //   node->cost + connector.GetTransitionCost(node->rid, lid).
+  // If the minimum is less than |*best_cost|, updates |*best_cost| and
+  // returns the node.  Otherwise returns NULL.  Ties are broken by the
+  // order of the enext list at |pos|, not by the order of Add(), so that the
+  // result is the same as that of walking the enext list.  The list is
+  // walked only when more than one node has the minimum cost.
+  Node *FindBestPrev(const ConnectorInterface &connector, size_t pos,
+                     uint16 lid, int *best_cost);
+
+ private:
+  // Column |pos| occupies [offsets_[pos], offsets_[pos] + sizes_[pos]) of
+  // rids_, costs_ and nodes_.
+  vector<size_t> offsets_;
+  vector<size_t> sizes_;
+  vector<uint16> rids_;
+  vector<int> costs_;
+  vector<Node *> nodes_;
+  // The lattice passed to Init(), whose enext lists break ties.
+  const Lattice *lattice_;
+  // Scratch buffer for transition costs of one column.
+  vector<int> transition_costs_;
+  // Scratch buffer for the nodes which have the same minimum cost.
+  vector<Node *> tied_nodes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ViterbiTable);
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_CONVERTER_VITERBI_TABLE_H_
@@ -0,0 +1,216 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "converter/viterbi_table.h"
+
+#include <climits>
+#include <vector>
+
+#include "base/port.h"
+#include "converter/connector_interface.h"
+#include "converter/lattice.h"
+#include "converter/node.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace {
+
+class TestConnector : public ConnectorInterface {
+ public:
+  TestConnector() {}
+  ~TestConnector() {}
+
+  int GetTransitionCost(uint16 rid, uint16 lid) const {
+    return rid == lid ? 0 : 100;
+  }
+
+  int GetResolution() const {
+    return 1;
+  }
+};
+
+Node *AddNode(Lattice *lattice, size_t begin_pos, size_t end_pos,
+              uint16 lid, uint16 rid, int cost) {
+  Node *node = lattice->NewNode();
+  node->lid = lid;
+  node->rid = rid;
+  node->key = lattice->key().substr(begin_pos, end_pos - begin_pos);
+  lattice->Insert(begin_pos, node);
+  // Insert() resets the cost.
+  node->cost = cost;
+  return node;
+}
+
+TEST(ViterbiTableTest, FindBestPrev) {
+  Lattice lattice;
+  lattice.SetKey("abc");
+  Node *n1 = AddNode(&lattice, 0, 2, 1, 1, 300);
+  Node *n2 = AddNode(&lattice, 0, 2, 2, 2, 250);
+  Node *n3 = AddNode(&lattice, 1, 2, 3, 3, 220);
+  // Ends at 2 but is treated as invalid below.
+  AddNode(&lattice, 1, 2, 4, 4, 400);
+
+  TestConnector connector;
+  ViterbiTable table;
+  table.Init(lattice);
+  EXPECT_EQ(0, table.column_size(2));
+
+  // Nothing has been added yet.
+  int best_cost = INT_MAX;
+  EXPECT_TRUE(table.FindBestPrev(connector, 2, 1, &best_cost) == NULL);
+  EXPECT_EQ(INT_MAX, best_cost);
+
+  table.Add(n1);
+  table.Add(n2);
+  table.Add(n3);
+  EXPECT_EQ(3, table.column_size(2));
+  EXPECT_EQ(0, table.column_size(0));
+
+  // Costs from n1, n2, n3 are 300 + 0, 250 + 100 and 220 + 100.
+  best_cost = INT_MAX;
+  EXPECT_EQ(n1, table.FindBestPrev(connector, 2, 1, &best_cost));
+  EXPECT_EQ(300, best_cost);
+
+  // 300 + 100, 250 + 0, 220 + 100.
+  best_cost = INT_MAX;
+  EXPECT_EQ(n2, table.FindBestPrev(connector, 2, 2, &best_cost));
+  EXPECT_EQ(250, best_cost);
+
+  // 400, 350, 320 with lid 4.  The invalid node (400 + 0) is ignored.
+  best_cost = INT_MAX;
+  EXPECT_EQ(n3, table.FindBestPrev(connector, 2, 4, &best_cost));
+  EXPECT_EQ(320, best_cost);
+
+  // Not updated unless the minimum is less than |best_cost|.
+  best_cost = 320;
+  EXPECT_TRUE(table.FindBestPrev(connector, 2, 4, &best_cost) == NULL);
+  EXPECT_EQ(320, best_cost);
+
+}
+
+TEST(ViterbiTableTest, ReuseForAnotherLattice) {
+  TestConnector connector;
+  Lattice lattice1;
+  lattice1.SetKey("abcd");
+  Node *n1 = AddNode(&lattice1, 0, 4, 1, 1, 100);
+  Node *n2 = AddNode(&lattice1, 1, 4, 2, 2, 100);
+
+  ViterbiTable *table = lattice1.viterbi_table();
+  table->Init(lattice1);
+  table->Add(n1);
+  table->Add(n2);
+  EXPECT_EQ(2, table->column_size(4));
+
+  // Init() discards the nodes of the previous lattice.
+  Lattice lattice2;
+  lattice2.SetKey("ab");
+  Node *n3 = AddNode(&lattice2, 0, 2, 1, 1, 50);
+  Node *n4 = AddNode(&lattice2, 1, 2, 1, 1, 50);
+  table->Init(lattice2);
+  EXPECT_EQ(0, table->column_size(2));
+  table->Add(n4);
+  table->Add(n3);
+  EXPECT_EQ(2, table->column_size(2));
+
+  // The tie is broken by the enext list of |lattice2|.
+  int best_cost = INT_MAX;
+  EXPECT_EQ(lattice2.end_nodes(2),
+            table->FindBestPrev(connector, 2, 1, &best_cost));
+  EXPECT_EQ(50, best_cost);
+
+  // The table is kept with the lattice.
+  EXPECT_EQ(table, lattice1.viterbi_table());
+}
+
+// The best prev found by walking the enext list, as Viterbi did before
+// ViterbiTable.
+Node *FindBestPrevByEnext(const ConnectorInterface &connector,
+                          const Lattice &lattice, size_t pos, uint16 lid,
+                          int *best_cost) {
+  Node *best_node = NULL;
+  for (Node *lnode = lattice.end_nodes(pos);
+       lnode != NULL; lnode = lnode->enext) {
+    if (lnode->prev == NULL) {
+      continue;
+    }
+    const int cost =
+        lnode->cost + connector.GetTransitionCost(lnode->rid, lid);
+    if (cost < *best_cost) {
+      *best_cost = cost;
+      best_node = lnode;
+    }
+  }
+  return best_node;
+}
+
+TEST(ViterbiTableTest, TieBreakSameAsEnextList) {
+  Lattice lattice;
+  lattice.SetKey("abcdef");
+  // Nodes ending at 6 with equal costs, inserted in the order of the begin
+  // position and in the reverse order, so that the order of Add() in
+  // Viterbi differs from that of the enext list.
+  vector<Node *> nodes;
+  for (int i = 0; i < 6; ++i) {
+    nodes.push_back(AddNode(&lattice, i, 6, 1, i % 3, 100));
+  }
+  for (int i = 5; i >= 0; --i) {
+    nodes.push_back(AddNode(&lattice, i, 6, 1, i % 3 + 3, 100));
+  }
+  Node dummy_prev;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i]->prev = &dummy_prev;
+  }
+
+  TestConnector connector;
+  ViterbiTable table;
+  table.Init(lattice);
+  // Viterbi adds nodes by the begin position and the begin_nodes list.
+  for (size_t pos = 0; pos < 6; ++pos) {
+    for (Node *node = lattice.begin_nodes(pos);
+         node != NULL; node = node->bnext) {
+      table.Add(node);
+    }
+  }
+  ASSERT_EQ(nodes.size(), table.column_size(6));
+
+  // lid 0..5 prefers the nodes of the same rid, and lid 6 has ties among
+  // all the nodes.
+  for (uint16 lid = 0; lid <= 6; ++lid) {
+    int expected_cost = INT_MAX;
+    const Node *expected =
+        FindBestPrevByEnext(connector, lattice, 6, lid, &expected_cost);
+    int best_cost = INT_MAX;
+    EXPECT_EQ(expected, table.FindBestPrev(connector, 6, lid, &best_cost))
+        << lid;
+    EXPECT_EQ(expected_cost, best_cost) << lid;
+  }
+}
+
+}  // namespace
+}  // namespace mozc
@@ -49,6 +49,9 @@ DEFINE_string(output, "", "Output data file name");
 DEFINE_string(dictionary_version, "", "dictionary version");
 DEFINE_bool(make_header, false, "make header mode");
 DEFINE_bool(use_gzip, false, "use gzip");
+DEFINE_bool(use_image, false,
+            "output a packed data image, which can be mapped and used "
+            "without parsing");
 
 namespace mozc {
 namespace {
@@ -115,7 +118,13 @@ bool OutputData(const string &file_path) {
 #endif  // NO_USAGE_REWRITER
   packer.SetCounterSuffixSortedArray(kCounterSuffixes,
                                      arraysize(kCounterSuffixes));
-  if (FLAGS_make_header) {
+  if (FLAGS_use_image) {
+    if (FLAGS_make_header || FLAGS_use_gzip) {
+      LOG(ERROR) << "use_image cannot be used with make_header or use_gzip";
+      return false;
+    }
+    return packer.OutputImage(file_path);
+  } else if (FLAGS_make_header) {
     return packer.OutputHeader(file_path, FLAGS_use_gzip);
   } else {
     return packer.Output(file_path, FLAGS_use_gzip);
@@ -0,0 +1,217 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/packed/packed_data_image.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace mozc {
+namespace packed {
+namespace {
+
+const char kMagic[8] = {'M', 'O', 'Z', 'C', 'P', 'K', 'D', '\0'};
+
+struct Header {
+  char magic[8];
+  uint32 image_version;
+  uint32 byte_order_mark;
+  uint32 data_format_version;
+  uint32 num_sections;
+};
+
+struct SectionEntry {
+  uint32 id;
+  uint32 offset;
+  uint32 size;
+  uint32 reserved;
+};
+
+size_t Align(size_t offset) {
+  return (offset + kPackedDataImageAlignment - 1) &
+      ~(kPackedDataImageAlignment - 1);
+}
+
+}  // namespace
+
+PackedDataImageBuilder::PackedDataImageBuilder(uint32 data_format_version)
+    : data_format_version_(data_format_version) {}
+
+PackedDataImageBuilder::~PackedDataImageBuilder() {}
+
+uint32 PackedDataImageBuilder::AddString(const char *str) {
+  if (str == NULL) {
+    return kPackedDataImageNullString;
+  }
+  return AddString(StringPiece(str));
+}
+
+uint32 PackedDataImageBuilder::AddString(StringPiece str) {
+  const string key = str.as_string();
+  map<string, uint32>::const_iterator it = string_offsets_.find(key);
+  if (it != string_offsets_.end()) {
+    return it->second;
+  }
+  const uint32 offset = static_cast<uint32>(string_pool_.size());
+  string_pool_.append(key);
+  string_pool_.push_back('\0');
+  string_offsets_.insert(make_pair(key, offset));
+  return offset;
+}
+
+void PackedDataImageBuilder::SetSection(uint32 id, const void *data,
+                                        size_t size) {
+  DCHECK_NE(kStringPoolSection, id);
+  sections_[id].assign(static_cast<const char *>(data), size);
+}
+
+void PackedDataImageBuilder::Serialize(string *output) const {
+  DCHECK(output);
+  map<uint32, StringPiece> sections;
+  for (map<uint32, string>::const_iterator it = sections_.begin();
+       it != sections_.end(); ++it) {
+    sections[it->first] = it->second;
+  }
+  sections[kStringPoolSection] = string_pool_;
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.image_version = kPackedDataImageVersion;
+  header.byte_order_mark = kPackedDataImageByteOrderMark;
+  header.data_format_version = data_format_version_;
+  header.num_sections = static_cast<uint32>(sections.size());
+
+  vector<SectionEntry> entries;
+  size_t offset =
+      Align(sizeof(header) + sections.size() * sizeof(SectionEntry));
+  for (map<uint32, StringPiece>::const_iterator it = sections.begin();
+       it != sections.end(); ++it) {
+    SectionEntry entry;
+    entry.id = it->first;
+    entry.offset = static_cast<uint32>(offset);
+    entry.size = static_cast<uint32>(it->second.size());
+    entry.reserved = 0;
+    entries.push_back(entry);
+    offset = Align(offset + it->second.size());
+  }
+
+  output->clear();
+  output->reserve(offset);
+  output->append(reinterpret_cast<const char *>(&header), sizeof(header));
+  output->append(reinterpret_cast<const char *>(&entries[0]),
+                 entries.size() * sizeof(SectionEntry));
+  size_t i = 0;
+  for (map<uint32, StringPiece>::const_iterator it = sections.begin();
+       it != sections.end(); ++it, ++i) {
+    output->resize(entries[i].offset, '\0');
+    output->append(it->second.data(), it->second.size());
+  }
+  output->resize(offset, '\0');
+}
+
+PackedDataImage::PackedDataImage()
+    : data_format_version_(0) {}
+
+PackedDataImage::~PackedDataImage() {}
+
+// static
+bool PackedDataImage::IsPackedDataImage(const char *data, size_t size) {
+  return size >= sizeof(Header) && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool PackedDataImage::Open(const char *data, size_t size) {
+  sections_.clear();
+  if (!IsPackedDataImage(data, size)) {
+    LOG(ERROR) << "Not a packed data image";
+    return false;
+  }
+  if (reinterpret_cast<uintptr_t>(data) % kPackedDataImageAlignment != 0) {
+    LOG(ERROR) << "Packed data image is not aligned";
+    return false;
+  }
+  const Header *header = reinterpret_cast<const Header *>(data);
+  if (header->byte_order_mark != kPackedDataImageByteOrderMark) {
+    LOG(ERROR) << "Byte order of the packed data image mismatch";
+    return false;
+  }
+  if (header->image_version != kPackedDataImageVersion) {
+    LOG(ERROR) << "Packed data image version mismatch."
+               << " expected:" << kPackedDataImageVersion
+               << " actual:" << header->image_version;
+    return false;
+  }
+  if (header->num_sections >
+      (size - sizeof(Header)) / sizeof(SectionEntry)) {
+    LOG(ERROR) << "Broken section table";
+    return false;
+  }
+  const SectionEntry *entries =
+      reinterpret_cast<const SectionEntry *>(data + sizeof(Header));
+  for (uint32 i = 0; i < header->num_sections; ++i) {
+    const SectionEntry &entry = entries[i];
+    if (entry.id >= kNumPackedDataSections ||
+        entry.offset > size || entry.size > size - entry.offset ||
+        entry.offset % kPackedDataImageAlignment != 0) {
+      LOG(ERROR) << "Broken section: " << entry.id;
+      sections_.clear();
+      return false;
+    }
+    if (entry.id >= sections_.size()) {
+      sections_.resize(entry.id + 1);
+    }
+    sections_[entry.id] = StringPiece(data + entry.offset, entry.size);
+  }
+  const StringPiece string_pool = GetSection(kStringPoolSection);
+  if (!string_pool.empty() && string_pool[string_pool.size() - 1] != '\0') {
+    LOG(ERROR) << "String pool is not terminated";
+    sections_.clear();
+    return false;
+  }
+  data_format_version_ = header->data_format_version;
+  return true;
+}
+
+StringPiece PackedDataImage::GetSection(uint32 id) const {
+  if (id >= sections_.size()) {
+    return StringPiece();
+  }
+  return sections_[id];
+}
+
+const char *PackedDataImage::GetString(uint32 offset) const {
+  const StringPiece string_pool = GetSection(kStringPoolSection);
+  if (offset == kPackedDataImageNullString || offset >= string_pool.size()) {
+    return NULL;
+  }
+  return string_pool.data() + offset;
+}
+
+}  // namespace packed
+}  // namespace mozc
@@ -0,0 +1,248 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flat container format of the packed system dictionary data.
+//
+// Unlike SystemDictionaryData (system_dictionary_data.proto), which has to be
+// parsed into heap objects before the engine starts, a packed data image can
+// be mapped into memory with Mmap and used in place: large blobs and integer
+// tables are referred to directly in the mapping, and strings are stored as
+// NUL-terminated entries of a string pool so that the structures of
+// DataManagerInterface can point to them without copying.
+//
+// Layout (integers are in the byte order of the machine that built the
+// image; the reader rejects images with different byte order):
+//
+//   Header (24 bytes)
+//     char[8] magic        "MOZCPKD\0"
+//     uint32  image_version       kPackedDataImageVersion
+//     uint32  byte_order_mark     kPackedDataImageByteOrderMark
+//     uint32  data_format_version kSystemDictionaryFormatVersion
+//     uint32  num_sections
+//   Section table (16 bytes per section)
+//     uint32  id, uint32 offset, uint32 size, uint32 reserved
+//   Section bodies, each starting at a multiple of kPackedDataImageAlignment.
+
+#ifndef MOZC_DATA_MANAGER_PACKED_PACKED_DATA_IMAGE_H_
+#define MOZC_DATA_MANAGER_PACKED_PACKED_DATA_IMAGE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+#include "base/string_piece.h"
+
+namespace mozc {
+namespace packed {
+
+const uint32 kPackedDataImageVersion = 1;
+const uint32 kPackedDataImageByteOrderMark = 0x01020304;
+const size_t kPackedDataImageAlignment = 16;
+// Offset value used for NULL strings.
+const uint32 kPackedDataImageNullString = 0xFFFFFFFF;
+
+// Section IDs of the system dictionary data.  Each comment describes the
+// element type of the section.
+enum PackedDataSection {
+  kStringPoolSection = 0,          // char (NUL-terminated strings)
+  kProductVersionSection,          // char
+  kPosTokenSection,                // PosTokenRecord
+  kConjugationFormSection,         // ConjugationFormRecord
+  kRuleIdTableSection,             // uint16
+  kRangeTableIndexSection,         // uint32 (first item of each table)
+  kRangeTableItemSection,          // RangeRecord (0xFFFF terminated tables)
+  kLidGroupSection,                // uint8
+  kBoundaryDataSection,            // BoundaryData
+  kSuffixTokenSection,             // SuffixTokenRecord
+  kReadingCorrectionSection,       // ReadingCorrectionRecord
+  kSegmenterSizeSection,           // uint32[2] (compressed l and r sizes)
+  kSegmenterLidTableSection,       // uint16
+  kSegmenterRidTableSection,       // uint16
+  kSegmenterBitArraySection,       // char
+  kSuggestionFilterSection,        // char
+  kConnectionSection,              // char
+  kDictionarySection,              // char
+  kCollocationSection,             // char
+  kCollocationSuppressionSection,  // char
+  kSymbolTokenSection,             // SymbolTokenRecord
+  kSymbolValueSection,             // SymbolValueRecord
+  kUsageBaseSuffixSection,         // ConjugationSuffixRecord
+  kUsageSuffixSection,             // ConjugationSuffixRecord
+  kUsageSuffixIndexSection,        // int32 (conjugation num + 1)
+  kUsageItemSection,               // UsageItemRecord
+  kCounterSuffixSection,           // CounterSuffixRecord
+  kNumPackedDataSections,
+};
+
+// Records stored in the sections.  String fields hold offsets in the string
+// pool section.
+struct PosTokenRecord {
+  uint32 pos;
+  uint32 conjugation_begin;
+  uint32 conjugation_size;
+};
+
+struct ConjugationFormRecord {
+  uint32 key_suffix;
+  uint32 value_suffix;
+  uint32 id;
+};
+
+struct RangeRecord {
+  uint16 lower;
+  uint16 upper;
+};
+
+struct SuffixTokenRecord {
+  uint32 key;
+  uint32 value;
+  uint16 lid;
+  uint16 rid;
+  int16 wcost;
+  uint16 padding;
+};
+
+struct ReadingCorrectionRecord {
+  uint32 value;
+  uint32 error;
+  uint32 correction;
+};
+
+struct SymbolTokenRecord {
+  uint32 key;
+  uint32 value_begin;
+  uint32 value_size;
+};
+
+struct SymbolValueRecord {
+  uint32 value;
+  uint32 description;
+  uint32 additional_description;
+  uint16 lid;
+  uint16 rid;
+  int16 cost;
+  uint16 padding;
+};
+
+struct ConjugationSuffixRecord {
+  uint32 value_suffix;
+  uint32 key_suffix;
+};
+
+struct UsageItemRecord {
+  int32 id;
+  uint32 key;
+  uint32 value;
+  int32 conjugation_id;
+  uint32 meaning;
+};
+
+struct CounterSuffixRecord {
+  uint32 suffix;
+  uint32 size;
+};
+
+class PackedDataImageBuilder {
+ public:
+  explicit PackedDataImageBuilder(uint32 data_format_version);
+  ~PackedDataImageBuilder();
+
+  // Adds a string to the string pool and returns its offset.  Identical
+  // strings share the same entry.  Returns kPackedDataImageNullString for
+  // NULL.
+  uint32 AddString(const char *str);
+  uint32 AddString(StringPiece str);
+
+  // Sets the body of the section |id|.  The string pool section is managed
+  // by the builder and cannot be set.
+  void SetSection(uint32 id, const void *data, size_t size);
+
+  template <typename T>
+  void SetArraySection(uint32 id, const vector<T> &array) {
+    SetSection(id, array.empty() ? NULL : &array[0], array.size() * sizeof(T));
+  }
+
+  void Serialize(string *output) const;
+
+ private:
+  const uint32 data_format_version_;
+  string string_pool_;
+  map<string, uint32> string_offsets_;
+  map<uint32, string> sections_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackedDataImageBuilder);
+};
+
+// Reads a packed data image without copying.  The memory passed to Open()
+// must outlive this object and be aligned to kPackedDataImageAlignment.
+class PackedDataImage {
+ public:
+  PackedDataImage();
+  ~PackedDataImage();
+
+  // Returns true if |data| starts with the magic of the packed data image.
+  static bool IsPackedDataImage(const char *data, size_t size);
+
+  // Validates the header and the section table.
+  bool Open(const char *data, size_t size);
+
+  uint32 data_format_version() const { return data_format_version_; }
+
+  // Returns the body of the section |id|.  A missing section is empty.
+  StringPiece GetSection(uint32 id) const;
+
+  // Returns the section |id| as an array of T.  Returns false if the section
+  // size is not a multiple of sizeof(T).
+  template <typename T>
+  bool GetArray(uint32 id, const T **array, size_t *size) const {
+    const StringPiece section = GetSection(id);
+    if (section.size() % sizeof(T) != 0) {
+      return false;
+    }
+    *array = reinterpret_cast<const T *>(section.data());
+    *size = section.size() / sizeof(T);
+    return true;
+  }
+
+  // Returns the string at |offset| in the string pool, or NULL for
+  // kPackedDataImageNullString and invalid offsets.
+  const char *GetString(uint32 offset) const;
+
+ private:
+  uint32 data_format_version_;
+  vector<StringPiece> sections_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackedDataImage);
+};
+
+}  // namespace packed
+}  // namespace mozc
+
+#endif  // MOZC_DATA_MANAGER_PACKED_PACKED_DATA_IMAGE_H_
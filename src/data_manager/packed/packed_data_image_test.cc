@@ -0,0 +1,173 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/packed/packed_data_image.h"
+
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace packed {
+namespace {
+
+const uint32 kFormatVersion = 4;
+
+// Copies |image| into a buffer aligned for PackedDataImage.
+class AlignedBuffer {
+ public:
+  explicit AlignedBuffer(const string &image)
+      : buffer_(image.size() / sizeof(uint64) + 1) {
+    memcpy(&buffer_[0], image.data(), image.size());
+  }
+  const char *data() const {
+    return reinterpret_cast<const char *>(&buffer_[0]);
+  }
+
+ private:
+  vector<uint64> buffer_;
+};
+
+TEST(PackedDataImageTest, BuildAndRead) {
+  PackedDataImageBuilder builder(kFormatVersion);
+  const uint32 hello = builder.AddString("hello");
+  const uint32 world = builder.AddString("world");
+  EXPECT_EQ(hello, builder.AddString(string("hello")));
+  EXPECT_EQ(kPackedDataImageNullString, builder.AddString(NULL));
+
+  vector<uint16> table;
+  table.push_back(1);
+  table.push_back(2);
+  table.push_back(3);
+  builder.SetArraySection(kRuleIdTableSection, table);
+  builder.SetSection(kDictionarySection, "abc", 3);
+
+  string image;
+  builder.Serialize(&image);
+  EXPECT_EQ(0, image.size() % kPackedDataImageAlignment);
+
+  const AlignedBuffer buffer(image);
+  EXPECT_TRUE(PackedDataImage::IsPackedDataImage(buffer.data(), image.size()));
+  PackedDataImage reader;
+  ASSERT_TRUE(reader.Open(buffer.data(), image.size()));
+  EXPECT_EQ(kFormatVersion, reader.data_format_version());
+
+  EXPECT_STREQ("hello", reader.GetString(hello));
+  EXPECT_STREQ("world", reader.GetString(world));
+  EXPECT_EQ(NULL, reader.GetString(kPackedDataImageNullString));
+  EXPECT_EQ(NULL, reader.GetString(100000));
+
+  const uint16 *rule_id_table = NULL;
+  size_t size = 0;
+  ASSERT_TRUE(reader.GetArray(kRuleIdTableSection, &rule_id_table, &size));
+  ASSERT_EQ(3, size);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(rule_id_table) %
+            kPackedDataImageAlignment);
+  EXPECT_EQ(1, rule_id_table[0]);
+  EXPECT_EQ(2, rule_id_table[1]);
+  EXPECT_EQ(3, rule_id_table[2]);
+
+  // Sections are referred to in place.
+  const StringPiece dictionary = reader.GetSection(kDictionarySection);
+  EXPECT_EQ("abc", dictionary.as_string());
+  EXPECT_GE(dictionary.data(), buffer.data());
+  EXPECT_LT(dictionary.data(), buffer.data() + image.size());
+
+  // Missing sections are empty.
+  EXPECT_TRUE(reader.GetSection(kConnectionSection).empty());
+  const uint32 *segmenter_size = NULL;
+  EXPECT_TRUE(reader.GetArray(kSegmenterSizeSection, &segmenter_size, &size));
+  EXPECT_EQ(0, size);
+
+  // Size mismatch of the element type.
+  const uint32 *wrong_type = NULL;
+  EXPECT_FALSE(reader.GetArray(kRuleIdTableSection, &wrong_type, &size));
+}
+
+TEST(PackedDataImageTest, RejectBrokenImage) {
+  PackedDataImageBuilder builder(kFormatVersion);
+  builder.AddString("hello");
+  builder.SetSection(kDictionarySection, "abcdefg", 7);
+  string image;
+  builder.Serialize(&image);
+
+  PackedDataImage reader;
+  {
+    // Protobuf data or other garbage.
+    const string garbage = "\x0a\x07" "1.2.3.4";
+    const AlignedBuffer buffer(garbage);
+    EXPECT_FALSE(
+        PackedDataImage::IsPackedDataImage(buffer.data(), garbage.size()));
+    EXPECT_FALSE(reader.Open(buffer.data(), garbage.size()));
+  }
+  {
+    // Truncated.
+    const AlignedBuffer buffer(image);
+    EXPECT_FALSE(reader.Open(buffer.data(), image.size() / 2));
+  }
+  {
+    // Unaligned.
+    const string unaligned = "x" + image;
+    const AlignedBuffer buffer(unaligned);
+    EXPECT_FALSE(reader.Open(buffer.data() + 1, image.size()));
+  }
+  {
+    // Different byte order.
+    string swapped = image;
+    swapped[12] = 0x01;
+    swapped[13] = 0x02;
+    swapped[14] = 0x03;
+    swapped[15] = 0x04;
+    if (swapped != image) {
+      const AlignedBuffer buffer(swapped);
+      EXPECT_FALSE(reader.Open(buffer.data(), swapped.size()));
+    }
+  }
+  {
+    // Section id out of range. The first section entry follows the 24-byte
+    // header.
+    string broken_id = image;
+    broken_id[24] = '\xff';
+    broken_id[25] = '\xff';
+    broken_id[26] = '\xff';
+    broken_id[27] = '\xff';
+    const AlignedBuffer buffer(broken_id);
+    EXPECT_FALSE(reader.Open(buffer.data(), broken_id.size()));
+  }
+  {
+    const AlignedBuffer buffer(image);
+    EXPECT_TRUE(reader.Open(buffer.data(), image.size()));
+  }
+}
+
+}  // namespace
+}  // namespace packed
+}  // namespace mozc
@@ -29,6 +29,7 @@
 
 #include "data_manager/packed/packed_data_manager.h"
 
+#include <cstring>
 #include <memory>
 
 #include "base/logging.h"
@@ -36,8 +37,10 @@
 #include "base/protobuf/coded_stream.h"
 #include "base/protobuf/gzip_stream.h"
 #include "base/protobuf/zero_copy_stream_impl.h"
+#include "base/string_piece.h"
 #include "converter/boundary_struct.h"
 #include "data_manager/data_manager_interface.h"
+#include "data_manager/packed/packed_data_image.h"
 #include "data_manager/packed/system_dictionary_data.pb.h"
 #include "data_manager/packed/system_dictionary_format_version.h"
 #include "dictionary/pos_matcher.h"
@@ -80,6 +83,8 @@ class PackedDataManager::Impl {
   ~Impl();
   bool Init(const string &system_dictionary_data);
   bool InitWithZippedData(const string &zipped_system_dictionary_data);
+  bool InitWithImage(const char *image, size_t size);
+  bool InitWithMmap(const string &filename);
   string GetDictionaryVersion();
 
   const UserPOS::POSToken *GetUserPOSData() const;
@@ -121,19 +126,41 @@ class PackedDataManager::Impl {
     uint16 upper;
   };
   bool InitializeWithSystemDictionaryData();
+  bool InitializeWithImage(const PackedDataImage &image);
+
+  // The following pointers and pieces refer to either the buffers owned by
+  // this class, |system_dictionary_data_|, or the packed data image.
+  string product_version_;
+  const uint16 *rule_id_table_;
+  const BoundaryData *boundary_data_;
+  const uint16 *compressed_lid_table_;
+  const uint16 *compressed_rid_table_;
+  size_t compressed_l_size_;
+  size_t compressed_r_size_;
+  size_t suffix_tokens_size_;
+  size_t reading_corrections_size_;
+  size_t counter_suffix_size_;
+  StringPiece lid_group_data_;
+  StringPiece segmenter_bit_array_data_;
+  StringPiece suggestion_filter_data_;
+  StringPiece connection_data_;
+  StringPiece dictionary_data_;
+  StringPiece collocation_data_;
+  StringPiece collocation_suppression_data_;
+#ifndef NO_USAGE_REWRITER
+  const int *conjugation_suffix_data_index_;
+#endif  // NO_USAGE_REWRITER
 
   unique_ptr<UserPOS::POSToken[]> pos_token_;
   unique_ptr<UserPOS::ConjugationType[]> conjugation_array_;
-  unique_ptr<uint16[]> rule_id_table_;
+  unique_ptr<uint16[]> rule_id_table_buffer_;
   unique_ptr<POSMatcher::Range *[]> range_tables_;
   unique_ptr<Range[]> range_table_items_;
-  unique_ptr<BoundaryData[]> boundary_data_;
+  unique_ptr<BoundaryData[]> boundary_data_buffer_;
   unique_ptr<SuffixToken[]> suffix_tokens_;
   unique_ptr<ReadingCorrectionItem[]> reading_corrections_;
-  size_t compressed_l_size_;
-  size_t compressed_r_size_;
-  unique_ptr<uint16[]> compressed_lid_table_;
-  unique_ptr<uint16[]> compressed_rid_table_;
+  unique_ptr<uint16[]> compressed_lid_table_buffer_;
+  unique_ptr<uint16[]> compressed_rid_table_buffer_;
   unique_ptr<EmbeddedDictionary::Value[]> symbol_data_values_;
   size_t symbol_data_token_size_;
   unique_ptr<EmbeddedDictionary::Token[]> symbol_data_tokens_;
@@ -142,15 +169,28 @@ class PackedDataManager::Impl {
 #ifndef NO_USAGE_REWRITER
   unique_ptr<ConjugationSuffix[]> base_conjugation_suffix_;
   unique_ptr<ConjugationSuffix[]> conjugation_suffix_data_;
-  unique_ptr<int[]> conjugation_suffix_data_index_;
+  unique_ptr<int[]> conjugation_suffix_data_index_buffer_;
   unique_ptr<UsageDictItem[]> usage_data_value_;
 #endif  // NO_USAGE_REWRITER
   unique_ptr<CounterSuffixEntry[]> counter_suffix_data_;
+  // Storage of the packed data image if it is copied or mapped.
+  unique_ptr<uint64[]> image_buffer_;
+  unique_ptr<Mmap> mmap_;
 };
 
 PackedDataManager::Impl::Impl()
-    : compressed_l_size_(0),
+    : rule_id_table_(NULL),
+      boundary_data_(NULL),
+      compressed_lid_table_(NULL),
+      compressed_rid_table_(NULL),
+      compressed_l_size_(0),
       compressed_r_size_(0),
+      suffix_tokens_size_(0),
+      reading_corrections_size_(0),
+      counter_suffix_size_(0),
+#ifndef NO_USAGE_REWRITER
+      conjugation_suffix_data_index_(NULL),
+#endif  // NO_USAGE_REWRITER
       symbol_data_token_size_(0) {
 }
 
@@ -158,6 +198,16 @@ PackedDataManager::Impl::~Impl() {
 }
 
 bool PackedDataManager::Impl::Init(const string &system_dictionary_data) {
+  if (PackedDataImage::IsPackedDataImage(system_dictionary_data.data(),
+                                         system_dictionary_data.size())) {
+    // Copies the image to an aligned buffer as |system_dictionary_data| may
+    // be released after initialization.
+    const size_t size = system_dictionary_data.size();
+    image_buffer_.reset(new uint64[size / sizeof(uint64) + 1]);
+    memcpy(image_buffer_.get(), system_dictionary_data.data(), size);
+    return InitWithImage(reinterpret_cast<const char *>(image_buffer_.get()),
+                         size);
+  }
   system_dictionary_data_.reset(new SystemDictionaryData);
   if (!system_dictionary_data_->ParseFromString(system_dictionary_data)) {
     LOG(ERROR) << "System dictionary data protobuf format error!";
@@ -182,8 +232,40 @@ bool PackedDataManager::Impl::InitWithZippedData(
   return InitializeWithSystemDictionaryData();
 }
 
+bool PackedDataManager::Impl::InitWithImage(const char *image, size_t size) {
+  PackedDataImage packed_data_image;
+  if (!packed_data_image.Open(image, size)) {
+    LOG(ERROR) << "System dictionary data image format error!";
+    return false;
+  }
+  return InitializeWithImage(packed_data_image);
+}
+
+bool PackedDataManager::Impl::InitWithMmap(const string &filename) {
+  mmap_.reset(new Mmap);
+  if (!mmap_->Open(filename.c_str(), "r")) {
+    LOG(ERROR) << "Failed to open " << filename;
+    return false;
+  }
+  if (PackedDataImage::IsPackedDataImage(mmap_->begin(), mmap_->size())) {
+    // The image is used in place, so pages of the file can be shared among
+    // processes.
+    return InitWithImage(mmap_->begin(), mmap_->size());
+  }
+  system_dictionary_data_.reset(new SystemDictionaryData);
+  const bool result =
+      system_dictionary_data_->ParseFromArray(mmap_->begin(), mmap_->size());
+  // The data has been copied to |system_dictionary_data_|.
+  mmap_.reset();
+  if (!result) {
+    LOG(ERROR) << "System dictionary data protobuf format error!";
+    return false;
+  }
+  return InitializeWithSystemDictionaryData();
+}
+
 string PackedDataManager::Impl::GetDictionaryVersion() {
-  return system_dictionary_data_->product_version();
+  return product_version_;
 }
 
 bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
@@ -240,15 +322,16 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
   }
 
   // Makes POSMatcher data.
-  rule_id_table_.reset(
+  rule_id_table_buffer_.reset(
       new uint16[
           system_dictionary_data_->pos_matcher_data().rule_id_table_size()]);
   for (size_t i = 0;
        i < system_dictionary_data_->pos_matcher_data().rule_id_table_size();
        ++i) {
-    rule_id_table_[i] =
+    rule_id_table_buffer_[i] =
         system_dictionary_data_->pos_matcher_data().rule_id_table(i);
   }
+  rule_id_table_ = rule_id_table_buffer_.get();
   const SystemDictionaryData::PosMatcherData &pos_matcher_data =
       system_dictionary_data_->pos_matcher_data();
   range_tables_.reset(
@@ -278,14 +361,15 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
   }
 
   // Makes boundary data.
-  boundary_data_.reset(
+  boundary_data_buffer_.reset(
       new BoundaryData[system_dictionary_data_->boundary_data_size()]);
   for (size_t i = 0; i < system_dictionary_data_->boundary_data_size(); ++i) {
     const SystemDictionaryData::BoundaryData &boundary_data =
         system_dictionary_data_->boundary_data(i);
-    boundary_data_[i].prefix_penalty = boundary_data.prefix_penalty();
-    boundary_data_[i].suffix_penalty = boundary_data.suffix_penalty();
+    boundary_data_buffer_[i].prefix_penalty = boundary_data.prefix_penalty();
+    boundary_data_buffer_[i].suffix_penalty = boundary_data.suffix_penalty();
   }
+  boundary_data_ = boundary_data_buffer_.get();
 
   // Makes suffix data.
   suffix_tokens_.reset(
@@ -341,16 +425,19 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
       system_dictionary_data_->segmenter_data();
   compressed_l_size_ = segmenter_data.compressed_l_size();
   compressed_r_size_ = segmenter_data.compressed_r_size();
-  compressed_lid_table_.reset(
+  compressed_lid_table_buffer_.reset(
       new uint16[segmenter_data.compressed_lid_table_size()]);
   for (size_t i = 0; i < segmenter_data.compressed_lid_table_size(); ++i) {
-    compressed_lid_table_[i] = segmenter_data.compressed_lid_table(i);
+    compressed_lid_table_buffer_[i] = segmenter_data.compressed_lid_table(i);
   }
-  compressed_rid_table_.reset(
+  compressed_lid_table_ = compressed_lid_table_buffer_.get();
+  compressed_rid_table_buffer_.reset(
       new uint16[segmenter_data.compressed_rid_table_size()]);
   for (size_t i = 0; i < segmenter_data.compressed_rid_table_size(); ++i) {
-    compressed_rid_table_[i] = segmenter_data.compressed_rid_table(i);
+    compressed_rid_table_buffer_[i] = segmenter_data.compressed_rid_table(i);
   }
+  compressed_rid_table_ = compressed_rid_table_buffer_.get();
+  segmenter_bit_array_data_ = segmenter_data.bit_array_data();
 
   // Makes symbol dictionary data.
   const SystemDictionaryData::EmbeddedDictionary &symbol_dictionary =
@@ -410,7 +497,7 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
 
   // Makes POSMatcher.
   pos_matcher_.reset(
-      new PackedPOSMatcher(rule_id_table_.get(), range_tables_.get()));
+      new PackedPOSMatcher(rule_id_table_, range_tables_.get()));
 
 #ifndef NO_USAGE_REWRITER
   // Makes Usge rewriter data.
@@ -418,10 +505,11 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
       system_dictionary_data_->usage_rewriter_data();
   const size_t conjugation_num = usage_rewriter_data.conjugations_size();
   base_conjugation_suffix_.reset(new ConjugationSuffix[conjugation_num]);
-  conjugation_suffix_data_index_.reset(new int[conjugation_num + 1]);
+  conjugation_suffix_data_index_buffer_.reset(new int[conjugation_num + 1]);
+  conjugation_suffix_data_index_ = conjugation_suffix_data_index_buffer_.get();
 
   size_t suffix_data_num = 0;
-  conjugation_suffix_data_index_[0] = 0;
+  conjugation_suffix_data_index_buffer_[0] = 0;
   for (size_t i = 0; i < conjugation_num; ++i) {
     const SystemDictionaryData::UsageRewriterData::Conjugation &conjugation =
       usage_rewriter_data.conjugations(i);
@@ -431,7 +519,7 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
         conjugation.base_suffix().key_suffix().data();
     suffix_data_num +=
         usage_rewriter_data.conjugations(i).conjugation_suffixes_size();
-    conjugation_suffix_data_index_[i + 1] = suffix_data_num;
+    conjugation_suffix_data_index_buffer_[i + 1] = suffix_data_num;
   }
   conjugation_suffix_data_.reset(new ConjugationSuffix[suffix_data_num]);
   size_t conjugation_suffix_id = 0;
@@ -481,6 +569,280 @@ bool PackedDataManager::Impl::InitializeWithSystemDictionaryData() {
       }
     }
   }
+
+  product_version_ = system_dictionary_data_->product_version();
+  suffix_tokens_size_ = system_dictionary_data_->suffix_tokens_size();
+  reading_corrections_size_ =
+      system_dictionary_data_->reading_corrections_size();
+  counter_suffix_size_ = system_dictionary_data_->counter_suffix_data_size();
+  lid_group_data_ = system_dictionary_data_->lid_group_data();
+  suggestion_filter_data_ = system_dictionary_data_->suggestion_filter_data();
+  connection_data_ = system_dictionary_data_->connection_data();
+  dictionary_data_ = system_dictionary_data_->dictionary_data();
+  collocation_data_ = system_dictionary_data_->collocation_data();
+  collocation_suppression_data_ =
+      system_dictionary_data_->collocation_suppression_data();
+  return true;
+}
+
+bool PackedDataManager::Impl::InitializeWithImage(
+    const PackedDataImage &image) {
+  // Checks format version.
+  if (image.data_format_version() != kSystemDictionaryFormatVersion) {
+    LOG(ERROR) << "System dictionary data format version miss match! "
+               << " expected:" << kSystemDictionaryFormatVersion
+               << " actual:" << image.data_format_version();
+    return false;
+  }
+  product_version_ = image.GetSection(kProductVersionSection).as_string();
+
+  // Only the arrays of structures having pointers are built here.  They
+  // point to the strings in the image, and the other data is used in place.
+  const PosTokenRecord *pos_tokens = NULL;
+  size_t pos_tokens_size = 0;
+  const ConjugationFormRecord *conjugation_forms = NULL;
+  size_t conjugation_forms_size = 0;
+  if (!image.GetArray(kPosTokenSection, &pos_tokens, &pos_tokens_size) ||
+      !image.GetArray(kConjugationFormSection,
+                      &conjugation_forms, &conjugation_forms_size)) {
+    LOG(ERROR) << "Broken POS token data";
+    return false;
+  }
+  pos_token_.reset(new UserPOS::POSToken[pos_tokens_size]);
+  conjugation_array_.reset(
+      new UserPOS::ConjugationType[conjugation_forms_size]);
+  for (size_t i = 0; i < conjugation_forms_size; ++i) {
+    conjugation_array_[i].key_suffix =
+        image.GetString(conjugation_forms[i].key_suffix);
+    conjugation_array_[i].value_suffix =
+        image.GetString(conjugation_forms[i].value_suffix);
+    conjugation_array_[i].id = conjugation_forms[i].id;
+  }
+  for (size_t i = 0; i < pos_tokens_size; ++i) {
+    const PosTokenRecord &record = pos_tokens[i];
+    if (record.conjugation_begin > conjugation_forms_size ||
+        record.conjugation_size >
+            conjugation_forms_size - record.conjugation_begin) {
+      LOG(ERROR) << "Broken POS token data";
+      return false;
+    }
+    pos_token_[i].pos = image.GetString(record.pos);
+    pos_token_[i].conjugation_size = record.conjugation_size;
+    pos_token_[i].conjugation_form = (record.conjugation_size == 0) ?
+        NULL : &conjugation_array_[record.conjugation_begin];
+  }
+
+  // POSMatcher.
+  size_t rule_id_table_size = 0;
+  const uint32 *range_table_index = NULL;
+  size_t range_tables_size = 0;
+  const RangeRecord *range_items = NULL;
+  size_t range_items_size = 0;
+  if (!image.GetArray(kRuleIdTableSection,
+                      &rule_id_table_, &rule_id_table_size) ||
+      !image.GetArray(kRangeTableIndexSection,
+                      &range_table_index, &range_tables_size) ||
+      !image.GetArray(kRangeTableItemSection,
+                      &range_items, &range_items_size)) {
+    LOG(ERROR) << "Broken POS matcher data";
+    return false;
+  }
+  range_tables_.reset(new POSMatcher::Range*[range_tables_size]);
+  for (size_t i = 0; i < range_tables_size; ++i) {
+    if (range_table_index[i] >= range_items_size) {
+      LOG(ERROR) << "Broken POS matcher data";
+      return false;
+    }
+    range_tables_[i] = reinterpret_cast<POSMatcher::Range *>(
+        const_cast<RangeRecord *>(&range_items[range_table_index[i]]));
+  }
+  if (range_items_size > 0 &&
+      range_items[range_items_size - 1].lower != static_cast<uint16>(0xFFFF)) {
+    LOG(ERROR) << "Range table is not terminated";
+    return false;
+  }
+  pos_matcher_.reset(new PackedPOSMatcher(rule_id_table_, range_tables_.get()));
+
+  lid_group_data_ = image.GetSection(kLidGroupSection);
+  size_t boundary_data_size = 0;
+  if (!image.GetArray(kBoundaryDataSection,
+                      &boundary_data_, &boundary_data_size)) {
+    LOG(ERROR) << "Broken boundary data";
+    return false;
+  }
+
+  // Suffix tokens.
+  const SuffixTokenRecord *suffix_tokens = NULL;
+  if (!image.GetArray(kSuffixTokenSection,
+                      &suffix_tokens, &suffix_tokens_size_)) {
+    LOG(ERROR) << "Broken suffix data";
+    return false;
+  }
+  suffix_tokens_.reset(new SuffixToken[suffix_tokens_size_]);
+  for (size_t i = 0; i < suffix_tokens_size_; ++i) {
+    suffix_tokens_[i].key = image.GetString(suffix_tokens[i].key);
+    suffix_tokens_[i].value = image.GetString(suffix_tokens[i].value);
+    suffix_tokens_[i].lid = suffix_tokens[i].lid;
+    suffix_tokens_[i].rid = suffix_tokens[i].rid;
+    suffix_tokens_[i].wcost = suffix_tokens[i].wcost;
+  }
+
+  // Reading corrections.
+  const ReadingCorrectionRecord *corrections = NULL;
+  if (!image.GetArray(kReadingCorrectionSection,
+                      &corrections, &reading_corrections_size_)) {
+    LOG(ERROR) << "Broken reading correction data";
+    return false;
+  }
+  reading_corrections_.reset(
+      new ReadingCorrectionItem[reading_corrections_size_]);
+  for (size_t i = 0; i < reading_corrections_size_; ++i) {
+    reading_corrections_[i].value = image.GetString(corrections[i].value);
+    reading_corrections_[i].error = image.GetString(corrections[i].error);
+    reading_corrections_[i].correction =
+        image.GetString(corrections[i].correction);
+  }
+
+  // Segmenter.
+  const uint32 *segmenter_sizes = NULL;
+  size_t segmenter_sizes_size = 0;
+  size_t lid_table_size = 0;
+  size_t rid_table_size = 0;
+  if (!image.GetArray(kSegmenterSizeSection,
+                      &segmenter_sizes, &segmenter_sizes_size) ||
+      segmenter_sizes_size != 2 ||
+      !image.GetArray(kSegmenterLidTableSection,
+                      &compressed_lid_table_, &lid_table_size) ||
+      !image.GetArray(kSegmenterRidTableSection,
+                      &compressed_rid_table_, &rid_table_size)) {
+    LOG(ERROR) << "Broken segmenter data";
+    return false;
+  }
+  compressed_l_size_ = segmenter_sizes[0];
+  compressed_r_size_ = segmenter_sizes[1];
+  segmenter_bit_array_data_ = image.GetSection(kSegmenterBitArraySection);
+
+  suggestion_filter_data_ = image.GetSection(kSuggestionFilterSection);
+  connection_data_ = image.GetSection(kConnectionSection);
+  dictionary_data_ = image.GetSection(kDictionarySection);
+  collocation_data_ = image.GetSection(kCollocationSection);
+  collocation_suppression_data_ =
+      image.GetSection(kCollocationSuppressionSection);
+
+  // Symbol dictionary.  Both arrays have a sentinel at the end.
+  const SymbolTokenRecord *symbol_tokens = NULL;
+  const SymbolValueRecord *symbol_values = NULL;
+  size_t symbol_values_size = 0;
+  if (!image.GetArray(kSymbolTokenSection,
+                      &symbol_tokens, &symbol_data_token_size_) ||
+      !image.GetArray(kSymbolValueSection,
+                      &symbol_values, &symbol_values_size)) {
+    LOG(ERROR) << "Broken symbol dictionary data";
+    return false;
+  }
+  symbol_data_values_.reset(
+      new EmbeddedDictionary::Value[symbol_values_size + 1]);
+  for (size_t i = 0; i < symbol_values_size; ++i) {
+    EmbeddedDictionary::Value *value = &symbol_data_values_[i];
+    value->value = image.GetString(symbol_values[i].value);
+    value->description = image.GetString(symbol_values[i].description);
+    value->additional_description =
+        image.GetString(symbol_values[i].additional_description);
+    value->lid = symbol_values[i].lid;
+    value->rid = symbol_values[i].rid;
+    value->cost = symbol_values[i].cost;
+  }
+  EmbeddedDictionary::Value *last_value =
+      &symbol_data_values_[symbol_values_size];
+  last_value->value = NULL;
+  last_value->description = NULL;
+  last_value->additional_description = NULL;
+  last_value->lid = 0;
+  last_value->rid = 0;
+  last_value->cost = 0;
+  symbol_data_tokens_.reset(
+      new EmbeddedDictionary::Token[symbol_data_token_size_ + 1]);
+  for (size_t i = 0; i < symbol_data_token_size_; ++i) {
+    const SymbolTokenRecord &record = symbol_tokens[i];
+    if (record.value_begin > symbol_values_size ||
+        record.value_size > symbol_values_size - record.value_begin) {
+      LOG(ERROR) << "Broken symbol dictionary data";
+      return false;
+    }
+    symbol_data_tokens_[i].key = image.GetString(record.key);
+    symbol_data_tokens_[i].value = &symbol_data_values_[record.value_begin];
+    symbol_data_tokens_[i].value_size = record.value_size;
+  }
+  symbol_data_tokens_[symbol_data_token_size_].key = NULL;
+  symbol_data_tokens_[symbol_data_token_size_].value =
+      symbol_data_values_.get();
+  symbol_data_tokens_[symbol_data_token_size_].value_size =
+      symbol_values_size;
+
+#ifndef NO_USAGE_REWRITER
+  // Usage rewriter.
+  const ConjugationSuffixRecord *base_suffixes = NULL;
+  size_t conjugation_num = 0;
+  const ConjugationSuffixRecord *suffixes = NULL;
+  size_t suffixes_size = 0;
+  size_t suffix_index_size = 0;
+  const UsageItemRecord *usage_items = NULL;
+  size_t usage_items_size = 0;
+  if (!image.GetArray(kUsageBaseSuffixSection,
+                      &base_suffixes, &conjugation_num) ||
+      !image.GetArray(kUsageSuffixSection, &suffixes, &suffixes_size) ||
+      !image.GetArray(kUsageSuffixIndexSection,
+                      &conjugation_suffix_data_index_, &suffix_index_size) ||
+      suffix_index_size != conjugation_num + 1 ||
+      !image.GetArray(kUsageItemSection, &usage_items, &usage_items_size)) {
+    LOG(ERROR) << "Broken usage rewriter data";
+    return false;
+  }
+  base_conjugation_suffix_.reset(new ConjugationSuffix[conjugation_num]);
+  for (size_t i = 0; i < conjugation_num; ++i) {
+    base_conjugation_suffix_[i].value_suffix =
+        image.GetString(base_suffixes[i].value_suffix);
+    base_conjugation_suffix_[i].key_suffix =
+        image.GetString(base_suffixes[i].key_suffix);
+  }
+  conjugation_suffix_data_.reset(new ConjugationSuffix[suffixes_size]);
+  for (size_t i = 0; i < suffixes_size; ++i) {
+    conjugation_suffix_data_[i].value_suffix =
+        image.GetString(suffixes[i].value_suffix);
+    conjugation_suffix_data_[i].key_suffix =
+        image.GetString(suffixes[i].key_suffix);
+  }
+  usage_data_value_.reset(new UsageDictItem[usage_items_size + 1]);
+  for (size_t i = 0; i < usage_items_size; ++i) {
+    usage_data_value_[i].id = usage_items[i].id;
+    usage_data_value_[i].key = image.GetString(usage_items[i].key);
+    usage_data_value_[i].value = image.GetString(usage_items[i].value);
+    usage_data_value_[i].conjugation_id = usage_items[i].conjugation_id;
+    usage_data_value_[i].meaning = image.GetString(usage_items[i].meaning);
+  }
+  UsageDictItem *last_item = &usage_data_value_[usage_items_size];
+  last_item->id = 0;
+  last_item->key = NULL;
+  last_item->value = NULL;
+  last_item->conjugation_id = 0;
+  last_item->meaning = NULL;
+#endif  // NO_USAGE_REWRITER
+
+  // Counter suffixes.
+  const CounterSuffixRecord *counter_suffixes = NULL;
+  if (!image.GetArray(kCounterSuffixSection,
+                      &counter_suffixes, &counter_suffix_size_)) {
+    LOG(ERROR) << "Broken counter suffix data";
+    return false;
+  }
+  if (counter_suffix_size_ > 0) {
+    counter_suffix_data_.reset(new CounterSuffixEntry[counter_suffix_size_]);
+    for (size_t i = 0; i < counter_suffix_size_; ++i) {
+      counter_suffix_data_[i].suffix =
+          image.GetString(counter_suffixes[i].suffix);
+      counter_suffix_data_[i].size = counter_suffixes[i].size;
+    }
+  }
   return true;
 }
 
@@ -493,15 +855,14 @@ const POSMatcher *PackedDataManager::Impl::GetPOSMatcher() const {
 }
 
 const uint8 *PackedDataManager::Impl::GetPosGroupData() const {
-  return reinterpret_cast<const uint8 *>(
-      system_dictionary_data_->lid_group_data().data());
+  return reinterpret_cast<const uint8 *>(lid_group_data_.data());
 }
 
 void PackedDataManager::Impl::GetConnectorData(
     const char **data,
     size_t *size) const {
-  *data = system_dictionary_data_->connection_data().data();
-  *size = system_dictionary_data_->connection_data().size();
+  *data = connection_data_.data();
+  *size = connection_data_.size();
 }
 
 void PackedDataManager::Impl::GetSegmenterData(
@@ -511,55 +872,53 @@ void PackedDataManager::Impl::GetSegmenterData(
     const BoundaryData **boundary_data) const {
   *l_num_elements = compressed_l_size_;
   *r_num_elements = compressed_r_size_;
-  *l_table = compressed_lid_table_.get();
-  *r_table = compressed_rid_table_.get();
-  *bitarray_num_bytes =
-      system_dictionary_data_->segmenter_data().bit_array_data().size();
-  *bitarray_data =
-      system_dictionary_data_->segmenter_data().bit_array_data().data();
-  *boundary_data = boundary_data_.get();
+  *l_table = compressed_lid_table_;
+  *r_table = compressed_rid_table_;
+  *bitarray_num_bytes = segmenter_bit_array_data_.size();
+  *bitarray_data = segmenter_bit_array_data_.data();
+  *boundary_data = boundary_data_;
 }
 
 void PackedDataManager::Impl::GetSystemDictionaryData(
     const char **data,
     int *size) const {
-  *data = system_dictionary_data_->dictionary_data().data();
-  *size = system_dictionary_data_->dictionary_data().size();
+  *data = dictionary_data_.data();
+  *size = dictionary_data_.size();
 }
 
 void PackedDataManager::Impl::GetSuffixDictionaryData(
     const SuffixToken **data,
     size_t *size) const {
   *data = suffix_tokens_.get();
-  *size = system_dictionary_data_->suffix_tokens().size();
+  *size = suffix_tokens_size_;
 }
 
 void PackedDataManager::Impl::GetReadingCorrectionData(
     const ReadingCorrectionItem **array,
     size_t *size) const {
   *array = reading_corrections_.get();
-  *size = system_dictionary_data_->reading_corrections().size();
+  *size = reading_corrections_size_;
 }
 
 void PackedDataManager::Impl::GetCollocationData(
   const char **array,
   size_t *size) const {
-  *array = system_dictionary_data_->collocation_data().data();
-  *size = system_dictionary_data_->collocation_data().size();
+  *array = collocation_data_.data();
+  *size = collocation_data_.size();
 }
 
 void PackedDataManager::Impl::GetCollocationSuppressionData(
     const char **array,
     size_t *size) const {
-  *array = system_dictionary_data_->collocation_suppression_data().data();
-  *size = system_dictionary_data_->collocation_suppression_data().size();
+  *array = collocation_suppression_data_.data();
+  *size = collocation_suppression_data_.size();
 }
 
 void PackedDataManager::Impl::GetSuggestionFilterData(
     const char **data,
     size_t *size) const {
-  *data = system_dictionary_data_->suggestion_filter_data().data();
-  *size = system_dictionary_data_->suggestion_filter_data().size();
+  *data = suggestion_filter_data_.data();
+  *size = suggestion_filter_data_.size();
 }
 
 void PackedDataManager::Impl::GetSymbolRewriterData(
@@ -577,13 +936,13 @@ void PackedDataManager::Impl::GetUsageRewriterData(
     const UsageDictItem **usage_data_value) const {
   *base_conjugation_suffix = base_conjugation_suffix_.get();
   *conjugation_suffix_data = conjugation_suffix_data_.get();
-  *conjugation_suffix_data_index = conjugation_suffix_data_index_.get();
+  *conjugation_suffix_data_index = conjugation_suffix_data_index_;
   *usage_data_value = usage_data_value_.get();
 }
 #endif  // NO_USAGE_REWRITER
 
 const uint16 *PackedDataManager::Impl::GetRuleIdTableForTest() const {
-  return rule_id_table_.get();
+  return rule_id_table_;
 }
 
 const void *PackedDataManager::Impl::GetRangeTablesForTest() const {
@@ -593,7 +952,7 @@ const void *PackedDataManager::Impl::GetRangeTablesForTest() const {
 void PackedDataManager::Impl::GetCounterSuffixSortedArray(
     const CounterSuffixEntry **array, size_t *size) const {
   *array = counter_suffix_data_.get();
-  *size = system_dictionary_data_->counter_suffix_data_size();
+  *size = counter_suffix_size_;
 }
 
 
@@ -624,6 +983,26 @@ bool PackedDataManager::InitWithZippedData(
   return false;
 }
 
+bool PackedDataManager::InitWithImage(const char *image, size_t size) {
+  manager_impl_.reset(new Impl());
+  if (manager_impl_->InitWithImage(image, size)) {
+    return true;
+  }
+  LOG(ERROR) << "PackedDataManager initialization error";
+  manager_impl_.reset();
+  return false;
+}
+
+bool PackedDataManager::InitWithMmap(const string &filename) {
+  manager_impl_.reset(new Impl());
+  if (manager_impl_->InitWithMmap(filename)) {
+    return true;
+  }
+  LOG(ERROR) << "PackedDataManager initialization error";
+  manager_impl_.reset();
+  return false;
+}
+
 string PackedDataManager::GetDictionaryVersion() {
   return manager_impl_->GetDictionaryVersion();
 }
@@ -640,13 +1019,7 @@ PackedDataManager *PackedDataManager::GetUserPosManager() {
       LOG(FATAL) << "PackedDataManager::GetUserPosManager ERROR!";
     } else {
       unique_ptr<PackedDataManager> data_manager(new PackedDataManager);
-      string buffer;
-      {
-        Mmap mmap;
-        CHECK(mmap.Open(FLAGS_dataset.c_str(), "r"));
-        buffer.assign(mmap.begin(), mmap.size());
-      }
-      if (data_manager->Init(buffer)) {
+      if (data_manager->InitWithMmap(FLAGS_dataset)) {
         RegisterPackedDataManager(data_manager.release());
       }
     }
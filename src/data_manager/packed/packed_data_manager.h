@@ -41,10 +41,18 @@ class PackedDataManager : public DataManagerInterface {
  public:
   PackedDataManager();
   virtual ~PackedDataManager();
-  // Initializes the PackedDataManager with packed system dictionary data.
-  // Returns false if initialization fails.
+  // Initializes the PackedDataManager with packed system dictionary data,
+  // which is either serialized SystemDictionaryData or a packed data image
+  // (see packed_data_image.h).  Returns false if initialization fails.
   bool Init(const string &system_dictionary_data);
   bool InitWithZippedData(const string &zipped_system_dictionary_data);
+  // Initializes with a packed data image without copying it.  |image| must
+  // be aligned to kPackedDataImageAlignment and outlive this object.
+  bool InitWithImage(const char *image, size_t size);
+  // Maps |filename| into memory.  A packed data image is used in place, so
+  // no heap copy of the dictionary is made and the mapped pages are shared
+  // among processes.
+  bool InitWithMmap(const string &filename);
   string GetDictionaryVersion();
 
   static PackedDataManager *GetUserPosManager();
@@ -43,9 +43,21 @@
       ],
       'dependencies': [
         '../../base/base.gyp:base',
+        'packed_data_image',
         'system_dictionary_data_protocol',
       ],
     },
+    {
+      'target_name': 'packed_data_image',
+      'type': 'static_library',
+      'toolsets': [ 'host', 'target' ],
+      'sources': [
+        'packed_data_image.cc',
+      ],
+      'dependencies': [
+        '../../base/base.gyp:base',
+      ],
+    },
     {
       'target_name': 'system_dictionary_data_protocol',
       'type': 'static_library',
@@ -82,6 +94,7 @@
         'system_dictionary_format_version.h',
       ],
       'dependencies': [
+        'packed_data_image',
         'system_dictionary_data_protocol',
         '../../base/base.gyp:base',
         '../../dictionary/dictionary_base.gyp:pos_matcher',
@@ -30,6 +30,7 @@
 #include "data_manager/packed/system_dictionary_data_packer.h"
 
 #include <string>
+#include <vector>
 
 #include "base/codegen_bytearray_stream.h"
 #include "base/file_stream.h"
@@ -38,6 +39,7 @@
 #include "base/logging.h"
 #include "base/version.h"
 #include "converter/boundary_struct.h"
+#include "data_manager/packed/packed_data_image.h"
 #include "data_manager/packed/system_dictionary_data.pb.h"
 #include "data_manager/packed/system_dictionary_format_version.h"
 #include "dictionary/suffix_dictionary_token.h"
@@ -369,5 +371,252 @@ bool SystemDictionaryDataPacker::OutputHeader(
   return true;
 }
 
+bool SystemDictionaryDataPacker::OutputImage(const string &file_path) {
+  string image;
+  SerializeToImage(&image);
+  OutputFileStream output(file_path.c_str(),
+                          ios::out | ios::binary | ios::trunc);
+  output.write(image.data(), image.size());
+  if (!output) {
+    LOG(ERROR) << "Failed to write data to " << file_path;
+    return false;
+  }
+  return true;
+}
+
+void SystemDictionaryDataPacker::SerializeToImage(string *output) const {
+  const SystemDictionaryData &data = *system_dictionary_;
+  PackedDataImageBuilder builder(data.format_version());
+  builder.SetSection(kProductVersionSection, data.product_version().data(),
+                     data.product_version().size());
+
+  // POS tokens.
+  {
+    vector<PosTokenRecord> tokens;
+    vector<ConjugationFormRecord> forms;
+    for (size_t i = 0; i < data.pos_tokens_size(); ++i) {
+      const SystemDictionaryData::PosToken &pos_token = data.pos_tokens(i);
+      PosTokenRecord token;
+      token.pos = pos_token.has_pos() ?
+          builder.AddString(pos_token.pos()) : kPackedDataImageNullString;
+      token.conjugation_begin = forms.size();
+      token.conjugation_size = pos_token.conjugation_forms_size();
+      tokens.push_back(token);
+      for (size_t j = 0; j < pos_token.conjugation_forms_size(); ++j) {
+        const SystemDictionaryData::PosToken::ConjugationType &conjugation =
+            pos_token.conjugation_forms(j);
+        ConjugationFormRecord form;
+        form.key_suffix = conjugation.has_key_suffix() ?
+            builder.AddString(conjugation.key_suffix()) :
+            kPackedDataImageNullString;
+        form.value_suffix = conjugation.has_value_suffix() ?
+            builder.AddString(conjugation.value_suffix()) :
+            kPackedDataImageNullString;
+        form.id = conjugation.id();
+        forms.push_back(form);
+      }
+    }
+    builder.SetArraySection(kPosTokenSection, tokens);
+    builder.SetArraySection(kConjugationFormSection, forms);
+  }
+
+  // POS matcher.
+  {
+    const SystemDictionaryData::PosMatcherData &pos_matcher =
+        data.pos_matcher_data();
+    vector<uint16> rule_id_table(pos_matcher.rule_id_table().begin(),
+                                 pos_matcher.rule_id_table().end());
+    builder.SetArraySection(kRuleIdTableSection, rule_id_table);
+    vector<uint32> range_table_index;
+    vector<RangeRecord> range_items;
+    for (size_t i = 0; i < pos_matcher.range_tables_size(); ++i) {
+      const SystemDictionaryData::PosMatcherData::RangeTable &table =
+          pos_matcher.range_tables(i);
+      range_table_index.push_back(range_items.size());
+      for (size_t j = 0; j < table.ranges_size(); ++j) {
+        RangeRecord range;
+        range.lower = table.ranges(j).lower();
+        range.upper = table.ranges(j).upper();
+        range_items.push_back(range);
+      }
+      RangeRecord terminator;
+      terminator.lower = static_cast<uint16>(0xFFFF);
+      terminator.upper = static_cast<uint16>(0xFFFF);
+      range_items.push_back(terminator);
+    }
+    builder.SetArraySection(kRangeTableIndexSection, range_table_index);
+    builder.SetArraySection(kRangeTableItemSection, range_items);
+  }
+
+  builder.SetSection(kLidGroupSection, data.lid_group_data().data(),
+                     data.lid_group_data().size());
+
+  {
+    vector<BoundaryData> boundary_data(data.boundary_data_size());
+    for (size_t i = 0; i < data.boundary_data_size(); ++i) {
+      boundary_data[i].prefix_penalty = data.boundary_data(i).prefix_penalty();
+      boundary_data[i].suffix_penalty = data.boundary_data(i).suffix_penalty();
+    }
+    builder.SetArraySection(kBoundaryDataSection, boundary_data);
+  }
+
+  {
+    vector<SuffixTokenRecord> suffix_tokens(data.suffix_tokens_size());
+    for (size_t i = 0; i < data.suffix_tokens_size(); ++i) {
+      const SystemDictionaryData::SuffixToken &token = data.suffix_tokens(i);
+      suffix_tokens[i].key = token.has_key() ?
+          builder.AddString(token.key()) : kPackedDataImageNullString;
+      suffix_tokens[i].value = token.has_value() ?
+          builder.AddString(token.value()) : kPackedDataImageNullString;
+      suffix_tokens[i].lid = token.lid();
+      suffix_tokens[i].rid = token.rid();
+      suffix_tokens[i].wcost = token.wcost();
+      suffix_tokens[i].padding = 0;
+    }
+    builder.SetArraySection(kSuffixTokenSection, suffix_tokens);
+  }
+
+  {
+    vector<ReadingCorrectionRecord> corrections(
+        data.reading_corrections_size());
+    for (size_t i = 0; i < data.reading_corrections_size(); ++i) {
+      const SystemDictionaryData::ReadingCorrectionItem &item =
+          data.reading_corrections(i);
+      corrections[i].value = item.has_value() ?
+          builder.AddString(item.value()) : kPackedDataImageNullString;
+      corrections[i].error = item.has_error() ?
+          builder.AddString(item.error()) : kPackedDataImageNullString;
+      corrections[i].correction = item.has_correction() ?
+          builder.AddString(item.correction()) : kPackedDataImageNullString;
+    }
+    builder.SetArraySection(kReadingCorrectionSection, corrections);
+  }
+
+  {
+    const SystemDictionaryData::SegmenterData &segmenter =
+        data.segmenter_data();
+    vector<uint32> sizes;
+    sizes.push_back(segmenter.compressed_l_size());
+    sizes.push_back(segmenter.compressed_r_size());
+    builder.SetArraySection(kSegmenterSizeSection, sizes);
+    vector<uint16> lid_table(segmenter.compressed_lid_table().begin(),
+                             segmenter.compressed_lid_table().end());
+    builder.SetArraySection(kSegmenterLidTableSection, lid_table);
+    vector<uint16> rid_table(segmenter.compressed_rid_table().begin(),
+                             segmenter.compressed_rid_table().end());
+    builder.SetArraySection(kSegmenterRidTableSection, rid_table);
+    builder.SetSection(kSegmenterBitArraySection,
+                       segmenter.bit_array_data().data(),
+                       segmenter.bit_array_data().size());
+  }
+
+  builder.SetSection(kSuggestionFilterSection,
+                     data.suggestion_filter_data().data(),
+                     data.suggestion_filter_data().size());
+  builder.SetSection(kConnectionSection, data.connection_data().data(),
+                     data.connection_data().size());
+  builder.SetSection(kDictionarySection, data.dictionary_data().data(),
+                     data.dictionary_data().size());
+  builder.SetSection(kCollocationSection, data.collocation_data().data(),
+                     data.collocation_data().size());
+  builder.SetSection(kCollocationSuppressionSection,
+                     data.collocation_suppression_data().data(),
+                     data.collocation_suppression_data().size());
+
+  // Symbol dictionary.
+  {
+    const SystemDictionaryData::EmbeddedDictionary &symbol_dictionary =
+        data.symbol_dictionary();
+    vector<SymbolTokenRecord> tokens;
+    vector<SymbolValueRecord> values;
+    for (size_t i = 0; i < symbol_dictionary.tokens_size(); ++i) {
+      const SystemDictionaryData::EmbeddedDictionary::Token &token =
+          symbol_dictionary.tokens(i);
+      SymbolTokenRecord token_record;
+      token_record.key = builder.AddString(token.key());
+      token_record.value_begin = values.size();
+      token_record.value_size = token.values_size();
+      tokens.push_back(token_record);
+      for (size_t j = 0; j < token.values_size(); ++j) {
+        const SystemDictionaryData::EmbeddedDictionary::Value &value =
+            token.values(j);
+        SymbolValueRecord value_record;
+        value_record.value = value.has_value() ?
+            builder.AddString(value.value()) : kPackedDataImageNullString;
+        value_record.description = value.has_description() ?
+            builder.AddString(value.description()) :
+            kPackedDataImageNullString;
+        value_record.additional_description =
+            value.has_additional_description() ?
+            builder.AddString(value.additional_description()) :
+            kPackedDataImageNullString;
+        value_record.lid = value.lid();
+        value_record.rid = value.rid();
+        value_record.cost = value.cost();
+        value_record.padding = 0;
+        values.push_back(value_record);
+      }
+    }
+    builder.SetArraySection(kSymbolTokenSection, tokens);
+    builder.SetArraySection(kSymbolValueSection, values);
+  }
+
+  // Usage rewriter.  The sections are left empty when the data is not set.
+  {
+    const SystemDictionaryData::UsageRewriterData &usage =
+        data.usage_rewriter_data();
+    vector<ConjugationSuffixRecord> base_suffixes;
+    vector<ConjugationSuffixRecord> suffixes;
+    vector<int32> suffix_index;
+    suffix_index.push_back(0);
+    for (size_t i = 0; i < usage.conjugations_size(); ++i) {
+      const SystemDictionaryData::UsageRewriterData::Conjugation &conjugation =
+          usage.conjugations(i);
+      ConjugationSuffixRecord base_suffix;
+      base_suffix.value_suffix =
+          builder.AddString(conjugation.base_suffix().value_suffix());
+      base_suffix.key_suffix =
+          builder.AddString(conjugation.base_suffix().key_suffix());
+      base_suffixes.push_back(base_suffix);
+      for (size_t j = 0; j < conjugation.conjugation_suffixes_size(); ++j) {
+        ConjugationSuffixRecord suffix;
+        suffix.value_suffix = builder.AddString(
+            conjugation.conjugation_suffixes(j).value_suffix());
+        suffix.key_suffix = builder.AddString(
+            conjugation.conjugation_suffixes(j).key_suffix());
+        suffixes.push_back(suffix);
+      }
+      suffix_index.push_back(suffixes.size());
+    }
+    vector<UsageItemRecord> items(usage.usage_data_values_size());
+    for (size_t i = 0; i < usage.usage_data_values_size(); ++i) {
+      const SystemDictionaryData::UsageRewriterData::UsageDictItem &item =
+          usage.usage_data_values(i);
+      items[i].id = item.id();
+      items[i].key = builder.AddString(item.key());
+      items[i].value = builder.AddString(item.value());
+      items[i].conjugation_id = item.conjugation_id();
+      items[i].meaning = builder.AddString(item.meaning());
+    }
+    builder.SetArraySection(kUsageBaseSuffixSection, base_suffixes);
+    builder.SetArraySection(kUsageSuffixSection, suffixes);
+    builder.SetArraySection(kUsageSuffixIndexSection, suffix_index);
+    builder.SetArraySection(kUsageItemSection, items);
+  }
+
+  {
+    vector<CounterSuffixRecord> counter_suffixes(
+        data.counter_suffix_data_size());
+    for (size_t i = 0; i < data.counter_suffix_data_size(); ++i) {
+      counter_suffixes[i].suffix =
+          builder.AddString(data.counter_suffix_data(i));
+      counter_suffixes[i].size = data.counter_suffix_data(i).size();
+    }
+    builder.SetArraySection(kCounterSuffixSection, counter_suffixes);
+  }
+
+  builder.Serialize(output);
+}
+
 }  // namespace packed
 }  // namespace mozc
@@ -117,6 +117,11 @@ class SystemDictionaryDataPacker {
   bool Output(const string &file_path, bool use_gzip);
   bool OutputHeader(const string &file_path, bool use_gzip);
 
+  // Outputs the data as a packed data image (see packed_data_image.h), which
+  // PackedDataManager can use in place without parsing.
+  bool OutputImage(const string &file_path);
+  void SerializeToImage(string *output) const;
+
  private:
   scoped_ptr<SystemDictionaryData> system_dictionary_;
 
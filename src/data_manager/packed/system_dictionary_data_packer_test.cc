@@ -0,0 +1,259 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "data_manager/packed/system_dictionary_data_packer.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/mmap.h"
+#include "base/port.h"
+#include "converter/boundary_struct.h"
+#include "data_manager/packed/packed_data_manager.h"
+#include "dictionary/suffix_dictionary_token.h"
+#include "dictionary/user_pos.h"
+#include "rewriter/correction_rewriter.h"
+#include "rewriter/counter_suffix.h"
+#include "rewriter/embedded_dictionary.h"
+#include "testing/base/public/googletest.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace packed {
+namespace {
+
+const UserPOS::ConjugationType kConjugations[] = {
+  {"", "", 10},
+  {"\xE3\x81\x8B", "\xE3\x81\x8B", 11},  // "か"
+  {NULL, "\xE3\x81\x8D", 12},            // "き"
+};
+
+const UserPOS::POSToken kPOSTokens[] = {
+  {"\xE5\x90\x8D\xE8\xA9\x9E", 1, kConjugations},  // "名詞"
+  {"\xE5\x8B\x95\xE8\xA9\x9E", 2, kConjugations + 1},  // "動詞"
+  {NULL, 0, NULL},
+};
+
+const uint16 kRuleIdTable[] = {1, 2, 3};
+const POSMatcher::Range kRangeTable0[] = {
+  {1, 5}, {7, 9}, {0xFFFF, 0xFFFF},
+};
+const POSMatcher::Range kRangeTable1[] = {
+  {0xFFFF, 0xFFFF},
+};
+const POSMatcher::Range *const kRangeTables[] = {
+  kRangeTable0, kRangeTable1,
+};
+
+const uint8 kLidGroup[] = {0, 1, 1, 2};
+const BoundaryData kBoundaryData[] = {{1, 2}, {3, 4}};
+const SuffixToken kSuffixTokens[] = {
+  {"key", "value", 1, 2, 300},
+  {"key", NULL, 3, 4, -5},
+};
+const ReadingCorrectionItem kReadingCorrections[] = {
+  {"value", "error", "correction"},
+};
+const uint16 kLidTable[] = {0, 1, 1};
+const uint16 kRidTable[] = {0, 0, 1, 1};
+const char kBitArray[] = "\x01\x02\x03";
+
+const EmbeddedDictionary::Value kSymbolValues[] = {
+  {"a", "description", NULL, 1, 2, 3},
+  {"b", NULL, "additional", 4, 5, 6},
+  {"c", NULL, NULL, 7, 8, 9},
+};
+const EmbeddedDictionary::Token kSymbolTokens[] = {
+  {"x", kSymbolValues, 2},
+  {"y", kSymbolValues + 2, 1},
+};
+
+const CounterSuffixEntry kCounterSuffixes[] = {
+  {"ab", 2}, {"cde", 3},
+};
+
+class SystemDictionaryDataPackerTest : public ::testing::Test {
+ protected:
+  void SetUpPacker(SystemDictionaryDataPacker *packer) {
+    packer->SetPosTokens(kPOSTokens, arraysize(kPOSTokens));
+    packer->SetPosMatcherData(kRuleIdTable, arraysize(kRuleIdTable),
+                              kRangeTables, arraysize(kRangeTables));
+    packer->SetLidGroupData(kLidGroup, arraysize(kLidGroup));
+    packer->SetBoundaryData(kBoundaryData, arraysize(kBoundaryData));
+    packer->SetSuffixTokens(kSuffixTokens, arraysize(kSuffixTokens));
+    packer->SetReadingCorretions(kReadingCorrections,
+                                 arraysize(kReadingCorrections));
+    packer->SetSegmenterData(3, 4,
+                             kLidTable, arraysize(kLidTable),
+                             kRidTable, arraysize(kRidTable),
+                             kBitArray, 3);
+    packer->SetSuggestionFilterData("filter", 6);
+    packer->SetConnectionData("connection", 10);
+    packer->SetDictionaryData("dictionary", 10);
+    packer->SetCollocationData("collocation", 11);
+    packer->SetCollocationSuppressionData("suppression", 11);
+    packer->SetSymbolRewriterData(kSymbolTokens, arraysize(kSymbolTokens));
+    packer->SetCounterSuffixSortedArray(kCounterSuffixes,
+                                        arraysize(kCounterSuffixes));
+  }
+
+  // Checks that |manager| returns the data given in SetUpPacker().
+  void ExpectData(const PackedDataManager &manager) {
+    const UserPOS::POSToken *pos_tokens = manager.GetUserPOSData();
+    ASSERT_TRUE(pos_tokens != NULL);
+    EXPECT_STREQ(kPOSTokens[0].pos, pos_tokens[0].pos);
+    EXPECT_EQ(1, pos_tokens[0].conjugation_size);
+    EXPECT_EQ(10, pos_tokens[0].conjugation_form[0].id);
+    EXPECT_STREQ(kPOSTokens[1].pos, pos_tokens[1].pos);
+    ASSERT_EQ(2, pos_tokens[1].conjugation_size);
+    EXPECT_STREQ("\xE3\x81\x8B", pos_tokens[1].conjugation_form[0].key_suffix);
+    EXPECT_TRUE(pos_tokens[1].conjugation_form[1].key_suffix == NULL);
+    EXPECT_STREQ("\xE3\x81\x8D",
+                 pos_tokens[1].conjugation_form[1].value_suffix);
+    EXPECT_EQ(12, pos_tokens[1].conjugation_form[1].id);
+    EXPECT_TRUE(pos_tokens[2].pos == NULL);
+
+    EXPECT_TRUE(manager.GetPOSMatcher() != NULL);
+    EXPECT_EQ(2, manager.GetPosGroupData()[3]);
+
+    size_t l_size = 0, r_size = 0, bitarray_size = 0;
+    const uint16 *l_table = NULL, *r_table = NULL;
+    const char *bitarray = NULL;
+    const BoundaryData *boundary_data = NULL;
+    manager.GetSegmenterData(&l_size, &r_size, &l_table, &r_table,
+                             &bitarray_size, &bitarray, &boundary_data);
+    EXPECT_EQ(3, l_size);
+    EXPECT_EQ(4, r_size);
+    EXPECT_EQ(1, l_table[2]);
+    EXPECT_EQ(1, r_table[3]);
+    EXPECT_EQ(string(kBitArray, 3), string(bitarray, bitarray_size));
+    EXPECT_EQ(4, boundary_data[1].suffix_penalty);
+
+    const SuffixToken *suffix_tokens = NULL;
+    size_t size = 0;
+    manager.GetSuffixDictionaryData(&suffix_tokens, &size);
+    ASSERT_EQ(2, size);
+    EXPECT_STREQ("value", suffix_tokens[0].value);
+    EXPECT_EQ(300, suffix_tokens[0].wcost);
+    EXPECT_STREQ("key", suffix_tokens[1].key);
+    EXPECT_TRUE(suffix_tokens[1].value == NULL);
+    EXPECT_EQ(-5, suffix_tokens[1].wcost);
+
+    const ReadingCorrectionItem *corrections = NULL;
+    manager.GetReadingCorrectionData(&corrections, &size);
+    ASSERT_EQ(1, size);
+    EXPECT_STREQ("correction", corrections[0].correction);
+
+    const char *data = NULL;
+    manager.GetConnectorData(&data, &size);
+    EXPECT_EQ("connection", string(data, size));
+    manager.GetCollocationData(&data, &size);
+    EXPECT_EQ("collocation", string(data, size));
+    manager.GetCollocationSuppressionData(&data, &size);
+    EXPECT_EQ("suppression", string(data, size));
+    manager.GetSuggestionFilterData(&data, &size);
+    EXPECT_EQ("filter", string(data, size));
+    int dictionary_size = 0;
+    manager.GetSystemDictionaryData(&data, &dictionary_size);
+    EXPECT_EQ("dictionary", string(data, dictionary_size));
+
+    const EmbeddedDictionary::Token *symbol_tokens = NULL;
+    manager.GetSymbolRewriterData(&symbol_tokens, &size);
+    ASSERT_EQ(2, size);
+    EXPECT_STREQ("x", symbol_tokens[0].key);
+    ASSERT_EQ(2, symbol_tokens[0].value_size);
+    EXPECT_STREQ("description", symbol_tokens[0].value[0].description);
+    EXPECT_STREQ("additional",
+                 symbol_tokens[0].value[1].additional_description);
+    EXPECT_EQ(9, symbol_tokens[1].value[0].cost);
+    // Sentinel.
+    EXPECT_TRUE(symbol_tokens[2].key == NULL);
+    EXPECT_EQ(3, symbol_tokens[2].value_size);
+
+    const CounterSuffixEntry *counter_suffixes = NULL;
+    manager.GetCounterSuffixSortedArray(&counter_suffixes, &size);
+    ASSERT_EQ(2, size);
+    EXPECT_EQ("cde", string(counter_suffixes[1].suffix,
+                            counter_suffixes[1].size));
+  }
+};
+
+TEST_F(SystemDictionaryDataPackerTest, ProtobufAndImage) {
+  SystemDictionaryDataPacker packer("1.2.3.4");
+  SetUpPacker(&packer);
+
+  const string proto_file =
+      FileUtil::JoinPath(FLAGS_test_tmpdir, "packed_data_proto");
+  const string image_file =
+      FileUtil::JoinPath(FLAGS_test_tmpdir, "packed_data_image");
+  ASSERT_TRUE(packer.Output(proto_file, false));
+  ASSERT_TRUE(packer.OutputImage(image_file));
+
+  {
+    string proto;
+    {
+      Mmap mmap;
+      ASSERT_TRUE(mmap.Open(proto_file.c_str(), "r"));
+      proto.assign(mmap.begin(), mmap.size());
+    }
+    PackedDataManager manager;
+    ASSERT_TRUE(manager.Init(proto));
+    EXPECT_EQ("1.2.3.4", manager.GetDictionaryVersion());
+    ExpectData(manager);
+  }
+  {
+    // Image copied from a string.
+    string image;
+    packer.SerializeToImage(&image);
+    PackedDataManager manager;
+    ASSERT_TRUE(manager.Init(image));
+    image.clear();
+    EXPECT_EQ("1.2.3.4", manager.GetDictionaryVersion());
+    ExpectData(manager);
+  }
+  {
+    // Image used in place.
+    PackedDataManager manager;
+    ASSERT_TRUE(manager.InitWithMmap(image_file));
+    EXPECT_EQ("1.2.3.4", manager.GetDictionaryVersion());
+    ExpectData(manager);
+  }
+  {
+    PackedDataManager manager;
+    ASSERT_TRUE(manager.InitWithMmap(proto_file));
+    ExpectData(manager);
+  }
+
+  FileUtil::Unlink(proto_file);
+  FileUtil::Unlink(image_file);
+}
+
+}  // namespace
+}  // namespace packed
+}  // namespace mozc
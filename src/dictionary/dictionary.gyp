@@ -59,6 +59,7 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
+        '../converter/converter_base.gyp:conversion_request',
       ],
       'xcode_settings' : {
         'SDKROOT': 'iphoneos',
@@ -74,8 +75,8 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
-        '../config/config.gyp:config_handler',
         '../config/config.gyp:config_protocol',
+        '../converter/converter_base.gyp:conversion_request',
         'dictionary_base.gyp:dictionary_protocol',
         'dictionary_base.gyp:pos_matcher',
         'dictionary_base.gyp:suppression_dictionary',
@@ -130,6 +131,7 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
+        '../converter/converter_base.gyp:conversion_request',
       ],
       'xcode_settings' : {
         'SDKROOT': 'iphoneos',
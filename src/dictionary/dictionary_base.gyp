@@ -245,6 +245,7 @@
         '../base/base.gyp:config_file_stream',
         '../config/config.gyp:config_handler',
         '../config/config.gyp:config_protocol',
+        '../converter/converter_base.gyp:conversion_request',
         '../usage_stats/usage_stats_base.gyp:usage_stats',
         'dictionary_protocol',
         'gen_pos_map#host',
@@ -31,12 +31,14 @@
 
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "base/logging.h"
+#include "base/stl_util.h"
 #include "base/string_piece.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
+#include "converter/conversion_request.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
@@ -83,15 +85,13 @@ namespace {
 
 class CallbackWithFilter : public DictionaryInterface::Callback {
  public:
-  CallbackWithFilter(const bool use_spelling_correction,
-                     const bool use_zip_code_conversion,
-                     const bool use_t13n_conversion,
+  CallbackWithFilter(const config::Config &config,
                      const POSMatcher *pos_matcher,
                      const SuppressionDictionary *suppression_dictionary,
                      DictionaryInterface::Callback *callback)
-      : use_spelling_correction_(use_spelling_correction),
-        use_zip_code_conversion_(use_zip_code_conversion),
-        use_t13n_conversion_(use_t13n_conversion),
+      : use_spelling_correction_(config.use_spelling_correction()),
+        use_zip_code_conversion_(config.use_zip_code_conversion()),
+        use_t13n_conversion_(config.use_t13n_conversion()),
         pos_matcher_(pos_matcher),
         suppression_dictionary_(suppression_dictionary),
         callback_(callback) {}
@@ -139,73 +139,107 @@ class CallbackWithFilter : public DictionaryInterface::Callback {
 
 void DictionaryImpl::LookupPredictive(
     StringPiece key,
-    bool use_kana_modifier_insensitive_lookup,
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   CallbackWithFilter callback_with_filter(
-      GET_CONFIG(use_spelling_correction),
-      GET_CONFIG(use_zip_code_conversion),
-      GET_CONFIG(use_t13n_conversion),
+      conversion_request.config(),
       pos_matcher_,
       suppression_dictionary_,
       callback);
   for (size_t i = 0; i < dics_.size(); ++i) {
     dics_[i]->LookupPredictive(
-        key, use_kana_modifier_insensitive_lookup, &callback_with_filter);
+        key, conversion_request, &callback_with_filter);
   }
 }
 
+void DictionaryImpl::LookupPredictiveTopK(
+    StringPiece key,
+    const ConversionRequest &conversion_request,
+    size_t limit,
+    Callback *callback) const {
+  CallbackWithFilter callback_with_filter(
+      conversion_request.config(),
+      pos_matcher_,
+      suppression_dictionary_,
+      callback);
+  for (size_t i = 0; i < dics_.size(); ++i) {
+    dics_[i]->LookupPredictiveTopK(
+        key, conversion_request, limit, &callback_with_filter);
+  }
+}
+
+void DictionaryImpl::LookupPredictiveForKeys(
+    const vector<string> &keys,
+    const ConversionRequest &conversion_request,
+    const vector<Callback *> &callbacks) const {
+  DCHECK_EQ(keys.size(), callbacks.size());
+  vector<Callback *> callbacks_with_filter;
+  callbacks_with_filter.reserve(callbacks.size());
+  for (size_t i = 0; i < callbacks.size(); ++i) {
+    callbacks_with_filter.push_back(new CallbackWithFilter(
+        conversion_request.config(),
+        pos_matcher_,
+        suppression_dictionary_,
+        callbacks[i]));
+  }
+  for (size_t i = 0; i < dics_.size(); ++i) {
+    dics_[i]->LookupPredictiveForKeys(
+        keys, conversion_request, callbacks_with_filter);
+  }
+  STLDeleteElements(&callbacks_with_filter);
+}
+
 void DictionaryImpl::LookupPrefix(
     StringPiece key,
-    bool use_kana_modifier_insensitive_lookup,
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   CallbackWithFilter callback_with_filter(
-      GET_CONFIG(use_spelling_correction),
-      GET_CONFIG(use_zip_code_conversion),
-      GET_CONFIG(use_t13n_conversion),
+      conversion_request.config(),
       pos_matcher_,
       suppression_dictionary_,
       callback);
   for (size_t i = 0; i < dics_.size(); ++i) {
     dics_[i]->LookupPrefix(
-        key, use_kana_modifier_insensitive_lookup, &callback_with_filter);
+        key, conversion_request, &callback_with_filter);
   }
 }
 
-void DictionaryImpl::LookupExact(StringPiece key, Callback *callback) const {
+void DictionaryImpl::LookupExact(StringPiece key,
+                                 const ConversionRequest &conversion_request,
+                                 Callback *callback) const {
   CallbackWithFilter callback_with_filter(
-      GET_CONFIG(use_spelling_correction),
-      GET_CONFIG(use_zip_code_conversion),
-      GET_CONFIG(use_t13n_conversion),
+      conversion_request.config(),
       pos_matcher_,
       suppression_dictionary_,
       callback);
   for (size_t i = 0; i < dics_.size(); ++i) {
-    dics_[i]->LookupExact(key, &callback_with_filter);
+    dics_[i]->LookupExact(key, conversion_request, &callback_with_filter);
   }
 }
 
 void DictionaryImpl::LookupReverse(StringPiece str,
                                    NodeAllocatorInterface *allocator,
+                                   const ConversionRequest &conversion_request,
                                    Callback *callback) const {
   CallbackWithFilter callback_with_filter(
-      GET_CONFIG(use_spelling_correction),
-      GET_CONFIG(use_zip_code_conversion),
-      GET_CONFIG(use_t13n_conversion),
+      conversion_request.config(),
       pos_matcher_,
       suppression_dictionary_,
       callback);
   for (size_t i = 0; i < dics_.size(); ++i) {
-    dics_[i]->LookupReverse(str, allocator, &callback_with_filter);
+    dics_[i]->LookupReverse(str, allocator, conversion_request,
+                            &callback_with_filter);
   }
 }
 
 bool DictionaryImpl::LookupComment(StringPiece key, StringPiece value,
+                                   const ConversionRequest &conversion_request,
                                    string *comment) const {
   // TODO(komatsu): UserDictionary should be treated as the highest priority.
   // In the current implementation, UserDictionary is the last node of dics_,
   // but the only dictionary which may return true.
   for (size_t i = 0; i < dics_.size(); ++i) {
-    if (dics_[i]->LookupComment(key, value, comment)) {
+    if (dics_[i]->LookupComment(key, value, conversion_request, comment)) {
       return true;
     }
   }
@@ -65,18 +65,31 @@ class DictionaryImpl : public DictionaryInterface {
   virtual bool HasValue(StringPiece value) const;
 
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
+
+  virtual void LookupPredictiveTopK(
+      StringPiece key, const ConversionRequest &conversion_request,
+      size_t limit, Callback *callback) const;
+
+  virtual void LookupPredictiveForKeys(
+      const vector<string> &keys, const ConversionRequest &conversion_request,
+      const vector<Callback *> &callbacks) const;
+
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
 
-  virtual void LookupExact(StringPiece key, Callback *callback) const;
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const;
 
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const;
 
   virtual bool LookupComment(StringPiece key, StringPiece value,
+                             const ConversionRequest &conversion_request,
                              string *comment) const;
 
   virtual bool Reload();
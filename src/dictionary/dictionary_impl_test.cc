@@ -37,6 +37,7 @@
 #include "base/util.h"
 #include "config/config.pb.h"
 #include "config/config_handler.h"
+#include "converter/conversion_request.h"
 #include "converter/node_allocator.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_interface.h"
@@ -94,6 +95,7 @@ class DictionaryImplTest : public ::testing::Test {
     config::Config config;
     config::ConfigHandler::GetDefaultConfig(&config);
     config::ConfigHandler::SetConfig(config);
+    convreq_.set_config(config::ConfigHandler::GetConfigSnapshot());
   }
 
   virtual void TearDown() {
@@ -195,9 +197,12 @@ class DictionaryImplTest : public ::testing::Test {
   // Pair of DictionaryInterface's lookup method and query text.
   struct LookupMethodAndQuery {
     void (DictionaryInterface::*lookup_method)(
-        StringPiece, bool, DictionaryInterface::Callback *) const;
+        StringPiece, const ConversionRequest &,
+        DictionaryInterface::Callback *) const;
     const char *query;
   };
+
+  ConversionRequest convreq_;
 };
 
 TEST_F(DictionaryImplTest, WordSuppressionTest) {
@@ -227,7 +232,7 @@ TEST_F(DictionaryImplTest, WordSuppressionTest) {
   s->UnLock();
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckKeyValueExistenceCallback callback(kKey, kValue);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_FALSE(callback.found());
   }
 
@@ -237,7 +242,7 @@ TEST_F(DictionaryImplTest, WordSuppressionTest) {
   s->UnLock();
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckKeyValueExistenceCallback callback(kKey, kValue);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_TRUE(callback.found());
   }
 }
@@ -261,19 +266,19 @@ TEST_F(DictionaryImplTest, DisableSpellingCorrectionTest) {
   // correction flag is set in the config.
   config::Config config;
   config.set_use_spelling_correction(true);
-  config::ConfigHandler::SetConfig(config);
+  convreq_.set_config(config::ConfigSnapshot(config));
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckSpellingExistenceCallback callback(kKey, kValue);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_TRUE(callback.found());
   }
 
   // Without the flag, it should be suppressed.
   config.set_use_spelling_correction(false);
-  config::ConfigHandler::SetConfig(config);;
+  convreq_.set_config(config::ConfigSnapshot(config));
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckSpellingExistenceCallback callback(kKey, kValue);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_FALSE(callback.found());
   }
 }
@@ -296,19 +301,19 @@ TEST_F(DictionaryImplTest, DisableZipCodeConversionTest) {
   // config.
   config::Config config;
   config.set_use_zip_code_conversion(true);
-  config::ConfigHandler::SetConfig(config);
+  convreq_.set_config(config::ConfigSnapshot(config));
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckZipCodeExistenceCallback callback(kKey, kValue, data->pos_matcher);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_TRUE(callback.found());
   }
 
   // Without the flag, it should be suppressed.
   config.set_use_zip_code_conversion(false);
-  config::ConfigHandler::SetConfig(config);;
+  convreq_.set_config(config::ConfigSnapshot(config));
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckZipCodeExistenceCallback callback(kKey, kValue, data->pos_matcher);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_FALSE(callback.found());
   }
 }
@@ -333,19 +338,75 @@ TEST_F(DictionaryImplTest, DisableT13nConversionTest) {
   // config.
   config::Config config;
   config.set_use_t13n_conversion(true);
-  config::ConfigHandler::SetConfig(config);
+  convreq_.set_config(config::ConfigSnapshot(config));
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckEnglishT13nCallback callback(kKey, kValue);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
     EXPECT_TRUE(callback.found());
   }
 
   // Without the flag, it should be suppressed.
   config.set_use_t13n_conversion(false);
-  config::ConfigHandler::SetConfig(config);;
+  convreq_.set_config(config::ConfigSnapshot(config));
   for (size_t i = 0; i < arraysize(kTestPair); ++i) {
     CheckEnglishT13nCallback callback(kKey, kValue);
-    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, false, &callback);
+    (d->*kTestPair[i].lookup_method)(kTestPair[i].query, convreq_, &callback);
+    EXPECT_FALSE(callback.found());
+  }
+}
+
+TEST_F(DictionaryImplTest, PerRequestConfigTest) {
+  scoped_ptr<DictionaryData> data(CreateDictionaryData());
+  DictionaryInterface *d = data->dictionary.get();
+
+  // "あぼがど" -> "アボカド", which is in the test dictionary.
+  const char kKey[] = "\xE3\x81\x82\xE3\x81\xBC\xE3\x81\x8C\xE3\x81\xA9";
+  const char kValue[] = "\xE3\x82\xA2\xE3\x83\x9C\xE3\x82\xAB\xE3\x83\x89";
+
+  // Enable spelling correction in the global config.
+  config::Config global_config;
+  config::ConfigHandler::GetDefaultConfig(&global_config);
+  global_config.set_use_spelling_correction(true);
+  config::ConfigHandler::SetConfig(global_config);
+
+  // A request without its own config takes a snapshot of the global config.
+  const ConversionRequest global_request;
+  {
+    CheckSpellingExistenceCallback callback(kKey, kValue);
+    d->LookupPrefix(kKey, global_request, &callback);
+    EXPECT_TRUE(callback.found());
+  }
+
+  // The config of the request takes precedence over the global one, so two
+  // requests with different configs can share the same dictionary.
+  config::Config request_config;
+  request_config.set_use_spelling_correction(false);
+  ConversionRequest request_with_config;
+  request_with_config.set_config(config::ConfigSnapshot(request_config));
+  {
+    CheckSpellingExistenceCallback callback(kKey, kValue);
+    d->LookupPrefix(kKey, request_with_config, &callback);
+    EXPECT_FALSE(callback.found());
+  }
+  {
+    CheckSpellingExistenceCallback callback(kKey, kValue);
+    d->LookupPrefix(kKey, global_request, &callback);
+    EXPECT_TRUE(callback.found());
+  }
+
+  // Updating the global config doesn't affect the snapshot held by the
+  // request in flight.
+  global_config.set_use_spelling_correction(false);
+  config::ConfigHandler::SetConfig(global_config);
+  {
+    CheckSpellingExistenceCallback callback(kKey, kValue);
+    d->LookupPrefix(kKey, global_request, &callback);
+    EXPECT_TRUE(callback.found());
+  }
+  {
+    const ConversionRequest new_request;
+    CheckSpellingExistenceCallback callback(kKey, kValue);
+    d->LookupPrefix(kKey, new_request, &callback);
     EXPECT_FALSE(callback.found());
   }
 }
@@ -356,12 +417,12 @@ TEST_F(DictionaryImplTest, LookupComment) {
   NodeAllocator allocator;
 
   string comment;
-  EXPECT_FALSE(d->LookupComment("key", "value", &comment));
+  EXPECT_FALSE(d->LookupComment("key", "value", convreq_, &comment));
   EXPECT_TRUE(comment.empty());
 
   // If key or value is "comment", UserDictionaryStub returns
   // "UserDictionaryStub" as comment.
-  EXPECT_TRUE(d->LookupComment("key", "comment", &comment));
+  EXPECT_TRUE(d->LookupComment("key", "comment", convreq_, &comment));
   EXPECT_EQ("UserDictionaryStub", comment);
 }
 
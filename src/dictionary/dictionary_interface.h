@@ -39,6 +39,7 @@
 
 namespace mozc {
 
+class ConversionRequest;       // converter/conversion_request.h
 class NodeAllocatorInterface;  // converter/node.h
 struct Token;                  // dictionary/dictionary_token.h
 
@@ -115,26 +116,57 @@ class DictionaryInterface {
   // Returns true if the dictionary has an entry for the given value.
   virtual bool HasValue(StringPiece value) const = 0;
 
+  // The lookup methods read the settings, e.g., kana modifier insensitive
+  // lookup and the config, from |conversion_request| instead of the global
+  // config.
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const = 0;
 
+  // Same as LookupPredictive(), but calls back the tokens in the ascending
+  // order of their costs and stops after |limit| tokens, if the dictionary
+  // supports it. The tokens of different keys may interleave; OnActualKey()
+  // is called back again before the tokens of each run of the same key.
+  // By default, the tokens are called back in the order of LookupPredictive().
+  virtual void LookupPredictiveTopK(
+      StringPiece key, const ConversionRequest &conversion_request,
+      size_t limit, Callback *callback) const {
+    LookupPredictive(key, conversion_request, callback);
+  }
+
+  // Same as LookupPredictive() with |callbacks|[i] for each |keys|[i], but
+  // the dictionary may share the lookup of the common prefixes of the keys.
+  // Each callback is called back in the same way as LookupPredictive(), but
+  // the callbacks of different keys may interleave.
+  // By default, LookupPredictive() is called for each key.
+  virtual void LookupPredictiveForKeys(
+      const vector<string> &keys, const ConversionRequest &conversion_request,
+      const vector<Callback *> &callbacks) const {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      LookupPredictive(keys[i], conversion_request, callbacks[i]);
+    }
+  }
+
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const = 0;
 
-  virtual void LookupExact(StringPiece key, Callback *callback) const = 0;
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const = 0;
 
   // For reverse lookup, the reading is stored in Token::value and the word
   // is stored in Token::key.
   // TODO(hsumita): Remove a dependency on NodeAllocatorInterface.
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const = 0;
 
   // Looks up a user comment from a pair of key and value.  When (key, value)
   // doesn't exist in this dictionary or user comment is empty, bool is
   // returned and string is kept as-is.
   virtual bool LookupComment(StringPiece key, StringPiece value,
+                             const ConversionRequest &conversion_request,
                              string *comment) const { return false; }
 
   // Populates cache for LookupReverse().
@@ -101,7 +101,7 @@ bool DictionaryMock::HasValue(StringPiece value) const {
 
 void DictionaryMock::LookupPredictive(
     StringPiece key,
-    bool,  // use_kana_modifier_insensitive_lookup
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   map<string, vector<Token *> >::const_iterator vector_iter =
       predictive_dictionary_.find(key.as_string());
@@ -122,7 +122,7 @@ void DictionaryMock::LookupPredictive(
 
 void DictionaryMock::LookupPrefix(
     StringPiece key,
-    bool,  // use_kana_modifier_insensitive_lookup
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   CHECK(!key.empty());
 
@@ -166,7 +166,9 @@ void DictionaryMock::LookupPrefix(
   }
 }
 
-void DictionaryMock::LookupExact(StringPiece key, Callback *callback) const {
+void DictionaryMock::LookupExact(StringPiece key,
+                                 const ConversionRequest &conversion_request,
+                                 Callback *callback) const {
   map<string, vector<Token *> >::const_iterator iter =
       exact_dictionary_.find(key.as_string());
   if (iter == exact_dictionary_.end()) {
@@ -186,6 +188,7 @@ void DictionaryMock::LookupExact(StringPiece key, Callback *callback) const {
 
 void DictionaryMock::LookupReverse(StringPiece str,
                                    NodeAllocatorInterface *allocator,
+                                   const ConversionRequest &conversion_request,
                                    Callback *callback) const {
   CHECK(!str.empty());
 
@@ -77,18 +77,21 @@ class DictionaryMock : public DictionaryInterface {
   // tokens whose keys exactly match the registered key are looked up; see the
   // comment of AddLookupPredictive.
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
 
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
 
-  virtual void LookupExact(StringPiece key, Callback *callback) const;
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const;
 
   // For reverse lookup, the reading is stored in Token::value and the word
   // is stored in Token::key. This mock method doesn't use |*allocator|.
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const;
 
   // Adds a string-result pair to the predictive search result.
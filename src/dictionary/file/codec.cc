@@ -30,13 +30,11 @@
 #include "dictionary/file/codec.h"
 
 #include <algorithm>
-#include <climits>
 
 #include "base/file_stream.h"
 #include "base/logging.h"
 #include "base/port.h"
 #include "base/singleton.h"
-#include "base/util.h"
 #include "dictionary/file/codec_interface.h"
 #include "dictionary/file/section.h"
 
@@ -133,11 +131,12 @@ bool DictionaryFileCodec::ReadSections(
   return true;
 }
 
-// Write padding
+// Write padding. The padding is filled with zeros so that the same input
+// always produces the same image.
 void DictionaryFileCodec::Pad4(int length, ostream *ofs) {
   DCHECK(ofs);
   for (int i = length; (i % 4) != 0; ++i) {
-    (*ofs) << static_cast<char>(Util::Random(CHAR_MAX));
+    (*ofs) << '\0';
   }
 }
 
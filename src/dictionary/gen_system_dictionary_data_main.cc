@@ -53,6 +53,16 @@ DEFINE_string(output, "", "output binary file");
 DEFINE_bool(make_header, false, "make header mode");
 DEFINE_bool(gen_test_dictionary, false,
             "generate test dictionary (use mock POSManager)");
+DEFINE_int32(num_threads, 1,
+             "number of threads to build the dictionary. The output doesn't "
+             "depend on it.");
+DEFINE_bool(streaming, false,
+            "stream tokens to the builder instead of loading all of them. "
+            "The tokens are the same but their order may differ.");
+DEFINE_int32(sort_buffer_mb, 0,
+             "max size of tokens kept in memory in streaming mode. Sorted "
+             "runs beyond it are written to temporary files. 0 means no "
+             "limit.");
 
 namespace mozc {
 namespace {
@@ -88,6 +98,20 @@ void GetInputFileName(const string &input_file,
   }
 }
 
+// Passes the streamed tokens to the builder.
+class AddTokenCallback : public TextDictionaryLoader::TokenCallback {
+ public:
+  explicit AddTokenCallback(dictionary::SystemDictionaryBuilder *builder)
+      : builder_(builder) {}
+
+  virtual void OnToken(const Token &token) {
+    builder_->AddToken(token);
+  }
+
+ private:
+  dictionary::SystemDictionaryBuilder *builder_;
+};
+
 }  // namespace
 }  // namespace mozc
 
@@ -106,10 +130,26 @@ int main(int argc, char **argv) {
   CHECK(pos_matcher);
 
   mozc::TextDictionaryLoader loader(*pos_matcher);
-  loader.Load(system_dictionary_input, reading_correction_input);
-
   mozc::dictionary::SystemDictionaryBuilder builder;
-  builder.BuildFromTokens(loader.tokens());
+  builder.set_num_threads(FLAGS_num_threads);
+  if (FLAGS_streaming) {
+    builder.set_sort_buffer_size(
+        static_cast<size_t>(FLAGS_sort_buffer_mb) << 20, FLAGS_output);
+    mozc::AddTokenCallback callback(&builder);
+    loader.StreamTokens(system_dictionary_input, reading_correction_input,
+                        &callback);
+    builder.BuildFromAddedTokens();
+  } else {
+    loader.Load(system_dictionary_input, reading_correction_input);
+    builder.BuildFromTokens(loader.tokens());
+  }
+
+  const mozc::dictionary::SystemDictionaryBuilder::StageTimings &timings =
+      builder.stage_timings();
+  for (size_t i = 0; i < timings.size(); ++i) {
+    LOG(INFO) << "Build stage " << timings[i].first << ": "
+              << timings[i].second << " msec";
+  }
 
   scoped_ptr<ostream> output_stream(
       new mozc::OutputFileStream(FLAGS_output.c_str(),
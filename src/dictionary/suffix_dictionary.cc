@@ -83,7 +83,7 @@ bool SuffixDictionary::HasValue(StringPiece value) const {
 
 void SuffixDictionary::LookupPredictive(
     StringPiece key,
-    bool,  // use_kana_modifier_insensitive_lookup
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   typedef IteratorAdapter<const SuffixToken *, SuffixTokenKeyAdapter> Iter;
   pair<Iter, Iter> range = equal_range(
@@ -120,16 +120,19 @@ void SuffixDictionary::LookupPredictive(
 }
 
 void SuffixDictionary::LookupPrefix(StringPiece key,
-                                    bool use_kana_modifier_insensitive_lookup,
+                                    const ConversionRequest &conversion_request,
                                     Callback *callback) const {
 }
 
-void SuffixDictionary::LookupReverse(StringPiece str,
-                                     NodeAllocatorInterface *allocator,
-                                     Callback *callback) const {
+void SuffixDictionary::LookupReverse(
+    StringPiece str, NodeAllocatorInterface *allocator,
+    const ConversionRequest &conversion_request,
+    Callback *callback) const {
 }
 
-void SuffixDictionary::LookupExact(StringPiece key, Callback *callback) const {
+void SuffixDictionary::LookupExact(StringPiece key,
+                                   const ConversionRequest &conversion_request,
+                                   Callback *callback) const {
 }
 
 }  // namespace mozc
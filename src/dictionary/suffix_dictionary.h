@@ -59,16 +59,19 @@ class SuffixDictionary : public DictionaryInterface {
 
   // Kana modifier insensitive lookup is not supported.
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
 
   // SuffixDictionary doesn't support Prefix/Revese/Exact Lookup.
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const;
-  virtual void LookupExact(StringPiece key, Callback *callback) const;
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const;
 
  private:
   const SuffixToken *const suffix_tokens_;
@@ -31,6 +31,7 @@
 
 #include "base/scoped_ptr.h"
 #include "base/util.h"
+#include "converter/conversion_request.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_test_util.h"
@@ -52,12 +53,13 @@ TEST(SuffixDictionaryTest, LookupPredictive) {
     dic.reset(new SuffixDictionary(tokens, tokens_size));
     ASSERT_NE(nullptr, dic.get());
   }
+  const ConversionRequest convreq;
 
   {
     // Lookup with empty key.  All tokens are looked up.  Here, just verify the
     // result is nonempty and each token has valid data.
     CollectTokenCallback callback;
-    dic->LookupPredictive("", false, &callback);
+    dic->LookupPredictive("", convreq, &callback);
     EXPECT_FALSE(callback.tokens().empty());
     for (size_t i = 0; i < callback.tokens().size(); ++i) {
       const Token &token = callback.tokens()[i];
@@ -72,7 +74,7 @@ TEST(SuffixDictionaryTest, LookupPredictive) {
     // Non-empty prefix.
     const string kPrefix = "\xE3\x81\x9F";  // "た"
     CollectTokenCallback callback;
-    dic->LookupPredictive(kPrefix, false, &callback);
+    dic->LookupPredictive(kPrefix, convreq, &callback);
     EXPECT_FALSE(callback.tokens().empty());
     for (size_t i = 0; i < callback.tokens().size(); ++i) {
       const Token &token = callback.tokens()[i];
@@ -76,6 +76,8 @@ const char kKeySectionName[] = "k";
 const char kValueSectionName[] = "v";
 const char kTokensSectionName[] = "t";
 const char kPosSectionName[] = "p";
+const char kReverseLookupSectionName[] = "r";
+const char kKeyCostsSectionName[] = "c";
 
 //// Constants for validation ////
 // 12 bits
@@ -213,6 +215,14 @@ const string SystemDictionaryCodec::GetSectionNameForPos() const {
   return kPosSectionName;
 }
 
+const string SystemDictionaryCodec::GetSectionNameForReverseLookup() const {
+  return kReverseLookupSectionName;
+}
+
+const string SystemDictionaryCodec::GetSectionNameForKeyCosts() const {
+  return kKeyCostsSectionName;
+}
+
 void SystemDictionaryCodec::EncodeKey(
     const StringPiece src, string *dst) const {
   EncodeDecodeKeyImpl(src, dst);
@@ -58,6 +58,12 @@ class SystemDictionaryCodec : public SystemDictionaryCodecInterface {
   // Return section name for frequent pos map
   virtual const string GetSectionNameForPos() const;
 
+  // Return section name for reverse lookup index
+  virtual const string GetSectionNameForReverseLookup() const;
+
+  // Return section name for the min costs of the key trie nodes
+  virtual const string GetSectionNameForKeyCosts() const;
+
   // Compresses key string into small bytes.
   virtual void EncodeKey(const StringPiece src, string *dst) const;
 
@@ -60,6 +60,12 @@ class SystemDictionaryCodecInterface {
   // Return section name for frequent pos map
   virtual const string GetSectionNameForPos() const = 0;
 
+  // Return section name for reverse lookup index
+  virtual const string GetSectionNameForReverseLookup() const = 0;
+
+  // Return section name for the min costs of the key trie nodes
+  virtual const string GetSectionNameForKeyCosts() const = 0;
+
   // Encode value(word) string
   virtual void EncodeValue(const StringPiece src, string *dst) const = 0;
 
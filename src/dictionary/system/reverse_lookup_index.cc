@@ -0,0 +1,127 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dictionary/system/reverse_lookup_index.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+struct ValueIdLessThan {
+  bool operator()(const pair<uint32, uint32> &lhs,
+                  const pair<uint32, uint32> &rhs) const {
+    return lhs.first < rhs.first;
+  }
+};
+
+void AppendUint32(uint32 value, string *output) {
+  output->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+}  // namespace
+
+ReverseLookupIndexBuilder::ReverseLookupIndexBuilder() : built_(false) {}
+
+ReverseLookupIndexBuilder::~ReverseLookupIndexBuilder() {}
+
+void ReverseLookupIndexBuilder::Add(uint32 value_id, uint32 key_id) {
+  DCHECK(!built_);
+  entries_.push_back(make_pair(value_id, key_id));
+}
+
+void ReverseLookupIndexBuilder::Build() {
+  DCHECK(!built_);
+  stable_sort(entries_.begin(), entries_.end(), ValueIdLessThan());
+
+  const uint32 num_values = entries_.empty() ? 0 : entries_.back().first + 1;
+  image_.clear();
+  image_.reserve(sizeof(uint32) * (num_values + entries_.size() + 2));
+  AppendUint32(num_values, &image_);
+  size_t pos = 0;
+  for (uint32 value_id = 0; value_id <= num_values; ++value_id) {
+    while (pos < entries_.size() && entries_[pos].first < value_id) {
+      ++pos;
+    }
+    AppendUint32(static_cast<uint32>(pos), &image_);
+  }
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    AppendUint32(entries_[i].second, &image_);
+  }
+
+  vector<pair<uint32, uint32> >().swap(entries_);
+  built_ = true;
+}
+
+const string &ReverseLookupIndexBuilder::image() const {
+  DCHECK(built_);
+  return image_;
+}
+
+ReverseLookupIndex::ReverseLookupIndex()
+    : num_values_(0), offsets_(NULL), key_ids_(NULL) {}
+
+ReverseLookupIndex::~ReverseLookupIndex() {}
+
+bool ReverseLookupIndex::Open(const uint8 *image, size_t length) {
+  DCHECK(image);
+  if (length < sizeof(uint32)) {
+    LOG(ERROR) << "Reverse lookup index is too short: " << length;
+    return false;
+  }
+  const uint32 *words = reinterpret_cast<const uint32 *>(image);
+  const uint32 num_values = words[0];
+  const size_t header_words = static_cast<size_t>(num_values) + 2;
+  if (length < header_words * sizeof(uint32) ||
+      length != (header_words + words[num_values + 1]) * sizeof(uint32)) {
+    LOG(ERROR) << "Broken reverse lookup index";
+    return false;
+  }
+  num_values_ = num_values;
+  offsets_ = words + 1;
+  key_ids_ = words + header_words;
+  return true;
+}
+
+size_t ReverseLookupIndex::GetKeyIds(uint32 value_id,
+                                     const uint32 **key_ids) const {
+  DCHECK(key_ids);
+  if (value_id >= num_values_) {
+    *key_ids = NULL;
+    return 0;
+  }
+  *key_ids = key_ids_ + offsets_[value_id];
+  return offsets_[value_id + 1] - offsets_[value_id];
+}
+
+}  // namespace dictionary
+}  // namespace mozc
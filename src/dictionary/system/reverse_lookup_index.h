@@ -0,0 +1,99 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Index from the ids in the value trie to the ids in the key trie of a system
+// dictionary, used for reverse conversion. SystemDictionaryBuilder stores the
+// index in the dictionary file, so that reverse lookups read it directly from
+// the mapped image.
+//
+// Image format (all the fields are uint32 in the host byte order, as well as
+// the frequent POS section):
+//   num_values
+//   offsets[num_values + 1]: the key ids of value id i are stored in
+//                            key_ids[offsets[i]] .. key_ids[offsets[i + 1] - 1]
+//   key_ids[offsets[num_values]]
+
+#ifndef MOZC_DICTIONARY_SYSTEM_REVERSE_LOOKUP_INDEX_H_
+#define MOZC_DICTIONARY_SYSTEM_REVERSE_LOOKUP_INDEX_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/port.h"
+
+namespace mozc {
+namespace dictionary {
+
+class ReverseLookupIndexBuilder {
+ public:
+  ReverseLookupIndexBuilder();
+  ~ReverseLookupIndexBuilder();
+
+  // Adds a token of |key_id| whose value is |value_id|. The key ids of the
+  // same value id are kept in the order they are added.
+  void Add(uint32 value_id, uint32 key_id);
+
+  void Build();
+
+  const string &image() const;
+
+ private:
+  bool built_;
+  vector<pair<uint32, uint32> > entries_;
+  string image_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReverseLookupIndexBuilder);
+};
+
+class ReverseLookupIndex {
+ public:
+  ReverseLookupIndex();
+  ~ReverseLookupIndex();
+
+  // Opens the index from |image|, which is not owned. Returns false if the
+  // image is broken.
+  bool Open(const uint8 *image, size_t length);
+
+  // Returns the number of the key ids of |value_id|, and sets the pointer to
+  // the first one to |key_ids|.
+  size_t GetKeyIds(uint32 value_id, const uint32 **key_ids) const;
+
+ private:
+  uint32 num_values_;
+  const uint32 *offsets_;
+  const uint32 *key_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReverseLookupIndex);
+};
+
+}  // namespace dictionary
+}  // namespace mozc
+
+#endif  // MOZC_DICTIONARY_SYSTEM_REVERSE_LOOKUP_INDEX_H_
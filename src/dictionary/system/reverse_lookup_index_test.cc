@@ -0,0 +1,109 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dictionary/system/reverse_lookup_index.h"
+
+#include <string>
+
+#include "base/port.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+const uint8 *GetImage(const ReverseLookupIndexBuilder &builder) {
+  return reinterpret_cast<const uint8 *>(builder.image().data());
+}
+
+TEST(ReverseLookupIndexTest, Lookup) {
+  ReverseLookupIndexBuilder builder;
+  builder.Add(3, 10);
+  builder.Add(0, 11);
+  builder.Add(3, 12);
+  builder.Add(3, 12);
+  builder.Add(1, 13);
+  builder.Build();
+
+  // num_values, 5 offsets and 5 key ids.
+  EXPECT_EQ(11 * sizeof(uint32), builder.image().size());
+
+  ReverseLookupIndex index;
+  ASSERT_TRUE(index.Open(GetImage(builder), builder.image().size()));
+
+  const uint32 *key_ids = NULL;
+  ASSERT_EQ(1, index.GetKeyIds(0, &key_ids));
+  EXPECT_EQ(11, key_ids[0]);
+
+  ASSERT_EQ(1, index.GetKeyIds(1, &key_ids));
+  EXPECT_EQ(13, key_ids[0]);
+
+  EXPECT_EQ(0, index.GetKeyIds(2, &key_ids));
+
+  // The key ids are kept in the order they are added.
+  ASSERT_EQ(3, index.GetKeyIds(3, &key_ids));
+  EXPECT_EQ(10, key_ids[0]);
+  EXPECT_EQ(12, key_ids[1]);
+  EXPECT_EQ(12, key_ids[2]);
+
+  EXPECT_EQ(0, index.GetKeyIds(4, &key_ids));
+  EXPECT_EQ(0, index.GetKeyIds(100, &key_ids));
+}
+
+TEST(ReverseLookupIndexTest, Empty) {
+  ReverseLookupIndexBuilder builder;
+  builder.Build();
+
+  ReverseLookupIndex index;
+  ASSERT_TRUE(index.Open(GetImage(builder), builder.image().size()));
+  const uint32 *key_ids = NULL;
+  EXPECT_EQ(0, index.GetKeyIds(0, &key_ids));
+}
+
+TEST(ReverseLookupIndexTest, BrokenImage) {
+  ReverseLookupIndexBuilder builder;
+  builder.Add(0, 1);
+  builder.Add(1, 2);
+  builder.Build();
+  const string &image = builder.image();
+
+  ReverseLookupIndex index;
+  EXPECT_FALSE(index.Open(GetImage(builder), 0));
+  EXPECT_FALSE(index.Open(GetImage(builder), sizeof(uint32)));
+  EXPECT_FALSE(index.Open(GetImage(builder), image.size() - sizeof(uint32)));
+
+  string too_long = image;
+  too_long.append(sizeof(uint32), '\0');
+  EXPECT_FALSE(index.Open(reinterpret_cast<const uint8 *>(too_long.data()),
+                          too_long.size()));
+}
+
+}  // namespace
+}  // namespace dictionary
+}  // namespace mozc
@@ -47,22 +47,28 @@
 #include "dictionary/system/system_dictionary.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <map>
+#include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "base/logging.h"
 #include "base/port.h"
+#include "base/stl_util.h"
 #include "base/string_piece.h"
 #include "base/system_util.h"
 #include "base/util.h"
+#include "converter/conversion_request.h"
 #include "converter/node_allocator.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/file/dictionary_file.h"
 #include "dictionary/system/codec_interface.h"
+#include "dictionary/system/reverse_lookup_index.h"
 #include "dictionary/system/words_info.h"
 #include "storage/louds/bit_vector_based_array.h"
 #include "storage/louds/louds_trie.h"
@@ -80,6 +86,10 @@ namespace {
 const int kMinRbxBlobSize = 4;
 const char *kReverseLookupCache = "reverse_lookup_cache";
 
+// The number of values in ValueCache.  The most referred values cover most
+// of the tokens since the distribution is heavily skewed.
+const size_t kValueCacheSize = 4096;
+
 class ReverseLookupCache : public NodeAllocatorData::Data {
  public:
   multimap<int, SystemDictionary::ReverseLookupResult> results;
@@ -175,6 +185,75 @@ void BuildHiraganaExpansionTable(
   }
 }
 
+}  // namespace
+
+// Table of the decoded values for the value ids referred to by the most
+// tokens.  Particles and common words are shared by many keys, so most of
+// the value decodings in lookups hit this table and skip the reverse walk of
+// the value trie.  The table is immutable after the construction, so it is
+// read by multiple threads without locks.  The hits and misses are counted
+// only in debug builds, as the shared counters would be written by every
+// lookup on all the threads.
+class ValueCache {
+ public:
+  ValueCache(const SystemDictionaryCodecInterface *codec,
+             const BitVectorBasedArray *token_array,
+             const LoudsTrie *value_trie,
+             size_t max_size);
+  ~ValueCache() {}
+
+  // Returns the decoded value for |id|, or NULL if it is not in the table.
+  const string *Lookup(int id) const {
+    for (size_t i = Hash(id) & mask_; ids_[i] != -1; i = (i + 1) & mask_) {
+      if (ids_[i] == id) {
+#ifdef DEBUG
+        hits_.fetch_add(1, std::memory_order_relaxed);
+#endif  // DEBUG
+        return &values_[i];
+      }
+    }
+#ifdef DEBUG
+    misses_.fetch_add(1, std::memory_order_relaxed);
+#endif  // DEBUG
+    return NULL;
+  }
+
+  size_t size() const { return size_; }
+  uint64 hits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64 misses() const { return misses_.load(std::memory_order_relaxed); }
+
+ private:
+  static uint32 Hash(int id) {
+    // Fibonacci hashing; the upper bits are mixed into the lower bits used as
+    // the index.
+    const uint32 h = static_cast<uint32>(id) * 2654435761u;
+    return h ^ (h >> 16);
+  }
+
+  // Open addressing table with linear probing.  Empty slots have -1.
+  vector<int> ids_;
+  vector<string> values_;
+  size_t mask_;
+  size_t size_;
+  mutable std::atomic<uint64> hits_;
+  mutable std::atomic<uint64> misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueCache);
+};
+
+namespace {
+
+// Decodes the value of |id| in |value_trie|.
+void DecodeValueFromTrie(const SystemDictionaryCodecInterface *codec,
+                         const LoudsTrie *value_trie, int id, string *value) {
+  char buffer[LoudsTrie::kMaxDepth + 1];
+  const char *encoded_value = value_trie->Reverse(id, buffer);
+  const size_t encoded_value_len =
+      LoudsTrie::kMaxDepth - (encoded_value - buffer);
+  DCHECK_EQ(encoded_value_len, strlen(encoded_value));
+  codec->DecodeValue(StringPiece(encoded_value, encoded_value_len), value);
+}
+
 // Note that this class is just introduced due to performance reason.
 // Conceptually, it should be in somewhere close to the codec implementation
 // (see comments in Next method for details).
@@ -187,11 +266,13 @@ class TokenDecodeIterator {
   TokenDecodeIterator(
       const SystemDictionaryCodecInterface *codec,
       const LoudsTrie *value_trie,
+      const ValueCache *value_cache,
       const uint32 *frequent_pos,
       StringPiece key,
       const uint8 *ptr)
       : codec_(codec),
         value_trie_(value_trie),
+        value_cache_(value_cache),
         frequent_pos_(frequent_pos),
         key_(key),
         state_(HAS_NEXT),
@@ -295,16 +376,19 @@ class TokenDecodeIterator {
   }
 
   void LookupValue(int id, string *value) const {
-    char buffer[LoudsTrie::kMaxDepth + 1];
-    const char *encoded_value = value_trie_->Reverse(id, buffer);
-    const size_t encoded_value_len =
-        LoudsTrie::kMaxDepth - (encoded_value - buffer);
-    DCHECK_EQ(encoded_value_len, strlen(encoded_value));
-    codec_->DecodeValue(StringPiece(encoded_value, encoded_value_len), value);
+    if (value_cache_ != NULL) {
+      const string *cached_value = value_cache_->Lookup(id);
+      if (cached_value != NULL) {
+        value->assign(*cached_value);
+        return;
+      }
+    }
+    DecodeValueFromTrie(codec_, value_trie_, id, value);
   }
 
   const SystemDictionaryCodecInterface *codec_;
   const LoudsTrie *value_trie_;
+  const ValueCache *value_cache_;
   const uint32 *frequent_pos_;
 
   const StringPiece key_;
@@ -419,99 +503,56 @@ class TokenScanIterator {
 
 }  // namespace
 
-class ReverseLookupIndex {
- public:
-  ReverseLookupIndex(
-      const SystemDictionaryCodecInterface *codec,
-      const storage::louds::BitVectorBasedArray *token_array) {
-    // Gets id size.
-    int value_id_max = -1;
-    for (TokenScanIterator iter(codec, token_array);
-         !iter.Done(); iter.Next()) {
-      const TokenScanIterator::Result &result = iter.Get();
-      value_id_max = max(value_id_max, result.value_id);
-    }
-
-    CHECK_GE(value_id_max, 0);
-    index_size_ = value_id_max + 1;
-    index_.reset(new ReverseLookupResultArray[index_size_]);
-
-    // Gets result size for each ids.
-    for (TokenScanIterator iter(codec, token_array);
-         !iter.Done(); iter.Next()) {
-      const TokenScanIterator::Result &result = iter.Get();
-      if (result.value_id != -1) {
-        DCHECK_LT(result.value_id, index_size_);
-        ++(index_[result.value_id].size);
-      }
+ValueCache::ValueCache(const SystemDictionaryCodecInterface *codec,
+                       const BitVectorBasedArray *token_array,
+                       const LoudsTrie *value_trie,
+                       size_t max_size)
+    : mask_(0), size_(0), hits_(0), misses_(0) {
+  // Counts the number of tokens referring to each value.
+  vector<uint32> counts;
+  for (TokenScanIterator iter(codec, token_array);
+       !iter.Done(); iter.Next()) {
+    const int value_id = iter.Get().value_id;
+    if (value_id == -1) {
+      continue;
     }
-
-    for (size_t i = 0; i < index_size_; ++i) {
-      index_[i].results.reset(
-          new SystemDictionary::ReverseLookupResult[index_[i].size]);
+    if (static_cast<size_t>(value_id) >= counts.size()) {
+      counts.resize(value_id + 1, 0);
     }
+    ++counts[value_id];
+  }
 
-    // Builds index.
-    for (TokenScanIterator iter(codec, token_array);
-         !iter.Done(); iter.Next()) {
-      const TokenScanIterator::Result &result = iter.Get();
-      if (result.value_id == -1) {
-        continue;
-      }
-
-      DCHECK_LT(result.value_id, index_size_);
-      ReverseLookupResultArray *result_array = &index_[result.value_id];
-
-      // Finds uninitialized result.
-      size_t result_index = 0;
-      for (result_index = 0;
-           result_index < result_array->size;
-           ++result_index) {
-        const SystemDictionary::ReverseLookupResult &lookup_result =
-            result_array->results[result_index];
-        if (lookup_result.tokens_offset == -1 &&
-            lookup_result.id_in_key_trie == -1) {
-          result_array->results[result_index].tokens_offset =
-              result.tokens_offset;
-          result_array->results[result_index].id_in_key_trie = result.index;
-          break;
-        }
-      }
+  // Picks the most referred values.  Ties are broken by the id to make the
+  // table deterministic.
+  vector<pair<uint32, int> > ranking;
+  ranking.reserve(counts.size());
+  for (size_t i = 0; i < counts.size(); ++i) {
+    if (counts[i] > 0) {
+      ranking.push_back(make_pair(counts[i], -static_cast<int>(i)));
     }
-
-    CHECK(index_.get() != NULL);
   }
-
-  ~ReverseLookupIndex() {}
-
-  void FillResultMap(
-      const set<int> &id_set,
-      multimap<int, SystemDictionary::ReverseLookupResult> *result_map) {
-    for (set<int>::const_iterator id_itr  = id_set.begin();
-         id_itr != id_set.end(); ++id_itr) {
-      const ReverseLookupResultArray &result_array = index_[*id_itr];
-      for (size_t i = 0; i < result_array.size; ++i) {
-        result_map->insert(make_pair(*id_itr, result_array.results[i]));
-      }
+  size_ = min(max_size, ranking.size());
+  partial_sort(ranking.begin(), ranking.begin() + size_, ranking.end(),
+               greater<pair<uint32, int> >());
+
+  // Keeps the load factor at most 0.5.
+  size_t table_size = 1;
+  while (table_size < size_ * 2) {
+    table_size *= 2;
+  }
+  mask_ = table_size - 1;
+  ids_.assign(table_size, -1);
+  values_.resize(table_size);
+  for (size_t i = 0; i < size_; ++i) {
+    const int id = -ranking[i].second;
+    size_t slot = Hash(id) & mask_;
+    while (ids_[slot] != -1) {
+      slot = (slot + 1) & mask_;
     }
+    ids_[slot] = id;
+    DecodeValueFromTrie(codec, value_trie, id, &values_[slot]);
   }
-
- private:
-  struct ReverseLookupResultArray {
-    ReverseLookupResultArray() : size(0) {}
-    // Use scoped_ptr for reducing memory consumption as possible.
-    // Using vector requires 90 MB even when we call resize explicitly.
-    // On the other hand, scoped_ptr requires 57 MB.
-    scoped_ptr<SystemDictionary::ReverseLookupResult[]> results;
-    size_t size;
-  };
-
-  // Use scoped array for reducing memory consumption as possible.
-  scoped_ptr<ReverseLookupResultArray[]> index_;
-  size_t index_size_;
-
-  DISALLOW_COPY_AND_ASSIGN(ReverseLookupIndex);
-};
+}
 
 SystemDictionary::Builder::Builder(const string &filename)
     : type_(FILENAME), filename_(filename),
@@ -564,8 +605,7 @@ SystemDictionary *SystemDictionary::Builder::Build() {
       return NULL;
   }
 
-  if (!instance->OpenDictionaryFile(
-          (options_ & ENABLE_REVERSE_LOOKUP_INDEX) != 0)) {
+  if (!instance->OpenDictionaryFile(options_)) {
     LOG(ERROR) << "Failed to create system dictionary";
     return NULL;
   }
@@ -579,6 +619,7 @@ SystemDictionary::SystemDictionary(const SystemDictionaryCodecInterface *codec)
       token_array_(new BitVectorBasedArray),
       dictionary_file_(new DictionaryFile),
       frequent_pos_(NULL),
+      key_trie_node_costs_(NULL),
       codec_(codec) {}
 
 SystemDictionary::~SystemDictionary() {}
@@ -611,7 +652,7 @@ SystemDictionary *SystemDictionary::CreateSystemDictionaryFromImage(
   return CreateSystemDictionaryFromImageWithOptions(ptr, len, NONE);
 }
 
-bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
+bool SystemDictionary::OpenDictionaryFile(Options options) {
   int len;
 
   const uint8 *key_image = reinterpret_cast<const uint8 *>(
@@ -641,10 +682,30 @@ bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
     return false;
   }
 
-  if (enable_reverse_lookup_index) {
+  // Dictionaries built by older builders don't have the reverse lookup
+  // section. In that case the index is built in heap only when requested.
+  const uint8 *reverse_lookup_image = reinterpret_cast<const uint8 *>(
+      dictionary_file_->GetSection(codec_->GetSectionNameForReverseLookup(),
+                                   &len));
+  if (reverse_lookup_image != NULL) {
+    reverse_lookup_index_.reset(new ReverseLookupIndex);
+    if (!reverse_lookup_index_->Open(reverse_lookup_image, len)) {
+      LOG(ERROR) << "can not open reverse lookup index";
+      return false;
+    }
+  } else if (options & ENABLE_REVERSE_LOOKUP_INDEX) {
     InitReverseLookupIndex();
   }
 
+  // The section is optional as well. Without it, the lookup in cost order
+  // falls back to the normal predictive lookup.
+  key_trie_node_costs_ = reinterpret_cast<const uint16 *>(
+      dictionary_file_->GetSection(codec_->GetSectionNameForKeyCosts(), &len));
+
+  if (options & ENABLE_VALUE_CACHE) {
+    InitValueCache();
+  }
+
   return true;
 }
 
@@ -653,8 +714,46 @@ void SystemDictionary::InitReverseLookupIndex() {
     return;
   }
 
-  reverse_lookup_index_.reset(
-      new ReverseLookupIndex(codec_, token_array_.get()));
+  ReverseLookupIndexBuilder builder;
+  for (TokenScanIterator iter(codec_, token_array_.get());
+       !iter.Done(); iter.Next()) {
+    const TokenScanIterator::Result &result = iter.Get();
+    if (result.value_id != -1) {
+      builder.Add(result.value_id, result.index);
+    }
+  }
+  builder.Build();
+  reverse_lookup_index_image_ = builder.image();
+
+  reverse_lookup_index_.reset(new ReverseLookupIndex);
+  CHECK(reverse_lookup_index_->Open(
+      reinterpret_cast<const uint8 *>(reverse_lookup_index_image_.data()),
+      reverse_lookup_index_image_.size()));
+}
+
+void SystemDictionary::InitValueCache() {
+  if (value_cache_.get() != NULL) {
+    return;
+  }
+
+  value_cache_.reset(new ValueCache(codec_, token_array_.get(),
+                                    value_trie_.get(), kValueCacheSize));
+}
+
+bool SystemDictionary::GetValueCacheStats(uint64 *hits,
+                                          uint64 *misses) const {
+  DCHECK(hits);
+  DCHECK(misses);
+#ifdef DEBUG
+  if (value_cache_.get() == NULL) {
+    return false;
+  }
+  *hits = value_cache_->hits();
+  *misses = value_cache_->misses();
+  return true;
+#else
+  return false;
+#endif  // DEBUG
 }
 
 bool SystemDictionary::HasValue(StringPiece value) const {
@@ -700,7 +799,8 @@ bool SystemDictionary::HasValue(StringPiece value) const {
 
   // Check tokens.
   for (TokenDecodeIterator iter(
-           codec_, value_trie_.get(), frequent_pos_, key, encoded_tokens_ptr);
+           codec_, value_trie_.get(), value_cache_.get(), frequent_pos_, key,
+           encoded_tokens_ptr);
        !iter.Done(); iter.Next()) {
     const Token *token = iter.Get().token;
     if (value == token->value) {
@@ -865,38 +965,21 @@ class ShortKeyCollector : public LoudsTrie::Callback {
   DISALLOW_COPY_AND_ASSIGN(ShortKeyCollector);
 };
 
-}  // namespace
-
-void SystemDictionary::LookupPredictive(
-    StringPiece key, bool use_kana_modifier_insensitive_lookup,
-    Callback *callback) const {
-  // Do nothing for empty key, although looking up all the entries with empty
-  // string seems natural.
-  if (key.empty()) {
-    return;
-  }
-
-  string lookup_key_str;
-  codec_->EncodeKey(key, &lookup_key_str);
-  if (lookup_key_str.size() > LoudsTrie::kMaxDepth) {
-    return;
-  }
-
-  // First, collect up to 64 keys so that results are as short as possible,
-  // which emulates BFS over trie.
-  ShortKeyCollector collector(codec_, lookup_key_str, 0, 64);
-  const KeyExpansionTable &table =
-      use_kana_modifier_insensitive_lookup ?
-      hiragana_expansion_table_ : KeyExpansionTable::GetDefaultInstance();
-  key_trie_->PredictiveSearchWithKeyExpansion(lookup_key_str.c_str(), table,
-                                              &collector);
-
+// Calls back the keys collected by ShortKeyCollector and their tokens.
+void CallbackCollectedKeys(
+    const vector<ShortKeyCollector::Entry> &entry_list,
+    const BitVectorBasedArray *token_array,
+    const LoudsTrie *value_trie,
+    const ValueCache *value_cache,
+    const SystemDictionaryCodecInterface *codec,
+    const uint32 *frequent_pos,
+    DictionaryInterface::Callback *callback) {
   string decoded_key, actual_key;
-  for (size_t i = 0; i < collector.entry_list().size(); ++i) {
-    const ShortKeyCollector::Entry &entry = collector.entry_list()[i];
+  for (size_t i = 0; i < entry_list.size(); ++i) {
+    const ShortKeyCollector::Entry &entry = entry_list[i];
 
     decoded_key.clear();
-    codec_->DecodeKey(entry.encoded_key, &decoded_key);
+    codec->DecodeKey(entry.encoded_key, &decoded_key);
     switch (callback->OnKey(decoded_key)) {
       case DictionaryInterface::Callback::TRAVERSE_DONE:
         return;
@@ -910,7 +993,7 @@ void SystemDictionary::LookupPredictive(
     }
 
     actual_key.clear();
-    codec_->DecodeKey(entry.encoded_actual_key, &actual_key);
+    codec->DecodeKey(entry.encoded_actual_key, &actual_key);
     const bool is_expanded = entry.encoded_key != entry.encoded_actual_key;
     switch (callback->OnActualKey(decoded_key, actual_key, is_expanded)) {
       case DictionaryInterface::Callback::TRAVERSE_DONE:
@@ -926,9 +1009,9 @@ void SystemDictionary::LookupPredictive(
 
     size_t dummy_length = 0;
     const uint8 *encoded_tokens_ptr = reinterpret_cast<const uint8*>(
-        token_array_->Get(entry.key_id, &dummy_length));
-    for (TokenDecodeIterator iter(codec_, value_trie_.get(),
-                                  frequent_pos_, actual_key,
+        token_array->Get(entry.key_id, &dummy_length));
+    for (TokenDecodeIterator iter(codec, value_trie, value_cache,
+                                  frequent_pos, actual_key,
                                   encoded_tokens_ptr);
          !iter.Done(); iter.Next()) {
       const TokenInfo &token_info = iter.Get();
@@ -946,19 +1029,284 @@ void SystemDictionary::LookupPredictive(
   }
 }
 
+}  // namespace
+
+void SystemDictionary::LookupPredictive(
+    StringPiece key, const ConversionRequest &conversion_request,
+    Callback *callback) const {
+  // Do nothing for empty key, although looking up all the entries with empty
+  // string seems natural.
+  if (key.empty()) {
+    return;
+  }
+
+  string lookup_key_str;
+  codec_->EncodeKey(key, &lookup_key_str);
+  if (lookup_key_str.size() > LoudsTrie::kMaxDepth) {
+    return;
+  }
+
+  // First, collect up to 64 keys so that results are as short as possible,
+  // which emulates BFS over trie.
+  ShortKeyCollector collector(codec_, lookup_key_str, 0, 64);
+  const KeyExpansionTable &table =
+      conversion_request.IsKanaModifierInsensitiveConversion() ?
+      hiragana_expansion_table_ : KeyExpansionTable::GetDefaultInstance();
+  key_trie_->PredictiveSearchWithKeyExpansion(lookup_key_str.c_str(), table,
+                                              &collector);
+
+  CallbackCollectedKeys(collector.entry_list(), token_array_.get(),
+                        value_trie_.get(), value_cache_.get(), codec_,
+                        frequent_pos_, callback);
+}
+
+namespace {
+
+// Dispatches the keys found for each lookup key to its ShortKeyCollector.
+class MultiKeyShortKeyCollector : public LoudsTrie::MultiKeyCallback {
+ public:
+  explicit MultiKeyShortKeyCollector(
+      const vector<ShortKeyCollector *> *collectors)
+      : collectors_(collectors) {
+  }
+
+  virtual LoudsTrie::Callback::ResultType Run(
+      size_t key_index, const char *trie_key, size_t trie_key_len,
+      int key_id) {
+    return (*collectors_)[key_index]->Run(trie_key, trie_key_len, key_id);
+  }
+
+ private:
+  const vector<ShortKeyCollector *> *collectors_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiKeyShortKeyCollector);
+};
+
+}  // namespace
+
+void SystemDictionary::LookupPredictiveForKeys(
+    const vector<string> &keys, const ConversionRequest &conversion_request,
+    const vector<Callback *> &callbacks) const {
+  DCHECK_EQ(keys.size(), callbacks.size());
+
+  // Encode the keys and skip the ones which LookupPredictive() ignores.
+  vector<string> lookup_keys;
+  vector<Callback *> lookup_callbacks;
+  lookup_keys.reserve(keys.size());
+  lookup_callbacks.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i].empty()) {
+      continue;
+    }
+    string lookup_key_str;
+    codec_->EncodeKey(keys[i], &lookup_key_str);
+    if (lookup_key_str.size() > LoudsTrie::kMaxDepth) {
+      continue;
+    }
+    lookup_keys.push_back(lookup_key_str);
+    lookup_callbacks.push_back(callbacks[i]);
+  }
+  if (lookup_keys.empty()) {
+    return;
+  }
+
+  // Collect the short keys for all the lookup keys in one traversal of the
+  // key trie. Note that |lookup_keys| must not be modified below, as the
+  // collectors refer to them.
+  vector<ShortKeyCollector *> collectors;
+  collectors.reserve(lookup_keys.size());
+  for (size_t i = 0; i < lookup_keys.size(); ++i) {
+    collectors.push_back(
+        new ShortKeyCollector(codec_, lookup_keys[i], 0, 64));
+  }
+  MultiKeyShortKeyCollector collector(&collectors);
+  const KeyExpansionTable &table =
+      conversion_request.IsKanaModifierInsensitiveConversion() ?
+      hiragana_expansion_table_ : KeyExpansionTable::GetDefaultInstance();
+  key_trie_->PredictiveSearchForKeys(lookup_keys, table, &collector);
+
+  for (size_t i = 0; i < collectors.size(); ++i) {
+    CallbackCollectedKeys(collectors[i]->entry_list(), token_array_.get(),
+                          value_trie_.get(), value_cache_.get(), codec_,
+                          frequent_pos_, lookup_callbacks[i]);
+  }
+  STLDeleteElements(&collectors);
+}
+
 namespace {
 
+// Traverser for predictive search in cost order. The key trie finds the keys
+// in the ascending order of the min costs of their subtrees, which bound the
+// costs of all the tokens not found yet. So the tokens of the found keys are
+// buffered, and the ones not more than the bound are called back in cost
+// order before the next key is handled.
+class CostOrderPredictiveTraverser : public LoudsTrie::CostOrderCallback {
+ public:
+  CostOrderPredictiveTraverser(const BitVectorBasedArray *token_array,
+                               const LoudsTrie *value_trie,
+                               const ValueCache *value_cache,
+                               const SystemDictionaryCodecInterface *codec,
+                               const uint32 *frequent_pos,
+                               StringPiece original_encoded_key,
+                               size_t limit,
+                               SystemDictionary::Callback *callback)
+      : token_array_(token_array),
+        value_trie_(value_trie),
+        value_cache_(value_cache),
+        codec_(codec),
+        frequent_pos_(frequent_pos),
+        original_encoded_key_(original_encoded_key),
+        limit_(limit),
+        callback_(callback),
+        num_tokens_(0),
+        last_key_index_(-1),
+        done_(false) {
+  }
+
+  virtual LoudsTrie::Callback::ResultType Run(
+      const char *trie_key, size_t trie_key_len, int key_id, int min_cost) {
+    CallbackTokens(min_cost);
+    if (done_) {
+      return LoudsTrie::Callback::SEARCH_DONE;
+    }
+
+    // Decode key and call back OnKey(). OnActualKey() is called back when the
+    // first token of the key is called back.
+    string encoded_key;
+    original_encoded_key_.CopyToString(&encoded_key);
+    encoded_key.append(trie_key + original_encoded_key_.size(),
+                       trie_key_len - original_encoded_key_.size());
+    KeyEntry key_entry;
+    codec_->DecodeKey(encoded_key, &key_entry.key);
+    switch (callback_->OnKey(key_entry.key)) {
+      case SystemDictionary::Callback::TRAVERSE_DONE:
+        done_ = true;
+        return LoudsTrie::Callback::SEARCH_DONE;
+      case SystemDictionary::Callback::TRAVERSE_NEXT_KEY:
+        return LoudsTrie::Callback::SEARCH_CONTINUE;
+      case SystemDictionary::Callback::TRAVERSE_CULL:
+        return LoudsTrie::Callback::SEARCH_CULL;
+      default:
+        break;
+    }
+    const StringPiece encoded_actual_key(trie_key, trie_key_len);
+    codec_->DecodeKey(encoded_actual_key, &key_entry.actual_key);
+    key_entry.is_expanded = encoded_actual_key != encoded_key;
+    key_entry.is_skipped = false;
+    key_list_.push_back(key_entry);
+
+    // Buffer the tokens of the key.
+    const int key_index = static_cast<int>(key_list_.size()) - 1;
+    size_t dummy_length = 0;
+    const uint8 *encoded_tokens_ptr = reinterpret_cast<const uint8*>(
+        token_array_->Get(key_id, &dummy_length));
+    for (TokenDecodeIterator iter(
+             codec_, value_trie_, value_cache_, frequent_pos_,
+             key_entry.actual_key, encoded_tokens_ptr);
+         !iter.Done(); iter.Next()) {
+      const Token &token = *iter.Get().token;
+      agenda_.push(make_pair(token.cost, token_list_.size()));
+      token_list_.push_back(make_pair(key_index, token));
+    }
+    return LoudsTrie::Callback::SEARCH_CONTINUE;
+  }
+
+  // Calls back all the remaining tokens.
+  void Finish() {
+    CallbackTokens(kint32max);
+  }
+
+ private:
+  struct KeyEntry {
+    string key;
+    string actual_key;
+    bool is_expanded;
+    // True if the remaining tokens of the key should not be called back.
+    bool is_skipped;
+  };
+
+  // Pair of the cost and the index in |token_list_|. The index breaks ties
+  // so that the tokens of the same cost are called back in the found order.
+  typedef pair<int, size_t> AgendaEntry;
+
+  void CallbackTokens(int max_cost) {
+    while (!done_ && !agenda_.empty() && agenda_.top().first <= max_cost) {
+      const pair<int, Token> &token_entry = token_list_[agenda_.top().second];
+      agenda_.pop();
+      KeyEntry *key_entry = &key_list_[token_entry.first];
+      if (key_entry->is_skipped) {
+        continue;
+      }
+      SystemDictionary::Callback::ResultType result;
+      if (token_entry.first != last_key_index_) {
+        last_key_index_ = token_entry.first;
+        result = callback_->OnActualKey(key_entry->key, key_entry->actual_key,
+                                        key_entry->is_expanded);
+        if (result != SystemDictionary::Callback::TRAVERSE_CONTINUE) {
+          Skip(result, key_entry);
+          continue;
+        }
+      }
+      result = callback_->OnToken(key_entry->key, key_entry->actual_key,
+                                  token_entry.second);
+      if (++num_tokens_ >= limit_) {
+        done_ = true;
+      }
+      Skip(result, key_entry);
+    }
+  }
+
+  void Skip(SystemDictionary::Callback::ResultType result,
+            KeyEntry *key_entry) {
+    switch (result) {
+      case SystemDictionary::Callback::TRAVERSE_DONE:
+        done_ = true;
+        break;
+      case SystemDictionary::Callback::TRAVERSE_NEXT_KEY:
+      case SystemDictionary::Callback::TRAVERSE_CULL:
+        // The keys starting with the key may have been found already, so
+        // culling is the same as skipping the key here.
+        key_entry->is_skipped = true;
+        break;
+      default:
+        break;
+    }
+  }
+
+  const BitVectorBasedArray *token_array_;
+  const LoudsTrie *value_trie_;
+  const ValueCache *value_cache_;
+  const SystemDictionaryCodecInterface *codec_;
+  const uint32 *frequent_pos_;
+  const StringPiece original_encoded_key_;
+  const size_t limit_;
+  SystemDictionary::Callback *callback_;
+
+  size_t num_tokens_;
+  int last_key_index_;
+  bool done_;
+  vector<KeyEntry> key_list_;
+  // Pairs of the index in |key_list_| and the token.
+  vector<pair<int, Token> > token_list_;
+  priority_queue<AgendaEntry, vector<AgendaEntry>,
+                 greater<AgendaEntry> > agenda_;
+
+  DISALLOW_COPY_AND_ASSIGN(CostOrderPredictiveTraverser);
+};
+
 // A general purpose traverser for prefix search over the system dictionary.
 class PrefixTraverser : public LoudsTrie::Callback {
  public:
   PrefixTraverser(const BitVectorBasedArray *token_array,
                   const LoudsTrie *value_trie,
+                  const ValueCache *value_cache,
                   const SystemDictionaryCodecInterface *codec,
                   const uint32 *frequent_pos,
                   StringPiece original_encoded_key,
                   SystemDictionary::Callback *callback)
       : token_array_(token_array),
         value_trie_(value_trie),
+        value_cache_(value_cache),
         codec_(codec),
         frequent_pos_(frequent_pos),
         original_encoded_key_(original_encoded_key),
@@ -979,7 +1327,7 @@ class PrefixTraverser : public LoudsTrie::Callback {
     const uint8 *encoded_tokens_ptr = reinterpret_cast<const uint8*>(
         token_array_->Get(key_id, &dummy_length));
     for (TokenDecodeIterator iter(
-             codec_, value_trie_, frequent_pos_,
+             codec_, value_trie_, value_cache_, frequent_pos_,
              actual_key, encoded_tokens_ptr);
          !iter.Done(); iter.Next()) {
       const TokenInfo &token_info = iter.Get();
@@ -1017,6 +1365,7 @@ class PrefixTraverser : public LoudsTrie::Callback {
 
   const BitVectorBasedArray *token_array_;
   const LoudsTrie *value_trie_;
+  const ValueCache *value_cache_;
   const SystemDictionaryCodecInterface *codec_;
   const uint32 *frequent_pos_;
   const StringPiece original_encoded_key_;
@@ -1043,21 +1392,55 @@ class ReverseLookupCallbackWrapper : public DictionaryInterface::Callback {
 
 }  // namespace
 
+void SystemDictionary::LookupPredictiveTopK(
+    StringPiece key, const ConversionRequest &conversion_request,
+    size_t limit, Callback *callback) const {
+  if (key_trie_node_costs_ == NULL) {
+    LookupPredictive(key, conversion_request, callback);
+    return;
+  }
+  if (key.empty() || limit == 0) {
+    return;
+  }
+
+  string lookup_key_str;
+  codec_->EncodeKey(key, &lookup_key_str);
+  if (lookup_key_str.size() > LoudsTrie::kMaxDepth) {
+    return;
+  }
+
+  // Note that the order is of the costs in the dictionary, i.e., doesn't
+  // reflect the penalty which |callback| may add to the expanded keys.
+  const KeyExpansionTable &table =
+      conversion_request.IsKanaModifierInsensitiveConversion() ?
+      hiragana_expansion_table_ : KeyExpansionTable::GetDefaultInstance();
+  CostOrderPredictiveTraverser traverser(
+      token_array_.get(), value_trie_.get(), value_cache_.get(), codec_,
+      frequent_pos_, lookup_key_str, limit, callback);
+  key_trie_->PredictiveSearchInCostOrder(
+      lookup_key_str.c_str(), table, key_trie_node_costs_, &traverser);
+  traverser.Finish();
+}
+
 void SystemDictionary::LookupPrefix(
     StringPiece key,
-    bool use_kana_modifier_insensitive_lookup,
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   string original_encoded_key;
   codec_->EncodeKey(key, &original_encoded_key);
-  PrefixTraverser traverser(token_array_.get(), value_trie_.get(), codec_,
-                            frequent_pos_, original_encoded_key, callback);
-  const KeyExpansionTable &table = use_kana_modifier_insensitive_lookup ?
+  PrefixTraverser traverser(token_array_.get(), value_trie_.get(),
+                            value_cache_.get(), codec_, frequent_pos_,
+                            original_encoded_key, callback);
+  const KeyExpansionTable &table =
+      conversion_request.IsKanaModifierInsensitiveConversion() ?
       hiragana_expansion_table_ : KeyExpansionTable::GetDefaultInstance();
   key_trie_->PrefixSearchWithKeyExpansion(
       original_encoded_key.c_str(), table, &traverser);
 }
 
-void SystemDictionary::LookupExact(StringPiece key, Callback *callback) const {
+void SystemDictionary::LookupExact(StringPiece key,
+                                   const ConversionRequest &conversion_request,
+                                   Callback *callback) const {
   // Find the key in the key trie.
   string encoded_key;
   codec_->EncodeKey(key, &encoded_key);
@@ -1076,7 +1459,8 @@ void SystemDictionary::LookupExact(StringPiece key, Callback *callback) const {
 
   // Callback on each token.
   for (TokenDecodeIterator iter(
-           codec_, value_trie_.get(), frequent_pos_, key, encoded_tokens_ptr);
+           codec_, value_trie_.get(), value_cache_.get(), frequent_pos_, key,
+           encoded_tokens_ptr);
        !iter.Done(); iter.Next()) {
     if (callback->OnToken(key, key, *iter.Get().token) !=
         Callback::TRAVERSE_CONTINUE) {
@@ -1087,6 +1471,7 @@ void SystemDictionary::LookupExact(StringPiece key, Callback *callback) const {
 
 void SystemDictionary::LookupReverse(
     StringPiece str, NodeAllocatorInterface *allocator,
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   // 1st step: Hiragana/Katakana are not in the value trie
   // 2nd step: Reverse lookup in value trie
@@ -1171,12 +1556,13 @@ class T13nPrefixTraverser : public PrefixTraverser {
  public:
   T13nPrefixTraverser(const BitVectorBasedArray *token_array,
                       const LoudsTrie *value_trie,
+                      const ValueCache *value_cache,
                       const SystemDictionaryCodecInterface *codec,
                       const uint32 *frequent_pos,
                       StringPiece original_encoded_key,
                       SystemDictionary::Callback *callback)
-      : PrefixTraverser(token_array, value_trie, codec, frequent_pos,
-                        original_encoded_key, callback) {}
+      : PrefixTraverser(token_array, value_trie, value_cache, codec,
+                        frequent_pos, original_encoded_key, callback) {}
 
   virtual ResultType Run(const char *trie_key,
                          size_t trie_key_len, int key_id) {
@@ -1192,7 +1578,7 @@ class T13nPrefixTraverser : public PrefixTraverser {
     const uint8 *encoded_tokens_ptr = reinterpret_cast<const uint8*>(
         token_array_->Get(key_id, &dummy_length));
     for (TokenDecodeIterator iter(
-             codec_, value_trie_, frequent_pos_,
+             codec_, value_trie_, value_cache_, frequent_pos_,
              actual_key, encoded_tokens_ptr);
          !iter.Done(); iter.Next()) {
       const TokenInfo &token_info = iter.Get();
@@ -1228,8 +1614,9 @@ void SystemDictionary::RegisterReverseLookupTokensForT13N(
   string hiragana, original_encoded_key;
   Util::KatakanaToHiragana(value, &hiragana);
   codec_->EncodeKey(hiragana, &original_encoded_key);
-  T13nPrefixTraverser traverser(token_array_.get(), value_trie_.get(), codec_,
-                                frequent_pos_, original_encoded_key, callback);
+  T13nPrefixTraverser traverser(token_array_.get(), value_trie_.get(),
+                                value_cache_.get(), codec_, frequent_pos_,
+                                original_encoded_key, callback);
   key_trie_->PrefixSearchWithKeyExpansion(
       original_encoded_key.c_str(), KeyExpansionTable::GetDefaultInstance(),
       &traverser);
@@ -1245,6 +1632,11 @@ void SystemDictionary::RegisterReverseLookupTokensForValue(
   value_trie_->PrefixSearch(lookup_key.c_str(), &id_collector);
   const set<int> &id_set = id_collector.id_set();
 
+  if (reverse_lookup_index_ != NULL) {
+    RegisterReverseLookupIndexResults(id_set, callback);
+    return;
+  }
+
   const bool has_cache = (allocator != NULL &&
                           allocator->data().has(kReverseLookupCache));
   ReverseLookupCache *cache =
@@ -1253,10 +1645,7 @@ void SystemDictionary::RegisterReverseLookupTokensForValue(
 
   multimap<int, ReverseLookupResult> *results = NULL;
   multimap<int, ReverseLookupResult> non_cached_results;
-  if (reverse_lookup_index_ != NULL) {
-    reverse_lookup_index_->FillResultMap(id_set, &non_cached_results);
-    results = &non_cached_results;
-  } else if (cache != NULL && IsCacheAvailable(id_set, cache->results)) {
+  if (cache != NULL && IsCacheAvailable(id_set, cache->results)) {
     results = &(cache->results);
   } else {
     // Cache is not available. Get token for each ID.
@@ -1291,7 +1680,6 @@ void SystemDictionary::RegisterReverseLookupResults(
   size_t dummy_length = 0;
   const uint8 *encoded_tokens_ptr =
       reinterpret_cast<const uint8*>(token_array_->Get(0, &dummy_length));
-  char buffer[LoudsTrie::kMaxDepth + 1];
   for (set<int>::const_iterator set_itr = id_set.begin();
        set_itr != id_set.end();
        ++set_itr) {
@@ -1306,38 +1694,65 @@ void SystemDictionary::RegisterReverseLookupResults(
          result_itr != range.second;
          ++result_itr) {
       const ReverseLookupResult &reverse_result = result_itr->second;
+      RegisterReverseLookupTokensForKey(
+          filter, reverse_result.id_in_key_trie,
+          encoded_tokens_ptr + reverse_result.tokens_offset, callback);
+    }
+  }
+}
 
-      const char *encoded_key =
-          key_trie_->Reverse(reverse_result.id_in_key_trie, buffer);
-      const size_t encoded_key_len =
-          LoudsTrie::kMaxDepth - (encoded_key - buffer);
-      DCHECK_EQ(encoded_key_len, strlen(encoded_key));
-      string tokens_key;
-      codec_->DecodeKey(StringPiece(encoded_key, encoded_key_len), &tokens_key);
-      if (callback->OnKey(tokens_key) !=
-              SystemDictionary::Callback::TRAVERSE_CONTINUE) {
-        continue;
-      }
+void SystemDictionary::RegisterReverseLookupIndexResults(
+    const set<int> &id_set, Callback *callback) const {
+  DCHECK(reverse_lookup_index_ != NULL);
+  for (set<int>::const_iterator set_itr = id_set.begin();
+       set_itr != id_set.end();
+       ++set_itr) {
+    FilterInfo filter;
+    filter.conditions =
+        (FilterInfo::VALUE_ID | FilterInfo::NO_SPELLING_CORRECTION);
+    filter.value_id = *set_itr;
 
-      // actual_key is always the same as tokens_key for reverse conversions.
-      RegisterTokens(
-          filter,
-          tokens_key,
-          tokens_key,
-          encoded_tokens_ptr + reverse_result.tokens_offset,
-          callback);
+    const uint32 *key_ids = NULL;
+    const size_t num_key_ids =
+        reverse_lookup_index_->GetKeyIds(*set_itr, &key_ids);
+    for (size_t i = 0; i < num_key_ids; ++i) {
+      size_t length = 0;
+      const uint8 *encoded_tokens_ptr = reinterpret_cast<const uint8 *>(
+          token_array_->Get(key_ids[i], &length));
+      RegisterReverseLookupTokensForKey(filter, key_ids[i],
+                                        encoded_tokens_ptr, callback);
     }
   }
 }
 
+void SystemDictionary::RegisterReverseLookupTokensForKey(
+    const FilterInfo &filter,
+    int id_in_key_trie,
+    const uint8 *encoded_tokens_ptr,
+    Callback *callback) const {
+  char buffer[LoudsTrie::kMaxDepth + 1];
+  const char *encoded_key = key_trie_->Reverse(id_in_key_trie, buffer);
+  const size_t encoded_key_len = LoudsTrie::kMaxDepth - (encoded_key - buffer);
+  DCHECK_EQ(encoded_key_len, strlen(encoded_key));
+  string tokens_key;
+  codec_->DecodeKey(StringPiece(encoded_key, encoded_key_len), &tokens_key);
+  if (callback->OnKey(tokens_key) !=
+          SystemDictionary::Callback::TRAVERSE_CONTINUE) {
+    return;
+  }
+
+  // actual_key is always the same as tokens_key for reverse conversions.
+  RegisterTokens(filter, tokens_key, tokens_key, encoded_tokens_ptr, callback);
+}
+
 void SystemDictionary::RegisterTokens(
     const FilterInfo &filter,
     const string &tokens_key,
     const string &actual_key,
     const uint8 *encoded_tokens_ptr,
     Callback *callback) const {
-  for (TokenDecodeIterator iter(codec_, value_trie_.get(), frequent_pos_,
-                                actual_key, encoded_tokens_ptr);
+  for (TokenDecodeIterator iter(codec_, value_trie_.get(), value_cache_.get(),
+                                frequent_pos_, actual_key, encoded_tokens_ptr);
        !iter.Done(); iter.Next()) {
     const TokenInfo &token_info = iter.Get();
     if (IsBadToken(filter, token_info)) {
@@ -45,6 +45,22 @@
         'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
       },
     },
+    {
+      'target_name': 'reverse_lookup_index',
+      'type': 'static_library',
+      'toolsets': ['target', 'host'],
+      'sources': [
+        'reverse_lookup_index.cc',
+      ],
+      'dependencies': [
+        '../../base/base.gyp:base_core',
+      ],
+      'xcode_settings' : {
+        'SDKROOT': 'iphoneos',
+        'IPHONEOS_DEPLOYMENT_TARGET': '7.0',
+        'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
+      },
+    },
     {
       'target_name': 'system_dictionary',
       'type': 'static_library',
@@ -53,10 +69,12 @@
       ],
       'dependencies': [
         '../../base/base.gyp:base_core',
+        '../../converter/converter_base.gyp:conversion_request',
         '../../storage/louds/louds.gyp:bit_vector_based_array',
         '../../storage/louds/louds.gyp:louds_trie',
         '../dictionary_base.gyp:text_dictionary_loader',
         '../file/dictionary_file.gyp:dictionary_file',
+        'reverse_lookup_index',
         'system_dictionary_codec',
       ],
       'xcode_settings' : {
@@ -73,6 +91,7 @@
       ],
       'dependencies': [
         '../../base/base.gyp:base_core',
+        '../../converter/converter_base.gyp:conversion_request',
         '../../storage/louds/louds.gyp:louds_trie',
         '../dictionary_base.gyp:pos_matcher',
         '../file/dictionary_file.gyp:dictionary_file',
@@ -90,14 +109,17 @@
       'toolsets': ['target', 'host'],  # "target" is needed for test.
       'sources': [
         'system_dictionary_builder.cc',
+        'token_sorter.cc',
       ],
       'dependencies': [
+        '../../base/base.gyp:base',
         '../../base/base.gyp:base_core',
         '../../storage/louds/louds.gyp:bit_vector_based_array_builder',
         '../../storage/louds/louds.gyp:louds_trie_builder',
         '../dictionary_base.gyp:pos_matcher',
         '../dictionary_base.gyp:text_dictionary_loader',
         '../file/dictionary_file.gyp:codec',
+        'reverse_lookup_index',
         'system_dictionary_codec',
       ],
       'xcode_settings' : {
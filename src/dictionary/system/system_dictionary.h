@@ -57,16 +57,24 @@ namespace dictionary {
 
 class SystemDictionaryCodecInterface;
 class ReverseLookupIndex;
+class ValueCache;
 
 class SystemDictionary : public DictionaryInterface {
  public:
   // System dictionary options represented as bitwise enum.
   enum Options {
     NONE = 0,
-    // If ENABLE_REVERSE_LOOKUP_INDEX is set, we will have the index in heap
-    // from the id in value trie to the id in key trie.
-    // That consumes more memory but we can perform reverse lookup more quickly.
+    // Dictionary files built by SystemDictionaryBuilder contain the index
+    // from the id in value trie to the id in key trie, which is used for
+    // reverse lookup regardless of the options.
+    // If ENABLE_REVERSE_LOOKUP_INDEX is set and the file doesn't have the
+    // index, we will build it in heap. That consumes more memory but we can
+    // perform reverse lookup more quickly.
     ENABLE_REVERSE_LOOKUP_INDEX = 1,
+    // If ENABLE_VALUE_CACHE is set, we will have the decoded values referred
+    // to by the most tokens in heap, which skips decoding them in lookups.
+    // Building the table scans all the tokens when the dictionary is opened.
+    ENABLE_VALUE_CACHE = 2,
   };
 
   // Builder class for system dictionary
@@ -144,27 +152,49 @@ class SystemDictionary : public DictionaryInterface {
 
   // Predictive lookup
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
 
+  // Predictive lookup for multiple keys. The short keys for all the keys are
+  // collected in one traversal of the key trie.
+  virtual void LookupPredictiveForKeys(
+      const vector<string> &keys, const ConversionRequest &conversion_request,
+      const vector<Callback *> &callbacks) const;
+
+  // Predictive lookup in cost order. Falls back to LookupPredictive() for
+  // the dictionary files without the min costs of the key trie nodes.
+  virtual void LookupPredictiveTopK(
+      StringPiece key, const ConversionRequest &conversion_request,
+      size_t limit, Callback *callback) const;
+
   // Prefix lookup
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
 
   // Exact lookup
-  virtual void LookupExact(StringPiece key, Callback *callback) const;
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const;
 
   // Value to key prefix lookup
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const;
   virtual void PopulateReverseLookupCache(
       StringPiece str, NodeAllocatorInterface *allocator) const;
   virtual void ClearReverseLookupCache(
       NodeAllocatorInterface *allocator) const;
 
+  // Gets the number of value decodings that hit and missed the value cache.
+  // Returns false if the cache is not enabled. The numbers are counted only
+  // in debug builds, so this always returns false in release builds.
+  bool GetValueCacheStats(uint64 *hits, uint64 *misses) const;
+
  private:
   FRIEND_TEST(SystemDictionaryTest, TokenAfterSpellningToken);
+  FRIEND_TEST(SystemDictionaryTest, ReverseLookupIndexInImage);
+  FRIEND_TEST(SystemDictionaryTest, LookupPredictiveTopK);
 
   struct FilterInfo {
     enum Condition {
@@ -182,7 +212,7 @@ class SystemDictionary : public DictionaryInterface {
 
   explicit SystemDictionary(const SystemDictionaryCodecInterface *codec);
 
-  bool OpenDictionaryFile(bool enable_reverse_lookup_index);
+  bool OpenDictionaryFile(Options options);
 
   // Calls |callback| with token info, which is filled using |tokens_key|,
   // |actual_key| and |encoded_tokens_ptr|.
@@ -213,7 +243,19 @@ class SystemDictionary : public DictionaryInterface {
       const multimap<int, ReverseLookupResult> &reverse_results,
       Callback *callback) const;
 
+  // Looks up the tokens of |id_set| with |reverse_lookup_index_|.
+  void RegisterReverseLookupIndexResults(const set<int> &id_set,
+                                         Callback *callback) const;
+
+  // Calls OnKey() for the key of |id_in_key_trie| and registers its tokens
+  // encoded at |encoded_tokens_ptr| with |filter|.
+  void RegisterReverseLookupTokensForKey(const FilterInfo &filter,
+                                         int id_in_key_trie,
+                                         const uint8 *encoded_tokens_ptr,
+                                         Callback *callback) const;
+
   void InitReverseLookupIndex();
+  void InitValueCache();
 
   scoped_ptr<storage::louds::LoudsTrie> key_trie_;
   scoped_ptr<storage::louds::LoudsTrie> value_trie_;
@@ -221,8 +263,15 @@ class SystemDictionary : public DictionaryInterface {
   scoped_ptr<DictionaryFile> dictionary_file_;
 
   scoped_ptr<ReverseLookupIndex> reverse_lookup_index_;
+  // Image of |reverse_lookup_index_| built in heap for the dictionary files
+  // without the reverse lookup section.
+  string reverse_lookup_index_image_;
+  scoped_ptr<ValueCache> value_cache_;
 
   const uint32 *frequent_pos_;
+  // Minimum cost of the tokens in the subtree of each key trie node, indexed
+  // by (node id - 1). NULL for the dictionary files without the section.
+  const uint16 *key_trie_node_costs_;
   const SystemDictionaryCodecInterface *codec_;
   storage::louds::KeyExpansionTable hiragana_expansion_table_;
 
@@ -38,12 +38,17 @@
 #include "base/flags.h"
 #include "base/hash_tables.h"
 #include "base/logging.h"
+#include "base/parallel_sort.h"
+#include "base/stopwatch.h"
+#include "base/thread.h"
 #include "base/util.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/file/codec_interface.h"
 #include "dictionary/pos_matcher.h"
 #include "dictionary/system/codec.h"
 #include "dictionary/system/codec_interface.h"
+#include "dictionary/system/reverse_lookup_index.h"
+#include "dictionary/system/token_sorter.h"
 #include "dictionary/system/words_info.h"
 #include "dictionary/text_dictionary_loader.h"
 #include "storage/louds/bit_vector_based_array_builder.h"
@@ -53,10 +58,15 @@ DEFINE_bool(preserve_intermediate_dictionary, false,
             "preserve inetemediate dictionary file.");
 DEFINE_int32(min_key_length_to_use_small_cost_encoding, 6,
              "minimum key length to use 1 byte cost encoding.");
+DEFINE_bool(build_key_trie_node_costs, false,
+            "build the section of the min costs of the key trie nodes, "
+            "which is used by --enable_top_k_predictive_lookup. It takes 2 "
+            "bytes per key trie node.");
 
 namespace mozc {
 namespace dictionary {
 
+using mozc::parallel_sort_internal::RunAndJoin;
 using mozc::storage::louds::LoudsTrieBuilder;
 using mozc::storage::louds::BitVectorBasedArrayBuilder;
 
@@ -86,11 +96,70 @@ void WriteSectionToFile(const DictionaryFileSection &section,
 
 }  // namespace
 
+class SystemDictionaryBuilder::Worker : public Thread {
+ public:
+  enum Task {
+    BUILD_VALUE_TRIE,
+    BUILD_KEY_TRIE,
+    SET_TOKEN_INFO,
+    ENCODE_TOKENS,
+  };
+
+  // BUILD_VALUE_TRIE and BUILD_KEY_TRIE use the whole |key_info_list|.
+  // The others process the key infos in [begin, end).
+  Worker(Task task, SystemDictionaryBuilder *builder,
+         KeyInfoList *key_info_list, size_t begin, size_t end,
+         vector<string> *encoded_tokens)
+      : task_(task),
+        builder_(builder),
+        key_info_list_(key_info_list),
+        begin_(begin),
+        end_(end),
+        encoded_tokens_(encoded_tokens) {}
+
+  virtual void Run() {
+    switch (task_) {
+      case BUILD_VALUE_TRIE:
+        builder_->BuildValueTrie(*key_info_list_);
+        break;
+      case BUILD_KEY_TRIE:
+        builder_->BuildKeyTrie(*key_info_list_);
+        break;
+      case SET_TOKEN_INFO:
+        builder_->SetTokenInfoInRange(key_info_list_->begin() + begin_,
+                                      key_info_list_->begin() + end_);
+        break;
+      case ENCODE_TOKENS: {
+        const KeyInfoList &key_info_list = *key_info_list_;
+        builder_->EncodeTokensInRange(key_info_list.begin() + begin_,
+                                      key_info_list.begin() + end_,
+                                      encoded_tokens_);
+        break;
+      }
+      default:
+        LOG(FATAL) << "Unknown task: " << task_;
+    }
+  }
+
+ private:
+  const Task task_;
+  SystemDictionaryBuilder *builder_;
+  KeyInfoList *key_info_list_;
+  const size_t begin_;
+  const size_t end_;
+  vector<string> *encoded_tokens_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
 SystemDictionaryBuilder::SystemDictionaryBuilder()
     : value_trie_builder_(new LoudsTrieBuilder),
       key_trie_builder_(new LoudsTrieBuilder),
       token_array_builder_(new BitVectorBasedArrayBuilder),
-      codec_(SystemDictionaryCodecFactory::GetCodec()) {}
+      reverse_lookup_index_builder_(new ReverseLookupIndexBuilder),
+      codec_(SystemDictionaryCodecFactory::GetCodec()),
+      num_threads_(1),
+      sort_buffer_size_(0) {}
 
 // This class does not have the ownership of |codec|.
 SystemDictionaryBuilder::SystemDictionaryBuilder(
@@ -98,26 +167,66 @@ SystemDictionaryBuilder::SystemDictionaryBuilder(
     : value_trie_builder_(new LoudsTrieBuilder),
       key_trie_builder_(new LoudsTrieBuilder),
       token_array_builder_(new BitVectorBasedArrayBuilder),
-      codec_(codec) {}
+      reverse_lookup_index_builder_(new ReverseLookupIndexBuilder),
+      codec_(codec),
+      num_threads_(1),
+      sort_buffer_size_(0) {}
 
 SystemDictionaryBuilder::~SystemDictionaryBuilder() {}
 
+void SystemDictionaryBuilder::set_num_threads(int num_threads) {
+  num_threads_ = max(num_threads, 1);
+}
+
+void SystemDictionaryBuilder::set_sort_buffer_size(
+    size_t sort_buffer_size, const string &temporary_file_prefix) {
+  DCHECK(token_sorter_.get() == NULL);
+  sort_buffer_size_ = sort_buffer_size;
+  temporary_file_prefix_ = temporary_file_prefix;
+}
+
+void SystemDictionaryBuilder::AddToken(const Token &token) {
+  CHECK(!token.key.empty()) << "empty key string in input";
+  CHECK(!token.value.empty()) << "empty value string in input";
+  if (token_sorter_.get() == NULL) {
+    token_sorter_.reset(
+        new TokenSorter(sort_buffer_size_, temporary_file_prefix_));
+  }
+  token_sorter_->Add(token);
+}
+
 void SystemDictionaryBuilder::BuildFromTokens(const vector<Token *> &tokens) {
+  stage_timings_.clear();
+  Stopwatch stopwatch = Stopwatch::StartNew();
+
   KeyInfoList key_info_list;
   ReadTokens(tokens, &key_info_list);
+  stage_timings_.push_back(
+      make_pair("ReadTokens", stopwatch.GetElapsedMilliseconds()));
 
+  stopwatch.Reset();
+  stopwatch.Start();
   BuildFrequentPos(key_info_list);
-  BuildValueTrie(key_info_list);
-  BuildKeyTrie(key_info_list);
-
-  SetIdForValue(&key_info_list);
-  SetIdForKey(&key_info_list);
-  SortTokenInfo(&key_info_list);
-  SetCostType(&key_info_list);
-  SetPosType(&key_info_list);
-  SetValueType(&key_info_list);
-
+  stage_timings_.push_back(
+      make_pair("BuildFrequentPos", stopwatch.GetElapsedMilliseconds()));
+
+  stopwatch.Reset();
+  stopwatch.Start();
+  BuildTries(key_info_list);
+  stage_timings_.push_back(
+      make_pair("BuildTries", stopwatch.GetElapsedMilliseconds()));
+
+  stopwatch.Reset();
+  stopwatch.Start();
+  SetTokenInfo(&key_info_list);
+  stage_timings_.push_back(
+      make_pair("SetTokenInfo", stopwatch.GetElapsedMilliseconds()));
+
+  stopwatch.Reset();
+  stopwatch.Start();
   BuildTokenArray(key_info_list);
+  stage_timings_.push_back(
+      make_pair("BuildTokenArray", stopwatch.GetElapsedMilliseconds()));
 }
 
 void SystemDictionaryBuilder::WriteToFile(const string &output_file) const {
@@ -161,6 +270,22 @@ void SystemDictionaryBuilder::WriteToStream(
     file_codec->GetSectionName(codec_->GetSectionNameForPos()));
   sections.push_back(frequent_pos_section);
 
+  DictionaryFileSection reverse_lookup_section(
+    reverse_lookup_index_builder_->image().data(),
+    reverse_lookup_index_builder_->image().size(),
+    file_codec->GetSectionName(codec_->GetSectionNameForReverseLookup()));
+  sections.push_back(reverse_lookup_section);
+
+  // The section is optional, and SystemDictionary falls back to the normal
+  // predictive lookup without it.
+  DictionaryFileSection key_costs_section(
+    reinterpret_cast<const char *>(key_trie_node_costs_.data()),
+    key_trie_node_costs_.size() * sizeof(key_trie_node_costs_[0]),
+    file_codec->GetSectionName(codec_->GetSectionNameForKeyCosts()));
+  if (!key_trie_node_costs_.empty()) {
+    sections.push_back(key_costs_section);
+  }
+
   if (FLAGS_preserve_intermediate_dictionary &&
       !intermediate_output_file_base_path.empty()) {
     // Write out intermediate results to files.
@@ -170,6 +295,10 @@ void SystemDictionaryBuilder::WriteToStream(
     WriteSectionToFile(key_trie_section, basepath + ".key");
     WriteSectionToFile(token_array_section, basepath + ".tokens");
     WriteSectionToFile(frequent_pos_section, basepath + ".freq_pos");
+    WriteSectionToFile(reverse_lookup_section, basepath + ".reverse");
+    if (!key_trie_node_costs_.empty()) {
+      WriteSectionToFile(key_costs_section, basepath + ".key_costs");
+    }
   }
 
   LOG(INFO) << "Start writing dictionary file.";
@@ -220,8 +349,116 @@ struct TokenPtrLessThan {
   }
 };
 
+void CountPos(const SystemDictionaryBuilder::KeyInfo &key_info,
+              map<uint32, int> *pos_map) {
+  for (size_t i = 0; i < key_info.tokens.size(); ++i) {
+    const Token *token = key_info.tokens[i].token;
+    (*pos_map)[GetCombinedPos(token->lid, token->rid)]++;
+  }
+}
+
+// Reads the tokens sorted by TokenSorter as KeyInfo, which is the same as
+// the one ReadTokens() makes for the key.
+class KeyInfoReader {
+ public:
+  explicit KeyInfoReader(TokenSorter *sorter)
+      : sorter_(sorter), has_next_(false) {
+    sorter_->Rewind();
+    has_next_ = sorter_->Next(&next_);
+  }
+
+  // Returns false at the end. The tokens of |key_info| are valid until the
+  // next call.
+  bool Read(SystemDictionaryBuilder::KeyInfo *key_info) {
+    if (!has_next_) {
+      return false;
+    }
+    tokens_.clear();
+    key_info->id_in_key_trie = -1;
+    key_info->key = next_.key;
+    do {
+      tokens_.push_back(next_);
+      has_next_ = sorter_->Next(&next_);
+    } while (has_next_ && next_.key == key_info->key);
+
+    key_info->tokens.clear();
+    for (size_t i = 0; i < tokens_.size(); ++i) {
+      key_info->tokens.push_back(TokenInfo(&tokens_[i]));
+      key_info->tokens.back().value_type = GetValueType(&tokens_[i]);
+    }
+    return true;
+  }
+
+ private:
+  TokenSorter *sorter_;
+  Token next_;
+  bool has_next_;
+  vector<Token> tokens_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyInfoReader);
+};
+
 }  // namespace
 
+void SystemDictionaryBuilder::BuildFromAddedTokens() {
+  stage_timings_.clear();
+  Stopwatch stopwatch = Stopwatch::StartNew();
+
+  if (token_sorter_.get() == NULL) {
+    token_sorter_.reset(
+        new TokenSorter(sort_buffer_size_, temporary_file_prefix_));
+  }
+  token_sorter_->Finish();
+  stage_timings_.push_back(
+      make_pair("SortTokens", stopwatch.GetElapsedMilliseconds()));
+
+  // First pass: collects POS frequencies, values and keys.
+  stopwatch.Reset();
+  stopwatch.Start();
+  KeyInfo key_info;
+  size_t num_keys = 0;
+  {
+    map<uint32, int> pos_map;
+    KeyInfoReader reader(token_sorter_.get());
+    while (reader.Read(&key_info)) {
+      CountPos(key_info, &pos_map);
+      AddValuesToTrie(key_info);
+      AddKeyToTrie(key_info);
+      ++num_keys;
+    }
+    SetFrequentPos(pos_map);
+  }
+  stage_timings_.push_back(
+      make_pair("ScanTokens", stopwatch.GetElapsedMilliseconds()));
+
+  stopwatch.Reset();
+  stopwatch.Start();
+  value_trie_builder_->set_num_threads(num_threads_);
+  value_trie_builder_->Build();
+  key_trie_builder_->set_num_threads(num_threads_);
+  key_trie_builder_->Build();
+  stage_timings_.push_back(
+      make_pair("BuildTries", stopwatch.GetElapsedMilliseconds()));
+
+  // Second pass: encodes the tokens of each key.
+  stopwatch.Reset();
+  stopwatch.Start();
+  {
+    vector<string> encoded_tokens(num_keys);
+    KeyInfoReader reader(token_sorter_.get());
+    while (reader.Read(&key_info)) {
+      SetTokenInfoForKey(&key_info);
+      codec_->EncodeTokens(key_info.tokens,
+                           &encoded_tokens[key_info.id_in_key_trie]);
+    }
+    BuildTokenArrayFromEncodedTokens(&encoded_tokens);
+  }
+  stage_timings_.push_back(
+      make_pair("BuildTokenArray", stopwatch.GetElapsedMilliseconds()));
+
+  token_sorter_.reset(NULL);
+}
+
 void SystemDictionaryBuilder::ReadTokens(const vector<Token *> &tokens,
                                          KeyInfoList *key_info_list) const {
   // Create KeyInfoList in two steps.
@@ -241,7 +478,8 @@ void SystemDictionaryBuilder::ReadTokens(const vector<Token *> &tokens,
     CHECK(!token->value.empty()) << "empty value string in input";
     reduce_buffer.push_back(token);
   }
-  stable_sort(reduce_buffer.begin(), reduce_buffer.end(), TokenPtrLessThan());
+  ParallelStableSort(reduce_buffer.begin(), reduce_buffer.end(),
+                     TokenPtrLessThan(), num_threads_);
 
   // Step 2.
   key_info_list->clear();
@@ -272,13 +510,13 @@ void SystemDictionaryBuilder::BuildFrequentPos(
   map<uint32, int> pos_map;
   for (KeyInfoList::const_iterator itr = key_info_list.begin();
        itr != key_info_list.end(); ++itr) {
-    const KeyInfo &key_info = *itr;
-    for (size_t i = 0; i < key_info.tokens.size(); ++i) {
-      const Token *token = key_info.tokens[i].token;
-      pos_map[GetCombinedPos(token->lid, token->rid)]++;
-    }
+    CountPos(*itr, &pos_map);
   }
+  SetFrequentPos(pos_map);
+}
 
+void SystemDictionaryBuilder::SetFrequentPos(
+    const map<uint32, int> &pos_map) {
   // Get histgram of frequency
   map<int, int> freq_map;
   for (map<uint32, int>::const_iterator jt = pos_map.begin();
@@ -302,7 +540,7 @@ void SystemDictionaryBuilder::BuildFrequentPos(
   VLOG(1) << "Pos threshold=" << freq_threshold;
   int freq_pos_idx = 0;
   int num_tokens = 0;
-  map<uint32, int>::iterator lt;
+  map<uint32, int>::const_iterator lt;
   for (lt = pos_map.begin(); lt != pos_map.end(); ++lt) {
     if (lt->second >= freq_threshold) {
       frequent_pos_[lt->first] = freq_pos_idx;
@@ -317,101 +555,150 @@ void SystemDictionaryBuilder::BuildFrequentPos(
 }
 
 
+vector<size_t> SystemDictionaryBuilder::GetShardBoundaries(
+    size_t size) const {
+  const size_t num_shards = max<size_t>(min<size_t>(num_threads_, size), 1);
+  vector<size_t> boundaries;
+  for (size_t i = 0; i < num_shards; ++i) {
+    boundaries.push_back(size * i / num_shards);
+  }
+  boundaries.push_back(size);
+  return boundaries;
+}
+
+void SystemDictionaryBuilder::BuildTries(const KeyInfoList &key_info_list) {
+  if (num_threads_ <= 1) {
+    BuildValueTrie(key_info_list);
+    BuildKeyTrie(key_info_list);
+    return;
+  }
+
+  // Each trie sorts its words with half of the threads.
+  const int num_threads_per_trie = max(num_threads_ / 2, 1);
+  value_trie_builder_->set_num_threads(num_threads_per_trie);
+  key_trie_builder_->set_num_threads(num_threads_per_trie);
+
+  // The workers don't modify the list.
+  KeyInfoList *list = const_cast<KeyInfoList *>(&key_info_list);
+  vector<Thread *> threads;
+  threads.push_back(
+      new Worker(Worker::BUILD_VALUE_TRIE, this, list, 0, 0, NULL));
+  threads.push_back(
+      new Worker(Worker::BUILD_KEY_TRIE, this, list, 0, 0, NULL));
+  RunAndJoin(&threads);
+}
+
 void SystemDictionaryBuilder::BuildValueTrie(const KeyInfoList &key_info_list) {
   for (KeyInfoList::const_iterator itr = key_info_list.begin();
        itr != key_info_list.end(); ++itr) {
-    const KeyInfo &key_info = *itr;
-    for (size_t i = 0; i < key_info.tokens.size(); ++i) {
-      const TokenInfo &token_info = key_info.tokens[i];
-      if (token_info.value_type == TokenInfo::AS_IS_HIRAGANA ||
-          token_info.value_type == TokenInfo::AS_IS_KATAKANA) {
-        // These values will be stored in token array as flags
-        continue;
-      }
-      string value_str;
-      codec_->EncodeValue(token_info.token->value, &value_str);
-      value_trie_builder_->Add(value_str);
-    }
+    AddValuesToTrie(*itr);
   }
   value_trie_builder_->Build();
 }
 
-void SystemDictionaryBuilder::SetIdForValue(KeyInfoList *key_info_list) const {
-  for (KeyInfoList::iterator itr = key_info_list->begin();
-       itr != key_info_list->end(); ++itr) {
-    for (size_t i = 0; i < itr->tokens.size(); ++i) {
-      TokenInfo *token_info = &(itr->tokens[i]);
-      string value_str;
-      codec_->EncodeValue(token_info->token->value, &value_str);
-      token_info->id_in_value_trie =
-          value_trie_builder_->GetId(value_str);
+void SystemDictionaryBuilder::AddValuesToTrie(const KeyInfo &key_info) {
+  for (size_t i = 0; i < key_info.tokens.size(); ++i) {
+    const TokenInfo &token_info = key_info.tokens[i];
+    if (token_info.value_type == TokenInfo::AS_IS_HIRAGANA ||
+        token_info.value_type == TokenInfo::AS_IS_KATAKANA) {
+      // These values will be stored in token array as flags
+      continue;
     }
+    string value_str;
+    codec_->EncodeValue(token_info.token->value, &value_str);
+    value_trie_builder_->Add(value_str);
+  }
+}
+
+void SystemDictionaryBuilder::SetTokenInfo(KeyInfoList *key_info_list) {
+  if (num_threads_ <= 1) {
+    SetTokenInfoInRange(key_info_list->begin(), key_info_list->end());
+    return;
   }
+
+  const vector<size_t> boundaries =
+      GetShardBoundaries(key_info_list->size());
+  vector<Thread *> threads;
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    threads.push_back(new Worker(Worker::SET_TOKEN_INFO, this, key_info_list,
+                                 boundaries[i], boundaries[i + 1], NULL));
+  }
+  RunAndJoin(&threads);
 }
 
-void SystemDictionaryBuilder::SortTokenInfo(KeyInfoList *key_info_list) const {
-  for (KeyInfoList::iterator itr = key_info_list->begin();
-       itr != key_info_list->end(); ++itr) {
-    KeyInfo *key_info = &(*itr);
-    sort(key_info->tokens.begin(), key_info->tokens.end(), TokenGreaterThan());
+void SystemDictionaryBuilder::SetTokenInfoInRange(
+    KeyInfoList::iterator begin, KeyInfoList::iterator end) const {
+  for (KeyInfoList::iterator itr = begin; itr != end; ++itr) {
+    SetTokenInfoForKey(&(*itr));
   }
 }
 
-void SystemDictionaryBuilder::SetCostType(KeyInfoList *key_info_list) const {
-  for (KeyInfoList::iterator itr = key_info_list->begin();
-       itr != key_info_list->end(); ++itr) {
-    KeyInfo *key_info = &(*itr);
-    if (HasHomonymsInSamePos(*key_info)) {
-      continue;
-    }
-    for (size_t i = 0; i < key_info->tokens.size(); ++i) {
-      TokenInfo *token_info = &key_info->tokens[i];
-      const int key_len = Util::CharsLen(token_info->token->key);
-      if (key_len >= FLAGS_min_key_length_to_use_small_cost_encoding) {
-        token_info->cost_type = TokenInfo::CAN_USE_SMALL_ENCODING;
-      }
+void SystemDictionaryBuilder::SetTokenInfoForKey(KeyInfo *key_info) const {
+  SetIdForValue(key_info);
+  SetIdForKey(key_info);
+  SortTokenInfo(key_info);
+  SetCostType(key_info);
+  SetPosType(key_info);
+  SetValueType(key_info);
+}
+
+void SystemDictionaryBuilder::SetIdForValue(KeyInfo *key_info) const {
+  for (size_t i = 0; i < key_info->tokens.size(); ++i) {
+    TokenInfo *token_info = &(key_info->tokens[i]);
+    string value_str;
+    codec_->EncodeValue(token_info->token->value, &value_str);
+    token_info->id_in_value_trie =
+        value_trie_builder_->GetId(value_str);
+  }
+}
+
+void SystemDictionaryBuilder::SortTokenInfo(KeyInfo *key_info) const {
+  sort(key_info->tokens.begin(), key_info->tokens.end(), TokenGreaterThan());
+}
+
+void SystemDictionaryBuilder::SetCostType(KeyInfo *key_info) const {
+  if (HasHomonymsInSamePos(*key_info)) {
+    return;
+  }
+  for (size_t i = 0; i < key_info->tokens.size(); ++i) {
+    TokenInfo *token_info = &key_info->tokens[i];
+    const int key_len = Util::CharsLen(token_info->token->key);
+    if (key_len >= FLAGS_min_key_length_to_use_small_cost_encoding) {
+      token_info->cost_type = TokenInfo::CAN_USE_SMALL_ENCODING;
     }
   }
 }
 
-void SystemDictionaryBuilder::SetPosType(KeyInfoList *key_info_list) const {
-  for (KeyInfoList::iterator itr = key_info_list->begin();
-       itr != key_info_list->end(); ++itr) {
-    KeyInfo *key_info = &(*itr);
-    for (size_t i = 0; i < key_info->tokens.size(); ++i) {
-      TokenInfo *token_info = &(key_info->tokens[i]);
-      const uint32 pos = GetCombinedPos(token_info->token->lid,
-                                        token_info->token->rid);
-      map<uint32, int>::const_iterator itr = frequent_pos_.find(pos);
-      if (itr != frequent_pos_.end()) {
-        token_info->pos_type = TokenInfo::FREQUENT_POS;
-        token_info->id_in_frequent_pos_map = itr->second;
-      }
-      if (i >= 1) {
-        const TokenInfo &prev_token_info = key_info->tokens[i - 1];
-        const uint32 prev_pos = GetCombinedPos(prev_token_info.token->lid,
-                                               prev_token_info.token->rid);
-        if (prev_pos == pos) {
-          // we can overwrite FREQUENT_POS
-          token_info->pos_type = TokenInfo::SAME_AS_PREV_POS;
-        }
+void SystemDictionaryBuilder::SetPosType(KeyInfo *key_info) const {
+  for (size_t i = 0; i < key_info->tokens.size(); ++i) {
+    TokenInfo *token_info = &(key_info->tokens[i]);
+    const uint32 pos = GetCombinedPos(token_info->token->lid,
+                                      token_info->token->rid);
+    map<uint32, int>::const_iterator itr = frequent_pos_.find(pos);
+    if (itr != frequent_pos_.end()) {
+      token_info->pos_type = TokenInfo::FREQUENT_POS;
+      token_info->id_in_frequent_pos_map = itr->second;
+    }
+    if (i >= 1) {
+      const TokenInfo &prev_token_info = key_info->tokens[i - 1];
+      const uint32 prev_pos = GetCombinedPos(prev_token_info.token->lid,
+                                             prev_token_info.token->rid);
+      if (prev_pos == pos) {
+        // we can overwrite FREQUENT_POS
+        token_info->pos_type = TokenInfo::SAME_AS_PREV_POS;
       }
     }
   }
 }
 
-void SystemDictionaryBuilder::SetValueType(KeyInfoList *key_info_list) const {
-  for (KeyInfoList::iterator itr = key_info_list->begin();
-       itr != key_info_list->end(); ++itr) {
-    KeyInfo *key_info = &(*itr);
-    for (size_t i = 1; i < key_info->tokens.size(); ++i) {
-      const TokenInfo *prev_token_info = &(key_info->tokens[i - 1]);
-      TokenInfo *token_info = &(key_info->tokens[i]);
-      if (token_info->value_type != TokenInfo::AS_IS_HIRAGANA &&
-          token_info->value_type != TokenInfo::AS_IS_KATAKANA &&
-          (token_info->token->value == prev_token_info->token->value)) {
-        token_info->value_type = TokenInfo::SAME_AS_PREV_VALUE;
-      }
+void SystemDictionaryBuilder::SetValueType(KeyInfo *key_info) const {
+  for (size_t i = 1; i < key_info->tokens.size(); ++i) {
+    const TokenInfo *prev_token_info = &(key_info->tokens[i - 1]);
+    TokenInfo *token_info = &(key_info->tokens[i]);
+    if (token_info->value_type != TokenInfo::AS_IS_HIRAGANA &&
+        token_info->value_type != TokenInfo::AS_IS_KATAKANA &&
+        (token_info->token->value == prev_token_info->token->value)) {
+      token_info->value_type = TokenInfo::SAME_AS_PREV_VALUE;
     }
   }
 }
@@ -419,49 +706,135 @@ void SystemDictionaryBuilder::SetValueType(KeyInfoList *key_info_list) const {
 void SystemDictionaryBuilder::BuildKeyTrie(const KeyInfoList &key_info_list) {
   for (KeyInfoList::const_iterator itr = key_info_list.begin();
        itr != key_info_list.end(); ++itr) {
-    string key_str;
-    codec_->EncodeKey(itr->key, &key_str);
-    key_trie_builder_->Add(key_str);
+    AddKeyToTrie(*itr);
   }
   key_trie_builder_->Build();
 }
 
-void SystemDictionaryBuilder::SetIdForKey(KeyInfoList *key_info_list) const {
-  for (KeyInfoList::iterator itr = key_info_list->begin();
-       itr != key_info_list->end(); ++itr) {
-    KeyInfo *key_info = &(*itr);
-    string key_str;
-    codec_->EncodeKey(key_info->key, &key_str);
-    key_info->id_in_key_trie =
-        key_trie_builder_->GetId(key_str);
+void SystemDictionaryBuilder::AddKeyToTrie(const KeyInfo &key_info) {
+  string key_str;
+  codec_->EncodeKey(key_info.key, &key_str);
+  key_trie_builder_->Add(key_str);
+}
+
+void SystemDictionaryBuilder::SetIdForKey(KeyInfo *key_info) const {
+  string key_str;
+  codec_->EncodeKey(key_info->key, &key_str);
+  key_info->id_in_key_trie =
+      key_trie_builder_->GetId(key_str);
+}
+
+void SystemDictionaryBuilder::EncodeTokensInRange(
+    KeyInfoList::const_iterator begin, KeyInfoList::const_iterator end,
+    vector<string> *encoded_tokens) const {
+  for (KeyInfoList::const_iterator itr = begin; itr != end; ++itr) {
+    codec_->EncodeTokens(itr->tokens,
+                         &(*encoded_tokens)[itr->id_in_key_trie]);
   }
 }
 
 void SystemDictionaryBuilder::BuildTokenArray(
     const KeyInfoList &key_info_list) {
-  // Here we make a reverse lookup table as follows:
-  //   |key_info_list[X].id_in_key_trie| -> |key_info_list[X]|
-  // assuming |key_info_list[X].id_in_key_trie| is unique and successive.
-  {
-    vector<const KeyInfo *> id_to_keyinfo_table;
-    id_to_keyinfo_table.resize(key_info_list.size());
+  if (num_threads_ <= 1) {
+    // Encodes the tokens of each key in the order of the key trie and adds
+    // them right away, so that the encoded tokens of all the keys are not
+    // kept besides the copy in |token_array_builder_|.
+    vector<const KeyInfo *> key_infos(key_info_list.size(), NULL);
     for (KeyInfoList::const_iterator itr = key_info_list.begin();
          itr != key_info_list.end(); ++itr) {
-      const KeyInfo &key_info = *itr;
-      const int id = key_info.id_in_key_trie;
-      id_to_keyinfo_table[id] = &key_info;
+      DCHECK_GE(itr->id_in_key_trie, 0);
+      DCHECK_LT(itr->id_in_key_trie, key_infos.size());
+      key_infos[itr->id_in_key_trie] = &(*itr);
+    }
+    vector<uint16> key_costs;
+    key_costs.reserve(key_infos.size());
+    string encoded_tokens;
+    for (size_t i = 0; i < key_infos.size(); ++i) {
+      DCHECK(key_infos[i] != NULL);
+      codec_->EncodeTokens(key_infos[i]->tokens, &encoded_tokens);
+      AddEncodedTokens(encoded_tokens, &key_costs);
     }
+    FinishTokenArray(key_costs);
+    return;
+  }
+
+  // Here we encode the tokens into a table indexed by
+  // |key_info_list[X].id_in_key_trie|, assuming it is unique and successive,
+  // so that the token array is in the order of the key trie.
+  vector<string> encoded_tokens(key_info_list.size());
+  // The workers don't modify the list.
+  KeyInfoList *list = const_cast<KeyInfoList *>(&key_info_list);
+  const vector<size_t> boundaries = GetShardBoundaries(key_info_list.size());
+  vector<Thread *> threads;
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    threads.push_back(new Worker(Worker::ENCODE_TOKENS, this, list,
+                                 boundaries[i], boundaries[i + 1],
+                                 &encoded_tokens));
+  }
+  RunAndJoin(&threads);
+  BuildTokenArrayFromEncodedTokens(&encoded_tokens);
+}
+
+void SystemDictionaryBuilder::BuildTokenArrayFromEncodedTokens(
+    vector<string> *encoded_tokens) {
+  vector<uint16> key_costs;
+  key_costs.reserve(encoded_tokens->size());
+  for (size_t i = 0; i < encoded_tokens->size(); ++i) {
+    AddEncodedTokens((*encoded_tokens)[i], &key_costs);
+    // |token_array_builder_| has its own copy.
+    string().swap((*encoded_tokens)[i]);
+  }
+  FinishTokenArray(key_costs);
+}
 
-    for (size_t i = 0; i < id_to_keyinfo_table.size(); ++i) {
-      const KeyInfo &key_info = *id_to_keyinfo_table[i];
-      string tokens_str;
-      codec_->EncodeTokens(key_info.tokens, &tokens_str);
-      token_array_builder_->Add(tokens_str);
+void SystemDictionaryBuilder::AddEncodedTokens(const string &encoded_tokens,
+                                               vector<uint16> *key_costs) {
+  const int key_id = key_costs->size();
+  token_array_builder_->Add(encoded_tokens);
+
+  // Uses the decoded costs, which may lose the lower bits by the small cost
+  // encoding, as they are the costs actually looked up.
+  uint16 key_cost = kuint16max;
+  if (FLAGS_build_key_trie_node_costs) {
+    Token token;
+    TokenInfo token_info(&token);
+    const uint8 *ptr =
+        reinterpret_cast<const uint8 *>(encoded_tokens.data());
+    bool has_next = true;
+    while (has_next) {
+      int read_bytes = 0;
+      has_next = codec_->DecodeToken(ptr, &token_info, &read_bytes);
+      key_cost = min(key_cost, static_cast<uint16>(token.cost));
+      ptr += read_bytes;
+    }
+  }
+  key_costs->push_back(key_cost);
+
+  // Registers the value ids of the tokens for reverse lookup. Tokens
+  // without value id (e.g. hiragana or katakana values same as their keys)
+  // are found by T13N lookup instead.
+  const uint8 *ptr = reinterpret_cast<const uint8 *>(encoded_tokens.data());
+  bool has_next = true;
+  while (has_next) {
+    int value_id = -1;
+    int read_bytes = 0;
+    has_next = codec_->ReadTokenForReverseLookup(ptr, &value_id, &read_bytes);
+    if (value_id != -1) {
+      reverse_lookup_index_builder_->Add(value_id, key_id);
     }
+    ptr += read_bytes;
   }
+}
 
+void SystemDictionaryBuilder::FinishTokenArray(
+    const vector<uint16> &key_costs) {
   token_array_builder_->Add(string(1, codec_->GetTokensTerminationFlag()));
   token_array_builder_->Build();
+  reverse_lookup_index_builder_->Build();
+  key_trie_node_costs_.clear();
+  if (FLAGS_build_key_trie_node_costs) {
+    key_trie_builder_->GetSubtreeMinCosts(key_costs, &key_trie_node_costs_);
+  }
 }
 
 }  // namespace dictionary
@@ -34,6 +34,7 @@
 #include <map>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/port.h"
@@ -52,7 +53,9 @@ class LoudsTrieBuilder;
 }  // namespace storage
 
 namespace dictionary {
+class ReverseLookupIndexBuilder;
 class SystemDictionaryCodecInterface;
+class TokenSorter;
 
 class SystemDictionaryBuilder {
  public:
@@ -68,8 +71,38 @@ class SystemDictionaryBuilder {
   SystemDictionaryBuilder();
   explicit SystemDictionaryBuilder(const SystemDictionaryCodecInterface *codec);
   virtual ~SystemDictionaryBuilder();
+
+  // Sets the number of threads used by BuildFromTokens(). The built image
+  // is byte-identical regardless of the number of threads. Default is 1.
+  void set_num_threads(int num_threads);
+
   void BuildFromTokens(const vector<Token *> &tokens);
 
+  // Sets the max size in bytes of the tokens kept in memory by AddToken().
+  // Beyond that, sorted runs of tokens are written to temporary files named
+  // with |temporary_file_prefix|. 0 means no limit, which is the default.
+  // Must be called before AddToken().
+  void set_sort_buffer_size(size_t sort_buffer_size,
+                            const string &temporary_file_prefix);
+
+  // Adds a token to be built by BuildFromAddedTokens(). The token is copied
+  // into a compact buffer, so the caller can reuse it.
+  void AddToken(const Token &token);
+
+  // Builds the dictionary from the tokens added by AddToken(). The image is
+  // byte-identical to the one BuildFromTokens() builds from the same tokens
+  // in the same order, while only the tokens of one key are expanded to
+  // Token objects at a time.
+  void BuildFromAddedTokens();
+
+  // Pairs of a build stage name and its elapsed time in milliseconds,
+  // recorded by the last BuildFromTokens() or BuildFromAddedTokens() in
+  // execution order.
+  typedef vector<pair<string, int64> > StageTimings;
+  const StageTimings &stage_timings() const {
+    return stage_timings_;
+  }
+
   void WriteToFile(const string &output_file) const;
   void WriteToStream(const string &intermediate_output_file_base_path,
                      ostream *output_stream) const;
@@ -77,35 +110,93 @@ class SystemDictionaryBuilder {
  private:
   typedef deque<KeyInfo> KeyInfoList;
 
+  // Thread running one of the build stages on a part of KeyInfoList.
+  class Worker;
+
   void ReadTokens(const vector<Token *>& tokens,
                   KeyInfoList *key_info_list) const;
 
   void BuildFrequentPos(const KeyInfoList &key_info_list);
 
+  // Sets |frequent_pos_| from the count of each combined POS.
+  void SetFrequentPos(const map<uint32, int> &pos_map);
+
+  // Builds the value trie and the key trie. They are built concurrently
+  // when more than one thread is available.
+  void BuildTries(const KeyInfoList &key_info_list);
+
   void BuildValueTrie(const KeyInfoList &key_info_list);
+  void AddValuesToTrie(const KeyInfo &key_info);
 
   void BuildKeyTrie(const KeyInfoList &key_info_list);
+  void AddKeyToTrie(const KeyInfo &key_info);
 
   void BuildTokenArray(const KeyInfoList &key_info_list);
 
-  void SetIdForValue(KeyInfoList *key_info_list) const;
-  void SetIdForKey(KeyInfoList *key_info_list) const;
-  void SortTokenInfo(KeyInfoList *key_info_list) const;
-
-  void SetCostType(KeyInfoList *key_info_list) const;
-  void SetPosType(KeyInfoList *keyinfomap) const;
-  void SetValueType(KeyInfoList *key_info_list) const;
+  // Builds the token array, the reverse lookup index and the min costs of the
+  // key trie nodes from the tokens encoded for each key, indexed by the id in
+  // key trie. Each string of |encoded_tokens| is released once it is added.
+  void BuildTokenArrayFromEncodedTokens(vector<string> *encoded_tokens);
+
+  // Adds the encoded tokens of the key whose id in key trie is
+  // key_costs->size() to the token array and the reverse lookup index, and
+  // appends the min cost of the tokens to |key_costs|.
+  void AddEncodedTokens(const string &encoded_tokens,
+                        vector<uint16> *key_costs);
+
+  // Builds the token array and the reverse lookup index, and the min costs
+  // of the key trie nodes from |key_costs| indexed by the id in key trie.
+  void FinishTokenArray(const vector<uint16> &key_costs);
+
+  // Fills the ids and the types of the tokens of all the key infos, and
+  // sorts them. Each key info is processed independently, so the list is
+  // split into shards processed by |num_threads_| threads.
+  void SetTokenInfo(KeyInfoList *key_info_list);
+  void SetTokenInfoInRange(KeyInfoList::iterator begin,
+                           KeyInfoList::iterator end) const;
+  void SetTokenInfoForKey(KeyInfo *key_info) const;
+
+  // Encodes the tokens of the key infos in [begin, end) and stores them to
+  // |encoded_tokens| indexed by the id in key trie.
+  void EncodeTokensInRange(KeyInfoList::const_iterator begin,
+                           KeyInfoList::const_iterator end,
+                           vector<string> *encoded_tokens) const;
+
+  void SetIdForValue(KeyInfo *key_info) const;
+  void SetIdForKey(KeyInfo *key_info) const;
+  void SortTokenInfo(KeyInfo *key_info) const;
+
+  void SetCostType(KeyInfo *key_info) const;
+  void SetPosType(KeyInfo *key_info) const;
+  void SetValueType(KeyInfo *key_info) const;
+
+  // Returns the boundaries of |num_threads_| shards of [0, size).
+  vector<size_t> GetShardBoundaries(size_t size) const;
 
   scoped_ptr<mozc::storage::louds::LoudsTrieBuilder> value_trie_builder_;
   scoped_ptr<mozc::storage::louds::LoudsTrieBuilder> key_trie_builder_;
   scoped_ptr<mozc::storage::louds::BitVectorBasedArrayBuilder>
       token_array_builder_;
+  scoped_ptr<ReverseLookupIndexBuilder> reverse_lookup_index_builder_;
+
+  // Minimum cost of the tokens in the subtree of each key trie node, which
+  // is used for the predictive lookup in cost order. Empty unless
+  // --build_key_trie_node_costs is set.
+  vector<uint16> key_trie_node_costs_;
 
   // mapping from {left_id, right_id} to POS index (0--255)
   map<uint32, int> frequent_pos_;
 
   const SystemDictionaryCodecInterface *codec_;
 
+  int num_threads_;
+  StageTimings stage_timings_;
+
+  // Tokens added by AddToken().
+  size_t sort_buffer_size_;
+  string temporary_file_prefix_;
+  scoped_ptr<TokenSorter> token_sorter_;
+
   DISALLOW_COPY_AND_ASSIGN(SystemDictionaryBuilder);
 };
 }  // namespace dictionary
@@ -33,6 +33,7 @@
 #include "dictionary/system/system_dictionary_builder.h"
 
 #include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -51,6 +52,7 @@ DEFINE_string(input,
               "input file");
 DEFINE_int32(dictionary_test_size, 10000,
              "Dictionary size for this test");
+DECLARE_string(test_tmpdir);
 
 namespace mozc {
 namespace dictionary {
@@ -78,5 +80,72 @@ TEST_F(SystemDictionaryBuilderTest, test) {
   builder.BuildFromTokens(tokens);
 }
 
+TEST_F(SystemDictionaryBuilderTest, MultiThreadedBuildIsDeterministic) {
+  const POSMatcher *pos_matcher =
+      UserPosManager::GetUserPosManager()->GetPOSMatcher();
+  TextDictionaryLoader loader(*pos_matcher);
+  const string dic_path = FileUtil::JoinPath(FLAGS_test_srcdir, FLAGS_input);
+  loader.LoadWithLineLimit(dic_path, "", FLAGS_dictionary_test_size);
+  const vector<Token *> &tokens = loader.tokens();
+
+  string expected;
+  {
+    SystemDictionaryBuilder builder;
+    builder.BuildFromTokens(tokens);
+    ostringstream stream;
+    builder.WriteToStream("", &stream);
+    expected = stream.str();
+  }
+  ASSERT_FALSE(expected.empty());
+
+  const int kNumThreads[] = { 2, 3, 8 };
+  for (size_t i = 0; i < arraysize(kNumThreads); ++i) {
+    SystemDictionaryBuilder builder;
+    builder.set_num_threads(kNumThreads[i]);
+    builder.BuildFromTokens(tokens);
+    ostringstream stream;
+    builder.WriteToStream("", &stream);
+    EXPECT_TRUE(expected == stream.str())
+        << "Different image with " << kNumThreads[i] << " threads";
+
+    // All the stages are timed.
+    EXPECT_EQ(5, builder.stage_timings().size());
+  }
+}
+
+TEST_F(SystemDictionaryBuilderTest, BuildFromAddedTokens) {
+  const POSMatcher *pos_matcher =
+      UserPosManager::GetUserPosManager()->GetPOSMatcher();
+  TextDictionaryLoader loader(*pos_matcher);
+  const string dic_path = FileUtil::JoinPath(FLAGS_test_srcdir, FLAGS_input);
+  loader.LoadWithLineLimit(dic_path, "", FLAGS_dictionary_test_size);
+  const vector<Token *> &tokens = loader.tokens();
+
+  string expected;
+  {
+    SystemDictionaryBuilder builder;
+    builder.BuildFromTokens(tokens);
+    ostringstream stream;
+    builder.WriteToStream("", &stream);
+    expected = stream.str();
+  }
+
+  // 0 keeps all the tokens in memory, and the others write sorted runs.
+  const size_t kSortBufferSizes[] = { 0, 4096, 65536 };
+  for (size_t i = 0; i < arraysize(kSortBufferSizes); ++i) {
+    SystemDictionaryBuilder builder;
+    builder.set_sort_buffer_size(
+        kSortBufferSizes[i], FileUtil::JoinPath(FLAGS_test_tmpdir, "sort"));
+    for (size_t j = 0; j < tokens.size(); ++j) {
+      builder.AddToken(*tokens[j]);
+    }
+    builder.BuildFromAddedTokens();
+    ostringstream stream;
+    builder.WriteToStream("", &stream);
+    EXPECT_TRUE(expected == stream.str())
+        << "Different image with sort buffer size " << kSortBufferSizes[i];
+  }
+}
+
 }  // namespace dictionary
 }  // namespace mozc
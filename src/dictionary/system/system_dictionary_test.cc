@@ -29,6 +29,7 @@
 
 #include "dictionary/system/system_dictionary.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 #include <utility>
@@ -40,14 +41,18 @@
 #include "base/stl_util.h"
 #include "base/system_util.h"
 #include "base/util.h"
+#include "config/config.pb.h"
+#include "converter/conversion_request.h"
 #include "converter/node_allocator.h"
 #include "data_manager/user_pos_manager.h"
 #include "dictionary/dictionary_test_util.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
 #include "dictionary/system/codec_interface.h"
+#include "dictionary/system/reverse_lookup_index.h"
 #include "dictionary/system/system_dictionary_builder.h"
 #include "dictionary/text_dictionary_loader.h"
+#include "session/commands.pb.h"
 #include "testing/base/public/googletest.h"
 #include "testing/base/public/gunit.h"
 
@@ -79,17 +84,11 @@ DEFINE_int32(dictionary_reverse_lookup_test_size, kDefaultReverseLookupTestSize,
 DECLARE_string(test_srcdir);
 DECLARE_string(test_tmpdir);
 DECLARE_int32(min_key_length_to_use_small_cost_encoding);
+DECLARE_bool(build_key_trie_node_costs);
 
 namespace mozc {
 namespace dictionary {
 
-namespace {
-
-const bool kEnableKanaModiferInsensitiveLookup = true;
-const bool kDisableKanaModiferInsensitiveLookup = false;
-
-}  // namespace
-
 using mozc::storage::louds::KeyExpansionTable;
 
 class SystemDictionaryTest : public testing::Test {
@@ -101,6 +100,16 @@ class SystemDictionaryTest : public testing::Test {
     const string dic_path = FileUtil::JoinPath(FLAGS_test_srcdir,
                                                FLAGS_dictionary_source);
     text_dict_->LoadWithLineLimit(dic_path, "", FLAGS_dictionary_test_size);
+
+    // Kana modifier insensitive lookup has to be enabled by both the request
+    // and the config.
+    kana_insensitive_request_.set_kana_modifier_insensitive_conversion(true);
+    config::Config kana_insensitive_config;
+    kana_insensitive_config.set_use_kana_modifier_insensitive_conversion(
+        true);
+    kana_insensitive_convreq_.set_request(&kana_insensitive_request_);
+    kana_insensitive_convreq_.set_config(
+        config::ConfigSnapshot(kana_insensitive_config));
   }
 
   virtual void SetUp() {
@@ -110,11 +119,14 @@ class SystemDictionaryTest : public testing::Test {
     original_flags_min_key_length_to_use_small_cost_encoding_ =
         FLAGS_min_key_length_to_use_small_cost_encoding;
     FLAGS_min_key_length_to_use_small_cost_encoding = kint32max;
+    original_flags_build_key_trie_node_costs_ =
+        FLAGS_build_key_trie_node_costs;
   }
 
   virtual void TearDown() {
     FLAGS_min_key_length_to_use_small_cost_encoding =
         original_flags_min_key_length_to_use_small_cost_encoding_;
+    FLAGS_build_key_trie_node_costs = original_flags_build_key_trie_node_costs_;
   }
 
   void BuildSystemDictionary(const vector <Token *>& tokens,
@@ -125,7 +137,11 @@ class SystemDictionaryTest : public testing::Test {
 
   scoped_ptr<TextDictionaryLoader> text_dict_;
   const string dic_fn_;
+  ConversionRequest convreq_;
+  commands::Request kana_insensitive_request_;
+  ConversionRequest kana_insensitive_convreq_;
   int original_flags_min_key_length_to_use_small_cost_encoding_;
+  bool original_flags_build_key_trie_node_costs_;
 };
 
 void SystemDictionaryTest::BuildSystemDictionary(const vector<Token *>& source,
@@ -305,7 +321,7 @@ TEST_F(SystemDictionaryTest, NormalWord) {
   CollectTokenCallback callback;
 
   // Look up by exact key.
-  system_dic->LookupPrefix(t0->key, false, &callback);
+  system_dic->LookupPrefix(t0->key, convreq_, &callback);
   ASSERT_EQ(1, callback.tokens().size());
   EXPECT_TOKEN_EQ(*t0, callback.tokens().front());
 
@@ -313,7 +329,7 @@ TEST_F(SystemDictionaryTest, NormalWord) {
   callback.Clear();
   system_dic->LookupPrefix(
       "\xE3\x81\x82\xE3\x81\x84\xE3\x81\x86",  // "あいう"
-      false, &callback);
+      convreq_, &callback);
   ASSERT_EQ(1, callback.tokens().size());
   EXPECT_TOKEN_EQ(*t0, callback.tokens().front());
 
@@ -321,7 +337,7 @@ TEST_F(SystemDictionaryTest, NormalWord) {
   callback.Clear();
   system_dic->LookupPrefix(
       "\xE3\x81\x8B\xE3\x81\x8D\xE3\x81\x8F",  // "かきく"
-      false, &callback);
+      convreq_, &callback);
   EXPECT_TRUE(callback.tokens().empty());
 }
 
@@ -366,7 +382,7 @@ TEST_F(SystemDictionaryTest, SameWord) {
   // All the tokens should be looked up.
   CollectTokenCallback callback;
   system_dic->LookupPrefix("\xe3\x81\x82",  // "あ"
-                           false, &callback);
+                           convreq_, &callback);
   EXPECT_TOKENS_EQ_UNORDERED(source_tokens, callback.tokens());
 }
 
@@ -382,7 +398,7 @@ TEST_F(SystemDictionaryTest, LookupAllWords) {
   // All the tokens should be looked up.
   for (size_t i = 0; i < source_tokens.size(); ++i) {
     CheckTokenExistenceCallback callback(source_tokens[i]);
-    system_dic->LookupPrefix(source_tokens[i]->key, false, &callback);
+    system_dic->LookupPrefix(source_tokens[i]->key, convreq_, &callback);
     EXPECT_TRUE(callback.found())
         << "Token was not found: " << PrintToken(*source_tokens[i]);
   }
@@ -410,7 +426,7 @@ TEST_F(SystemDictionaryTest, SimpleLookupPrefix) {
 
   // |t0| should be looked up from |k1|.
   CheckTokenExistenceCallback callback(t0.get());
-  system_dic->LookupPrefix(k1, false, &callback);
+  system_dic->LookupPrefix(k1, convreq_, &callback);
   EXPECT_TRUE(callback.found());
 }
 
@@ -520,7 +536,7 @@ TEST_F(SystemDictionaryTest, LookupPrefix) {
   {
     LookupPrefixTestCallback callback;
     system_dic->LookupPrefix("\xE3\x81\x82\xE3\x81\x84",  // "あい"
-                             false, &callback);
+                             convreq_, &callback);
     const set<pair<string, string> > &result = callback.result();
     // "あ" -- "あい" should be found.
     for (size_t i = 0; i < 5; ++i) {
@@ -542,7 +558,7 @@ TEST_F(SystemDictionaryTest, LookupPrefix) {
     LookupPrefixTestCallback callback;
     system_dic->LookupPrefix(
         "\xE3\x81\x8B\xE3\x81\x8D\xE3\x81\x8F",  //"かきく"
-        false,
+        convreq_,
         &callback);
     const set<pair<string, string> > &result = callback.result();
     // Only "か" should be found as the callback doesn't traverse the subtree of
@@ -560,7 +576,7 @@ TEST_F(SystemDictionaryTest, LookupPrefix) {
     LookupPrefixTestCallback callback;
     system_dic->LookupPrefix(
         "\xE3\x81\x95\xE3\x81\x97\xE3\x81\x99",  // "さしす"
-        false,
+        convreq_,
         &callback);
     const set<pair<string, string> > &result = callback.result();
     // Only "さし" should be found as tokens for "さ" is skipped (see
@@ -578,7 +594,7 @@ TEST_F(SystemDictionaryTest, LookupPrefix) {
     LookupPrefixTestCallback callback;
     system_dic->LookupPrefix(
         "\xE3\x81\x9F\xE3\x81\xA1\xE3\x81\xA4",  // "たちつ"
-        false,
+        convreq_,
         &callback);
     const set<pair<string, string> > &result = callback.result();
     // Nothing should be found as the traversal is immediately done after seeing
@@ -591,7 +607,7 @@ TEST_F(SystemDictionaryTest, LookupPrefix) {
     LookupPrefixTestCallback callback;
     system_dic->LookupPrefix(
         "\xE3\x81\xAF\xE3\x81\xB2",  // "はひ"
-        true,  // Use kana modifier insensitive lookup
+        kana_insensitive_convreq_,
         &callback);
     const set<pair<string, string> > &result = callback.result();
     const char *kExpectedKeys[] = {
@@ -642,7 +658,7 @@ TEST_F(SystemDictionaryTest, LookupPredictive) {
   const char *kMamimumemo =
       "\xe3\x81\xbe\xe3\x81\xbf\xe3\x82\x80\xe3\x82\x81\xe3\x82\x82";
   CheckMultiTokensExistenceCallback callback(tokens);
-  system_dic->LookupPredictive(kMamimumemo, false, &callback);
+  system_dic->LookupPredictive(kMamimumemo, convreq_, &callback);
   EXPECT_TRUE(callback.AreAllFound());
 }
 
@@ -670,12 +686,12 @@ TEST_F(SystemDictionaryTest, LookupPredictive_KanaModifierInsensitiveLookup) {
 
   // Without Kana modifier insensitive lookup flag, nothing is looked up.
   CollectTokenCallback callback;
-  system_dic->LookupPredictive(kKey, false, &callback);
+  system_dic->LookupPredictive(kKey, convreq_, &callback);
   EXPECT_TRUE(callback.tokens().empty());
 
   // With Kana modifier insensitive lookup flag, every token is looked up.
   callback.Clear();
-  system_dic->LookupPredictive(kKey, true, &callback);
+  system_dic->LookupPredictive(kKey, kana_insensitive_convreq_, &callback);
   EXPECT_TOKENS_EQ_UNORDERED(tokens, callback.tokens());
 }
 
@@ -705,11 +721,105 @@ TEST_F(SystemDictionaryTest, LookupPredictive_CutOffEmulatingBFS) {
   // mechanism.  However, "あい" is looked up as it's short.
   CheckMultiTokensExistenceCallback callback(tokens);
   system_dic->LookupPredictive("\xe3\x81\x82",  // "あ"
-                               false, &callback);
+                               convreq_, &callback);
   EXPECT_TRUE(callback.IsFound(tokens[0]));
   EXPECT_FALSE(callback.IsFound(tokens[1]));
 }
 
+TEST_F(SystemDictionaryTest, LookupPredictiveTopK) {
+  const vector<Token *> &source_tokens = text_dict_->tokens();
+
+  // The costs of the key trie nodes are not built by default.
+  FLAGS_build_key_trie_node_costs = false;
+  BuildSystemDictionary(source_tokens, FLAGS_dictionary_test_size);
+  scoped_ptr<SystemDictionary> system_dic(
+      SystemDictionary::CreateSystemDictionaryFromFile(dic_fn_));
+  ASSERT_TRUE(system_dic.get() != NULL)
+      << "Failed to open dictionary source: " << dic_fn_;
+  EXPECT_TRUE(system_dic->key_trie_node_costs_ == NULL);
+
+  FLAGS_build_key_trie_node_costs = true;
+  BuildSystemDictionary(source_tokens, FLAGS_dictionary_test_size);
+  system_dic.reset(SystemDictionary::CreateSystemDictionaryFromFile(dic_fn_));
+  ASSERT_TRUE(system_dic.get() != NULL)
+      << "Failed to open dictionary source: " << dic_fn_;
+  ASSERT_TRUE(system_dic->key_trie_node_costs_ != NULL);
+
+  // The costs of all the tokens starting with "あ" in ascending order.
+  const string kKey = "\xe3\x81\x82";  // "あ"
+  vector<int> expected_costs;
+  for (size_t i = 0;
+       i < source_tokens.size() && i < FLAGS_dictionary_test_size; ++i) {
+    if (Util::StartsWith(source_tokens[i]->key, kKey)) {
+      expected_costs.push_back(source_tokens[i]->cost);
+    }
+  }
+  sort(expected_costs.begin(), expected_costs.end());
+  const size_t kLimit = 20;
+  ASSERT_LT(kLimit, expected_costs.size());
+
+  // The best |kLimit| tokens are looked up in cost order.
+  CollectTokenCallback callback;
+  system_dic->LookupPredictiveTopK(kKey, convreq_, kLimit, &callback);
+  ASSERT_EQ(kLimit, callback.tokens().size());
+  for (size_t i = 0; i < kLimit; ++i) {
+    EXPECT_TRUE(Util::StartsWith(callback.tokens()[i].key, kKey));
+    EXPECT_EQ(expected_costs[i], callback.tokens()[i].cost);
+  }
+
+  // Without the costs of the key trie nodes, falls back to LookupPredictive().
+  system_dic->key_trie_node_costs_ = NULL;
+  CollectTokenCallback expected_callback;
+  system_dic->LookupPredictive(kKey, convreq_, &expected_callback);
+  callback.Clear();
+  system_dic->LookupPredictiveTopK(kKey, convreq_, kLimit, &callback);
+  ASSERT_EQ(expected_callback.tokens().size(), callback.tokens().size());
+  for (size_t i = 0; i < callback.tokens().size(); ++i) {
+    EXPECT_TRUE(CompareTokensForLookup(expected_callback.tokens()[i],
+                                       callback.tokens()[i], false));
+  }
+}
+
+TEST_F(SystemDictionaryTest, LookupPredictiveForKeys) {
+  BuildSystemDictionary(text_dict_->tokens(), FLAGS_dictionary_test_size);
+  scoped_ptr<SystemDictionary> system_dic(
+      SystemDictionary::CreateSystemDictionaryFromFile(dic_fn_));
+  ASSERT_TRUE(system_dic.get() != NULL)
+      << "Failed to open dictionary source: " << dic_fn_;
+
+  vector<string> keys;
+  keys.push_back("\xe3\x81\x82");  // "あ"
+  keys.push_back("\xe3\x81\x82\xe3\x81\x84");  // "あい"
+  keys.push_back("");  // Nothing is looked up for empty key.
+  keys.push_back("\xe3\x81\x8b\xe3\x81\xa4");  // "かつ"
+  keys.push_back("\xe3\x81\x8b\xe3\x81\xa3");  // "かっ"
+
+  // Each key gets the same tokens as LookupPredictive(), with and without
+  // kana modifier insensitive lookup.
+  const ConversionRequest *requests[] = {
+    &convreq_, &kana_insensitive_convreq_,
+  };
+  for (size_t i = 0; i < arraysize(requests); ++i) {
+    vector<CollectTokenCallback> callbacks(keys.size());
+    vector<SystemDictionary::Callback *> callback_ptrs;
+    for (size_t j = 0; j < callbacks.size(); ++j) {
+      callback_ptrs.push_back(&callbacks[j]);
+    }
+    system_dic->LookupPredictiveForKeys(keys, *requests[i], callback_ptrs);
+
+    for (size_t j = 0; j < keys.size(); ++j) {
+      CollectTokenCallback expected_callback;
+      system_dic->LookupPredictive(keys[j], *requests[i], &expected_callback);
+      ASSERT_EQ(expected_callback.tokens().size(),
+                callbacks[j].tokens().size()) << i << ", " << j;
+      for (size_t k = 0; k < callbacks[j].tokens().size(); ++k) {
+        EXPECT_TRUE(CompareTokensForLookup(expected_callback.tokens()[k],
+                                           callbacks[j].tokens()[k], false));
+      }
+    }
+  }
+}
+
 TEST_F(SystemDictionaryTest, LookupExact) {
   vector<Token *> source_tokens;
 
@@ -733,16 +843,16 @@ TEST_F(SystemDictionaryTest, LookupExact) {
 
   // |t0| should not be looked up from |k1|.
   CheckTokenExistenceCallback callback0(t0.get());
-  system_dic->LookupExact(k1, &callback0);
+  system_dic->LookupExact(k1, convreq_, &callback0);
   EXPECT_FALSE(callback0.found());
   // But |t1| should be found.
   CheckTokenExistenceCallback callback1(t1.get());
-  system_dic->LookupExact(k1, &callback1);
+  system_dic->LookupExact(k1, convreq_, &callback1);
   EXPECT_TRUE(callback1.found());
 
   // Nothing should be found from "hoge".
   CollectTokenCallback callback_hoge;
-  system_dic->LookupExact("hoge", &callback_hoge);
+  system_dic->LookupExact("hoge", convreq_, &callback_hoge);
   EXPECT_TRUE(callback_hoge.tokens().empty());
 }
 
@@ -847,7 +957,7 @@ TEST_F(SystemDictionaryTest, LookupReverse) {
   for (size_t source_index = 0; source_index < test_size; ++source_index) {
     const Token &source_token = *source_tokens[source_index];
     CollectTokenCallback callback;
-    system_dic->LookupReverse(source_token.value, NULL, &callback);
+    system_dic->LookupReverse(source_token.value, NULL, convreq_, &callback);
     const vector<Token> &tokens = callback.tokens();
 
     bool found = false;
@@ -886,7 +996,7 @@ TEST_F(SystemDictionaryTest, LookupReverse) {
     // append "が"
     const string key = t7->value + "\xe3\x81\x8c";
     CollectTokenCallback callback;
-    system_dic->LookupReverse(key, NULL, &callback);
+    system_dic->LookupReverse(key, NULL, convreq_, &callback);
     const vector<Token> &tokens = callback.tokens();
     bool found = false;
     for (size_t i = 0; i < tokens.size(); ++i) {
@@ -920,8 +1030,9 @@ TEST_F(SystemDictionaryTest, LookupReverseIndex) {
        size > 0 && it != source_tokens.end(); ++it, --size) {
     const Token &t = **it;
     CollectTokenCallback callback1, callback2;
-    system_dic_without_index->LookupReverse(t.value, NULL, &callback1);
-    system_dic_with_index->LookupReverse(t.value, NULL, &callback2);
+    system_dic_without_index->LookupReverse(t.value, NULL, convreq_,
+                                            &callback1);
+    system_dic_with_index->LookupReverse(t.value, NULL, convreq_, &callback2);
 
     const vector<Token> &tokens1 = callback1.tokens();
     const vector<Token> &tokens2 = callback2.tokens();
@@ -932,6 +1043,113 @@ TEST_F(SystemDictionaryTest, LookupReverseIndex) {
   }
 }
 
+TEST_F(SystemDictionaryTest, ReverseLookupIndexInImage) {
+  const vector<Token *> &source_tokens = text_dict_->tokens();
+  BuildSystemDictionary(source_tokens, FLAGS_dictionary_test_size);
+
+  // The index is read from the image without any option.
+  scoped_ptr<SystemDictionary> system_dic_with_index(
+      SystemDictionary::CreateSystemDictionaryFromFileWithOptions(
+          dic_fn_, SystemDictionary::NONE));
+  ASSERT_TRUE(system_dic_with_index.get() != NULL)
+      << "Failed to open dictionary source:" << dic_fn_;
+  EXPECT_TRUE(system_dic_with_index->reverse_lookup_index_.get() != NULL);
+  EXPECT_TRUE(system_dic_with_index->reverse_lookup_index_image_.empty());
+
+  // Emulates the dictionary without the reverse lookup section, which scans
+  // the tokens for each lookup.
+  scoped_ptr<SystemDictionary> system_dic_without_index(
+      SystemDictionary::CreateSystemDictionaryFromFileWithOptions(
+          dic_fn_, SystemDictionary::NONE));
+  ASSERT_TRUE(system_dic_without_index.get() != NULL)
+      << "Failed to open dictionary source:" << dic_fn_;
+  system_dic_without_index->reverse_lookup_index_.reset();
+
+  // Emulates the same dictionary opened with ENABLE_REVERSE_LOOKUP_INDEX,
+  // which builds the index in heap.
+  scoped_ptr<SystemDictionary> system_dic_with_heap_index(
+      SystemDictionary::CreateSystemDictionaryFromFileWithOptions(
+          dic_fn_, SystemDictionary::NONE));
+  ASSERT_TRUE(system_dic_with_heap_index.get() != NULL)
+      << "Failed to open dictionary source:" << dic_fn_;
+  system_dic_with_heap_index->reverse_lookup_index_.reset();
+  system_dic_with_heap_index->InitReverseLookupIndex();
+  EXPECT_FALSE(system_dic_with_heap_index->reverse_lookup_index_image_.empty());
+
+  vector<Token *>::const_iterator it;
+  int size = FLAGS_dictionary_reverse_lookup_test_size;
+  for (it = source_tokens.begin();
+       size > 0 && it != source_tokens.end(); ++it, --size) {
+    const Token &t = **it;
+    CollectTokenCallback callback1, callback2, callback3;
+    system_dic_without_index->LookupReverse(t.value, NULL, convreq_,
+                                            &callback1);
+    system_dic_with_index->LookupReverse(t.value, NULL, convreq_, &callback2);
+    system_dic_with_heap_index->LookupReverse(t.value, NULL, convreq_,
+                                              &callback3);
+
+    const vector<Token> &tokens1 = callback1.tokens();
+    const vector<Token> &tokens2 = callback2.tokens();
+    const vector<Token> &tokens3 = callback3.tokens();
+    ASSERT_EQ(tokens1.size(), tokens2.size());
+    ASSERT_EQ(tokens1.size(), tokens3.size());
+    for (size_t i = 0; i < tokens1.size(); ++i) {
+      EXPECT_TOKEN_EQ(tokens1[i], tokens2[i]);
+      EXPECT_TOKEN_EQ(tokens1[i], tokens3[i]);
+    }
+  }
+}
+
+TEST_F(SystemDictionaryTest, ValueCache) {
+  const vector<Token *> &source_tokens = text_dict_->tokens();
+  BuildSystemDictionary(source_tokens, FLAGS_dictionary_test_size);
+
+  scoped_ptr<SystemDictionary> system_dic_without_cache(
+      SystemDictionary::CreateSystemDictionaryFromFileWithOptions(
+          dic_fn_, SystemDictionary::NONE));
+  ASSERT_TRUE(system_dic_without_cache.get() != NULL)
+      << "Failed to open dictionary source:" << dic_fn_;
+  scoped_ptr<SystemDictionary> system_dic_with_cache(
+      SystemDictionary::CreateSystemDictionaryFromFileWithOptions(
+          dic_fn_, SystemDictionary::ENABLE_VALUE_CACHE));
+  ASSERT_TRUE(system_dic_with_cache.get() != NULL)
+      << "Failed to open dictionary source:" << dic_fn_;
+
+  uint64 hits = 0, misses = 0;
+  EXPECT_FALSE(system_dic_without_cache->GetValueCacheStats(&hits, &misses));
+#ifdef DEBUG
+  ASSERT_TRUE(system_dic_with_cache->GetValueCacheStats(&hits, &misses));
+  EXPECT_EQ(0, hits);
+  EXPECT_EQ(0, misses);
+#else
+  // The stats are not counted in release builds.
+  EXPECT_FALSE(system_dic_with_cache->GetValueCacheStats(&hits, &misses));
+#endif  // DEBUG
+
+  // The cache must not change the results.
+  const size_t size = min(static_cast<size_t>(FLAGS_dictionary_test_size),
+                          source_tokens.size());
+  for (size_t i = 0; i < size; ++i) {
+    CollectTokenCallback callback1, callback2;
+    system_dic_without_cache->LookupPrefix(
+        source_tokens[i]->key, convreq_, &callback1);
+    system_dic_with_cache->LookupPrefix(
+        source_tokens[i]->key, convreq_, &callback2);
+
+    const vector<Token> &tokens1 = callback1.tokens();
+    const vector<Token> &tokens2 = callback2.tokens();
+    ASSERT_EQ(tokens1.size(), tokens2.size());
+    for (size_t j = 0; j < tokens1.size(); ++j) {
+      EXPECT_TOKEN_EQ(tokens1[j], tokens2[j]);
+    }
+  }
+
+#ifdef DEBUG
+  ASSERT_TRUE(system_dic_with_cache->GetValueCacheStats(&hits, &misses));
+  EXPECT_GT(hits, 0);
+#endif  // DEBUG
+}
+
 TEST_F(SystemDictionaryTest, LookupReverseWithCache) {
   const string kDoraemon =
       "\xe3\x83\x89\xe3\x83\xa9\xe3\x81\x88\xe3\x82\x82\xe3\x82\x93";
@@ -960,7 +1178,7 @@ TEST_F(SystemDictionaryTest, LookupReverseWithCache) {
   NodeAllocator allocator;
   system_dic->PopulateReverseLookupCache(kDoraemon, &allocator);
   CheckTokenExistenceCallback callback(&target_token);
-  system_dic->LookupReverse(kDoraemon, &allocator, &callback);
+  system_dic->LookupReverse(kDoraemon, &allocator, convreq_, &callback);
   EXPECT_TRUE(callback.found())
       << "Could not find " << PrintToken(source_token);
   system_dic->ClearReverseLookupCache(&allocator);
@@ -1013,7 +1231,7 @@ TEST_F(SystemDictionaryTest, SpellingCorrectionTokens) {
 
   for (size_t i = 0; i < source_tokens.size(); ++i) {
     CheckTokenExistenceCallback callback(source_tokens[i]);
-    system_dic->LookupPrefix(source_tokens[i]->key, false, &callback);
+    system_dic->LookupPrefix(source_tokens[i]->key, convreq_, &callback);
     EXPECT_TRUE(callback.found())
         << "Token " << i << " was not found: " << PrintToken(*source_tokens[i]);
   }
@@ -1033,6 +1251,8 @@ class CodecForTest : public SystemDictionaryCodecInterface {
   const string GetSectionNameForValue() const { return "Mock"; }
   const string GetSectionNameForTokens() const { return "Mock"; }
   const string GetSectionNameForPos() const { return "Mock"; }
+  const string GetSectionNameForReverseLookup() const { return "Mock"; }
+  const string GetSectionNameForKeyCosts() const { return "Mock"; }
   void EncodeKey(const StringPiece src, string *dst) const {}
   void DecodeKey(const StringPiece src, string *dst) const {}
   size_t GetEncodedKeyLength(const StringPiece src) const { return 0; }
@@ -1136,7 +1356,7 @@ TEST_F(SystemDictionaryTest, EnableNoModifierTargetWithLoudsTrie) {
     CheckTokenExistenceCallback callback(tokens[i].get());
     // "かつこう" -> "かつ", "かっこ", "かつこう", "かっこう" and "がっこう"
     system_dic->LookupPrefix(
-        k2, kEnableKanaModiferInsensitiveLookup, &callback);
+        k2, kana_insensitive_convreq_, &callback);
     EXPECT_TRUE(callback.found())
         << "Token " << i << " was not found: " << PrintToken(*tokens[i]);
   }
@@ -1150,7 +1370,7 @@ TEST_F(SystemDictionaryTest, EnableNoModifierTargetWithLoudsTrie) {
     }
     CheckMultiTokensExistenceCallback callback(expected);
     system_dic->LookupPredictive(
-        k0, kEnableKanaModiferInsensitiveLookup, &callback);
+        k0, kana_insensitive_convreq_, &callback);
     EXPECT_TRUE(callback.AreAllFound());
   }
   {
@@ -1161,7 +1381,7 @@ TEST_F(SystemDictionaryTest, EnableNoModifierTargetWithLoudsTrie) {
     expected.push_back(tokens[4].get());
     CheckMultiTokensExistenceCallback callback(expected);
     system_dic->LookupPredictive(
-        k1, kEnableKanaModiferInsensitiveLookup, &callback);
+        k1, kana_insensitive_convreq_, &callback);
     EXPECT_TRUE(callback.AreAllFound());
   }
 }
@@ -1194,7 +1414,7 @@ TEST_F(SystemDictionaryTest, NoModifierForKanaEntries) {
   const string k = "\xe3\x81\xa6\xe3\x81\x84\xe3\x81\x99\xe3\x81\xa6"
       "\xe3\x81\x84\xe3\x82\x93\xe3\x81\x90";
   CheckTokenExistenceCallback callback(t0.get());
-  system_dic->LookupPrefix(k, kEnableKanaModiferInsensitiveLookup,
+  system_dic->LookupPrefix(k, kana_insensitive_convreq_,
                            &callback);
   EXPECT_TRUE(callback.found()) << "Not found: " << PrintToken(*t0);
 }
@@ -1245,14 +1465,14 @@ TEST_F(SystemDictionaryTest, DoNotReturnNoModifierTargetWithLoudsTrie) {
     for (size_t i = 0; i < to_be_looked_up.size(); ++i) {
       CheckTokenExistenceCallback callback(to_be_looked_up[i]);
       system_dic->LookupPrefix(
-          k3, kDisableKanaModiferInsensitiveLookup, &callback);
+          k3, convreq_, &callback);
       EXPECT_TRUE(callback.found())
           << "Token is not found: " << PrintToken(*to_be_looked_up[i]);
     }
     for (size_t i = 0; i < not_to_be_looked_up.size(); ++i) {
       CheckTokenExistenceCallback callback(not_to_be_looked_up[i]);
       system_dic->LookupPrefix(
-          k3, kDisableKanaModiferInsensitiveLookup, &callback);
+          k3, convreq_, &callback);
       EXPECT_FALSE(callback.found())
           << "Token should not be found: "
           << PrintToken(*not_to_be_looked_up[i]);
@@ -1272,14 +1492,14 @@ TEST_F(SystemDictionaryTest, DoNotReturnNoModifierTargetWithLoudsTrie) {
     for (size_t i = 0; i < to_be_looked_up.size(); ++i) {
       CheckTokenExistenceCallback callback(to_be_looked_up[i]);
       system_dic->LookupPredictive(
-          k1, kDisableKanaModiferInsensitiveLookup, &callback);
+          k1, convreq_, &callback);
       EXPECT_TRUE(callback.found())
           << "Token is not found: " << PrintToken(*to_be_looked_up[i]);
     }
     for (size_t i = 0; i < not_to_be_looked_up.size(); ++i) {
       CheckTokenExistenceCallback callback(not_to_be_looked_up[i]);
       system_dic->LookupPredictive(
-          k3, kDisableKanaModiferInsensitiveLookup, &callback);
+          k3, convreq_, &callback);
       EXPECT_FALSE(callback.found())
           << "Token should not be found: "
           << PrintToken(*not_to_be_looked_up[i]);
@@ -43,6 +43,20 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'reverse_lookup_index_test',
+      'type': 'executable',
+      'sources': [
+        'reverse_lookup_index_test.cc',
+      ],
+      'dependencies': [
+        '../../testing/testing.gyp:gtest_main',
+        'system_dictionary.gyp:reverse_lookup_index',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     {
       'target_name': 'system_dictionary_test',
       'type': 'executable',
@@ -97,14 +111,31 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'token_sorter_test',
+      'type': 'executable',
+      'sources': [
+        'token_sorter_test.cc',
+      ],
+      'dependencies': [
+        '../../base/base.gyp:base_core',
+        '../../testing/testing.gyp:gtest_main',
+        'system_dictionary.gyp:system_dictionary_builder',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     # Test cases meta target: this target is referred from gyp/tests.gyp
     {
       'target_name': 'system_dictionary_all_test',
       'type': 'none',
       'dependencies': [
+        'reverse_lookup_index_test',
         'system_dictionary_builder_test',
         'system_dictionary_codec_test',
         'system_dictionary_test',
+        'token_sorter_test',
         'value_dictionary_test',
       ],
     },
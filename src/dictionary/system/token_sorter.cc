@@ -0,0 +1,300 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dictionary/system/token_sorter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/file_stream.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/number_util.h"
+#include "base/stl_util.h"
+#include "base/string_piece.h"
+#include "dictionary/dictionary_token.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+// Serialized token:
+//   [key size:4][value size:4][cost:4][lid:4][rid:4][attributes:1]
+//   [key][value]
+const size_t kHeaderSize = 21;
+
+void EncodeToken(const Token &token, string *output) {
+  char header[kHeaderSize];
+  const uint32 key_size = token.key.size();
+  const uint32 value_size = token.value.size();
+  const int32 cost = token.cost;
+  const int32 lid = token.lid;
+  const int32 rid = token.rid;
+  memcpy(header, &key_size, 4);
+  memcpy(header + 4, &value_size, 4);
+  memcpy(header + 8, &cost, 4);
+  memcpy(header + 12, &lid, 4);
+  memcpy(header + 16, &rid, 4);
+  header[20] = static_cast<char>(token.attributes);
+  output->append(header, kHeaderSize);
+  output->append(token.key);
+  output->append(token.value);
+}
+
+// Decodes the header and returns the sizes of key and value.
+void DecodeHeader(const char *header, uint32 *key_size, uint32 *value_size,
+                  Token *token) {
+  int32 cost, lid, rid;
+  memcpy(key_size, header, 4);
+  memcpy(value_size, header + 4, 4);
+  memcpy(&cost, header + 8, 4);
+  memcpy(&lid, header + 12, 4);
+  memcpy(&rid, header + 16, 4);
+  token->cost = cost;
+  token->lid = lid;
+  token->rid = rid;
+  token->attributes = static_cast<Token::AttributesBitfield>(header[20]);
+}
+
+void DecodeToken(const char *data, Token *token) {
+  uint32 key_size, value_size;
+  DecodeHeader(data, &key_size, &value_size, token);
+  token->key.assign(data + kHeaderSize, key_size);
+  token->value.assign(data + kHeaderSize + key_size, value_size);
+}
+
+StringPiece GetKey(const string &buffer, size_t offset) {
+  uint32 key_size;
+  memcpy(&key_size, buffer.data() + offset, 4);
+  return StringPiece(buffer.data() + offset + kHeaderSize, key_size);
+}
+
+size_t GetEncodedSize(const string &buffer, size_t offset) {
+  uint32 key_size, value_size;
+  memcpy(&key_size, buffer.data() + offset, 4);
+  memcpy(&value_size, buffer.data() + offset + 4, 4);
+  return kHeaderSize + key_size + value_size;
+}
+
+class OffsetLessThan {
+ public:
+  explicit OffsetLessThan(const string &buffer) : buffer_(buffer) {}
+
+  bool operator()(size_t lhs, size_t rhs) const {
+    return GetKey(buffer_, lhs) < GetKey(buffer_, rhs);
+  }
+
+ private:
+  const string &buffer_;
+};
+
+}  // namespace
+
+// Reads the tokens in a run file one by one.
+class TokenSorter::RunReader {
+ public:
+  explicit RunReader(const string &filename)
+      : ifs_(filename.c_str(), ios::in | ios::binary) {
+    CHECK(ifs_) << "Cannot open " << filename;
+  }
+
+  // Reads the next token to current(). Returns false at the end.
+  bool Advance() {
+    char header[kHeaderSize];
+    if (!ifs_.read(header, kHeaderSize)) {
+      return false;
+    }
+    uint32 key_size, value_size;
+    DecodeHeader(header, &key_size, &value_size, &current_);
+    buffer_.resize(key_size + value_size);
+    if (!buffer_.empty()) {
+      CHECK(ifs_.read(&buffer_[0], buffer_.size())) << "Broken run file";
+    }
+    current_.key.assign(buffer_, 0, key_size);
+    current_.value.assign(buffer_, key_size, value_size);
+    return true;
+  }
+
+  const Token &current() const {
+    return current_;
+  }
+
+ private:
+  InputFileStream ifs_;
+  string buffer_;
+  Token current_;
+
+  DISALLOW_COPY_AND_ASSIGN(RunReader);
+};
+
+// K-way merger of run files. Tokens with the same key are read in the order
+// of the runs, which keeps the sort stable.
+class TokenSorter::RunMerger {
+ public:
+  explicit RunMerger(const vector<string> &filenames) {
+    for (size_t i = 0; i < filenames.size(); ++i) {
+      readers_.push_back(new RunReader(filenames[i]));
+      if (readers_.back()->Advance()) {
+        heap_.push_back(i);
+      }
+    }
+    make_heap(heap_.begin(), heap_.end(), ReaderGreaterThan(readers_));
+  }
+
+  ~RunMerger() {
+    STLDeleteElements(&readers_);
+  }
+
+  bool Next(Token *token) {
+    if (heap_.empty()) {
+      return false;
+    }
+    const ReaderGreaterThan greater_than(readers_);
+    pop_heap(heap_.begin(), heap_.end(), greater_than);
+    RunReader *reader = readers_[heap_.back()];
+    *token = reader->current();
+    if (reader->Advance()) {
+      push_heap(heap_.begin(), heap_.end(), greater_than);
+    } else {
+      heap_.pop_back();
+    }
+    return true;
+  }
+
+ private:
+  class ReaderGreaterThan {
+   public:
+    explicit ReaderGreaterThan(const vector<RunReader *> &readers)
+        : readers_(readers) {}
+
+    bool operator()(size_t lhs, size_t rhs) const {
+      const int result = readers_[lhs]->current().key.compare(
+          readers_[rhs]->current().key);
+      if (result != 0) {
+        return result > 0;
+      }
+      return lhs > rhs;
+    }
+
+   private:
+    const vector<RunReader *> &readers_;
+  };
+
+  vector<RunReader *> readers_;
+  // Min-heap of the indices of the readers having a token.
+  vector<size_t> heap_;
+
+  DISALLOW_COPY_AND_ASSIGN(RunMerger);
+};
+
+TokenSorter::TokenSorter(size_t max_buffer_size,
+                         const string &temporary_file_prefix)
+    : max_buffer_size_(max_buffer_size),
+      temporary_file_prefix_(temporary_file_prefix),
+      num_tokens_(0),
+      finished_(false),
+      cursor_(0) {}
+
+TokenSorter::~TokenSorter() {
+  merger_.reset();
+  for (size_t i = 0; i < run_filenames_.size(); ++i) {
+    FileUtil::Unlink(run_filenames_[i]);
+  }
+}
+
+void TokenSorter::Add(const Token &token) {
+  DCHECK(!finished_);
+  offsets_.push_back(buffer_.size());
+  EncodeToken(token, &buffer_);
+  ++num_tokens_;
+  if (max_buffer_size_ > 0 && buffer_.size() >= max_buffer_size_) {
+    SpillBuffer();
+  }
+}
+
+void TokenSorter::Finish() {
+  DCHECK(!finished_);
+  finished_ = true;
+  if (run_filenames_.empty()) {
+    SortOffsets();
+    return;
+  }
+  if (!offsets_.empty()) {
+    SpillBuffer();
+  }
+  string().swap(buffer_);
+  vector<size_t>().swap(offsets_);
+}
+
+void TokenSorter::Rewind() {
+  DCHECK(finished_);
+  cursor_ = 0;
+  if (!run_filenames_.empty()) {
+    merger_.reset(NULL);
+    merger_.reset(new RunMerger(run_filenames_));
+  }
+}
+
+bool TokenSorter::Next(Token *token) {
+  if (merger_.get() != NULL) {
+    return merger_->Next(token);
+  }
+  if (cursor_ >= offsets_.size()) {
+    return false;
+  }
+  DecodeToken(buffer_.data() + offsets_[cursor_], token);
+  ++cursor_;
+  return true;
+}
+
+void TokenSorter::SortOffsets() {
+  stable_sort(offsets_.begin(), offsets_.end(), OffsetLessThan(buffer_));
+}
+
+void TokenSorter::SpillBuffer() {
+  SortOffsets();
+  const string filename = temporary_file_prefix_ + ".run" +
+      NumberUtil::SimpleItoa(static_cast<uint32>(run_filenames_.size()));
+  {
+    OutputFileStream ofs(filename.c_str(), ios::out | ios::binary);
+    CHECK(ofs) << "Cannot open " << filename;
+    for (size_t i = 0; i < offsets_.size(); ++i) {
+      ofs.write(buffer_.data() + offsets_[i],
+                GetEncodedSize(buffer_, offsets_[i]));
+    }
+    CHECK(ofs) << "Failed to write " << filename;
+  }
+  VLOG(1) << "Wrote " << offsets_.size() << " tokens to " << filename;
+  run_filenames_.push_back(filename);
+  buffer_.clear();
+  offsets_.clear();
+}
+
+}  // namespace dictionary
+}  // namespace mozc
@@ -0,0 +1,121 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DICTIONARY_SYSTEM_TOKEN_SORTER_H_
+#define MOZC_DICTIONARY_SYSTEM_TOKEN_SORTER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+#include "base/scoped_ptr.h"
+
+namespace mozc {
+struct Token;
+
+namespace dictionary {
+
+// Stable sorter of tokens by key with bounded memory usage.  Tokens are
+// kept in a compact serialized form instead of Token objects.  When the
+// serialized tokens exceed |max_buffer_size| bytes, they are sorted and
+// written to a temporary file as a sorted run, and the runs are merged on
+// reading.  The order of the tokens read is the same as the one of
+// stable_sort() by Token::key.
+//
+// Usage:
+//   TokenSorter sorter(64 << 20, "/tmp/dictionary");
+//   for (...) {
+//     sorter.Add(token);
+//   }
+//   sorter.Finish();
+//   sorter.Rewind();
+//   Token token;
+//   while (sorter.Next(&token)) {
+//     ...
+//   }
+class TokenSorter {
+ public:
+  // If |max_buffer_size| is 0, all the tokens are kept in memory.
+  // Temporary files are named |temporary_file_prefix| + ".run" + <index>
+  // and removed by the destructor.
+  TokenSorter(size_t max_buffer_size, const string &temporary_file_prefix);
+  ~TokenSorter();
+
+  // Adds a token. Must not be called after Finish().
+  void Add(const Token &token);
+
+  // Sorts the added tokens. Must be called once before Rewind().
+  void Finish();
+
+  // Moves the cursor to the first token. Can be called more than once.
+  void Rewind();
+
+  // Reads the next token in the sorted order. Returns false at the end.
+  bool Next(Token *token);
+
+  size_t num_tokens() const {
+    return num_tokens_;
+  }
+
+  size_t num_runs() const {
+    return run_filenames_.size();
+  }
+
+ private:
+  class RunReader;
+  class RunMerger;
+
+  // Sorts the tokens in |buffer_| and writes them to a new run file.
+  void SpillBuffer();
+
+  // Sorts |offsets_| by the keys of the tokens in |buffer_|.
+  void SortOffsets();
+
+  const size_t max_buffer_size_;
+  const string temporary_file_prefix_;
+
+  // Serialized tokens and their offsets in |buffer_|.
+  string buffer_;
+  vector<size_t> offsets_;
+
+  vector<string> run_filenames_;
+  size_t num_tokens_;
+  bool finished_;
+
+  // Cursor on |offsets_| used when no run has been written.
+  size_t cursor_;
+  scoped_ptr<RunMerger> merger_;
+
+  DISALLOW_COPY_AND_ASSIGN(TokenSorter);
+};
+
+}  // namespace dictionary
+}  // namespace mozc
+
+#endif  // MOZC_DICTIONARY_SYSTEM_TOKEN_SORTER_H_
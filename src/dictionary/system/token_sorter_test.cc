@@ -0,0 +1,133 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dictionary/system/token_sorter.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/flags.h"
+#include "base/number_util.h"
+#include "dictionary/dictionary_token.h"
+#include "testing/base/public/gunit.h"
+
+DECLARE_string(test_tmpdir);
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+struct TokenKeyLessThan {
+  bool operator()(const Token &lhs, const Token &rhs) const {
+    return lhs.key < rhs.key;
+  }
+};
+
+// Returns tokens with duplicate keys, so that stability of sort matters.
+vector<Token> MakeTokens(int size) {
+  vector<Token> tokens;
+  for (int i = 0; i < size; ++i) {
+    Token token;
+    token.key = "key" + NumberUtil::SimpleItoa(static_cast<uint32>(
+        (i * 7919) % (size / 3 + 1)));
+    token.value = "value" + NumberUtil::SimpleItoa(static_cast<uint32>(i));
+    token.cost = i;
+    token.lid = i % 100;
+    token.rid = i % 200;
+    token.attributes = static_cast<Token::AttributesBitfield>(i % 2);
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+void ExpectSorted(const vector<Token> &input, TokenSorter *sorter) {
+  vector<Token> expected = input;
+  stable_sort(expected.begin(), expected.end(), TokenKeyLessThan());
+
+  // Reading twice yields the same result.
+  for (int pass = 0; pass < 2; ++pass) {
+    sorter->Rewind();
+    Token token;
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_TRUE(sorter->Next(&token));
+      EXPECT_EQ(expected[i].key, token.key);
+      EXPECT_EQ(expected[i].value, token.value);
+      EXPECT_EQ(expected[i].cost, token.cost);
+      EXPECT_EQ(expected[i].lid, token.lid);
+      EXPECT_EQ(expected[i].rid, token.rid);
+      EXPECT_EQ(expected[i].attributes, token.attributes);
+    }
+    EXPECT_FALSE(sorter->Next(&token));
+  }
+}
+
+TEST(TokenSorterTest, InMemory) {
+  const vector<Token> tokens = MakeTokens(1000);
+  TokenSorter sorter(0, FLAGS_test_tmpdir + "/in_memory");
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    sorter.Add(tokens[i]);
+  }
+  sorter.Finish();
+  EXPECT_EQ(tokens.size(), sorter.num_tokens());
+  EXPECT_EQ(0, sorter.num_runs());
+  ExpectSorted(tokens, &sorter);
+}
+
+TEST(TokenSorterTest, ExternalRuns) {
+  const vector<Token> tokens = MakeTokens(1000);
+  const string prefix = FLAGS_test_tmpdir + "/external";
+  {
+    // About 40 bytes per token, so each run has about 25 tokens.
+    TokenSorter sorter(1024, prefix);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      sorter.Add(tokens[i]);
+    }
+    sorter.Finish();
+    EXPECT_EQ(tokens.size(), sorter.num_tokens());
+    EXPECT_LT(10, sorter.num_runs());
+    EXPECT_TRUE(FileUtil::FileExists(prefix + ".run0"));
+    ExpectSorted(tokens, &sorter);
+  }
+  // Run files are removed.
+  EXPECT_FALSE(FileUtil::FileExists(prefix + ".run0"));
+}
+
+TEST(TokenSorterTest, Empty) {
+  TokenSorter sorter(1024, FLAGS_test_tmpdir + "/empty");
+  sorter.Finish();
+  sorter.Rewind();
+  Token token;
+  EXPECT_FALSE(sorter.Next(&token));
+}
+
+}  // namespace
+}  // namespace dictionary
+}  // namespace mozc
@@ -181,7 +181,7 @@ class PredictiveTraverser : public LoudsTrie::Callback {
 
 void ValueDictionary::LookupPredictive(
     StringPiece key,
-    bool,  // use_kana_modifier_insensitive_lookup
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   // Do nothing for empty key, although looking up all the entries with empty
   // string seems natural.
@@ -196,10 +196,12 @@ void ValueDictionary::LookupPredictive(
 }
 
 void ValueDictionary::LookupPrefix(
-    StringPiece key, bool use_kana_modifier_insensitive_lookup,
+    StringPiece key, const ConversionRequest &conversion_request,
     Callback *callback) const {}
 
-void ValueDictionary::LookupExact(StringPiece key, Callback *callback) const {
+void ValueDictionary::LookupExact(StringPiece key,
+                                  const ConversionRequest &conversion_request,
+                                  Callback *callback) const {
   if (key.empty()) {
     // For empty string, return NULL for compatibility reason; see the comment
     // above.
@@ -222,6 +224,7 @@ void ValueDictionary::LookupExact(StringPiece key, Callback *callback) const {
 
 void ValueDictionary::LookupReverse(StringPiece str,
                                     NodeAllocatorInterface *allocator,
+                                    const ConversionRequest &conversion_request,
                                     Callback *callback) const {
 }
 
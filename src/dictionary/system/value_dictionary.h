@@ -71,14 +71,17 @@ class ValueDictionary : public DictionaryInterface {
   // Implementation of DictionaryInterface
   virtual bool HasValue(StringPiece value) const;
   virtual void LookupPredictive(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const;
-  virtual void LookupExact(StringPiece key, Callback *callback) const;
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const;
   virtual void LookupReverse(
       StringPiece str, NodeAllocatorInterface *allocator,
+      const ConversionRequest &conversion_request,
       Callback *callback) const;
 
  private:
@@ -35,6 +35,7 @@
 #include "base/stl_util.h"
 #include "base/system_util.h"
 #include "base/trie.h"
+#include "converter/conversion_request.h"
 #include "data_manager/user_pos_manager.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_test_util.h"
@@ -91,6 +92,7 @@ class ValueDictionaryTest : public testing::Test {
 
   const string dict_name_;
   const POSMatcher *pos_matcher_;
+  ConversionRequest convreq_;
 
  private:
   vector<Token *> tokens_;
@@ -149,12 +151,12 @@ TEST_F(ValueDictionaryTest, LookupPredictive) {
 
   {
     CollectTokenCallback callback;
-    dictionary->LookupPredictive("", false, &callback);
+    dictionary->LookupPredictive("", convreq_, &callback);
     EXPECT_TRUE(callback.tokens().empty());
   }
   {
     CollectTokenCallback callback;
-    dictionary->LookupPredictive("w", false, &callback);
+    dictionary->LookupPredictive("w", convreq_, &callback);
     vector<Token *> expected;
     expected.push_back(&token_we);
     expected.push_back(&token_war);
@@ -164,7 +166,7 @@ TEST_F(ValueDictionaryTest, LookupPredictive) {
   }
   {
     CollectTokenCallback callback;
-    dictionary->LookupPredictive("wo", false, &callback);
+    dictionary->LookupPredictive("wo", convreq_, &callback);
     vector<Token *> expected;
     expected.push_back(&token_word);
     expected.push_back(&token_world);
@@ -172,7 +174,7 @@ TEST_F(ValueDictionaryTest, LookupPredictive) {
   }
   {
     CollectTokenCallback callback;
-    dictionary->LookupPredictive("ho", false, &callback);
+    dictionary->LookupPredictive("ho", convreq_, &callback);
     EXPECT_TRUE(callback.tokens().empty());
   }
 }
@@ -190,7 +192,7 @@ TEST_F(ValueDictionaryTest, LookupExact) {
       ValueDictionary::CreateValueDictionaryFromFile(*pos_matcher_,
                                                      dict_name_));
   CollectTokenCallback callback;
-  dictionary->LookupExact("war", &callback);
+  dictionary->LookupExact("war", convreq_, &callback);
   ASSERT_EQ(1, callback.tokens().size());
   EXPECT_EQ("war", callback.tokens()[0].value);
 }
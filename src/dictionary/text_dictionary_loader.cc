@@ -35,6 +35,8 @@
 
 #include <algorithm>
 #include <limits>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -44,6 +46,7 @@
 #include "base/logging.h"
 #include "base/multifile.h"
 #include "base/number_util.h"
+#include "base/scoped_ptr.h"
 #include "base/stl_util.h"
 #include "base/string_piece.h"
 #include "base/util.h"
@@ -94,6 +97,27 @@ void ParseReadingCorrectionTSV(const string &line,
   value_key->second = iter.Get();
 }
 
+// The cost is calculated as -log(prob) * 500.
+// We here assume that the wrong reading appear with 1/100 probability
+// of the original (correct) reading.
+const int kCostPenalty = 2302;      // -log(1/100) * 500;
+
+// Sets up a reading correction token from |key| and the token in the system
+// dictionary that has the same value and the maximum cost.
+void SetReadingCorrectionToken(StringPiece key, const Token &max_cost_token,
+                               Token *token) {
+  key.CopyToString(&token->key);
+  token->value = max_cost_token.value;
+  token->lid = max_cost_token.lid;
+  token->rid = max_cost_token.rid;
+  token->cost = max_cost_token.cost + kCostPenalty;
+  // We don't set SPELLING_CORRECTION. The entries in reading_correction
+  // data are also stored in rewriter/correction_rewriter.cc.
+  // reading_correction_rewriter annotates the spelling correction
+  // notations.
+  token->attributes = Token::NONE;
+}
+
 // Helper function to parse an integer from a string.
 inline bool SafeStrToInt(StringPiece s, int *n) {
   uint32 u32 = 0;
@@ -268,21 +292,8 @@ void TextDictionaryLoader::LoadReadingCorrectionTokens(
       }
     }
 
-    // The cost is calculated as -log(prob) * 500.
-    // We here assume that the wrong reading appear with 1/100 probability
-    // of the original (correct) reading.
-    const int kCostPenalty = 2302;      // -log(1/100) * 500;
     scoped_ptr<Token> token(new Token);
-    value_key.second.CopyToString(&token->key);
-    token->value = max_cost_token->value;
-    token->lid = max_cost_token->lid;
-    token->rid = max_cost_token->rid;
-    token->cost = max_cost_token->cost + kCostPenalty;
-    // We don't set SPELLING_CORRECTION. The entries in reading_correction
-    // data are also stored in rewriter/correction_rewriter.cc.
-    // reading_correction_rewriter annotates the spelling correction
-    // notations.
-    token->attributes = Token::NONE;
+    SetReadingCorrectionToken(value_key.second, *max_cost_token, token.get());
     tokens->push_back(token.release());
     ++reading_correction_size;
     if (--*limit <= 0) {
@@ -293,6 +304,103 @@ void TextDictionaryLoader::LoadReadingCorrectionTokens(
             << reading_correction_filename;
 }
 
+void TextDictionaryLoader::StreamTokens(
+    const string &dictionary_filename,
+    const string &reading_correction_filename,
+    TokenCallback *callback) const {
+  DCHECK(callback);
+
+  // Reading correction entries are read first since they are much fewer than
+  // the tokens in the system dictionary.  Then, while streaming the system
+  // dictionary, we only remember the tokens needed to filter the entries and
+  // to recover their POS and cost, instead of keeping all the tokens.
+  vector<pair<string, string> > corrections;  // Pairs of value and key.
+  set<string> correction_values;
+  set<pair<string, string> > correction_value_keys;
+  if (!reading_correction_filename.empty()) {
+    InputMultiFile file(reading_correction_filename);
+    string line;
+    while (file.ReadLine(&line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      Util::ChopReturns(&line);
+      pair<StringPiece, StringPiece> value_key;
+      ParseReadingCorrectionTSV(line, &value_key);
+      corrections.push_back(make_pair(value_key.first.as_string(),
+                                      value_key.second.as_string()));
+      correction_values.insert(corrections.back().first);
+      correction_value_keys.insert(corrections.back());
+    }
+  }
+
+  // For each value in |correction_values|, the token that has the maximum
+  // cost.  As in LoadReadingCorrectionTokens(), the one with the smallest key
+  // is taken when multiple tokens have the maximum cost.
+  map<string, Token> max_cost_tokens;
+  set<pair<string, string> > existing_value_keys;
+  {
+    InputMultiFile file(dictionary_filename);
+    string line;
+    vector<StringPiece> columns;
+    int num_tokens = 0;
+    while (file.ReadLine(&line)) {
+      Util::ChopReturns(&line);
+      columns.clear();
+      Util::SplitStringUsing(line, "\t", &columns);
+      scoped_ptr<Token> token(ParseTSV(columns));
+      if (!token.get()) {
+        continue;
+      }
+      if (correction_values.find(token->value) != correction_values.end()) {
+        map<string, Token>::iterator iter =
+            max_cost_tokens.find(token->value);
+        if (iter == max_cost_tokens.end()) {
+          max_cost_tokens.insert(make_pair(token->value, *token));
+        } else if (token->cost > iter->second.cost ||
+                   (token->cost == iter->second.cost &&
+                    token->key < iter->second.key)) {
+          iter->second = *token;
+        }
+        const pair<string, string> value_key(token->value, token->key);
+        if (correction_value_keys.find(value_key) !=
+            correction_value_keys.end()) {
+          existing_value_keys.insert(value_key);
+        }
+      }
+      callback->OnToken(*token);
+      ++num_tokens;
+    }
+    LOG(INFO) << num_tokens << " tokens from " << dictionary_filename;
+  }
+
+  if (corrections.empty()) {
+    return;
+  }
+  int reading_correction_size = 0;
+  Token token;
+  for (size_t i = 0; i < corrections.size(); ++i) {
+    if (existing_value_keys.find(corrections[i]) !=
+        existing_value_keys.end()) {
+      VLOG(1) << "System dictionary has the same key-value: "
+              << corrections[i].first << "\t" << corrections[i].second;
+      continue;
+    }
+    map<string, Token>::const_iterator iter =
+        max_cost_tokens.find(corrections[i].first);
+    if (iter == max_cost_tokens.end()) {
+      VLOG(1) << "Cannot find the value in system dicitonary - ignored:"
+              << corrections[i].first;
+      continue;
+    }
+    SetReadingCorrectionToken(corrections[i].second, iter->second, &token);
+    callback->OnToken(token);
+    ++reading_correction_size;
+  }
+  LOG(INFO) << reading_correction_size << " tokens from "
+            << reading_correction_filename;
+}
+
 void TextDictionaryLoader::Clear() {
   STLDeleteElements(&tokens_);
 }
@@ -45,6 +45,14 @@ class POSMatcher;
 
 class TextDictionaryLoader {
  public:
+  // Receives the tokens parsed by StreamTokens().
+  class TokenCallback {
+   public:
+    virtual ~TokenCallback() {}
+    // |token| is valid only during the call.
+    virtual void OnToken(const Token &token) = 0;
+  };
+
   // TODO(noriyukit): Better to pass the pointer of pos_matcher.
   explicit TextDictionaryLoader(const POSMatcher& pos_matcher);
   virtual ~TextDictionaryLoader();
@@ -64,6 +72,16 @@ class TextDictionaryLoader {
                          const string &reading_correction_filename,
                          int limit);
 
+  // Parses the same files as Load() and passes each token to |callback|
+  // instead of keeping it, so that the memory usage doesn't grow with the
+  // size of the dictionary.  The tokens are the same as the ones Load()
+  // loads but their order differs: the dictionary tokens come in the order of
+  // the files, followed by the reading correction tokens in the order of the
+  // reading correction files.  The tokens loaded by Load() are not changed.
+  void StreamTokens(const string &dictionary_filename,
+                    const string &reading_correction_filename,
+                    TokenCallback *callback) const;
+
   // Clears the loaded tokens.
   void Clear();
 
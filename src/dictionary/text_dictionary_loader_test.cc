@@ -53,6 +53,20 @@ const char kTextLines[] =
 const char kReadingCorrectionLines[] =
     "bar\tfoo\tfoo_correct\n"
     "foobar\tfoobar_error\tfoobar_correct\n";
+
+class TokenCollector : public TextDictionaryLoader::TokenCallback {
+ public:
+  virtual void OnToken(const Token &token) {
+    tokens_.push_back(token);
+  }
+
+  const vector<Token> &tokens() const {
+    return tokens_;
+  }
+
+ private:
+  vector<Token> tokens_;
+};
 }  // namespace
 
 class TextDictionaryLoaderTest : public ::testing::Test {
@@ -254,4 +268,49 @@ TEST_F(TextDictionaryLoaderTest, ReadingCorrectionTest) {
   EXPECT_EQ(30 + 2302, tokens[3]->cost);
 }
 
+TEST_F(TextDictionaryLoaderTest, StreamTokensTest) {
+  scoped_ptr<TextDictionaryLoader> loader(CreateTextDictionaryLoader());
+
+  const string dic_filename =
+      FileUtil::JoinPath(FLAGS_test_tmpdir, "test.tsv");
+  const string reading_correction_filename =
+      FileUtil::JoinPath(FLAGS_test_tmpdir, "reading_correction.tsv");
+
+  {
+    OutputFileStream ofs(dic_filename.c_str());
+    ofs << kTextLines;
+    // Another token having the same value with larger cost.
+    ofs << "buz2\t11\t21\t40\tfoobar\n";
+  }
+  {
+    OutputFileStream ofs(reading_correction_filename.c_str());
+    ofs << kReadingCorrectionLines;
+  }
+
+  TokenCollector collector;
+  loader->StreamTokens(dic_filename, reading_correction_filename, &collector);
+  const vector<Token> &tokens = collector.tokens();
+  ASSERT_EQ(5, tokens.size());
+  EXPECT_EQ("key_test1", tokens[0].key);
+  EXPECT_EQ("foo", tokens[1].key);
+  EXPECT_EQ("buz", tokens[2].key);
+  EXPECT_EQ("buz2", tokens[3].key);
+  EXPECT_EQ("foobar_error", tokens[4].key);
+  EXPECT_EQ("foobar", tokens[4].value);
+  EXPECT_EQ(11, tokens[4].lid);
+  EXPECT_EQ(21, tokens[4].rid);
+  EXPECT_EQ(40 + 2302, tokens[4].cost);
+
+  // The loaded tokens are not changed.
+  EXPECT_TRUE(loader->tokens().empty());
+
+  // The same tokens as Load().
+  loader->Load(dic_filename, reading_correction_filename);
+  const vector<Token *> &loaded_tokens = loader->tokens();
+  ASSERT_EQ(tokens.size(), loaded_tokens.size());
+  EXPECT_EQ("foobar_error", loaded_tokens[4]->key);
+  EXPECT_EQ(tokens[4].cost, loaded_tokens[4]->cost);
+  EXPECT_EQ(tokens[4].lid, loaded_tokens[4]->lid);
+}
+
 }  // namespace mozc
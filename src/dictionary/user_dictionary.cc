@@ -42,7 +42,7 @@
 #include "base/thread.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
+#include "converter/conversion_request.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
 #include "dictionary/suppression_dictionary.h"
@@ -301,7 +301,7 @@ bool UserDictionary::HasValue(StringPiece value) const {
 
 void UserDictionary::LookupPredictive(
     StringPiece key,
-    bool,  // use_kana_modifier_insensitive_lookup
+    const ConversionRequest &conversion_request,
     Callback *callback) const {
   scoped_reader_lock l(mutex_.get());
 
@@ -312,7 +312,7 @@ void UserDictionary::LookupPredictive(
   if (tokens_->empty()) {
     return;
   }
-  if (GET_CONFIG(incognito_mode)) {
+  if (conversion_request.config().incognito_mode()) {
     return;
   }
 
@@ -350,7 +350,7 @@ void UserDictionary::LookupPredictive(
 
 // UserDictionary doesn't support kana modifier insensitive lookup.
 void UserDictionary::LookupPrefix(
-    StringPiece key, bool /*use_kana_modifier_insensitive_lookup*/,
+    StringPiece key, const ConversionRequest &conversion_request,
     Callback *callback) const {
   scoped_reader_lock l(mutex_.get());
 
@@ -361,7 +361,7 @@ void UserDictionary::LookupPrefix(
   if (tokens_->empty()) {
     return;
   }
-  if (GET_CONFIG(incognito_mode)) {
+  if (conversion_request.config().incognito_mode()) {
     return;
   }
 
@@ -406,9 +406,12 @@ void UserDictionary::LookupPrefix(
   }
 }
 
-void UserDictionary::LookupExact(StringPiece key, Callback *callback) const {
+void UserDictionary::LookupExact(StringPiece key,
+                                 const ConversionRequest &conversion_request,
+                                 Callback *callback) const {
   scoped_reader_lock l(mutex_.get());
-  if (key.empty() || tokens_->empty() || GET_CONFIG(incognito_mode)) {
+  if (key.empty() || tokens_->empty() ||
+      conversion_request.config().incognito_mode()) {
     return;
   }
   UserPOS::Token key_token;
@@ -438,15 +441,17 @@ void UserDictionary::LookupExact(StringPiece key, Callback *callback) const {
 
 void UserDictionary::LookupReverse(StringPiece str,
                                    NodeAllocatorInterface *allocator,
+                                   const ConversionRequest &conversion_request,
                                    Callback *callback) const {
-  if (GET_CONFIG(incognito_mode)) {
+  if (conversion_request.config().incognito_mode()) {
     return;
   }
 }
 
 bool UserDictionary::LookupComment(StringPiece key, StringPiece value,
+                                   const ConversionRequest &conversion_request,
                                    string *comment) const {
-  if (key.empty() || GET_CONFIG(incognito_mode)) {
+  if (key.empty() || conversion_request.config().incognito_mode()) {
     return false;
   }
 
@@ -517,8 +522,11 @@ bool UserDictionary::AddToAutoRegisteredDictionary(
     return false;
   }
 
+  // Uses the global config, since the registration is not a part of
+  // conversion.
+  const ConversionRequest conversion_request;
   FindValueCallback callback(value);
-  LookupExact(key, &callback);
+  LookupExact(key, conversion_request, &callback);
   if (callback.found()) {
     // Already registered.
     return false;
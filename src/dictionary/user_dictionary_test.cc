@@ -47,6 +47,7 @@
 #include "base/util.h"
 #include "config/config.pb.h"
 #include "config/config_handler.h"
+#include "converter/conversion_request.h"
 #include "data_manager/testing/mock_user_pos_manager.h"
 #include "dictionary/dictionary_test_util.h"
 #include "dictionary/dictionary_token.h"
@@ -252,12 +253,12 @@ class UserDictionaryTest : public ::testing::Test {
     vector<Entry> entries_;
   };
 
-  static void TestLookupPredictiveHelper(const Entry *expected,
-                                         size_t expected_size,
-                                         StringPiece key,
-                                         const UserDictionary &dic) {
+  void TestLookupPredictiveHelper(const Entry *expected,
+                                  size_t expected_size,
+                                  StringPiece key,
+                                  const UserDictionary &dic) const {
     EntryCollector collector;
-    dic.LookupPredictive(key, false, &collector);
+    dic.LookupPredictive(key, convreq_, &collector);
 
     if (expected == NULL || expected_size == 0) {
       EXPECT_TRUE(collector.entries().empty());
@@ -267,13 +268,13 @@ class UserDictionaryTest : public ::testing::Test {
     }
   }
 
-  static void TestLookupPrefixHelper(const Entry *expected,
-                                     size_t expected_size,
-                                     const char *key,
-                                     size_t key_size,
-                                     const UserDictionary &dic) {
+  void TestLookupPrefixHelper(const Entry *expected,
+                              size_t expected_size,
+                              const char *key,
+                              size_t key_size,
+                              const UserDictionary &dic) const {
     EntryCollector collector;
-    dic.LookupPrefix(StringPiece(key, key_size), false, &collector);
+    dic.LookupPrefix(StringPiece(key, key_size), convreq_, &collector);
 
     if (expected == NULL || expected_size == 0) {
       EXPECT_TRUE(collector.entries().empty());
@@ -283,13 +284,13 @@ class UserDictionaryTest : public ::testing::Test {
     }
   }
 
-  static void TestLookupExactHelper(const Entry *expected,
-                                    size_t expected_size,
-                                    const char *key,
-                                    size_t key_size,
-                                    const UserDictionary &dic) {
+  void TestLookupExactHelper(const Entry *expected,
+                             size_t expected_size,
+                             const char *key,
+                             size_t key_size,
+                             const UserDictionary &dic) const {
     EntryCollector collector;
-    dic.LookupExact(StringPiece(key, key_size), &collector);
+    dic.LookupExact(StringPiece(key, key_size), convreq_, &collector);
 
     if (expected == NULL || expected_size == 0) {
       EXPECT_TRUE(collector.entries().empty());
@@ -359,14 +360,15 @@ class UserDictionaryTest : public ::testing::Test {
   }
 
   // Helper function to lookup comment string from |dic|.
-  static string LookupComment(const UserDictionary& dic,
-                              StringPiece key, StringPiece value) {
+  string LookupComment(const UserDictionary& dic,
+                       StringPiece key, StringPiece value) const {
     string comment;
-    dic.LookupComment(key, value, &comment);
+    dic.LookupComment(key, value, convreq_, &comment);
     return comment;
   }
 
   scoped_ptr<SuppressionDictionary> suppression_dictionary_;
+  ConversionRequest convreq_;
 
  private:
   mozc::usage_stats::scoped_usage_stats_enabler usage_stats_enabler_;
@@ -567,6 +569,7 @@ TEST_F(UserDictionaryTest, IncognitoModeTest) {
   config::ConfigHandler::GetConfig(&config);
   config.set_incognito_mode(true);
   config::ConfigHandler::SetConfig(config);
+  convreq_.set_config(config::ConfigHandler::GetConfigSnapshot());
 
   scoped_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
   // Wait for async reload called from the constructor.
@@ -583,15 +586,16 @@ TEST_F(UserDictionaryTest, IncognitoModeTest) {
 
   config.set_incognito_mode(false);
   config::ConfigHandler::SetConfig(config);
+  convreq_.set_config(config::ConfigHandler::GetConfigSnapshot());
 
   {
     EntryCollector collector;
-    dic->LookupPrefix("start", false, &collector);
+    dic->LookupPrefix("start", convreq_, &collector);
     EXPECT_FALSE(collector.entries().empty());
   }
   {
     EntryCollector collector;
-    dic->LookupPredictive("s", false, &collector);
+    dic->LookupPredictive("s", convreq_, &collector);
     EXPECT_FALSE(collector.entries().empty());
   }
 }
@@ -637,7 +641,7 @@ TEST_F(UserDictionaryTest, AsyncLoadTest) {
       dic->Reload();
       for (int i = 0; i < 1000; ++i) {
         CollectTokenCallback callback;
-        dic->LookupPrefix(keys[i], false, &callback);
+        dic->LookupPrefix(keys[i], convreq_, &callback);
       }
     }
     dic->WaitForReloader();
@@ -848,7 +852,7 @@ TEST_F(UserDictionaryTest, TestSuggestionOnlyWord) {
   {
     const char kKey[] = "key0123";
     CollectTokenCallback callback;
-    user_dic->LookupPrefix(kKey, false, &callback);
+    user_dic->LookupPrefix(kKey, convreq_, &callback);
     const vector<Token> &tokens = callback.tokens();
     for (size_t i = 0; i < tokens.size(); ++i) {
       EXPECT_EQ("default", tokens[i].value);
@@ -857,7 +861,7 @@ TEST_F(UserDictionaryTest, TestSuggestionOnlyWord) {
   {
     const char kKey[] = "key";
     CollectTokenCallback callback;
-    user_dic->LookupPredictive(kKey, false, &callback);
+    user_dic->LookupPredictive(kKey, convreq_, &callback);
     const vector<Token> &tokens = callback.tokens();
     for (size_t i = 0; i < tokens.size(); ++i) {
       EXPECT_TRUE(tokens[i].value == "suggest_only" ||
@@ -928,20 +932,24 @@ TEST_F(UserDictionaryTest, LookupComment) {
   // Entry is in user dictionary but has no comment.
   string comment;
   comment = "prev comment";
-  EXPECT_FALSE(dic->LookupComment("comment_key1", "comment_value2", &comment));
+  EXPECT_FALSE(dic->LookupComment("comment_key1", "comment_value2",
+                                  convreq_, &comment));
   EXPECT_EQ("prev comment", comment);
 
   // Usual case: single key-value pair with comment.
-  EXPECT_TRUE(dic->LookupComment("comment_key2", "comment_value2", &comment));
+  EXPECT_TRUE(dic->LookupComment("comment_key2", "comment_value2",
+                                 convreq_, &comment));
   EXPECT_EQ("comment", comment);
 
   // There exist two entries having the same key, value and POS.  Since POS is
   // irrelevant to comment lookup, the first nonempty comment should be found.
-  EXPECT_TRUE(dic->LookupComment("comment_key3", "comment_value3", &comment));
+  EXPECT_TRUE(dic->LookupComment("comment_key3", "comment_value3",
+                                 convreq_, &comment));
   EXPECT_EQ("comment1", comment);
 
   // White-space only comments should be cleared.
-  EXPECT_FALSE(dic->LookupComment("comment_key4", "comment_value4", &comment));
+  EXPECT_FALSE(dic->LookupComment("comment_key4", "comment_value4",
+                                  convreq_, &comment));
   // The previous comment should remain.
   EXPECT_EQ("comment1", comment);
 
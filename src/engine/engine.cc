@@ -29,6 +29,7 @@
 
 #include "engine/engine.h"
 
+#include "base/flags.h"
 #include "base/logging.h"
 #include "base/port.h"
 #include "converter/connector_base.h"
@@ -58,6 +59,11 @@
 #include "rewriter/rewriter.h"
 #include "rewriter/rewriter_interface.h"
 
+DEFINE_bool(enable_system_dictionary_value_cache,
+            false,
+            "Keep the most referred values of the system dictionary decoded "
+            "in heap. Scans all the tokens when the engine is initialized.");
+
 namespace mozc {
 
 using mozc::dictionary::DictionaryImpl;
@@ -153,9 +159,12 @@ void Engine::Init(
   int dictionary_size = 0;
   data_manager->GetSystemDictionaryData(&dictionary_data, &dictionary_size);
 
+  const SystemDictionary::Options system_dictionary_options =
+      FLAGS_enable_system_dictionary_value_cache ?
+      SystemDictionary::ENABLE_VALUE_CACHE : SystemDictionary::NONE;
   dictionary_.reset(new DictionaryImpl(
-      SystemDictionary::CreateSystemDictionaryFromImage(
-          dictionary_data, dictionary_size),
+      SystemDictionary::CreateSystemDictionaryFromImageWithOptions(
+          dictionary_data, dictionary_size, system_dictionary_options),
       ValueDictionary::CreateValueDictionaryFromImage(
           *data_manager->GetPOSMatcher(), dictionary_data, dictionary_size),
       user_dictionary_.get(),
@@ -59,7 +59,9 @@ class EngineInterface {
   // managed by the engine class and should not be deleted by callers.
   virtual SuppressionDictionary *GetSuppressionDictionary() = 0;
 
-  // Reloads internal data, e.g., user dictionary, etc.
+  // Reloads internal data, e.g., user dictionary, etc. Can be called while
+  // other threads are converting: the new user dictionary is built aside and
+  // swapped in under its own lock.
   virtual bool Reload() = 0;
 
   // Gets a user data manager.
@@ -38,6 +38,7 @@
         '../config/config_test.gyp:config_all_test',
         '../composer/composer.gyp:composer_all_test',
         '../converter/converter_test.gyp:converter_all_test',
+        '../data_manager/packed/packed_data_manager_test.gyp:packed_data_all_test',
         '../dictionary/dictionary_test.gyp:dictionary_all_test',
         '../dictionary/file/dictionary_file_test.gyp:dictionary_file_all_test',
         '../dictionary/system/system_dictionary_test.gyp:system_dictionary_all_test',
@@ -85,6 +85,13 @@ void IPCServer::Wait() {
   }
 }
 
+void IPCServer::SetNumWorkers(int num_workers) {
+#if defined(OS_LINUX) && !defined(OS_ANDROID)
+  DCHECK_GE(num_workers, 0);
+  num_workers_ = num_workers;
+#endif  // OS_LINUX && !OS_ANDROID
+}
+
 IPCClientInterface::~IPCClientInterface() {
 }
 
@@ -123,6 +130,14 @@ uint32 IPCClient::GetServerProcessId() const {
   return ipc_path_manager_->GetServerProcessId();
 }
 
+bool IPCClient::IsReusable() const {
+#if defined(OS_LINUX) && !defined(OS_ANDROID)
+  return connected_ && persistent_;
+#else
+  return false;
+#endif  // OS_LINUX && !OS_ANDROID
+}
+
 // static
 bool IPCClient::TerminateServer(const string &name) {
   IPCClient client(name);
@@ -44,6 +44,7 @@ namespace mozc {
 
 class IPCPathManager;
 class Thread;
+class IPCServerDispatcher;
 
 enum {
   IPC_REQUESTSIZE = 16 * 8192,
@@ -84,6 +85,9 @@ class IPCClientInterface {
 
   // return last error
   virtual IPCErrorType GetLastIPCError() const = 0;
+
+  // Return true if Call() can be invoked more than once with this client.
+  virtual bool IsReusable() const { return false; }
 };
 
 #ifdef OS_MACOSX
@@ -146,8 +150,12 @@ class IPCClient : public IPCClientInterface {
   // Return true when IPC finishes successfully.
   // When Server doesn't send response within timeout, 'Call' returns false.
   // When timeout (in msec) is set -1, 'Call' waits forever.
-  // Note that on Linux and Windows, Call() closes the socket_. This means you
-  // cannot call the Call() function more than once.
+  // Note that on Windows, and on Linux when the server doesn't support
+  // persistent connections, Call() closes the socket_. This means you
+  // cannot call the Call() function more than once unless IsReusable()
+  // returns true.
+  // GetLastIPCError() returns IPC_WRITE_ERROR only when the request could
+  // not be sent entirely, i.e., the server has never processed it.
   bool Call(const char *request,
             size_t request_size,
             char *response,
@@ -158,6 +166,8 @@ class IPCClient : public IPCClientInterface {
     return last_ipc_error_;
   }
 
+  bool IsReusable() const;
+
   // terminate the server process named |name|
   // Do not use it unless version mismatch happens
   static bool TerminateServer(const string &name);
@@ -180,6 +190,10 @@ class IPCClient : public IPCClientInterface {
   MachPortManagerInterface *mach_port_manager_;
 #else
   int socket_;
+#if defined(OS_LINUX) && !defined(OS_ANDROID)
+  // true if the connection is kept open across Call()s.
+  bool persistent_;
+#endif  // OS_LINUX && !OS_ANDROID
 #endif
   bool connected_;
   IPCPathManager *ipc_path_manager_;
@@ -268,6 +282,15 @@ class IPCServer {
   // call TerminateThread()
   void Terminate();
 
+  // Set the number of worker threads which call Process().
+  // When |num_workers| is 0, Process() is called from the thread running
+  // Loop(). When |num_workers| is greater than 1, Process() may be called
+  // concurrently from different workers, while all the requests sent over
+  // one connection are processed by the same worker in order.
+  // Needs to be called before Loop(). Only the server on Linux supports
+  // worker threads for now; it is ignored on the other platforms.
+  void SetNumWorkers(int num_workers);
+
 #ifdef OS_MACOSX
   void SetMachPortManager(MachPortManagerInterface *manager) {
     mach_port_manager_ = manager;
@@ -290,6 +313,10 @@ class IPCServer {
 #else
   int socket_;
   string server_address_;
+#if defined(OS_LINUX) && !defined(OS_ANDROID)
+  int num_workers_;
+  scoped_ptr<IPCServerDispatcher> dispatcher_;
+#endif  // OS_LINUX && !OS_ANDROID
 #endif
 
   int timeout_;
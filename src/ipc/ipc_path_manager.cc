@@ -222,6 +222,11 @@ bool IPCPathManager::SavePathName() {
   ipc_path_info_->set_thread_id(0);
 #endif
 
+#if defined(OS_LINUX) && !defined(OS_ANDROID)
+  // The epoll-based server in unix_ipc.cc keeps connections open.
+  ipc_path_info_->set_persistent_connection(true);
+#endif
+
   string buf;
   if (!ipc_path_info_->SerializeToString(&buf)) {
     LOG(ERROR) << "SerializeToString failed";
@@ -297,6 +302,10 @@ uint32 IPCPathManager::GetServerProcessId() const {
   return ipc_path_info_->process_id();
 }
 
+bool IPCPathManager::IsPersistentConnectionSupported() const {
+  return ipc_path_info_->persistent_connection();
+}
+
 void IPCPathManager::Clear() {
   scoped_lock l(mutex_.get());
   ipc_path_info_->Clear();
@@ -88,6 +88,9 @@ class IPCPathManager {
   // return process id of the server
   uint32 GetServerProcessId() const;
 
+  // return true if the server accepts persistent connections.
+  bool IsPersistentConnectionSupported() const;
+
   // Checks the server pid is the valid server specified with server_path.
   // server pid can be obtained by OS dependent method.
   // This API is only available on Windows Vista or Linux.
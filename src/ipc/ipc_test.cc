@@ -168,3 +168,74 @@ TEST(IPCTest, IPCTest) {
 
   con.Wait();
 }
+
+#if defined(OS_LINUX) && !defined(OS_ANDROID)
+TEST(IPCTest, PersistentConnectionTest) {
+  mozc::SystemUtil::SetUserProfileDirectory(FLAGS_test_tmpdir);
+  const char kPersistentServerAddress[] = "test_persistent_echo_server";
+
+  EchoServer con(kPersistentServerAddress, 10, 1000);
+  con.SetNumWorkers(2);
+  con.LoopAndReturn();
+  mozc::Util::Sleep(1000);
+
+  // One client can call the server many times over the same connection.
+  mozc::IPCClient client(kPersistentServerAddress, "");
+  ASSERT_TRUE(client.Connected());
+  EXPECT_TRUE(client.IsReusable());
+  char buf[8192];
+  for (int i = 0; i < 100; ++i) {
+    const string input = "test" + GenRandomString(max(mozc::Util::Random(8000),
+                                                      1));
+    size_t length = sizeof(buf);
+    ASSERT_TRUE(client.Call(input.data(), input.size(), buf, &length, 1000));
+    EXPECT_EQ(input, string(buf, length));
+  }
+  EXPECT_TRUE(client.IsReusable());
+
+  // Empty response is also delivered as a frame.
+  mozc::IPCClient kill(kPersistentServerAddress, "");
+  const char kill_cmd[32] = "kill";
+  size_t output_size = sizeof(buf);
+  EXPECT_TRUE(kill.Call(kill_cmd, strlen(kill_cmd), buf, &output_size, 1000));
+  EXPECT_EQ(0, output_size);
+
+  con.Wait();
+}
+
+TEST(IPCTest, IdlePersistentConnectionTest) {
+  mozc::SystemUtil::SetUserProfileDirectory(FLAGS_test_tmpdir);
+  const char kIdleServerAddress[] = "test_idle_echo_server";
+
+  // Without workers, the thread running Loop() handles all the connections.
+  EchoServer con(kIdleServerAddress, 10, 5000);
+  con.SetNumWorkers(0);
+  con.LoopAndReturn();
+  mozc::Util::Sleep(1000);
+
+  // The idle client has sent only the preamble. The server must not wait
+  // for its first request while the other client is calling.
+  mozc::IPCClient idle(kIdleServerAddress, "");
+  ASSERT_TRUE(idle.Connected());
+  mozc::Util::Sleep(100);
+
+  mozc::IPCClient client(kIdleServerAddress, "");
+  ASSERT_TRUE(client.Connected());
+  char buf[8192];
+  const string input = "test";
+  size_t length = sizeof(buf);
+  ASSERT_TRUE(client.Call(input.data(), input.size(), buf, &length, 1000));
+  EXPECT_EQ(input, string(buf, length));
+
+  // The idle client can still call the server later.
+  length = sizeof(buf);
+  ASSERT_TRUE(idle.Call(input.data(), input.size(), buf, &length, 1000));
+  EXPECT_EQ(input, string(buf, length));
+
+  const char kill_cmd[32] = "kill";
+  size_t output_size = sizeof(buf);
+  EXPECT_TRUE(client.Call(kill_cmd, strlen(kill_cmd), buf, &output_size,
+                          1000));
+  con.Wait();
+}
+#endif  // OS_LINUX && !OS_ANDROID
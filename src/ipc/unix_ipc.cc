@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <libgen.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -47,9 +48,12 @@
 #include <cerrno>
 #include <cstring>
 #include <cstdlib>
+#include <set>
+#include <vector>
 
 #include "base/file_util.h"
 #include "base/logging.h"
+#include "base/mutex.h"
 #include "base/thread.h"
 #include "ipc/ipc_path_manager.h"
 
@@ -63,6 +67,18 @@ namespace {
 
 const int kInvalidSocket = -1;
 
+// A client which keeps the connection open sends this preamble right after
+// connecting, and then sends each request as a frame, i.e., 4-byte length in
+// network byte order followed by the payload. The server replies with a frame
+// in the same format. As the request of the legacy protocol is a serialized
+// protocol buffer, which never starts with '\0', the server can tell the two
+// protocols apart by the first byte.
+const char kPersistentConnectionPreamble[] = { '\0', 'M', 'Z', 'C' };
+const size_t kFrameHeaderSize = 4;
+
+// Maximum number of events handled by one epoll_wait() call.
+const int kMaxEpollEvents = 16;
+
 void mkdir_p(const string &dirname) {
   const string parent_dir = FileUtil::Dirname(dirname);
   struct stat st;
@@ -208,6 +224,87 @@ bool RecvMessage(int socket,
   return true;
 }
 
+// Receives exactly |size| bytes. |eof| is set to true when the peer closed
+// the connection before sending any byte.
+bool RecvFully(int socket,
+               char *buf,
+               size_t size,
+               int timeout,
+               bool *eof,
+               IPCErrorType *last_ipc_error) {
+  *eof = false;
+  size_t received = 0;
+  while (received < size) {
+    if (IsReadTimeout(socket, timeout)) {
+      LOG(WARNING) << "Read timeout " << timeout;
+      *last_ipc_error = IPC_TIMEOUT_ERROR;
+      return false;
+    }
+    const ssize_t l = ::recv(socket, buf + received, size - received, 0);
+    if (l < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(ERROR) << "an error occurred during recv(): " << strerror(errno);
+      *last_ipc_error = IPC_READ_ERROR;
+      return false;
+    }
+    if (l == 0) {
+      *eof = (received == 0);
+      *last_ipc_error = IPC_READ_ERROR;
+      return false;
+    }
+    received += l;
+  }
+  return true;
+}
+
+bool SendFrame(int socket,
+               const char *buf,
+               size_t buf_length,
+               int timeout,
+               IPCErrorType *last_ipc_error) {
+  const uint32 length = htonl(static_cast<uint32>(buf_length));
+  char header[kFrameHeaderSize];
+  ::memcpy(header, &length, kFrameHeaderSize);
+  if (!SendMessage(socket, header, kFrameHeaderSize, timeout,
+                   last_ipc_error)) {
+    return false;
+  }
+  return buf_length == 0 ||
+      SendMessage(socket, buf, buf_length, timeout, last_ipc_error);
+}
+
+// |buf_length| must be the size of |buf| on input, and is set to the size of
+// the received payload.
+bool RecvFrame(int socket,
+               char *buf,
+               size_t *buf_length,
+               int timeout,
+               bool *eof,
+               IPCErrorType *last_ipc_error) {
+  char header[kFrameHeaderSize];
+  if (!RecvFully(socket, header, kFrameHeaderSize, timeout, eof,
+                 last_ipc_error)) {
+    return false;
+  }
+  uint32 length = 0;
+  ::memcpy(&length, header, kFrameHeaderSize);
+  length = ntohl(length);
+  if (length > *buf_length) {
+    LOG(ERROR) << "frame is too large: " << length;
+    *last_ipc_error = IPC_READ_ERROR;
+    return false;
+  }
+  bool unused_eof = false;
+  if (!RecvFully(socket, buf, length, timeout, &unused_eof, last_ipc_error)) {
+    return false;
+  }
+  *buf_length = length;
+  VLOG(1) << length << " bytes received";
+  return true;
+}
+
 void SetCloseOnExecFlag(int fd) {
   int flags = ::fcntl(fd, F_GETFD, 0);
   if (flags < 0) {
@@ -231,14 +328,14 @@ bool IsAbstractSocket(const string& address) {
 
 // Client
 IPCClient::IPCClient(const string &name)
-    : socket_(kInvalidSocket), connected_(false),
+    : socket_(kInvalidSocket), persistent_(false), connected_(false),
       ipc_path_manager_(NULL),
       last_ipc_error_(IPC_NO_ERROR) {
   Init(name, "");
 }
 
 IPCClient::IPCClient(const string &name, const string &server_path)
-    : socket_(kInvalidSocket), connected_(false),
+    : socket_(kInvalidSocket), persistent_(false), connected_(false),
       ipc_path_manager_(NULL),
       last_ipc_error_(IPC_NO_ERROR) {
   Init(name, server_path);
@@ -300,6 +397,14 @@ void IPCClient::Init(const string &name, const string &server_path) {
         last_ipc_error_ = IPC_INVALID_SERVER;
         break;
       }
+      persistent_ = manager->IsPersistentConnectionSupported();
+      if (persistent_ &&
+          !SendMessage(socket_, kPersistentConnectionPreamble,
+                       sizeof(kPersistentConnectionPreamble), -1,
+                       &last_ipc_error_)) {
+        LOG(ERROR) << "Cannot send the preamble";
+        break;
+      }
       last_ipc_error_ = IPC_NO_ERROR;
       connected_ = true;
       break;
@@ -325,6 +430,26 @@ bool IPCClient::Call(const char *request_,
                      size_t *response_size,
                      int32 timeout) {
   last_ipc_error_ = IPC_NO_ERROR;
+  if (persistent_) {
+    // The connection is kept open, so Call() can be invoked again unless
+    // an error occurs.
+    bool eof = false;
+    if (!SendFrame(socket_, request_, input_length, timeout,
+                   &last_ipc_error_)) {
+      LOG(ERROR) << "SendFrame failed";
+      connected_ = false;
+      return false;
+    }
+    if (!RecvFrame(socket_, response_, response_size, timeout, &eof,
+                   &last_ipc_error_)) {
+      LOG(ERROR) << "RecvFrame failed";
+      connected_ = false;
+      return false;
+    }
+    VLOG(1) << "Call succeeded";
+    return true;
+  }
+
   if (!SendMessage(socket_, request_, input_length, timeout,
                    &last_ipc_error_)) {
     LOG(ERROR) << "SendMessage failed";
@@ -352,11 +477,429 @@ bool IPCClient::Connected() const {
   return connected_;
 }
 
+namespace {
+class IPCServerWorker;
+}  // namespace
+
+// Dispatches the connections of IPCServer with epoll.
+// Each connection is registered with EPOLLONESHOT so that only one thread
+// handles it at a time. Persistent connections are re-armed after the
+// preamble and after each request, so a thread reads a frame only when it
+// is readable. Legacy connections are closed after one request.
+// When there are workers, a connection is always handled by the worker
+// selected by its file descriptor, so the requests from one client are
+// processed in order by the same thread.
+class IPCServerDispatcher {
+ public:
+  IPCServerDispatcher(IPCServer *server,
+                      int listen_socket,
+                      int timeout,
+                      int num_workers);
+  ~IPCServerDispatcher();
+
+  // Runs the event loop until Process() returns false.
+  void Run();
+
+  // Reads a request from the connection |id|, calls Process() and sends
+  // the response. Returns the result of Process().
+  bool HandleConnection(uint64 id, char *request, char *response);
+
+  // Lets Run() return. This method can be called from workers.
+  void Quit();
+
+ private:
+  enum ConnectionMode {
+    UNKNOWN_CONNECTION = 0,
+    LEGACY_CONNECTION = 1,
+    PERSISTENT_CONNECTION = 2,
+    LISTENER = 3,
+    WAKEUP = 4,
+  };
+
+  static uint64 MakeId(int fd, ConnectionMode mode) {
+    return (static_cast<uint64>(mode) << 32) | static_cast<uint32>(fd);
+  }
+  static int GetFd(uint64 id) {
+    return static_cast<int>(id & 0xFFFFFFFF);
+  }
+  static ConnectionMode GetMode(uint64 id) {
+    return static_cast<ConnectionMode>(id >> 32);
+  }
+
+  bool Watch(int fd, ConnectionMode mode, int op);
+  void Accept();
+  bool DetectMode(int fd, ConnectionMode *mode);
+  void CloseConnection(int fd);
+  bool IsQuitting();
+
+  IPCServer *server_;
+  const int listen_socket_;
+  const int timeout_;
+  int epoll_fd_;
+  int wakeup_pipe_[2];
+  vector<IPCServerWorker *> workers_;
+  scoped_ptr<char[]> request_;
+  scoped_ptr<char[]> response_;
+
+  Mutex mutex_;
+  set<int> connections_;
+  bool quit_;
+
+  DISALLOW_COPY_AND_ASSIGN(IPCServerDispatcher);
+};
+
+namespace {
+
+// Worker thread which handles the connections posted by
+// IPCServerDispatcher.
+class IPCServerWorker : public Thread {
+ public:
+  explicit IPCServerWorker(IPCServerDispatcher *dispatcher)
+      : dispatcher_(dispatcher),
+        request_(new char[IPC_REQUESTSIZE]),
+        response_(new char[IPC_RESPONSESIZE]) {
+    if (::pipe(pipe_) != 0) {
+      LOG(ERROR) << "pipe() failed: " << strerror(errno);
+      pipe_[0] = pipe_[1] = kInvalidSocket;
+      return;
+    }
+    SetCloseOnExecFlag(pipe_[0]);
+    SetCloseOnExecFlag(pipe_[1]);
+  }
+
+  virtual ~IPCServerWorker() {
+    Stop();
+    if (pipe_[0] != kInvalidSocket) {
+      ::close(pipe_[0]);
+    }
+  }
+
+  bool IsAvailable() const {
+    return pipe_[0] != kInvalidSocket;
+  }
+
+  bool Post(uint64 id) {
+    // Writes to a pipe up to PIPE_BUF bytes are atomic.
+    return ::write(pipe_[1], &id, sizeof(id)) == sizeof(id);
+  }
+
+  // Stops accepting new connections and waits until the posted
+  // connections are handled.
+  void Stop() {
+    if (pipe_[1] != kInvalidSocket) {
+      ::close(pipe_[1]);
+      pipe_[1] = kInvalidSocket;
+      Join();
+    }
+  }
+
+  virtual void Run() {
+    uint64 id = 0;
+    while (::read(pipe_[0], &id, sizeof(id)) == sizeof(id)) {
+      if (!dispatcher_->HandleConnection(id, request_.get(),
+                                         response_.get())) {
+        dispatcher_->Quit();
+      }
+    }
+  }
+
+ private:
+  IPCServerDispatcher *dispatcher_;
+  int pipe_[2];
+  scoped_ptr<char[]> request_;
+  scoped_ptr<char[]> response_;
+
+  DISALLOW_COPY_AND_ASSIGN(IPCServerWorker);
+};
+
+}  // namespace
+
+IPCServerDispatcher::IPCServerDispatcher(IPCServer *server,
+                                         int listen_socket,
+                                         int timeout,
+                                         int num_workers)
+    : server_(server),
+      listen_socket_(listen_socket),
+      timeout_(timeout),
+      epoll_fd_(kInvalidSocket),
+      request_(new char[IPC_REQUESTSIZE]),
+      response_(new char[IPC_RESPONSESIZE]),
+      quit_(false) {
+  wakeup_pipe_[0] = wakeup_pipe_[1] = kInvalidSocket;
+
+  epoll_fd_ = ::epoll_create(kMaxEpollEvents);
+  if (epoll_fd_ < 0) {
+    LOG(ERROR) << "epoll_create() failed: " << strerror(errno);
+    return;
+  }
+  SetCloseOnExecFlag(epoll_fd_);
+
+  if (::pipe(wakeup_pipe_) != 0) {
+    LOG(ERROR) << "pipe() failed: " << strerror(errno);
+    wakeup_pipe_[0] = wakeup_pipe_[1] = kInvalidSocket;
+    return;
+  }
+  SetCloseOnExecFlag(wakeup_pipe_[0]);
+  SetCloseOnExecFlag(wakeup_pipe_[1]);
+
+  if (!Watch(listen_socket_, LISTENER, EPOLL_CTL_ADD) ||
+      !Watch(wakeup_pipe_[0], WAKEUP, EPOLL_CTL_ADD)) {
+    return;
+  }
+
+  for (int i = 0; i < num_workers; ++i) {
+    IPCServerWorker *worker = new IPCServerWorker(this);
+    if (!worker->IsAvailable()) {
+      delete worker;
+      break;
+    }
+    worker->SetJoinable(true);
+    worker->Start();
+    workers_.push_back(worker);
+  }
+}
+
+IPCServerDispatcher::~IPCServerDispatcher() {
+  Quit();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    delete workers_[i];
+  }
+  workers_.clear();
+
+  set<int> connections;
+  {
+    scoped_lock l(&mutex_);
+    connections.swap(connections_);
+  }
+  for (set<int>::const_iterator it = connections.begin();
+       it != connections.end(); ++it) {
+    ::close(*it);
+  }
+
+  for (size_t i = 0; i < 2; ++i) {
+    if (wakeup_pipe_[i] != kInvalidSocket) {
+      ::close(wakeup_pipe_[i]);
+    }
+  }
+  if (epoll_fd_ != kInvalidSocket) {
+    ::close(epoll_fd_);
+  }
+}
+
+bool IPCServerDispatcher::Watch(int fd, ConnectionMode mode, int op) {
+  struct epoll_event event;
+  ::memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  if (mode != LISTENER && mode != WAKEUP) {
+    event.events |= EPOLLONESHOT;
+  }
+  event.data.u64 = MakeId(fd, mode);
+  if (::epoll_ctl(epoll_fd_, op, fd, &event) != 0) {
+    LOG(ERROR) << "epoll_ctl() failed: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void IPCServerDispatcher::Run() {
+  if (epoll_fd_ < 0 || wakeup_pipe_[0] == kInvalidSocket) {
+    LOG(ERROR) << "dispatcher is not available";
+    return;
+  }
+
+  struct epoll_event events[kMaxEpollEvents];
+  while (!IsQuitting()) {
+    const int num_events =
+        ::epoll_wait(epoll_fd_, events, kMaxEpollEvents, -1);
+    if (num_events < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(ERROR) << "epoll_wait() failed: " << strerror(errno);
+      return;
+    }
+    for (int i = 0; i < num_events && !IsQuitting(); ++i) {
+      const uint64 id = events[i].data.u64;
+      switch (GetMode(id)) {
+        case LISTENER:
+          Accept();
+          break;
+        case WAKEUP:
+          // Quit() has been called.
+          break;
+        default:
+          if (workers_.empty()) {
+            if (!HandleConnection(id, request_.get(), response_.get())) {
+              Quit();
+            }
+          } else if (!workers_[GetFd(id) % workers_.size()]->Post(id)) {
+            LOG(ERROR) << "Cannot post the connection to the worker";
+            CloseConnection(GetFd(id));
+          }
+          break;
+      }
+    }
+  }
+}
+
+void IPCServerDispatcher::Accept() {
+  const int new_sock = ::accept(listen_socket_, NULL, NULL);
+  if (new_sock < 0) {
+    LOG(FATAL) << "accept() failed: " << strerror(errno);
+    return;
+  }
+  SetCloseOnExecFlag(new_sock);
+  pid_t pid = 0;
+  if (!IsPeerValid(new_sock, &pid)) {
+    ::close(new_sock);
+    return;
+  }
+  {
+    scoped_lock l(&mutex_);
+    connections_.insert(new_sock);
+  }
+  if (!Watch(new_sock, UNKNOWN_CONNECTION, EPOLL_CTL_ADD)) {
+    CloseConnection(new_sock);
+  }
+}
+
+bool IPCServerDispatcher::DetectMode(int fd, ConnectionMode *mode) {
+  if (IsReadTimeout(fd, timeout_)) {
+    LOG(WARNING) << "Read timeout " << timeout_;
+    return false;
+  }
+  char first_byte = 0;
+  if (::recv(fd, &first_byte, 1, MSG_PEEK) != 1) {
+    return false;
+  }
+  if (first_byte != kPersistentConnectionPreamble[0]) {
+    *mode = LEGACY_CONNECTION;
+    return true;
+  }
+
+  char preamble[sizeof(kPersistentConnectionPreamble)];
+  bool eof = false;
+  IPCErrorType last_ipc_error = IPC_NO_ERROR;
+  if (!RecvFully(fd, preamble, sizeof(preamble), timeout_, &eof,
+                 &last_ipc_error) ||
+      ::memcmp(preamble, kPersistentConnectionPreamble,
+               sizeof(preamble)) != 0) {
+    LOG(WARNING) << "Invalid preamble";
+    return false;
+  }
+  *mode = PERSISTENT_CONNECTION;
+  return true;
+}
+
+bool IPCServerDispatcher::HandleConnection(uint64 id,
+                                           char *request,
+                                           char *response) {
+  const int fd = GetFd(id);
+  if (IsQuitting()) {
+    CloseConnection(fd);
+    return true;
+  }
+
+  ConnectionMode mode = GetMode(id);
+  if (mode == UNKNOWN_CONNECTION) {
+    if (!DetectMode(fd, &mode)) {
+      CloseConnection(fd);
+      return true;
+    }
+    if (mode == PERSISTENT_CONNECTION) {
+      // Doesn't wait for the first frame here so that an idle client
+      // doesn't hold this thread. epoll reports the connection again as
+      // soon as the frame is readable, including when it has already
+      // arrived with the preamble.
+      if (!Watch(fd, PERSISTENT_CONNECTION, EPOLL_CTL_MOD)) {
+        CloseConnection(fd);
+      }
+      return true;
+    }
+  }
+
+  IPCErrorType last_ipc_error = IPC_NO_ERROR;
+  size_t request_size = IPC_REQUESTSIZE;
+  size_t response_size = IPC_RESPONSESIZE;
+
+  if (mode == LEGACY_CONNECTION) {
+    // The client half-closes the socket after sending the request.
+    bool result = true;
+    if (RecvMessage(fd, request, &request_size, timeout_, &last_ipc_error)) {
+      if (!server_->Process(request, request_size,
+                            response, &response_size)) {
+        LOG(WARNING) << "Process() failed";
+        result = false;
+      }
+      if (response_size > 0) {
+        SendMessage(fd, response, response_size, timeout_, &last_ipc_error);
+      }
+    }
+    CloseConnection(fd);
+    return result;
+  }
+
+  DCHECK_EQ(PERSISTENT_CONNECTION, mode);
+  bool eof = false;
+  if (!RecvFrame(fd, request, &request_size, timeout_, &eof,
+                 &last_ipc_error)) {
+    // |eof| is true when the client closed the connection.
+    LOG_IF(WARNING, !eof) << "RecvFrame failed";
+    CloseConnection(fd);
+    return true;
+  }
+
+  const bool result = server_->Process(request, request_size,
+                                       response, &response_size);
+  if (!result) {
+    LOG(WARNING) << "Process() failed";
+  }
+  // Always sends a frame so that the client doesn't wait for the timeout.
+  if (!SendFrame(fd, response, response_size, timeout_, &last_ipc_error) ||
+      !result || !Watch(fd, PERSISTENT_CONNECTION, EPOLL_CTL_MOD)) {
+    CloseConnection(fd);
+  }
+  return result;
+}
+
+void IPCServerDispatcher::CloseConnection(int fd) {
+  {
+    scoped_lock l(&mutex_);
+    if (connections_.erase(fd) == 0) {
+      return;
+    }
+  }
+  // Closing the descriptor removes it from the epoll set as well.
+  ::close(fd);
+}
+
+void IPCServerDispatcher::Quit() {
+  {
+    scoped_lock l(&mutex_);
+    if (quit_) {
+      return;
+    }
+    quit_ = true;
+  }
+  if (wakeup_pipe_[1] != kInvalidSocket) {
+    const char kWakeup = 'q';
+    if (::write(wakeup_pipe_[1], &kWakeup, 1) != 1) {
+      LOG(ERROR) << "write() failed: " << strerror(errno);
+    }
+  }
+}
+
+bool IPCServerDispatcher::IsQuitting() {
+  scoped_lock l(&mutex_);
+  return quit_;
+}
+
 // Server
 IPCServer::IPCServer(const string &name,
                      int32 num_connections,
                      int32 timeout)
-    : connected_(false), socket_(kInvalidSocket), timeout_(timeout) {
+    : connected_(false), socket_(kInvalidSocket), num_workers_(0),
+      timeout_(timeout) {
   IPCPathManager *manager = IPCPathManager::GetIPCPathManager(name);
   if (!manager->CreateNewPathName() && !manager->LoadPathName()) {
     LOG(ERROR) << "Cannot prepare IPC path name";
@@ -427,6 +970,7 @@ IPCServer::~IPCServer() {
   if (server_thread_.get() != NULL) {
     server_thread_->Terminate();
   }
+  dispatcher_.reset();
   ::shutdown(socket_, SHUT_RDWR);
   ::close(socket_);
   if (!IsAbstractSocket(server_address_)) {
@@ -443,38 +987,12 @@ bool IPCServer::Connected() const {
 }
 
 void IPCServer::Loop() {
-  // The most portable and straightforward single-thread server
-  bool error = false;
-  IPCErrorType last_ipc_error = IPC_NO_ERROR;
-  pid_t pid = 0;
-  while (!error) {
-    const int new_sock = ::accept(socket_, NULL, NULL);
-    if (new_sock < 0) {
-      LOG(FATAL) << "accept() failed: " << strerror(errno);
-      return;
-    }
-    if (!IsPeerValid(new_sock, &pid)) {
-      continue;
-    }
-    size_t request_size = sizeof(request_);
-    size_t response_size = sizeof(response_);
-    if (RecvMessage(new_sock,
-                    &request_[0],
-                    &request_size, timeout_, &last_ipc_error)) {
-      if (!Process(&request_[0], request_size,
-                   &response_[0], &response_size)) {
-        LOG(WARNING) << "Process() failed";
-        error = true;
-      }
-      if (response_size > 0) {
-        SendMessage(new_sock,
-                    &response_[0],
-                    response_size, timeout_, &last_ipc_error);
-      }
-    }
-
-    ::close(new_sock);
-  }
+  // Connections are kept open and dispatched with epoll. Process() is called
+  // from this thread or from |num_workers_| worker threads.
+  dispatcher_.reset(
+      new IPCServerDispatcher(this, socket_, timeout_, num_workers_));
+  dispatcher_->Run();
+  dispatcher_.reset();
 
   ::shutdown(socket_, SHUT_RDWR);
   ::close(socket_);
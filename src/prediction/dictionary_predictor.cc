@@ -33,6 +33,7 @@
 #include <cctype>
 #include <climits>   // INT_MAX
 #include <cmath>
+#include <deque>
 #include <list>
 #include <map>
 #include <set>
@@ -42,11 +43,17 @@
 
 #include "base/flags.h"
 #include "base/logging.h"
+#include "base/mutex.h"
 #include "base/number_util.h"
+#include "base/scoped_ptr.h"
+#include "base/stl_util.h"
+#include "base/stopwatch.h"
+#include "base/thread.h"
+#include "base/trace.h"
+#include "base/unnamed_event.h"
 #include "base/util.h"
 #include "composer/composer.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/connector_interface.h"
 #include "converter/conversion_request.h"
 #include "converter/converter_interface.h"
@@ -71,6 +78,23 @@ DEFINE_bool(enable_mixed_conversion,
             false,
             "Enable mixed conversion feature");
 
+DEFINE_bool(enable_top_k_predictive_lookup,
+            false,
+            "Look up the unigram candidates in cost order and stop at the "
+            "lookup limit, instead of collecting the shortest keys first");
+
+DEFINE_int32(dictionary_predictor_worker_threads,
+             0,
+             "Number of the worker threads to aggregate the predictions other "
+             "than the realtime conversion concurrently with it. "
+             "0 aggregates all the predictions sequentially.");
+
+DEFINE_int32(dictionary_predictor_source_deadline_msec,
+             0,
+             "With the worker threads, the predictions of a source which "
+             "doesn't finish within this time from the start of the "
+             "aggregation are dropped. 0 waits for all the sources.");
+
 DECLARE_bool(enable_typing_correction);
 
 namespace mozc {
@@ -158,13 +182,40 @@ bool IsMixedConversionEnabled(const commands::Request& request) {
   return request.mixed_conversion() || FLAGS_enable_mixed_conversion;
 }
 
-bool IsTypingCorrectionEnabled() {
-  return GET_CONFIG(use_typing_correction) ||
+bool IsTypingCorrectionEnabled(const ConversionRequest &request) {
+  return request.config().use_typing_correction() ||
          FLAGS_enable_typing_correction;
 }
 
+// Copies |request| to |output| disabling kana modifier insensitive lookup,
+// for the lookups which need the exact key.
+void CopyRequestForExactKeyLookup(const ConversionRequest &request,
+                                  ConversionRequest *output) {
+  output->CopyFrom(request);
+  output->set_kana_modifier_insensitive_conversion(false);
+}
+
+// Looks up the unigram candidates of |key|. With the top-k lookup, the
+// dictionary stops after the |limit| best tokens instead of stopping at the
+// |limit|-th token of the shortest keys.
+void LookupPredictiveForUnigram(const DictionaryInterface &dictionary,
+                                const string &key,
+                                const ConversionRequest &request,
+                                size_t limit,
+                                DictionaryInterface::Callback *callback) {
+  if (FLAGS_enable_top_k_predictive_lookup) {
+    dictionary.LookupPredictiveTopK(key, request, limit, callback);
+  } else {
+    dictionary.LookupPredictive(key, request, callback);
+  }
+}
+
 }  // namespace
 
+// Appends the looked up tokens to |results| until |limit| results are
+// appended. The results already in |results| don't count toward |limit|, so
+// the limit of a prediction source doesn't depend on the sources aggregated
+// before it, and the sources can be aggregated in parallel.
 class DictionaryPredictor::PredictiveLookupCallback :
       public mozc::DictionaryInterface::Callback {
  public:
@@ -174,7 +225,8 @@ class DictionaryPredictor::PredictiveLookupCallback :
                            vector<DictionaryPredictor::Result> *results)
       : penalty_(0), types_(types), limit_(limit),
         original_key_len_(original_key_len),
-        subsequent_chars_(subsequent_chars), results_(results) {}
+        subsequent_chars_(subsequent_chars), results_(results),
+        initial_results_size_(results->size()) {}
 
   virtual ResultType OnKey(StringPiece key) {
     if (subsequent_chars_ == NULL) {
@@ -214,7 +266,7 @@ class DictionaryPredictor::PredictiveLookupCallback :
     results_->push_back(Result());
     results_->back().InitializeByTokenAndTypes(token, types_);
     results_->back().wcost += penalty_;
-    if (results_->size() < limit_) {
+    if (results_->size() - initial_results_size_ < limit_) {
       return TRAVERSE_CONTINUE;
     } else {
       return TRAVERSE_DONE;
@@ -228,6 +280,7 @@ class DictionaryPredictor::PredictiveLookupCallback :
   const size_t original_key_len_;
   const set<string> *subsequent_chars_;
   vector<DictionaryPredictor::Result> *results_;
+  const size_t initial_results_size_;
 
   DISALLOW_COPY_AND_ASSIGN(PredictiveLookupCallback);
 };
@@ -261,6 +314,49 @@ class DictionaryPredictor::PredictiveBigramLookupCallback :
   DISALLOW_COPY_AND_ASSIGN(PredictiveBigramLookupCallback);
 };
 
+// Looks up one of the type corrected queries which are looked up at once.
+// The results of the queries are merged in the order of the queries within
+// |limit|, so the callback of the |query_index|-th query stops once the
+// results of the queries up to it reach |limit|. The results of the
+// preceding queries only grow, so the tokens after that are never used.
+class DictionaryPredictor::TypeCorrectedLookupCallback :
+      public PredictiveLookupCallback {
+ public:
+  TypeCorrectedLookupCallback(
+      DictionaryPredictor::PredictionTypes types,
+      size_t limit, size_t original_key_len,
+      const set<string> *subsequent_chars,
+      size_t query_index,
+      vector<vector<DictionaryPredictor::Result> > *query_results)
+      : PredictiveLookupCallback(types, limit, original_key_len,
+                                 subsequent_chars,
+                                 &(*query_results)[query_index]),
+        total_limit_(limit),
+        query_index_(query_index),
+        query_results_(query_results) {}
+
+  virtual ResultType OnToken(StringPiece key, StringPiece actual_key,
+                             const Token &token) {
+    const ResultType result =
+        PredictiveLookupCallback::OnToken(key, actual_key, token);
+    if (result != TRAVERSE_CONTINUE) {
+      return result;
+    }
+    size_t size = 0;
+    for (size_t i = 0; i <= query_index_; ++i) {
+      size += (*query_results_)[i].size();
+    }
+    return (size < total_limit_) ? TRAVERSE_CONTINUE : TRAVERSE_DONE;
+  }
+
+ private:
+  const size_t total_limit_;
+  const size_t query_index_;
+  const vector<vector<DictionaryPredictor::Result> > *query_results_;
+
+  DISALLOW_COPY_AND_ASSIGN(TypeCorrectedLookupCallback);
+};
+
 // Comparator for sorting prediction candidates.
 // If we have words A and AB, for example "六本木" and "六本木ヒルズ",
 // assume that cost(A) < cost(AB).
@@ -301,7 +397,11 @@ DictionaryPredictor::DictionaryPredictor(
       counter_suffix_word_id_(pos_matcher->GetCounterSuffixWordId()),
       predictor_name_("DictionaryPredictor") {}
 
-DictionaryPredictor::~DictionaryPredictor() {}
+DictionaryPredictor::~DictionaryPredictor() {
+  // The sources dropped by the deadline may still use this predictor on the
+  // workers. Deleting the pool waits for them.
+  worker_pool_.reset();
+}
 
 bool DictionaryPredictor::PredictForRequest(const ConversionRequest &request,
                                             Segments *segments) const {
@@ -340,6 +440,9 @@ bool DictionaryPredictor::AggregatePrediction(
     // exactly matches the query.
     // Therefore, we use only the realtime conversion result.
     AggregateRealtimeConversion(prediction_types, request, segments, results);
+  } else if (FLAGS_dictionary_predictor_worker_threads > 0) {
+    AggregatePredictionInParallel(prediction_types, request, segments,
+                                  results);
   } else {
     AggregateRealtimeConversion(prediction_types, request, segments, results);
     AggregateUnigramPrediction(prediction_types, request, *segments, results);
@@ -358,6 +461,314 @@ bool DictionaryPredictor::AggregatePrediction(
   }
 }
 
+// A set of the prediction sources aggregated on the worker threads. The job
+// owns the copies of its inputs and the results of each source, and is
+// reference counted by the caller and the worker pool, so that the workers
+// can finish the sources dropped by the deadline after the caller returns.
+class DictionaryPredictor::AggregationJob {
+ public:
+  AggregationJob(const DictionaryPredictor *predictor,
+                 PredictionTypes types,
+                 const ConversionRequest &request,
+                 const Segments &segments,
+                 const vector<PredictionType> &sources)
+      : predictor_(predictor),
+        types_(types),
+        sources_(sources),
+        results_(sources.size()),
+        finished_(sources.size(), false),
+        next_source_index_(0),
+        num_finished_(0),
+        ref_count_(1) {
+    request_.CopyFrom(request.request());
+    conversion_request_.CopyFrom(request);
+    conversion_request_.set_request(&request_);
+    if (request.has_composer()) {
+      composer_.reset(new composer::Composer(NULL, &request_));
+      composer_->CopyFrom(request.composer());
+      composer_->SetRequest(&request_);
+      conversion_request_.set_composer(composer_.get());
+    }
+    segments_.CopyFrom(segments);
+  }
+
+  void AddRef() {
+    scoped_lock l(&mutex_);
+    ++ref_count_;
+  }
+
+  void Release() {
+    bool is_last = false;
+    {
+      scoped_lock l(&mutex_);
+      is_last = (--ref_count_ == 0);
+    }
+    if (is_last) {
+      delete this;
+    }
+  }
+
+  // Aggregates the sources not started yet, one by one. Called on the
+  // worker threads. Returns immediately once the results are taken by
+  // AppendResults(), so a stale job left in the queue costs nothing.
+  void Run() {
+    while (true) {
+      size_t index = 0;
+      {
+        scoped_lock l(&mutex_);
+        if (next_source_index_ >= sources_.size()) {
+          return;
+        }
+        index = next_source_index_++;
+      }
+      vector<Result> results;
+      predictor_->AggregatePredictionOfType(
+          sources_[index], types_, conversion_request_, segments_, &results);
+      scoped_lock l(&mutex_);
+      results_[index].swap(results);
+      finished_[index] = true;
+      if (++num_finished_ == sources_.size()) {
+        all_finished_.Notify();
+      }
+    }
+  }
+
+  // Waits until all the sources finish, or at most |timeout_msec| if it is
+  // not negative, and appends the results of the finished sources in the
+  // order of |sources_|. The other sources are dropped.
+  void AppendResults(int timeout_msec, vector<Result> *results) {
+    all_finished_.Wait(timeout_msec);
+    scoped_lock l(&mutex_);
+    // The sources not started yet are no longer needed.
+    next_source_index_ = sources_.size();
+    for (size_t i = 0; i < sources_.size(); ++i) {
+      if (!finished_[i]) {
+        VLOG(1) << "Dropped the prediction source " << sources_[i]
+                << " by the deadline";
+        continue;
+      }
+      results->insert(results->end(), results_[i].begin(), results_[i].end());
+    }
+  }
+
+ private:
+  ~AggregationJob() {}
+
+  const DictionaryPredictor *predictor_;
+  const PredictionTypes types_;
+  const vector<PredictionType> sources_;
+
+  // Copies of the inputs.
+  commands::Request request_;
+  scoped_ptr<composer::Composer> composer_;
+  ConversionRequest conversion_request_;
+  Segments segments_;
+
+  // The members below are guarded by |mutex_|.
+  Mutex mutex_;
+  vector<vector<Result> > results_;
+  vector<bool> finished_;
+  size_t next_source_index_;
+  size_t num_finished_;
+  int ref_count_;
+  UnnamedEvent all_finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(AggregationJob);
+};
+
+// Long-lived worker threads which run the AggregationJobs posted to the
+// queue. A job posted n times is run by up to n workers at the same time.
+// The queued jobs whose results are already taken are skipped.
+class DictionaryPredictor::AggregationWorkerPool {
+ public:
+  explicit AggregationWorkerPool(size_t num_workers) : stopped_(false) {
+    for (size_t i = 0; i < num_workers; ++i) {
+      Worker *worker = new Worker(this);
+      worker->SetJoinable(true);
+      worker->Start();
+      if (!worker->IsRunning()) {
+        LOG(ERROR) << "Failed to start an aggregation worker";
+        delete worker;
+        continue;
+      }
+      workers_.push_back(worker);
+    }
+  }
+
+  // Waits for the jobs running on the workers. The jobs still in the queue
+  // are released without being run.
+  ~AggregationWorkerPool() {
+    {
+      scoped_lock l(&mutex_);
+      stopped_ = true;
+    }
+    job_posted_.Notify();
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      workers_[i]->Join();
+      delete workers_[i];
+    }
+    for (size_t i = 0; i < jobs_.size(); ++i) {
+      jobs_[i]->Release();
+    }
+  }
+
+  size_t num_workers() const {
+    return workers_.size();
+  }
+
+  // Posts |job| |count| times. The pool holds a reference per post.
+  void Post(AggregationJob *job, size_t count) {
+    {
+      scoped_lock l(&mutex_);
+      for (size_t i = 0; i < count; ++i) {
+        job->AddRef();
+        jobs_.push_back(job);
+      }
+    }
+    job_posted_.Notify();
+  }
+
+ private:
+  class Worker : public Thread {
+   public:
+    explicit Worker(AggregationWorkerPool *pool) : pool_(pool) {}
+    virtual ~Worker() {}
+
+    virtual void Run() {
+      pool_->RunWorker();
+    }
+
+   private:
+    AggregationWorkerPool *pool_;
+
+    DISALLOW_COPY_AND_ASSIGN(Worker);
+  };
+
+  void RunWorker() {
+    while (true) {
+      AggregationJob *job = NULL;
+      bool has_more_jobs = false;
+      {
+        scoped_lock l(&mutex_);
+        if (stopped_) {
+          break;
+        }
+        if (!jobs_.empty()) {
+          job = jobs_.front();
+          jobs_.pop_front();
+          has_more_jobs = !jobs_.empty();
+        }
+      }
+      if (job == NULL) {
+        job_posted_.Wait(-1);
+        continue;
+      }
+      // |job_posted_| wakes up one worker per notification, so passes the
+      // rest of the queue to another worker.
+      if (has_more_jobs) {
+        job_posted_.Notify();
+      }
+      job->Run();
+      job->Release();
+    }
+    // Lets the next worker know that the pool is stopped.
+    job_posted_.Notify();
+  }
+
+  vector<Worker *> workers_;
+  UnnamedEvent job_posted_;
+
+  // The members below are guarded by |mutex_|.
+  Mutex mutex_;
+  deque<AggregationJob *> jobs_;
+  bool stopped_;
+
+  DISALLOW_COPY_AND_ASSIGN(AggregationWorkerPool);
+};
+
+DictionaryPredictor::AggregationWorkerPool *
+DictionaryPredictor::GetWorkerPool() const {
+  scoped_lock l(&worker_pool_mutex_);
+  if (worker_pool_.get() == NULL) {
+    worker_pool_.reset(new AggregationWorkerPool(
+        static_cast<size_t>(FLAGS_dictionary_predictor_worker_threads)));
+  }
+  return worker_pool_.get();
+}
+
+void DictionaryPredictor::AggregatePredictionInParallel(
+    PredictionTypes types,
+    const ConversionRequest &request,
+    Segments *segments,
+    vector<Result> *results) const {
+  Stopwatch stopwatch = Stopwatch::StartNew();
+
+  // The sources in the order of the sequential aggregation.
+  const PredictionType kSources[] = {
+    UNIGRAM, BIGRAM, SUFFIX, ENGLISH, TYPING_CORRECTION,
+  };
+  vector<PredictionType> sources;
+  for (size_t i = 0; i < arraysize(kSources); ++i) {
+    if (types & kSources[i]) {
+      sources.push_back(kSources[i]);
+    }
+  }
+  if (sources.empty()) {
+    AggregateRealtimeConversion(types, request, segments, results);
+    return;
+  }
+
+  // The job copies |segments| before the realtime conversion, which
+  // temporarily modifies them.
+  AggregationJob *job =
+      new AggregationJob(this, types, request, *segments, sources);
+  AggregationWorkerPool *worker_pool = GetWorkerPool();
+  worker_pool->Post(job, min(worker_pool->num_workers(), sources.size()));
+
+  AggregateRealtimeConversion(types, request, segments, results);
+
+  if (worker_pool->num_workers() == 0) {
+    job->Run();
+  }
+  int timeout_msec = -1;
+  if (FLAGS_dictionary_predictor_source_deadline_msec > 0) {
+    timeout_msec = max(
+        0,
+        static_cast<int>(FLAGS_dictionary_predictor_source_deadline_msec -
+                         stopwatch.GetElapsedMilliseconds()));
+  }
+  job->AppendResults(timeout_msec, results);
+  job->Release();
+}
+
+void DictionaryPredictor::AggregatePredictionOfType(
+    PredictionType source,
+    PredictionTypes types,
+    const ConversionRequest &request,
+    const Segments &segments,
+    vector<Result> *results) const {
+  switch (source) {
+    case UNIGRAM:
+      AggregateUnigramPrediction(types, request, segments, results);
+      break;
+    case BIGRAM:
+      AggregateBigramPrediction(types, request, segments, results);
+      break;
+    case SUFFIX:
+      AggregateSuffixPrediction(types, request, segments, results);
+      break;
+    case ENGLISH:
+      AggregateEnglishPrediction(types, request, segments, results);
+      break;
+    case TYPING_CORRECTION:
+      AggregateTypeCorrectingPrediction(types, request, segments, results);
+      break;
+    default:
+      LOG(DFATAL) << "Unexpected prediction source: " << source;
+      break;
+  }
+}
+
 void DictionaryPredictor::SetCost(const ConversionRequest &request,
                                   const Segments &segments,
                                   vector<Result> *results) const {
@@ -1084,6 +1495,7 @@ void DictionaryPredictor::AggregateRealtimeConversion(
   if (!(types & REALTIME)) {
     return;
   }
+  MOZC_TRACE_SCOPE(Trace::DICTIONARY_PREDICTOR_AGGREGATE_REALTIME_CONVERSION);
 
   DCHECK(converter_);
   DCHECK(immutable_converter_);
@@ -1182,6 +1594,7 @@ void DictionaryPredictor::AggregateUnigramPrediction(
   if (!(types & UNIGRAM)) {
     return;
   }
+  MOZC_TRACE_SCOPE(Trace::DICTIONARY_PREDICTOR_AGGREGATE_UNIGRAM);
 
   DCHECK(results);
   DCHECK(segments.request_type() == Segments::PREDICTION ||
@@ -1294,6 +1707,7 @@ void DictionaryPredictor::AggregateBigramPrediction(
   if (!(types & BIGRAM)) {
     return;
   }
+  MOZC_TRACE_SCOPE(Trace::DICTIONARY_PREDICTOR_AGGREGATE_BIGRAM);
 
   DCHECK(results);
   DCHECK(dictionary_);
@@ -1315,8 +1729,11 @@ void DictionaryPredictor::AddBigramResultsFromHistory(
     const Segments &segments,
     vector<Result> *results) const {
   // Check that history_key/history_value are in the dictionary.
+  ConversionRequest exact_key_request;
+  CopyRequestForExactKeyLookup(request, &exact_key_request);
   FindValueCallback find_history_callback(history_value);
-  dictionary_->LookupPrefix(history_key, false, &find_history_callback);
+  dictionary_->LookupPrefix(history_key, exact_key_request,
+                            &find_history_callback);
 
   // History value is not found in the dictionary.
   // User may create this the history candidate from T13N or segment
@@ -1353,7 +1770,7 @@ void DictionaryPredictor::AddBigramResultsFromHistory(
                                           history_value_size - 1, 1));
   for (size_t i = prev_results_size; i < results->size(); ++i) {
     CheckBigramResult(find_history_callback.token(), history_ctype,
-                      last_history_ctype, &(*results)[i]);
+                      last_history_ctype, exact_key_request, &(*results)[i]);
   }
 }
 
@@ -1363,6 +1780,7 @@ void DictionaryPredictor::CheckBigramResult(
     const Token &history_token,
     const Util::ScriptType history_ctype,
     const Util::ScriptType last_history_ctype,
+    const ConversionRequest &request,
     Result *result) const {
   DCHECK(result);
 
@@ -1424,7 +1842,7 @@ void DictionaryPredictor::CheckBigramResult(
   }
 
   FindValueCallback callback(value);
-  dictionary_->LookupPrefix(key, false, &callback);
+  dictionary_->LookupPrefix(key, request, &callback);
   if (!callback.found()) {
     result->types = NO_PREDICTION;
     return;
@@ -1444,7 +1862,10 @@ void DictionaryPredictor::GetPredictiveResults(
     const string input_key = history_key + segments.conversion_segment(0).key();
     PredictiveLookupCallback callback(types, lookup_limit, input_key.size(),
                                       NULL, results);
-    dictionary.LookupPredictive(input_key, false, &callback);
+    ConversionRequest exact_key_request;
+    CopyRequestForExactKeyLookup(request, &exact_key_request);
+    LookupPredictiveForUnigram(dictionary, input_key, exact_key_request,
+                               lookup_limit, &callback);
     return;
   }
 
@@ -1460,8 +1881,8 @@ void DictionaryPredictor::GetPredictiveResults(
   PredictiveLookupCallback callback(
       types, lookup_limit, input_key.size(),
       expanded.empty() ? NULL : &expanded, results);
-  dictionary.LookupPredictive(
-      input_key, request.IsKanaModifierInsensitiveConversion(), &callback);
+  LookupPredictiveForUnigram(dictionary, input_key, request, lookup_limit,
+                             &callback);
 }
 
 void DictionaryPredictor::GetPredictiveResultsForBigram(
@@ -1478,7 +1899,9 @@ void DictionaryPredictor::GetPredictiveResultsForBigram(
     const string input_key = history_key + segments.conversion_segment(0).key();
     PredictiveBigramLookupCallback callback(
         types, lookup_limit, input_key.size(), NULL, history_value, results);
-    dictionary.LookupPredictive(input_key, false, &callback);
+    ConversionRequest exact_key_request;
+    CopyRequestForExactKeyLookup(request, &exact_key_request);
+    dictionary.LookupPredictive(input_key, exact_key_request, &callback);
     return;
   }
 
@@ -1494,8 +1917,7 @@ void DictionaryPredictor::GetPredictiveResultsForBigram(
   PredictiveBigramLookupCallback callback(types, lookup_limit, input_key.size(),
                                           expanded.empty() ? NULL : &expanded,
                                           history_value, results);
-  dictionary.LookupPredictive(
-      input_key, request.IsKanaModifierInsensitiveConversion(), &callback);
+  dictionary.LookupPredictive(input_key, request, &callback);
 }
 
 void DictionaryPredictor::GetPredictiveResultsForEnglish(
@@ -1518,6 +1940,8 @@ void DictionaryPredictor::GetPredictiveResultsForEnglish(
   if (input_key.size() < 2) {
     return;
   }
+  ConversionRequest exact_key_request;
+  CopyRequestForExactKeyLookup(request, &exact_key_request);
   const size_t prev_results_size = results->size();
   if (Util::IsUpperAscii(input_key)) {
     // For upper case key, look up its lower case version and then transform the
@@ -1526,7 +1950,7 @@ void DictionaryPredictor::GetPredictiveResultsForEnglish(
     Util::LowerString(&key);
     PredictiveLookupCallback callback(types, lookup_limit, key.size(), NULL,
                                       results);
-    dictionary.LookupPredictive(key, false, &callback);
+    dictionary.LookupPredictive(key, exact_key_request, &callback);
     for (size_t i = prev_results_size; i < results->size(); ++i) {
       Util::UpperString(&results->at(i).value);
     }
@@ -1537,7 +1961,7 @@ void DictionaryPredictor::GetPredictiveResultsForEnglish(
     Util::LowerString(&key);
     PredictiveLookupCallback callback(types, lookup_limit, key.size(), NULL,
                                       results);
-    dictionary.LookupPredictive(key, false, &callback);
+    dictionary.LookupPredictive(key, exact_key_request, &callback);
     for (size_t i = prev_results_size; i < results->size(); ++i) {
       Util::CapitalizeString(&results->at(i).value);
     }
@@ -1545,7 +1969,7 @@ void DictionaryPredictor::GetPredictiveResultsForEnglish(
     // For other cases (lower and as-is), just look up directly.
     PredictiveLookupCallback callback(types, lookup_limit, input_key.size(),
                                       NULL, results);
-    dictionary.LookupPredictive(input_key, false, &callback);
+    dictionary.LookupPredictive(input_key, exact_key_request, &callback);
   }
   // If input mode is FULL_ASCII, then convert the results to full-width.
   if (request.composer().GetInputMode() == transliteration::FULL_ASCII) {
@@ -1571,21 +1995,37 @@ void DictionaryPredictor::GetPredictiveResultsUsingTypingCorrection(
 
   vector<composer::TypeCorrectedQuery> queries;
   request.composer().GetTypeCorrectedQueriesForPrediction(&queries);
+  if (queries.empty()) {
+    return;
+  }
+
+  // The corrected queries usually share long prefixes, so look them up at
+  // once to let the dictionary share the traversal. Each query gets its own
+  // result list, and the results are merged in the order of the queries
+  // within |lookup_limit| as if the queries were looked up one by one, each
+  // with the limit left by the preceding queries.
+  vector<string> input_keys(queries.size());
+  vector<vector<Result> > query_results(queries.size());
+  vector<DictionaryInterface::Callback *> callbacks(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    const composer::TypeCorrectedQuery &query = queries[i];
+    input_keys[i] = history_key + query.base;
+    callbacks[i] = new TypeCorrectedLookupCallback(
+        types, lookup_limit, input_keys[i].size(),
+        query.expanded.empty() ? NULL : &query.expanded, i, &query_results);
+  }
+  dictionary.LookupPredictiveForKeys(input_keys, request, callbacks);
+  STLDeleteElements(&callbacks);
+
   for (size_t query_index = 0; query_index < queries.size(); ++query_index) {
-    const composer::TypeCorrectedQuery &query = queries[query_index];
-    const string input_key = history_key + query.base;
-    const size_t previous_results_size = results->size();
-    PredictiveLookupCallback callback(
-        types, lookup_limit, input_key.size(),
-        query.expanded.empty() ? NULL : &query.expanded, results);
-    dictionary.LookupPredictive(
-        input_key, request.IsKanaModifierInsensitiveConversion(), &callback);
-
-    for (size_t i = previous_results_size; i < results->size(); ++i) {
-      results->at(i).wcost += query.cost;
+    const vector<Result> &query_result = query_results[query_index];
+    const size_t size = min(query_result.size(), lookup_limit);
+    for (size_t i = 0; i < size; ++i) {
+      results->push_back(query_result[i]);
+      results->back().wcost += queries[query_index].cost;
     }
-    lookup_limit -= results->size() - previous_results_size;
-    if (lookup_limit <= 0) {
+    lookup_limit -= size;
+    if (lookup_limit == 0) {
       break;
     }
   }
@@ -1599,6 +2039,7 @@ void DictionaryPredictor::AggregateSuffixPrediction(
   if (!(types & SUFFIX)) {
     return;
   }
+  MOZC_TRACE_SCOPE(Trace::DICTIONARY_PREDICTOR_AGGREGATE_SUFFIX);
 
   DCHECK_GT(segments.conversion_segments_size(), 0);
 
@@ -1648,6 +2089,7 @@ void DictionaryPredictor::AggregateEnglishPrediction(
   if (!(types & ENGLISH)) {
     return;
   }
+  MOZC_TRACE_SCOPE(Trace::DICTIONARY_PREDICTOR_AGGREGATE_ENGLISH);
   DCHECK(results);
   DCHECK(dictionary_);
 
@@ -1675,6 +2117,7 @@ void DictionaryPredictor::AggregateTypeCorrectingPrediction(
   if (!(types & TYPING_CORRECTION)) {
     return;
   }
+  MOZC_TRACE_SCOPE(Trace::DICTIONARY_PREDICTOR_AGGREGATE_TYPE_CORRECTING);
   DCHECK(results);
   DCHECK(dictionary_);
 
@@ -1717,7 +2160,7 @@ DictionaryPredictor::PredictionTypes DictionaryPredictor::GetPredictionTypes(
 
   const bool zero_query_suggestion = request.request().zero_query_suggestion();
   if (IsLatinInputMode(request) && !zero_query_suggestion) {
-    if (GET_CONFIG(use_dictionary_suggest)) {
+    if (request.config().use_dictionary_suggest()) {
       // By following the dictionary_suggest config, enable English prediction.
       result |= ENGLISH;
     }
@@ -1727,7 +2170,7 @@ DictionaryPredictor::PredictionTypes DictionaryPredictor::GetPredictionTypes(
     return result;
   }
 
-  if (!GET_CONFIG(use_dictionary_suggest) &&
+  if (!request.config().use_dictionary_suggest() &&
       segments.request_type() == Segments::SUGGESTION) {
     VLOG(2) << "no_dictionary_suggest";
     return result;
@@ -1777,7 +2220,7 @@ DictionaryPredictor::PredictionTypes DictionaryPredictor::GetPredictionTypes(
     result |= SUFFIX;
   }
 
-  if (IsTypingCorrectionEnabled() && key_len >= 3) {
+  if (IsTypingCorrectionEnabled(request) && key_len >= 3) {
     result |= TYPING_CORRECTION;
   }
 
@@ -1796,7 +2239,7 @@ bool DictionaryPredictor::ShouldRealTimeConversionEnabled(
   }
 
   return (segments.request_type() == Segments::PARTIAL_SUGGESTION ||
-          GET_CONFIG(use_realtime_conversion) ||
+          request.config().use_realtime_conversion() ||
           IsMixedConversionEnabled(request.request()));
 }
 
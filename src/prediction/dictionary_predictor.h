@@ -34,6 +34,8 @@
 #include <string>
 #include <vector>
 
+#include "base/mutex.h"
+#include "base/scoped_ptr.h"
 #include "base/util.h"
 #include "dictionary/dictionary_token.h"
 #include "prediction/predictor_interface.h"
@@ -143,8 +145,11 @@ class DictionaryPredictor : public PredictorInterface {
 
   class PredictiveLookupCallback;
   class PredictiveBigramLookupCallback;
+  class TypeCorrectedLookupCallback;
   class ResultWCostLess;
   class ResultCostLess;
+  class AggregationJob;
+  class AggregationWorkerPool;
 
   void AggregateRealtimeConversion(PredictionTypes types,
                                    const ConversionRequest &request,
@@ -211,12 +216,39 @@ class DictionaryPredictor : public PredictorInterface {
   FRIEND_TEST(DictionaryPredictorTest, SetLMCost);
   FRIEND_TEST(DictionaryPredictorTest, SetDescription);
   FRIEND_TEST(DictionaryPredictorTest, SetDebugDescription);
+  FRIEND_TEST(DictionaryPredictorTest, ReuseAggregationWorkers);
+  FRIEND_TEST(DictionaryPredictorTest, LookupLimitCountsOnlyOwnResults);
+  FRIEND_TEST(DictionaryPredictorTest,
+              AggregatePredictionInParallelReachingCutoff);
 
   // Returns false if no results were aggregated.
   bool AggregatePrediction(const ConversionRequest &request,
                            Segments *segments,
                            vector<Result> *results) const;
 
+  // Same as the aggregation in AggregatePrediction(), but aggregates the
+  // sources other than the realtime conversion on worker threads. The results
+  // are merged in the same order as the sequential aggregation, and the
+  // sources not finished by the deadline are dropped.
+  // See FLAGS_dictionary_predictor_worker_threads.
+  void AggregatePredictionInParallel(PredictionTypes types,
+                                     const ConversionRequest &request,
+                                     Segments *segments,
+                                     vector<Result> *results) const;
+
+  // Returns the worker pool of AggregatePredictionInParallel(). The pool is
+  // created on the first call with FLAGS_dictionary_predictor_worker_threads
+  // workers.
+  AggregationWorkerPool *GetWorkerPool() const;
+
+  // Calls the aggregation of |source|, one of UNIGRAM, BIGRAM, SUFFIX,
+  // ENGLISH and TYPING_CORRECTION.
+  void AggregatePredictionOfType(PredictionType source,
+                                 PredictionTypes types,
+                                 const ConversionRequest &request,
+                                 const Segments &segments,
+                                 vector<Result> *results) const;
+
   void SetCost(const ConversionRequest &request,
                const Segments &segments, vector<Result> *results) const;
 
@@ -236,6 +268,7 @@ class DictionaryPredictor : public PredictorInterface {
   void CheckBigramResult(const Token &history_token,
                          const Util::ScriptType history_ctype,
                          const Util::ScriptType last_history_ctype,
+                         const ConversionRequest &request,
                          Result *result) const;
 
   void GetPredictiveResults(const DictionaryInterface &dictionary,
@@ -422,6 +455,12 @@ class DictionaryPredictor : public PredictorInterface {
   const uint16 counter_suffix_word_id_;
   const string predictor_name_;
 
+  // Worker threads of AggregatePredictionInParallel(), created on the first
+  // call. They may still run the sources dropped by the deadline, so the
+  // destructor stops and joins them.
+  mutable Mutex worker_pool_mutex_;
+  mutable scoped_ptr<AggregationWorkerPool> worker_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(DictionaryPredictor);
 };
 }  // namespace mozc
@@ -37,6 +37,7 @@
 
 #include "base/flags.h"
 #include "base/logging.h"
+#include "base/number_util.h"
 #include "base/port.h"
 #include "base/system_util.h"
 #include "base/util.h"
@@ -78,6 +79,8 @@ using ::testing::_;
 
 DECLARE_string(test_tmpdir);
 DECLARE_bool(enable_expansion_for_dictionary_predictor);
+DECLARE_int32(dictionary_predictor_worker_threads);
+DECLARE_int32(dictionary_predictor_source_deadline_msec);
 
 namespace mozc {
 namespace {
@@ -287,19 +290,27 @@ class CallCheckDictionary : public DictionaryInterface {
                      bool(StringPiece));
   MOCK_CONST_METHOD3(LookupPredictive,
                      void(StringPiece key,
-                          bool use_kana_modifier_insensitive_lookup,
+                          const ConversionRequest &conversion_request,
                           Callback *callback));
   MOCK_CONST_METHOD3(LookupPrefix,
                      void(StringPiece key,
-                          bool use_kana_modifier_insensitive_lookup,
+                          const ConversionRequest &conversion_request,
                           Callback *callback));
-  MOCK_CONST_METHOD2(LookupExact,
-                     void(StringPiece key, Callback *callback));
-  MOCK_CONST_METHOD3(LookupReverse,
+  MOCK_CONST_METHOD3(LookupExact,
+                     void(StringPiece key,
+                          const ConversionRequest &conversion_request,
+                          Callback *callback));
+  MOCK_CONST_METHOD4(LookupReverse,
                      void(StringPiece str, NodeAllocatorInterface *allocator,
+                          const ConversionRequest &conversion_request,
                           Callback *callback));
 };
 
+// Matches a ConversionRequest by its kana modifier insensitive lookup setting.
+MATCHER_P(KanaModifierInsensitiveConversionIs, enabled, "") {
+  return arg.IsKanaModifierInsensitiveConversion() == enabled;
+}
+
 // Action to call the third argument of LookupPrefix with the token
 // <key, value>.
 ACTION_P4(LookupPrefixOneToken, key, value, lid, rid) {
@@ -578,6 +589,10 @@ class DictionaryPredictorTest : public ::testing::Test {
     }
   }
 
+  static void SetMockTypingModel(composer::Table *table) {
+    table->typing_model_ = Singleton<MockTypingModel>::get();
+  }
+
   void ExpansionForUnigramTestHelper(bool use_expansion) {
     config::Config config;
     config.set_use_dictionary_suggest(true);
@@ -609,7 +624,8 @@ class DictionaryPredictorTest : public ::testing::Test {
       composer.GetQueryForPrediction(&query);
       segment->set_key(query);
 
-      EXPECT_CALL(*check_dictionary, LookupPredictive(_, use_expansion, _));
+      EXPECT_CALL(*check_dictionary, LookupPredictive(
+          _, KanaModifierInsensitiveConversionIs(use_expansion), _));
 
       vector<TestableDictionaryPredictor::Result> results;
       predictor->AggregateUnigramPrediction(
@@ -674,7 +690,8 @@ class DictionaryPredictorTest : public ::testing::Test {
               // "グーグル"
               "\xe3\x82\xb0\xe3\x83\xbc\xe3\x82\xb0\xe3\x83\xab",
               1, 1));
-      EXPECT_CALL(*check_dictionary, LookupPredictive(_, use_expansion, _));
+      EXPECT_CALL(*check_dictionary, LookupPredictive(
+          _, KanaModifierInsensitiveConversionIs(use_expansion), _));
 
       vector<TestableDictionaryPredictor::Result> results;
       predictor->AggregateBigramPrediction(
@@ -715,7 +732,8 @@ class DictionaryPredictorTest : public ::testing::Test {
       composer.GetQueryForPrediction(&query);
       segment->set_key(query);
 
-      EXPECT_CALL(*check_dictionary, LookupPredictive(_, use_expansion, _));
+      EXPECT_CALL(*check_dictionary, LookupPredictive(
+          _, KanaModifierInsensitiveConversionIs(use_expansion), _));
 
       vector<TestableDictionaryPredictor::Result> results;
       predictor->AggregateSuffixPrediction(
@@ -793,7 +811,11 @@ class DictionaryPredictorTest : public ::testing::Test {
     return default_composer_;
   }
 
-  const ConversionRequest &default_conversion_request() const {
+  // Returns the request with the snapshot of the current config, which the
+  // tests update with ConfigHandler::SetConfig().
+  const ConversionRequest &default_conversion_request() {
+    default_conversion_request_.set_config(
+        config::ConfigHandler::GetConfigSnapshot());
     return default_conversion_request_;
   }
 
@@ -842,7 +864,7 @@ class DictionaryPredictorTest : public ::testing::Test {
   config::Config config_backup_;
   const commands::Request default_request_;
   const composer::Composer default_composer_;
-  const ConversionRequest default_conversion_request_;
+  ConversionRequest default_conversion_request_;
   const bool default_expansion_flag_;
   scoped_ptr<ImmutableConverterInterface> immutable_converter_;
 };
@@ -1007,7 +1029,7 @@ TEST_F(DictionaryPredictorTest, GetPredictionTypes) {
   config::ConfigHandler::SetConfig(config);
 
   composer::Composer composer(NULL, &default_request());
-  const ConversionRequest conversion_request(&composer, &default_request());
+  ConversionRequest conversion_request(&composer, &default_request());
 
   // empty segments
   {
@@ -1113,6 +1135,7 @@ TEST_F(DictionaryPredictorTest, GetPredictionTypes) {
     const bool orig_use_dictionary_suggest = config.use_dictionary_suggest();
     config.set_use_dictionary_suggest(true);
     config::ConfigHandler::SetConfig(config);
+    conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     MakeSegmentsForSuggestion("hel", &segments);
 
@@ -1130,6 +1153,7 @@ TEST_F(DictionaryPredictorTest, GetPredictionTypes) {
     // disabled.
     config.set_use_dictionary_suggest(false);
     config::ConfigHandler::SetConfig(config);
+    conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     composer.SetInputMode(transliteration::HALF_ASCII);
     EXPECT_EQ(
@@ -1143,6 +1167,7 @@ TEST_F(DictionaryPredictorTest, GetPredictionTypes) {
 
     config.set_use_dictionary_suggest(true);
     config::ConfigHandler::SetConfig(config);
+    conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     segments.set_request_type(Segments::PARTIAL_SUGGESTION);
     composer.SetInputMode(transliteration::HALF_ASCII);
@@ -1157,6 +1182,7 @@ TEST_F(DictionaryPredictorTest, GetPredictionTypes) {
 
     config.set_use_dictionary_suggest(false);
     config::ConfigHandler::SetConfig(config);
+    conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     composer.SetInputMode(transliteration::HALF_ASCII);
     EXPECT_EQ(
@@ -1170,6 +1196,7 @@ TEST_F(DictionaryPredictorTest, GetPredictionTypes) {
 
     config.set_use_dictionary_suggest(orig_use_dictionary_suggest);
     config::ConfigHandler::SetConfig(config);
+    conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
   }
 }
 
@@ -1360,6 +1387,261 @@ TEST_F(DictionaryPredictorTest, AggregateUnigramPrediction) {
   EXPECT_EQ(1, segments.conversion_segments_size());
 }
 
+TEST_F(DictionaryPredictorTest, AggregatePredictionInParallel) {
+  config::Config config;
+  config.set_use_dictionary_suggest(true);
+  config.set_use_realtime_conversion(true);
+  config::ConfigHandler::SetConfig(config);
+
+  scoped_ptr<MockDataAndPredictor> data_and_predictor(
+      CreateDictionaryPredictorWithMockData());
+  const DictionaryPredictor *predictor =
+      data_and_predictor->dictionary_predictor();
+
+  // "ぐーぐるあ" after the history "グーグル".
+  Segments segments;
+  MakeSegmentsForSuggestion(
+      "\xE3\x81\x90\xE3\x83\xBC\xE3\x81\x90\xE3\x82\x8B\xE3\x81\x82",
+      &segments);
+  PrependHistorySegments("\xE3\x81\x90\xE3\x83\xBC\xE3\x81\x90\xE3\x82\x8B",
+                         "\xE3\x82\xB0\xE3\x83\xBC\xE3\x82\xB0\xE3\x83\xAB",
+                         &segments);
+  Segments parallel_segments;
+  parallel_segments.CopyFrom(segments);
+
+  const int original_worker_threads = FLAGS_dictionary_predictor_worker_threads;
+  FLAGS_dictionary_predictor_worker_threads = 0;
+  EXPECT_TRUE(predictor->PredictForRequest(default_conversion_request(),
+                                           &segments));
+  FLAGS_dictionary_predictor_worker_threads = 2;
+  EXPECT_TRUE(predictor->PredictForRequest(default_conversion_request(),
+                                           &parallel_segments));
+  FLAGS_dictionary_predictor_worker_threads = original_worker_threads;
+
+  // The results are merged in the same order as the sequential aggregation.
+  const Segment &segment = segments.conversion_segment(0);
+  const Segment &parallel_segment = parallel_segments.conversion_segment(0);
+  ASSERT_EQ(segment.candidates_size(), parallel_segment.candidates_size());
+  for (size_t i = 0; i < segment.candidates_size(); ++i) {
+    EXPECT_EQ(segment.candidate(i).value, parallel_segment.candidate(i).value);
+    EXPECT_EQ(segment.candidate(i).cost, parallel_segment.candidate(i).cost);
+  }
+}
+
+namespace {
+
+// DictionaryMock whose predictive lookup takes |lookup_msec|.
+class SlowPredictiveDictionary : public DictionaryMock {
+ public:
+  explicit SlowPredictiveDictionary(uint32 lookup_msec)
+      : lookup_msec_(lookup_msec) {}
+  virtual ~SlowPredictiveDictionary() {}
+
+  virtual void LookupPredictive(
+      StringPiece key, const ConversionRequest &conversion_request,
+      Callback *callback) const {
+    Util::Sleep(lookup_msec_);
+    DictionaryMock::LookupPredictive(key, conversion_request, callback);
+  }
+
+ private:
+  const uint32 lookup_msec_;
+};
+
+}  // namespace
+
+TEST_F(DictionaryPredictorTest, DropSlowPredictionSourceByDeadline) {
+  config::Config config;
+  config.set_use_dictionary_suggest(true);
+  config.set_use_realtime_conversion(false);
+  config::ConfigHandler::SetConfig(config);
+
+  SlowPredictiveDictionary *dictionary = new SlowPredictiveDictionary(200);
+  AddWordsToMockDic(dictionary);
+  MockDataAndPredictor data_and_predictor;
+  data_and_predictor.Init(dictionary);
+  const DictionaryPredictor *predictor =
+      data_and_predictor.dictionary_predictor();
+
+  const int original_worker_threads = FLAGS_dictionary_predictor_worker_threads;
+  const int original_deadline = FLAGS_dictionary_predictor_source_deadline_msec;
+  FLAGS_dictionary_predictor_worker_threads = 2;
+
+  // "ぐーぐるあ"
+  const char kKey[] = "\xE3\x81\x90\xE3\x83\xBC"
+      "\xE3\x81\x90\xE3\x82\x8B\xE3\x81\x82";
+  Segments segments;
+  MakeSegmentsForSuggestion(kKey, &segments);
+  FLAGS_dictionary_predictor_source_deadline_msec = 0;
+  EXPECT_TRUE(predictor->PredictForRequest(default_conversion_request(),
+                                           &segments));
+
+  // The unigram prediction, the only source, doesn't finish by the deadline.
+  MakeSegmentsForSuggestion(kKey, &segments);
+  FLAGS_dictionary_predictor_source_deadline_msec = 10;
+  EXPECT_FALSE(predictor->PredictForRequest(default_conversion_request(),
+                                            &segments));
+
+  FLAGS_dictionary_predictor_worker_threads = original_worker_threads;
+  FLAGS_dictionary_predictor_source_deadline_msec = original_deadline;
+  // The predictor is deleted after the dropped source finishes.
+}
+
+TEST_F(DictionaryPredictorTest, ReuseAggregationWorkers) {
+  config::Config config;
+  config.set_use_dictionary_suggest(true);
+  config.set_use_realtime_conversion(false);
+  config::ConfigHandler::SetConfig(config);
+
+  SlowPredictiveDictionary *dictionary = new SlowPredictiveDictionary(200);
+  AddWordsToMockDic(dictionary);
+  MockDataAndPredictor data_and_predictor;
+  data_and_predictor.Init(dictionary);
+  const DictionaryPredictor *predictor =
+      data_and_predictor.dictionary_predictor();
+
+  const int original_worker_threads = FLAGS_dictionary_predictor_worker_threads;
+  const int original_deadline = FLAGS_dictionary_predictor_source_deadline_msec;
+  FLAGS_dictionary_predictor_worker_threads = 2;
+
+  // "ぐーぐるあ"
+  const char kKey[] = "\xE3\x81\x90\xE3\x83\xBC"
+      "\xE3\x81\x90\xE3\x82\x8B\xE3\x81\x82";
+  Segments segments;
+  MakeSegmentsForSuggestion(kKey, &segments);
+  FLAGS_dictionary_predictor_source_deadline_msec = 10;
+  EXPECT_FALSE(predictor->PredictForRequest(default_conversion_request(),
+                                            &segments));
+  const DictionaryPredictor::AggregationWorkerPool *worker_pool =
+      predictor->GetWorkerPool();
+  ASSERT_TRUE(worker_pool != NULL);
+
+  // The next request is served by the same workers, while one of them still
+  // runs the source dropped above.
+  MakeSegmentsForSuggestion(kKey, &segments);
+  FLAGS_dictionary_predictor_source_deadline_msec = 0;
+  EXPECT_TRUE(predictor->PredictForRequest(default_conversion_request(),
+                                           &segments));
+  EXPECT_EQ(worker_pool, predictor->GetWorkerPool());
+
+  FLAGS_dictionary_predictor_worker_threads = original_worker_threads;
+  FLAGS_dictionary_predictor_source_deadline_msec = original_deadline;
+}
+
+namespace {
+
+// "てすと"
+const char kTesuto[] = "\xE3\x81\xA6\xE3\x81\x99\xE3\x81\xA8";
+
+// Adds |size| words predicted from "てすと" to |dictionary|.
+void AddTesutoWords(size_t size, DictionaryMock *dictionary) {
+  for (size_t i = 0; i < size; ++i) {
+    const string suffix = NumberUtil::SimpleItoa(static_cast<int32>(i));
+    // "テスト"
+    dictionary->AddLookupPredictive(kTesuto, kTesuto + suffix,
+                                    "\xE3\x83\x86\xE3\x82\xB9"
+                                    "\xE3\x83\x88" + suffix,
+                                    Token::NONE);
+  }
+}
+
+}  // namespace
+
+TEST_F(DictionaryPredictorTest, LookupLimitCountsOnlyOwnResults) {
+  Segments segments;
+  MakeSegmentsForSuggestion(kTesuto, &segments);
+  const ConversionRequest conversion_request;
+  const size_t kPreviousResultsSize = 10;
+
+  {
+    // The unigram words just under the cutoff are all kept, even though the
+    // results of other sources are already there.
+    MockDataAndPredictor data_and_predictor;
+    data_and_predictor.Init();
+    const DictionaryPredictor *predictor =
+        data_and_predictor.dictionary_predictor();
+    const size_t cutoff_threshold =
+        predictor->GetCandidateCutoffThreshold(segments);
+    AddTesutoWords(cutoff_threshold - 1,
+                   data_and_predictor.mutable_dictionary());
+
+    vector<DictionaryPredictor::Result> results(
+        kPreviousResultsSize, DictionaryPredictor::MakeEmptyResult());
+    predictor->AggregateUnigramPrediction(
+        DictionaryPredictor::UNIGRAM, conversion_request, segments, &results);
+    EXPECT_EQ(kPreviousResultsSize + cutoff_threshold - 1, results.size());
+  }
+  {
+    // The unigram words reaching the cutoff are all dropped.
+    MockDataAndPredictor data_and_predictor;
+    data_and_predictor.Init();
+    const DictionaryPredictor *predictor =
+        data_and_predictor.dictionary_predictor();
+    const size_t cutoff_threshold =
+        predictor->GetCandidateCutoffThreshold(segments);
+    AddTesutoWords(cutoff_threshold, data_and_predictor.mutable_dictionary());
+
+    vector<DictionaryPredictor::Result> results(
+        kPreviousResultsSize, DictionaryPredictor::MakeEmptyResult());
+    predictor->AggregateUnigramPrediction(
+        DictionaryPredictor::UNIGRAM, conversion_request, segments, &results);
+    EXPECT_EQ(kPreviousResultsSize, results.size());
+  }
+}
+
+TEST_F(DictionaryPredictorTest, AggregatePredictionInParallelReachingCutoff) {
+  config::Config config;
+  config.set_use_dictionary_suggest(true);
+  config.set_use_realtime_conversion(true);
+  config::ConfigHandler::SetConfig(config);
+
+  const int original_worker_threads = FLAGS_dictionary_predictor_worker_threads;
+  // The number of the unigram words relative to the cutoff threshold.
+  const int kOffsets[] = { -1, 0 };
+  for (size_t i = 0; i < arraysize(kOffsets); ++i) {
+    MockDataAndPredictor data_and_predictor;
+    data_and_predictor.Init();
+    const DictionaryPredictor *predictor =
+        data_and_predictor.dictionary_predictor();
+
+    Segments segments;
+    MakeSegmentsForSuggestion(kTesuto, &segments);
+    const size_t cutoff_threshold =
+        predictor->GetCandidateCutoffThreshold(segments);
+    AddTesutoWords(cutoff_threshold + kOffsets[i],
+                   data_and_predictor.mutable_dictionary());
+    Segments parallel_segments;
+    parallel_segments.CopyFrom(segments);
+
+    FLAGS_dictionary_predictor_worker_threads = 0;
+    vector<DictionaryPredictor::Result> results;
+    predictor->AggregatePrediction(default_conversion_request(), &segments,
+                                   &results);
+    FLAGS_dictionary_predictor_worker_threads = 2;
+    vector<DictionaryPredictor::Result> parallel_results;
+    predictor->AggregatePrediction(default_conversion_request(),
+                                   &parallel_segments, &parallel_results);
+
+    // Both modes keep or drop the same unigram results.
+    size_t unigram_results_size = 0;
+    ASSERT_EQ(results.size(), parallel_results.size());
+    for (size_t j = 0; j < results.size(); ++j) {
+      EXPECT_EQ(results[j].types, parallel_results[j].types);
+      EXPECT_EQ(results[j].value, parallel_results[j].value);
+      EXPECT_EQ(results[j].wcost, parallel_results[j].wcost);
+      if (results[j].types & DictionaryPredictor::UNIGRAM) {
+        ++unigram_results_size;
+      }
+    }
+    if (kOffsets[i] < 0) {
+      EXPECT_EQ(cutoff_threshold + kOffsets[i], unigram_results_size);
+    } else {
+      EXPECT_EQ(0, unigram_results_size);
+    }
+  }
+  FLAGS_dictionary_predictor_worker_threads = original_worker_threads;
+}
+
 TEST_F(DictionaryPredictorTest, AggregateBigramPrediction) {
   scoped_ptr<MockDataAndPredictor> data_and_predictor(
       CreateDictionaryPredictorWithMockData());
@@ -1696,7 +1978,7 @@ class TestSuffixDictionary : public DictionaryInterface {
 
   virtual void LookupPredictive(
       StringPiece key,
-      bool use_kana_modifier_insensitive_lookup,
+      const ConversionRequest &conversion_request,
       Callback *callback) const {
     Token token;
     for (size_t i = 0; i < arraysize(kSuffixTokens); ++i) {
@@ -1727,12 +2009,15 @@ class TestSuffixDictionary : public DictionaryInterface {
   }
 
   virtual void LookupPrefix(
-      StringPiece key, bool use_kana_modifier_insensitive_lookup,
+      StringPiece key, const ConversionRequest &conversion_request,
       Callback *callback) const {}
 
-  virtual void LookupExact(StringPiece key, Callback *callback) const {}
+  virtual void LookupExact(StringPiece key,
+                           const ConversionRequest &conversion_request,
+                           Callback *callback) const {}
 
   virtual void LookupReverse(StringPiece str, NodeAllocatorInterface *allocator,
+                             const ConversionRequest &conversion_request,
                              Callback *callback) const {}
 };
 
@@ -1938,6 +2223,88 @@ TEST_F(DictionaryPredictorTest, AggregateTypeCorrectingPrediction) {
                                     arraysize(kExpectedValues));
 }
 
+namespace {
+
+// Dictionary which predicts |num_tokens| words from any key, and counts the
+// lookups and the tokens passed to the callbacks.
+class CountingPredictiveDictionary : public DictionaryMock {
+ public:
+  explicit CountingPredictiveDictionary(size_t num_tokens)
+      : num_tokens_(num_tokens), num_lookups_(0), num_visited_tokens_(0) {}
+  virtual ~CountingPredictiveDictionary() {}
+
+  virtual void LookupPredictive(
+      StringPiece key, const ConversionRequest &conversion_request,
+      Callback *callback) const {
+    ++num_lookups_;
+    for (size_t i = 0; i < num_tokens_; ++i) {
+      Token token;
+      token.key = key.as_string() + NumberUtil::SimpleItoa(
+          static_cast<int32>(i));
+      token.value = token.key;
+      ++num_visited_tokens_;
+      if (callback->OnToken(key, key, token) != Callback::TRAVERSE_CONTINUE) {
+        return;
+      }
+    }
+  }
+
+  size_t num_lookups() const {
+    return num_lookups_;
+  }
+  size_t num_visited_tokens() const {
+    return num_visited_tokens_;
+  }
+
+ private:
+  const size_t num_tokens_;
+  mutable size_t num_lookups_;
+  mutable size_t num_visited_tokens_;
+};
+
+}  // namespace
+
+TEST_F(DictionaryPredictorTest, TypeCorrectingPredictionStopsAtLimit) {
+  config::Config config;
+  config::ConfigHandler::GetDefaultConfig(&config);
+  config.set_use_typing_correction(true);
+  config::ConfigHandler::SetConfig(config);
+
+  commands::Request qwerty_request;
+  qwerty_request.set_special_romanji_table(
+      commands::Request::QWERTY_MOBILE_TO_HIRAGANA);
+  CountingPredictiveDictionary *dictionary =
+      new CountingPredictiveDictionary(1000);
+  MockDataAndPredictor data_and_predictor;
+  data_and_predictor.Init(dictionary);
+  const TestableDictionaryPredictor *predictor =
+      data_and_predictor.dictionary_predictor();
+
+  composer::Table table;
+  table.LoadFromFile("system://qwerty_mobile-hiragana.tsv");
+  SetMockTypingModel(&table);
+  composer::Composer composer(&table, &qwerty_request);
+  const char kInputText[] = "gu-huru";
+  const uint32 kCorrectedKeyCodes[] = {'g', 'u', '-', 'g', 'u', 'r', 'u'};
+  InsertInputSequenceForProbableKeyEvent(kInputText, kCorrectedKeyCodes,
+                                         &composer);
+
+  Segments segments;
+  MakeSegmentsForSuggestion(kInputText, &segments);
+  vector<TestableDictionaryPredictor::Result> results;
+  const ConversionRequest conversion_request(&composer, &qwerty_request);
+  predictor->AggregateTypeCorrectingPrediction(
+      TestableDictionaryPredictor::TYPING_CORRECTION,
+      conversion_request, segments, &results);
+
+  // Once the preceding queries fill the limit, each of the remaining queries
+  // stops at its first token instead of looking up the limit by itself.
+  const size_t kSuggestionLimit = 256;
+  ASSERT_LT(1, dictionary->num_lookups());
+  EXPECT_GE(kSuggestionLimit + dictionary->num_lookups(),
+            dictionary->num_visited_tokens());
+}
+
 TEST_F(DictionaryPredictorTest, ZeroQuerySuggestionAfterNumbers) {
   scoped_ptr<MockDataAndPredictor> data_and_predictor(
       CreateDictionaryPredictorWithMockData());
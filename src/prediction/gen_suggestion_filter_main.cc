@@ -43,6 +43,9 @@ DEFINE_bool(header, true,
             "make header file instead of raw bloom filter");
 DEFINE_string(name, "SuggestionFilterData",
               "name for variable name in the header file");
+DEFINE_bool(blocked, false,
+            "generate a cache-line blocked bloom filter. "
+            "Lookups are faster but the size is rounded up to a power of two");
 
 namespace {
 void ReadWords(const string &name, vector<uint64> *words) {
@@ -89,6 +92,8 @@ int main(int argc, char **argv) {
   LOG(INFO) << "num_bytes: " << num_bytes;
 
   scoped_ptr<ExistenceFilter> filter(
+      FLAGS_blocked ?
+      ExistenceFilter::CreateOptimalBlocked(num_bytes, words.size()) :
       ExistenceFilter::CreateOptimal(num_bytes, words.size()));
   for (size_t i = 0; i < words.size(); ++i) {
     filter->Insert(words[i]);
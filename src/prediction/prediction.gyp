@@ -40,6 +40,7 @@
       'sources': [
         'dictionary_predictor.cc',
         'predictor.cc',
+        'user_history_key_index.cc',
         'user_history_predictor.cc',
       ],
       'dependencies': [
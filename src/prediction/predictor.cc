@@ -35,7 +35,6 @@
 #include "base/flags.h"
 #include "base/logging.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/segments.h"
 #include "session/commands.pb.h"
 
@@ -82,9 +81,10 @@ BasePredictor::BasePredictor(PredictorInterface *dictionary_predictor,
 
 BasePredictor::~BasePredictor() {}
 
-void BasePredictor::Finish(Segments *segments) {
-  user_history_predictor_->Finish(segments);
-  dictionary_predictor_->Finish(segments);
+void BasePredictor::Finish(const ConversionRequest &request,
+                           Segments *segments) {
+  user_history_predictor_->Finish(request, segments);
+  dictionary_predictor_->Finish(request, segments);
 
   if (segments->conversion_segments_size() < 1 ||
       segments->request_type() == Segments::CONVERSION) {
@@ -153,13 +153,14 @@ bool DefaultPredictor::PredictForRequest(const ConversionRequest &request,
          segments->request_type() == Segments::PARTIAL_PREDICTION ||
          segments->request_type() == Segments::PARTIAL_SUGGESTION);
 
-  if (GET_CONFIG(presentation_mode)) {
+  if (request.config().presentation_mode()) {
     return false;
   }
 
   int size = kPredictionSize;
   if (segments->request_type() == Segments::SUGGESTION) {
-    size = min(9, max(1, static_cast<int>(GET_CONFIG(suggestions_size))));
+    size = min(9, max(1,
+                      static_cast<int>(request.config().suggestions_size())));
   }
 
   bool result = false;
@@ -209,7 +210,7 @@ bool MobilePredictor::PredictForRequest(const ConversionRequest &request,
          segments->request_type() == Segments::PARTIAL_PREDICTION ||
          segments->request_type() == Segments::PARTIAL_SUGGESTION);
 
-  if (GET_CONFIG(presentation_mode)) {
+  if (request.config().presentation_mode()) {
     return false;
   }
 
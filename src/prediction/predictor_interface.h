@@ -50,8 +50,9 @@ class PredictorInterface {
   virtual bool PredictForRequest(const ConversionRequest &request,
                                  Segments *segments) const = 0;
 
-  // Hook(s) for all mutable operations.
-  virtual void Finish(Segments *segments) {}
+  // Hook(s) for all mutable operations. |request| is the request the
+  // segments were converted with; its config decides what can be learned.
+  virtual void Finish(const ConversionRequest &request, Segments *segments) {}
 
   // Reverts the last Finish operation.
   virtual void Revert(Segments *segments) {}
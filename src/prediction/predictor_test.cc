@@ -342,12 +342,14 @@ TEST_F(PredictorTest, DisableAllSuggestion) {
 
   config.set_presentation_mode(true);
   config::ConfigHandler::SetConfig(config);
+  default_request_->set_config(config::ConfigHandler::GetConfigSnapshot());
   EXPECT_FALSE(predictor->PredictForRequest(*default_request_, &segments));
   EXPECT_FALSE(predictor1->predict_called());
   EXPECT_FALSE(predictor2->predict_called());
 
   config.set_presentation_mode(false);
   config::ConfigHandler::SetConfig(config);
+  default_request_->set_config(config::ConfigHandler::GetConfigSnapshot());
   EXPECT_TRUE(predictor->PredictForRequest(*default_request_, &segments));
   EXPECT_TRUE(predictor1->predict_called());
   EXPECT_TRUE(predictor2->predict_called());
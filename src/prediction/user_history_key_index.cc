@@ -0,0 +1,178 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "prediction/user_history_key_index.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/util.h"
+
+namespace mozc {
+
+UserHistoryKeyIndex::UserHistoryKeyIndex() : next_seq_(0) {}
+
+UserHistoryKeyIndex::~UserHistoryKeyIndex() {}
+
+void UserHistoryKeyIndex::Insert(uint32 fp, const string &key) {
+  Erase(fp);
+  if (key.empty()) {
+    return;
+  }
+  Item *item = &items_[fp];
+  item->key = key;
+  Util::HiraganaToRomanji(key, &item->roman_key);
+  item->seq = next_seq_++;
+  keys_.insert(make_pair(item->key, fp));
+  roman_keys_.insert(make_pair(item->roman_key, fp));
+}
+
+bool UserHistoryKeyIndex::Erase(uint32 fp) {
+  ItemMap::iterator it = items_.find(fp);
+  if (it == items_.end()) {
+    return false;
+  }
+  keys_.erase(make_pair(it->second.key, fp));
+  roman_keys_.erase(make_pair(it->second.roman_key, fp));
+  items_.erase(it);
+  return true;
+}
+
+void UserHistoryKeyIndex::Clear() {
+  items_.clear();
+  keys_.clear();
+  roman_keys_.clear();
+  next_seq_ = 0;
+}
+
+// static
+void UserHistoryKeyIndex::AppendPredictive(const KeySet &keys,
+                                           StringPiece prefix,
+                                           vector<uint32> *fps) {
+  for (KeySet::const_iterator it =
+           keys.lower_bound(make_pair(prefix.as_string(), 0));
+       it != keys.end() && Util::StartsWith(it->first, prefix); ++it) {
+    fps->push_back(it->second);
+  }
+}
+
+void UserHistoryKeyIndex::LookupPredictive(StringPiece prefix,
+                                           vector<uint32> *fps) const {
+  DCHECK(fps);
+  AppendPredictive(keys_, prefix, fps);
+}
+
+void UserHistoryKeyIndex::LookupPrefix(StringPiece key,
+                                       vector<uint32> *fps) const {
+  DCHECK(fps);
+  // Keys are UTF-8 strings, so only the prefixes ending at character
+  // boundaries need to be looked up.
+  size_t len = 0;
+  while (len < key.size()) {
+    len += max(static_cast<size_t>(1), Util::OneCharLen(key.data() + len));
+    const string prefix = key.substr(0, len).as_string();
+    for (KeySet::const_iterator it = keys_.lower_bound(make_pair(prefix, 0));
+         it != keys_.end() && it->first == prefix; ++it) {
+      fps->push_back(it->second);
+    }
+  }
+}
+
+void UserHistoryKeyIndex::LookupRomanFuzzy(StringPiece roman_prefix,
+                                           vector<uint32> *fps) const {
+  DCHECK(fps);
+  if (roman_prefix.empty()) {
+    return;
+  }
+  const string prefix = roman_prefix.as_string();
+
+  // If the first mismatch is found after the first character, the romanized
+  // key starts with the first character of |prefix|.
+  AppendPredictive(roman_keys_, prefix.substr(0, 1), fps);
+
+  // The first character is replaced with '-'.
+  AppendPredictive(roman_keys_, "-", fps);
+
+  // The first two characters are swapped.
+  if (prefix.size() > 1) {
+    string swapped = prefix.substr(0, 2);
+    swap(swapped[0], swapped[1]);
+    AppendPredictive(roman_keys_, swapped, fps);
+  }
+
+  // The first character is deleted. Visits each distinct first character of
+  // the romanized keys and looks up that character followed by |prefix|.
+  KeySet::const_iterator it = roman_keys_.begin();
+  while (it != roman_keys_.end()) {
+    if (it->first.empty()) {
+      ++it;
+      continue;
+    }
+    const uint8 c = static_cast<uint8>(it->first[0]);
+    AppendPredictive(roman_keys_, string(1, static_cast<char>(c)) + prefix,
+                     fps);
+    if (c == 0xFF) {
+      break;
+    }
+    it = roman_keys_.lower_bound(
+        make_pair(string(1, static_cast<char>(c + 1)), 0));
+  }
+}
+
+namespace {
+typedef pair<uint64, uint32> SeqAndFingerprint;
+
+struct SeqGreater {
+  bool operator()(const SeqAndFingerprint &lhs,
+                  const SeqAndFingerprint &rhs) const {
+    return lhs.first > rhs.first;
+  }
+};
+}  // namespace
+
+void UserHistoryKeyIndex::SortByRecency(vector<uint32> *fps) const {
+  DCHECK(fps);
+  vector<SeqAndFingerprint> sorted;
+  sorted.reserve(fps->size());
+  for (size_t i = 0; i < fps->size(); ++i) {
+    ItemMap::const_iterator it = items_.find((*fps)[i]);
+    if (it != items_.end()) {
+      sorted.push_back(make_pair(it->second.seq, it->first));
+    }
+  }
+  sort(sorted.begin(), sorted.end(), SeqGreater());
+  sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+  fps->clear();
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    fps->push_back(sorted[i].second);
+  }
+}
+
+}  // namespace mozc
@@ -0,0 +1,110 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_PREDICTION_USER_HISTORY_KEY_INDEX_H_
+#define MOZC_PREDICTION_USER_HISTORY_KEY_INDEX_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/port.h"
+#include "base/string_piece.h"
+
+namespace mozc {
+
+// Reading index for the entries of UserHistoryPredictor.
+//
+// UserHistoryPredictor stores its entries in an LRU cache keyed by the
+// fingerprint of key/value. To avoid scanning the whole LRU on every key
+// event, this class keeps the readings (and their romanized forms) sorted so
+// that the entries which can match the user input are found by range scans.
+// The index also remembers the insertion order so that the matched
+// fingerprints can be visited in the same order as the LRU list.
+class UserHistoryKeyIndex {
+ public:
+  UserHistoryKeyIndex();
+  ~UserHistoryKeyIndex();
+
+  // Registers |fp| with the reading |key|. If |fp| is already registered, it
+  // is re-registered as the most recent one. Empty keys are not indexed.
+  void Insert(uint32 fp, const string &key);
+
+  // Unregisters |fp|. Returns false if |fp| is not registered.
+  bool Erase(uint32 fp);
+
+  // Removes all the registered entries.
+  void Clear();
+
+  // Returns the number of registered entries.
+  size_t size() const { return items_.size(); }
+
+  // Appends the fingerprints whose key starts with |prefix|.
+  void LookupPredictive(StringPiece prefix, vector<uint32> *fps) const;
+
+  // Appends the fingerprints whose key is a prefix of |key|, including the
+  // ones exactly the same as |key|.
+  void LookupPrefix(StringPiece key, vector<uint32> *fps) const;
+
+  // Appends the fingerprints whose romanized key may match |roman_prefix|
+  // with UserHistoryPredictor::RomanFuzzyPrefixMatch(), i.e., the romanized
+  // key starts with |roman_prefix| allowing one deletion, one swap or one
+  // '-' replacement. The result is a superset of the actual matches.
+  void LookupRomanFuzzy(StringPiece roman_prefix, vector<uint32> *fps) const;
+
+  // Sorts |fps| from the most recently inserted one and removes duplicates.
+  // Unregistered fingerprints are removed as well.
+  void SortByRecency(vector<uint32> *fps) const;
+
+ private:
+  struct Item {
+    string key;
+    string roman_key;
+    uint64 seq;
+  };
+
+  typedef map<uint32, Item> ItemMap;
+  typedef set<pair<string, uint32> > KeySet;
+
+  static void AppendPredictive(const KeySet &keys, StringPiece prefix,
+                               vector<uint32> *fps);
+
+  ItemMap items_;
+  KeySet keys_;
+  KeySet roman_keys_;
+  uint64 next_seq_;
+
+  DISALLOW_COPY_AND_ASSIGN(UserHistoryKeyIndex);
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_PREDICTION_USER_HISTORY_KEY_INDEX_H_
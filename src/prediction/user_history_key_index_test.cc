@@ -0,0 +1,154 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "prediction/user_history_key_index.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/port.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace {
+
+bool Contains(const vector<uint32> &fps, uint32 fp) {
+  return find(fps.begin(), fps.end(), fp) != fps.end();
+}
+
+TEST(UserHistoryKeyIndexTest, LookupPredictive) {
+  UserHistoryKeyIndex index;
+  // "わたし", "わたしの", "わたなべ", "あなた"
+  index.Insert(1, "\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97");
+  index.Insert(2, "\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97\xE3\x81\xAE");
+  index.Insert(3, "\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\xAA\xE3\x81\xB9");
+  index.Insert(4, "\xE3\x81\x82\xE3\x81\xAA\xE3\x81\x9F");
+  EXPECT_EQ(4, index.size());
+
+  vector<uint32> fps;
+  // "わたし"
+  index.LookupPredictive("\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97", &fps);
+  EXPECT_EQ(2, fps.size());
+  EXPECT_TRUE(Contains(fps, 1));
+  EXPECT_TRUE(Contains(fps, 2));
+
+  fps.clear();
+  // "わ"
+  index.LookupPredictive("\xE3\x82\x8F", &fps);
+  EXPECT_EQ(3, fps.size());
+
+  fps.clear();
+  // "い"
+  index.LookupPredictive("\xE3\x81\x84", &fps);
+  EXPECT_TRUE(fps.empty());
+}
+
+TEST(UserHistoryKeyIndexTest, LookupPrefix) {
+  UserHistoryKeyIndex index;
+  // "わ", "わた", "わたし", "わたしの"
+  index.Insert(1, "\xE3\x82\x8F");
+  index.Insert(2, "\xE3\x82\x8F\xE3\x81\x9F");
+  index.Insert(3, "\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97");
+  index.Insert(4, "\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97\xE3\x81\xAE");
+
+  vector<uint32> fps;
+  // "わたし"
+  index.LookupPrefix("\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97", &fps);
+  EXPECT_EQ(3, fps.size());
+  EXPECT_TRUE(Contains(fps, 1));
+  EXPECT_TRUE(Contains(fps, 2));
+  EXPECT_TRUE(Contains(fps, 3));
+  EXPECT_FALSE(Contains(fps, 4));
+}
+
+TEST(UserHistoryKeyIndexTest, LookupRomanFuzzy) {
+  UserHistoryKeyIndex index;
+  // "かまた" => "kamata"
+  index.Insert(1, "\xE3\x81\x8B\xE3\x81\xBE\xE3\x81\x9F");
+  // "わたし" => "watashi"
+  index.Insert(2, "\xE3\x82\x8F\xE3\x81\x9F\xE3\x81\x97");
+
+  vector<uint32> fps;
+  index.LookupRomanFuzzy("kamata", &fps);
+  EXPECT_TRUE(Contains(fps, 1));
+
+  // Deletion of the first character.
+  fps.clear();
+  index.LookupRomanFuzzy("amat", &fps);
+  EXPECT_TRUE(Contains(fps, 1));
+
+  // Swap of the first two characters.
+  fps.clear();
+  index.LookupRomanFuzzy("akma", &fps);
+  EXPECT_TRUE(Contains(fps, 1));
+
+  fps.clear();
+  index.LookupRomanFuzzy("", &fps);
+  EXPECT_TRUE(fps.empty());
+}
+
+TEST(UserHistoryKeyIndexTest, EraseAndSortByRecency) {
+  UserHistoryKeyIndex index;
+  index.Insert(1, "a");
+  index.Insert(2, "ab");
+  index.Insert(3, "abc");
+  // Re-insertion makes the entry the most recent one.
+  index.Insert(1, "a");
+  EXPECT_EQ(3, index.size());
+
+  vector<uint32> fps;
+  index.LookupPrefix("abc", &fps);
+  index.LookupPredictive("a", &fps);
+  fps.push_back(100);  // Unregistered fingerprint.
+  index.SortByRecency(&fps);
+  ASSERT_EQ(3, fps.size());
+  EXPECT_EQ(1, fps[0]);
+  EXPECT_EQ(3, fps[1]);
+  EXPECT_EQ(2, fps[2]);
+
+  EXPECT_TRUE(index.Erase(3));
+  EXPECT_FALSE(index.Erase(3));
+  fps.clear();
+  index.LookupPredictive("a", &fps);
+  EXPECT_EQ(2, fps.size());
+  EXPECT_FALSE(Contains(fps, 3));
+
+  // Empty keys are not indexed.
+  index.Insert(4, "");
+  EXPECT_EQ(2, index.size());
+
+  index.Clear();
+  EXPECT_EQ(0, index.size());
+  fps.clear();
+  index.LookupPredictive("a", &fps);
+  EXPECT_TRUE(fps.empty());
+}
+
+}  // namespace
+}  // namespace mozc
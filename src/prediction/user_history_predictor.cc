@@ -32,7 +32,10 @@
 #include <algorithm>
 #include <cctype>
 #include <climits>
+#include <list>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "base/config_file_stream.h"
 #include "base/flags.h"
@@ -53,6 +56,7 @@
 #include "prediction/user_history_predictor.pb.h"
 #include "rewriter/variants_rewriter.h"
 #include "session/commands.pb.h"
+#include "storage/encrypted_journal_storage.h"
 #include "storage/encrypted_string_storage.h"
 #include "storage/lru_cache.h"
 #include "usage_stats/usage_stats.h"
@@ -69,8 +73,8 @@ namespace mozc {
 using commands::Request;
 
 namespace {
-// find suggestion candidates from the most recent 3000 history in LRU.
-// We don't check all history, since suggestion is called every key event
+// find suggestion candidates from the most recent 3000 matched histories in
+// LRU. We don't check all history, since suggestion is called every key event
 const size_t kMaxSuggestionTrial = 3000;
 
 // find suffix matches of history_segments from the most recent 500 histories
@@ -105,6 +109,14 @@ const char kFileName[] = "user://history.db";
 const char kFileName[] = "user://.history.db";
 #endif
 
+// suffix of the journal file for the history
+const char kJournalFileSuffix[] = ".journal";
+
+// the journal is compacted into a new snapshot when it gets longer than the
+// number of entries, but it can have at least kMinJournalRecordsToCompact
+// records.
+const size_t kMinJournalRecordsToCompact = 1000;
+
 // use '\t' as a key/value delimiter
 const char kDelimiter[] = "\t";
 
@@ -266,7 +278,11 @@ bool UserHistoryPredictor::IsPrivacySensitive(const Segments *segments) const {
 }
 
 UserHistoryStorage::UserHistoryStorage(const string &filename)
-    : storage_(new storage::EncryptedStringStorage(filename)) {
+    : storage_(new storage::EncryptedStringStorage(filename)),
+      journal_(new storage::EncryptedJournalStorage(
+          filename + kJournalFileSuffix)),
+      num_journal_records_(0),
+      is_journal_broken_(false) {
 }
 
 UserHistoryStorage::~UserHistoryStorage() {}
@@ -283,16 +299,100 @@ bool UserHistoryStorage::Load() {
     return false;
   }
 
-  VLOG(1) << "Loaded user histroy, size=" << entries_size();
+  num_journal_records_ = 0;
+  is_journal_broken_ = false;
+  // The snapshots saved before the journal was introduced don't have the id.
+  if (snapshot_id() != 0) {
+    vector<string> records;
+    if (journal_->Load(snapshot_id(), &records, &is_journal_broken_)) {
+      ApplyJournal(records);
+    }
+  }
+
+  VLOG(1) << "Loaded user histroy, size=" << entries_size()
+          << " journal=" << num_journal_records_;
   return true;
 }
 
-bool UserHistoryStorage::Save() const {
+void UserHistoryStorage::ApplyJournal(const vector<string> &records) {
+  typedef list<Entry> EntryList;
+  EntryList entries;
+  map<uint32, EntryList::iterator> entry_map;
+  for (size_t i = 0; i < entries_size(); ++i) {
+    const uint32 fp = UserHistoryPredictor::EntryFingerprint(this->entries(i));
+    map<uint32, EntryList::iterator>::iterator it = entry_map.find(fp);
+    if (it != entry_map.end()) {
+      entries.erase(it->second);
+    }
+    entries.push_back(Entry());
+    entries.back().Swap(mutable_entries(i));
+    entry_map[fp] = --entries.end();
+  }
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    JournalRecord record;
+    if (!record.ParseFromString(records[i])) {
+      LOG(ERROR) << "ParseFromString failed. journal looks broken";
+      is_journal_broken_ = true;
+      break;
+    }
+    ++num_journal_records_;
+
+    // The entries are keyed in the same way as UserHistoryPredictor::Load().
+    const uint32 fp = record.has_entry() ?
+        UserHistoryPredictor::EntryFingerprint(record.entry()) :
+        record.fingerprint();
+    map<uint32, EntryList::iterator>::iterator it = entry_map.find(fp);
+    switch (record.type()) {
+      case JournalRecord::UPDATE_ENTRY:
+        if (it != entry_map.end()) {
+          it->second->Swap(record.mutable_entry());
+          break;
+        }
+        entries.push_back(Entry());
+        entries.back().Swap(record.mutable_entry());
+        entry_map[fp] = --entries.end();
+        break;
+      case JournalRecord::PROMOTE_ENTRY:
+        if (it != entry_map.end()) {
+          entries.erase(it->second);
+        }
+        entries.push_back(Entry());
+        entries.back().Swap(record.mutable_entry());
+        entry_map[fp] = --entries.end();
+        break;
+      case JournalRecord::ERASE_ENTRY:
+        if (it != entry_map.end()) {
+          entries.erase(it->second);
+          entry_map.erase(it);
+        }
+        break;
+      default:
+        LOG(ERROR) << "Unknown journal record type: " << record.type();
+        break;
+    }
+  }
+
+  clear_entries();
+  for (EntryList::iterator it = entries.begin(); it != entries.end(); ++it) {
+    add_entries()->Swap(&(*it));
+  }
+}
+
+bool UserHistoryStorage::Save() {
   if (entries_size() == 0) {
     LOG(WARNING) << "etries size is 0. Not saved";
     return false;
   }
 
+  // The new snapshot invalidates the journal for the previous one, even if
+  // the journal is not removed.
+  uint64 id = 0;
+  while (id == 0) {
+    Util::GetRandomSequence(reinterpret_cast<char *>(&id), sizeof(id));
+  }
+  set_snapshot_id(id);
+
   string output;
   if (!AppendToString(&output)) {
     LOG(ERROR) << "AppendToString failed";
@@ -304,6 +404,33 @@ bool UserHistoryStorage::Save() const {
     return false;
   }
 
+  if (!journal_->Remove()) {
+    LOG(WARNING) << "Can't remove the journal of user history.";
+  }
+
+  return true;
+}
+
+bool UserHistoryStorage::AppendToJournal(
+    const vector<JournalRecord> &records) const {
+  if (snapshot_id() == 0) {
+    LOG(ERROR) << "snapshot_id is not set";
+    return false;
+  }
+
+  vector<string> output(records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (!records[i].AppendToString(&output[i])) {
+      LOG(ERROR) << "AppendToString failed";
+      return false;
+    }
+  }
+
+  if (!journal_->Append(snapshot_id(), output)) {
+    LOG(ERROR) << "Can't append to the journal of user history.";
+    return false;
+  }
+
   return true;
 }
 
@@ -385,7 +512,10 @@ UserHistoryPredictor::UserHistoryPredictor(
       suppression_dictionary_(suppression_dictionary),
       predictor_name_("UserHistoryPredictor"),
       updated_(false),
-      dic_(new DicCache(UserHistoryPredictor::cache_size())) {
+      dic_(new DicCache(UserHistoryPredictor::cache_size())),
+      snapshot_id_(0),
+      num_journal_records_(0),
+      needs_snapshot_(true) {
   AsyncLoad();  // non-blocking
   // Load()  blocking version can be used if any
 }
@@ -407,6 +537,7 @@ uint16 UserHistoryPredictor::revert_id() {
 }
 
 void UserHistoryPredictor::WaitForSyncer() {
+  scoped_lock l(&syncer_mutex_);
   if (syncer_.get() != NULL) {
     syncer_->Join();
     syncer_.reset(NULL);
@@ -419,6 +550,7 @@ bool UserHistoryPredictor::WaitForSyncerForTest() {
 }
 
 bool UserHistoryPredictor::CheckSyncerAndDelete() const {
+  scoped_lock l(&syncer_mutex_);
   if (syncer_.get() != NULL) {
     if (syncer_->IsRunning()) {
       return false;
@@ -441,6 +573,7 @@ bool UserHistoryPredictor::Reload() {
 }
 
 bool UserHistoryPredictor::AsyncLoad() {
+  scoped_lock l(&syncer_mutex_);
   if (!CheckSyncerAndDelete()) {  // now loading/saving
     return true;
   }
@@ -454,10 +587,14 @@ bool UserHistoryPredictor::AsyncLoad() {
 }
 
 bool UserHistoryPredictor::AsyncSave() {
-  if (!updated_) {
-    return true;
+  {
+    scoped_reader_lock l(&dic_mutex_);
+    if (!updated_) {
+      return true;
+    }
   }
 
+  scoped_lock l(&syncer_mutex_);
   if (!CheckSyncerAndDelete()) {  // now loading/saving
     return true;
   }
@@ -479,9 +616,30 @@ bool UserHistoryPredictor::Load() {
     return false;
   }
 
+  // The file is parsed without the lock, so that the conversions running in
+  // parallel are only blocked while the entries are merged.
+  scoped_writer_lock l(&dic_mutex_);
+  const bool is_empty = (dic_->Head() == NULL);
   for (size_t i = 0; i < history.entries_size(); ++i) {
-    dic_->Insert(EntryFingerprint(history.entries(i)),
-                 history.entries(i));
+    DicElement *e = InsertDicElement(EntryFingerprint(history.entries(i)),
+                                     history.entries(i).key());
+    if (e != NULL) {
+      e->value = history.entries(i);
+    }
+  }
+
+  {
+    scoped_lock journal_lock(&journal_mutex_);
+    if (is_empty) {
+      // |dic_| is the same as the file, so the next changes can be appended
+      // to the journal unless it was broken.
+      pending_changes_.clear();
+      snapshot_id_ = history.snapshot_id();
+      num_journal_records_ = history.num_journal_records();
+      needs_snapshot_ = (snapshot_id_ == 0 || history.is_journal_broken());
+    } else {
+      needs_snapshot_ = true;
+    }
   }
 
   VLOG(1) << "Loaded user histroy, size=" << history.entries_size();
@@ -490,43 +648,85 @@ bool UserHistoryPredictor::Load() {
 }
 
 bool UserHistoryPredictor::Save() {
-  if (!updated_) {
-    return true;
-  }
-
-  if (GET_CONFIG(incognito_mode)) {
-    VLOG(2) << "incognito mode";
-    return true;
-  }
-
-  if (!GET_CONFIG(use_history_suggest)) {
-    VLOG(2) << "no history suggest";
-    return true;
-  }
-
-  const DicElement *tail = dic_->Tail();
-  if (tail == NULL) {
-    return true;
-  }
-
+  // Finish() checks the config of each conversion before learning it, so
+  // every pending change is allowed to be saved regardless of the current
+  // config. Removals by Revert() and Clear*() are saved as well.
   const string filename = GetUserHistoryFileName();
 
   UserHistoryStorage history(filename);
-  for (const DicElement *elm = tail; elm != NULL; elm = elm->prev) {
-    history.add_entries()->CopyFrom(elm->value);
+  vector<JournalRecord> records;
+  bool use_journal = false;
+  size_t entry_size = 0;
+  {
+    scoped_reader_lock l(&dic_mutex_);
+    if (!updated_) {
+      return true;
+    }
+    scoped_lock journal_lock(&journal_mutex_);
+    // Appends only the changes to the journal, and compacts it into a new
+    // snapshot when it gets long. As Save() runs on the syncer thread, the
+    // compaction doesn't block the conversion.
+    const size_t max_journal_records =
+        max(kMinJournalRecordsToCompact, dic_->Size());
+    use_journal = (!needs_snapshot_ && snapshot_id_ != 0 &&
+                   num_journal_records_ + pending_changes_.size() <=
+                   max_journal_records &&
+                   GetJournalRecords(&records));
+    if (use_journal) {
+      history.set_snapshot_id(snapshot_id_);
+    } else {
+      records.clear();
+      const DicElement *tail = dic_->Tail();
+      if (tail == NULL) {
+        return true;
+      }
+      for (const DicElement *elm = tail; elm != NULL; elm = elm->prev) {
+        history.add_entries()->CopyFrom(elm->value);
+      }
+    }
+    pending_changes_.clear();
+    entry_size = dic_->Size();
   }
 
   // update usage stats here.
   usage_stats::UsageStats::SetInteger(
       "UserHistoryPredictorEntrySize",
-      static_cast<int>(history.entries_size()));
+      static_cast<int>(entry_size));
 
-  if (!history.Save()) {
-    LOG(ERROR) << "UserHistoryStorage::Save() failed";
-    return false;
+  bool result = false;
+  if (use_journal) {
+    result = records.empty() || history.AppendToJournal(records);
+  } else {
+    result = history.Save();
   }
 
-  updated_ = false;
+  {
+    scoped_writer_lock l(&dic_mutex_);
+    scoped_lock journal_lock(&journal_mutex_);
+    if (!result) {
+      // The changes taken above are not in the file, so the whole history
+      // needs to be saved next time.
+      needs_snapshot_ = true;
+      updated_ = true;
+    } else {
+      if (use_journal) {
+        num_journal_records_ += records.size();
+      } else {
+        snapshot_id_ = history.snapshot_id();
+        num_journal_records_ = 0;
+        needs_snapshot_ = false;
+      }
+      // The changes made while saving are saved next time.
+      updated_ = !pending_changes_.empty();
+    }
+  }
+
+  if (!result) {
+    LOG(ERROR) << (use_journal ? "UserHistoryStorage::AppendToJournal()"
+                               : "UserHistoryStorage::Save()")
+               << " failed";
+    return false;
+  }
 
   return true;
 }
@@ -536,14 +736,23 @@ bool UserHistoryPredictor::ClearAllHistory() {
   WaitForSyncer();
 
   VLOG(1) << "Clearing user prediction";
-  // renew DicCache as LRUCache tries to reuse the internal value by
-  // using FreeList
-  dic_.reset(new DicCache(UserHistoryPredictor::cache_size()));
+  {
+    scoped_writer_lock l(&dic_mutex_);
+    // renew DicCache as LRUCache tries to reuse the internal value by
+    // using FreeList
+    dic_.reset(new DicCache(UserHistoryPredictor::cache_size()));
+    key_index_.Clear();
+    {
+      scoped_lock journal_lock(&journal_mutex_);
+      pending_changes_.clear();
+      needs_snapshot_ = true;
+    }
 
-  // insert a dummy event entry.
-  InsertEvent(Entry::CLEAN_ALL_EVENT);
+    // insert a dummy event entry.
+    InsertEvent(Entry::CLEAN_ALL_EVENT);
 
-  updated_ = true;
+    updated_ = true;
+  }
 
   Sync();
 
@@ -555,31 +764,34 @@ bool UserHistoryPredictor::ClearUnusedHistory() {
   WaitForSyncer();
 
   VLOG(1) << "Clearing unused prediction";
-  const DicElement *head = dic_->Head();
-  if (head == NULL) {
-    VLOG(2) << "dic head is NULL";
-    return false;
-  }
-
   vector<uint32> keys;
-  for (const DicElement *elm = head; elm != NULL; elm = elm->next) {
-    VLOG(3) << elm->key << " " << elm->value.suggestion_freq();
-    if (elm->value.suggestion_freq() == 0) {
-      keys.push_back(elm->key);
+  {
+    scoped_writer_lock l(&dic_mutex_);
+    const DicElement *head = dic_->Head();
+    if (head == NULL) {
+      VLOG(2) << "dic head is NULL";
+      return false;
     }
-  }
 
-  for (size_t i = 0; i < keys.size(); ++i) {
-    VLOG(2) << "Removing: " << keys[i];
-    if (!dic_->Erase(keys[i])) {
-      LOG(ERROR) << "cannot erase " << keys[i];
+    for (const DicElement *elm = head; elm != NULL; elm = elm->next) {
+      VLOG(3) << elm->key << " " << elm->value.suggestion_freq();
+      if (elm->value.suggestion_freq() == 0) {
+        keys.push_back(elm->key);
+      }
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+      VLOG(2) << "Removing: " << keys[i];
+      if (!EraseDicElement(keys[i])) {
+        LOG(ERROR) << "cannot erase " << keys[i];
+      }
     }
-  }
 
-  // insert a dummy event entry.
-  InsertEvent(Entry::CLEAN_UNUSED_EVENT);
+    // insert a dummy event entry.
+    InsertEvent(Entry::CLEAN_UNUSED_EVENT);
 
-  updated_ = true;
+    updated_ = true;
+  }
 
   Sync();
 
@@ -657,6 +869,7 @@ UserHistoryPredictor::RemoveNgramChain(const string &target_key,
           // |entry| is the second-to-the-last node. So cut the link to the
           // child entry.
           EraseNextEntries(fp, entry);
+          MarkChanged(EntryFingerprint(*entry), JournalRecord::UPDATE_ENTRY);
           return DONE;
         default:
           break;
@@ -692,6 +905,7 @@ UserHistoryPredictor::RemoveNgramChain(const string &target_key,
 
 bool UserHistoryPredictor::ClearHistoryEntry(const string &key,
                                              const string &value) {
+  scoped_writer_lock l(&dic_mutex_);
   bool deleted = false;
   {
     // Find the history entry that has the exactly same key and value and has
@@ -701,6 +915,7 @@ bool UserHistoryPredictor::ClearHistoryEntry(const string &key,
       entry->set_suggestion_freq(0);
       entry->set_conversion_freq(0);
       entry->set_removed(true);
+      MarkChanged(EntryFingerprint(*entry), JournalRecord::UPDATE_ENTRY);
       // We don't clear entry->next_entries() so that we can generate prediction
       // by chaining.
       deleted = true;
@@ -745,8 +960,8 @@ bool UserHistoryPredictor::HasBigramEntry(
 
 // static
 string UserHistoryPredictor::GetRomanMisspelledKey(
-    const Segments &segments) {
-  if (GET_CONFIG(preedit_method) != config::Config::ROMAN) {
+    const ConversionRequest &request, const Segments &segments) {
+  if (request.config().preedit_method() != config::Config::ROMAN) {
     return "";
   }
 
@@ -1141,7 +1356,7 @@ bool UserHistoryPredictor::PredictForRequest(const ConversionRequest &request,
     return false;
   }
 
-  if (GET_CONFIG(incognito_mode)) {
+  if (request.config().incognito_mode()) {
     VLOG(2) << "incognito mode";
     return false;
   }
@@ -1151,7 +1366,7 @@ bool UserHistoryPredictor::PredictForRequest(const ConversionRequest &request,
     return false;
   }
 
-  if (!GET_CONFIG(use_history_suggest) &&
+  if (!request.config().use_history_suggest() &&
       segments->request_type() == Segments::SUGGESTION) {
     VLOG(2) << "no history suggest";
     return false;
@@ -1162,6 +1377,7 @@ bool UserHistoryPredictor::PredictForRequest(const ConversionRequest &request,
     return false;
   }
 
+  scoped_reader_lock l(&dic_mutex_);
   if (dic_->Head() == NULL) {
     VLOG(2) << "dic head is NULL";
     return false;
@@ -1251,7 +1467,7 @@ void UserHistoryPredictor::GetResultsFromHistoryDictionary(
   const size_t max_results_size = 5 * segments.max_prediction_candidates_size();
 
   // Get romanized input key if the given preedit looks misspelled.
-  const string roman_input_key = GetRomanMisspelledKey(segments);
+  const string roman_input_key = GetRomanMisspelledKey(request, segments);
 
   // TODO(team): make GetKanaMisspelledKey(segments);
   // const string kana_input_key = GetKanaMisspelledKey(segments);
@@ -1278,10 +1494,21 @@ void UserHistoryPredictor::GetResultsFromHistoryDictionary(
   scoped_ptr<Trie<string> > expanded;
   GetInputKeyFromSegments(request, segments, &input_key, &base_key, &expanded);
 
+  // Only the entries found by |key_index_| can match the input, so we
+  // don't need to scan all the LRU.
+  vector<uint32> fps;
+  GetCandidateFingerprints(base_key, expanded.get(), roman_input_key,
+                           prev_entry, &fps);
+
   int trial = 0;
-  for (const DicElement *elm = dic_->Head(); elm != NULL; elm = elm->next) {
+  for (size_t i = 0; i < fps.size(); ++i) {
+    const Entry *entry = dic_->LookupWithoutInsert(fps[i]);
+    if (entry == NULL) {
+      LOG(DFATAL) << "key_index_ is out of sync: " << fps[i];
+      continue;
+    }
     if (!IsValidEntryIgnoringRemovedField(
-            elm->value, request.request().available_emoji_carrier())) {
+            *entry, request.request().available_emoji_carrier())) {
       continue;
     }
     if (segments.request_type() == Segments::SUGGESTION &&
@@ -1293,9 +1520,9 @@ void UserHistoryPredictor::GetResultsFromHistoryDictionary(
     // lookup key from elm_value and prev_entry.
     // If a new entry is found, the entry is pushed to the results.
     // TODO(team): make KanaFuzzyLookupEntry().
-    if (!LookupEntry(input_key, base_key, expanded.get(), &(elm->value),
+    if (!LookupEntry(input_key, base_key, expanded.get(), entry,
                      prev_entry, results) &&
-        !RomanFuzzyLookupEntry(roman_input_key, &(elm->value), results)) {
+        !RomanFuzzyLookupEntry(roman_input_key, entry, results)) {
       continue;
     }
 
@@ -1306,6 +1533,41 @@ void UserHistoryPredictor::GetResultsFromHistoryDictionary(
   }
 }
 
+void UserHistoryPredictor::GetCandidateFingerprints(
+    const string &base_key, const Trie<string> *key_expanded,
+    const string &roman_input_key, const Entry *prev_entry,
+    vector<uint32> *fps) const {
+  DCHECK(fps);
+  if (base_key.empty()) {
+    if (key_expanded != NULL) {
+      // The entry must start with one of the expanded keys.
+      vector<string> expanded_keys;
+      key_expanded->LookUpPredictiveAll("", &expanded_keys);
+      for (size_t i = 0; i < expanded_keys.size(); ++i) {
+        key_index_.LookupPredictive(expanded_keys[i], fps);
+      }
+    } else if (prev_entry != NULL) {
+      // Zero query suggestion. Only the entries linked from |prev_entry|
+      // can be the results.
+      for (size_t i = 0; i < prev_entry->next_entries_size(); ++i) {
+        fps->push_back(prev_entry->next_entries(i).entry_fp());
+      }
+    }
+  } else {
+    // Entries whose key is a prefix of |base_key| (RIGHT_PREFIX_MATCH and
+    // EXACT_MATCH) and entries whose key starts with |base_key|
+    // (LEFT_PREFIX_MATCH).
+    key_index_.LookupPrefix(base_key, fps);
+    key_index_.LookupPredictive(base_key, fps);
+  }
+
+  if (!roman_input_key.empty()) {
+    key_index_.LookupRomanFuzzy(roman_input_key, fps);
+  }
+
+  key_index_.SortByRecency(fps);
+}
+
 // static
 void UserHistoryPredictor::GetInputKeyFromSegments(
     const ConversionRequest &request, const Segments &segments,
@@ -1503,6 +1765,103 @@ bool UserHistoryPredictor::IsValidEntryIgnoringRemovedField(
   return true;
 }
 
+UserHistoryPredictor::DicElement *UserHistoryPredictor::InsertDicElement(
+    uint32 fp, const string &key) {
+  // LRUCache silently evicts the tail when it is full, so remember the tail
+  // to keep |key_index_| in sync.
+  const DicElement *tail = dic_->Tail();
+  const bool has_tail = (tail != NULL && tail->key != fp);
+  const uint32 tail_fp = has_tail ? tail->key : 0;
+
+  DicElement *e = dic_->Insert(fp);
+  if (has_tail && !dic_->HasKey(tail_fp)) {
+    key_index_.Erase(tail_fp);
+    MarkChanged(tail_fp, JournalRecord::ERASE_ENTRY);
+  }
+  if (e == NULL) {
+    key_index_.Erase(fp);
+    MarkChanged(fp, JournalRecord::ERASE_ENTRY);
+    return NULL;
+  }
+  key_index_.Insert(fp, key);
+  MarkChanged(fp, JournalRecord::PROMOTE_ENTRY);
+  return e;
+}
+
+bool UserHistoryPredictor::EraseDicElement(uint32 fp) {
+  key_index_.Erase(fp);
+  MarkChanged(fp, JournalRecord::ERASE_ENTRY);
+  return dic_->Erase(fp);
+}
+
+void UserHistoryPredictor::MarkChanged(uint32 fp, JournalRecord::Type type) {
+  scoped_lock l(&journal_mutex_);
+  if (type == JournalRecord::UPDATE_ENTRY) {
+    map<uint32, JournalRecord::Type>::const_iterator it =
+        pending_changes_.find(fp);
+    if (it != pending_changes_.end() &&
+        it->second == JournalRecord::PROMOTE_ENTRY) {
+      return;
+    }
+  }
+  pending_changes_[fp] = type;
+}
+
+bool UserHistoryPredictor::GetJournalRecords(
+    vector<JournalRecord> *records) const {
+  DCHECK(records);
+  records->clear();
+  size_t num_promoted = 0;
+  for (map<uint32, JournalRecord::Type>::const_iterator it =
+           pending_changes_.begin();
+       it != pending_changes_.end(); ++it) {
+    if (it->second == JournalRecord::PROMOTE_ENTRY) {
+      ++num_promoted;
+      continue;
+    }
+    records->push_back(JournalRecord());
+    JournalRecord *record = &records->back();
+    record->set_fingerprint(it->first);
+    const Entry *entry = dic_->LookupWithoutInsert(it->first);
+    if (it->second == JournalRecord::UPDATE_ENTRY && entry != NULL) {
+      record->set_type(JournalRecord::UPDATE_ENTRY);
+      record->mutable_entry()->CopyFrom(*entry);
+    } else {
+      record->set_type(JournalRecord::ERASE_ENTRY);
+    }
+  }
+
+  // Only the insertion moves an entry to the head of the LRU, so the
+  // promoted entries are the first |num_promoted| ones from the head.
+  vector<const DicElement *> promoted;
+  for (const DicElement *elm = dic_->Head();
+       elm != NULL && promoted.size() < num_promoted; elm = elm->next) {
+    map<uint32, JournalRecord::Type>::const_iterator it =
+        pending_changes_.find(elm->key);
+    if (it == pending_changes_.end() ||
+        it->second != JournalRecord::PROMOTE_ENTRY) {
+      LOG(ERROR) << "promoted entries are not at the head of LRU";
+      return false;
+    }
+    promoted.push_back(elm);
+  }
+  if (promoted.size() != num_promoted) {
+    LOG(ERROR) << "promoted entries are not found";
+    return false;
+  }
+
+  for (vector<const DicElement *>::reverse_iterator it = promoted.rbegin();
+       it != promoted.rend(); ++it) {
+    records->push_back(JournalRecord());
+    JournalRecord *record = &records->back();
+    record->set_type(JournalRecord::PROMOTE_ENTRY);
+    record->set_fingerprint((*it)->key);
+    record->mutable_entry()->CopyFrom((*it)->value);
+  }
+
+  return true;
+}
+
 void UserHistoryPredictor::InsertEvent(EntryType type) {
   if (type == Entry::DEFAULT_ENTRY) {
     return;
@@ -1512,7 +1871,7 @@ void UserHistoryPredictor::InsertEvent(EntryType type) {
   const uint32 dic_key = Fingerprint("", "", type);
 
   CHECK(dic_.get());
-  DicElement *e = dic_->Insert(dic_key);
+  DicElement *e = InsertDicElement(dic_key, "");
   if (e == NULL) {
     VLOG(2) << "insert failed";
     return;
@@ -1556,7 +1915,7 @@ void UserHistoryPredictor::Insert(const string &key,
     // add a treatment for UPDATE_ENTRY mode
   }
 
-  DicElement *e = dic_->Insert(dic_key);
+  DicElement *e = InsertDicElement(dic_key, key);
   if (e == NULL) {
     VLOG(2) << "insert failed";
     return;
@@ -1596,18 +1955,19 @@ void UserHistoryPredictor::Insert(const string &key,
   updated_ = true;
 }
 
-void UserHistoryPredictor::Finish(Segments *segments) {
+void UserHistoryPredictor::Finish(const ConversionRequest &request,
+                                  Segments *segments) {
   if (segments->request_type() == Segments::REVERSE_CONVERSION) {
     // Do nothing for REVERSE_CONVERSION.
     return;
   }
 
-  if (GET_CONFIG(incognito_mode)) {
+  if (request.config().incognito_mode()) {
     VLOG(2) << "incognito mode";
     return;
   }
 
-  if (!GET_CONFIG(use_history_suggest)) {
+  if (!request.config().use_history_suggest()) {
     VLOG(2) << "no history suggest";
     return;
   }
@@ -1617,6 +1977,7 @@ void UserHistoryPredictor::Finish(Segments *segments) {
     return;
   }
 
+  scoped_writer_lock l(&dic_mutex_);
   const bool is_suggestion = segments->request_type() != Segments::CONVERSION;
   const uint32 last_access_time = static_cast<uint32>(Util::GetTime());
 
@@ -1793,6 +2154,11 @@ void UserHistoryPredictor::InsertHistory(bool is_suggestion_selected,
                 learning_segments.history_segment(
                     segments->history_segments_size() - 1)));
 
+    if (history_entry != NULL) {
+      MarkChanged(EntryFingerprint(*history_entry),
+                  JournalRecord::UPDATE_ENTRY);
+    }
+
     NextEntry next_entry;
     if (segments->request_type() == Segments::CONVERSION) {
       next_entry.set_entry_fp(
@@ -1817,13 +2183,14 @@ void UserHistoryPredictor::Revert(Segments *segments) {
     return;
   }
 
+  scoped_writer_lock l(&dic_mutex_);
   for (size_t i = 0; i < segments->revert_entries_size(); ++i) {
     const Segments::RevertEntry &revert_entry =
         segments->revert_entry(i);
     if (revert_entry.id == UserHistoryPredictor::revert_id() &&
         revert_entry.revert_entry_type == Segments::RevertEntry::CREATE_ENTRY) {
       VLOG(2) << "Erasing the key: " << StringToUint32(revert_entry.key);
-      dic_->Erase(StringToUint32(revert_entry.key));
+      EraseDicElement(StringToUint32(revert_entry.key));
     }
   }
 }
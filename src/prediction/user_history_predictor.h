@@ -30,6 +30,7 @@
 #ifndef MOZC_PREDICTION_USER_HISTORY_PREDICTOR_H_
 #define MOZC_PREDICTION_USER_HISTORY_PREDICTOR_H_
 
+#include <map>
 #include <queue>
 #include <set>
 #include <string>
@@ -37,10 +38,12 @@
 #include <vector>
 
 #include "base/freelist.h"
+#include "base/mutex.h"
 #include "base/scoped_ptr.h"
 #include "base/string_piece.h"
 #include "base/trie.h"
 #include "prediction/predictor_interface.h"
+#include "prediction/user_history_key_index.h"
 #include "prediction/user_history_predictor.pb.h"
 #include "storage/lru_cache.h"
 // for FRIEND_TEST
@@ -49,6 +52,7 @@
 namespace mozc {
 
 namespace storage {
+class EncryptedJournalStorage;
 class StringStorageInterface;
 }  // namespace storage
 
@@ -61,26 +65,49 @@ class SuppressionDictionary;
 class UserHistoryPredictorSyncer;
 
 // Added serialization method for UserHistory.
+// The history is stored as a snapshot of all the entries and a journal of
+// the changes made after the snapshot, which is |filename| + ".journal".
 class UserHistoryStorage : public mozc::user_history_predictor::UserHistory {
  public:
+  typedef user_history_predictor::UserHistoryJournalRecord JournalRecord;
+
   explicit UserHistoryStorage(const string &filename);
   ~UserHistoryStorage();
 
-  // Load from encrypted file.
+  // Load from encrypted file, and applies the journal for the snapshot.
   bool Load();
 
-  // Save history into encrypted file.
-  bool Save() const;
+  // Save history into encrypted file as a new snapshot with a new
+  // snapshot_id, and removes the journal for the previous one.
+  bool Save();
+
+  // Appends |records| to the journal for the current snapshot_id.
+  bool AppendToJournal(const vector<JournalRecord> &records) const;
+
+  // Returns the number of journal records applied by Load().
+  size_t num_journal_records() const { return num_journal_records_; }
+
+  // Returns true if Load() found a broken journal record. The records after
+  // it are lost, so a new snapshot should be saved.
+  bool is_journal_broken() const { return is_journal_broken_; }
 
  private:
+  // Applies |records| to the entries, which are ordered from the tail of the
+  // LRU to the head.
+  void ApplyJournal(const vector<string> &records);
+
   scoped_ptr<storage::StringStorageInterface> storage_;
+  scoped_ptr<storage::EncryptedJournalStorage> journal_;
+  size_t num_journal_records_;
+  bool is_journal_broken_;
 };
 
-// UserHistoryPredictor is NOT thread safe.
-// Currently, all methods of UserHistoryPredictor is called
-// by single thread. Although AsyncSave() and AsyncLoad() make
-// worker threads internally, these two functions won't be
-// called by multiple-threads at the same time
+// UserHistoryPredictor can be shared by the threads converting with the same
+// engine. Predict() and PredictForRequest() only take a reader lock on the
+// history, so they run in parallel with each other. Finish(), Revert(),
+// Load() and the Clear*() methods take the writer lock. AsyncSave() and
+// AsyncLoad() make a worker thread internally; the syncer is guarded by its
+// own mutex.
 class UserHistoryPredictor : public PredictorInterface {
  public:
   UserHistoryPredictor(const DictionaryInterface *dictionary,
@@ -93,7 +120,7 @@ class UserHistoryPredictor : public PredictorInterface {
                                  Segments *segments) const;
 
   // Hook(s) for all mutable operations.
-  virtual void Finish(Segments *segments);
+  virtual void Finish(const ConversionRequest &request, Segments *segments);
 
   // Revert last Finish operation.
   virtual void Revert(Segments *segments);
@@ -202,6 +229,7 @@ class UserHistoryPredictor : public PredictorInterface {
   FRIEND_TEST(UserHistoryPredictorTest, UserHistoryPredictorTest);
   FRIEND_TEST(UserHistoryPredictorTest, UserHistoryPredictorTest_suggestion);
   FRIEND_TEST(UserHistoryPredictorTest, DescriptionTest);
+  FRIEND_TEST(UserHistoryPredictorTest, FinishFollowsConfigOfRequest);
   FRIEND_TEST(UserHistoryPredictorTest,
               UserHistoryPredictorUnusedHistoryTest);
   FRIEND_TEST(UserHistoryPredictorTest, UserHistoryPredictorRevertTest);
@@ -230,6 +258,9 @@ class UserHistoryPredictor : public PredictorInterface {
   FRIEND_TEST(UserHistoryPredictorTest, PrivacySensitiveTest);
   FRIEND_TEST(UserHistoryPredictorTest, PrivacySensitiveMultiSegmentsTest);
   FRIEND_TEST(UserHistoryPredictorTest, UserHistoryStorage);
+  FRIEND_TEST(UserHistoryPredictorTest, UserHistoryStorageJournal);
+  FRIEND_TEST(UserHistoryPredictorTest, SaveToJournal);
+  FRIEND_TEST(UserHistoryPredictorTest, RetrySaveAfterFailure);
   FRIEND_TEST(UserHistoryPredictorTest, RomanFuzzyPrefixMatch);
   FRIEND_TEST(UserHistoryPredictorTest, MaybeRomanMisspelledKey);
   FRIEND_TEST(UserHistoryPredictorTest, GetRomanMisspelledKey);
@@ -368,9 +399,37 @@ class UserHistoryPredictor : public PredictorInterface {
 
   typedef mozc::storage::LRUCache<uint32, Entry> DicCache;
   typedef DicCache::Element DicElement;
+  typedef UserHistoryStorage::JournalRecord JournalRecord;
 
   bool CheckSyncerAndDelete() const;
 
+  // Inserts |fp| into |dic_| and registers |key| to |key_index_|. Entries
+  // evicted from the LRU are unregistered from |key_index_| as well.
+  // The caller needs to set the value of the returned element.
+  DicElement *InsertDicElement(uint32 fp, const string &key);
+
+  // Erases |fp| from both |dic_| and |key_index_|.
+  bool EraseDicElement(uint32 fp);
+
+  // Records that the entry of |fp| was changed after the last Save(), so
+  // that Save() can append the change to the journal. PROMOTE_ENTRY is not
+  // overwritten by UPDATE_ENTRY, as the promoted entry is saved as a whole.
+  void MarkChanged(uint32 fp, JournalRecord::Type type);
+
+  // Makes the journal records of |pending_changes_|. The promoted entries are
+  // ordered from the tail of the LRU to the head, so that they are promoted
+  // in the same order when the journal is applied. Returns false if
+  // |pending_changes_| is inconsistent with |dic_|.
+  bool GetJournalRecords(vector<JournalRecord> *records) const;
+
+  // Collects the fingerprints of the entries which can be matched by
+  // LookupEntry() or RomanFuzzyLookupEntry(), in the LRU order.
+  void GetCandidateFingerprints(const string &base_key,
+                                const Trie<string> *key_expanded,
+                                const string &roman_input_key,
+                                const Entry *prev_entry,
+                                vector<uint32> *fps) const;
+
   // If |entry| is the target of prediction,
   // create a new result and insert it to |results|.
   // Can set |prev_entry| if there is a history segment just before |input_key|.
@@ -427,7 +486,8 @@ class UserHistoryPredictor : public PredictorInterface {
   // composer() if composer is available. If not, use the key
   // directory. It also use MaybeRomanMisspelledKey() defined
   // below to check the preedit looks missspelled or not.
-  static string GetRomanMisspelledKey(const Segments &segments);
+  static string GetRomanMisspelledKey(const ConversionRequest &request,
+                                      const Segments &segments);
 
   // return true if |key| may contain miss spelling.
   // Currently, this function returns true if
@@ -489,8 +549,26 @@ class UserHistoryPredictor : public PredictorInterface {
   const SuppressionDictionary *suppression_dictionary_;
   const string predictor_name_;
 
+  // Guards |updated_|, |dic_| and |key_index_|. Note that DicCache::Lookup
+  // reorders the LRU list, so predictions only use LookupWithoutInsert().
+  mutable ReaderWriterMutex dic_mutex_;
   bool updated_;
   scoped_ptr<DicCache> dic_;
+  UserHistoryKeyIndex key_index_;
+
+  // Guards the state of the journal. It is taken after |dic_mutex_|, so
+  // that Save() can take the changes while it only holds the reader lock.
+  Mutex journal_mutex_;
+  // The changes made after the last Save(), keyed by the fingerprint.
+  map<uint32, JournalRecord::Type> pending_changes_;
+  // The snapshot which the saved journal is for. 0 if not loaded or saved.
+  uint64 snapshot_id_;
+  size_t num_journal_records_;
+  // True if the next Save() needs to write a whole snapshot, e.g., when the
+  // history was cleared or the journal was broken.
+  bool needs_snapshot_;
+
+  mutable Mutex syncer_mutex_;
   mutable scoped_ptr<UserHistoryPredictorSyncer> syncer_;
 };
 }  // namespace mozc
@@ -31,6 +31,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "base/file_util.h"
 #include "base/logging.h"
@@ -38,6 +39,7 @@
 #include "base/password_manager.h"
 #include "base/port.h"
 #include "base/system_util.h"
+#include "base/thread.h"
 #include "base/util.h"
 #include "composer/composer.h"
 #include "composer/table.h"
@@ -130,6 +132,28 @@ bool FindCandidateByValue(const string &value, const Segments &segments) {
   }
   return false;
 }
+
+// Keeps suggesting from a UserHistoryPredictor shared with a learning thread.
+class PredictThread : public Thread {
+ public:
+  PredictThread(const UserHistoryPredictor *predictor, const string &key,
+                int num_trials)
+      : predictor_(predictor), key_(key), num_trials_(num_trials) {}
+
+  virtual void Run() {
+    const ConversionRequest conversion_request;
+    for (int i = 0; i < num_trials_; ++i) {
+      Segments segments;
+      MakeSegmentsForSuggestion(key_, &segments);
+      predictor_->PredictForRequest(conversion_request, &segments);
+    }
+  }
+
+ private:
+  const UserHistoryPredictor *predictor_;
+  const string key_;
+  const int num_trials_;
+};
 }   // anonymous namespace
 
 class UserHistoryPredictorTest : public ::testing::Test {
@@ -206,7 +230,8 @@ class UserHistoryPredictorTest : public ::testing::Test {
       UserHistoryPredictor *predictor,
       const string &key, const string &value) {
     UserHistoryPredictor::Entry *e =
-        &predictor->dic_->Insert(predictor->Fingerprint(key, value))->value;
+        &predictor->InsertDicElement(predictor->Fingerprint(key, value),
+                                     key)->value;
     e->set_key(key);
     e->set_value(value);
     e->set_removed(false);
@@ -310,7 +335,7 @@ class UserHistoryPredictorTest : public ::testing::Test {
 };
 
 TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTest) {
-  const ConversionRequest conversion_request;
+  ConversionRequest conversion_request;
 
   {
     UserHistoryPredictor *predictor = GetUserHistoryPredictor();
@@ -350,7 +375,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTest) {
           "\xE7\xA7\x81\xE3\x81\xAE\xE5\x90\x8D\xE5\x89\x8D"
           "\xE3\x81\xAF\xE4\xB8\xAD\xE9\x87\x8E\xE3\x81\xA7"
           "\xE3\x81\x99", &segments);
-      predictor->Finish(&segments);
+      predictor->Finish(ConversionRequest(), &segments);
 
       // "わたしの"
       MakeSegmentsForSuggestion(
@@ -391,6 +416,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTest) {
       config::Config config;
       config.set_use_history_suggest(false);
       config::ConfigHandler::SetConfig(config);
+      conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
       // "わたしの"
       MakeSegmentsForSuggestion(
@@ -400,6 +426,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTest) {
       config.set_use_history_suggest(true);
       config.set_incognito_mode(true);
       config::ConfigHandler::SetConfig(config);
+      conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
       // "わたしの"
       MakeSegmentsForSuggestion(
@@ -411,6 +438,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTest) {
     {
       config::Config config;
       config::ConfigHandler::SetConfig(config);
+      conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
     }
 
     // reproducesd
@@ -522,7 +550,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTest_suggestion) {
     MakeSegmentsForSuggestion("\xE3\x81\xBE", &segments);
     // "摩"
     AddCandidate(1, "\xE6\x91\xA9", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
 
     // All added items must be suggestion entries.
     const UserHistoryPredictor::DicCache::Element *element;
@@ -567,7 +595,7 @@ TEST_F(UserHistoryPredictorTest, DescriptionTest) {
   const char kDescription[] = "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88";
 #endif  // DEBUG
 
-  const ConversionRequest conversion_request;
+  ConversionRequest conversion_request;
 
   {
     UserHistoryPredictor *predictor = GetUserHistoryPredictor();
@@ -589,7 +617,7 @@ TEST_F(UserHistoryPredictorTest, DescriptionTest) {
           "\xE3\x81\x99",
           kDescription,
           &segments);
-      predictor->Finish(&segments);
+      predictor->Finish(ConversionRequest(), &segments);
 
       // "わたしの"
       MakeSegmentsForSuggestion(
@@ -631,6 +659,7 @@ TEST_F(UserHistoryPredictorTest, DescriptionTest) {
       config::Config config;
       config.set_use_history_suggest(false);
       config::ConfigHandler::SetConfig(config);
+      conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
       predictor->WaitForSyncer();
 
       // "わたしの"
@@ -641,6 +670,7 @@ TEST_F(UserHistoryPredictorTest, DescriptionTest) {
       config.set_use_history_suggest(true);
       config.set_incognito_mode(true);
       config::ConfigHandler::SetConfig(config);
+      conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
       // "わたしの"
       MakeSegmentsForSuggestion(
@@ -652,6 +682,7 @@ TEST_F(UserHistoryPredictorTest, DescriptionTest) {
     {
       config::Config config;
       config::ConfigHandler::SetConfig(config);
+      conversion_request.set_config(config::ConfigHandler::GetConfigSnapshot());
       predictor->WaitForSyncer();
     }
 
@@ -747,6 +778,50 @@ TEST_F(UserHistoryPredictorTest, DescriptionTest) {
   }
 }
 
+TEST_F(UserHistoryPredictorTest, FinishFollowsConfigOfRequest) {
+  UserHistoryPredictor *predictor =
+      GetUserHistoryPredictorWithClearedHistory();
+
+  config::Config incognito_config;
+  config::ConfigHandler::GetDefaultConfig(&incognito_config);
+  incognito_config.set_incognito_mode(true);
+  ConversionRequest incognito_request;
+  incognito_request.set_config(config::ConfigSnapshot(incognito_config));
+
+  config::Config no_history_config;
+  config::ConfigHandler::GetDefaultConfig(&no_history_config);
+  no_history_config.set_use_history_suggest(false);
+  ConversionRequest no_history_request;
+  no_history_request.set_config(config::ConfigSnapshot(no_history_config));
+
+  // The global config allows learning, but the configs of the requests
+  // don't.
+  Segments segments;
+  MakeSegmentsForConversion("abc", &segments);
+  AddCandidate("ABC", &segments);
+  predictor->Finish(incognito_request, &segments);
+  predictor->Finish(no_history_request, &segments);
+  EXPECT_TRUE(predictor->dic_->Head() == NULL);
+
+  // The request allows learning while the global config is in incognito
+  // mode, e.g., when another session has turned it on.
+  config::ConfigHandler::SetConfig(incognito_config);
+  config::Config default_config;
+  config::ConfigHandler::GetDefaultConfig(&default_config);
+  ConversionRequest default_request;
+  default_request.set_config(config::ConfigSnapshot(default_config));
+  predictor->Finish(default_request, &segments);
+  ASSERT_TRUE(predictor->dic_->Head() != NULL);
+  EXPECT_EQ("abc", predictor->dic_->Head()->value.key());
+
+  // The learned entry is saved regardless of the global config.
+  ASSERT_TRUE(predictor->Save());
+  UserHistoryStorage history(UserHistoryPredictor::GetUserHistoryFileName());
+  ASSERT_TRUE(history.Load());
+  ASSERT_LT(0, history.entries_size());
+  EXPECT_EQ("abc", history.entries(history.entries_size() - 1).key());
+}
+
 TEST_F(UserHistoryPredictorTest, UserHistoryPredictorUnusedHistoryTest) {
   {
     UserHistoryPredictor *predictor = GetUserHistoryPredictor();
@@ -767,7 +842,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorUnusedHistoryTest) {
 
     // once
     segments.set_request_type(Segments::SUGGESTION);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
 
     segments.Clear();
     // "ひろすえりょうこ"
@@ -780,7 +855,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorUnusedHistoryTest) {
     segments.set_request_type(Segments::CONVERSION);
 
     // conversion
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
 
     // sync
     predictor->Sync();
@@ -872,7 +947,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorRevertTest) {
       "\xE3\x81\xAF\xE4\xB8\xAD\xE9\x87\x8E\xE3\x81\xA7"
       "\xE3\x81\x99", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   // Before Revert, Suggest works
   // "わたしの"
@@ -910,7 +985,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorClearTest) {
     // "テストテスト"
     AddCandidate("\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88"
                  "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
   }
 
   predictor->ClearAllHistory();
@@ -923,7 +998,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorClearTest) {
     // "テストテスト"
     AddCandidate("\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88"
                  "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
   }
 
   // frequency is cleared as well.
@@ -964,7 +1039,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorTailingPunctuation) {
   MakeSegmentsForConversion("\xE3\x80\x82", &segments);
   AddCandidate(1, "\xE3\x80\x82", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
   // "わたしの"
@@ -1026,7 +1101,7 @@ TEST_F(UserHistoryPredictorTest, UserHistoryPredictorPreceedingPunctuation) {
       "\xE3\x81\xAF\xE4\xB8\xAD\xE9\x87\x8E\xE3\x81\xA7"
       "\xE3\x81\x99", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
   // "わたしの"
@@ -1095,7 +1170,7 @@ TEST_F(UserHistoryPredictorTest, StartsWithPunctuations) {
                    "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88"
                    "\xe6\x96\x87\xe7\xab\xa0",
                    &segments);
-      predictor->Finish(&segments);
+      predictor->Finish(ConversionRequest(), &segments);
     }
     segments.Clear();
     {
@@ -1110,7 +1185,7 @@ TEST_F(UserHistoryPredictorTest, StartsWithPunctuations) {
                    first_char +
                    "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88"
                    "\xe6\x96\x87\xe7\xab\xa0", &segments);
-      predictor->Finish(&segments);
+      predictor->Finish(ConversionRequest(), &segments);
     }
     segments.Clear();
     {
@@ -1158,14 +1233,14 @@ TEST_F(UserHistoryPredictorTest, ZeroQuerySuggestionTest) {
     MakeSegmentsForConversion("\xE3\x81\x9F\xE3\x82\x8D"
                               "\xE3\x81\x86\xE3\x81\xAF", &segments);
     AddCandidate(0, "\xE5\xA4\xAA\xE9\x83\x8E\xE3\x81\xAF", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
     segments.mutable_segment(0)->set_segment_type(Segment::HISTORY);
 
     // "はなこに/花子に"
     MakeSegmentsForConversion("\xE3\x81\xAF\xE3\x81\xAA"
                               "\xE3\x81\x93\xE3\x81\xAB", &segments);
     AddCandidate(1, "\xE8\x8A\xB1\xE5\xAD\x90\xE3\x81\xAB", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
     segments.mutable_segment(1)->set_segment_type(Segment::HISTORY);
 
     // "きょうと/京都"
@@ -1176,7 +1251,7 @@ TEST_F(UserHistoryPredictorTest, ZeroQuerySuggestionTest) {
     AddCandidate(1, "\xE4\xBA\xAC\xE9\x83\xBD",
                  &segments);
     Util::Sleep(2000);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
     segments.mutable_segment(1)->set_segment_type(Segment::HISTORY);
 
     // "おおさか/大阪"
@@ -1187,7 +1262,7 @@ TEST_F(UserHistoryPredictorTest, ZeroQuerySuggestionTest) {
     AddCandidate(1, "\xE5\xA4\xA7\xE9\x98\xAA",
                  &segments);
     Util::Sleep(2000);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
     segments.mutable_segment(1)->set_segment_type(Segment::HISTORY);
 
     // Zero query suggestion is disabled.
@@ -1242,7 +1317,7 @@ TEST_F(UserHistoryPredictorTest, ZeroQuerySuggestionTest) {
     MakeSegmentsForConversion("\xE3\x81\xAF\xE3\x81\xAA"
                               "\xE3\x81\x93\xE3\x81\xAB", &segments);
     AddCandidate(1, "\xE8\x8A\xB1\xE5\xAD\x90\xE3\x81\xAB", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
 
     segments.Clear();
     // "たろうは/太郎は"
@@ -1284,14 +1359,14 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsMultiInput) {
   MakeSegmentsForConversion("\xE3\x81\x9F\xE3\x82\x8D"
                             "\xE3\x81\x86\xE3\x81\xAF", &segments);
   AddCandidate(0, "\xE5\xA4\xAA\xE9\x83\x8E\xE3\x81\xAF", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(0)->set_segment_type(Segment::HISTORY);
 
   // "はなこに/花子に"
   MakeSegmentsForConversion("\xE3\x81\xAF\xE3\x81\xAA"
                             "\xE3\x81\x93\xE3\x81\xAB", &segments);
   AddCandidate(1, "\xE8\x8A\xB1\xE5\xAD\x90\xE3\x81\xAB", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(1)->set_segment_type(Segment::HISTORY);
 
   // "むずかしい/難しい"
@@ -1300,7 +1375,7 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsMultiInput) {
                             "\xE3\x81\x8B\xE3\x81\x97"
                             "\xE3\x81\x84", &segments);
   AddCandidate(2, "\xE9\x9B\xA3\xE3\x81\x97\xE3\x81\x84", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(2)->set_segment_type(Segment::HISTORY);
 
   // "ほんを/本を"
@@ -1308,7 +1383,7 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsMultiInput) {
   MakeSegmentsForConversion("\xE3\x81\xBB"
                             "\xE3\x82\x93\xE3\x82\x92", &segments);
   AddCandidate(3, "\xE6\x9C\xAC\xE3\x82\x92", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(3)->set_segment_type(Segment::HISTORY);
 
   // "よませた/読ませた"
@@ -1317,7 +1392,7 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsMultiInput) {
                             "\xE3\x81\x9B\xE3\x81\x9F", &segments);
   AddCandidate(4, "\xE8\xAA\xAD\xE3\x81\xBE"
                "\xE3\x81\x9B\xE3\x81\x9F", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   // "た", Too short inputs
   segments.Clear();
@@ -1377,13 +1452,13 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsMultiInput) {
   MakeSegmentsForConversion("\xE3\x81\x9F\xE3\x82\x8D"
                             "\xE3\x81\x86\xE3\x81\xAF", &segments);
   AddCandidate(0, "\xE5\xA4\xAA\xE9\x83\x8E\xE3\x81\xAF", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(0)->set_segment_type(Segment::HISTORY);
 
   MakeSegmentsForConversion("\xE3\x82\x88\xE3\x81\x97"
                             "\xE3\x81\x93\xE3\x81\xAB", &segments);
   AddCandidate(1, "\xE8\x89\xAF\xE5\xAD\x90\xE3\x81\xAB", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(1)->set_segment_type(Segment::HISTORY);
 
   // "たろうは"
@@ -1430,7 +1505,7 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsSingleInput) {
   AddCandidate(4, "\xE8\xAA\xAD\xE3\x81\xBE"
                "\xE3\x81\x9B\xE3\x81\x9F", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   // "たろうは"
   segments.Clear();
@@ -1491,13 +1566,13 @@ TEST_F(UserHistoryPredictorTest, MultiSegmentsSingleInput) {
   MakeSegmentsForConversion("\xE3\x81\x9F\xE3\x82\x8D"
                             "\xE3\x81\x86\xE3\x81\xAF", &segments);
   AddCandidate(0, "\xE5\xA4\xAA\xE9\x83\x8E\xE3\x81\xAF", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(0)->set_segment_type(Segment::HISTORY);
 
   MakeSegmentsForConversion("\xE3\x82\x88\xE3\x81\x97"
                             "\xE3\x81\x93\xE3\x81\xAB", &segments);
   AddCandidate(1, "\xE8\x89\xAF\xE5\xAD\x90\xE3\x81\xAB", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(1)->set_segment_type(Segment::HISTORY);
 
   // "たろうは"
@@ -1542,7 +1617,7 @@ TEST_F(UserHistoryPredictorTest, Regression2843371_Case1) {
   MakeSegmentsForConversion("\xE3\x80\x82", &segments);
   AddCandidate(3, "\xE3\x80\x82", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
 
@@ -1572,7 +1647,7 @@ TEST_F(UserHistoryPredictorTest, Regression2843371_Case1) {
   MakeSegmentsForConversion("\xE3\x80\x82", &segments);
   AddCandidate(3, "\xE3\x80\x82", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
 
@@ -1650,7 +1725,7 @@ TEST_F(UserHistoryPredictorTest, Regression2843371_Case2) {
   MakeSegmentsForConversion("\xE3\x80\x82", &segments);
   AddCandidate(10, "\xE3\x80\x82", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
 
@@ -1700,7 +1775,7 @@ TEST_F(UserHistoryPredictorTest, Regression2843371_Case3) {
   MakeSegmentsForConversion("\xE3\x80\x82", &segments);
   AddCandidate(5, "\xE3\x80\x82", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   Util::Sleep(2000);
 
@@ -1730,7 +1805,7 @@ TEST_F(UserHistoryPredictorTest, Regression2843371_Case3) {
   MakeSegmentsForConversion("\xE3\x80\x82", &segments);
   AddCandidate(5, "\xE3\x80\x82", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
 
@@ -1775,7 +1850,7 @@ TEST_F(UserHistoryPredictorTest, Regression2843775) {
                "\xE9\xA1\x98\xE3\x81\x84"
                "\xE3\x81\x97\xE3\x81\xBE\xE3\x81\x99", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
 
@@ -1847,7 +1922,7 @@ TEST_F(UserHistoryPredictorTest, DuplicateString) {
   MakeSegmentsForConversion("\xEF\xBC\x89", &segments);
   AddCandidate(7, "\xEF\xBC\x89", &segments);
 
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
 
   segments.Clear();
 
@@ -1928,7 +2003,7 @@ TEST_F(UserHistoryPredictorTest, SyncTest) {
         segments.Clear();
         MakeSegmentsForConversion(commands[i].key, &segments);
         AddCandidate(commands[i].value, &segments);
-        predictor->Finish(&segments);
+        predictor->Finish(ConversionRequest(), &segments);
         break;
       case Command::LOOKUP:
         segments.Clear();
@@ -2468,7 +2543,7 @@ TEST_F(UserHistoryPredictorTest, PrivacySensitiveTest) {
       Segments segments;
       MakeSegmentsForConversion(input, &segments);
       AddCandidate(0, output, &segments);
-      predictor->Finish(&segments);
+      predictor->Finish(ConversionRequest(), &segments);
     }
 
     // TODO(yukawa): Refactor the scenario runner below by making
@@ -2533,7 +2608,7 @@ TEST_F(UserHistoryPredictorTest, PrivacySensitiveMultiSegmentsTest) {
     MakeSegmentsForConversion("abc!", &segments);
     AddCandidate(0, "123", &segments);
     AddCandidate(1, "abc!", &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
   }
 
   {
@@ -2573,6 +2648,133 @@ TEST_F(UserHistoryPredictorTest, UserHistoryStorage) {
   FileUtil::Unlink(filename);
 }
 
+TEST_F(UserHistoryPredictorTest, UserHistoryStorageJournal) {
+  const string filename =
+      FileUtil::JoinPath(SystemUtil::GetUserProfileDirectory(), "test");
+  const string journal_filename = filename + ".journal";
+
+  // Entries are ordered from the tail of LRU to the head.
+  UserHistoryStorage storage1(filename);
+  const char *kKeys[] = { "a", "b", "c" };
+  for (size_t i = 0; i < arraysize(kKeys); ++i) {
+    UserHistoryPredictor::Entry *entry = storage1.add_entries();
+    entry->set_key(kKeys[i]);
+    entry->set_value(kKeys[i]);
+  }
+  ASSERT_TRUE(storage1.Save());
+  EXPECT_NE(0, storage1.snapshot_id());
+
+  vector<UserHistoryStorage::JournalRecord> records(3);
+  records[0].set_type(UserHistoryStorage::JournalRecord::UPDATE_ENTRY);
+  records[0].set_fingerprint(UserHistoryPredictor::Fingerprint("b", "b"));
+  records[0].mutable_entry()->CopyFrom(storage1.entries(1));
+  records[0].mutable_entry()->set_suggestion_freq(10);
+  records[1].set_type(UserHistoryStorage::JournalRecord::PROMOTE_ENTRY);
+  records[1].set_fingerprint(UserHistoryPredictor::Fingerprint("a", "a"));
+  records[1].mutable_entry()->CopyFrom(storage1.entries(0));
+  records[2].set_type(UserHistoryStorage::JournalRecord::ERASE_ENTRY);
+  records[2].set_fingerprint(UserHistoryPredictor::Fingerprint("c", "c"));
+  ASSERT_TRUE(storage1.AppendToJournal(records));
+  EXPECT_TRUE(FileUtil::FileExists(journal_filename));
+
+  UserHistoryStorage storage2(filename);
+  ASSERT_TRUE(storage2.Load());
+  EXPECT_EQ(storage1.snapshot_id(), storage2.snapshot_id());
+  EXPECT_EQ(3, storage2.num_journal_records());
+  EXPECT_FALSE(storage2.is_journal_broken());
+  ASSERT_EQ(2, storage2.entries_size());
+  EXPECT_EQ("b", storage2.entries(0).key());
+  EXPECT_EQ(10, storage2.entries(0).suggestion_freq());
+  EXPECT_EQ("a", storage2.entries(1).key());
+
+  // A new snapshot discards the journal.
+  ASSERT_TRUE(storage1.Save());
+  EXPECT_FALSE(FileUtil::FileExists(journal_filename));
+  UserHistoryStorage storage3(filename);
+  ASSERT_TRUE(storage3.Load());
+  EXPECT_EQ(0, storage3.num_journal_records());
+  EXPECT_EQ(storage1.DebugString(), storage3.DebugString());
+
+  FileUtil::Unlink(filename);
+}
+
+TEST_F(UserHistoryPredictorTest, SaveToJournal) {
+  UserHistoryPredictor *predictor =
+      GetUserHistoryPredictorWithClearedHistory();
+
+  Segments segments;
+  MakeSegmentsForConversion("abc", &segments);
+  AddCandidate("ABC", &segments);
+  predictor->Finish(ConversionRequest(), &segments);
+  segments.Clear();
+  MakeSegmentsForConversion("def", &segments);
+  AddCandidate("DEF", &segments);
+  predictor->Finish(ConversionRequest(), &segments);
+
+  // ClearAllHistory() saved a snapshot, so only the changes after it are
+  // appended to the journal.
+  ASSERT_TRUE(predictor->Save());
+  EXPECT_NE(0, predictor->snapshot_id_);
+  EXPECT_FALSE(predictor->needs_snapshot_);
+  EXPECT_EQ(2, predictor->num_journal_records_);
+
+  segments.Clear();
+  MakeSegmentsForConversion("abc", &segments);
+  AddCandidate("ABC", &segments);
+  predictor->Finish(ConversionRequest(), &segments);
+  EXPECT_TRUE(predictor->ClearHistoryEntry("def", "DEF"));
+  ASSERT_TRUE(predictor->Save());
+  EXPECT_EQ(4, predictor->num_journal_records_);
+
+  UserHistoryStorage history(UserHistoryPredictor::GetUserHistoryFileName());
+  ASSERT_TRUE(history.Load());
+  EXPECT_EQ(predictor->snapshot_id_, history.snapshot_id());
+  EXPECT_EQ(4, history.num_journal_records());
+  ASSERT_EQ(3, history.entries_size());
+  EXPECT_EQ(UserHistoryPredictor::Entry::CLEAN_ALL_EVENT,
+            history.entries(0).entry_type());
+  EXPECT_EQ("def", history.entries(1).key());
+  EXPECT_TRUE(history.entries(1).removed());
+  EXPECT_EQ("abc", history.entries(2).key());
+  EXPECT_EQ(2, history.entries(2).conversion_freq());
+
+  // ClearAllHistory() needs a new snapshot.
+  predictor->ClearAllHistory();
+  predictor->WaitForSyncer();
+  EXPECT_EQ(0, predictor->num_journal_records_);
+  EXPECT_NE(history.snapshot_id(), predictor->snapshot_id_);
+}
+
+TEST_F(UserHistoryPredictorTest, RetrySaveAfterFailure) {
+  UserHistoryPredictor *predictor =
+      GetUserHistoryPredictorWithClearedHistory();
+  const string filename = UserHistoryPredictor::GetUserHistoryFileName();
+
+  Segments segments;
+  MakeSegmentsForConversion("abc", &segments);
+  AddCandidate("ABC", &segments);
+  predictor->Finish(ConversionRequest(), &segments);
+
+  // The temporary file of the snapshot cannot be created.
+  predictor->needs_snapshot_ = true;
+  const string tmp_filename = filename + ".tmp";
+  ASSERT_TRUE(FileUtil::CreateDirectory(tmp_filename));
+  EXPECT_FALSE(predictor->Save());
+  EXPECT_TRUE(predictor->updated_);
+  EXPECT_TRUE(predictor->needs_snapshot_);
+
+  // The changes are saved by the next Save().
+  ASSERT_TRUE(FileUtil::RemoveDirectory(tmp_filename));
+  EXPECT_TRUE(predictor->Save());
+  EXPECT_FALSE(predictor->updated_);
+  EXPECT_FALSE(predictor->needs_snapshot_);
+
+  UserHistoryStorage history(filename);
+  ASSERT_TRUE(history.Load());
+  ASSERT_EQ(2, history.entries_size());
+  EXPECT_EQ("abc", history.entries(1).key());
+}
+
 TEST_F(UserHistoryPredictorTest, RomanFuzzyPrefixMatch) {
   // same
   EXPECT_FALSE(UserHistoryPredictor::RomanFuzzyPrefixMatch("abc", "abc"));
@@ -2703,31 +2905,35 @@ TEST_F(UserHistoryPredictorTest, GetRomanMisspelledKey) {
   Segment::Candidate *candidate = seg->add_candidate();
   candidate->value = "test";
 
+  // The preedit method is taken from the config of the request.
   config::Config config;
   config.set_preedit_method(config::Config::ROMAN);
-  config::ConfigHandler::SetConfig(config);
+  ConversionRequest request;
+  request.set_config(config::ConfigSnapshot(config));
 
   seg->set_key("");
-  EXPECT_EQ("", UserHistoryPredictor::GetRomanMisspelledKey(segments));
+  EXPECT_EQ("",
+            UserHistoryPredictor::GetRomanMisspelledKey(request, segments));
 
   //  seg->set_key("おねがいしまうs");
   seg->set_key("\xE3\x81\x8A\xE3\x81\xAD\xE3\x81\x8C"
                "\xE3\x81\x84\xE3\x81\x97\xE3\x81\xBE\xE3\x81\x86s");
   EXPECT_EQ("onegaisimaus",
-            UserHistoryPredictor::GetRomanMisspelledKey(segments));
+            UserHistoryPredictor::GetRomanMisspelledKey(request, segments));
 
   //  seg->set_key("おねがいします");
   seg->set_key("\xE3\x81\x8A\xE3\x81\xAD\xE3\x81\x8C"
                "\xE3\x81\x84\xE3\x81\x97\xE3\x81\xBE\xE3\x81\x99");
-  EXPECT_EQ("", UserHistoryPredictor::GetRomanMisspelledKey(segments));
+  EXPECT_EQ("",
+            UserHistoryPredictor::GetRomanMisspelledKey(request, segments));
 
   config.set_preedit_method(config::Config::KANA);
-  config::ConfigHandler::SetConfig(config);
 
   //  seg->set_key("おねがいします");
   seg->set_key("\xE3\x81\x8A\xE3\x81\xAD\xE3\x81\x8C"
                "\xE3\x81\x84\xE3\x81\x97\xE3\x81\xBE\xE3\x81\x99");
-  EXPECT_EQ("", UserHistoryPredictor::GetRomanMisspelledKey(segments));
+  EXPECT_EQ("",
+            UserHistoryPredictor::GetRomanMisspelledKey(request, segments));
 }
 
 
@@ -3515,7 +3721,7 @@ TEST_F(UserHistoryPredictorTest, RealtimeConversionInnerSegment) {
     // "なかのです, 中野です"
     candidate->inner_segment_boundary.push_back(pair<int, int>(5, 4));
   }
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.Clear();
 
   // "なかの"
@@ -3569,7 +3775,7 @@ TEST_F(UserHistoryPredictorTest, ZeroQueryFromRealtimeConversion) {
     // "なかのです, 中野です"
     candidate->inner_segment_boundary.push_back(pair<int, int>(5, 4));
   }
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.Clear();
 
   // "わたしの"
@@ -3577,7 +3783,7 @@ TEST_F(UserHistoryPredictorTest, ZeroQueryFromRealtimeConversion) {
       "\xe3\x82\x8f\xe3\x81\x9f\xe3\x81\x97\xe3\x81\xae", &segments);
   // "私の"
   AddCandidate(0, "\xe7\xa7\x81\xe3\x81\xae", &segments);
-  predictor->Finish(&segments);
+  predictor->Finish(ConversionRequest(), &segments);
   segments.mutable_segment(0)->set_segment_type(Segment::HISTORY);
 
   MakeSegmentsForSuggestion("", &segments);   // empty request
@@ -3619,7 +3825,7 @@ TEST_F(UserHistoryPredictorTest, LongCandidateForMobile) {
     candidate->content_value = kValue;
     candidate->key = kKey;
     candidate->content_key = kKey;
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
     segments.Clear();
   }
 
@@ -4203,7 +4409,7 @@ TEST_F(UserHistoryPredictorTest, ClearHistoryEntry_Scenario1) {
     AddCandidate(
         "\xE3\x82\xB0\xE3\x83\xBC\xE3\x82\xB0\x72",  // "グーグr"
         &segments);
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
   }
 
   // Test if the predictor learned "グーグr".
@@ -4285,7 +4491,7 @@ TEST_F(UserHistoryPredictorTest, ClearHistoryEntry_Scenario2) {
     candidate->key = seg->key();
     candidate->content_key = seg->key();
 
-    predictor->Finish(&segments);
+    predictor->Finish(ConversionRequest(), &segments);
   }
 
   // Check if the predictor learned the sentence.  Since the symbol is contained
@@ -4342,4 +4548,41 @@ TEST_F(UserHistoryPredictorTest, ClearHistoryEntry_Scenario2) {
       "\xE3\x81\x84\xE5\xA4\xA9\xE6\xB0\x97\x21"));
 }
 
+TEST_F(UserHistoryPredictorTest, PredictWhileLearning) {
+  UserHistoryPredictor *predictor =
+      GetUserHistoryPredictorWithClearedHistory();
+
+  // "きょう"
+  const string kPrefix = "\xE3\x81\x8D\xE3\x82\x87\xE3\x81\x86";
+  const int kNumThreads = 4;
+  vector<PredictThread *> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new PredictThread(predictor, kPrefix, 200));
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Start();
+  }
+
+  // Learns new entries while the other threads are suggesting.
+  for (int i = 0; i < 200; ++i) {
+    Segments segments;
+    // "きょうは"
+    MakeSegmentsForConversion(kPrefix + "\xE3\x81\xAF", &segments);
+    // "今日は<i>"
+    AddCandidate(Util::StringPrintf("\xE4\xBB\x8A\xE6\x97\xA5\xE3\x81\xAF%d",
+                                    i),
+                 &segments);
+    predictor->Finish(ConversionRequest(), &segments);
+  }
+
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  // "今日は199"
+  EXPECT_TRUE(IsSuggestedAndPredicted(
+      predictor, kPrefix, "\xE4\xBB\x8A\xE6\x97\xA5\xE3\x81\xAF" "199"));
+}
+
 }  // namespace mozc
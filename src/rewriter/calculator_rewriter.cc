@@ -35,7 +35,6 @@
 #include "base/logging.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/converter_interface.h"
 #include "converter/segments.h"
@@ -59,7 +58,7 @@ CalculatorRewriter::~CalculatorRewriter() {}
 //            a valid expression.
 bool CalculatorRewriter::Rewrite(const ConversionRequest &request,
                                  Segments *segments) const {
-  if (!GET_CONFIG(use_calculator)) {
+  if (!request.config().use_calculator()) {
     return false;
   }
 
@@ -256,7 +256,7 @@ TEST_F(CalculatorRewriterTest, ConfigTest) {
   config::ConfigHandler::GetDefaultConfig(&config);
 
   calculator_mock().SetCalculatePair("1+1=", "2", true);
-  const ConversionRequest request;
+  ConversionRequest request;
 
   // Since this test depends on the actual implementation of
   // Converter::ResizeSegments(), we cannot use converter mock here. However,
@@ -272,6 +272,7 @@ TEST_F(CalculatorRewriterTest, ConfigTest) {
     AddSegment("=", "=", &segments);
     config.set_use_calculator(true);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     EXPECT_TRUE(calculator_rewriter->Rewrite(request, &segments));
   }
 
@@ -283,6 +284,7 @@ TEST_F(CalculatorRewriterTest, ConfigTest) {
     AddSegment("=", "=", &segments);
     config.set_use_calculator(false);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     EXPECT_FALSE(calculator_rewriter->Rewrite(request, &segments));
   }
 }
@@ -33,6 +33,9 @@
 #include "rewriter/rewriter_interface.h"
 
 namespace mozc {
+namespace config {
+class Config;
+}  // namespace config
 
 class ConversionRequest;
 class Segments;
@@ -50,13 +53,14 @@ class CommandRewriter : public RewriterInterface  {
                        Segments *segments) const;
 
  private:
-  bool RewriteSegment(Segment *segment) const;
+  bool RewriteSegment(const config::Config &config, Segment *segment) const;
 
   // Insert a new IncogitoModeToggle Command candidate.
   // Use segment->candidate(base_pos) as a reference candidate.
   // |insert_pos| is the actual position where the new candidate
   // is inserted.
-  void InsertIncognitoModeToggleCommand(Segment *segment,
+  void InsertIncognitoModeToggleCommand(const config::Config &config,
+                                        Segment *segment,
                                         size_t reference_pos,
                                         size_t insert_pos) const;
 
@@ -64,7 +68,8 @@ class CommandRewriter : public RewriterInterface  {
   // Use segment->candidate(base_pos) as a reference candidate.
   // |insert_pos| is the actual position where the new candidate
   // is inserted.
-  void InsertDisableAllSuggestionToggleCommand(Segment *segment,
+  void InsertDisableAllSuggestionToggleCommand(const config::Config &config,
+                                               Segment *segment,
                                                size_t reference_pos,
                                                size_t insert_pos) const;
 };
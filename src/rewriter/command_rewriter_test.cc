@@ -157,7 +157,7 @@ TEST_F(CommandRewriterTest, ValueCheck) {
   CommandRewriter rewriter;
   Segments segments;
   config::Config config;
-  const ConversionRequest request;
+  ConversionRequest request;
 
   Segment *seg = segments.push_back_segment();
 
@@ -171,6 +171,7 @@ TEST_F(CommandRewriterTest, ValueCheck) {
         "\xE3\x82\xB9\xE3\x83\x88";
     config.set_presentation_mode(false);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     EXPECT_TRUE(rewriter.Rewrite(request, &segments));
     // EXPECT_EQ("サジェスト機能の一時停止",
     // GetCommandCandidateValue(*seg));
@@ -192,6 +193,7 @@ TEST_F(CommandRewriterTest, ValueCheck) {
         "\xE3\x82\xB9\xE3\x83\x88";
     config.set_presentation_mode(true);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     EXPECT_TRUE(rewriter.Rewrite(request, &segments));
     // EXPECT_EQ("サジェスト機能を元に戻す",
     // GetCommandCandidateValue(*seg));
@@ -211,6 +213,7 @@ TEST_F(CommandRewriterTest, ValueCheck) {
     candidate->value = "\xE7\xA7\x98\xE5\xAF\x86";
     config.set_incognito_mode(false);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     EXPECT_TRUE(rewriter.Rewrite(request, &segments));
     // EXPECT_EQ("シークレットモードをオン",
     // GetCommandCandidateValue(*seg));
@@ -230,6 +233,7 @@ TEST_F(CommandRewriterTest, ValueCheck) {
     candidate->value = "\xE7\xA7\x98\xE5\xAF\x86";
     config.set_incognito_mode(true);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     EXPECT_TRUE(rewriter.Rewrite(request, &segments));
     // EXPECT_EQ("シークレットモードをオフ",
     //               GetCommandCandidateValue(*seg));
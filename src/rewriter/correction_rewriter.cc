@@ -35,7 +35,6 @@
 
 #include "base/logging.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "data_manager/data_manager_interface.h"
@@ -110,7 +109,7 @@ CorrectionRewriter::~CorrectionRewriter() {}
 
 bool CorrectionRewriter::Rewrite(const ConversionRequest &request,
                                  Segments *segments) const {
-  if (!GET_CONFIG(use_spelling_correction)) {
+  if (!request.config().use_spelling_correction()) {
     return false;
   }
 
@@ -104,11 +104,13 @@ TEST_F(CorrectionRewriterTest, RewriteTest) {
   config::Config config;
   config.set_use_spelling_correction(false);
   config::ConfigHandler::SetConfig(config);
+  request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
   EXPECT_FALSE(rewriter_->Rewrite(request, &segments));
 
   config.set_use_spelling_correction(true);
   config::ConfigHandler::SetConfig(config);
+  request.set_config(config::ConfigHandler::GetConfigSnapshot());
   EXPECT_TRUE(rewriter_->Rewrite(request, &segments));
 
   // candidate 0
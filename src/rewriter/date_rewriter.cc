@@ -49,7 +49,6 @@
 #include "composer/composer.h"
 #include "composer/table.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "session/commands.pb.h"
@@ -2427,7 +2426,7 @@ int DateRewriter::capability(const ConversionRequest &request) const {
 
 bool DateRewriter::Rewrite(const ConversionRequest &request,
                            Segments *segments) const {
-  if (!GET_CONFIG(use_date_conversion)) {
+  if (!request.config().use_date_conversion()) {
     VLOG(2) << "no use_date_conversion";
     return false;
   }
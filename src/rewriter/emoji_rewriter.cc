@@ -39,7 +39,6 @@
 #include "base/logging.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "session/commands.pb.h"
@@ -237,7 +236,7 @@ int EmojiRewriter::capability(const ConversionRequest &request) const {
 
 bool EmojiRewriter::Rewrite(const ConversionRequest &request,
                             Segments *segments) const {
-  if (!mozc::config::ConfigHandler::GetConfig().use_emoji_conversion()) {
+  if (!request.config().use_emoji_conversion()) {
     VLOG(2) << "no use_emoji_conversion";
     return false;
   }
@@ -254,7 +253,7 @@ bool EmojiRewriter::Rewrite(const ConversionRequest &request,
 
 void EmojiRewriter::Finish(const ConversionRequest &request,
                            Segments *segments) {
-  if (!mozc::config::ConfigHandler::GetConfig().use_emoji_conversion()) {
+  if (!request.config().use_emoji_conversion()) {
     return;
   }
 
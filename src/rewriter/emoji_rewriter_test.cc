@@ -179,6 +179,7 @@ class EmojiRewriterTest : public ::testing::Test {
     config::Config config(original_config_);
     config.set_use_emoji_conversion(true);
     config::ConfigHandler::SetConfig(config);
+    request_.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     mozc::usage_stats::UsageStats::ClearAllStatsForTest();
 
@@ -195,7 +196,7 @@ class EmojiRewriterTest : public ::testing::Test {
     SystemUtil::SetUserProfileDirectory(original_profile_directory_);
   }
 
-  const ConversionRequest request_;
+  ConversionRequest request_;
   scoped_ptr<EmojiRewriter> rewriter_;
 
  private:
@@ -403,6 +404,7 @@ TEST_F(EmojiRewriterTest, NoConversionWithDisabledSettings) {
   config::ConfigHandler::GetConfig(&config);
   config.set_use_emoji_conversion(false);
   config::ConfigHandler::SetConfig(config);
+  request_.set_config(config::ConfigHandler::GetConfigSnapshot());
 
   Segments segments;
   SetSegment("test", "test", &segments);
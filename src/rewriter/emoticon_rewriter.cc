@@ -38,7 +38,6 @@
 #include "base/singleton.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "rewriter/embedded_dictionary.h"
@@ -259,7 +258,7 @@ int EmoticonRewriter::capability(const ConversionRequest &request) const {
 
 bool EmoticonRewriter::Rewrite(const ConversionRequest &request,
                                Segments *segments) const {
-  if (!GET_CONFIG(use_emoticon_conversion)) {
+  if (!request.config().use_emoticon_conversion()) {
     VLOG(2) << "no use_emoticon_conversion";
     return false;
   }
@@ -87,13 +87,14 @@ class EmoticonRewriterTest : public testing::Test {
 
 TEST_F(EmoticonRewriterTest, BasicTest) {
   EmoticonRewriter emoticon_rewriter;
-  const ConversionRequest request;
+  ConversionRequest request;
 
   {
     config::Config input;
     config::ConfigHandler::GetConfig(&input);
     input.set_use_emoticon_conversion(true);
     config::ConfigHandler::SetConfig(input);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     Segments segments;
     AddSegment("test", "test", &segments);
@@ -129,6 +130,7 @@ TEST_F(EmoticonRewriterTest, BasicTest) {
     config::ConfigHandler::GetConfig(&input);
     input.set_use_emoticon_conversion(false);
     config::ConfigHandler::SetConfig(input);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     Segments segments;
     AddSegment("test", "test", &segments);
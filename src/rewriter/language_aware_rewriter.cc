@@ -35,7 +35,6 @@
 #include "base/util.h"
 #include "composer/composer.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "dictionary/dictionary_interface.h"
@@ -55,7 +54,8 @@ LanguageAwareRewriter::~LanguageAwareRewriter() {}
 
 namespace {
 
-bool IsEnabled(const mozc::commands::Request &request) {
+bool IsEnabled(const ConversionRequest &conversion_request) {
+  const mozc::commands::Request &request = conversion_request.request();
   // The current default value of language_aware_input is
   // NO_LANGUAGE_AWARE_INPUT and only unittests set LANGUAGE_AWARE_SUGGESTION
   // at this moment.  Thus, FillRawText is not performed in the productions
@@ -70,7 +70,7 @@ bool IsEnabled(const mozc::commands::Request &request) {
   DCHECK_EQ(mozc::commands::Request::DEFAULT_LANGUAGE_AWARE_BEHAVIOR,
             request.language_aware_input());
 
-  if (!GET_CONFIG(use_spelling_correction)) {
+  if (!conversion_request.config().use_spelling_correction()) {
     return false;
   }
 
@@ -86,7 +86,7 @@ bool IsEnabled(const mozc::commands::Request &request) {
 int LanguageAwareRewriter::capability(
     const ConversionRequest &request) const {
   // Language aware input is performed only on suggestion or prediction.
-  if (!IsEnabled(request.request())) {
+  if (!IsEnabled(request)) {
     return RewriterInterface::NOT_AVAILABLE;
   }
 
@@ -216,7 +216,7 @@ bool LanguageAwareRewriter::FillRawText(
 
 bool LanguageAwareRewriter::Rewrite(
     const ConversionRequest &request, Segments *segments) const {
-  if (!IsEnabled(request.request())) {
+  if (!IsEnabled(request)) {
     return false;
   }
   return FillRawText(request, segments);
@@ -33,8 +33,8 @@
 #include <vector>
 
 #include "base/stl_util.h"
+#include "base/trace.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "rewriter/rewriter_interface.h"
@@ -86,6 +86,8 @@ class MergerRewriter : public RewriterInterface {
     bool result = false;
     for (size_t i = 0; i < rewriters_.size(); ++i) {
       if (CheckCapablity(request, segments, rewriters_[i])) {
+        MOZC_TRACE_SCOPE_WITH_ARG(Trace::MERGER_REWRITER_REWRITE,
+                                  static_cast<int32>(i));
         result |= rewriters_[i]->Rewrite(request, segments);
       }
     }
@@ -93,7 +95,7 @@ class MergerRewriter : public RewriterInterface {
     if (segments->request_type() == Segments::SUGGESTION &&
         segments->conversion_segments_size() == 1 &&
         !request.request().mixed_conversion()) {
-      const size_t max_suggestions = GET_CONFIG(suggestions_size);
+      const size_t max_suggestions = request.config().suggestions_size();
       Segment *segment = segments->mutable_conversion_segment(0);
       const size_t candidate_size = segment->candidates_size();
       if (candidate_size > max_suggestions) {
@@ -39,7 +39,6 @@
 #include "base/number_util.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "data_manager/data_manager_interface.h"
@@ -424,7 +423,7 @@ int NumberRewriter::capability(const ConversionRequest &request) const {
 bool NumberRewriter::Rewrite(const ConversionRequest &request,
                              Segments *segments) const {
   DCHECK(segments);
-  if (!GET_CONFIG(use_number_conversion)) {
+  if (!request.config().use_number_conversion()) {
     VLOG(2) << "no use_number_conversion";
     return false;
   }
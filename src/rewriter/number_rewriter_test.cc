@@ -145,6 +145,7 @@ class NumberRewriterTest : public ::testing::Test {
     config::Config default_config;
     config::ConfigHandler::GetDefaultConfig(&default_config);
     config::ConfigHandler::SetConfig(default_config);
+    default_request_.set_config(config::ConfigHandler::GetConfigSnapshot());
     pos_matcher_ = mock_data_manager_.GetPOSMatcher();
   }
 
@@ -161,7 +162,7 @@ class NumberRewriterTest : public ::testing::Test {
 
   const testing::MockDataManager mock_data_manager_;
   const POSMatcher *pos_matcher_;
-  const ConversionRequest default_request_;
+  ConversionRequest default_request_;
 };
 
 namespace {
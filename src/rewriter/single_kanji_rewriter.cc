@@ -38,7 +38,6 @@
 #include "base/singleton.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "dictionary/pos_matcher.h"
@@ -250,7 +249,7 @@ int SingleKanjiRewriter::capability(const ConversionRequest &request) const {
 
 bool SingleKanjiRewriter::Rewrite(const ConversionRequest &request,
                                   Segments *segments) const {
-  if (!GET_CONFIG(use_single_kanji_conversion)) {
+  if (!request.config().use_single_kanji_conversion()) {
     VLOG(2) << "no use_single_kanji_conversion";
     return false;
   }
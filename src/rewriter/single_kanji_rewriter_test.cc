@@ -62,6 +62,7 @@ class SingleKanjiRewriterTest : public ::testing::Test {
     config::Config default_config;
     config::ConfigHandler::GetDefaultConfig(&default_config);
     config::ConfigHandler::SetConfig(default_config);
+    default_request_.set_config(config::ConfigHandler::GetConfigSnapshot());
   }
 
   SingleKanjiRewriter *CreateSingleKanjiRewriter() const {
@@ -72,7 +73,7 @@ class SingleKanjiRewriterTest : public ::testing::Test {
     return *pos_matcher_;
   }
 
-  const ConversionRequest default_request_;
+  ConversionRequest default_request_;
 
  private:
   scoped_ptr<testing::MockDataManager> data_manager_;
@@ -38,7 +38,6 @@
 #include "base/singleton.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/converter_interface.h"
 #include "converter/segments.h"
@@ -348,7 +347,7 @@ int SymbolRewriter::capability(const ConversionRequest &request) const {
 
 bool SymbolRewriter::Rewrite(const ConversionRequest &request,
                              Segments *segments) const {
-  if (!GET_CONFIG(use_symbol_conversion)) {
+  if (!request.config().use_symbol_conversion()) {
     VLOG(2) << "no use_symbol_conversion";
     return false;
   }
@@ -173,7 +173,7 @@ TEST_F(UsageRewriterTest, ConfigTest) {
   Segments segments;
   scoped_ptr<UsageRewriter> rewriter(CreateUsageRewriter());
   Segment *seg;
-  const ConversionRequest request;
+  ConversionRequest request;
 
   // Default setting
   {
@@ -195,6 +195,7 @@ TEST_F(UsageRewriterTest, ConfigTest) {
     config.mutable_information_list_config()->
         set_use_local_usage_dictionary(false);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     segments.Clear();
     seg = segments.push_back_segment();
@@ -214,6 +215,7 @@ TEST_F(UsageRewriterTest, ConfigTest) {
     config.mutable_information_list_config()->
         set_use_local_usage_dictionary(true);
     config::ConfigHandler::SetConfig(config);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     segments.Clear();
     seg = segments.push_back_segment();
@@ -38,7 +38,6 @@
 #include "base/logging.h"
 #include "base/util.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/converter_interface.h"
 #include "converter/segments.h"
@@ -123,12 +122,12 @@ void UserBoundaryHistoryRewriter::Finish(const ConversionRequest &request,
     return;
   }
 
-  if (GET_CONFIG(incognito_mode)) {
+  if (request.config().incognito_mode()) {
     VLOG(2) << "incognito mode";
     return;
   }
 
-  if (GET_CONFIG(history_learning_level) !=
+  if (request.config().history_learning_level() !=
       config::Config::DEFAULT_HISTORY) {
     VLOG(2) << "history_learning_level is not DEFAULT_HISTORY";
     return;
@@ -164,12 +163,12 @@ void UserBoundaryHistoryRewriter::Finish(const ConversionRequest &request,
 
 bool UserBoundaryHistoryRewriter::Rewrite(
     const ConversionRequest &request, Segments *segments) const {
-  if (GET_CONFIG(incognito_mode)) {
+  if (request.config().incognito_mode()) {
     VLOG(2) << "incognito mode";
     return false;
   }
 
-  if (GET_CONFIG(history_learning_level) == config::Config::NO_HISTORY) {
+  if (request.config().history_learning_level() == config::Config::NO_HISTORY) {
     VLOG(2) << "history_learning_level is NO_HISTORY";
     return false;
   }
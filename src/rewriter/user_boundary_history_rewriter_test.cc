@@ -88,6 +88,9 @@ void SetSegments(Segments *segments, bool fixed) {
   candidate->content_value = "\xe3\x81\x9f\xe3\x82\x93\xe3\x81\xbd\xe3\x81\xbd";
 }
 
+// Note that ConversionRequest takes a snapshot of the config when it is
+// constructed. The tests create a request for each call to use the config
+// set by the following functions.
 void SetIncognito(bool incognito) {
   config::Config input;
   config::ConfigHandler::GetConfig(&input);
@@ -130,8 +133,6 @@ class UserBoundaryHistoryRewriterTest : public testing::Test {
     return mock_;
   }
 
-  const ConversionRequest default_request_;
-
  private:
   ConverterMock mock_;
 
@@ -154,14 +155,14 @@ TEST_F(UserBoundaryHistoryRewriterTest, Rewrite1) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
   SetSegments(&segments, false);
   segments.set_user_history_enabled(true);
 
-  EXPECT_TRUE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_TRUE(rewriter.Rewrite(ConversionRequest(), &segments));
   const string segments_str = segments.DebugString();
 
   // "たんぽぽ" -> "たん|ぽぽ"
@@ -199,14 +200,14 @@ TEST_F(UserBoundaryHistoryRewriterTest, Rewrite2) {
   segments.set_resized(true);
   segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &segments);
+  rewriter.Finish(ConversionRequest(), &segments);
   const string segments_str = segments.DebugString();
 
   Segments bounded_segments;
   SetBoundedSegments(&bounded_segments, false);
   bounded_segments.set_user_history_enabled(true);
 
-  EXPECT_TRUE(rewriter.Rewrite(default_request_, &bounded_segments));
+  EXPECT_TRUE(rewriter.Rewrite(ConversionRequest(), &bounded_segments));
   const string bounded_segments_str = bounded_segments.DebugString();
 
   // "たん|ぽぽ" -> "たんぽぽ"
@@ -242,7 +243,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenIncognito) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
@@ -251,7 +252,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenIncognito) {
   const string segments_str = segments.DebugString();
 
   SetIncognito(false);  // no_incognito when rewrite
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -266,7 +267,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenReadOnly) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
@@ -274,7 +275,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenReadOnly) {
   segments.set_user_history_enabled(true);
   const string segments_str = segments.DebugString();
 
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -289,7 +290,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenDisableUserHistory) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(false);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
@@ -297,7 +298,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenDisableUserHistory) {
   segments.set_user_history_enabled(true);
   const string segments_str = segments.DebugString();
 
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -312,7 +313,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenNotResized) {
   bounded_segments.set_resized(false);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
@@ -320,7 +321,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoInsertWhenNotResized) {
   segments.set_user_history_enabled(true);
   const string segments_str =segments.DebugString();
 
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -335,7 +336,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteAfterClear) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
@@ -346,7 +347,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteAfterClear) {
   rewriter.Clear();
 
   const string segments_str = segments.DebugString();
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -361,7 +362,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenIncognito) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str = bounded_segments.DebugString();
 
   Segments segments;
@@ -370,7 +371,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenIncognito) {
 
   const string segments_str = segments.DebugString();
   SetIncognito(true);
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -385,7 +386,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenNoHistory) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str =bounded_segments.DebugString();
 
   Segments segments;
@@ -394,7 +395,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenNoHistory) {
 
   const string segments_str =segments.DebugString();
   SetLearningLevel(config::Config::NO_HISTORY);
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str =segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -409,7 +410,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenDisabledUserHistory) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str =bounded_segments.DebugString();
 
   Segments segments;
@@ -417,7 +418,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenDisabledUserHistory) {
   segments.set_user_history_enabled(false);
 
   const string segments_str =segments.DebugString();
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str =segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
@@ -432,7 +433,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenAlreadyResized) {
   bounded_segments.set_resized(true);
   bounded_segments.set_user_history_enabled(true);
 
-  rewriter.Finish(default_request_, &bounded_segments);
+  rewriter.Finish(ConversionRequest(), &bounded_segments);
   const string bounded_segments_str =bounded_segments.DebugString();
 
   Segments segments;
@@ -441,7 +442,7 @@ TEST_F(UserBoundaryHistoryRewriterTest, NoRewriteWhenAlreadyResized) {
   segments.set_resized(true);
 
   const string segments_str = segments.DebugString();
-  EXPECT_FALSE(rewriter.Rewrite(default_request_, &segments));
+  EXPECT_FALSE(rewriter.Rewrite(ConversionRequest(), &segments));
 
   const string segments_rewrited_str = segments.DebugString();
   EXPECT_EQ(segments_str, segments_rewrited_str);
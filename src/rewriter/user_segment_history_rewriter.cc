@@ -44,7 +44,6 @@
 #include "base/util.h"
 #include "config/character_form_manager.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "dictionary/pos_group.h"
@@ -757,8 +756,9 @@ void UserSegmentHistoryRewriter::RememberFirstCandidate(
   }
 }
 
-bool UserSegmentHistoryRewriter::IsAvailable(const Segments &segments) const {
-  if (GET_CONFIG(incognito_mode)) {
+bool UserSegmentHistoryRewriter::IsAvailable(const ConversionRequest &request,
+                                             const Segments &segments) const {
+  if (request.config().incognito_mode()) {
     VLOG(2) << "incognito_mode";
     return false;
   }
@@ -790,11 +790,11 @@ void UserSegmentHistoryRewriter::Finish(const ConversionRequest &request,
     return;
   }
 
-  if (!IsAvailable(*segments)) {
+  if (!IsAvailable(request, *segments)) {
     return;
   }
 
-  if (GET_CONFIG(history_learning_level) != Config::DEFAULT_HISTORY) {
+  if (request.config().history_learning_level() != Config::DEFAULT_HISTORY) {
     VLOG(2) << "history_learning_level is not DEFAULT_HISTORY";
     return;
   }
@@ -945,11 +945,11 @@ bool UserSegmentHistoryRewriter::RewriteNumber(Segment *segment) const {
 
 bool UserSegmentHistoryRewriter::Rewrite(const ConversionRequest &request,
                                          Segments *segments) const {
-  if (!IsAvailable(*segments)) {
+  if (!IsAvailable(request, *segments)) {
     return false;
   }
 
-  if (GET_CONFIG(history_learning_level) == Config::NO_HISTORY) {
+  if (request.config().history_learning_level() == Config::NO_HISTORY) {
     VLOG(2) << "history_learning_level is NO_HISTORY";
     return false;
   }
@@ -225,10 +225,11 @@ TEST_F(UserSegmentHistoryRewriterTest, IncognitoModeTest) {
   Segments segments;
   scoped_ptr<UserSegmentHistoryRewriter> rewriter(
       CreateUserSegmentHistoryRewriter());
-  const ConversionRequest request;
+  ConversionRequest request;
 
   {
     SetIncognito(false);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     segments.mutable_segment(0)->move_candidate(2, 0);
     segments.mutable_segment(0)->mutable_candidate(0)->attributes
@@ -241,6 +242,7 @@ TEST_F(UserSegmentHistoryRewriterTest, IncognitoModeTest) {
               segments.segment(0).candidate(0).value);
 
     SetIncognito(true);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     rewriter->Rewrite(request, &segments);
     EXPECT_EQ("candidate0",
@@ -250,6 +252,7 @@ TEST_F(UserSegmentHistoryRewriterTest, IncognitoModeTest) {
   {
     rewriter->Clear();   // clear history
     SetIncognito(true);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     segments.mutable_segment(0)->move_candidate(2, 0);
     segments.mutable_segment(0)->mutable_candidate(0)->attributes
@@ -268,10 +271,11 @@ TEST_F(UserSegmentHistoryRewriterTest, ConfigTest) {
   Segments segments;
   scoped_ptr<UserSegmentHistoryRewriter> rewriter(
       CreateUserSegmentHistoryRewriter());
-  const ConversionRequest request;
+  ConversionRequest request;
 
   {
     SetLearningLevel(Config::DEFAULT_HISTORY);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     segments.mutable_segment(0)->move_candidate(2, 0);
     segments.mutable_segment(0)->mutable_candidate(0)->attributes
@@ -284,12 +288,14 @@ TEST_F(UserSegmentHistoryRewriterTest, ConfigTest) {
               segments.segment(0).candidate(0).value);
 
     SetLearningLevel(Config::NO_HISTORY);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     rewriter->Rewrite(request, &segments);
     EXPECT_EQ("candidate0",
               segments.segment(0).candidate(0).value);
 
     SetLearningLevel(Config::READ_ONLY);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     rewriter->Rewrite(request, &segments);
     EXPECT_EQ("candidate2",
@@ -298,6 +304,7 @@ TEST_F(UserSegmentHistoryRewriterTest, ConfigTest) {
 
   {
     SetLearningLevel(Config::NO_HISTORY);
+    request.set_config(config::ConfigHandler::GetConfigSnapshot());
     InitSegments(&segments, 1);
     segments.mutable_segment(0)->move_candidate(2, 0);
     segments.mutable_segment(0)->mutable_candidate(0)->attributes
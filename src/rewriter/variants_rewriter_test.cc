@@ -249,12 +249,13 @@ TEST_F(VariantsRewriterTest, RewriteTest) {
 TEST_F(VariantsRewriterTest, RewriteTestManyCandidates) {
   scoped_ptr<VariantsRewriter> rewriter(CreateVariantsRewriter());
   Segments segments;
-  const ConversionRequest request;
+  ConversionRequest request;
   Segment *seg = segments.push_back_segment();
 
   Config config;
   ConfigHandler::GetDefaultConfig(&config);
   ConfigHandler::SetConfig(config);
+  request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
   {
     for (int i = 0; i < 10; ++i) {
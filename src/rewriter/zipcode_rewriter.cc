@@ -33,7 +33,6 @@
 
 #include "base/logging.h"
 #include "config/config.pb.h"
-#include "config/config_handler.h"
 #include "converter/conversion_request.h"
 #include "converter/segments.h"
 #include "dictionary/pos_matcher.h"
@@ -64,6 +63,7 @@ bool ZipcodeRewriter::GetZipcodeCandidatePositions(const Segment &seg,
 bool ZipcodeRewriter::InsertCandidate(size_t insert_pos,
                                       const string &zipcode,
                                       const string &address,
+                                      const ConversionRequest &request,
                                       Segment *segment) const {
   DCHECK(segment);
   if (segment->candidates_size() == 0) {
@@ -81,7 +81,7 @@ bool ZipcodeRewriter::InsertCandidate(size_t insert_pos,
   const Segment::Candidate &base_candidate = segment->candidate(offset - 1);
 
   bool is_full_width = true;
-  switch (GET_CONFIG(space_character_form)) {
+  switch (request.config().space_character_form()) {
     case config::Config::FUNDAMENTAL_INPUT_MODE:
       is_full_width = true;
       break;
@@ -149,7 +149,7 @@ bool ZipcodeRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
-  return InsertCandidate(insert_pos, zipcode,
-                         address, segments->mutable_conversion_segment(0));
+  return InsertCandidate(insert_pos, zipcode, address, request,
+                         segments->mutable_conversion_segment(0));
 }
 }  // namespace mozc
@@ -56,6 +56,7 @@ class ZipcodeRewriter : public RewriterInterface  {
   bool InsertCandidate(size_t insert_pos,
                        const string &zipcode,
                        const string &address,
+                       const ConversionRequest &request,
                        Segment *segment) const;
 
   const POSMatcher *pos_matcher_;
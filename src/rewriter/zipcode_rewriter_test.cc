@@ -138,7 +138,7 @@ TEST_F(ZipcodeRewriterTest, BasicTest) {
      // "東京都港区赤坂"
      "\xE6\x9D\xB1\xE4\xBA\xAC\xE9\x83\xBD\xE6"
      "\xB8\xAF\xE5\x8C\xBA\xE8\xB5\xA4\xE5\x9D\x82";
-  const ConversionRequest default_request;
+  ConversionRequest default_request;
 
   {
     Segments segments;
@@ -152,6 +152,7 @@ TEST_F(ZipcodeRewriterTest, BasicTest) {
     config.set_space_character_form(
         config::Config::FUNDAMENTAL_HALF_WIDTH);
     config::ConfigHandler::SetConfig(config);
+    default_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     Segments segments;
     AddSegment(kZipcode, kAddress, ZIPCODE, &segments);
@@ -166,6 +167,7 @@ TEST_F(ZipcodeRewriterTest, BasicTest) {
     config.set_space_character_form(
         config::Config::FUNDAMENTAL_FULL_WIDTH);
     config::ConfigHandler::SetConfig(config);
+    default_request.set_config(config::ConfigHandler::GetConfigSnapshot());
 
     Segments segments;
     AddSegment(kZipcode, kAddress, ZIPCODE, &segments);
@@ -0,0 +1,687 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Micro benchmarks for the conversion pipeline with the OSS dictionary.
+//
+// The inputs are the fixed sentences of RandomKeyEventsGenerator, so the
+// results are comparable between runs and revisions.  The results are
+// printed as a table, and also written as JSON to --benchmark_output for
+// regression tracking.
+//
+// Example:
+//   conversion_benchmark_main --benchmark_filter=SystemDictionary
+//       --benchmark_output=/tmp/result.json
+
+#include <iostream>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "base/benchmark.h"
+#include "base/file_stream.h"
+#include "base/file_util.h"
+#include "base/flags.h"
+#include "base/logging.h"
+#include "base/port.h"
+#include "base/scoped_ptr.h"
+#include "base/stl_util.h"
+#include "base/system_util.h"
+#include "base/util.h"
+#include "converter/connector_base.h"
+#include "converter/conversion_request.h"
+#include "converter/converter_interface.h"
+#include "converter/immutable_converter.h"
+#include "converter/node_allocator.h"
+#include "converter/segmenter_base.h"
+#include "converter/segments.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "dictionary/dictionary_impl.h"
+#include "dictionary/dictionary_interface.h"
+#include "dictionary/pos_group.h"
+#include "dictionary/suffix_dictionary.h"
+#include "dictionary/suffix_dictionary_token.h"
+#include "dictionary/suppression_dictionary.h"
+#include "dictionary/system/system_dictionary.h"
+#include "dictionary/system/value_dictionary.h"
+#include "dictionary/user_dictionary.h"
+#include "dictionary/user_pos.h"
+#include "engine/engine_interface.h"
+#include "engine/oss_engine_factory.h"
+#include "prediction/dictionary_predictor.h"
+#include "prediction/suggestion_filter.h"
+#include "prediction/user_history_predictor.h"
+#include "rewriter/rewriter.h"
+#include "session/commands.pb.h"
+#include "session/random_keyevents_generator.h"
+#include "session/session_handler.h"
+#include "storage/louds/louds_trie.h"
+#include "storage/louds/louds_trie_builder.h"
+
+DEFINE_string(benchmark_filter, "",
+              "run only the benchmarks whose names contain this string");
+DEFINE_string(benchmark_output, "",
+              "if set, write the results to this file as JSON");
+DEFINE_int32(benchmark_min_time_ms, 1000,
+             "minimum time to run each benchmark");
+DEFINE_int32(benchmark_min_ops, 100,
+             "minimum number of operations to run each benchmark");
+DEFINE_int32(benchmark_max_sentences, 200,
+             "maximum number of test sentences used as inputs");
+DEFINE_string(user_profile_dir, "mozc_benchmark_profile",
+              "scratch directory for the user history learned by the "
+              "benchmarks; do not use a real profile directory");
+
+namespace mozc {
+namespace {
+
+using mozc::dictionary::DictionaryImpl;
+using mozc::dictionary::SystemDictionary;
+using mozc::dictionary::ValueDictionary;
+using mozc::storage::louds::LoudsTrie;
+using mozc::storage::louds::LoudsTrieBuilder;
+
+// Shared inputs and components.  They are created once since loading the
+// dictionary takes much longer than most of the benchmarks.
+class Environment {
+ public:
+  Environment() {
+    size_t size = 0;
+    const char **sentences =
+        session::RandomKeyEventsGenerator::GetTestSentences(&size);
+    CHECK_GT(size, 0);
+    size = min(static_cast<size_t>(FLAGS_benchmark_max_sentences), size);
+    for (size_t i = 0; i < size; ++i) {
+      sentences_.push_back(sentences[i]);
+      // The first 1 to 5 characters as the keys for the suggestion.
+      const size_t length = Util::CharsLen(sentences_.back());
+      for (size_t len = 1; len <= min(static_cast<size_t>(5), length); ++len) {
+        prefixes_.push_back(Util::SubString(sentences_.back(), 0, len));
+      }
+    }
+
+    suppression_dictionary_.reset(new SuppressionDictionary);
+    user_dictionary_.reset(
+        new UserDictionary(new UserPOS(data_manager_.GetUserPOSData()),
+                           data_manager_.GetPOSMatcher(),
+                           suppression_dictionary_.get()));
+
+    const char *dictionary_data = NULL;
+    int dictionary_size = 0;
+    data_manager_.GetSystemDictionaryData(&dictionary_data, &dictionary_size);
+    system_dictionary_.reset(SystemDictionary::CreateSystemDictionaryFromImage(
+        dictionary_data, dictionary_size));
+    CHECK(system_dictionary_.get());
+    dictionary_.reset(new DictionaryImpl(
+        SystemDictionary::CreateSystemDictionaryFromImage(
+            dictionary_data, dictionary_size),
+        ValueDictionary::CreateValueDictionaryFromImage(
+            *data_manager_.GetPOSMatcher(), dictionary_data, dictionary_size),
+        user_dictionary_.get(),
+        suppression_dictionary_.get(),
+        data_manager_.GetPOSMatcher()));
+
+    const SuffixToken *suffix_tokens = NULL;
+    size_t suffix_tokens_size = 0;
+    data_manager_.GetSuffixDictionaryData(&suffix_tokens, &suffix_tokens_size);
+    suffix_dictionary_.reset(
+        new SuffixDictionary(suffix_tokens, suffix_tokens_size));
+    connector_.reset(ConnectorBase::CreateFromDataManager(data_manager_));
+    segmenter_.reset(SegmenterBase::CreateFromDataManager(data_manager_));
+    pos_group_.reset(new PosGroup(data_manager_.GetPosGroupData()));
+    {
+      const char *data = NULL;
+      size_t size = 0;
+      data_manager_.GetSuggestionFilterData(&data, &size);
+      CHECK(data);
+      suggestion_filter_.reset(new SuggestionFilter(data, size));
+    }
+    immutable_converter_.reset(new ImmutableConverterImpl(
+        dictionary_.get(),
+        suffix_dictionary_.get(),
+        suppression_dictionary_.get(),
+        connector_.get(),
+        segmenter_.get(),
+        data_manager_.GetPOSMatcher(),
+        pos_group_.get(),
+        suggestion_filter_.get()));
+
+    // The predictor and the rewriter need a converter for the realtime
+    // conversion and the transliterations.  The one of the engine is used.
+    engine_.reset(OssEngineFactory::Create());
+    CHECK(engine_.get());
+
+    // The converted sentences are the inputs for the rewriter and the
+    // reverse lookup.
+    const ConversionRequest request;
+    for (size_t i = 0; i < sentences_.size(); ++i) {
+      scoped_ptr<Segments> segments(new Segments);
+      MakeSegmentsForConversion(sentences_[i], segments.get());
+      if (!immutable_converter_->ConvertForRequest(request, segments.get())) {
+        continue;
+      }
+      string value;
+      for (size_t j = 0; j < segments->conversion_segments_size(); ++j) {
+        const Segment &segment = segments->conversion_segment(j);
+        if (segment.candidates_size() > 0) {
+          value.append(segment.candidate(0).value);
+        }
+      }
+      converted_values_.push_back(value);
+      converted_segments_.push_back(segments.release());
+    }
+    CHECK(!converted_segments_.empty());
+  }
+
+  ~Environment() {
+    STLDeleteElements(&converted_segments_);
+  }
+
+  static void MakeSegmentsForConversion(const string &key,
+                                        Segments *segments) {
+    segments->Clear();
+    segments->set_request_type(Segments::CONVERSION);
+    segments->add_segment()->set_key(key);
+  }
+
+  static void MakeSegmentsForSuggestion(const string &key,
+                                        Segments *segments) {
+    segments->Clear();
+    segments->set_request_type(Segments::SUGGESTION);
+    segments->set_max_prediction_candidates_size(10);
+    segments->add_segment()->set_key(key);
+  }
+
+  const vector<string> &sentences() const { return sentences_; }
+  const vector<string> &prefixes() const { return prefixes_; }
+  const vector<string> &converted_values() const { return converted_values_; }
+  const vector<Segments *> &converted_segments() const {
+    return converted_segments_;
+  }
+
+  const oss::OssDataManager &data_manager() const { return data_manager_; }
+  const SystemDictionary *system_dictionary() const {
+    return system_dictionary_.get();
+  }
+  const DictionaryInterface *dictionary() const { return dictionary_.get(); }
+  const DictionaryInterface *suffix_dictionary() const {
+    return suffix_dictionary_.get();
+  }
+  const SuppressionDictionary *suppression_dictionary() const {
+    return suppression_dictionary_.get();
+  }
+  const ConnectorInterface *connector() const { return connector_.get(); }
+  const SegmenterInterface *segmenter() const { return segmenter_.get(); }
+  const PosGroup *pos_group() const { return pos_group_.get(); }
+  const SuggestionFilter *suggestion_filter() const {
+    return suggestion_filter_.get();
+  }
+  const ImmutableConverterInterface *immutable_converter() const {
+    return immutable_converter_.get();
+  }
+  EngineInterface *engine() const { return engine_.get(); }
+
+ private:
+  vector<string> sentences_;
+  vector<string> prefixes_;
+  vector<string> converted_values_;
+  vector<Segments *> converted_segments_;
+
+  oss::OssDataManager data_manager_;
+  scoped_ptr<SuppressionDictionary> suppression_dictionary_;
+  scoped_ptr<UserDictionary> user_dictionary_;
+  scoped_ptr<SystemDictionary> system_dictionary_;
+  scoped_ptr<DictionaryInterface> dictionary_;
+  scoped_ptr<DictionaryInterface> suffix_dictionary_;
+  scoped_ptr<const ConnectorInterface> connector_;
+  scoped_ptr<const SegmenterInterface> segmenter_;
+  scoped_ptr<const PosGroup> pos_group_;
+  scoped_ptr<const SuggestionFilter> suggestion_filter_;
+  scoped_ptr<ImmutableConverterInterface> immutable_converter_;
+  scoped_ptr<EngineInterface> engine_;
+
+  DISALLOW_COPY_AND_ASSIGN(Environment);
+};
+
+// Base class of the benchmarks which take the inputs in turn.
+class InputBenchmark : public BenchmarkInterface {
+ public:
+  InputBenchmark(const string &name, const vector<string> *inputs)
+      : name_(name), inputs_(inputs), index_(0) {}
+  virtual ~InputBenchmark() {}
+
+  virtual string name() const { return name_; }
+
+  // |inputs_| may be a member of a subclass, which is not initialized yet
+  // in the constructor.
+  virtual void SetUp() {
+    CHECK(!inputs_->empty());
+  }
+
+  virtual void PrepareOp() {
+    index_ = (index_ + 1) % inputs_->size();
+  }
+
+ protected:
+  const string &input() const { return (*inputs_)[index_]; }
+
+ private:
+  const string name_;
+  const vector<string> *inputs_;
+  size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputBenchmark);
+};
+
+class CountingTrieCallback : public LoudsTrie::Callback {
+ public:
+  CountingTrieCallback() : count_(0) {}
+  virtual ResultType Run(const char *s, size_t len, int key_id) {
+    ++count_;
+    return SEARCH_CONTINUE;
+  }
+  int count() const { return count_; }
+
+ private:
+  int count_;
+};
+
+class LoudsTrieBenchmark : public InputBenchmark {
+ public:
+  enum SearchType {
+    EXACT,
+    PREFIX,
+    PREDICTIVE,
+  };
+
+  LoudsTrieBenchmark(const string &name, SearchType type,
+                     const Environment &env)
+      : InputBenchmark(name, &keys_), type_(type) {
+    // Builds a trie of all the substrings of up to 4 characters in the
+    // sentences.  The sentences and their suffixes are the inputs.
+    LoudsTrieBuilder builder;
+    for (size_t i = 0; i < env.sentences().size(); ++i) {
+      const string &sentence = env.sentences()[i];
+      const size_t length = Util::CharsLen(sentence);
+      for (size_t begin = 0; begin < length; ++begin) {
+        const string suffix = Util::SubString(sentence, begin, length);
+        keys_.push_back(suffix);
+        for (size_t len = 1; len <= 4 && begin + len <= length; ++len) {
+          builder.Add(Util::SubString(sentence, begin, len));
+        }
+      }
+    }
+    builder.Build();
+    image_ = builder.image();
+    CHECK(trie_.Open(reinterpret_cast<const uint8 *>(image_.data())));
+  }
+
+  virtual void RunOp() {
+    CountingTrieCallback callback;
+    switch (type_) {
+      case EXACT:
+        trie_.ExactSearch(input());
+        break;
+      case PREFIX:
+        trie_.PrefixSearch(input().c_str(), &callback);
+        break;
+      case PREDICTIVE:
+        // Only the first character is used to get many results.
+        trie_.PredictiveSearch(Util::SubString(input(), 0, 1).c_str(),
+                               &callback);
+        break;
+    }
+  }
+
+ private:
+  const SearchType type_;
+  vector<string> keys_;
+  string image_;
+  LoudsTrie trie_;
+};
+
+class CountingDictionaryCallback : public DictionaryInterface::Callback {
+ public:
+  CountingDictionaryCallback() : count_(0) {}
+  virtual ResultType OnToken(StringPiece key, StringPiece expanded_key,
+                             const Token &token) {
+    ++count_;
+    return TRAVERSE_CONTINUE;
+  }
+  int count() const { return count_; }
+
+ private:
+  int count_;
+};
+
+class SystemDictionaryBenchmark : public InputBenchmark {
+ public:
+  enum LookupType {
+    PREFIX,
+    PREDICTIVE,
+    REVERSE,
+  };
+
+  SystemDictionaryBenchmark(const string &name, LookupType type,
+                            const Environment &env)
+      : InputBenchmark(name, type == PREFIX ? &env.sentences() :
+                       type == PREDICTIVE ? &env.prefixes() :
+                       &env.converted_values()),
+        type_(type),
+        dictionary_(env.system_dictionary()) {
+    conversion_request_.set_kana_modifier_insensitive_conversion(false);
+  }
+
+  virtual void PrepareOp() {
+    InputBenchmark::PrepareOp();
+    allocator_.Free();
+  }
+
+  virtual void RunOp() {
+    CountingDictionaryCallback callback;
+    switch (type_) {
+      case PREFIX:
+        dictionary_->LookupPrefix(input(), conversion_request_, &callback);
+        break;
+      case PREDICTIVE:
+        dictionary_->LookupPredictive(input(), conversion_request_,
+                                      &callback);
+        break;
+      case REVERSE:
+        dictionary_->LookupReverse(input(), &allocator_, conversion_request_,
+                                   &callback);
+        break;
+    }
+  }
+
+ private:
+  const LookupType type_;
+  const SystemDictionary *dictionary_;
+  ConversionRequest conversion_request_;
+  NodeAllocator allocator_;
+};
+
+class ImmutableConverterBenchmark : public InputBenchmark {
+ public:
+  explicit ImmutableConverterBenchmark(const Environment &env)
+      : InputBenchmark("ImmutableConverter/ConvertForRequest",
+                       &env.sentences()),
+        converter_(env.immutable_converter()) {}
+
+  virtual void PrepareOp() {
+    InputBenchmark::PrepareOp();
+    Environment::MakeSegmentsForConversion(input(), &segments_);
+  }
+
+  virtual void RunOp() {
+    converter_->ConvertForRequest(request_, &segments_);
+  }
+
+ private:
+  const ImmutableConverterInterface *converter_;
+  const ConversionRequest request_;
+  Segments segments_;
+};
+
+class DictionaryPredictorBenchmark : public InputBenchmark {
+ public:
+  explicit DictionaryPredictorBenchmark(const Environment &env)
+      : InputBenchmark("DictionaryPredictor/PredictForRequest",
+                       &env.prefixes()),
+        predictor_(env.engine()->GetConverter(),
+                   env.immutable_converter(),
+                   env.dictionary(),
+                   env.suffix_dictionary(),
+                   env.connector(),
+                   env.segmenter(),
+                   env.data_manager().GetPOSMatcher(),
+                   env.suggestion_filter()) {}
+
+  virtual void PrepareOp() {
+    InputBenchmark::PrepareOp();
+    Environment::MakeSegmentsForSuggestion(input(), &segments_);
+  }
+
+  virtual void RunOp() {
+    predictor_.PredictForRequest(request_, &segments_);
+  }
+
+ private:
+  DictionaryPredictor predictor_;
+  const ConversionRequest request_;
+  Segments segments_;
+};
+
+class UserHistoryPredictorBenchmark : public InputBenchmark {
+ public:
+  explicit UserHistoryPredictorBenchmark(const Environment &env)
+      : InputBenchmark("UserHistoryPredictor/PredictForRequest",
+                       &env.prefixes()),
+        env_(env),
+        predictor_(env.dictionary(),
+                   env.data_manager().GetPOSMatcher(),
+                   env.suppression_dictionary()) {}
+
+  virtual void SetUp() {
+    InputBenchmark::SetUp();
+    predictor_.WaitForSyncerForTest();
+    predictor_.ClearAllHistory();
+    predictor_.WaitForSyncerForTest();
+    // Learns the converted sentences.
+    for (size_t i = 0; i < env_.converted_segments().size(); ++i) {
+      Segments segments;
+      segments.CopyFrom(*env_.converted_segments()[i]);
+      for (size_t j = 0; j < segments.segments_size(); ++j) {
+        segments.mutable_segment(j)->set_segment_type(Segment::FIXED_VALUE);
+      }
+      predictor_.Finish(request_, &segments);
+    }
+  }
+
+  virtual void PrepareOp() {
+    InputBenchmark::PrepareOp();
+    Environment::MakeSegmentsForSuggestion(input(), &segments_);
+  }
+
+  virtual void RunOp() {
+    predictor_.PredictForRequest(request_, &segments_);
+  }
+
+  virtual void TearDown() {
+    predictor_.ClearAllHistory();
+    predictor_.WaitForSyncerForTest();
+  }
+
+ private:
+  const Environment &env_;
+  UserHistoryPredictor predictor_;
+  const ConversionRequest request_;
+  Segments segments_;
+};
+
+class MergerRewriterBenchmark : public BenchmarkInterface {
+ public:
+  explicit MergerRewriterBenchmark(const Environment &env)
+      : env_(env),
+        rewriter_(env.engine()->GetConverter(), &env.data_manager(),
+                  env.pos_group(), env.dictionary()),
+        index_(0) {}
+
+  virtual string name() const { return "MergerRewriter/Rewrite"; }
+
+  virtual void PrepareOp() {
+    index_ = (index_ + 1) % env_.converted_segments().size();
+    segments_.CopyFrom(*env_.converted_segments()[index_]);
+  }
+
+  virtual void RunOp() {
+    rewriter_.Rewrite(request_, &segments_);
+  }
+
+ private:
+  const Environment &env_;
+  RewriterImpl rewriter_;
+  const ConversionRequest request_;
+  Segments segments_;
+  size_t index_;
+};
+
+// Sends the romaji key events of the sentences one by one.  Each operation
+// is one keystroke, and the composition is reverted at the end of a
+// sentence outside of the measurement.
+class SessionHandlerBenchmark : public BenchmarkInterface {
+ public:
+  explicit SessionHandlerBenchmark(const Environment &env)
+      : handler_(env.engine()), id_(0), sentence_index_(0), key_index_(0) {
+    for (size_t i = 0; i < env.sentences().size(); ++i) {
+      string romaji;
+      Util::HiraganaToRomanji(env.sentences()[i], &romaji);
+      vector<commands::KeyEvent> keys;
+      for (size_t j = 0; j < romaji.size(); ++j) {
+        if (romaji[j] >= 'a' && romaji[j] <= 'z') {
+          commands::KeyEvent key;
+          key.set_key_code(static_cast<int>(romaji[j]));
+          keys.push_back(key);
+        }
+      }
+      if (!keys.empty()) {
+        keys_.push_back(keys);
+      }
+    }
+    CHECK(!keys_.empty());
+  }
+
+  virtual string name() const { return "SessionHandler/EvalCommand"; }
+
+  virtual void SetUp() {
+    commands::Command command;
+    command.mutable_input()->set_type(commands::Input::CREATE_SESSION);
+    CHECK(handler_.EvalCommand(&command));
+    id_ = command.output().id();
+  }
+
+  virtual void PrepareOp() {
+    if (key_index_ < keys_[sentence_index_].size()) {
+      command_.Clear();
+      command_.mutable_input()->set_id(id_);
+      command_.mutable_input()->set_type(commands::Input::SEND_KEY);
+      command_.mutable_input()->mutable_key()->CopyFrom(
+          keys_[sentence_index_][key_index_++]);
+      return;
+    }
+    commands::Command revert;
+    revert.mutable_input()->set_id(id_);
+    revert.mutable_input()->set_type(commands::Input::SEND_COMMAND);
+    revert.mutable_input()->mutable_command()->set_type(
+        commands::SessionCommand::REVERT);
+    handler_.EvalCommand(&revert);
+    sentence_index_ = (sentence_index_ + 1) % keys_.size();
+    key_index_ = 0;
+    PrepareOp();
+  }
+
+  virtual void RunOp() {
+    handler_.EvalCommand(&command_);
+  }
+
+  virtual void TearDown() {
+    commands::Command command;
+    command.mutable_input()->set_id(id_);
+    command.mutable_input()->set_type(commands::Input::DELETE_SESSION);
+    handler_.EvalCommand(&command);
+  }
+
+ private:
+  SessionHandler handler_;
+  vector<vector<commands::KeyEvent> > keys_;
+  uint64 id_;
+  size_t sentence_index_;
+  size_t key_index_;
+  commands::Command command_;
+};
+
+void RunBenchmarks() {
+  const Environment env;
+
+  vector<BenchmarkInterface *> benchmarks;
+  benchmarks.push_back(new LoudsTrieBenchmark(
+      "LoudsTrie/ExactSearch", LoudsTrieBenchmark::EXACT, env));
+  benchmarks.push_back(new LoudsTrieBenchmark(
+      "LoudsTrie/PrefixSearch", LoudsTrieBenchmark::PREFIX, env));
+  benchmarks.push_back(new LoudsTrieBenchmark(
+      "LoudsTrie/PredictiveSearch", LoudsTrieBenchmark::PREDICTIVE, env));
+  benchmarks.push_back(new SystemDictionaryBenchmark(
+      "SystemDictionary/LookupPrefix", SystemDictionaryBenchmark::PREFIX,
+      env));
+  benchmarks.push_back(new SystemDictionaryBenchmark(
+      "SystemDictionary/LookupPredictive",
+      SystemDictionaryBenchmark::PREDICTIVE, env));
+  benchmarks.push_back(new SystemDictionaryBenchmark(
+      "SystemDictionary/LookupReverse", SystemDictionaryBenchmark::REVERSE,
+      env));
+  benchmarks.push_back(new ImmutableConverterBenchmark(env));
+  benchmarks.push_back(new DictionaryPredictorBenchmark(env));
+  benchmarks.push_back(new UserHistoryPredictorBenchmark(env));
+  benchmarks.push_back(new MergerRewriterBenchmark(env));
+  benchmarks.push_back(new SessionHandlerBenchmark(env));
+
+  BenchmarkRunner runner;
+  runner.set_min_ops(FLAGS_benchmark_min_ops);
+  runner.set_min_time_ms(FLAGS_benchmark_min_time_ms);
+
+  vector<BenchmarkResult> results;
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    if (benchmarks[i]->name().find(FLAGS_benchmark_filter) != string::npos) {
+      results.push_back(BenchmarkResult());
+      runner.Run(benchmarks[i], &results.back());
+    }
+    delete benchmarks[i];
+  }
+
+  cout << BenchmarkRunner::FormatAsText(results);
+  if (!FLAGS_benchmark_output.empty()) {
+    OutputFileStream ofs(FLAGS_benchmark_output.c_str());
+    ofs << BenchmarkRunner::FormatAsJson(results);
+  }
+}
+
+}  // namespace
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  InitGoogle(argv[0], &argc, &argv, false);
+
+  // The benchmarks learn the user history, so a scratch profile is used.
+  if (!mozc::FileUtil::DirectoryExists(FLAGS_user_profile_dir)) {
+    CHECK(mozc::FileUtil::CreateDirectory(FLAGS_user_profile_dir))
+        << "Cannot create " << FLAGS_user_profile_dir;
+  }
+  mozc::SystemUtil::SetUserProfileDirectory(FLAGS_user_profile_dir);
+
+  mozc::RunBenchmarks();
+  return 0;
+}
@@ -141,6 +141,32 @@ void CandidateList::Clear() {
   alternative_ids_->clear();
 }
 
+void CandidateList::CopyFrom(const CandidateList &src) {
+  Clear();
+  rotate_ = src.rotate_;
+  page_size_ = src.page_size_;
+  focused_index_ = src.focused_index_;
+  focused_ = src.focused_;
+  name_ = src.name_;
+  for (size_t i = 0; i < src.size(); ++i) {
+    const Candidate &src_candidate = src.candidate(i);
+    if (src_candidate.IsSubcandidateList()) {
+      const CandidateList &src_subcandidate_list =
+          src_candidate.subcandidate_list();
+      AllocateSubCandidateList(src_subcandidate_list.rotate_)->CopyFrom(
+          src_subcandidate_list);
+      continue;
+    }
+    Candidate *new_candidate = candidate_pool_->Alloc();
+    candidates_->push_back(new_candidate);
+    new_candidate->set_id(src_candidate.id());
+    new_candidate->set_attributes(src_candidate.attributes());
+  }
+  next_available_id_ = src.next_available_id_;
+  *added_candidates_ = *src.added_candidates_;
+  *alternative_ids_ = *src.alternative_ids_;
+}
+
 const Candidate &CandidateList::GetDeepestFocusedCandidate() const {
   if (focused_candidate().IsSubcandidateList()) {
     return focused_candidate().subcandidate_list().GetDeepestFocusedCandidate();
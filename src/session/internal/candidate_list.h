@@ -101,6 +101,8 @@ class CandidateList {
   virtual ~CandidateList();
 
   void Clear();
+  // Copies |src| including its subcandidate lists.
+  void CopyFrom(const CandidateList &src);
 
   const Candidate &GetDeepestFocusedCandidate() const;
   void AddCandidate(int id, const string &value);
@@ -472,5 +472,36 @@ TEST_F(CandidateListTest, NextAvailableId) {
   EXPECT_EQ(214, sub_sub_list_2_1_->next_available_id());
 }
 
+TEST_F(CandidateListTest, CopyFrom) {
+  main_list_->set_name("main");
+  // (main7, sub20, subsub211)
+  EXPECT_TRUE(main_list_->MoveToId(211));
+
+  CandidateList copied_list(false);
+  copied_list.CopyFrom(*main_list_);
+  EXPECT_EQ("main", copied_list.name());
+  EXPECT_EQ(main_list_->size(), copied_list.size());
+  EXPECT_EQ(main_list_->page_size(), copied_list.page_size());
+  EXPECT_EQ(211, copied_list.focused_id());
+  EXPECT_EQ(7, copied_list.focused_index());
+  EXPECT_EQ(213, copied_list.next_available_id());
+  for (size_t i = 0; i < main_list_->size(); ++i) {
+    EXPECT_EQ(main_list_->candidate(i).id(), copied_list.candidate(i).id());
+    EXPECT_EQ(main_list_->candidate(i).IsSubcandidateList(),
+              copied_list.candidate(i).IsSubcandidateList());
+  }
+
+  // The subcandidate lists are copied too.
+  EXPECT_TRUE(copied_list.MoveToId(-4));
+  EXPECT_EQ(-4, copied_list.focused_id());
+  EXPECT_EQ(211, main_list_->focused_id());
+  EXPECT_EQ(0, sub_list_1_->focused_index());
+
+  // The rotation of the list is copied.
+  copied_list.MoveLast();
+  EXPECT_TRUE(copied_list.MoveNext());
+  EXPECT_EQ(0, copied_list.focused_id());
+}
+
 }  // namespace session
 }  // namespace mozc
@@ -0,0 +1,125 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_SESSION_INTERNAL_COPY_ON_WRITE_PTR_H_
+#define MOZC_SESSION_INTERNAL_COPY_ON_WRITE_PTR_H_
+
+#include "base/port.h"
+#include "base/scoped_ptr.h"
+
+namespace mozc {
+namespace session {
+
+// Owning pointer whose object can be shared by several owners, e.g. a
+// session state and its undo snapshot. The object is cloned by the given
+// cloner on the first mutable access while it is shared, so only the objects
+// which are actually modified are copied.
+// The reference count is not atomic as the owners sharing an object are used
+// on the same thread.
+template <typename T>
+class CopyOnWritePtr {
+ public:
+  typedef T *(*Cloner)(const T &src);
+
+  explicit CopyOnWritePtr(Cloner cloner) : rep_(NULL), cloner_(cloner) {}
+  // Takes the ownership of |object|.
+  CopyOnWritePtr(T *object, Cloner cloner) : rep_(NULL), cloner_(cloner) {
+    reset(object);
+  }
+  ~CopyOnWritePtr() {
+    Release();
+  }
+
+  const T *get() const {
+    return (rep_ == NULL) ? NULL : rep_->object.get();
+  }
+  const T &operator*() const {
+    return *get();
+  }
+  const T *operator->() const {
+    return get();
+  }
+
+  // Clones the object if it is shared.
+  T *mutable_get() {
+    if (shared()) {
+      reset((*cloner_)(*rep_->object));
+    }
+    return (rep_ == NULL) ? NULL : rep_->object.get();
+  }
+
+  // Returns true if the object is shared with another owner. The caller
+  // going to discard the whole object can reset() it with a new one instead
+  // of cloning it by mutable_get().
+  bool shared() const {
+    return rep_ != NULL && rep_->ref_count > 1;
+  }
+
+  // Takes the ownership of |object|.
+  void reset(T *object) {
+    Release();
+    if (object != NULL) {
+      rep_ = new Rep(object);
+    }
+  }
+
+  void ShareFrom(const CopyOnWritePtr &other) {
+    if (rep_ == other.rep_) {
+      return;
+    }
+    Release();
+    rep_ = other.rep_;
+    if (rep_ != NULL) {
+      ++rep_->ref_count;
+    }
+  }
+
+ private:
+  struct Rep {
+    explicit Rep(T *obj) : object(obj), ref_count(1) {}
+    scoped_ptr<T> object;
+    int ref_count;
+  };
+
+  void Release() {
+    if (rep_ != NULL && --rep_->ref_count == 0) {
+      delete rep_;
+    }
+    rep_ = NULL;
+  }
+
+  Rep *rep_;
+  const Cloner cloner_;
+
+  DISALLOW_COPY_AND_ASSIGN(CopyOnWritePtr);
+};
+
+}  // namespace session
+}  // namespace mozc
+#endif  // MOZC_SESSION_INTERNAL_COPY_ON_WRITE_PTR_H_
@@ -0,0 +1,143 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "session/internal/copy_on_write_ptr.h"
+
+#include <string>
+
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace session {
+namespace {
+
+int g_clone_count = 0;
+
+string *CountingCloner(const string &src) {
+  ++g_clone_count;
+  return new string(src);
+}
+
+class CopyOnWritePtrTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    g_clone_count = 0;
+  }
+};
+
+TEST_F(CopyOnWritePtrTest, Basic) {
+  CopyOnWritePtr<string> empty(&CountingCloner);
+  EXPECT_TRUE(empty.get() == NULL);
+  EXPECT_TRUE(empty.mutable_get() == NULL);
+  EXPECT_FALSE(empty.shared());
+
+  CopyOnWritePtr<string> ptr(new string("abc"), &CountingCloner);
+  EXPECT_EQ("abc", *ptr);
+  EXPECT_EQ(3, ptr->size());
+  EXPECT_FALSE(ptr.shared());
+
+  // The object owned alone is never cloned.
+  const string *object = ptr.get();
+  ptr.mutable_get()->append("d");
+  EXPECT_EQ(object, ptr.get());
+  EXPECT_EQ("abcd", *ptr);
+
+  ptr.reset(new string("xyz"));
+  EXPECT_EQ("xyz", *ptr);
+  ptr.reset(NULL);
+  EXPECT_TRUE(ptr.get() == NULL);
+  EXPECT_EQ(0, g_clone_count);
+}
+
+TEST_F(CopyOnWritePtrTest, ShareFrom) {
+  CopyOnWritePtr<string> src(new string("abc"), &CountingCloner);
+  CopyOnWritePtr<string> dest(&CountingCloner);
+  dest.ShareFrom(src);
+  EXPECT_EQ(src.get(), dest.get());
+  EXPECT_TRUE(src.shared());
+  EXPECT_TRUE(dest.shared());
+
+  // Sharing the same object again is no-op.
+  dest.ShareFrom(src);
+  EXPECT_EQ(src.get(), dest.get());
+  EXPECT_EQ(0, g_clone_count);
+
+  // The object shared with |src| is released by |dest|.
+  dest.reset(new string("xyz"));
+  EXPECT_FALSE(src.shared());
+  EXPECT_FALSE(dest.shared());
+  EXPECT_EQ("abc", *src);
+  EXPECT_EQ("xyz", *dest);
+  EXPECT_EQ(0, g_clone_count);
+}
+
+TEST_F(CopyOnWritePtrTest, CloneOnlyOnFirstMutableAccess) {
+  CopyOnWritePtr<string> src(new string("abc"), &CountingCloner);
+  CopyOnWritePtr<string> dest(&CountingCloner);
+  dest.ShareFrom(src);
+
+  // Read accesses don't clone the object.
+  EXPECT_EQ("abc", *dest);
+  EXPECT_EQ(0, g_clone_count);
+
+  const string *shared_object = src.get();
+  dest.mutable_get()->append("d");
+  EXPECT_EQ(1, g_clone_count);
+  EXPECT_NE(shared_object, dest.get());
+  EXPECT_EQ(shared_object, src.get());
+  EXPECT_EQ("abc", *src);
+  EXPECT_EQ("abcd", *dest);
+  EXPECT_FALSE(src.shared());
+  EXPECT_FALSE(dest.shared());
+
+  // Neither of them is cloned any more.
+  dest.mutable_get()->append("e");
+  src.mutable_get()->append("f");
+  EXPECT_EQ(1, g_clone_count);
+  EXPECT_EQ("abcf", *src);
+  EXPECT_EQ("abcde", *dest);
+}
+
+TEST_F(CopyOnWritePtrTest, OutlivesOwner) {
+  CopyOnWritePtr<string> dest(&CountingCloner);
+  {
+    CopyOnWritePtr<string> src(new string("abc"), &CountingCloner);
+    dest.ShareFrom(src);
+  }
+  EXPECT_FALSE(dest.shared());
+  EXPECT_EQ("abc", *dest);
+  dest.mutable_get()->append("d");
+  EXPECT_EQ("abcd", *dest);
+  EXPECT_EQ(0, g_clone_count);
+}
+
+}  // namespace
+}  // namespace session
+}  // namespace mozc
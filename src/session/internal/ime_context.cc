@@ -44,29 +44,44 @@ using commands::Request;
 ImeContext::ImeContext()
     : create_time_(0),
       last_command_time_(0),
+      composer_(&ImeContext::CloneComposer),
+      converter_(&ImeContext::CloneConverter),
       state_(NONE),
-      request_(&Request::default_instance()) {
+      request_(&Request::default_instance()),
+      output_(&ImeContext::CloneOutput) {
+  output_.reset(new commands::Output);
 }
 ImeContext::~ImeContext() {}
 
 const composer::Composer &ImeContext::composer() const {
   DCHECK(composer_.get());
-  return *composer_;
+  return *composer_.get();
 }
 composer::Composer *ImeContext::mutable_composer() {
   DCHECK(composer_.get());
-  return composer_.get();
+  return composer_.mutable_get();
 }
 void ImeContext::set_composer(composer::Composer *composer) {
   DCHECK(composer);
   composer_.reset(composer);
 }
 
+void ImeContext::ResetComposer() {
+  DCHECK(composer_.get());
+  if (composer_.shared()) {
+    composer::Composer *composer = new composer::Composer(NULL, NULL);
+    composer->CopySettingsFrom(*composer_);
+    composer_.reset(composer);
+    return;
+  }
+  composer_.mutable_get()->Reset();
+}
+
 const SessionConverterInterface &ImeContext::converter() const {
-  return *converter_;
+  return *converter_.get();
 }
 SessionConverterInterface *ImeContext::mutable_converter() {
-  return converter_.get();
+  return converter_.mutable_get();
 }
 void ImeContext::set_converter(SessionConverterInterface *converter) {
   converter_.reset(converter);
@@ -74,8 +89,8 @@ void ImeContext::set_converter(SessionConverterInterface *converter) {
 
 void ImeContext::SetRequest(const commands::Request *request) {
   request_ = request;
-  converter_->SetRequest(request_);
-  composer_->SetRequest(request_);
+  mutable_converter()->SetRequest(request_);
+  mutable_composer()->SetRequest(request_);
 }
 
 const commands::Request &ImeContext::GetRequest() const {
@@ -83,6 +98,36 @@ const commands::Request &ImeContext::GetRequest() const {
   return *request_;
 }
 
+const commands::Output &ImeContext::output() const {
+  return *output_.get();
+}
+commands::Output *ImeContext::mutable_output() {
+  return output_.mutable_get();
+}
+void ImeContext::set_output(const commands::Output &output) {
+  output_.reset(CloneOutput(output));
+}
+
+// static
+composer::Composer *ImeContext::CloneComposer(const composer::Composer &src) {
+  composer::Composer *composer = new composer::Composer(NULL, NULL);
+  composer->CopyFrom(src);
+  return composer;
+}
+
+// static
+SessionConverterInterface *ImeContext::CloneConverter(
+    const SessionConverterInterface &src) {
+  return src.Clone();
+}
+
+// static
+commands::Output *ImeContext::CloneOutput(const commands::Output &src) {
+  commands::Output *output = new commands::Output;
+  output->CopyFrom(src);
+  return output;
+}
+
 // static
 void ImeContext::CopyContext(const ImeContext &src, ImeContext *dest) {
   DCHECK(dest);
@@ -90,8 +135,8 @@ void ImeContext::CopyContext(const ImeContext &src, ImeContext *dest) {
   dest->set_create_time(src.create_time());
   dest->set_last_command_time(src.last_command_time());
 
-  dest->mutable_composer()->CopyFrom(src.composer());
-  dest->converter_.reset(src.converter().Clone());
+  dest->composer_.ShareFrom(src.composer_);
+  dest->converter_.ShareFrom(src.converter_);
 
   dest->set_state(src.state());
   dest->set_keymap(src.keymap());
@@ -102,7 +147,7 @@ void ImeContext::CopyContext(const ImeContext &src, ImeContext *dest) {
   dest->mutable_application_info()->CopyFrom(src.application_info());
   dest->mutable_composition_rectangle()->CopyFrom(src.composition_rectangle());
   dest->mutable_caret_rectangle()->CopyFrom(src.caret_rectangle());
-  dest->mutable_output()->CopyFrom(src.output());
+  dest->output_.ShareFrom(src.output_);
 }
 
 }  // namespace session
@@ -36,6 +36,7 @@
 #include "base/port.h"
 #include "base/scoped_ptr.h"
 #include "session/commands.pb.h"
+#include "session/internal/copy_on_write_ptr.h"
 
 namespace mozc {
 
@@ -70,6 +71,9 @@ class ImeContext {
   const composer::Composer &composer() const;
   composer::Composer *mutable_composer();
   void set_composer(composer::Composer *composer);
+  // Resets the composer. Unlike mutable_composer()->Reset(), this doesn't
+  // copy the composition when the composer is shared with another context.
+  void ResetComposer();
 
   const SessionConverterInterface &converter() const;
   SessionConverterInterface *mutable_converter();
@@ -137,19 +141,27 @@ class ImeContext {
     return &caret_rectangle_;
   }
 
-  const commands::Output &output() const {
-    return output_;
-  }
-  commands::Output *mutable_output() {
-    return &output_;
-  }
+  const commands::Output &output() const;
+  commands::Output *mutable_output();
+  // Replaces the output with a copy of |output|. Unlike
+  // mutable_output()->CopyFrom(), this doesn't copy the current output
+  // when it is shared with another context.
+  void set_output(const commands::Output &output);
 
   // Copy |source| context to |destination| context.
+  // The composer, the converter and the output are not copied here but
+  // shared between the two contexts, and each context clones them on its
+  // first mutable access. This keeps taking an undo snapshot O(1).
   // TODO(hsumita): Renames it as CopyFrom and make it non-static to keep
   // consistency with other classes.
   static void CopyContext(const ImeContext &src, ImeContext *dest);
 
  private:
+  static composer::Composer *CloneComposer(const composer::Composer &src);
+  static SessionConverterInterface *CloneConverter(
+      const SessionConverterInterface &src);
+  static commands::Output *CloneOutput(const commands::Output &src);
+
   // TODO(team): Actual use of |create_time_| is to keep the time when the
   // session holding this instance is created and not the time when this
   // instance is created. We may want to move out |create_time_| from ImeContext
@@ -157,9 +169,9 @@ class ImeContext {
   uint64 create_time_;
   uint64 last_command_time_;
 
-  scoped_ptr<composer::Composer> composer_;
+  CopyOnWritePtr<composer::Composer> composer_;
 
-  scoped_ptr<SessionConverterInterface> converter_;
+  CopyOnWritePtr<SessionConverterInterface> converter_;
 
   State state_;
 
@@ -180,7 +192,7 @@ class ImeContext {
 
   // Storing the last output consisting of the last result and the
   // last performed command.
-  commands::Output output_;
+  CopyOnWritePtr<commands::Output> output_;
 
   DISALLOW_COPY_AND_ASSIGN(ImeContext);
 };
@@ -217,5 +217,93 @@ TEST(ImeContextTest, CopyContext) {
   }
 }
 
+TEST(ImeContextTest, CopyContextIsCopyOnWrite) {
+  composer::Table table;
+  // "あ"
+  table.AddRule("a", "\xE3\x81\x82", "");
+  // "い"
+  table.AddRule("i", "\xE3\x81\x84", "");
+
+  scoped_ptr<MockConverterEngine> engine(new MockConverterEngine);
+  const commands::Request default_request;
+
+  ImeContext source;
+  source.set_composer(new composer::Composer(&table, &default_request));
+  source.set_converter(new SessionConverter(
+      engine->GetConverter(), &default_request));
+  source.mutable_composer()->InsertCharacter("a");
+  source.mutable_output()->set_id(1);
+
+  // Nothing is copied until either of the contexts is modified.
+  ImeContext destination;
+  ImeContext::CopyContext(source, &destination);
+  EXPECT_EQ(&source.composer(), &destination.composer());
+  EXPECT_EQ(&source.converter(), &destination.converter());
+  EXPECT_EQ(&source.output(), &destination.output());
+
+  // Modifying the destination doesn't affect the source.
+  destination.mutable_composer()->InsertCharacter("i");
+  EXPECT_NE(&source.composer(), &destination.composer());
+  string composition;
+  source.composer().GetStringForPreedit(&composition);
+  // "あ"
+  EXPECT_EQ("\xE3\x81\x82", composition);
+  composition.clear();
+  destination.composer().GetStringForPreedit(&composition);
+  // "あい"
+  EXPECT_EQ("\xE3\x81\x82\xE3\x81\x84", composition);
+
+  // Once copied, the object is owned by the context alone.
+  const composer::Composer *composer = &destination.composer();
+  EXPECT_EQ(composer, destination.mutable_composer());
+
+  // Modifying the source doesn't affect the destination either.
+  const SessionConverterInterface *converter = &destination.converter();
+  EXPECT_NE(converter, source.mutable_converter());
+  EXPECT_EQ(converter, &destination.converter());
+
+  commands::Output output;
+  output.set_id(2);
+  destination.set_output(output);
+  EXPECT_EQ(1, source.output().id());
+  EXPECT_EQ(2, destination.output().id());
+  destination.mutable_output()->set_id(3);
+  EXPECT_EQ(1, source.output().id());
+  EXPECT_EQ(3, destination.output().id());
+}
+
+TEST(ImeContextTest, ResetComposerDoesNotCopySharedComposer) {
+  composer::Table table;
+  // "あ"
+  table.AddRule("a", "\xE3\x81\x82", "");
+
+  const commands::Request default_request;
+  ImeContext source;
+  source.set_composer(new composer::Composer(&table, &default_request));
+  source.mutable_composer()->SetInputMode(transliteration::FULL_KATAKANA);
+  source.mutable_composer()->InsertCharacter("a");
+  const composer::Composer *composer = &source.composer();
+
+  // Resetting the shared composer replaces it with an empty one, and leaves
+  // the composition of the other context intact.
+  ImeContext destination;
+  ImeContext::CopyContext(source, &destination);
+  destination.ResetComposer();
+  EXPECT_NE(composer, &destination.composer());
+  EXPECT_TRUE(destination.composer().Empty());
+  EXPECT_EQ(transliteration::FULL_KATAKANA,
+            destination.composer().GetInputMode());
+  EXPECT_EQ(composer, &source.composer());
+  string composition;
+  source.composer().GetStringForPreedit(&composition);
+  // "ア"
+  EXPECT_EQ("\xE3\x82\xA2", composition);
+
+  // Resetting the composer owned alone resets it in place.
+  source.ResetComposer();
+  EXPECT_EQ(composer, &source.composer());
+  EXPECT_TRUE(source.composer().Empty());
+}
+
 }  // namespace session
 }  // namespace mozc
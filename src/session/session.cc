@@ -137,7 +137,7 @@ void SetSessionState(const ImeContext::State state, ImeContext *context) {
   switch (state) {
     case ImeContext::DIRECT:
     case ImeContext::PRECOMPOSITION:
-      context->mutable_composer()->Reset();
+      context->ResetComposer();
       break;
     case ImeContext::CONVERSION:
       context->mutable_composer()->ResetInputMode();
@@ -233,14 +233,15 @@ void Session::InitContext(ImeContext *context) const {
 #endif
   context->mutable_client_context()->Clear();
 
-  UpdateConfig(config::ConfigHandler::GetConfig(), context);
+  UpdateConfig(config::ConfigHandler::GetConfigSnapshot(), context);
 }
 
 
 void Session::PushUndoContext() {
   // TODO(komatsu): Support multiple undo.
+  // The composer and the converter are shared with |context_| until either
+  // of the contexts modifies them.
   prev_context_.reset(new ImeContext);
-  InitContext(prev_context_.get());
   ImeContext::CopyContext(*context_, prev_context_.get());
 }
 
@@ -1117,7 +1118,7 @@ void Session::SetTable(const composer::Table *table) {
 }
 
 void Session::ReloadConfig() {
-  UpdateConfig(config::ConfigHandler::GetConfig(), context_.get());
+  UpdateConfig(config::ConfigHandler::GetConfigSnapshot(), context_.get());
 }
 
 void Session::SetRequest(const commands::Request *request) {
@@ -1126,12 +1127,14 @@ void Session::SetRequest(const commands::Request *request) {
 }
 
 // static
-void Session::UpdateConfig(const config::Config &config, ImeContext *context) {
-  context->set_keymap(config.session_keymap());
+void Session::UpdateConfig(const config::ConfigSnapshot &config,
+                           ImeContext *context) {
+  context->set_keymap(config.get().session_keymap());
 
-  Singleton<KeyEventTransformer>::get()->ReloadConfig(config);
+  Singleton<KeyEventTransformer>::get()->ReloadConfig(config.get());
   context->mutable_composer()->ReloadConfig();
-  UpdateOperationPreferences(config, context);
+  context->mutable_converter()->SetConfig(config);
+  UpdateOperationPreferences(config.get(), context);
 }
 
 // static
@@ -1360,7 +1363,7 @@ bool Session::CommitCandidate(commands::Command *command) {
         context_->mutable_composer()->DeleteRange(0, consumed_key_size);
         MoveCursorToEnd(command);
         // Copy the previous output for Undo.
-        context_->mutable_output()->CopyFrom(command->output());
+        context_->set_output(command->output());
         return true;
       }
     }
@@ -1380,7 +1383,7 @@ bool Session::CommitCandidate(commands::Command *command) {
   }
   Output(command);
   // Copy the previous output for Undo.
-  context_->mutable_output()->CopyFrom(command->output());
+  context_->set_output(command->output());
   return true;
 }
 
@@ -1766,7 +1769,7 @@ bool Session::CommitInternal(commands::Command *command,
 
   Output(command);
   // Copy the previous output for Undo.
-  context_->mutable_output()->CopyFrom(command->output());
+  context_->set_output(command->output());
   return true;
 }
 
@@ -1825,7 +1828,7 @@ bool Session::CommitFirstSuggestion(commands::Command *command) {
 
   Output(command);
   // Copy the previous output for Undo.
-  context_->mutable_output()->CopyFrom(command->output());
+  context_->set_output(command->output());
   return true;
 }
 
@@ -1852,7 +1855,7 @@ bool Session::CommitSegment(commands::Command *command) {
   }
   Output(command);
   // Copy the previous output for Undo.
-  context_->mutable_output()->CopyFrom(command->output());
+  context_->set_output(command->output());
   return true;
 }
 
@@ -56,6 +56,10 @@ namespace composer {
 class Table;
 }  // namespace composer
 
+namespace config {
+class ConfigSnapshot;
+}  // namespace config
+
 class EngineInterface;
 
 namespace session {
@@ -268,8 +272,9 @@ class Session : public SessionInterface {
 
   const ImeContext &context() const;
 
-  // Update config of |context| referring |config|.
-  static void UpdateConfig(const mozc::config::Config &config,
+  // Update config of |context| referring |config|. The converter of
+  // |context| keeps |config| for the following conversions.
+  static void UpdateConfig(const mozc::config::ConfigSnapshot &config,
                            ImeContext *context);
 
   // Set OperationPreferences on |context| by using (tentative) |config|.
@@ -38,6 +38,7 @@
 #include "base/logging.h"
 #include "base/port.h"
 #include "base/text_normalizer.h"
+#include "base/trace.h"
 #include "base/util.h"
 #include "composer/composer.h"
 #include "config/config.pb.h"
@@ -90,6 +91,44 @@ void SetIncognitoMode(bool enabled) {
   ConfigHandler::SetConfig(config);
 }
 
+Segments *CloneSegments(const Segments &src) {
+  Segments *segments = new Segments;
+  segments->CopyFrom(src);
+  return segments;
+}
+
+// Copies |src| except its conversion segments. The result is the same as
+// CloneSegments() followed by Segments::clear_conversion_segments().
+Segments *CloneHistorySegments(const Segments &src) {
+  Segments *segments = new Segments;
+  segments->set_max_history_segments_size(src.max_history_segments_size());
+  segments->set_max_prediction_candidates_size(
+      src.max_prediction_candidates_size());
+  segments->set_max_conversion_candidates_size(
+      src.max_conversion_candidates_size());
+  segments->set_user_history_enabled(src.user_history_enabled());
+  segments->set_request_type(src.request_type());
+  for (size_t i = 0; i < src.history_segments_size(); ++i) {
+    segments->add_segment()->CopyFrom(src.history_segment(i));
+  }
+  for (size_t i = 0; i < src.revert_entries_size(); ++i) {
+    segments->push_back_revert_entry()->CopyFrom(src.revert_entry(i));
+  }
+  return segments;
+}
+
+Segment *CloneSegment(const Segment &src) {
+  Segment *segment = new Segment;
+  segment->CopyFrom(src);
+  return segment;
+}
+
+CandidateList *CloneCandidateList(const CandidateList &src) {
+  CandidateList *candidate_list = new CandidateList(true);
+  candidate_list->CopyFrom(src);
+  return candidate_list;
+}
+
 }  // namespace
 
 const size_t SessionConverter::kConsumedAllCharacters =
@@ -100,12 +139,14 @@ SessionConverter::SessionConverter(const ConverterInterface *converter,
     : SessionConverterInterface(),
       state_(COMPOSITION),
       converter_(converter),
-      segments_(new Segments),
+      segments_(new Segments, &CloneSegments),
       segment_index_(0),
+      previous_suggestions_(new Segment, &CloneSegment),
       result_(new commands::Result),
-      candidate_list_(new CandidateList(true)),
+      candidate_list_(new CandidateList(true), &CloneCandidateList),
       candidate_list_visible_(false),
       request_(request),
+      config_(config::ConfigHandler::GetConfigSnapshot()),
       client_revision_(0) {
   conversion_preferences_.use_history = true;
   conversion_preferences_.max_history_size = kDefaultMaxHistorySize;
@@ -146,12 +187,12 @@ bool SessionConverter::ConvertWithPreferences(
     const ConversionPreferences &preferences) {
   DCHECK(CheckState(COMPOSITION | SUGGESTION | CONVERSION));
 
-  segments_->set_request_type(Segments::CONVERSION);
-  SetConversionPreferences(preferences, segments_.get());
+  segments_.mutable_get()->set_request_type(Segments::CONVERSION);
+  SetConversionPreferences(preferences, segments_.mutable_get());
 
-  const ConversionRequest conversion_request(&composer, request_);
+  const ConversionRequest conversion_request(&composer, request_, config_);
   if (!converter_->StartConversionForRequest(conversion_request,
-                                             segments_.get())) {
+                                             segments_.mutable_get())) {
     LOG(WARNING) << "StartConversionForRequest() failed";
     ResetState();
     return false;
@@ -265,7 +306,7 @@ bool SessionConverter::ConvertToTransliteration(
     }
 
     DCHECK(CheckState(CONVERSION));
-    candidate_list_->MoveToAttributes(query_attr);
+    candidate_list_.mutable_get()->MoveToAttributes(query_attr);
   } else {
     DCHECK(CheckState(CONVERSION));
     const Attributes current_attr =
@@ -277,7 +318,7 @@ bool SessionConverter::ConvertToTransliteration(
       query_attr |= (current_attr & (UPPER | LOWER | CAPITALIZED));
     }
 
-    candidate_list_->MoveNextAttributes(query_attr);
+    candidate_list_.mutable_get()->MoveNextAttributes(query_attr);
   }
   candidate_list_visible_ = false;
   // Treat as top conversion candidate on usage stats.
@@ -337,8 +378,8 @@ bool SessionConverter::SwitchKanaType(const composer::Composer &composer) {
     if (segments_->conversion_segments_size() != 1) {
       string composition;
       GetPreedit(0, segments_->conversion_segments_size(), &composition);
-      const ConversionRequest conversion_request(&composer, request_);
-      converter_->ResizeSegment(segments_.get(),
+      const ConversionRequest conversion_request(&composer, request_, config_);
+      converter_->ResizeSegment(segments_.mutable_get(),
                                 conversion_request,
                                 0, Util::CharsLen(composition));
       UpdateCandidateList();
@@ -360,7 +401,7 @@ bool SessionConverter::SwitchKanaType(const composer::Composer &composer) {
   }
 
   DCHECK(CheckState(CONVERSION));
-  candidate_list_->MoveNextAttributes(attributes);
+  candidate_list_.mutable_get()->MoveNextAttributes(attributes);
   candidate_list_visible_ = false;
   // Treat as top conversion candidate on usage stats.
   selected_candidate_indices_[segment_index_] = 0;
@@ -418,9 +459,9 @@ bool SessionConverter::SuggestWithPreferences(
   }
 
   // Initialize the segments for suggestion.
-  SetConversionPreferences(preferences, segments_.get());
+  SetConversionPreferences(preferences, segments_.mutable_get());
 
-  ConversionRequest conversion_request(&composer, request_);
+  ConversionRequest conversion_request(&composer, request_, config_);
   const size_t cursor = composer.GetCursor();
   if (cursor == composer.GetLength() || cursor == 0 ||
       !request_->mixed_conversion()) {
@@ -429,13 +470,13 @@ bool SessionConverter::SuggestWithPreferences(
     conversion_request.set_use_actual_converter_for_realtime_conversion(
         FLAGS_use_actual_converter_for_realtime_conversion);
     if (!converter_->StartSuggestionForRequest(conversion_request,
-                                               segments_.get())) {
+                                               segments_.mutable_get())) {
       // TODO(komatsu): Because suggestion is a prefix search, once
       // StartSuggestion returns false, this GetSuggestion always
       // returns false.  Refactor it.
       VLOG(1) << "StartSuggestionForRequest() returns no suggestions.";
       // Clear segments and keep the context
-      converter_->CancelConversion(segments_.get());
+      converter_->CancelConversion(segments_.mutable_get());
       return false;
     }
   } else {
@@ -446,11 +487,11 @@ bool SessionConverter::SuggestWithPreferences(
     // implementation reason. If the flag is true, all the composition
     // characters will be used in the below process, which conflicts
     // with *partial* prediction.
-    if (!converter_->StartPartialSuggestionForRequest(conversion_request,
-                                                      segments_.get())) {
+    if (!converter_->StartPartialSuggestionForRequest(
+            conversion_request, segments_.mutable_get())) {
       VLOG(1) << "StartPartialSuggestionForRequest() returns no suggestions.";
       // Clear segments and keep the context
-      converter_->CancelConversion(segments_.get());
+      converter_->CancelConversion(segments_.mutable_get());
       return false;
     }
   }
@@ -458,7 +499,7 @@ bool SessionConverter::SuggestWithPreferences(
 
   // Copy current suggestions so that we can merge
   // prediction/suggestions later
-  previous_suggestions_.CopyFrom(segments_->conversion_segment(0));
+  previous_suggestions_.reset(CloneSegment(segments_->conversion_segment(0)));
 
   // TODO(komatsu): the next line can be deleted.
   segment_index_ = 0;
@@ -488,27 +529,27 @@ bool SessionConverter::PredictWithPreferences(
   ResetResult();
 
   // Initialize the segments for prediction
-  segments_->set_request_type(Segments::PREDICTION);
-  SetConversionPreferences(preferences, segments_.get());
+  segments_.mutable_get()->set_request_type(Segments::PREDICTION);
+  SetConversionPreferences(preferences, segments_.mutable_get());
 
   const bool predict_first =
-      !CheckState(PREDICTION) && IsEmptySegment(previous_suggestions_);
+      !CheckState(PREDICTION) && IsEmptySegment(*previous_suggestions_);
 
   const bool predict_expand =
       (CheckState(PREDICTION) &&
-       !IsEmptySegment(previous_suggestions_) &&
+       !IsEmptySegment(*previous_suggestions_) &&
        candidate_list_->size() > 0 &&
        candidate_list_->focused() &&
        candidate_list_->focused_index() == candidate_list_->last_index());
 
-  segments_->clear_conversion_segments();
+  segments_.mutable_get()->clear_conversion_segments();
 
   if (predict_expand || predict_first) {
-    ConversionRequest conversion_request(&composer, request_);
+    ConversionRequest conversion_request(&composer, request_, config_);
     conversion_request.set_use_actual_converter_for_realtime_conversion(
         FLAGS_use_actual_converter_for_realtime_conversion);
     if (!converter_->StartPredictionForRequest(conversion_request,
-                                               segments_.get())) {
+                                               segments_.mutable_get())) {
       LOG(WARNING) << "StartPredictionForRequest() failed";
 
       // TODO(komatsu): Perform refactoring after checking the stability test.
@@ -525,7 +566,7 @@ bool SessionConverter::PredictWithPreferences(
   // Merge suggestions and prediction
   string preedit;
   composer.GetQueryForPrediction(&preedit);
-  PrependCandidates(previous_suggestions_, preedit, segments_.get());
+  PrependCandidates(*previous_suggestions_, preedit, segments_.mutable_get());
 
   segment_index_ = 0;
   state_ = PREDICTION;
@@ -561,7 +602,7 @@ bool SessionConverter::ExpandSuggestionWithPreferences(
   //     after implemention of partial conversion.
 
   // Initialize the segments for prediction.
-  SetConversionPreferences(preferences, segments_.get());
+  SetConversionPreferences(preferences, segments_.mutable_get());
 
   string preedit;
   composer.GetQueryForPrediction(&preedit);
@@ -570,7 +611,7 @@ bool SessionConverter::ExpandSuggestionWithPreferences(
   // Without this statement we can add additional candidates into
   // existing segments.
 
-  ConversionRequest conversion_request(&composer, request_);
+  ConversionRequest conversion_request(&composer, request_, config_);
 
   const size_t cursor = composer.GetCursor();
   if (cursor == composer.GetLength() || cursor == 0 ||
@@ -583,25 +624,25 @@ bool SessionConverter::ExpandSuggestionWithPreferences(
     // TODO(matsuzakit or yamaguchi): Add ExpandSuggestion method
     //    to Converter class.
     if (!converter_->StartPredictionForRequest(conversion_request,
-                                               segments_.get())) {
+                                               segments_.mutable_get())) {
       LOG(WARNING) << "StartPredictionForRequest() failed";
     }
   } else {
     // c.f. SuggestWithPreferences for ConversionRequest flags.
-    if (!converter_->StartPartialPredictionForRequest(conversion_request,
-                                                      segments_.get())) {
+    if (!converter_->StartPartialPredictionForRequest(
+            conversion_request, segments_.mutable_get())) {
       VLOG(1) << "StartPartialPredictionForRequest() returns no suggestions.";
       // Clear segments and keep the context
-      converter_->CancelConversion(segments_.get());
+      converter_->CancelConversion(segments_.mutable_get());
       return false;
     }
   }
   // Overwrite the request type to SUGGESTION.
   // Without this logic, a candidate gets focused that is unexpected behavior.
-  segments_->set_request_type(Segments::SUGGESTION);
+  segments_.mutable_get()->set_request_type(Segments::SUGGESTION);
 
   // Merge suggestions and predictions.
-  PrependCandidates(previous_suggestions_, preedit, segments_.get());
+  PrependCandidates(*previous_suggestions_, preedit, segments_.mutable_get());
 
   segment_index_ = 0;
   // Call AppendCandidateList instead of UpdateCandidateList because
@@ -619,7 +660,7 @@ void SessionConverter::MaybeExpandPrediction(
 
   // Expand the current suggestions and fill with Prediction results.
   if (!CheckState(PREDICTION) ||
-      IsEmptySegment(previous_suggestions_) ||
+      IsEmptySegment(*previous_suggestions_) ||
       !candidate_list_->focused() ||
       candidate_list_->focused_index() != candidate_list_->last_index()) {
     return;
@@ -634,7 +675,8 @@ void SessionConverter::MaybeExpandPrediction(
   }
 
   DCHECK_LT(previous_index, candidate_list_->size());
-  candidate_list_->MoveToId(candidate_list_->candidate(previous_index).id());
+  const int id = candidate_list_->candidate(previous_index).id();
+  candidate_list_.mutable_get()->MoveToId(id);
   UpdateSelectedCandidateIndex();
 }
 
@@ -643,7 +685,7 @@ void SessionConverter::Cancel() {
   ResetResult();
 
   // Clear segments and keep the context
-  converter_->CancelConversion(segments_.get());
+  converter_->CancelConversion(segments_.mutable_get());
   ResetState();
 }
 
@@ -652,7 +694,7 @@ void SessionConverter::Reset() {
 
   // Even if composition mode, call ResetConversion
   // in order to clear history segments.
-  converter_->ResetConversion(segments_.get());
+  converter_->ResetConversion(segments_.mutable_get());
 
   if (CheckState(COMPOSITION)) {
     return;
@@ -675,13 +717,13 @@ void SessionConverter::Commit(const composer::Composer &composer,
   }
 
   for (size_t i = 0; i < segments_->conversion_segments_size(); ++i) {
-    converter_->CommitSegmentValue(segments_.get(),
+    converter_->CommitSegmentValue(segments_.mutable_get(),
                                    i,
                                    GetCandidateIndexForConverter(i));
   }
   CommitUsageStats(state_, context);
-  ConversionRequest conversion_request(&composer, request_);
-  converter_->FinishConversion(conversion_request, segments_.get());
+  ConversionRequest conversion_request(&composer, request_, config_);
+  converter_->FinishConversion(conversion_request, segments_.mutable_get());
   ResetState();
 }
 
@@ -711,7 +753,7 @@ bool SessionConverter::CommitSuggestionInternal(
       *consumed_key_size < composer.GetLength()) {
     // A candidate was chosen from partial suggestion.
     converter_->CommitPartialSuggestionSegmentValue(
-        segments_.get(),
+        segments_.mutable_get(),
         0,
         GetCandidateIndexForConverter(0),
         Util::SubString(preedit, 0, *consumed_key_size),
@@ -725,12 +767,12 @@ bool SessionConverter::CommitSuggestionInternal(
     DCHECK_GT(segments_->conversion_segments_size(), 0);
   } else {
     // Not partial suggestion so let's reset the state.
-    converter_->CommitSegmentValue(segments_.get(),
+    converter_->CommitSegmentValue(segments_.mutable_get(),
                                    0,
                                    GetCandidateIndexForConverter(0));
     CommitUsageStats(SessionConverterInterface::SUGGESTION, context);
-    ConversionRequest conversion_request(&composer, request_);
-    converter_->FinishConversion(conversion_request, segments_.get());
+    ConversionRequest conversion_request(&composer, request_, config_);
+    converter_->FinishConversion(conversion_request, segments_.mutable_get());
     DCHECK_EQ(0, segments_->conversion_segments_size());
     ResetState();
   }
@@ -747,7 +789,7 @@ bool SessionConverter::CommitSuggestionByIndex(
     LOG(ERROR) << "index is out of the range: " << index;
     return false;
   }
-  candidate_list_->MoveToPageIndex(index);
+  candidate_list_.mutable_get()->MoveToPageIndex(index);
   UpdateSelectedCandidateIndex();
   return CommitSuggestionInternal(composer, context, consumed_key_size);
 }
@@ -758,7 +800,7 @@ bool SessionConverter::CommitSuggestionById(
     const commands::Context &context,
     size_t *consumed_key_size) {
   DCHECK(CheckState(SUGGESTION));
-  if (!candidate_list_->MoveToId(id)) {
+  if (!candidate_list_.mutable_get()->MoveToId(id)) {
     // Don't use CandidateMoveToId() method, which overwrites candidates.
     // This is harmful for EXPAND_SUGGESTION session command.
     LOG(ERROR) << "No id found";
@@ -812,7 +854,7 @@ void SessionConverter::CommitSegmentsInternal(
   vector<size_t> candidate_ids;
   for (size_t i = 0; i < segments_to_commit; ++i) {
     // Get the i-th (0 origin) conversion segment and the selected candidate.
-    Segment *segment = segments_->mutable_conversion_segment(i);
+    Segment *segment = segments_.mutable_get()->mutable_conversion_segment(i);
     if (segment == NULL) {
       LOG(ERROR) << "There is no segment on position " << i;
       return;
@@ -825,7 +867,7 @@ void SessionConverter::CommitSegmentsInternal(
     // Collect candidate's id for each segment.
     candidate_ids.push_back(GetCandidateIndexForConverter(i));
   }
-  converter_->CommitSegments(segments_.get(), candidate_ids);
+  converter_->CommitSegments(segments_.mutable_get(), candidate_ids);
 
   // Commit the [0, segments_to_commit - 1] conversion segment.
   CommitUsageStatsWithSegmentsSize(state_, context, segments_to_commit);
@@ -846,12 +888,17 @@ void SessionConverter::CommitPreedit(const composer::Composer &composer,
   TextNormalizer::NormalizePreeditText(preedit, &normalized_preedit);
   SessionOutput::FillPreeditResult(preedit, result_.get());
 
+  // The conversion segments are replaced below, so only the history segments
+  // are copied when the segments are shared with a clone.
+  if (segments_.shared()) {
+    segments_.reset(CloneHistorySegments(*segments_));
+  }
   ConverterUtil::InitSegmentsFromString(key, normalized_preedit,
-                                        segments_.get());
+                                        segments_.mutable_get());
 
   CommitUsageStats(SessionConverterInterface::COMPOSITION, context);
-  ConversionRequest conversion_request(&composer, request_);
-  converter_->FinishConversion(conversion_request, segments_.get());
+  ConversionRequest conversion_request(&composer, request_, config_);
+  converter_->FinishConversion(conversion_request, segments_.mutable_get());
   ResetState();
 }
 
@@ -872,7 +919,7 @@ void SessionConverter::CommitHead(
 }
 
 void SessionConverter::Revert() {
-  converter_->RevertConversion(segments_.get());
+  converter_->RevertConversion(segments_.mutable_get());
 }
 
 void SessionConverter::SegmentFocusInternal(size_t index) {
@@ -930,8 +977,8 @@ void SessionConverter::ResizeSegmentWidth(const composer::Composer &composer,
   }
   ResetResult();
 
-  const ConversionRequest conversion_request(&composer, request_);
-  if (!converter_->ResizeSegment(segments_.get(),
+  const ConversionRequest conversion_request(&composer, request_, config_);
+  if (!converter_->ResizeSegment(segments_.mutable_get(),
                                  conversion_request,
                                  segment_index_, delta)) {
     return;
@@ -969,7 +1016,7 @@ void SessionConverter::CandidateNext(const composer::Composer &composer) {
   ResetResult();
 
   MaybeExpandPrediction(composer);
-  candidate_list_->MoveNext();
+  candidate_list_.mutable_get()->MoveNext();
   candidate_list_visible_ = true;
   UpdateSelectedCandidateIndex();
   SegmentFocus();
@@ -979,7 +1026,7 @@ void SessionConverter::CandidateNextPage() {
   DCHECK(CheckState(PREDICTION | CONVERSION));
   ResetResult();
 
-  candidate_list_->MoveNextPage();
+  candidate_list_.mutable_get()->MoveNextPage();
   candidate_list_visible_ = true;
   UpdateSelectedCandidateIndex();
   SegmentFocus();
@@ -989,7 +1036,7 @@ void SessionConverter::CandidatePrev() {
   DCHECK(CheckState(PREDICTION | CONVERSION));
   ResetResult();
 
-  candidate_list_->MovePrev();
+  candidate_list_.mutable_get()->MovePrev();
   candidate_list_visible_ = true;
   UpdateSelectedCandidateIndex();
   SegmentFocus();
@@ -999,7 +1046,7 @@ void SessionConverter::CandidatePrevPage() {
   DCHECK(CheckState(PREDICTION | CONVERSION));
   ResetResult();
 
-  candidate_list_->MovePrevPage();
+  candidate_list_.mutable_get()->MovePrevPage();
   candidate_list_visible_ = true;
   UpdateSelectedCandidateIndex();
   SegmentFocus();
@@ -1019,7 +1066,7 @@ void SessionConverter::CandidateMoveToId(
   }
   DCHECK(CheckState(PREDICTION | CONVERSION));
 
-  candidate_list_->MoveToId(id);
+  candidate_list_.mutable_get()->MoveToId(id);
   candidate_list_visible_ = false;
   UpdateSelectedCandidateIndex();
   SegmentFocus();
@@ -1029,7 +1076,7 @@ void SessionConverter::CandidateMoveToPageIndex(const size_t index) {
   DCHECK(CheckState(PREDICTION | CONVERSION));
   ResetResult();
 
-  candidate_list_->MoveToPageIndex(index);
+  candidate_list_.mutable_get()->MoveToPageIndex(index);
   candidate_list_visible_ = false;
   UpdateSelectedCandidateIndex();
   SegmentFocus();
@@ -1058,7 +1105,7 @@ bool SessionConverter::CandidateMoveToShortcut(const char shortcut) {
     return false;
   }
 
-  if (!candidate_list_->MoveToPageIndex(index)) {
+  if (!candidate_list_.mutable_get()->MoveToPageIndex(index)) {
     VLOG(1) << "shortcut is out of the range.";
     return false;
   }
@@ -1080,6 +1127,7 @@ void SessionConverter::PopOutput(
 
 void SessionConverter::FillOutput(
     const composer::Composer &composer, commands::Output *output) const {
+  MOZC_TRACE_SCOPE(Trace::SESSION_OUTPUT);
   if (output == NULL) {
     LOG(ERROR) << "output is NULL.";
     return;
@@ -1143,20 +1191,17 @@ SessionConverter* SessionConverter::Clone() const {
   // moment it's ok because the current design guarantees that the converter is
   // singleton. However, we should refactor such bad design; see also the
   // comment right above.
-  session_converter->segments_->CopyFrom(*segments_);
+  session_converter->segments_.ShareFrom(segments_);
   session_converter->segment_index_ = segment_index_;
-  session_converter->previous_suggestions_.CopyFrom(previous_suggestions_);
+  session_converter->previous_suggestions_.ShareFrom(previous_suggestions_);
   session_converter->conversion_preferences_ = conversion_preferences();
   session_converter->operation_preferences_ = operation_preferences_;
   session_converter->result_->CopyFrom(*result_);
-
-  if (session_converter->CheckState(SUGGESTION | PREDICTION | CONVERSION)) {
-    session_converter->UpdateCandidateList();
-    session_converter->candidate_list_->MoveToId(candidate_list_->focused_id());
-    session_converter->SetCandidateListVisible(candidate_list_visible_);
-  }
+  session_converter->candidate_list_.ShareFrom(candidate_list_);
+  session_converter->candidate_list_visible_ = candidate_list_visible_;
 
   session_converter->request_ = request_;
+  session_converter->config_ = config_;
   session_converter->selected_candidate_indices_ = selected_candidate_indices_;
 
   return session_converter;
@@ -1169,22 +1214,34 @@ void SessionConverter::ResetResult() {
 void SessionConverter::ResetState() {
   state_ = COMPOSITION;
   segment_index_ = 0;
-  previous_suggestions_.clear();
+  if (previous_suggestions_.shared()) {
+    previous_suggestions_.reset(new Segment);
+  } else {
+    previous_suggestions_.mutable_get()->clear();
+  }
   candidate_list_visible_ = false;
-  candidate_list_->Clear();
+  ClearCandidateList();
   selected_candidate_indices_.clear();
 }
 
+void SessionConverter::ClearCandidateList() {
+  if (candidate_list_.shared()) {
+    candidate_list_.reset(new CandidateList(true));
+    return;
+  }
+  candidate_list_.mutable_get()->Clear();
+}
+
 void SessionConverter::SegmentFocus() {
   DCHECK(CheckState(SUGGESTION | PREDICTION | CONVERSION));
-  converter_->FocusSegmentValue(segments_.get(),
+  converter_->FocusSegmentValue(segments_.mutable_get(),
                                 segment_index_,
                                 GetCandidateIndexForConverter(segment_index_));
 }
 
 void SessionConverter::SegmentFix() {
   DCHECK(CheckState(SUGGESTION | PREDICTION | CONVERSION));
-  converter_->CommitSegmentValue(segments_.get(),
+  converter_->CommitSegmentValue(segments_.mutable_get(),
                                  segment_index_,
                                  GetCandidateIndexForConverter(segment_index_));
 }
@@ -1254,7 +1311,7 @@ size_t SessionConverter::GetConsumedPreeditSize(const size_t index,
 
 bool SessionConverter::MaybePerformCommandCandidate(
     const size_t index,
-    const size_t size) const {
+    const size_t size) {
   // If a candidate has the command attribute, Cancel is performed
   // instead of Commit after executing the specified action.
   for (size_t i = index; i < size; ++i) {
@@ -1282,6 +1339,9 @@ bool SessionConverter::MaybePerformCommandCandidate(
           LOG(WARNING) << "Unknown command: " << candidate.command;
           break;
       }
+      // Uses the updated config from the next conversion. The other sessions
+      // are updated by SessionHandler.
+      config_ = ConfigHandler::GetConfigSnapshot();
       return true;
     }
   }
@@ -1327,13 +1387,14 @@ void SessionConverter::AppendCandidateList() {
   // meta candidates are not located in the same list (distributed over
   // some lists), the most appropriate location to be added new meta candidates
   // cannot be decided).
-  const bool add_meta_candidates = (candidate_list_->size() == 0);
+  CandidateList *candidate_list = candidate_list_.mutable_get();
+  const bool add_meta_candidates = (candidate_list->size() == 0);
 
   const Segment &segment = segments_->conversion_segment(segment_index_);
-  for (size_t i = candidate_list_->next_available_id();
+  for (size_t i = candidate_list->next_available_id();
        i < segment.candidates_size();
        ++i) {
-    candidate_list_->AddCandidate(i, segment.candidate(i).value);
+    candidate_list->AddCandidate(i, segment.candidate(i).value);
     // if candidate has spelling correction attribute,
     // always display the candidate to let user know the
     // miss spelled candidate.
@@ -1348,7 +1409,7 @@ void SessionConverter::AppendCandidateList() {
       segments_->request_type() != Segments::SUGGESTION &&
       segments_->request_type() != Segments::PARTIAL_SUGGESTION &&
       segments_->request_type() != Segments::PARTIAL_PREDICTION);
-  candidate_list_->set_focused(focused);
+  candidate_list->set_focused(focused);
 
   if (segment.meta_candidates_size() == 0) {
     // For suggestion mode, it is natural that T13N is not initialized.
@@ -1368,7 +1429,7 @@ void SessionConverter::AppendCandidateList() {
   CandidateList *transliterations;
   if (operation_preferences_.use_cascading_window) {
     const bool kNoRotate = false;
-    transliterations = candidate_list_->AllocateSubCandidateList(kNoRotate);
+    transliterations = candidate_list->AllocateSubCandidateList(kNoRotate);
     transliterations->set_focused(true);
 
     const char kT13nLabel[] =
@@ -1377,7 +1438,7 @@ void SessionConverter::AppendCandidateList() {
       "\xe6\x96\x87\xe5\xad\x97\xe7\xa8\xae";
     transliterations->set_name(kT13nLabel);
   } else {
-    transliterations = candidate_list_.get();
+    transliterations = candidate_list;
   }
 
   // Add transliterations.
@@ -1393,7 +1454,7 @@ void SessionConverter::AppendCandidateList() {
 
 void SessionConverter::UpdateCandidateList() {
   DCHECK(CheckState(SUGGESTION | PREDICTION | CONVERSION));
-  candidate_list_->Clear();
+  ClearCandidateList();
   AppendCandidateList();
 }
 
@@ -1554,6 +1615,10 @@ void SessionConverter::SetRequest(const commands::Request *request) {
   request_ = request;
 }
 
+void SessionConverter::SetConfig(const config::ConfigSnapshot &config) {
+  config_ = config;
+}
+
 void SessionConverter::OnStartComposition(const commands::Context &context) {
   bool revision_changed = false;
   if (context.has_revision()) {
@@ -1563,7 +1628,7 @@ void SessionConverter::OnStartComposition(const commands::Context &context) {
   if (!context.has_preceding_text()) {
     // In this case, reset history segments when the revision is mismatched.
     if (revision_changed) {
-      converter_->ResetConversion(segments_.get());
+      converter_->ResetConversion(segments_.mutable_get());
     }
     return;
   }
@@ -1572,7 +1637,7 @@ void SessionConverter::OnStartComposition(const commands::Context &context) {
   // If preceding text is empty, it is OK to reset the history segments by
   // calling ResetConversion.
   if (preceding_text.empty()) {
-    converter_->ResetConversion(segments_.get());
+    converter_->ResetConversion(segments_.mutable_get());
     return;
   }
 
@@ -1610,7 +1675,7 @@ void SessionConverter::OnStartComposition(const commands::Context &context) {
 
   // Here we reconstruct history segments from |preceding_text| regardless
   // of revision mismatch. If it fails the history segments is cleared anyway.
-  converter_->ReconstructHistory(segments_.get(), preceding_text);
+  converter_->ReconstructHistory(segments_.mutable_get(), preceding_text);
 }
 
 void SessionConverter::UpdateSelectedCandidateIndex() {
@@ -37,6 +37,8 @@
 
 #include "base/port.h"
 #include "base/scoped_ptr.h"
+#include "config/config_handler.h"
+#include "session/internal/copy_on_write_ptr.h"
 #include "session/session_converter_interface.h"
 
 namespace mozc {
@@ -50,10 +52,6 @@ class Request;
 class Result;
 }  // namespace commands
 
-namespace config {
-class Config;
-}  // namespace config
-
 namespace session {
 class CandidateList;
 
@@ -244,6 +242,9 @@ class SessionConverter : public SessionConverterInterface {
   // Sets setting by the request;
   virtual void SetRequest(const commands::Request *request);
 
+  // Sets the config passed to the converter with each conversion.
+  virtual void SetConfig(const config::ConfigSnapshot &config);
+
   // Set setting by the context.
   virtual void OnStartComposition(const commands::Context &context);
 
@@ -253,6 +254,9 @@ class SessionConverter : public SessionConverterInterface {
       Segments *segments);
 
   // Copies SessionConverter
+  // The segments, the previous suggestions and the candidate list are shared
+  // with the clone until either of the converters modifies them, so Clone()
+  // doesn't copy them.
   // TODO(hsumita): Copy all member variables.
   // Currently, converter_ is not copied.
   virtual SessionConverter *Clone() const;
@@ -273,6 +277,10 @@ class SessionConverter : public SessionConverterInterface {
   // Resets the session state variables.
   void ResetState();
 
+  // Clears the candidate list. The list shared with a clone is replaced with
+  // an empty one instead of being copied.
+  void ClearCandidateList();
+
   // Notifies the converter that the current segment is focused.
   void SegmentFocus();
 
@@ -298,7 +306,7 @@ class SessionConverter : public SessionConverterInterface {
 
   // Performs the command if the command candidate is selected.  True
   // is returned if a command is performed.
-  bool MaybePerformCommandCandidate(size_t index, size_t size) const;
+  bool MaybePerformCommandCandidate(size_t index, size_t size);
 
   // Updates internal states
   bool UpdateResult(size_t index, size_t size, size_t *consumed_key_size);
@@ -355,11 +363,11 @@ class SessionConverter : public SessionConverterInterface {
   SessionConverterInterface::State state_;
 
   const ConverterInterface *converter_;
-  scoped_ptr<Segments> segments_;
+  CopyOnWritePtr<Segments> segments_;
   size_t segment_index_;
 
   // Previous suggestions to be merged with the current predictions.
-  Segment previous_suggestions_;
+  CopyOnWritePtr<Segment> previous_suggestions_;
 
   // Default conversion preferences.
   ConversionPreferences conversion_preferences_;
@@ -369,10 +377,11 @@ class SessionConverter : public SessionConverterInterface {
 
   scoped_ptr<commands::Result> result_;
 
-  scoped_ptr<CandidateList> candidate_list_;
+  CopyOnWritePtr<CandidateList> candidate_list_;
   bool candidate_list_visible_;
 
   const commands::Request *request_;
+  config::ConfigSnapshot config_;
 
   // Selected index data of each segments for usage stats.
   vector<int> selected_candidate_indices_;
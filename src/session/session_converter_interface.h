@@ -47,6 +47,11 @@ class Output;
 class Request;
 }
 
+namespace config {
+class Config;
+class ConfigSnapshot;
+}
+
 namespace composer {
 class Composer;
 }
@@ -259,6 +264,10 @@ class SessionConverterInterface {
   // Currently this is especially for SessionConverter.
   virtual void SetRequest(const commands::Request *request) = 0;
 
+  // Set the config used by the following conversions.  By default the
+  // snapshot of the global config taken at the construction is used.
+  virtual void SetConfig(const config::ConfigSnapshot &config) = 0;
+
   // Update the internal state by the context.
   virtual void OnStartComposition(const commands::Context &context) = 0;
 
@@ -123,9 +123,15 @@ class SessionConverterTest : public ::testing::Test {
     dest->CopyFrom(*converter.segments_.get());
   }
 
+  // Returns the segments owned by |converter| to check if they are shared.
+  static const Segments *GetSegmentsPointer(
+      const SessionConverter &converter) {
+    return converter.segments_.get();
+  }
+
   static void SetSegments(const Segments &src, SessionConverter *converter) {
     CHECK(converter);
-    converter->segments_->CopyFrom(src);
+    converter->segments_.mutable_get()->CopyFrom(src);
   }
 
   static const commands::Result &GetResult(const SessionConverter &converter) {
@@ -2875,6 +2881,71 @@ TEST_F(SessionConverterTest, Clone) {
   }
 }
 
+TEST_F(SessionConverterTest, CloneSharesStateUntilModified) {
+  SessionConverter src(convertermock_.get(), &default_request_);
+  Segments segments;
+  SetKamaboko(&segments);
+  convertermock_->SetStartConversionForRequest(&segments, true);
+  EXPECT_TRUE(src.Convert(*composer_));
+
+  // Clone() copies neither the segments nor the candidate list.
+  scoped_ptr<SessionConverter> dest(src.Clone());
+  const Segments *shared_segments = GetSegmentsPointer(src);
+  const CandidateList *shared_candidate_list = &GetCandidateList(src);
+  EXPECT_EQ(shared_segments, GetSegmentsPointer(*dest));
+  EXPECT_EQ(shared_candidate_list, &GetCandidateList(*dest));
+  ExpectSameSessionConverter(src, *dest);
+
+  // Committing the clone copies the segments to be committed only, and
+  // doesn't copy the candidate list to be cleared.
+  const size_t candidates_size = GetCandidateList(src).size();
+  dest->Commit(*composer_, Context::default_instance());
+  EXPECT_FALSE(dest->IsActive());
+  EXPECT_NE(shared_segments, GetSegmentsPointer(*dest));
+  EXPECT_NE(shared_candidate_list, &GetCandidateList(*dest));
+  EXPECT_EQ(0, GetCandidateList(*dest).size());
+
+  // The source still has the state before the commit.
+  EXPECT_TRUE(src.IsActive());
+  EXPECT_EQ(shared_segments, GetSegmentsPointer(src));
+  EXPECT_EQ(shared_candidate_list, &GetCandidateList(src));
+  EXPECT_EQ(candidates_size, GetCandidateList(src).size());
+  EXPECT_EQ(segments.conversion_segments_size(),
+            GetSegmentsPointer(src)->conversion_segments_size());
+  EXPECT_FALSE(GetResult(src).has_value());
+}
+
+TEST_F(SessionConverterTest, CommitPreeditOfCloneCopiesOnlyHistory) {
+  SessionConverter src(convertermock_.get(), &default_request_);
+  Segments segments;
+  SetAiueo(&segments);
+  Segment *history = segments.push_front_segment();
+  history->set_segment_type(Segment::HISTORY);
+  history->add_candidate()->value = kChars_Mo;
+  SetSegments(segments, &src);
+
+  scoped_ptr<SessionConverter> dest(src.Clone());
+  const Segments *shared_segments = GetSegmentsPointer(src);
+  EXPECT_EQ(shared_segments, GetSegmentsPointer(*dest));
+
+  composer_->InsertCharacterPreedit(kChars_Aiueo);
+  dest->CommitPreedit(*composer_, Context::default_instance());
+  EXPECT_NE(shared_segments, GetSegmentsPointer(*dest));
+  EXPECT_EQ(1, GetSegmentsPointer(*dest)->history_segments_size());
+  EXPECT_EQ(kChars_Mo,
+            GetSegmentsPointer(*dest)->history_segment(0).candidate(0).value);
+  EXPECT_EQ(1, GetSegmentsPointer(*dest)->conversion_segments_size());
+  EXPECT_EQ(1,
+            GetSegmentsPointer(*dest)->conversion_segment(0).candidates_size());
+
+  // The source keeps its own conversion segments.
+  EXPECT_EQ(shared_segments, GetSegmentsPointer(src));
+  EXPECT_EQ(segments.conversion_segments_size(),
+            GetSegmentsPointer(src)->conversion_segments_size());
+  EXPECT_EQ(segments.conversion_segment(0).candidates_size(),
+            GetSegmentsPointer(src)->conversion_segment(0).candidates_size());
+}
+
 // Suggest() in the suggestion state was not accepted.  (http://b/1948334)
 TEST_F(SessionConverterTest, Issue1948334) {
   SessionConverter converter(convertermock_.get(), &default_request_);
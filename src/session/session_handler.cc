@@ -42,6 +42,7 @@
 #include "base/process.h"
 #include "base/singleton.h"
 #include "base/stopwatch.h"
+#include "base/trace.h"
 #include "base/util.h"
 #include "composer/table.h"
 #include "config/config.pb.h"
@@ -228,8 +229,9 @@ void SessionHandler::ReloadSession() {
 }
 
 void SessionHandler::ReloadConfig() {
+  config_ = config::ConfigHandler::GetConfigSnapshot();
   const composer::Table *table = table_manager_->GetTable(
-      *request_, config::ConfigHandler::GetConfig());
+      *request_, config_.get());
   for (SessionElement *element =
            const_cast<SessionElement *>(session_map_->Head());
        element != NULL; element = element->next) {
@@ -241,6 +243,14 @@ void SessionHandler::ReloadConfig() {
   }
 }
 
+void SessionHandler::ReloadConfigIfUpdated() {
+  // A command candidate, e.g., the one enabling incognito mode, updates the
+  // config while a session handles the command.
+  if (!config_.IsSameAs(config::ConfigHandler::GetConfigSnapshot())) {
+    ReloadConfig();
+  }
+}
+
 bool SessionHandler::SyncData(commands::Command *command) {
   VLOG(1) << "Syncing user data";
   engine_->GetUserDataManager()->Sync();
@@ -450,6 +460,7 @@ bool SessionHandler::EvalCommand(commands::Command *command) {
     return false;
   }
 
+  MOZC_TRACE_SCOPE(Trace::SESSION_HANDLER_EVAL_COMMAND);
   bool eval_succeeded = false;
   stopwatch_->Reset();
   stopwatch_->Start();
@@ -515,6 +526,9 @@ bool SessionHandler::EvalCommand(commands::Command *command) {
     case commands::Input::SEND_USER_DICTIONARY_COMMAND:
       eval_succeeded = SendUserDictionaryCommand(command);
       break;
+    case commands::Input::GET_TRACE_EVENTS:
+      eval_succeeded = GetTraceEvents(command);
+      break;
     case commands::Input::NO_OPERATION:
       eval_succeeded = NoOperation(command);
       break;
@@ -563,6 +577,7 @@ bool SessionHandler::SendKey(commands::Command *command) {
     return false;
   }
   (*session)->SendKey(command);
+  ReloadConfigIfUpdated();
   return true;
 }
 
@@ -586,6 +601,7 @@ bool SessionHandler::SendCommand(commands::Command *command) {
     return false;
   }
   (*session)->SendCommand(command);
+  ReloadConfigIfUpdated();
   return true;
 }
 
@@ -760,6 +776,13 @@ bool SessionHandler::SendUserDictionaryCommand(commands::Command *command) {
   return result;
 }
 
+bool SessionHandler::GetTraceEvents(commands::Command *command) {
+  VLOG(1) << "Exporting trace events";
+  Trace::ExportAsChromeTraceJson(
+      command->mutable_output()->mutable_trace_events());
+  return true;
+}
+
 bool SessionHandler::NoOperation(commands::Command *command) {
   return true;
 }
@@ -38,6 +38,7 @@
 #include "base/port.h"
 #include "base/scoped_ptr.h"
 #include "composer/table.h"
+#include "config/config_handler.h"
 #include "session/common.h"
 #include "session/session_handler_interface.h"
 #include "storage/lru_cache.h"
@@ -107,6 +108,8 @@ class SessionHandler : public SessionHandlerInterface {
   void ReloadSession();
   // Reload the configurations on the current sessions.
   void ReloadConfig();
+  // Reload the configurations if the config has been updated by a session.
+  void ReloadConfigIfUpdated();
 
   bool CreateSession(commands::Command *command);
   bool DeleteSession(commands::Command *command);
@@ -129,6 +132,7 @@ class SessionHandler : public SessionHandlerInterface {
   bool ClearStorage(commands::Command *command);
   bool Cleanup(commands::Command *command);
   bool SendUserDictionaryCommand(commands::Command *command);
+  bool GetTraceEvents(commands::Command *command);
   bool NoOperation(commands::Command *command);
 
   SessionID CreateNewSessionID();
@@ -155,6 +159,8 @@ class SessionHandler : public SessionHandlerInterface {
       user_dictionary_session_handler_;
   scoped_ptr<composer::TableManager> table_manager_;
   scoped_ptr<commands::Request> request_;
+  // The config handed to the sessions by the last ReloadConfig().
+  config::ConfigSnapshot config_;
 
   DISALLOW_COPY_AND_ASSIGN(SessionHandler);
 };
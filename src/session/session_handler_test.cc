@@ -33,6 +33,7 @@
 
 #include "base/clock_mock.h"
 #include "base/port.h"
+#include "base/trace.h"
 #include "base/util.h"
 #include "config/config.pb.h"
 #include "config/config_handler.h"
@@ -278,6 +279,33 @@ TEST_F(SessionHandlerTest, ElapsedTimeTest) {
   EXPECT_TIMING_STATS("ElapsedTimeUSec", 0, 1, 0, 0);
 }
 
+TEST_F(SessionHandlerTest, GetTraceEventsTest) {
+  scoped_ptr<EngineInterface> engine(MockDataEngineFactory::Create());
+  SessionHandler handler(engine.get());
+  Trace::Clear();
+  {
+    ScopedTrace trace(Trace::MERGER_REWRITER_REWRITE, 1);
+  }
+
+  {
+    commands::Command command;
+    command.mutable_input()->set_type(commands::Input::GET_TRACE_EVENTS);
+    EXPECT_TRUE(handler.EvalCommand(&command));
+    const string &json = command.output().trace_events();
+    EXPECT_TRUE(Util::StartsWith(json, "{\"traceEvents\":["));
+    EXPECT_NE(string::npos, json.find("\"MergerRewriter::Rewrite\""));
+  }
+
+  {  // The exported events are cleared.
+    commands::Command command;
+    command.mutable_input()->set_type(commands::Input::GET_TRACE_EVENTS);
+    EXPECT_TRUE(handler.EvalCommand(&command));
+    EXPECT_EQ(string::npos,
+              command.output().trace_events().find(
+                  "\"MergerRewriter::Rewrite\""));
+  }
+}
+
 TEST_F(SessionHandlerTest, ConfigTest) {
   config::Config config;
   config::ConfigHandler::GetStoredConfig(&config);
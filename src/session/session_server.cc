@@ -56,6 +56,9 @@ const int kNumConnections   = 10;
 #endif  // OS_WIN
 
 const int kTimeOut = 5000;  // 5000msec
+
+// The number of threads parsing and serializing the requests.
+const int kNumWorkers = 2;
 const char kSessionName[] = "session";
 const char kEventName[] = "session";
 
@@ -69,6 +72,8 @@ SessionServer::SessionServer()
       usage_observer_(new session::SessionUsageObserver()),
       session_handler_(new SessionHandler(engine_.get())) {
   using usage_stats::UsageStatsUploader;
+  SetNumWorkers(kNumWorkers);
+
   // start session watch dog timer
   session_handler_->StartWatchDog();
   session_handler_->AddObserver(usage_observer_.get());
@@ -116,7 +121,12 @@ bool SessionServer::Process(const char *request,
     return true;
   }
 
-  if (!session_handler_->EvalCommand(&command)) {
+  bool eval_result = false;
+  {
+    scoped_lock l(&handler_mutex_);
+    eval_result = session_handler_->EvalCommand(&command);
+  }
+  if (!eval_result) {
     LOG(WARNING) << "EvalCommand() returned false. Exiting the loop.";
     *response_size = 0;
     return false;
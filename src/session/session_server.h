@@ -32,6 +32,7 @@
 #ifndef MOZC_SESSION_SESSION_SERVER_H_
 #define MOZC_SESSION_SESSION_SERVER_H_
 
+#include "base/mutex.h"
 #include "base/port.h"
 #include "ipc/ipc.h"
 
@@ -70,6 +71,10 @@ class SessionServer: public IPCServer {
   scoped_ptr<EngineInterface> engine_;
   scoped_ptr<session::SessionUsageObserver> usage_observer_;
   scoped_ptr<SessionHandlerInterface> session_handler_;
+  // Process() may be called from multiple IPC worker threads, while
+  // SessionHandler is not thread-safe.  Only EvalCommand() is serialized;
+  // parsing and serialization of the messages run concurrently.
+  Mutex handler_mutex_;
 
   DISALLOW_COPY_AND_ASSIGN(SessionServer);
 };
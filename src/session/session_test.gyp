@@ -210,6 +210,7 @@
       'type': 'executable',
       'sources': [
         'internal/candidate_list_test.cc',
+        'internal/copy_on_write_ptr_test.cc',
         'internal/ime_context_test.cc',
         'internal/keymap_test.cc',
         'internal/keymap_factory_test.cc',
@@ -98,6 +98,7 @@ bool IsSessionIndependentCommand(commands::Input::CommandType type) {
     case commands::Input::READ_ALL_FROM_STORAGE:
     case commands::Input::RELOAD:
     case commands::Input::SEND_USER_DICTIONARY_COMMAND:
+    case commands::Input::GET_TRACE_EVENTS:
       return true;
     default:
       return false;
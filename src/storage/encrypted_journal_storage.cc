@@ -0,0 +1,336 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/encrypted_journal_storage.h"
+
+#ifdef OS_WIN
+#include <Windows.h>
+#endif
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/encryptor.h"
+#include "base/file_stream.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/mmap.h"
+#include "base/password_manager.h"
+#include "base/util.h"
+
+namespace mozc {
+namespace storage {
+
+namespace {
+// File layout:
+//   header: kMagic (8 bytes) + snapshot id (8 bytes, little endian)
+//   record: size of the following data (4 bytes, little endian)
+//           + salt (kSaltSize bytes)
+//           + encrypted (checksum (4 bytes) + payload)
+const char kMagic[] = "MOZCJRNL";
+const size_t kMagicSize = 8;
+const size_t kHeaderSize = kMagicSize + 8;
+const size_t kRecordSizeFieldSize = 4;
+const size_t kChecksumSize = 4;
+
+// Salt size for encryption
+const size_t kSaltSize = 32;
+
+// Maximum file size (64Mbyte)
+const size_t kMaxFileSize = 64 * 1024 * 1024;
+
+void AppendUint32(uint32 value, string *output) {
+  for (size_t i = 0; i < 4; ++i) {
+    output->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void AppendUint64(uint64 value, string *output) {
+  for (size_t i = 0; i < 8; ++i) {
+    output->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint32 ReadUint32(const char *data) {
+  uint32 value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value |= static_cast<uint32>(static_cast<uint8>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+uint64 ReadUint64(const char *data) {
+  uint64 value = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    value |= static_cast<uint64>(static_cast<uint8>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+string MakeHeader(uint64 snapshot_id) {
+  string header(kMagic, kMagicSize);
+  AppendUint64(snapshot_id, &header);
+  return header;
+}
+
+bool GetPassword(string *password) {
+  if (!PasswordManager::GetPassword(password)) {
+    LOG(ERROR) << "PasswordManager::GetPassword() failed";
+    return false;
+  }
+
+  if (password->empty()) {
+    LOG(ERROR) << "password is empty";
+    return false;
+  }
+
+  return true;
+}
+}  // namespace
+
+EncryptedJournalStorage::EncryptedJournalStorage(const string &filename)
+    : filename_(filename) {}
+
+EncryptedJournalStorage::~EncryptedJournalStorage() {}
+
+bool EncryptedJournalStorage::Load(uint64 snapshot_id,
+                                   vector<string> *records,
+                                   bool *is_broken) const {
+  DCHECK(records);
+  DCHECK(is_broken);
+  records->clear();
+  *is_broken = false;
+
+  if (!FileUtil::FileExists(filename_)) {
+    return false;
+  }
+
+  Mmap mmap;
+  if (!mmap.Open(filename_.c_str(), "r")) {
+    LOG(ERROR) << "cannot open journal file";
+    return false;
+  }
+
+  if (mmap.size() > kMaxFileSize) {
+    LOG(ERROR) << "file size is too big.";
+    return false;
+  }
+
+  if (mmap.size() < kHeaderSize ||
+      memcmp(mmap.begin(), kMagic, kMagicSize) != 0) {
+    LOG(ERROR) << "journal header is broken";
+    return false;
+  }
+
+  if (ReadUint64(mmap.begin() + kMagicSize) != snapshot_id) {
+    VLOG(1) << "journal is for another snapshot";
+    return false;
+  }
+
+  string password;
+  if (!GetPassword(&password)) {
+    return false;
+  }
+
+  const char *ptr = mmap.begin() + kHeaderSize;
+  const char *end = mmap.begin() + mmap.size();
+  while (ptr < end) {
+    if (static_cast<size_t>(end - ptr) < kRecordSizeFieldSize) {
+      *is_broken = true;
+      break;
+    }
+    const size_t size = ReadUint32(ptr);
+    ptr += kRecordSizeFieldSize;
+    if (size < kSaltSize || static_cast<size_t>(end - ptr) < size) {
+      *is_broken = true;
+      break;
+    }
+
+    const string salt(ptr, kSaltSize);
+    string data(ptr + kSaltSize, size - kSaltSize);
+    ptr += size;
+    if (!Decrypt(password, salt, &data) || data.size() < kChecksumSize) {
+      *is_broken = true;
+      break;
+    }
+
+    const uint32 checksum = ReadUint32(data.data());
+    if (checksum != Util::Fingerprint32(data.data() + kChecksumSize,
+                                        data.size() - kChecksumSize)) {
+      *is_broken = true;
+      break;
+    }
+    records->push_back(data.substr(kChecksumSize));
+  }
+
+  if (*is_broken) {
+    LOG(WARNING) << "journal is broken after " << records->size()
+                 << " records";
+  }
+
+  return true;
+}
+
+bool EncryptedJournalStorage::Append(uint64 snapshot_id,
+                                     const vector<string> &records) const {
+  string password;
+  if (!GetPassword(&password)) {
+    return false;
+  }
+
+  string output;
+  for (size_t i = 0; i < records.size(); ++i) {
+    string salt;
+    salt.resize(kSaltSize);
+    Util::GetRandomSequence(&salt[0], kSaltSize);
+
+    string data;
+    AppendUint32(Util::Fingerprint32(records[i]), &data);
+    data.append(records[i]);
+    if (!Encrypt(password, salt, &data)) {
+      return false;
+    }
+
+    AppendUint32(static_cast<uint32>(salt.size() + data.size()), &output);
+    output.append(salt);
+    output.append(data);
+  }
+
+  // Appends to the existing journal only when it is for the same snapshot.
+  const string header = MakeHeader(snapshot_id);
+  size_t current_size = 0;
+  {
+    InputFileStream ifs(filename_.c_str(), ios::in | ios::binary);
+    if (ifs) {
+      string current_header(kHeaderSize, '\0');
+      ifs.read(&current_header[0], kHeaderSize);
+      if (ifs && current_header == header) {
+        ifs.seekg(0, ios::end);
+        current_size = static_cast<size_t>(ifs.tellg());
+      }
+    }
+  }
+
+  if (current_size > 0) {
+    if (current_size + output.size() > kMaxFileSize) {
+      LOG(ERROR) << "journal becomes too big";
+      return false;
+    }
+    OutputFileStream ofs(filename_.c_str(),
+                         ios::out | ios::app | ios::binary);
+    if (!ofs) {
+      LOG(ERROR) << "failed to write: " << filename_;
+      return false;
+    }
+    VLOG(1) << "Appending " << records.size() << " records to: "
+            << filename_;
+    ofs.write(output.data(), output.size());
+    return ofs.good();
+  }
+
+  if (header.size() + output.size() > kMaxFileSize) {
+    LOG(ERROR) << "journal becomes too big";
+    return false;
+  }
+
+  const string tmp_filename = filename_ + ".tmp";
+  {
+    OutputFileStream ofs(tmp_filename.c_str(), ios::out | ios::binary);
+    if (!ofs) {
+      LOG(ERROR) << "failed to write: " << tmp_filename;
+      return false;
+    }
+    VLOG(1) << "Starting journal: " << filename_;
+    ofs.write(header.data(), header.size());
+    ofs.write(output.data(), output.size());
+  }
+
+  if (!FileUtil::AtomicRename(tmp_filename, filename_)) {
+    LOG(ERROR) << "AtomicRename failed";
+    return false;
+  }
+
+#ifdef OS_WIN
+  if (!FileUtil::HideFile(filename_)) {
+    LOG(ERROR) << "Cannot make hidden: " << filename_
+               << " " << ::GetLastError();
+  }
+#endif
+
+  return true;
+}
+
+bool EncryptedJournalStorage::Remove() const {
+  if (!FileUtil::FileExists(filename_)) {
+    return true;
+  }
+  return FileUtil::Unlink(filename_);
+}
+
+bool EncryptedJournalStorage::Encrypt(const string &password,
+                                      const string &salt,
+                                      string *data) const {
+  DCHECK(data);
+
+  Encryptor::Key key;
+  if (!key.DeriveFromPassword(password, salt)) {
+    LOG(ERROR) << "Encryptor::Key::DeriveFromPassword() failed";
+    return false;
+  }
+
+  if (!Encryptor::EncryptString(key, data)) {
+    LOG(ERROR) << "Encryptor::EncryptString() failed";
+    return false;
+  }
+
+  return true;
+}
+
+bool EncryptedJournalStorage::Decrypt(const string &password,
+                                      const string &salt,
+                                      string *data) const {
+  DCHECK(data);
+
+  Encryptor::Key key;
+  if (!key.DeriveFromPassword(password, salt)) {
+    LOG(ERROR) << "Encryptor::Key::DeriveFromPassword failed";
+    return false;
+  }
+
+  if (!Encryptor::DecryptString(key, data)) {
+    LOG(ERROR) << "Encryptor::DecryptString() failed";
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace storage
+}  // namespace mozc
@@ -0,0 +1,86 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_STORAGE_ENCRYPTED_JOURNAL_STORAGE_H_
+#define MOZC_STORAGE_ENCRYPTED_JOURNAL_STORAGE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/port.h"
+
+namespace mozc {
+namespace storage {
+
+// Append-only journal of the changes made after a snapshot, e.g., the one
+// saved by EncryptedStringStorage, so that the changes can be saved without
+// rewriting the whole snapshot. Each record is encrypted separately with its
+// own salt, so appending costs only the size of the new records.
+//
+// The journal is bound to the snapshot by |snapshot_id|. When the snapshot
+// is rewritten with a new id, the journal for the old one is ignored by
+// Load() and started over by Append(), even if it was not removed, e.g., at
+// a crash.
+class EncryptedJournalStorage {
+ public:
+  explicit EncryptedJournalStorage(const string &filename);
+  virtual ~EncryptedJournalStorage();
+
+  // Reads the records appended for the snapshot of |snapshot_id|. Returns
+  // false if the journal doesn't exist or is for another snapshot. Stops at
+  // the first broken record, e.g., the one written partially at a crash, and
+  // sets |is_broken| to true. The records after it are not readable, so the
+  // caller should start a new snapshot.
+  bool Load(uint64 snapshot_id, vector<string> *records,
+            bool *is_broken) const;
+
+  // Appends |records| to the journal for the snapshot of |snapshot_id|.
+  // Starts a new journal if the file doesn't exist or is for another
+  // snapshot.
+  bool Append(uint64 snapshot_id, const vector<string> &records) const;
+
+  // Removes the journal file.
+  bool Remove() const;
+
+ protected:
+  virtual bool Encrypt(const string &password, const string &salt,
+                       string *data) const;
+  virtual bool Decrypt(const string &password, const string &salt,
+                       string *data) const;
+
+ private:
+  string filename_;
+
+  DISALLOW_COPY_AND_ASSIGN(EncryptedJournalStorage);
+};
+
+}  // namespace storage
+}  // namespace mozc
+
+#endif  // MOZC_STORAGE_ENCRYPTED_JOURNAL_STORAGE_H_
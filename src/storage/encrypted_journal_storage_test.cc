@@ -0,0 +1,192 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/encrypted_journal_storage.h"
+
+#include <string>
+#include <vector>
+
+#include "base/file_stream.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/scoped_ptr.h"
+#include "base/system_util.h"
+#include "testing/base/public/gunit.h"
+
+DECLARE_string(test_tmpdir);
+
+namespace mozc {
+namespace storage {
+
+namespace {
+#ifdef OS_ANDROID
+// Mock the encryption/decryption for android.
+// For android, we use Java's library for encryption. However, we cannot use
+// them, because we cannot launch JVM from native tests on Android.
+class TestEncryptedJournalStorage : public EncryptedJournalStorage {
+ public:
+  explicit TestEncryptedJournalStorage(const string &filename)
+      : EncryptedJournalStorage(filename) {
+  }
+ protected:
+  virtual bool Encrypt(const string &password, const string &salt,
+                       string *data) const {
+    data->append(salt);
+    return true;
+  }
+
+  virtual bool Decrypt(const string &password, const string &salt,
+                       string *data) const {
+    if (data->size() < salt.size() ||
+        data->compare(data->size() - salt.size(), salt.size(), salt) != 0) {
+      return false;
+    }
+    data->resize(data->size() - salt.size());
+    return true;
+  }
+};
+#else
+typedef EncryptedJournalStorage TestEncryptedJournalStorage;
+#endif  // OS_ANDROID
+
+const uint64 kSnapshotId = GG_ULONGLONG(0x123456789abcdef);
+}  // namespace
+
+class EncryptedJournalStorageTest : public testing::Test {
+ protected:
+  void SetUp() {
+    SystemUtil::SetUserProfileDirectory(FLAGS_test_tmpdir);
+    filename_ = FileUtil::JoinPath(SystemUtil::GetUserProfileDirectory(),
+                                   "encrypted_journal_storage_for_test.db");
+    FileUtil::Unlink(filename_);
+
+    storage_.reset(new TestEncryptedJournalStorage(filename_));
+  }
+
+  void TearDown() {
+    FileUtil::Unlink(filename_);
+  }
+
+  string filename_;
+  scoped_ptr<EncryptedJournalStorage> storage_;
+};
+
+TEST_F(EncryptedJournalStorageTest, AppendAndLoad) {
+  vector<string> records;
+  bool is_broken = false;
+  EXPECT_FALSE(storage_->Load(kSnapshotId, &records, &is_broken));
+
+  vector<string> input;
+  input.push_back("abcdefghijklmnopqrstuvwxyz");
+  input.push_back("");
+  ASSERT_TRUE(storage_->Append(kSnapshotId, input));
+
+  vector<string> input2;
+  input2.push_back(string("\x00\x01\x02", 3));
+  ASSERT_TRUE(storage_->Append(kSnapshotId, input2));
+
+  ASSERT_TRUE(storage_->Load(kSnapshotId, &records, &is_broken));
+  EXPECT_FALSE(is_broken);
+  ASSERT_EQ(3, records.size());
+  EXPECT_EQ(input[0], records[0]);
+  EXPECT_EQ(input[1], records[1]);
+  EXPECT_EQ(input2[0], records[2]);
+
+  EXPECT_TRUE(storage_->Remove());
+  EXPECT_FALSE(storage_->Load(kSnapshotId, &records, &is_broken));
+  EXPECT_TRUE(records.empty());
+}
+
+TEST_F(EncryptedJournalStorageTest, AnotherSnapshot) {
+  vector<string> input;
+  input.push_back("old");
+  ASSERT_TRUE(storage_->Append(kSnapshotId, input));
+
+  // The journal for another snapshot is not loaded.
+  vector<string> records;
+  bool is_broken = false;
+  EXPECT_FALSE(storage_->Load(kSnapshotId + 1, &records, &is_broken));
+  EXPECT_TRUE(records.empty());
+
+  // Appending for another snapshot starts a new journal.
+  input[0] = "new";
+  ASSERT_TRUE(storage_->Append(kSnapshotId + 1, input));
+  EXPECT_FALSE(storage_->Load(kSnapshotId, &records, &is_broken));
+  ASSERT_TRUE(storage_->Load(kSnapshotId + 1, &records, &is_broken));
+  EXPECT_FALSE(is_broken);
+  ASSERT_EQ(1, records.size());
+  EXPECT_EQ("new", records[0]);
+}
+
+TEST_F(EncryptedJournalStorageTest, BrokenTail) {
+  vector<string> input;
+  input.push_back("first");
+  input.push_back("second");
+  ASSERT_TRUE(storage_->Append(kSnapshotId, input));
+
+  // Emulates a record written partially.
+  {
+    OutputFileStream ofs(filename_.c_str(),
+                         ios::out | ios::app | ios::binary);
+    ofs.write("\xff\x00\x00\x00garbage", 11);
+  }
+
+  vector<string> records;
+  bool is_broken = false;
+  ASSERT_TRUE(storage_->Load(kSnapshotId, &records, &is_broken));
+  EXPECT_TRUE(is_broken);
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ("first", records[0]);
+  EXPECT_EQ("second", records[1]);
+}
+
+#ifndef OS_ANDROID
+// Note: On Android, we cannot check the behavior of Encryption because
+// it depends on the JVM's behavior, which cannot be launched from native test.
+TEST_F(EncryptedJournalStorageTest, Encrypt) {
+  const string original_data = "abcdefghijklmnopqrstuvwxyz";
+  vector<string> input(1, original_data);
+  ASSERT_TRUE(storage_->Append(kSnapshotId, input));
+
+  string result;
+  {
+    InputFileStream ifs(filename_.c_str(), ios::in | ios::binary);
+    const size_t kBufSize = 256;
+    char buf[kBufSize];
+    ifs.read(buf, kBufSize);
+    result.assign(buf, ifs.gcount());
+  }
+
+  EXPECT_LT(original_data.size(), result.size());
+  EXPECT_TRUE(result.find(original_data) == string::npos);
+}
+#endif  // OS_ANDROID
+
+}  // namespace storage
+}  // namespace mozc
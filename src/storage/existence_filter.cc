@@ -29,6 +29,7 @@
 
 #include "storage/existence_filter.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 
@@ -54,6 +55,20 @@ inline uint32 BitsToWords(uint32 bits) {
   return words;
 }
 
+// Each block of a BLOCKED filter is one 64-byte cache line. As the size of
+// BlockBitmap's blocks is a multiple of it, a filter block never straddles
+// two bitmap blocks.
+const uint32 kBitsPerFilterBlock = 512;
+const int kBitsPerFilterBlockShift = 9;
+
+// Marker stored in place of 'm' to indicate a versioned header.
+const uint32 kVersionedHeaderMarker = 0;
+
+// Multiplier used to derive the in-block bit positions from the hash.
+// The block itself is selected by the upper 32 bits of the raw hash, so the
+// bit positions have to come from a remixed value.
+const uint64 kBlockHashMultiplier = 0x9E3779B97F4A7C15ULL;
+
 }  // namespace
 
 class ExistenceFilter::BlockBitmap {
@@ -80,6 +95,9 @@ class ExistenceFilter::BlockBitmap {
   //    }
   bool GetMutableFragment(uint32* itr, char*** ptr, size_t* size);
 
+  // Hints the CPU to load the word containing the bit at |index|.
+  void Prefetch(uint32 index) const;
+
  private:
   static const int kBlockShift = 21;  // 2^21 bits == 256KB block
   static const int kBlockBits = 1 << kBlockShift;
@@ -149,7 +167,8 @@ void ExistenceFilter::BlockBitmap::Clear() {
 }
 
 ExistenceFilter::ExistenceFilter(uint32 m, uint32 n, int k)
-    : vec_size_(m ? m : 1),
+    : format_(STANDARD),
+      vec_size_(m ? m : 1),
       expected_nelts_(n),
       num_hashes_(k) {
   CHECK_LT(num_hashes_, 8);
@@ -159,11 +178,19 @@ ExistenceFilter::ExistenceFilter(uint32 m, uint32 n, int k)
 
 // this is private constructor
 ExistenceFilter::ExistenceFilter(uint32 m, uint32 n, int k,
-                                 bool is_mutable)
-    : vec_size_(m ? m : 1),
+                                 Format format, bool is_mutable)
+    : format_(format),
+      vec_size_(m ? m : 1),
       expected_nelts_(n),
       num_hashes_(k) {
   CHECK_LT(num_hashes_, 8);
+  if (format_ == BLOCKED) {
+    // The number of blocks must be a power of two.
+    const uint32 num_blocks = vec_size_ >> kBitsPerFilterBlockShift;
+    CHECK_EQ(vec_size_ % kBitsPerFilterBlock, 0);
+    CHECK_GT(num_blocks, 0);
+    CHECK_EQ(num_blocks & (num_blocks - 1), 0);
+  }
   rep_.reset(new BlockBitmap(m ? m : 1, is_mutable));
   rep_->Clear();
 }
@@ -172,18 +199,13 @@ ExistenceFilter::ExistenceFilter(uint32 m, uint32 n, int k,
 ExistenceFilter *
 ExistenceFilter::CreateImmutableExietenceFilter(uint32 m,
                                                 uint32 n,
-                                                int k) {
-  return new ExistenceFilter(m, n, k, false);
+                                                int k,
+                                                Format format) {
+  return new ExistenceFilter(m, n, k, format, false);
 }
 
-ExistenceFilter* ExistenceFilter::CreateOptimal(size_t size_in_bytes,
-                                                uint32 estimated_insertions) {
-  CHECK_LT(size_in_bytes, (1 << 29))
-                             << "Requested size is too big";
-  CHECK_GT(estimated_insertions, 0);
-  const uint32 m = size_in_bytes * 8;
-  const uint32 n = estimated_insertions;
-
+namespace {
+int GetOptimalNumHashes(uint32 m, uint32 n) {
   int optimal_k = static_cast<int>((static_cast<float>(m) / n * log(2.0))
                                    + 0.5);
   if (optimal_k < 1) {
@@ -194,8 +216,40 @@ ExistenceFilter* ExistenceFilter::CreateOptimal(size_t size_in_bytes,
   }
 
   VLOG(1) << "optimal_k: " << optimal_k;
+  return optimal_k;
+}
+}  // namespace
+
+ExistenceFilter* ExistenceFilter::CreateOptimal(size_t size_in_bytes,
+                                                uint32 estimated_insertions) {
+  CHECK_LT(size_in_bytes, (1 << 29))
+                             << "Requested size is too big";
+  CHECK_GT(estimated_insertions, 0);
+  const uint32 m = size_in_bytes * 8;
+  const uint32 n = estimated_insertions;
+
+  ExistenceFilter *filter =
+      new ExistenceFilter(m, n, GetOptimalNumHashes(m, n));
+  CHECK(filter);
+  return filter;
+}
+
+ExistenceFilter* ExistenceFilter::CreateOptimalBlocked(
+    size_t size_in_bytes, uint32 estimated_insertions) {
+  CHECK_LT(size_in_bytes, (1 << 28))
+                             << "Requested size is too big";
+  CHECK_GT(estimated_insertions, 0);
+  const size_t min_blocks =
+      (size_in_bytes * 8 + kBitsPerFilterBlock - 1) / kBitsPerFilterBlock;
+  uint32 num_blocks = 1;
+  while (num_blocks < min_blocks) {
+    num_blocks <<= 1;
+  }
+  const uint32 m = num_blocks * kBitsPerFilterBlock;
+  const uint32 n = estimated_insertions;
 
-  ExistenceFilter *filter = new ExistenceFilter(m, n, optimal_k);
+  ExistenceFilter *filter = new ExistenceFilter(
+      m, n, GetOptimalNumHashes(m, n), BLOCKED, true);
   CHECK(filter);
   return filter;
 }
@@ -221,6 +275,14 @@ inline void ExistenceFilter::BlockBitmap::Set(uint32 index) {
   block_[bindex][windex] |= (static_cast<uint32>(1) << bitpos);
 }
 
+inline void ExistenceFilter::BlockBitmap::Prefetch(uint32 index) const {
+#ifdef __GNUC__
+  const uint32 bindex = index >> kBlockShift;
+  const uint32 windex = (index & kBlockMask) >> 5;
+  __builtin_prefetch(&block_[bindex][windex]);
+#endif  // __GNUC__
+}
+
 bool ExistenceFilter::BlockBitmap::GetMutableFragment(uint32 *iter,
                                                       char ***ptr,
                                                       size_t *size) {
@@ -236,7 +298,31 @@ bool ExistenceFilter::BlockBitmap::GetMutableFragment(uint32 *iter,
   return true;
 }
 
+inline uint32 ExistenceFilter::GetBlockOffset(uint64 hash) const {
+  const uint32 block_mask = (vec_size_ >> kBitsPerFilterBlockShift) - 1;
+  return (static_cast<uint32>(hash >> 32) & block_mask) <<
+      kBitsPerFilterBlockShift;
+}
+
+// Each of the k bit positions takes 9 bits of the remixed hash. As k < 8,
+// 63 bits are enough.
+inline bool ExistenceFilter::ExistsInBlock(uint32 block_offset,
+                                           uint64 hash) const {
+  hash *= kBlockHashMultiplier;
+  for (size_t i = 0; i < num_hashes_; ++i) {
+    const uint32 index = block_offset + (hash & (kBitsPerFilterBlock - 1));
+    if (!rep_->Get(index)) {
+      return false;
+    }
+    hash >>= kBitsPerFilterBlockShift;
+  }
+  return true;
+}
+
 bool ExistenceFilter::Exists(uint64 hash) const {
+  if (format_ == BLOCKED) {
+    return ExistsInBlock(GetBlockOffset(hash), hash);
+  }
   for (size_t i = 0; i < num_hashes_; ++i) {
     hash = RotateLeft64(hash, 8);
     uint32 index = hash % vec_size_;
@@ -247,7 +333,44 @@ bool ExistenceFilter::Exists(uint64 hash) const {
   return true;
 }
 
+void ExistenceFilter::ExistsMany(const vector<uint64> &hashes,
+                                 vector<bool> *results) const {
+  DCHECK(results);
+  results->resize(hashes.size());
+  if (format_ != BLOCKED) {
+    for (size_t i = 0; i < hashes.size(); ++i) {
+      (*results)[i] = Exists(hashes[i]);
+    }
+    return;
+  }
+
+  // Lookups are processed in small batches: first the cache lines of the
+  // whole batch are requested, then the bits are tested. This lets the
+  // memory loads of independent lookups overlap.
+  const size_t kBatchSize = 16;
+  uint32 offsets[kBatchSize];
+  for (size_t begin = 0; begin < hashes.size(); begin += kBatchSize) {
+    const size_t end = min(begin + kBatchSize, hashes.size());
+    for (size_t i = begin; i < end; ++i) {
+      offsets[i - begin] = GetBlockOffset(hashes[i]);
+      rep_->Prefetch(offsets[i - begin]);
+    }
+    for (size_t i = begin; i < end; ++i) {
+      (*results)[i] = ExistsInBlock(offsets[i - begin], hashes[i]);
+    }
+  }
+}
+
 void ExistenceFilter::Insert(uint64 hash) {
+  if (format_ == BLOCKED) {
+    const uint32 block_offset = GetBlockOffset(hash);
+    hash *= kBlockHashMultiplier;
+    for (size_t i = 0; i < num_hashes_; ++i) {
+      rep_->Set(block_offset + (hash & (kBitsPerFilterBlock - 1)));
+      hash >>= kBitsPerFilterBlockShift;
+    }
+    return;
+  }
   for (size_t i = 0; i < num_hashes_; ++i) {
     hash = RotateLeft64(hash, 8);
     uint32 index = hash % vec_size_;
@@ -276,7 +399,7 @@ size_t ExistenceFilter::MinFilterSizeInBytesForErrorRate(float error_rate,
 // allocate 'buf' and write filter to the buf.
 // 'size' will hold the size of buf
 void ExistenceFilter::Write(char **buf, size_t *size) {
-  const int require_bytes = sizeof(Header) + Size();
+  const int require_bytes = HeaderBytes(format_) + Size();
 
   *buf = new char[require_bytes];
   CHECK(*buf);
@@ -285,6 +408,14 @@ void ExistenceFilter::Write(char **buf, size_t *size) {
   char *buf_ptr = *buf;
 
   // write header
+  if (format_ != STANDARD) {
+    const uint32 marker = kVersionedHeaderMarker;
+    const uint32 version = static_cast<uint32>(format_);
+    memcpy(buf_ptr, &marker, sizeof(marker));
+    buf_ptr += sizeof(marker);
+    memcpy(buf_ptr, &version, sizeof(version));
+    buf_ptr += sizeof(version);
+  }
   memcpy(buf_ptr, &vec_size_, sizeof(vec_size_));
   buf_ptr += sizeof(vec_size_);
   memcpy(buf_ptr, &expected_nelts_, sizeof(expected_nelts_));
@@ -292,7 +423,8 @@ void ExistenceFilter::Write(char **buf, size_t *size) {
   memcpy(buf_ptr, &num_hashes_, sizeof(num_hashes_));
   buf_ptr += sizeof(num_hashes_);
   LOG(INFO) << "Write header : vec_size" << vec_size_ << " expected_nelts "
-            << expected_nelts_ << " num_hashes " << num_hashes_;
+            << expected_nelts_ << " num_hashes " << num_hashes_
+            << " format " << format_;
 
   // write bitmap
   char **fragment_ptr = NULL;
@@ -309,7 +441,40 @@ void ExistenceFilter::Write(char **buf, size_t *size) {
   }
 }
 
-bool ExistenceFilter::ReadHeader(const char *buf, Header* header) {
+// static
+size_t ExistenceFilter::HeaderBytes(Format format) {
+  const size_t legacy_bytes = sizeof(uint32) * 2 + sizeof(int);
+  if (format == STANDARD) {
+    return legacy_bytes;
+  }
+  // Marker and version.
+  return sizeof(uint32) * 2 + legacy_bytes;
+}
+
+bool ExistenceFilter::ReadHeader(const char *buf, size_t size,
+                                 Header* header) {
+  if (size < HeaderBytes(STANDARD)) {
+    LOG(ERROR) << "Not enough bufsize: could not read header";
+    return false;
+  }
+  uint32 marker = 0;
+  memcpy(&marker, buf, sizeof(marker));
+  header->format = STANDARD;
+  if (marker == kVersionedHeaderMarker) {
+    buf += sizeof(marker);
+    uint32 version = 0;
+    memcpy(&version, buf, sizeof(version));
+    buf += sizeof(version);
+    if (version != static_cast<uint32>(BLOCKED)) {
+      LOG(ERROR) << "Unknown filter format: " << version;
+      return false;
+    }
+    header->format = BLOCKED;
+    if (size < HeaderBytes(header->format)) {
+      LOG(ERROR) << "Not enough bufsize: could not read header";
+      return false;
+    }
+  }
   memcpy(&(header->m), buf, sizeof(header->m));
   buf += sizeof(header->m);
   memcpy(&(header->n), buf, sizeof(header->n));
@@ -320,22 +485,24 @@ bool ExistenceFilter::ReadHeader(const char *buf, Header* header) {
     LOG(ERROR) << "Bad number of hashes (header->k)";
     return false;
   }
+  if (header->format == BLOCKED) {
+    const uint32 num_blocks = header->m >> kBitsPerFilterBlockShift;
+    if (header->m % kBitsPerFilterBlock != 0 || num_blocks == 0 ||
+        (num_blocks & (num_blocks - 1)) != 0) {
+      LOG(ERROR) << "Bad size of blocked filter (header->m)";
+      return false;
+    }
+  }
   return true;
 }
 
 ExistenceFilter* ExistenceFilter::Read(const char *buf, size_t size) {
   Header header;
-  const uint32 header_bytes =
-      sizeof(header.m) + sizeof(header.n) + sizeof(header.k);
-  if (size < header_bytes) {
-    LOG(ERROR) << "Not enough bufsize: could not read header";
-    return NULL;
-  }
-
-  if (!ReadHeader(buf, &header)) {
+  if (!ReadHeader(buf, size, &header)) {
     LOG(ERROR) << "Invalid format: could not read header";
     return NULL;
   }
+  const uint32 header_bytes = HeaderBytes(header.format);
   buf += header_bytes;
 
   const uint32 filter_size = BitsToWords(header.m);
@@ -353,7 +520,8 @@ ExistenceFilter* ExistenceFilter::Read(const char *buf, size_t size) {
   ExistenceFilter* filter =
       ExistenceFilter::CreateImmutableExietenceFilter(header.m,
                                                       header.n,
-                                                      header.k);
+                                                      header.k,
+                                                      header.format);
   char **ptr = NULL;
   size_t n = 0;
   size_t read = 0;
@@ -30,6 +30,8 @@
 #ifndef MOZC_STORAGE_EXISTENCE_FILTER_H_
 #define MOZC_STORAGE_EXISTENCE_FILTER_H_
 
+#include <vector>
+
 #include "base/port.h"
 #include "base/scoped_ptr.h"
 
@@ -39,10 +41,25 @@ namespace storage {
 // Bloom filter
 class ExistenceFilter {
  public:
+  // Layout of the bit vector.
+  enum Format {
+    // Classic bloom filter. The k bits of a value are spread over the
+    // whole bit vector.
+    STANDARD = 0,
+    // Blocked bloom filter. The k bits of a value all fall into one
+    // 512-bit (64-byte) block, so a lookup touches a single cache line.
+    // The number of blocks is a power of two, so no modulo is needed.
+    BLOCKED = 1,
+  };
+
+  // Serialized header. STANDARD filters are written as "m n k" for
+  // compatibility with existing data. Other formats are prefixed with a
+  // zero word (m is never zero) and the format version: "0 format m n k".
   struct Header {
     uint32 m;
     uint32 n;
     int k;
+    Format format;
   };
 
   // 'm' is the number of bits in the bit vector
@@ -55,6 +72,11 @@ class ExistenceFilter {
   static ExistenceFilter* CreateOptimal(size_t size_in_bytes,
                                         uint32 estimated_insertions);
 
+  // Creates a BLOCKED filter. The size is rounded up to a power-of-two
+  // number of 64-byte blocks.
+  static ExistenceFilter* CreateOptimalBlocked(size_t size_in_bytes,
+                                               uint32 estimated_insertions);
+
   void Clear();
 
   // Inserts a hash value into the filter
@@ -65,6 +87,15 @@ class ExistenceFilter {
   // It may return some false positives
   bool Exists(uint64 hash) const;
 
+  // Batch version of Exists(). (*results)[i] is set to Exists(hashes[i]).
+  // For BLOCKED filters the cache lines are prefetched ahead of the
+  // lookups, so this is faster than calling Exists() in a loop.
+  void ExistsMany(const vector<uint64> &hashes, vector<bool> *results) const;
+
+  Format format() const {
+    return format_;
+  }
+
   // Returns the size (in bytes) of the bloom filter
   size_t Size() const;
 
@@ -75,7 +106,12 @@ class ExistenceFilter {
 
   void Write(char **buf, size_t *size);
 
-  static bool ReadHeader(const char *buf, Header* header);
+  // Reads the header from buf[]. Both the legacy and the versioned headers
+  // are accepted. |size| is the number of available bytes in buf[].
+  static bool ReadHeader(const char *buf, size_t size, Header* header);
+
+  // Returns the number of bytes used by the header of the given format.
+  static size_t HeaderBytes(Format format);
 
   // Read Existence filter from buf[]
   // Note that the returned ExsitenceFilter is immutable filter.
@@ -86,13 +122,21 @@ class ExistenceFilter {
   class BlockBitmap;
 
   // private constructor for ExistenceFilter::Read();
-  ExistenceFilter(uint32 m, uint32 n, int k, bool is_mutable);
+  ExistenceFilter(uint32 m, uint32 n, int k, Format format, bool is_mutable);
 
   static ExistenceFilter *CreateImmutableExietenceFilter(uint32 m,
                                                          uint32 n,
-                                                         int k);
+                                                         int k,
+                                                         Format format);
+
+  // Returns the index of the first bit of the block for |hash|.
+  // Only for BLOCKED filters.
+  uint32 GetBlockOffset(uint64 hash) const;
+
+  bool ExistsInBlock(uint32 block_offset, uint64 hash) const;
 
   scoped_ptr<BlockBitmap> rep_;  // points to bitmap
+  const Format format_;
   const uint32 vec_size_;  // size of bitmap (in bits)
   const uint32 expected_nelts_;  // expected number of inserts
   const int32 num_hashes_;  // number of hashes per lookup
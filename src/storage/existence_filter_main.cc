@@ -30,12 +30,16 @@
 #include "storage/existence_filter.h"
 
 #include <string>
+#include <vector>
 
 #include "base/flags.h"
 #include "base/logging.h"
 #include "base/port.h"
+#include "base/scoped_ptr.h"
 #include "base/util.h"
 
+DEFINE_bool(blocked, false, "use the cache-line blocked format");
+
 using mozc::storage::ExistenceFilter;
 
 int main(int argc, char **argv) {
@@ -43,7 +47,9 @@ int main(int argc, char **argv) {
 
   int n = 500;
   int m = ExistenceFilter::MinFilterSizeInBytesForErrorRate(0.01, n);
-  ExistenceFilter *filter = ExistenceFilter::CreateOptimal(m, n);
+  ExistenceFilter *filter = FLAGS_blocked ?
+      ExistenceFilter::CreateOptimalBlocked(m, n) :
+      ExistenceFilter::CreateOptimal(m, n);
   for (int i = 0; i < n; ++i) {
     uint64 val = i * 2;
     filter->Insert(val);
@@ -56,5 +62,23 @@ int main(int argc, char **argv) {
     }
   }
 
+  char *buf = NULL;
+  size_t size = 0;
+  filter->Write(&buf, &size);
+  scoped_ptr<ExistenceFilter> filter_read(ExistenceFilter::Read(buf, size));
+  CHECK(filter_read.get());
+
+  vector<uint64> values;
+  for (int i = 0; i < 2 * n; ++i) {
+    values.push_back(i);
+  }
+  vector<bool> results;
+  filter_read->ExistsMany(values, &results);
+  for (int i = 0; i < 2 * n; i += 2) {
+    CHECK(results[i]);
+  }
+
+  delete [] buf;
+  delete filter;
   return 0;
 }
@@ -62,9 +62,11 @@ void CheckValues(ExistenceFilter* filter, int m, int n) {
   LOG(INFO) << "false_positives: " << false_positives;
 }
 
-void RunTest(int m, int n) {
-  LOG(INFO) << "Test " << m << " " << n;
-  ExistenceFilter *filter = ExistenceFilter::CreateOptimal(m, n);
+void RunTest(int m, int n, ExistenceFilter::Format format) {
+  LOG(INFO) << "Test " << m << " " << n << " " << format;
+  ExistenceFilter *filter = (format == ExistenceFilter::BLOCKED) ?
+      ExistenceFilter::CreateOptimalBlocked(m, n) :
+      ExistenceFilter::CreateOptimal(m, n);
 
   for (int i = 0; i < n; ++i) {
     int val = i * 2;
@@ -80,6 +82,8 @@ void RunTest(int m, int n) {
   filter->Write(&buf, &size);
   LOG(INFO) << "write size: " << size;
   ExistenceFilter *filter2 = ExistenceFilter::Read(buf, size);
+  CHECK(filter2);
+  CHECK_EQ(format, filter2->format());
   CheckValues(filter2, m, n);
   delete filter2;
   delete[] buf;
@@ -92,7 +96,99 @@ void RunTest(int m, int n) {
 TEST(ExistenceFilterTest, RunTest) {
   int n = 50000;
   int m = ExistenceFilter::MinFilterSizeInBytesForErrorRate(0.01, 50000);
-  RunTest(m, n);
+  RunTest(m, n, ExistenceFilter::STANDARD);
+}
+
+TEST(ExistenceFilterTest, RunBlockedTest) {
+  int n = 50000;
+  int m = ExistenceFilter::MinFilterSizeInBytesForErrorRate(0.01, 50000);
+  RunTest(m, n, ExistenceFilter::BLOCKED);
+}
+
+TEST(ExistenceFilterTest, BlockedSizeTest) {
+  scoped_ptr<ExistenceFilter> filter(
+      ExistenceFilter::CreateOptimalBlocked(1, 1));
+  EXPECT_EQ(64, filter->Size());
+  filter.reset(ExistenceFilter::CreateOptimalBlocked(65, 10));
+  EXPECT_EQ(128, filter->Size());
+  filter.reset(ExistenceFilter::CreateOptimalBlocked(1000, 100));
+  EXPECT_EQ(1024, filter->Size());
+}
+
+TEST(ExistenceFilterTest, ReadLegacyHeaderTest) {
+  // Data written before the versioned header was introduced:
+  // m = 64, n = 1, k = 1 followed by 8 bytes of bitmap.
+  const uint32 kData[] = { 64, 1, 1, 0x1, 0x0 };
+  const char *buf = reinterpret_cast<const char *>(kData);
+
+  ExistenceFilter::Header header;
+  ASSERT_TRUE(ExistenceFilter::ReadHeader(buf, sizeof(kData), &header));
+  EXPECT_EQ(64, header.m);
+  EXPECT_EQ(1, header.n);
+  EXPECT_EQ(1, header.k);
+  EXPECT_EQ(ExistenceFilter::STANDARD, header.format);
+
+  scoped_ptr<ExistenceFilter> filter(
+      ExistenceFilter::Read(buf, sizeof(kData)));
+  ASSERT_TRUE(filter.get() != NULL);
+  EXPECT_EQ(ExistenceFilter::STANDARD, filter->format());
+  EXPECT_EQ(8, filter->Size());
+}
+
+TEST(ExistenceFilterTest, ReadBrokenHeaderTest) {
+  ExistenceFilter::Header header;
+  {
+    // Unknown version.
+    const uint32 kData[] = { 0, 100, 512, 1, 1 };
+    EXPECT_FALSE(ExistenceFilter::ReadHeader(
+        reinterpret_cast<const char *>(kData), sizeof(kData), &header));
+  }
+  {
+    // Blocked filter whose number of blocks is not a power of two.
+    const uint32 kData[] = { 0, ExistenceFilter::BLOCKED, 512 * 3, 1, 1 };
+    EXPECT_FALSE(ExistenceFilter::ReadHeader(
+        reinterpret_cast<const char *>(kData), sizeof(kData), &header));
+  }
+  {
+    // Truncated versioned header.
+    const uint32 kData[] = { 0, ExistenceFilter::BLOCKED, 512 };
+    EXPECT_FALSE(ExistenceFilter::ReadHeader(
+        reinterpret_cast<const char *>(kData), sizeof(kData), &header));
+  }
+}
+
+TEST(ExistenceFilterTest, ExistsManyTest) {
+  const int kNum = 1000;
+  const ExistenceFilter::Format kFormats[] = {
+    ExistenceFilter::STANDARD, ExistenceFilter::BLOCKED,
+  };
+  for (size_t i = 0; i < arraysize(kFormats); ++i) {
+    const size_t num_bytes =
+        ExistenceFilter::MinFilterSizeInBytesForErrorRate(0.01, kNum);
+    scoped_ptr<ExistenceFilter> filter(
+        (kFormats[i] == ExistenceFilter::BLOCKED) ?
+        ExistenceFilter::CreateOptimalBlocked(num_bytes, kNum) :
+        ExistenceFilter::CreateOptimal(num_bytes, kNum));
+    vector<uint64> hashes;
+    for (int j = 0; j < 2 * kNum; ++j) {
+      const uint64 hash = Util::Fingerprint(
+          reinterpret_cast<const char *>(&j), sizeof(j));
+      if (j % 2 == 0) {
+        filter->Insert(hash);
+      }
+      hashes.push_back(hash);
+    }
+
+    vector<bool> results;
+    filter->ExistsMany(hashes, &results);
+    ASSERT_EQ(hashes.size(), results.size());
+    for (size_t j = 0; j < hashes.size(); ++j) {
+      EXPECT_EQ(filter->Exists(hashes[j]), results[j]);
+      if (j % 2 == 0) {
+        EXPECT_TRUE(results[j]);
+      }
+    }
+  }
 }
 
 TEST(ExistenceFilterTest, MinFilterSizeEstimateTest) {
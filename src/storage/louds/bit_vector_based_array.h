@@ -31,7 +31,7 @@
 #define MOZC_STORAGE_LOUDS_BIT_VECTOR_BASED_ARRAY_H_
 
 #include "base/port.h"
-#include "storage/louds/simple_succinct_bit_vector_index.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 
 namespace mozc {
 namespace storage {
@@ -52,7 +52,7 @@ class BitVectorBasedArray {
   const char *Get(size_t index, size_t *length) const;
 
  private:
-  SimpleSuccinctBitVectorIndex index_;
+  RankSelectBitVectorIndex index_;
   size_t base_length_;
   size_t step_length_;
   const char *data_;
@@ -67,7 +67,7 @@
         '../../base/base.gyp:base',
         'key_expansion_table',
         'louds',
-        'simple_succinct_bit_vector_index',
+        'rank_select_bit_vector_index',
       ],
       'xcode_settings' : {
         'SDKROOT': 'iphoneos',
@@ -102,7 +102,7 @@
       ],
       'dependencies': [
         '../../base/base.gyp:base',
-        'simple_succinct_bit_vector_index',
+        'rank_select_bit_vector_index',
       ],
       'xcode_settings' : {
         'SDKROOT': 'iphoneos',
@@ -144,6 +144,22 @@
         'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
       },
     },
+    {
+      'target_name': 'rank_select_bit_vector_index',
+      'type': 'static_library',
+      'toolsets': ['target', 'host'],
+      'sources': [
+        'rank_select_bit_vector_index.cc',
+      ],
+      'dependencies': [
+        '../../base/base.gyp:base',
+      ],
+      'xcode_settings' : {
+        'SDKROOT': 'iphoneos',
+        'IPHONEOS_DEPLOYMENT_TARGET': '7.0',
+        'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
+      },
+    },
     # Bit stream implementation for builders.
     {
       'target_name': 'bit_stream',
@@ -31,6 +31,7 @@
 #define MOZC_STORAGE_LOUDS_LOUDS_H_
 
 #include "base/port.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "storage/louds/simple_succinct_bit_vector_index.h"
 
 namespace mozc {
@@ -51,9 +52,12 @@ namespace louds {
 // representation" and "node id of the tree".
 // In this representation, we can think that each '1'-bit is corresponding
 // to an edge.
-class Louds {
+// BitVectorIndex is the implementation of rank/select operations, either
+// RankSelectBitVectorIndex or SimpleSuccinctBitVectorIndex.
+template <typename BitVectorIndex>
+class BasicLouds {
  public:
-  Louds() {
+  BasicLouds() {
   }
 
   void Open(const uint8 *image, int length) {
@@ -108,11 +112,14 @@ class Louds {
   }
 
  private:
-  SimpleSuccinctBitVectorIndex index_;
+  BitVectorIndex index_;
 
-  DISALLOW_COPY_AND_ASSIGN(Louds);
+  DISALLOW_COPY_AND_ASSIGN(BasicLouds);
 };
 
+typedef BasicLouds<RankSelectBitVectorIndex> Louds;
+typedef BasicLouds<SimpleSuccinctBitVectorIndex> SimpleLouds;
+
 }  // namespace louds
 }  // namespace storage
 }  // namespace mozc
@@ -30,11 +30,16 @@
 #include "storage/louds/louds_trie.h"
 
 #include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/port.h"
 #include "storage/louds/louds.h"
-#include "storage/louds/simple_succinct_bit_vector_index.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 
 namespace mozc {
 namespace storage {
@@ -100,7 +105,7 @@ namespace {
 class ExactSearcher {
  public:
   ExactSearcher(const Louds *trie,
-                const SimpleSuccinctBitVectorIndex *terminal_bit_vector,
+                const RankSelectBitVectorIndex *terminal_bit_vector,
                 const char *edge_character)
       : trie_(trie),
         terminal_bit_vector_(terminal_bit_vector),
@@ -144,7 +149,7 @@ class ExactSearcher {
 
  private:
   const Louds *trie_;
-  const SimpleSuccinctBitVectorIndex *terminal_bit_vector_;
+  const RankSelectBitVectorIndex *terminal_bit_vector_;
   const char *edge_character_;
 
   DISALLOW_COPY_AND_ASSIGN(ExactSearcher);
@@ -163,7 +168,7 @@ namespace {
 class PrefixSearcher {
  public:
   PrefixSearcher(const Louds *trie,
-                 const SimpleSuccinctBitVectorIndex *terminal_bit_vector,
+                 const RankSelectBitVectorIndex *terminal_bit_vector,
                  const char *edge_character,
                  const KeyExpansionTable *key_expansion_table,
                  const char *key,
@@ -236,7 +241,7 @@ class PrefixSearcher {
 
  private:
   const Louds *trie_;
-  const SimpleSuccinctBitVectorIndex *terminal_bit_vector_;
+  const RankSelectBitVectorIndex *terminal_bit_vector_;
   const char *edge_character_;
   const KeyExpansionTable *key_expansion_table_;
 
@@ -263,7 +268,7 @@ namespace {
 class PredictiveSearcher {
  public:
   PredictiveSearcher(const Louds *trie,
-                     const SimpleSuccinctBitVectorIndex *terminal_bit_vector,
+                     const RankSelectBitVectorIndex *terminal_bit_vector,
                      const char *edge_character,
                      const KeyExpansionTable *key_expansion_table,
                      const char *key,
@@ -314,7 +319,7 @@ class PredictiveSearcher {
 
  private:
   const Louds *trie_;
-  const SimpleSuccinctBitVectorIndex *terminal_bit_vector_;
+  const RankSelectBitVectorIndex *terminal_bit_vector_;
   const char *edge_character_;
   const KeyExpansionTable *key_expansion_table_;
 
@@ -387,6 +392,260 @@ void LoudsTrie::PredictiveSearchWithKeyExpansion(
   searcher.Search(0, 1, 2);
 }
 
+namespace {
+class CostOrderPredictiveSearcher {
+ public:
+  CostOrderPredictiveSearcher(
+      const Louds *trie,
+      const RankSelectBitVectorIndex *terminal_bit_vector,
+      const char *edge_character,
+      const KeyExpansionTable *key_expansion_table,
+      const uint16 *node_costs,
+      LoudsTrie::CostOrderCallback *callback)
+      : trie_(trie),
+        terminal_bit_vector_(terminal_bit_vector),
+        edge_character_(edge_character),
+        key_expansion_table_(key_expansion_table),
+        node_costs_(node_costs),
+        callback_(callback) {
+  }
+
+  // Pushes the nodes matching |key| to the agenda, as the roots of the search.
+  void AddRoots(const char *key, int node_id, size_t bit_index) {
+    if (*key == '\0') {
+      Push(node_id);
+      return;
+    }
+    if (!trie_->IsEdgeBit(bit_index)) {
+      return;
+    }
+    int child_node_id = trie_->GetChildNodeId(bit_index);
+    const ExpandedKey &expanded_key = key_expansion_table_->ExpandKey(*key);
+    do {
+      if (expanded_key.IsHit(edge_character_[child_node_id - 1])) {
+        AddRoots(key + 1, child_node_id,
+                 trie_->GetFirstEdgeBitIndex(child_node_id));
+      }
+      ++bit_index;
+      ++child_node_id;
+    } while (trie_->IsEdgeBit(bit_index));
+  }
+
+  void Search() {
+    while (!agenda_.empty()) {
+      const int min_cost = agenda_.top().first;
+      const int node_id = agenda_.top().second;
+      agenda_.pop();
+
+      if (terminal_bit_vector_->Get(node_id - 1)) {
+        size_t len = 0;
+        const char *word = GetWord(node_id, &len);
+        const LoudsTrie::Callback::ResultType result = callback_->Run(
+            word, len, terminal_bit_vector_->Rank1(node_id - 1), min_cost);
+        if (result == LoudsTrie::Callback::SEARCH_DONE) {
+          return;
+        }
+        if (result == LoudsTrie::Callback::SEARCH_CULL) {
+          continue;
+        }
+      }
+
+      size_t bit_index = trie_->GetFirstEdgeBitIndex(node_id);
+      for (int child_node_id = Louds::GetChildNodeId(node_id, bit_index);
+           trie_->IsEdgeBit(bit_index); ++bit_index, ++child_node_id) {
+        Push(child_node_id);
+      }
+    }
+  }
+
+ private:
+  // Pair of the min cost and the node id. The node id breaks ties so that
+  // shorter words are found first, as the nodes are numbered in BFS order.
+  typedef pair<int, int> Entry;
+
+  void Push(int node_id) {
+    agenda_.push(Entry(node_costs_[node_id - 1], node_id));
+  }
+
+  // Same as LoudsTrie::Reverse(), but from the node id.
+  const char *GetWord(int node_id, size_t *len) {
+    char *ptr = buffer_ + LoudsTrie::kMaxDepth;
+    while (node_id > 1) {
+      --ptr;
+      *ptr = edge_character_[node_id - 1];
+      node_id = trie_->GetParentNodeId(trie_->GetParentEdgeBitIndex(node_id));
+    }
+    *len = buffer_ + LoudsTrie::kMaxDepth - ptr;
+    return ptr;
+  }
+
+  const Louds *trie_;
+  const RankSelectBitVectorIndex *terminal_bit_vector_;
+  const char *edge_character_;
+  const KeyExpansionTable *key_expansion_table_;
+  const uint16 *node_costs_;
+  LoudsTrie::CostOrderCallback *callback_;
+
+  priority_queue<Entry, vector<Entry>, greater<Entry> > agenda_;
+  char buffer_[LoudsTrie::kMaxDepth + 1];
+
+  DISALLOW_COPY_AND_ASSIGN(CostOrderPredictiveSearcher);
+};
+}  // namespace
+
+void LoudsTrie::PredictiveSearchInCostOrder(
+    const char *key, const KeyExpansionTable &key_expansion_table,
+    const uint16 *node_costs, CostOrderCallback *callback) const {
+  DCHECK(node_costs);
+  CostOrderPredictiveSearcher searcher(
+      &trie_, &terminal_bit_vector_, edge_character_, &key_expansion_table,
+      node_costs, callback);
+  searcher.AddRoots(key, 1, 2);
+  searcher.Search();
+}
+
+namespace {
+class MultiKeyPredictiveSearcher {
+ public:
+  MultiKeyPredictiveSearcher(
+      const Louds *trie,
+      const RankSelectBitVectorIndex *terminal_bit_vector,
+      const char *edge_character,
+      const KeyExpansionTable *key_expansion_table,
+      const vector<string> *keys,
+      LoudsTrie::MultiKeyCallback *callback)
+      : trie_(trie),
+        terminal_bit_vector_(terminal_bit_vector),
+        edge_character_(edge_character),
+        key_expansion_table_(key_expansion_table),
+        keys_(keys),
+        callback_(callback),
+        done_(keys->size(), false),
+        num_done_(0) {
+  }
+
+  // Starts the search for all the keys from the root node.
+  void Search() {
+    if (keys_->empty()) {
+      return;
+    }
+    vector<size_t> *root_keys = &active_keys_[0];
+    root_keys->clear();
+    for (size_t i = 0; i < keys_->size(); ++i) {
+      root_keys->push_back(i);
+    }
+    // The node id and the bit index of the root node are 1 and 2.
+    Search(0, 1, 2);
+  }
+
+ private:
+  // Searches the subtree of the node at |depth| for the keys in
+  // active_keys_[depth], i.e., the keys whose first |depth| characters (or
+  // the whole key, if it is shorter) match the path to the node.
+  // Returns true if the search for all the keys is done.
+  bool Search(size_t depth, int node_id, size_t bit_index) {
+    vector<size_t> *active_keys = &active_keys_[depth];
+    if (terminal_bit_vector_->Get(node_id - 1)) {
+      // Invoke the callback for the keys which the word begins with, and
+      // remove the keys whose search is done or culled here from the list.
+      const int key_id = terminal_bit_vector_->Rank1(node_id - 1);
+      size_t num_kept_keys = 0;
+      for (size_t i = 0; i < active_keys->size(); ++i) {
+        const size_t key_index = (*active_keys)[i];
+        if ((*keys_)[key_index].size() <= depth) {
+          const LoudsTrie::Callback::ResultType callback_result =
+              callback_->Run(key_index, buffer_, depth, key_id);
+          if (callback_result == LoudsTrie::Callback::SEARCH_DONE) {
+            done_[key_index] = true;
+            if (++num_done_ == keys_->size()) {
+              return true;
+            }
+            continue;
+          }
+          if (callback_result == LoudsTrie::Callback::SEARCH_CULL) {
+            continue;
+          }
+        }
+        (*active_keys)[num_kept_keys++] = key_index;
+      }
+      active_keys->resize(num_kept_keys);
+      if (active_keys->empty()) {
+        return false;
+      }
+    }
+
+    if (!trie_->IsEdgeBit(bit_index)) {
+      // This is leaf. Do nothing.
+      return false;
+    }
+    DCHECK_LT(depth, LoudsTrie::kMaxDepth);
+
+    // Then traverse the children, each with the keys which can still match.
+    // The search for a key may be done in the subtree of an earlier child,
+    // so such keys are filtered out here as well.
+    vector<size_t> *child_keys = &active_keys_[depth + 1];
+    int child_node_id = trie_->GetChildNodeId(bit_index);
+    do {
+      const char character = edge_character_[child_node_id - 1];
+      child_keys->clear();
+      for (size_t i = 0; i < active_keys->size(); ++i) {
+        const size_t key_index = (*active_keys)[i];
+        if (done_[key_index]) {
+          continue;
+        }
+        const string &key = (*keys_)[key_index];
+        if (key.size() <= depth ||
+            key_expansion_table_->ExpandKey(key[depth]).IsHit(character)) {
+          child_keys->push_back(key_index);
+        }
+      }
+      if (!child_keys->empty()) {
+        buffer_[depth] = character;
+        const int child_index = trie_->GetFirstEdgeBitIndex(child_node_id);
+        if (Search(depth + 1, child_node_id, child_index)) {
+          return true;
+        }
+      }
+
+      // Note: Because of the representation of LOUDS, the child node id is
+      // consecutive. So we don't need to invoke GetChildNodeId.
+      ++bit_index;
+      ++child_node_id;
+    } while (trie_->IsEdgeBit(bit_index));
+
+    return false;
+  }
+
+  const Louds *trie_;
+  const RankSelectBitVectorIndex *terminal_bit_vector_;
+  const char *edge_character_;
+  const KeyExpansionTable *key_expansion_table_;
+
+  const vector<string> *keys_;
+  LoudsTrie::MultiKeyCallback *callback_;
+
+  char buffer_[LoudsTrie::kMaxDepth + 1];
+
+  // The indices of the keys searched for in the subtree of the current node
+  // at each depth. Reused across the siblings to avoid allocations.
+  vector<size_t> active_keys_[LoudsTrie::kMaxDepth + 1];
+
+  vector<bool> done_;
+  size_t num_done_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiKeyPredictiveSearcher);
+};
+}  // namespace
+
+void LoudsTrie::PredictiveSearchForKeys(
+    const vector<string> &keys, const KeyExpansionTable &key_expansion_table,
+    MultiKeyCallback *callback) const {
+  MultiKeyPredictiveSearcher searcher(
+      &trie_, &terminal_bit_vector_, edge_character_, &key_expansion_table,
+      &keys, callback);
+  searcher.Search();
+}
+
 const char *LoudsTrie::Reverse(int key_id, char *buffer) const {
   if (key_id < 0) {
     // Just for rx compatibility.
@@ -30,11 +30,14 @@
 #ifndef MOZC_STORAGE_LOUDS_LOUDS_TRIE_H_
 #define MOZC_STORAGE_LOUDS_LOUDS_TRIE_H_
 
+#include <string>
+#include <vector>
+
 #include "base/port.h"
 #include "base/string_piece.h"
 #include "storage/louds/key_expansion_table.h"
 #include "storage/louds/louds.h"
-#include "storage/louds/simple_succinct_bit_vector_index.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 
 namespace mozc {
 namespace storage {
@@ -76,6 +79,39 @@ class LoudsTrie {
     Callback() {}
   };
 
+  // Interface which is called back by PredictiveSearchInCostOrder().
+  class CostOrderCallback {
+   public:
+    virtual ~CostOrderCallback() {
+    }
+
+    // Same as Callback::Run(), but |min_cost| is the cost annotated to the
+    // node of the word. The words are found in the ascending order of
+    // |min_cost|, so the costs of the words found later are not less than it.
+    // SEARCH_CULL skips the words which begin with the word.
+    virtual Callback::ResultType Run(const char *s, size_t len, int key_id,
+                                     int min_cost) = 0;
+
+   protected:
+    CostOrderCallback() {}
+  };
+
+  // Interface which is called back by PredictiveSearchForKeys().
+  class MultiKeyCallback {
+   public:
+    virtual ~MultiKeyCallback() {
+    }
+
+    // Same as Callback::Run(), but |key_index| is the index of the key which
+    // the word begins with. SEARCH_DONE and SEARCH_CULL only affect the search
+    // for that key; the search for the other keys continues.
+    virtual Callback::ResultType Run(size_t key_index, const char *s,
+                                     size_t len, int key_id) = 0;
+
+   protected:
+    MultiKeyCallback() {}
+  };
+
   LoudsTrie() : edge_character_(NULL) {
   }
   ~LoudsTrie() {
@@ -116,6 +152,26 @@ class LoudsTrie {
       const char *key, const KeyExpansionTable &key_expansion_table,
       Callback *callback) const;
 
+  // Same as PredictiveSearchWithKeyExpansion(), but searches best-first and
+  // finds the words in the ascending order of |node_costs|, which is indexed
+  // by (node id - 1) and must hold the minimum cost of the words in the
+  // subtree rooted at each node (see LoudsTrieBuilder::GetSubtreeMinCosts()).
+  // So the callback can stop the search once it finds enough words, without
+  // visiting the whole subtree of |key|.
+  void PredictiveSearchInCostOrder(
+      const char *key, const KeyExpansionTable &key_expansion_table,
+      const uint16 *node_costs, CostOrderCallback *callback) const;
+
+  // Same as PredictiveSearchWithKeyExpansion() for each of |keys|, but walks
+  // the trie only once for all of them. The nodes on the common prefixes of
+  // the keys (and the subtrees shared by the keys which are prefixes of other
+  // keys) are visited only once. For each key, the words are found in the
+  // same order as PredictiveSearchWithKeyExpansion(), though the words of
+  // different keys interleave.
+  void PredictiveSearchForKeys(
+      const vector<string> &keys, const KeyExpansionTable &key_expansion_table,
+      MultiKeyCallback *callback) const;
+
 
   // Traverses the trie from leaf to root and store the characters annotated to
   // the edges. The size of the buffer should be larger than kMaxDepth.  Returns
@@ -132,7 +188,7 @@ class LoudsTrie {
   // id=10 in trie_ corresponds to id=9 in terminal_bit_vector_, and so on.
   // TODO(hidehiko): Simplify the id-mapping by introducing a bit for the
   // super root in this bit vector.
-  SimpleSuccinctBitVectorIndex terminal_bit_vector_;
+  RankSelectBitVectorIndex terminal_bit_vector_;
 
   // A sequence of characters, annotated to each edge.
   // This array also doesn't have an entry for super root.
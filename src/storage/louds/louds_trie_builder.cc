@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "base/logging.h"
+#include "base/parallel_sort.h"
 #include "base/port.h"
 #include "storage/louds/bit_stream.h"
 
@@ -40,7 +41,7 @@ namespace mozc {
 namespace storage {
 namespace louds {
 
-LoudsTrieBuilder::LoudsTrieBuilder() : built_(false) {
+LoudsTrieBuilder::LoudsTrieBuilder() : built_(false), num_threads_(1) {
 }
 
 void LoudsTrieBuilder::Add(const string &word) {
@@ -52,18 +53,22 @@ void LoudsTrieBuilder::Add(const string &word) {
 namespace {
 
 // A pair of word and its original index in the (sorted) word_list_.
+// Also holds the index of the node for the prefix of the word output so far.
 class Entry {
  public:
   Entry(const string &word, size_t original_index)
-      : word_(&word), original_index_(original_index) {
+      : word_(&word), original_index_(original_index), node_index_(0) {
   }
 
   const string &word() const { return *word_; }
   size_t original_index() const { return original_index_; }
+  int node_index() const { return node_index_; }
+  void set_node_index(int node_index) { node_index_ = node_index; }
 
  private:
   const string *word_;
   size_t original_index_;
+  int node_index_;
 };
 
 class EntryLengthLessThan {
@@ -95,7 +100,13 @@ void LoudsTrieBuilder::Build() {
   CHECK(!built_);
 
   // Initialize for the build. Sort and de-dup the words.
-  sort(word_list_.begin(), word_list_.end());
+  // Equal words are indistinguishable, so the stable parallel sort gives the
+  // same order as sort().
+  if (num_threads_ > 1) {
+    ParallelStableSort(word_list_.begin(), word_list_.end(), num_threads_);
+  } else {
+    sort(word_list_.begin(), word_list_.end());
+  }
   word_list_.erase(
       unique(word_list_.begin(), word_list_.end()), word_list_.end());
   vector<Entry> entry_list;
@@ -104,6 +115,8 @@ void LoudsTrieBuilder::Build() {
     entry_list.push_back(Entry(word_list_[i], i));
   }
   id_list_.resize(word_list_.size(), - 1);
+  parent_list_.clear();
+  key_node_list_.clear();
 
   // Output the tree to streams.
   BitStream trie_stream;
@@ -115,6 +128,7 @@ void LoudsTrieBuilder::Build() {
   trie_stream.PushBit(0);
   edge_character.push_back('\0');
   terminal_stream.PushBit(0);
+  parent_list_.push_back(-1);
 
   // Then, traverse the sorted word list.
   // The basic concept to output the trie is simple:
@@ -169,6 +183,9 @@ void LoudsTrieBuilder::Build() {
         // This is the first string of this node. Output an edge.
         trie_stream.PushBit(1);
         edge_character.push_back(entry_list[i].word()[depth]);
+        const int node_index = static_cast<int>(edge_character.size()) - 1;
+        parent_list_.push_back(entry_list[i].node_index());
+        entry_list[i].set_node_index(node_index);
 
         if (entry_list[i].word().length() == depth + 1) {
           // This is a terminal node.
@@ -176,11 +193,15 @@ void LoudsTrieBuilder::Build() {
           // strings sharing the node. So the check above should work well.
           terminal_stream.PushBit(1);
           id_list_[entry_list[i].original_index()] = id;
+          key_node_list_.push_back(node_index);
           ++id;
         } else {
           // This is not a terminal node.
           terminal_stream.PushBit(0);
         }
+      } else if (word.length() > depth) {
+        // The node is shared with the previous entry.
+        entry_list[i].set_node_index(entry_list[i - 1].node_index());
       }
 
       if (i == entry_list.size() - 1 ||
@@ -220,6 +241,23 @@ const string &LoudsTrieBuilder::image() const {
   return image_;
 }
 
+void LoudsTrieBuilder::GetSubtreeMinCosts(const vector<uint16> &word_costs,
+                                          vector<uint16> *node_costs) const {
+  CHECK(built_);
+  CHECK_EQ(word_costs.size(), key_node_list_.size());
+  DCHECK(node_costs);
+  node_costs->assign(parent_list_.size(), kuint16max);
+  for (size_t i = 0; i < word_costs.size(); ++i) {
+    (*node_costs)[key_node_list_[i]] = word_costs[i];
+  }
+  // The nodes are numbered in BFS order, so every child is visited before its
+  // parent in the reverse order.
+  for (size_t i = parent_list_.size() - 1; i > 0; --i) {
+    uint16 *parent_cost = &(*node_costs)[parent_list_[i]];
+    *parent_cost = min(*parent_cost, (*node_costs)[i]);
+  }
+}
+
 int LoudsTrieBuilder::GetId(const string &word) const {
   CHECK(built_);
 
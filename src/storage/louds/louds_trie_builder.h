@@ -43,6 +43,12 @@ class LoudsTrieBuilder {
  public:
   LoudsTrieBuilder();
 
+  // Sets the number of threads used to sort the words in Build().
+  // The image doesn't depend on the number of threads. Default is 1.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+
   // Adds the word to the builder. It is necessary to call this method,
   // before Build invocation.
   void Add(const string &word);
@@ -58,13 +64,26 @@ class LoudsTrieBuilder {
   // related to the built LoudsTrie.
   int GetId(const string &word) const;
 
+  // Computes the minimum of |word_costs| of the words in the subtree rooted
+  // at each node, which is used by LoudsTrie::PredictiveSearchInCostOrder().
+  // |word_costs| is indexed by the key_id, and |node_costs| is indexed by
+  // (node id - 1), in the same way as the edge characters in the image.
+  void GetSubtreeMinCosts(const vector<uint16> &word_costs,
+                          vector<uint16> *node_costs) const;
+
  private:
   bool built_;
+  int num_threads_;
 
   vector<string> word_list_;
   vector<int> id_list_;
   string image_;
 
+  // The parent of each node and the node of each key_id, indexed in the same
+  // way as |node_costs| of GetSubtreeMinCosts(). The parent of the root is -1.
+  vector<int> parent_list_;
+  vector<int> key_node_list_;
+
   DISALLOW_COPY_AND_ASSIGN(LoudsTrieBuilder);
 };
 
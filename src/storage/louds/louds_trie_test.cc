@@ -31,6 +31,7 @@
 
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "base/port.h"
 #include "storage/louds/key_expansion_table.h"
@@ -518,6 +519,207 @@ TEST_F(LoudsTrieTest, PredictiveSearchCulling2) {
   trie.Close();
 }
 
+class CostOrderTestCallback : public LoudsTrie::CostOrderCallback {
+ public:
+  CostOrderTestCallback() : limit_(numeric_limits<size_t>::max()) {
+  }
+
+  virtual LoudsTrie::Callback::ResultType Run(
+      const char *s, size_t len, int key_id, int min_cost) {
+    words_.push_back(string(s, len));
+    costs_.push_back(min_cost);
+    if (words_.size() >= limit_) {
+      return LoudsTrie::Callback::SEARCH_DONE;
+    }
+    return LoudsTrie::Callback::SEARCH_CONTINUE;
+  }
+
+  void set_limit(size_t limit) {
+    limit_ = limit;
+  }
+
+  const vector<string> &words() const {
+    return words_;
+  }
+
+  const vector<int> &costs() const {
+    return costs_;
+  }
+
+ private:
+  size_t limit_;
+  vector<string> words_;
+  vector<int> costs_;
+};
+
+TEST_F(LoudsTrieTest, PredictiveSearchInCostOrder) {
+  LoudsTrieBuilder builder;
+  builder.Add("a");
+  builder.Add("abc");
+  builder.Add("abd");
+  builder.Add("ae");
+  builder.Add("aef");
+  builder.Add("b");
+  builder.Add("cbc");
+  builder.Build();
+
+  vector<uint16> word_costs(7);
+  word_costs[builder.GetId("a")] = 500;
+  word_costs[builder.GetId("abc")] = 300;
+  word_costs[builder.GetId("abd")] = 100;
+  word_costs[builder.GetId("ae")] = 400;
+  word_costs[builder.GetId("aef")] = 200;
+  word_costs[builder.GetId("b")] = 10;
+  word_costs[builder.GetId("cbc")] = 150;
+  vector<uint16> node_costs;
+  builder.GetSubtreeMinCosts(word_costs, &node_costs);
+
+  LoudsTrie trie;
+  trie.Open(reinterpret_cast<const uint8 *>(builder.image().data()));
+  KeyExpansionTable key_expansion_table;
+
+  {
+    CostOrderTestCallback callback;
+    trie.PredictiveSearchInCostOrder(
+        "a", key_expansion_table, &node_costs[0], &callback);
+    ASSERT_EQ(5, callback.words().size());
+    // The cost of each word is the minimum cost of its subtree, so "a" is
+    // found first with the cost of "abd".
+    EXPECT_EQ("a", callback.words()[0]);
+    EXPECT_EQ("abd", callback.words()[1]);
+    EXPECT_EQ("ae", callback.words()[2]);
+    EXPECT_EQ("aef", callback.words()[3]);
+    EXPECT_EQ("abc", callback.words()[4]);
+    EXPECT_EQ(100, callback.costs()[0]);
+    EXPECT_EQ(100, callback.costs()[1]);
+    EXPECT_EQ(200, callback.costs()[2]);
+    EXPECT_EQ(200, callback.costs()[3]);
+    EXPECT_EQ(300, callback.costs()[4]);
+  }
+
+  {
+    CostOrderTestCallback callback;
+    callback.set_limit(2);
+    trie.PredictiveSearchInCostOrder(
+        "a", key_expansion_table, &node_costs[0], &callback);
+    ASSERT_EQ(2, callback.words().size());
+    EXPECT_EQ("a", callback.words()[0]);
+    EXPECT_EQ("abd", callback.words()[1]);
+  }
+
+  {
+    key_expansion_table.Add('a', "c");
+    CostOrderTestCallback callback;
+    trie.PredictiveSearchInCostOrder(
+        "ab", key_expansion_table, &node_costs[0], &callback);
+    ASSERT_EQ(3, callback.words().size());
+    EXPECT_EQ("abd", callback.words()[0]);
+    EXPECT_EQ("cbc", callback.words()[1]);
+    EXPECT_EQ("abc", callback.words()[2]);
+  }
+
+  trie.Close();
+}
+
+// Dispatches the words found for each key to the callback of the key.
+class MultiKeyTestCallback : public LoudsTrie::MultiKeyCallback {
+ public:
+  explicit MultiKeyTestCallback(const vector<TestCallback *> &callbacks)
+      : callbacks_(callbacks) {
+  }
+
+  virtual LoudsTrie::Callback::ResultType Run(
+      size_t key_index, const char *s, size_t len, int id) {
+    EXPECT_LT(key_index, callbacks_.size());
+    return callbacks_[key_index]->Run(s, len, id);
+  }
+
+ private:
+  const vector<TestCallback *> callbacks_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiKeyTestCallback);
+};
+
+TEST_F(LoudsTrieTest, PredictiveSearchForKeys) {
+  LoudsTrieBuilder builder;
+  builder.Add("a");
+  builder.Add("ab");
+  builder.Add("abc");
+  builder.Add("abcd");
+  builder.Add("abd");
+  builder.Add("adc");
+  builder.Add("ae");
+  builder.Add("b");
+
+  builder.Build();
+  LoudsTrie trie;
+  trie.Open(reinterpret_cast<const uint8 *>(builder.image().data()));
+
+  KeyExpansionTable key_expansion_table;
+  key_expansion_table.Add('b', "d");
+
+  vector<string> keys;
+  keys.push_back("a");
+  keys.push_back("ab");
+  keys.push_back("abc");
+  keys.push_back("ax");
+  keys.push_back("b");
+
+  TestCallback a_callback;
+  a_callback.AddExpectation("a", 1, builder.GetId("a"),
+                            LoudsTrie::Callback::SEARCH_CONTINUE);
+  a_callback.AddExpectation("ab", 2, builder.GetId("ab"),
+                            LoudsTrie::Callback::SEARCH_CULL);
+  // No callback for abc, abcd and abd.
+  a_callback.AddExpectation("adc", 3, builder.GetId("adc"),
+                            LoudsTrie::Callback::SEARCH_CONTINUE);
+  a_callback.AddExpectation("ae", 2, builder.GetId("ae"),
+                            LoudsTrie::Callback::SEARCH_CONTINUE);
+
+  // "ab" is expanded to "ad" as well. Culling for "a" doesn't affect "ab".
+  TestCallback ab_callback;
+  ab_callback.AddExpectation("ab", 2, builder.GetId("ab"),
+                             LoudsTrie::Callback::SEARCH_CONTINUE);
+  ab_callback.AddExpectation("abc", 3, builder.GetId("abc"),
+                             LoudsTrie::Callback::SEARCH_CONTINUE);
+  ab_callback.AddExpectation("abcd", 4, builder.GetId("abcd"),
+                             LoudsTrie::Callback::SEARCH_CONTINUE);
+  ab_callback.AddExpectation("abd", 3, builder.GetId("abd"),
+                             LoudsTrie::Callback::SEARCH_DONE);
+  // No callback for adc.
+
+  TestCallback abc_callback;
+  abc_callback.AddExpectation("abc", 3, builder.GetId("abc"),
+                              LoudsTrie::Callback::SEARCH_CONTINUE);
+  abc_callback.AddExpectation("abcd", 4, builder.GetId("abcd"),
+                              LoudsTrie::Callback::SEARCH_CONTINUE);
+  abc_callback.AddExpectation("adc", 3, builder.GetId("adc"),
+                              LoudsTrie::Callback::SEARCH_CONTINUE);
+
+  // No word begins with "ax".
+  TestCallback ax_callback;
+
+  TestCallback b_callback;
+  b_callback.AddExpectation("b", 1, builder.GetId("b"),
+                            LoudsTrie::Callback::SEARCH_CONTINUE);
+
+  vector<TestCallback *> callbacks;
+  callbacks.push_back(&a_callback);
+  callbacks.push_back(&ab_callback);
+  callbacks.push_back(&abc_callback);
+  callbacks.push_back(&ax_callback);
+  callbacks.push_back(&b_callback);
+  MultiKeyTestCallback callback(callbacks);
+  trie.PredictiveSearchForKeys(keys, key_expansion_table, &callback);
+  EXPECT_EQ(4, a_callback.num_invoked());
+  EXPECT_EQ(4, ab_callback.num_invoked());
+  EXPECT_EQ(3, abc_callback.num_invoked());
+  EXPECT_EQ(0, ax_callback.num_invoked());
+  EXPECT_EQ(1, b_callback.num_invoked());
+
+  trie.Close();
+}
+
 TEST_F(LoudsTrieTest, Reverse) {
   LoudsTrieBuilder builder;
   builder.Add("aa");
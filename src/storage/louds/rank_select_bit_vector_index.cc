@@ -0,0 +1,252 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/louds/rank_select_bit_vector_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/port.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif  // __BMI2__
+
+namespace mozc {
+namespace storage {
+namespace louds {
+
+namespace {
+
+const int kWordsPerBlock = 8;
+const int kBitsPerBlock = 512;
+const int kSelectSampleRate = 512;
+
+#ifdef __GNUC__
+inline int BitCount1(uint64 x) {
+  return __builtin_popcountll(x);
+}
+#else
+int BitCount1(uint64 x) {
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+}
+#endif
+
+// Returns the position of the k-th (0-origin) 1-bit in x.
+inline int SelectInWord(uint64 x, int k) {
+#if defined(__BMI2__)
+  return static_cast<int>(_tzcnt_u64(_pdep_u64(1ULL << k, x)));
+#else
+  int position = 0;
+  // Skip bytes by popcount first, then scan bits in the byte.
+  while (true) {
+    const int count = BitCount1(x & 0xFF);
+    if (k < count) {
+      break;
+    }
+    k -= count;
+    x >>= 8;
+    position += 8;
+  }
+  for (; ; x >>= 1, ++position) {
+    if (x & 1) {
+      if (k == 0) {
+        return position;
+      }
+      --k;
+    }
+  }
+#endif  // __BMI2__
+}
+
+}  // namespace
+
+RankSelectBitVectorIndex::RankSelectBitVectorIndex()
+    : data_(NULL), length_(0), num_full_words_(0), last_word_(0) {
+}
+
+void RankSelectBitVectorIndex::Init(const uint8 *data, int length) {
+  DCHECK_EQ(length % 4, 0);
+  data_ = data;
+  length_ = length;
+  num_full_words_ = length / 8;
+  last_word_ = 0;
+  if (length % 8 != 0) {
+    memcpy(&last_word_, data + num_full_words_ * 8, length % 8);
+  }
+
+  const int num_words = (length + 7) / 8;
+  const int num_blocks = (num_words + kWordsPerBlock - 1) / kWordsPerBlock;
+  counts_.assign(2 * (num_blocks + 1), 0);
+  uint64 num_bits = 0;
+  for (int block = 0; block < num_blocks; ++block) {
+    counts_[2 * block] = num_bits;
+    uint64 relative_counts = 0;
+    uint64 block_bits = 0;
+    for (int word = 0; word < kWordsPerBlock; ++word) {
+      if (word > 0) {
+        relative_counts |= block_bits << (9 * (word - 1));
+      }
+      const int index = block * kWordsPerBlock + word;
+      if (index < num_words) {
+        block_bits += BitCount1(GetWord(index));
+      }
+    }
+    counts_[2 * block + 1] = relative_counts;
+    num_bits += block_bits;
+  }
+  counts_[2 * num_blocks] = num_bits;
+
+  // Sample the blocks for select.
+  const int total_bits = length * 8;
+  select0_hints_.clear();
+  select1_hints_.clear();
+  int next0 = 1;
+  int next1 = 1;
+  for (int block = 0; block < num_blocks; ++block) {
+    const int end_bits = min(total_bits, (block + 1) * kBitsPerBlock);
+    const int ones = GetBlockRank1(block + 1);
+    const int zeros = end_bits - ones;
+    for (; next1 <= ones; next1 += kSelectSampleRate) {
+      select1_hints_.push_back(block);
+    }
+    for (; next0 <= zeros; next0 += kSelectSampleRate) {
+      select0_hints_.push_back(block);
+    }
+  }
+}
+
+void RankSelectBitVectorIndex::Reset() {
+  data_ = NULL;
+  length_ = 0;
+  num_full_words_ = 0;
+  last_word_ = 0;
+  counts_.clear();
+  select0_hints_.clear();
+  select1_hints_.clear();
+}
+
+uint64 RankSelectBitVectorIndex::GetWord(int index) const {
+  if (index < num_full_words_) {
+    uint64 word;
+    memcpy(&word, data_ + index * 8, sizeof(word));
+    return word;
+  }
+  DCHECK_EQ(num_full_words_, index);
+  return last_word_;
+}
+
+int RankSelectBitVectorIndex::GetWordRank1(int block, int word) const {
+  if (word == 0) {
+    return 0;
+  }
+  return static_cast<int>(
+      (counts_[2 * block + 1] >> (9 * (word - 1))) & 0x1FF);
+}
+
+int RankSelectBitVectorIndex::Rank1(int n) const {
+  const int block = n / kBitsPerBlock;
+  const int word = (n / 64) % kWordsPerBlock;
+  int result = GetBlockRank1(block) + GetWordRank1(block, word);
+  if (n % 64 > 0) {
+    const uint64 mask = (static_cast<uint64>(1) << (n % 64)) - 1;
+    result += BitCount1(GetWord(n / 64) & mask);
+  }
+  return result;
+}
+
+int RankSelectBitVectorIndex::FindBlock(
+    int n, int begin, int end, bool zero) const {
+  // Binary search for the last block whose preceding bits are less than n.
+  while (begin < end) {
+    const int middle = (begin + end + 1) / 2;
+    const int rank1 = GetBlockRank1(middle);
+    const int count = zero ? middle * kBitsPerBlock - rank1 : rank1;
+    if (count < n) {
+      begin = middle;
+    } else {
+      end = middle - 1;
+    }
+  }
+  return begin;
+}
+
+int RankSelectBitVectorIndex::Select0(int n) const {
+  DCHECK_GT(n, 0);
+  const int sample = (n - 1) / kSelectSampleRate;
+  DCHECK_LT(sample, select0_hints_.size());
+  const int last_block = counts_.size() / 2 - 2;
+  const int block = FindBlock(
+      n, select0_hints_[sample],
+      sample + 1 < select0_hints_.size() ?
+          select0_hints_[sample + 1] : last_block,
+      true);
+  n -= block * kBitsPerBlock - GetBlockRank1(block);
+
+  // Find the word by the relative counts.
+  int word = 0;
+  while (word + 1 < kWordsPerBlock &&
+         (word + 1) * 64 - GetWordRank1(block, word + 1) < n) {
+    ++word;
+  }
+  n -= word * 64 - GetWordRank1(block, word);
+  const int index = block * kWordsPerBlock + word;
+  return index * 64 + SelectInWord(~GetWord(index), n - 1);
+}
+
+int RankSelectBitVectorIndex::Select1(int n) const {
+  DCHECK_GT(n, 0);
+  const int sample = (n - 1) / kSelectSampleRate;
+  DCHECK_LT(sample, select1_hints_.size());
+  const int last_block = counts_.size() / 2 - 2;
+  const int block = FindBlock(
+      n, select1_hints_[sample],
+      sample + 1 < select1_hints_.size() ?
+          select1_hints_[sample + 1] : last_block,
+      false);
+  n -= GetBlockRank1(block);
+
+  // Find the word by the relative counts.
+  int word = 0;
+  while (word + 1 < kWordsPerBlock && GetWordRank1(block, word + 1) < n) {
+    ++word;
+  }
+  n -= GetWordRank1(block, word);
+  const int index = block * kWordsPerBlock + word;
+  return index * 64 + SelectInWord(GetWord(index), n - 1);
+}
+
+}  // namespace louds
+}  // namespace storage
+}  // namespace mozc
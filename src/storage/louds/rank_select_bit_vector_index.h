@@ -0,0 +1,125 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_STORAGE_LOUDS_RANK_SELECT_BIT_VECTOR_INDEX_H_
+#define MOZC_STORAGE_LOUDS_RANK_SELECT_BIT_VECTOR_INDEX_H_
+
+#include <vector>
+#include "base/port.h"
+
+namespace mozc {
+namespace storage {
+namespace louds {
+
+// Succinct bit vector with a two-level rank index and sampled select hints,
+// based on "rank9" by S. Vigna (Broadword Implementation of Rank/Select
+// Queries, 2008).
+// The bit vector is divided into 512-bit blocks. For each block, the index
+// keeps the number of 1-bits before the block and, packed in 9 bits each,
+// the number of 1-bits from the beginning of the block to each of its
+// 64-bit words. So Rank is two table lookups plus one popcount.
+// For Select, the blocks containing every 512th 0-bit and 1-bit are
+// recorded to narrow the search range of the blocks.
+// This class has the same interface as SimpleSuccinctBitVectorIndex.
+class RankSelectBitVectorIndex {
+ public:
+  RankSelectBitVectorIndex();
+
+  // Initializes the index. This class doesn't have the ownership of the memory
+  // pointed by data, so it is caller's responsibility to manage its life time.
+  // The 'data' needs to be aligned to 32-bits, and 'length' (in bytes) needs
+  // to be a multiple of 4.
+  void Init(const uint8 *data, int length);
+
+  // Resets the internal state, especially releases the allocated memory
+  // for the index used internally.
+  void Reset();
+
+  // Returns the bit at the index in data. The index in a byte is as follows;
+  // MSB|XXXXXXXX|LSB
+  //     76543210
+  int Get(int index) const {
+    return (data_[index / 8] >> (index % 8)) & 1;
+  }
+
+  // Returns the number of 0-bit in [0, n) bits of data.
+  int Rank0(int n) const {
+    return n - Rank1(n);
+  }
+
+  // Returns the number of 1-bit in [0, n) bits of data.
+  int Rank1(int n) const;
+
+  // Returns the position of n-th 0-bit on the data. (n is 1-origin).
+  // Returned index is 0-origin.
+  int Select0(int n) const;
+
+  // Returns the position of n-th 1-bit in the data. (n is 1-origin).
+  // Returned index is 0-origin.
+  int Select1(int n) const;
+
+ private:
+  // Returns the index-th 64-bit word of the data.
+  uint64 GetWord(int index) const;
+
+  // Returns the number of 1-bits before the block.
+  int GetBlockRank1(int block) const {
+    return static_cast<int>(counts_[block * 2]);
+  }
+
+  // Returns the number of 1-bits from the beginning of the block to the
+  // word (0 <= word < 8).
+  int GetWordRank1(int block, int word) const;
+
+  // Returns the last block in [begin, end] whose number of preceding bits
+  // (0-bits if zero is true) is less than n.
+  int FindBlock(int n, int begin, int end, bool zero) const;
+
+  const uint8 *data_;
+  int length_;
+  int num_full_words_;
+  uint64 last_word_;
+
+  // counts_[2 * i] is the number of 1-bits before the i-th block, and
+  // counts_[2 * i + 1] is the packed 9-bit relative counts of its words.
+  // There is a sentinel block at the end.
+  vector<uint64> counts_;
+
+  // The blocks containing the (512 * i + 1)-th 0-bit and 1-bit.
+  vector<int> select0_hints_;
+  vector<int> select1_hints_;
+
+  DISALLOW_COPY_AND_ASSIGN(RankSelectBitVectorIndex);
+};
+
+}  // namespace louds
+}  // namespace storage
+}  // namespace mozc
+
+#endif  // MOZC_STORAGE_LOUDS_RANK_SELECT_BIT_VECTOR_INDEX_H_
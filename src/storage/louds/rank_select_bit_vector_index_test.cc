@@ -0,0 +1,212 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/louds/rank_select_bit_vector_index.h"
+
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/port.h"
+#include "base/stopwatch.h"
+#include "storage/louds/simple_succinct_bit_vector_index.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace storage {
+namespace louds {
+namespace {
+
+class RankSelectBitVectorIndexTest : public ::testing::Test {
+ protected:
+  // Generates |length| bytes of random bits where each bit is 1 with the
+  // probability of |density| / 256.
+  static void MakeRandomData(int length, int density, uint32 seed,
+                             vector<uint32> *data) {
+    data->assign(length / 4, 0);
+    uint8 *bytes = reinterpret_cast<uint8 *>(&(*data)[0]);
+    uint32 x = seed;
+    for (int i = 0; i < length * 8; ++i) {
+      // xorshift32.
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      if (static_cast<int>(x & 0xFF) < density) {
+        bytes[i / 8] |= (1 << (i % 8));
+      }
+    }
+  }
+};
+
+TEST_F(RankSelectBitVectorIndexTest, Rank) {
+  static const char kData[] = "\x00\x00\xFF\xFF\x00\x00\xFF\xFF";
+  RankSelectBitVectorIndex bit_vector;
+
+  bit_vector.Init(reinterpret_cast<const uint8 *>(kData), 8);
+  EXPECT_EQ(0, bit_vector.Rank0(0));
+  EXPECT_EQ(0, bit_vector.Rank1(0));
+
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(i, bit_vector.Rank0(i)) << i;
+    EXPECT_EQ(0, bit_vector.Rank1(i)) << i;
+  }
+  for (int i = 17; i <= 32; ++i) {
+    EXPECT_EQ(16, bit_vector.Rank0(i)) << i;
+    EXPECT_EQ(i - 16, bit_vector.Rank1(i)) << i;
+  }
+  for (int i = 33; i <= 48; ++i) {
+    EXPECT_EQ(i - 16, bit_vector.Rank0(i)) << i;
+    EXPECT_EQ(16, bit_vector.Rank1(i)) << i;
+  }
+  for (int i = 49; i <= 64; ++i) {
+    EXPECT_EQ(32, bit_vector.Rank0(i)) << i;
+    EXPECT_EQ(i - 32, bit_vector.Rank1(i)) << i;
+  }
+}
+
+TEST_F(RankSelectBitVectorIndexTest, Select) {
+  static const char kData[] = "\x00\x00\xFF\xFF\x00\x00\xFF\xFF";
+  RankSelectBitVectorIndex bit_vector;
+
+  bit_vector.Init(reinterpret_cast<const uint8 *>(kData), 8);
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(i - 1, bit_vector.Select0(i)) << i;
+  }
+  for (int i = 17; i <= 32; ++i) {
+    EXPECT_EQ(i + 15, bit_vector.Select0(i)) << i;
+  }
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(i + 15, bit_vector.Select1(i)) << i;
+  }
+  for (int i = 17; i <= 32; ++i) {
+    EXPECT_EQ(i + 31, bit_vector.Select1(i)) << i;
+  }
+}
+
+TEST_F(RankSelectBitVectorIndexTest, Pattern) {
+  // Repeat the bit pattern '0b10101010'.
+  const string data(1024, '\xAA');
+
+  RankSelectBitVectorIndex bit_vector;
+  bit_vector.Init(reinterpret_cast<const uint8 *>(data.data()), data.length());
+  for (int i = 0; i < 1024 * 8; ++i) {
+    EXPECT_EQ((i + 1) / 2, bit_vector.Rank0(i)) << i;
+    EXPECT_EQ(i / 2, bit_vector.Rank1(i)) << i;
+  }
+  for (int i = 0; i < 1024 * 4; ++i) {
+    EXPECT_EQ(i * 2, bit_vector.Select0(i + 1)) << i;
+    EXPECT_EQ(i * 2 + 1, bit_vector.Select1(i + 1)) << i;
+  }
+}
+
+TEST_F(RankSelectBitVectorIndexTest, CompareWithSimpleIndex) {
+  // Covers the lengths which are not multiple of the word and block size,
+  // and both sparse and dense bit vectors.
+  const int kLengths[] = {4, 8, 12, 60, 64, 68, 1028, 4096, 10004};
+  const int kDensities[] = {0, 3, 128, 250, 256};
+  for (size_t i = 0; i < arraysize(kLengths); ++i) {
+    for (size_t j = 0; j < arraysize(kDensities); ++j) {
+      vector<uint32> data;
+      MakeRandomData(kLengths[i], kDensities[j], i * 100 + j + 1, &data);
+      const uint8 *image = reinterpret_cast<const uint8 *>(&data[0]);
+      SimpleSuccinctBitVectorIndex expected;
+      expected.Init(image, kLengths[i]);
+      RankSelectBitVectorIndex actual;
+      actual.Init(image, kLengths[i]);
+
+      const int num_bits = kLengths[i] * 8;
+      for (int n = 0; n <= num_bits; ++n) {
+        ASSERT_EQ(expected.Rank1(n), actual.Rank1(n))
+            << kLengths[i] << " " << kDensities[j] << " " << n;
+      }
+      const int num_ones = expected.Rank1(num_bits);
+      for (int n = 1; n <= num_ones; ++n) {
+        ASSERT_EQ(expected.Select1(n), actual.Select1(n))
+            << kLengths[i] << " " << kDensities[j] << " " << n;
+      }
+      for (int n = 1; n <= num_bits - num_ones; ++n) {
+        ASSERT_EQ(expected.Select0(n), actual.Select0(n))
+            << kLengths[i] << " " << kDensities[j] << " " << n;
+      }
+    }
+  }
+}
+
+TEST_F(RankSelectBitVectorIndexTest, Reset) {
+  static const char kData[] = "\xFF\xFF\xFF\xFF";
+  RankSelectBitVectorIndex bit_vector;
+  bit_vector.Init(reinterpret_cast<const uint8 *>(kData), 4);
+  EXPECT_EQ(32, bit_vector.Rank1(32));
+  bit_vector.Reset();
+  bit_vector.Init(reinterpret_cast<const uint8 *>(kData), 4);
+  EXPECT_EQ(31, bit_vector.Select1(32));
+}
+
+// Not a correctness test; logs the time of the queries on both indices for
+// the bit vector as large as the system dictionary's LOUDS.
+template <typename Index>
+double BenchmarkIndex(const vector<uint32> &data, int num_queries) {
+  const int length = data.size() * 4;
+  Index index;
+  index.Init(reinterpret_cast<const uint8 *>(&data[0]), length);
+  const int num_bits = length * 8;
+  const int num_ones = index.Rank1(num_bits);
+  const int num_zeros = num_bits - num_ones;
+  int checksum = 0;
+  Stopwatch stopwatch = Stopwatch::StartNew();
+  uint32 x = 1;
+  for (int i = 0; i < num_queries; ++i) {
+    x = x * 1103515245 + 12345;
+    checksum += index.Rank1(x % num_bits);
+    checksum += index.Select0(x % num_zeros + 1);
+    checksum += index.Select1(x % num_ones + 1);
+  }
+  stopwatch.Stop();
+  VLOG(1) << "checksum: " << checksum;
+  return stopwatch.GetElapsedNanoseconds() / num_queries;
+}
+
+TEST_F(RankSelectBitVectorIndexTest, Benchmark) {
+  const int kLength = 4 << 20;
+  const int kNumQueries = 100000;
+  vector<uint32> data;
+  MakeRandomData(kLength, 128, 1, &data);
+  const double simple_ns =
+      BenchmarkIndex<SimpleSuccinctBitVectorIndex>(data, kNumQueries);
+  const double rank_select_ns =
+      BenchmarkIndex<RankSelectBitVectorIndex>(data, kNumQueries);
+  LOG(INFO) << "Rank1 + Select0 + Select1 [ns/query] "
+            << "SimpleSuccinctBitVectorIndex: " << simple_ns
+            << " RankSelectBitVectorIndex: " << rank_select_ns;
+}
+
+}  // namespace
+}  // namespace louds
+}  // namespace storage
+}  // namespace mozc
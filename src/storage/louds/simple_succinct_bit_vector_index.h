@@ -89,7 +89,7 @@ class SimpleSuccinctBitVectorIndex {
   int length_;
   int chunk_size_;
 
-  // TODO(hidehiko): Create two-level index for more performance.
+  // See RankSelectBitVectorIndex for the two-level index.
   vector<int> index_;
 
   DISALLOW_COPY_AND_ASSIGN(SimpleSuccinctBitVectorIndex);
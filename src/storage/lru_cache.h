@@ -31,15 +31,40 @@
 #define MOZC_STORAGE_LRU_CACHE_H_
 
 #include <cstring>
-#include <map>
 #include <string>
 
 #include "base/logging.h"
 #include "base/port.h"
+#include "base/util.h"
 
 namespace mozc {
 namespace storage {
 
+// Hash function of the keys of LRUCache. The default works for the integral
+// keys, e.g., fingerprints and session ids. Specialize this for other key
+// types.
+template<typename Key>
+struct LRUCacheKeyHash {
+  static uint32 Hash(const Key &key) {
+    // Mixes the bits (the finalizer of MurmurHash3), since sequential ids
+    // would be clustered in the table otherwise.
+    uint64 k = static_cast<uint64>(key);
+    k ^= k >> 33;
+    k *= GG_ULONGLONG(0xff51afd7ed558ccd);
+    k ^= k >> 33;
+    k *= GG_ULONGLONG(0xc4ceb9fe1a85ec53);
+    k ^= k >> 33;
+    return static_cast<uint32>(k);
+  }
+};
+
+template<>
+struct LRUCacheKeyHash<string> {
+  static uint32 Hash(const string &key) {
+    return Util::Fingerprint32(key);
+  }
+};
+
 // Note: this class keeps some resources inside of the Key/Value, even if
 // such a entry is erased. Be careful to use for such classes.
 template<typename Key, typename Value>
@@ -125,6 +150,26 @@ class LRUCache {
   // key is found.
   Element* LookupInternal(const Key &key) const;
 
+  // Slot of the hash table. |element| is NULL for an empty slot, and |hash|
+  // caches the hash value of element->key.
+  struct Slot {
+    Element *element;
+    uint32 hash;
+  };
+
+  // Returns the slot of key, or NULL if no element with this key is found.
+  Slot *FindSlot(const Key &key, uint32 hash) const;
+
+  // Adds the element to the hash table. The key must not be in the table.
+  void InsertSlot(Element *element, uint32 hash);
+
+  // Removes the element in the slot from the hash table.
+  void EraseSlot(Slot *slot);
+
+  // Reallocates the hash table with table_size slots, which must be a power
+  // of two.
+  void ResizeTable(size_t table_size);
+
   // Removes the specified element from the LRU list.
   void RemoveFromLRU(Element* element);
 
@@ -136,9 +181,12 @@ class LRUCache {
   // lookup is not necessary.
   bool Evict(Element* element);
 
-  typedef map<Key, Element*> Table;
-
-  Table* table_;
+  // Open-addressing hash table with linear probing, which indexes the
+  // elements by key. The number of slots is a power of two, and at most half
+  // of them are used so that the probe sequences are short.
+  Slot* table_;
+  size_t table_size_;       // number of slots in table_
+  size_t size_;             // number of elements in table_
   Element* free_list_;     // singly linked list of Element
   Element* lru_head_;      // head of doubly linked list of Element
   Element* lru_tail_;      // tail of doubly linked list of Element
@@ -223,13 +271,86 @@ LRUCache<Key, Value>::NextFreeElement() {
 template<typename Key, typename Value>
 typename LRUCache<Key, Value>::Element*
 LRUCache<Key, Value>::LookupInternal(const Key &key) const {
-  typename Table::iterator iter = table_->find(key);
-  if (iter != table_->end()) {
-    return iter->second;
+  const Slot *slot = FindSlot(key, LRUCacheKeyHash<Key>::Hash(key));
+  if (slot != NULL) {
+    return slot->element;
+  }
+  return NULL;
+}
+
+template<typename Key, typename Value>
+typename LRUCache<Key, Value>::Slot*
+LRUCache<Key, Value>::FindSlot(const Key &key, uint32 hash) const {
+  const size_t mask = table_size_ - 1;
+  for (size_t i = hash & mask; table_[i].element != NULL;
+       i = (i + 1) & mask) {
+    if (table_[i].hash == hash && table_[i].element->key == key) {
+      return &table_[i];
+    }
   }
   return NULL;
 }
 
+template<typename Key, typename Value>
+void LRUCache<Key, Value>::InsertSlot(Element *element, uint32 hash) {
+  if ((size_ + 1) * 2 > table_size_) {
+    ResizeTable(table_size_ * 2);
+  }
+  const size_t mask = table_size_ - 1;
+  size_t i = hash & mask;
+  while (table_[i].element != NULL) {
+    i = (i + 1) & mask;
+  }
+  table_[i].element = element;
+  table_[i].hash = hash;
+  ++size_;
+}
+
+template<typename Key, typename Value>
+void LRUCache<Key, Value>::EraseSlot(Slot *slot) {
+  // Instead of leaving a tombstone, moves back the following elements in the
+  // probe sequence which would become unreachable through the empty slot.
+  const size_t mask = table_size_ - 1;
+  size_t empty = slot - table_;
+  for (size_t i = (empty + 1) & mask; table_[i].element != NULL;
+       i = (i + 1) & mask) {
+    const size_t home = table_[i].hash & mask;
+    // The element stays if its home slot is cyclically in (empty, i].
+    const bool stays = (empty < i) ?
+        (empty < home && home <= i) : (empty < home || home <= i);
+    if (!stays) {
+      table_[empty] = table_[i];
+      empty = i;
+    }
+  }
+  table_[empty].element = NULL;
+  --size_;
+}
+
+template<typename Key, typename Value>
+void LRUCache<Key, Value>::ResizeTable(size_t table_size) {
+  DCHECK_EQ(0, table_size & (table_size - 1));
+  Slot *old_table = table_;
+  const size_t old_table_size = table_size_;
+  table_ = new Slot[table_size];
+  table_size_ = table_size;
+  for (size_t i = 0; i < table_size_; ++i) {
+    table_[i].element = NULL;
+  }
+  const size_t mask = table_size_ - 1;
+  for (size_t i = 0; i < old_table_size; ++i) {
+    if (old_table[i].element == NULL) {
+      continue;
+    }
+    size_t j = old_table[i].hash & mask;
+    while (table_[j].element != NULL) {
+      j = (j + 1) & mask;
+    }
+    table_[j] = old_table[i];
+  }
+  delete [] old_table;
+}
+
 template<typename Key, typename Value>
 void LRUCache<Key, Value>::RemoveFromLRU(Element* element) {
   if (lru_head_ == element) {
@@ -268,8 +389,9 @@ void LRUCache<Key, Value>::PushLRUHead(Element* element) {
 template<typename Key, typename Value>
 bool LRUCache<Key, Value>::Evict(Element* e) {
   if (e != NULL) {
-    int erased = table_->erase(e->key);
-    CHECK_EQ(erased, 1);
+    Slot *slot = FindSlot(e->key, LRUCacheKeyHash<Key>::Hash(e->key));
+    CHECK(slot != NULL);
+    EraseSlot(slot);
     RemoveFromLRU(e);
     PushFreeList(e);
     return true;
@@ -279,15 +401,18 @@ bool LRUCache<Key, Value>::Evict(Element* e) {
 
 template<typename Key, typename Value>
 LRUCache<Key, Value>::LRUCache(size_t max_elements)
-  : free_list_(NULL),
+  : table_(NULL),
+    table_size_(0),
+    size_(0),
+    free_list_(NULL),
     lru_head_(NULL),
     lru_tail_(NULL),
     block_count_(0),
     block_capacity_(0),
     max_elements_(max_elements) {
   ::memset(blocks_, 0, sizeof(blocks_));
-  table_ = new Table;
-  CHECK(table_);
+  // The table grows as the elements are added, like the blocks.
+  ResizeTable(16);
   if (max_elements_ <= 128) {
     next_block_size_ = max_elements_;
   } else {
@@ -308,7 +433,7 @@ template<typename Key, typename Value>
 LRUCache<Key, Value>::~LRUCache() {
   // To free all the memory that I have allocated I need to delete table_ and
   // any used entries in blocks_.
-  delete table_;
+  delete [] table_;
   for (size_t i = 0; i < block_count_; ++i) {
     delete [] blocks_[i];
   }
@@ -343,7 +468,7 @@ LRUCache<Key, Value>::Insert(const Key& key) {
     CHECK(e != NULL);
   }
   e->key = key;
-  (*table_)[key] = e;
+  InsertSlot(e, LRUCacheKeyHash<Key>::Hash(key));
   PushLRUHead(e);
 
   return e;
@@ -386,7 +511,10 @@ bool LRUCache<Key, Value>::Erase(const Key& key) {
 
 template<typename Key, typename Value>
 void LRUCache<Key, Value>::Clear() {
-  table_->clear();
+  for (size_t i = 0; i < table_size_; ++i) {
+    table_[i].element = NULL;
+  }
+  size_ = 0;
   Element* e = lru_head_;
   while (e != NULL) {
     Element* next = e->next;
@@ -398,12 +526,12 @@ void LRUCache<Key, Value>::Clear() {
 
 template<typename Key, typename Value>
 bool LRUCache<Key, Value>::HasKey(const Key& key) const {
-  return (table_->find(key) != table_->end());
+  return LookupInternal(key) != NULL;
 }
 
 template<typename Key, typename Value>
 size_t LRUCache<Key, Value>::Size() const {
-  return table_->size();
+  return size_;
 }
 
 }  // namespace storage
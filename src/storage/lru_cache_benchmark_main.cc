@@ -0,0 +1,275 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Micro benchmarks of LRUCache, compared with the map-indexed LRU cache it
+// used to be.
+//
+// The keys are 32-bit fingerprints like the ones of UserHistoryPredictor.
+// Each operation looks up or inserts --lru_cache_keys_per_op keys, which is
+// about the number of lookups per keystroke.
+//
+// Example:
+//   lru_cache_benchmark_main --lru_cache_size=10000
+//       --benchmark_output=/tmp/result.json
+
+#include <iostream>  // NOLINT
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/benchmark.h"
+#include "base/file_stream.h"
+#include "base/flags.h"
+#include "base/logging.h"
+#include "base/port.h"
+#include "base/scoped_ptr.h"
+#include "base/util.h"
+#include "storage/lru_cache.h"
+
+DEFINE_string(benchmark_filter, "",
+              "run only the benchmarks whose names contain this string");
+DEFINE_string(benchmark_output, "",
+              "if set, write the results to this file as JSON");
+DEFINE_int32(benchmark_min_time_ms, 1000,
+             "minimum time to run each benchmark");
+DEFINE_int32(benchmark_min_ops, 100,
+             "minimum number of operations to run each benchmark");
+DEFINE_int32(lru_cache_size, 10000, "maximum number of elements");
+DEFINE_int32(lru_cache_keys_per_op, 100,
+             "number of keys looked up or inserted in each operation");
+
+namespace mozc {
+namespace storage {
+namespace {
+
+// Same as LRUCache, but indexes the elements with map as LRUCache did
+// before, for comparison.  Only the operations used by the benchmarks are
+// implemented.  Note that this allocates a list node per insertion, while
+// LRUCache reuses the elements.
+template<typename Key, typename Value>
+class MapIndexedLRUCache {
+ public:
+  explicit MapIndexedLRUCache(size_t max_elements)
+      : max_elements_(max_elements) {}
+
+  void Insert(const Key &key, const Value &value) {
+    typename Table::iterator iter = table_.find(key);
+    if (iter != table_.end()) {
+      lru_.erase(iter->second);
+      table_.erase(iter);
+    } else if (table_.size() >= max_elements_) {
+      table_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    lru_.push_front(make_pair(key, value));
+    table_[key] = lru_.begin();
+  }
+
+  const Value *Lookup(const Key &key) {
+    typename Table::iterator iter = table_.find(key);
+    if (iter == table_.end()) {
+      return NULL;
+    }
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    return &iter->second->second;
+  }
+
+  const Value *LookupWithoutInsert(const Key &key) const {
+    typename Table::const_iterator iter = table_.find(key);
+    if (iter == table_.end()) {
+      return NULL;
+    }
+    return &iter->second->second;
+  }
+
+ private:
+  typedef list<pair<Key, Value> > List;
+  typedef map<Key, typename List::iterator> Table;
+
+  const size_t max_elements_;
+  List lru_;
+  Table table_;
+
+  DISALLOW_COPY_AND_ASSIGN(MapIndexedLRUCache);
+};
+
+// Keys of the benchmarks.  The cache is filled with |hit_keys|, and
+// |miss_keys| are not in it.
+struct Keys {
+  vector<uint32> hit_keys;
+  vector<uint32> miss_keys;
+};
+
+void MakeKeys(size_t size, Keys *keys) {
+  for (size_t i = 0; i < size * 2; ++i) {
+    const uint32 key = Util::Fingerprint32(Util::StringPrintf("key%d", static_cast<int>(i)));
+    if (i % 2 == 0) {
+      keys->hit_keys.push_back(key);
+    } else {
+      keys->miss_keys.push_back(key);
+    }
+  }
+}
+
+template<typename Cache>
+class LRUCacheBenchmark : public BenchmarkInterface {
+ public:
+  enum Operation {
+    // Lookup() of the keys in the cache, which moves them to the head.
+    LOOKUP,
+    // LookupWithoutInsert() of the keys in the cache.
+    LOOKUP_WITHOUT_INSERT_HIT,
+    // LookupWithoutInsert() of the keys not in the cache.
+    LOOKUP_WITHOUT_INSERT_MISS,
+    // Insert() of the keys not in the cache, which evicts the tail.
+    INSERT,
+  };
+
+  LRUCacheBenchmark(const string &name, Operation operation,
+                    const Keys *keys)
+      : name_(name), operation_(operation), keys_(keys), index_(0),
+        checksum_(0) {}
+
+  virtual string name() const { return name_; }
+
+  virtual void SetUp() {
+    cache_.reset(new Cache(keys_->hit_keys.size()));
+    for (size_t i = 0; i < keys_->hit_keys.size(); ++i) {
+      cache_->Insert(keys_->hit_keys[i], i);
+    }
+  }
+
+  virtual void PrepareOp() {
+    index_ += FLAGS_lru_cache_keys_per_op;
+  }
+
+  virtual void RunOp() {
+    const size_t size = keys_->hit_keys.size();
+    const size_t keys_per_op = FLAGS_lru_cache_keys_per_op;
+    for (size_t i = 0; i < keys_per_op; ++i) {
+      const size_t index = (index_ + i) % size;
+      const uint32 *value = NULL;
+      switch (operation_) {
+        case LOOKUP:
+          value = cache_->Lookup(keys_->hit_keys[index]);
+          break;
+        case LOOKUP_WITHOUT_INSERT_HIT:
+          value = cache_->LookupWithoutInsert(keys_->hit_keys[index]);
+          break;
+        case LOOKUP_WITHOUT_INSERT_MISS:
+          value = cache_->LookupWithoutInsert(keys_->miss_keys[index]);
+          break;
+        case INSERT:
+          // Alternates the two sets of the keys, so that the inserted keys
+          // are always new ones.
+          cache_->Insert((index_ / size) % 2 == 0 ?
+                         keys_->miss_keys[index] : keys_->hit_keys[index],
+                         index);
+          break;
+      }
+      if (value != NULL) {
+        checksum_ += *value;
+      }
+    }
+  }
+
+  virtual void TearDown() {
+    // Uses the results so that the lookups are not optimized out.
+    VLOG(1) << name_ << " checksum: " << checksum_;
+    cache_.reset();
+  }
+
+ private:
+  const string name_;
+  const Operation operation_;
+  const Keys *keys_;
+  size_t index_;
+  uint32 checksum_;
+  scoped_ptr<Cache> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(LRUCacheBenchmark);
+};
+
+template<typename Cache>
+void AddBenchmarks(const string &prefix, const Keys *keys,
+                   vector<BenchmarkInterface *> *benchmarks) {
+  typedef LRUCacheBenchmark<Cache> Benchmark;
+  benchmarks->push_back(new Benchmark(
+      prefix + "/Lookup", Benchmark::LOOKUP, keys));
+  benchmarks->push_back(new Benchmark(
+      prefix + "/LookupWithoutInsertHit", Benchmark::LOOKUP_WITHOUT_INSERT_HIT,
+      keys));
+  benchmarks->push_back(new Benchmark(
+      prefix + "/LookupWithoutInsertMiss",
+      Benchmark::LOOKUP_WITHOUT_INSERT_MISS, keys));
+  benchmarks->push_back(new Benchmark(
+      prefix + "/Insert", Benchmark::INSERT, keys));
+}
+
+void RunBenchmarks() {
+  CHECK_GT(FLAGS_lru_cache_size, 0);
+  Keys keys;
+  MakeKeys(FLAGS_lru_cache_size, &keys);
+
+  vector<BenchmarkInterface *> benchmarks;
+  AddBenchmarks<LRUCache<uint32, uint32> >("LRUCache", &keys, &benchmarks);
+  AddBenchmarks<MapIndexedLRUCache<uint32, uint32> >(
+      "MapIndexedLRUCache", &keys, &benchmarks);
+
+  BenchmarkRunner runner;
+  runner.set_min_ops(FLAGS_benchmark_min_ops);
+  runner.set_min_time_ms(FLAGS_benchmark_min_time_ms);
+
+  vector<BenchmarkResult> results;
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    if (benchmarks[i]->name().find(FLAGS_benchmark_filter) != string::npos) {
+      results.push_back(BenchmarkResult());
+      runner.Run(benchmarks[i], &results.back());
+    }
+    delete benchmarks[i];
+  }
+
+  cout << BenchmarkRunner::FormatAsText(results);
+  if (!FLAGS_benchmark_output.empty()) {
+    OutputFileStream ofs(FLAGS_benchmark_output.c_str());
+    ofs << BenchmarkRunner::FormatAsJson(results);
+  }
+}
+
+}  // namespace
+}  // namespace storage
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  InitGoogle(argv[0], &argc, &argv, false);
+  mozc::storage::RunBenchmarks();
+  return 0;
+}
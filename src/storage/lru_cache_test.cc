@@ -0,0 +1,170 @@
+// Copyright 2010-2014, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/lru_cache.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "base/port.h"
+#include "base/util.h"
+#include "testing/base/public/gunit.h"
+
+namespace mozc {
+namespace storage {
+namespace {
+
+TEST(LRUCacheTest, InsertAndLookup) {
+  LRUCache<uint32, string> cache(3);
+  EXPECT_EQ(0, cache.Size());
+  EXPECT_TRUE(cache.Lookup(1) == NULL);
+
+  cache.Insert(1, "one");
+  cache.Insert(2, "two");
+  cache.Insert(3, "three");
+  EXPECT_EQ(3, cache.Size());
+  ASSERT_TRUE(cache.Lookup(1) != NULL);
+  EXPECT_EQ("one", *cache.Lookup(1));
+
+  // 2 is the least recently used, as 1 was looked up.
+  cache.Insert(4, "four");
+  EXPECT_EQ(3, cache.Size());
+  EXPECT_FALSE(cache.HasKey(2));
+  EXPECT_TRUE(cache.HasKey(1));
+  EXPECT_TRUE(cache.HasKey(3));
+  EXPECT_TRUE(cache.HasKey(4));
+
+  // Inserting an existing key updates the value.
+  cache.Insert(3, "THREE");
+  EXPECT_EQ(3, cache.Size());
+  ASSERT_TRUE(cache.LookupWithoutInsert(3) != NULL);
+  EXPECT_EQ("THREE", *cache.LookupWithoutInsert(3));
+
+  // LookupWithoutInsert() doesn't change the order.
+  EXPECT_EQ(3, cache.Head()->key);
+  EXPECT_TRUE(cache.LookupWithoutInsert(1) != NULL);
+  EXPECT_EQ(3, cache.Head()->key);
+  EXPECT_EQ(1, cache.Tail()->key);
+
+  EXPECT_TRUE(cache.Erase(4));
+  EXPECT_FALSE(cache.Erase(4));
+  EXPECT_EQ(2, cache.Size());
+  EXPECT_FALSE(cache.HasKey(4));
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.Size());
+  EXPECT_TRUE(cache.Head() == NULL);
+  EXPECT_FALSE(cache.HasKey(1));
+  cache.Insert(1, "one");
+  EXPECT_EQ(1, cache.Size());
+}
+
+TEST(LRUCacheTest, StringKey) {
+  LRUCache<string, int> cache(2);
+  cache.Insert("a", 1);
+  cache.Insert("b", 2);
+  cache.Insert("c", 3);
+  EXPECT_FALSE(cache.HasKey("a"));
+  ASSERT_TRUE(cache.Lookup("b") != NULL);
+  EXPECT_EQ(2, *cache.Lookup("b"));
+  ASSERT_TRUE(cache.Lookup("c") != NULL);
+  EXPECT_EQ(3, *cache.Lookup("c"));
+}
+
+// Compares random operations with a simple implementation, which also
+// covers the growth of the hash table and the removal from the middle of
+// the probe sequences.
+TEST(LRUCacheTest, RandomOperations) {
+  const size_t kMaxElements = 1000;
+  LRUCache<uint32, uint32> cache(kMaxElements);
+  list<uint32> expected_lru;  // From the most recently used one.
+  map<uint32, uint32> expected_values;
+
+  for (int i = 0; i < 100000; ++i) {
+    // Small key space to make collisions and hits frequent.
+    const uint32 key = static_cast<uint32>(Util::Random(3000));
+    switch (Util::Random(4)) {
+      case 0: {
+        const uint32 value = static_cast<uint32>(i);
+        cache.Insert(key, value);
+        if (expected_values.find(key) != expected_values.end()) {
+          expected_lru.remove(key);
+        } else if (expected_values.size() == kMaxElements) {
+          expected_values.erase(expected_lru.back());
+          expected_lru.pop_back();
+        }
+        expected_lru.push_front(key);
+        expected_values[key] = value;
+        break;
+      }
+      case 1: {
+        const uint32 *value = cache.Lookup(key);
+        map<uint32, uint32>::const_iterator iter = expected_values.find(key);
+        if (iter == expected_values.end()) {
+          EXPECT_TRUE(value == NULL);
+        } else {
+          ASSERT_TRUE(value != NULL);
+          EXPECT_EQ(iter->second, *value);
+          expected_lru.remove(key);
+          expected_lru.push_front(key);
+        }
+        break;
+      }
+      case 2: {
+        const bool erased = expected_values.erase(key) > 0;
+        if (erased) {
+          expected_lru.remove(key);
+        }
+        EXPECT_EQ(erased, cache.Erase(key));
+        break;
+      }
+      default: {
+        EXPECT_EQ(expected_values.find(key) != expected_values.end(),
+                  cache.HasKey(key));
+        break;
+      }
+    }
+    ASSERT_EQ(expected_values.size(), cache.Size());
+  }
+
+  // The LRU lists are the same.
+  const LRUCache<uint32, uint32>::Element *element = cache.Head();
+  for (list<uint32>::const_iterator iter = expected_lru.begin();
+       iter != expected_lru.end(); ++iter) {
+    ASSERT_TRUE(element != NULL);
+    EXPECT_EQ(*iter, element->key);
+    element = element->next;
+  }
+  EXPECT_TRUE(element == NULL);
+}
+
+}  // namespace
+}  // namespace storage
+}  // namespace mozc
@@ -34,6 +34,7 @@
       'type': 'static_library',
       'toolsets': ['target', 'host'],
       'sources': [
+        'encrypted_journal_storage.cc',
         'encrypted_string_storage.cc',
         'existence_filter.cc',
         'lru_storage.cc',
@@ -51,5 +52,16 @@
         'ARCHS': '$(ARCHS_UNIVERSAL_IPHONE_OS)',
       },
     },
+    {
+      'target_name': 'lru_cache_benchmark_main',
+      'type': 'executable',
+      'sources': [
+        'lru_cache_benchmark_main.cc',
+      ],
+      'dependencies': [
+        '../base/base.gyp:base',
+        '../base/base.gyp:benchmark',
+      ],
+    },
   ],
 }
@@ -33,8 +33,10 @@
       'target_name': 'storage_test',
       'type': 'executable',
       'sources': [
+        'encrypted_journal_storage_test.cc',
         'encrypted_string_storage_test.cc',
         'existence_filter_test.cc',
+        'lru_cache_test.cc',
         'lru_storage_test.cc',
         'memory_storage_test.cc',
         'registry_test.cc',
@@ -30,9 +30,14 @@
 #include "usage_stats/usage_stats.h"
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <numeric>
 
 #include "base/logging.h"
+#include "base/mutex.h"
+#include "base/scoped_ptr.h"
+#include "base/singleton.h"
 #include "config/stats_config_util.h"
 #include "storage/registry.h"
 #include "usage_stats/usage_stats.pb.h"
@@ -105,6 +110,150 @@ bool SetterInternal(const string &name, const Stats &stats) {
   }
   return true;
 }
+
+void MergeCount(const string &name, uint32 val) {
+  Stats stats;
+  if (GetterInternal(name, Stats::COUNT, &stats)) {
+    stats.set_count(stats.count() + val);
+  } else {
+    stats.set_name(name);
+    stats.set_type(Stats::COUNT);
+    stats.set_count(val);
+  }
+  SetterInternal(name, stats);
+}
+
+void MergeTiming(const string &name, uint32 num_timings, uint64 total_time,
+                 uint32 min_time, uint32 max_time) {
+  Stats stats;
+  if (GetterInternal(name, Stats::TIMING, &stats)) {
+    stats.set_num_timings(stats.num_timings() + num_timings);
+    stats.set_total_time(stats.total_time() + total_time);
+    stats.set_avg_time(stats.total_time() / stats.num_timings());
+    stats.set_min_time(min(stats.min_time(), min_time));
+    stats.set_max_time(max(stats.max_time(), max_time));
+  } else {
+    stats.set_name(name);
+    stats.set_type(Stats::TIMING);
+    stats.set_num_timings(num_timings);
+    stats.set_total_time(total_time);
+    stats.set_avg_time(total_time / num_timings);
+    stats.set_min_time(min_time);
+    stats.set_max_time(max_time);
+  }
+  SetterInternal(name, stats);
+}
+
+// Aggregates counts and timings in memory so that IncrementCountBy() and
+// UpdateTiming() don't have to parse and serialize a Stats message in the
+// registry for every call.  Each listed stats has a slot of atomic
+// variables, so updating it takes no lock.  The aggregated values are merged
+// into the registry by Flush(), which UsageStats::Sync() calls.
+//
+// A timing consists of several variables updated independently, so a Flush()
+// running concurrently with UpdateTiming() may take some of them in this
+// round and the rest in the next one.  The values are exact once all the
+// updates have been flushed.
+class PendingStats {
+ public:
+  PendingStats() : slots_(new Slot[arraysize(kStatsList)]) {
+    for (size_t i = 0; i < arraysize(kStatsList); ++i) {
+      index_[kStatsList[i]] = i;
+      ResetSlot(&slots_[i]);
+    }
+  }
+
+  // Returns the slot index of |name|, or -1 if |name| is not listed.
+  int GetIndex(const string &name) const {
+    const map<string, int>::const_iterator it = index_.find(name);
+    return it == index_.end() ? -1 : it->second;
+  }
+
+  void AddCount(int index, uint32 val) {
+    slots_[index].count.fetch_add(val, memory_order_relaxed);
+  }
+
+  void AddTiming(int index, uint32 val) {
+    Slot *slot = &slots_[index];
+    slot->total_time.fetch_add(val, memory_order_relaxed);
+    UpdateMin(&slot->min_time, val);
+    UpdateMax(&slot->max_time, val);
+    // Updated last with release semantics so that Flush() sees the other
+    // variables of this timing once it sees the number.
+    slot->num_timings.fetch_add(1, memory_order_release);
+  }
+
+  // Merges the aggregated values into the registry and resets them.
+  void Flush() {
+    scoped_lock l(&flush_mutex_);
+    for (size_t i = 0; i < arraysize(kStatsList); ++i) {
+      Slot *slot = &slots_[i];
+      const uint32 count = slot->count.exchange(0, memory_order_relaxed);
+      if (count > 0) {
+        MergeCount(kStatsList[i], count);
+      }
+      const uint32 num_timings =
+          slot->num_timings.exchange(0, memory_order_acquire);
+      if (num_timings > 0) {
+        const uint64 total_time =
+            slot->total_time.exchange(0, memory_order_relaxed);
+        const uint32 min_time =
+            slot->min_time.exchange(kuint32max, memory_order_relaxed);
+        const uint32 max_time =
+            slot->max_time.exchange(0, memory_order_relaxed);
+        MergeTiming(kStatsList[i], num_timings, total_time, min_time,
+                    max_time);
+      }
+    }
+  }
+
+  // Discards the aggregated values.
+  void Clear() {
+    scoped_lock l(&flush_mutex_);
+    for (size_t i = 0; i < arraysize(kStatsList); ++i) {
+      ResetSlot(&slots_[i]);
+    }
+  }
+
+ private:
+  struct Slot {
+    atomic<uint32> count;
+    atomic<uint32> num_timings;
+    atomic<uint64> total_time;
+    atomic<uint32> min_time;
+    atomic<uint32> max_time;
+  };
+
+  static void ResetSlot(Slot *slot) {
+    slot->count.store(0, memory_order_relaxed);
+    slot->num_timings.store(0, memory_order_relaxed);
+    slot->total_time.store(0, memory_order_relaxed);
+    slot->min_time.store(kuint32max, memory_order_relaxed);
+    slot->max_time.store(0, memory_order_relaxed);
+  }
+
+  static void UpdateMin(atomic<uint32> *target, uint32 val) {
+    uint32 current = target->load(memory_order_relaxed);
+    while (val < current &&
+           !target->compare_exchange_weak(current, val,
+                                          memory_order_relaxed)) {
+    }
+  }
+
+  static void UpdateMax(atomic<uint32> *target, uint32 val) {
+    uint32 current = target->load(memory_order_relaxed);
+    while (val > current &&
+           !target->compare_exchange_weak(current, val,
+                                          memory_order_relaxed)) {
+    }
+  }
+
+  map<string, int> index_;
+  scoped_ptr<Slot[]> slots_;
+  Mutex flush_mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingStats);
+};
 }  // namespace
 
 bool UsageStats::IsListed(const string &name) {
@@ -117,6 +266,7 @@ bool UsageStats::IsListed(const string &name) {
 }
 
 void UsageStats::ClearStats() {
+  Singleton<PendingStats>::get()->Clear();
   string stats_str;
   Stats stats;
   for (size_t i = 0; i < arraysize(kStatsList); ++i) {
@@ -139,6 +289,7 @@ void UsageStats::ClearStats() {
 }
 
 void UsageStats::ClearAllStatsForTest() {
+  Singleton<PendingStats>::get()->Clear();
   for (size_t i = 0; i < arraysize(kStatsList); ++i) {
     const string key = string(kRegistryPrefix) + kStatsList[i];
     storage::Registry::Erase(key);
@@ -151,16 +302,12 @@ void UsageStats::IncrementCountBy(const string &name, uint32 val) {
     return;
   }
 
-  Stats stats;
-  if (GetterInternal(name, Stats::COUNT, &stats)) {
-    stats.set_count(stats.count() + val);
-  } else {
-    stats.set_name(name);
-    stats.set_type(Stats::COUNT);
-    stats.set_count(val);
+  PendingStats *pending = Singleton<PendingStats>::get();
+  const int index = pending->GetIndex(name);
+  if (index < 0) {
+    return;
   }
-
-  SetterInternal(name, stats);
+  pending->AddCount(index, val);
 }
 
 void UsageStats::UpdateTiming(const string &name, uint32 val) {
@@ -169,24 +316,12 @@ void UsageStats::UpdateTiming(const string &name, uint32 val) {
     return;
   }
 
-  Stats stats;
-  if (GetterInternal(name, Stats::TIMING, &stats)) {
-    stats.set_num_timings(stats.num_timings() + 1);
-    stats.set_total_time(stats.total_time() + val);
-    stats.set_avg_time(stats.total_time() / stats.num_timings());
-    stats.set_min_time(min(stats.min_time(), val));
-    stats.set_max_time(max(stats.max_time(), val));
-  } else {
-    stats.set_name(name);
-    stats.set_type(Stats::TIMING);
-    stats.set_num_timings(1);
-    stats.set_total_time(val);
-    stats.set_avg_time(val);
-    stats.set_min_time(val);
-    stats.set_max_time(val);
+  PendingStats *pending = Singleton<PendingStats>::get();
+  const int index = pending->GetIndex(name);
+  if (index < 0) {
+    return;
   }
-
-  SetterInternal(name, stats);
+  pending->AddTiming(index, val);
 }
 
 void UsageStats::SetInteger(const string &name, int val) {
@@ -219,6 +354,7 @@ void UsageStats::SetBoolean(const string &name, bool val) {
 
 bool UsageStats::GetCountForTest(const string &name, uint32 *value) {
   CHECK(value != NULL);
+  Flush();
   Stats stats;
   if (!GetterInternal(name, Stats::COUNT, &stats)) {
     return false;
@@ -234,6 +370,7 @@ bool UsageStats::GetCountForTest(const string &name, uint32 *value) {
 
 bool UsageStats::GetIntegerForTest(const string &name, int32 *value) {
   CHECK(value != NULL);
+  Flush();
   Stats stats;
   if (!GetterInternal(name, Stats::INTEGER, &stats)) {
     return false;
@@ -249,6 +386,7 @@ bool UsageStats::GetIntegerForTest(const string &name, int32 *value) {
 
 bool UsageStats::GetBooleanForTest(const string &name, bool *value) {
   CHECK(value != NULL);
+  Flush();
   Stats stats;
   if (!GetterInternal(name, Stats::BOOLEAN, &stats)) {
     return false;
@@ -268,6 +406,7 @@ bool UsageStats::GetTimingForTest(const string &name,
                                   uint32 *avg_time,
                                   uint32 *min_time,
                                   uint32 *max_time) {
+  Flush();
   Stats stats;
   if (!GetterInternal(name, Stats::TIMING, &stats)) {
     return false;
@@ -302,6 +441,7 @@ bool UsageStats::GetTimingForTest(const string &name,
 }
 
 bool UsageStats::GetVirtualKeyboardForTest(const string &name, Stats *stats) {
+  Flush();
   if (!GetterInternal(name, Stats::VIRTUAL_KEYBOARD, stats)) {
     return false;
   }
@@ -316,6 +456,7 @@ bool UsageStats::GetVirtualKeyboardForTest(const string &name, Stats *stats) {
 }
 
 bool UsageStats::GetStatsForTest(const string &name, Stats *stats) {
+  Flush();
   return LoadStats(name, stats);
 }
 
@@ -366,7 +507,12 @@ void UsageStats::StoreTouchEventStats(
   SetterInternal(name, stats);
 }
 
+void UsageStats::Flush() {
+  Singleton<PendingStats>::get()->Flush();
+}
+
 bool UsageStats::Sync() {
+  Flush();
   if (!storage::Registry::Sync()) {
     LOG(ERROR) << "sync failed";
     return false;
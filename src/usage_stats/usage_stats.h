@@ -76,7 +76,13 @@ class UsageStats {
   static void StoreTouchEventStats(
       const string &name, const map<string, TouchEventStatsMap> &touch_stats);
 
-  // Synchronizes (writes) usage data into disk. Returns false on failure.
+  // Merges counts and timings into the registry. IncrementCountBy() and
+  // UpdateTiming() aggregate values in memory, and they are not visible in
+  // the registry until this method is called.
+  static void Flush();
+
+  // Flushes the aggregated data and synchronizes (writes) usage data into
+  // disk. Returns false on failure.
   static bool Sync();
 
   // Clears existing data exept for Integer and Boolean stats.
@@ -31,10 +31,12 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/port.h"
 #include "base/scoped_ptr.h"
 #include "base/system_util.h"
+#include "base/thread.h"
 #include "config/stats_config_util.h"
 #include "config/stats_config_util_mock.h"
 #include "storage/registry.h"
@@ -52,11 +54,13 @@ class UsageStatsTest : public ::testing::Test {
   virtual void SetUp() {
     SystemUtil::SetUserProfileDirectory(FLAGS_test_tmpdir);
     EXPECT_TRUE(storage::Registry::Clear());
+    UsageStats::ClearAllStatsForTest();
     mozc::config::StatsConfigUtil::SetHandler(&stats_config_util_);
   }
   virtual void TearDown() {
     mozc::config::StatsConfigUtil::SetHandler(NULL);
     EXPECT_TRUE(storage::Registry::Clear());
+    UsageStats::ClearAllStatsForTest();
   }
 
  private:
@@ -294,5 +298,108 @@ TEST_F(UsageStatsTest, StoreTouchEventStats) {
                                          &stats_str));
 }
 
+TEST_F(UsageStatsTest, FlushAggregatedStats) {
+  const char kCountKey[] = "ShutDown";
+  const char kTimingKey[] = "ElapsedTimeUSec";
+  string stats_str;
+
+  UsageStats::IncrementCount(kCountKey);
+  UsageStats::IncrementCountBy(kCountKey, 2);
+  UsageStats::UpdateTiming(kTimingKey, 5);
+  UsageStats::UpdateTiming(kTimingKey, 9);
+
+  // Counts and timings are not in the registry until they are flushed.
+  EXPECT_FALSE(storage::Registry::Lookup("usage_stats.ShutDown", &stats_str));
+  EXPECT_FALSE(storage::Registry::Lookup("usage_stats.ElapsedTimeUSec",
+                                         &stats_str));
+  UsageStats::Flush();
+  EXPECT_TRUE(storage::Registry::Lookup("usage_stats.ShutDown", &stats_str));
+  EXPECT_TRUE(storage::Registry::Lookup("usage_stats.ElapsedTimeUSec",
+                                        &stats_str));
+
+  // Values flushed later are merged to the stored ones.
+  UsageStats::IncrementCount(kCountKey);
+  UsageStats::UpdateTiming(kTimingKey, 1);
+  UsageStats::Flush();
+
+  uint32 count_val = 0;
+  EXPECT_TRUE(UsageStats::GetCountForTest(kCountKey, &count_val));
+  EXPECT_EQ(4, count_val);
+
+  uint64 total_time = 0;
+  uint32 num_timings = 0;
+  uint32 avg_time = 0;
+  uint32 min_time = 0;
+  uint32 max_time = 0;
+  EXPECT_TRUE(UsageStats::GetTimingForTest(kTimingKey, &total_time,
+                                           &num_timings, &avg_time,
+                                           &min_time, &max_time));
+  EXPECT_EQ(15, total_time);
+  EXPECT_EQ(3, num_timings);
+  EXPECT_EQ(5, avg_time);
+  EXPECT_EQ(1, min_time);
+  EXPECT_EQ(9, max_time);
+
+  // ClearStats() discards the values not flushed yet as well.
+  UsageStats::IncrementCount(kCountKey);
+  UsageStats::ClearStats();
+  EXPECT_FALSE(UsageStats::GetCountForTest(kCountKey, &count_val));
+}
+
+namespace {
+class IncrementThread : public Thread {
+ public:
+  IncrementThread(const string &name, int num_increments)
+      : name_(name), num_increments_(num_increments) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_increments_; ++i) {
+      UsageStats::IncrementCount(name_);
+      UsageStats::UpdateTiming("ElapsedTimeUSec", i);
+      if (i % 1000 == 0) {
+        UsageStats::Flush();
+      }
+    }
+  }
+
+ private:
+  const string name_;
+  const int num_increments_;
+};
+}  // namespace
+
+TEST_F(UsageStatsTest, IncrementFromMultipleThreads) {
+  const int kNumThreads = 4;
+  const int kNumIncrements = 10000;
+  vector<IncrementThread *> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(new IncrementThread("ShutDown", kNumIncrements));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->Start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  uint32 count_val = 0;
+  EXPECT_TRUE(UsageStats::GetCountForTest("ShutDown", &count_val));
+  EXPECT_EQ(kNumThreads * kNumIncrements, count_val);
+
+  uint64 total_time = 0;
+  uint32 num_timings = 0;
+  uint32 min_time = 0;
+  uint32 max_time = 0;
+  EXPECT_TRUE(UsageStats::GetTimingForTest("ElapsedTimeUSec", &total_time,
+                                           &num_timings, NULL,
+                                           &min_time, &max_time));
+  EXPECT_EQ(kNumThreads * kNumIncrements, num_timings);
+  EXPECT_EQ(static_cast<uint64>(kNumThreads) *
+            kNumIncrements * (kNumIncrements - 1) / 2, total_time);
+  EXPECT_EQ(0, min_time);
+  EXPECT_EQ(kNumIncrements - 1, max_time);
+}
+
 }  // namespace usage_stats
 }  // namespace mozc
@@ -246,6 +246,9 @@ void UsageStatsUploader::SetClientIdHandler(
 
 void UsageStatsUploader::LoadStats(UploadUtil *uploader) {
   DCHECK(uploader);
+  // Counts and timings aggregated in memory have to be in the registry to be
+  // uploaded (and cleared by ClearStats() afterward).
+  UsageStats::Flush();
   string stats_str;
   Stats stats;
   for (size_t i = 0; i < arraysize(kStatsList); ++i) {
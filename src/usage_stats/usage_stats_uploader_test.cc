@@ -167,6 +167,7 @@ class UsageStatsUploaderTest : public ::testing::Test {
     TestableUsageStatsUploader::SetClientIdHandler(&client_id_);
     HTTPClient::SetHTTPClientHandler(&client_);
     EXPECT_TRUE(storage::Registry::Clear());
+    UsageStats::ClearAllStatsForTest();
 
     mozc::config::Config config;
     mozc::config::ConfigHandler::GetDefaultConfig(&config);
@@ -187,6 +188,7 @@ class UsageStatsUploaderTest : public ::testing::Test {
     TestableUsageStatsUploader::SetClientIdHandler(NULL);
     HTTPClient::SetHTTPClientHandler(NULL);
     EXPECT_TRUE(storage::Registry::Clear());
+    UsageStats::ClearAllStatsForTest();
   }
 
   void SetValidResult() {